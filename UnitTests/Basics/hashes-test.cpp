@@ -33,6 +33,51 @@
 // --SECTION--                                                    private macros
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief a crc32c implementation
+////////////////////////////////////////////////////////////////////////////////
+
+typedef uint32_t (*Crc32CFunction) (uint32_t, char const*, size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns all crc32c implementations usable on this machine
+///
+/// the one selected at startup is tested as well as the ones behind it, so
+/// the table implementation is also tested on machines with SSE4.2
+////////////////////////////////////////////////////////////////////////////////
+
+static std::vector<Crc32CFunction> Crc32CImplementations () {
+  std::vector<Crc32CFunction> result;
+
+  result.emplace_back(TRI_BlockCrc32C);
+  result.emplace_back(TRI_BlockCrc32CSoftware);
+
+  if (TRI_HasHardwareCrc32C()) {
+    result.emplace_back(TRI_BlockCrc32CHardware);
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief bit-by-bit reference implementation of crc32c
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t ReferenceCrc32C (uint32_t value, char const* data, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    value ^= static_cast<uint8_t>(data[i]);
+    for (int j = 0; j < 8; ++j) {
+      value = (value >> 1) ^ ((value & 1) ? 0x82F63B78 : 0);
+    }
+  }
+
+  return value;
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 setup / tear-down
 // -----------------------------------------------------------------------------
@@ -423,6 +468,91 @@ BOOST_AUTO_TEST_CASE (tst_crc32_utf8) {
   BOOST_CHECK_EQUAL((uint64_t) 2590070434ULL,   TRI_FinalCrc32(TRI_BlockCrc32(TRI_InitialCrc32(), buffer.c_str(), strlen(buffer.c_str()))));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test crc32c
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_crc32c_simple) {
+  std::vector<std::pair<std::string, uint64_t>> const values = {
+    { "", 0ULL },
+    { " ", 1925242255ULL },
+    { "a", 3251651376ULL },
+    { "123456789", 3808858755ULL },
+    { "the quick brown fox jumped over the lazy dog", 3928504206ULL }
+  };
+
+  for (auto crc32c : Crc32CImplementations()) {
+    for (auto const& it : values) {
+      std::string const& buffer = it.first;
+      BOOST_CHECK_EQUAL(it.second, (uint64_t) TRI_FinalCrc32(crc32c(TRI_InitialCrc32(), buffer.c_str(), buffer.size())));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test crc32c with unaligned data and in pieces
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_crc32c_unaligned) {
+  std::string buffer;
+
+  for (size_t i = 0; i < 1024; ++i) {
+    buffer.push_back(static_cast<char>(i * 7 + 3));
+  }
+
+  for (auto crc32c : Crc32CImplementations()) {
+    for (size_t offset = 0; offset < 9; ++offset) {
+      for (size_t length = 0; length < 300; length += 13) {
+        char const* data = buffer.c_str() + offset;
+
+        uint32_t expected = ReferenceCrc32C(TRI_InitialCrc32(), data, length);
+
+        BOOST_CHECK_EQUAL(expected, crc32c(TRI_InitialCrc32(), data, length));
+
+        // calculating the value in two pieces must produce the same result
+        uint32_t crc = crc32c(TRI_InitialCrc32(), data, length / 3);
+        crc = crc32c(crc, data + length / 3, length - length / 3);
+        BOOST_CHECK_EQUAL(expected, crc);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that all crc32c implementations agree on larger blocks
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_crc32c_implementations) {
+  std::string buffer;
+  uint32_t seed = 12345;
+
+  for (size_t i = 0; i < 70000; ++i) {
+    seed = seed * 1103515245 + 12345;
+    buffer.push_back(static_cast<char>(seed >> 16));
+  }
+
+  auto const implementations = Crc32CImplementations();
+
+  for (size_t offset = 0; offset < 16; offset += 3) {
+    for (size_t length = 0; length + offset <= buffer.size(); length = length * 2 + 7) {
+      char const* data = buffer.c_str() + offset;
+      uint32_t const expected = TRI_BlockCrc32CSoftware(TRI_InitialCrc32(), data, length);
+
+      for (auto crc32c : implementations) {
+        BOOST_CHECK_EQUAL(expected, crc32c(TRI_InitialCrc32(), data, length));
+
+        // an initial value other than the default one
+        BOOST_CHECK_EQUAL(TRI_BlockCrc32CSoftware(expected, data, length / 2),
+                          crc32c(expected, data, length / 2));
+      }
+    }
+  }
+
+  // the reference implementation is slow, so only check a larger block once
+  BOOST_CHECK_EQUAL(ReferenceCrc32C(TRI_InitialCrc32(), buffer.c_str(), buffer.size()),
+                    TRI_BlockCrc32CSoftware(TRI_InitialCrc32(), buffer.c_str(), buffer.size()));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief generate tests
 ////////////////////////////////////////////////////////////////////////////////
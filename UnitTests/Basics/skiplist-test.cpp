@@ -28,6 +28,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "Basics/skip-list.h"
+#include "Basics/ThreadPool.h"
 #include "Basics/voc-errors.h"
 
 #include <vector>
@@ -439,6 +440,63 @@ BOOST_AUTO_TEST_CASE (tst_unique_remove_all) {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test bulk loading
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_unique_bulk_load) {
+  triagens::basics::SkipList skiplist(CmpElmElm, CmpKeyElm, nullptr, FreeElm, true);
+  triagens::basics::ThreadPool pool(3, "SkipListTest");
+
+  std::vector<int*> values; 
+  for (int i = 0; i < 10000; ++i) {
+    values.push_back(new int((i * 7919) % 10000));
+  }
+
+  // a duplicate is refused and nothing is inserted
+  int duplicate = 17;
+  std::vector<void*> docs(values.begin(), values.end());
+  docs.push_back(&duplicate);
+
+  BOOST_CHECK_EQUAL(TRI_ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED, skiplist.bulkLoad(docs, &pool));
+  BOOST_CHECK_EQUAL(0, skiplist.getNrUsed());
+  BOOST_CHECK_EQUAL((void*) 0, skiplist.startNode()->nextNode());
+
+  // bulkLoad has reordered the documents
+  docs.assign(values.begin(), values.end());
+  BOOST_CHECK_EQUAL(0, skiplist.bulkLoad(docs, &pool));
+  BOOST_CHECK_EQUAL(10000, skiplist.getNrUsed());
+
+  // check the order and the predecessors
+  triagens::basics::SkipListNode* prev = skiplist.startNode();
+  triagens::basics::SkipListNode* current = skiplist.startNode()->nextNode();
+  int expected = 0;
+
+  while (current != nullptr) {
+    BOOST_CHECK_EQUAL(expected, *static_cast<int*>(current->document()));
+    BOOST_CHECK_EQUAL(prev, current->prevNode());
+    ++expected;
+    prev = current;
+    current = current->nextNode();
+  }
+
+  BOOST_CHECK_EQUAL(10000, expected);
+  BOOST_CHECK_EQUAL(prev, skiplist.prevNode(nullptr));
+
+  // lookups use the upper levels
+  for (int i = 0; i < 10000; i += 97) {
+    BOOST_CHECK_EQUAL(i, *static_cast<int*>(skiplist.lookup(&i)->document()));
+  }
+
+  BOOST_CHECK_EQUAL(0, skiplist.remove(values[0]));
+  BOOST_CHECK_EQUAL(0, skiplist.insert(values[0]));
+
+  // clean up
+  for (auto i : values) {
+    delete i;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief generate tests
 ////////////////////////////////////////////////////////////////////////////////
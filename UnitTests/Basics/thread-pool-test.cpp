@@ -0,0 +1,336 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite for ThreadPool
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2015, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+
+#include "Basics/RunInThreads.h"
+#include "Basics/ThreadPool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace triagens::basics;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief blocks all threads of a pool until release() is called
+////////////////////////////////////////////////////////////////////////////////
+
+struct PoolBlocker {
+  PoolBlocker (ThreadPool& pool)
+    : started(0),
+      released(false) {
+
+    for (size_t i = 0; i < pool.numThreads(); ++i) {
+      pool.enqueue([this] () -> void {
+        ++started;
+        while (! released) {
+          this_thread::yield();
+        }
+      });
+    }
+
+    while (started < pool.numThreads()) {
+      this_thread::yield();
+    }
+  }
+
+  ~PoolBlocker () {
+    release();
+  }
+
+  void release () {
+    released = true;
+  }
+
+  atomic<size_t> started;
+  atomic<bool> released;
+};
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 setup / tear-down
+// -----------------------------------------------------------------------------
+
+struct CThreadPoolSetup {
+  CThreadPoolSetup () {
+    BOOST_TEST_MESSAGE("setup ThreadPool");
+  }
+
+  ~CThreadPoolSetup () {
+    BOOST_TEST_MESSAGE("tear-down ThreadPool");
+  }
+};
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                        test suite
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief setup
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE(CThreadPoolTest, CThreadPoolSetup)
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that every item is processed exactly once
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_parallel_for_items) {
+  ThreadPool pool(4, "ThreadPoolTest");
+
+  for (size_t n : { 0, 1, 2, 3, 5, 100, 10000 }) {
+    vector<atomic<int>> seen(n);
+    for (auto& it : seen) {
+      it = 0;
+    }
+
+    pool.parallelFor(n, [&] (size_t i) -> void {
+      ++seen[i];
+    });
+
+    for (size_t i = 0; i < n; ++i) {
+      BOOST_CHECK_EQUAL(1, seen[i].load());
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that the calling thread takes part in the work
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_parallel_for_caller) {
+  auto const caller = this_thread::get_id();
+
+  // without any threads, the caller does all the work
+  {
+    ThreadPool pool(0, "ThreadPoolTest");
+    size_t count = 0;
+
+    pool.parallelFor(1000, [&] (size_t i) -> void {
+      BOOST_CHECK(this_thread::get_id() == caller);
+      ++count;
+    });
+
+    BOOST_CHECK_EQUAL(1000, count);
+  }
+
+  // the caller does not wait for helpers that cannot start because all
+  // threads of the pool are busy
+  {
+    ThreadPool pool(2, "ThreadPoolTest");
+    PoolBlocker blocker(pool);
+    size_t count = 0;
+
+    pool.parallelFor(1000, [&] (size_t i) -> void {
+      BOOST_CHECK(this_thread::get_id() == caller);
+      ++count;
+    });
+
+    BOOST_CHECK_EQUAL(1000, count);
+  }
+
+  // the caller works on some of the items while the helpers are running.
+  // no item is finished before both the caller and a helper have started
+  // one, and the helpers can hold only two items while waiting
+  {
+    ThreadPool pool(2, "ThreadPoolTest");
+    atomic<size_t> byCaller(0);
+    atomic<size_t> byHelpers(0);
+
+    pool.parallelFor(100, [&] (size_t i) -> void {
+      if (this_thread::get_id() == caller) {
+        ++byCaller;
+      }
+      else {
+        ++byHelpers;
+      }
+
+      while (byCaller == 0 || byHelpers == 0) {
+        this_thread::yield();
+      }
+    });
+
+    BOOST_CHECK_EQUAL(100, byCaller + byHelpers);
+    BOOST_CHECK(byCaller > 0);
+    BOOST_CHECK(byHelpers > 0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test nested use from items and from tasks of the same pool
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_parallel_for_nested) {
+  ThreadPool pool(3, "ThreadPoolTest");
+
+  // parallelFor inside the items of parallelFor
+  vector<atomic<int>> seen(50 * 50);
+  for (auto& it : seen) {
+    it = 0;
+  }
+
+  pool.parallelFor(50, [&] (size_t i) -> void {
+    pool.parallelFor(50, [&] (size_t j) -> void {
+      ++seen[i * 50 + j];
+    });
+  });
+
+  for (auto const& it : seen) {
+    BOOST_CHECK_EQUAL(1, it.load());
+  }
+
+  // parallelFor inside tasks that occupy all threads of the pool
+  atomic<size_t> done(0);
+  atomic<size_t> count(0);
+
+  for (size_t i = 0; i < pool.numThreads(); ++i) {
+    pool.enqueue([&] () -> void {
+      pool.parallelFor(1000, [&] (size_t) -> void {
+        ++count;
+      });
+      ++done;
+    });
+  }
+
+  while (done < pool.numThreads()) {
+    this_thread::yield();
+  }
+
+  BOOST_CHECK_EQUAL(pool.numThreads() * 1000, count.load());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test exceptions thrown by items
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_parallel_for_exceptions) {
+  ThreadPool pool(3, "ThreadPoolTest");
+
+  for (size_t failing : { 0, 1, 500, 999 }) {
+    atomic<size_t> count(0);
+
+    BOOST_CHECK_THROW(pool.parallelFor(1000, [&] (size_t i) -> void {
+      ++count;
+      if (i == failing) {
+        throw runtime_error("failed");
+      }
+    }), runtime_error);
+
+    // items after the failing one may have been skipped
+    BOOST_CHECK(count > 0);
+    BOOST_CHECK(count <= 1000);
+  }
+
+  // an exception thrown by a helper thread
+  auto const caller = this_thread::get_id();
+  atomic<bool> thrown(false);
+
+  BOOST_CHECK_THROW(pool.parallelFor(1000, [&] (size_t i) -> void {
+    if (this_thread::get_id() != caller) {
+      thrown = true;
+      throw runtime_error("failed");
+    }
+    while (! thrown) {
+      this_thread::yield();
+    }
+  }), runtime_error);
+
+  // the pool can still be used
+  atomic<size_t> count(0);
+  pool.parallelFor(1000, [&] (size_t) -> void {
+    ++count;
+  });
+  BOOST_CHECK_EQUAL(1000, count.load());
+
+  // RunInThreads processes all items and rethrows the first exception
+  for (ThreadPool* p : { &pool, static_cast<ThreadPool*>(nullptr) }) {
+    vector<atomic<int>> seen(100);
+    for (auto& it : seen) {
+      it = 0;
+    }
+
+    try {
+      RunInThreads(p, 100, [&] (size_t i) -> void {
+        ++seen[i];
+        if (i % 10 == 3) {
+          throw runtime_error("failed " + to_string(i));
+        }
+      });
+      BOOST_FAIL("no exception thrown");
+    }
+    catch (runtime_error const& ex) {
+      BOOST_CHECK_EQUAL(string("failed 3"), ex.what());
+    }
+
+    for (auto const& it : seen) {
+      BOOST_CHECK_EQUAL(1, it.load());
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test callers using the pool at the same time
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (tst_parallel_for_concurrent_callers) {
+  ThreadPool pool(2, "ThreadPoolTest");
+  vector<thread> callers;
+  atomic<size_t> count(0);
+
+  for (size_t i = 0; i < 4; ++i) {
+    callers.emplace_back([&] () -> void {
+      for (size_t j = 0; j < 20; ++j) {
+        pool.parallelFor(500, [&] (size_t) -> void {
+          ++count;
+        });
+      }
+    });
+  }
+
+  for (auto& it : callers) {
+    it.join();
+  }
+
+  BOOST_CHECK_EQUAL(4 * 20 * 500, count.load());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief generate tests
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END ()
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// {@inheritDoc}\\|/// @addtogroup\\|// --SECTION--\\|/// @\\}\\)"
+// End:
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmark harness
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include "Basics/system-functions.h"
+
+using namespace triagens::basics;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+Benchmark::Benchmark (size_t size,
+                      size_t runs,
+                      std::string const& filter)
+  : _size(size),
+    _runs(runs),
+    _filter(filter),
+    _start(0.0),
+    _results() {
+
+}
+
+Benchmark::~Benchmark () {
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the benchmarks of a group should be executed
+////////////////////////////////////////////////////////////////////////////////
+
+bool Benchmark::enabled (std::string const& group) const {
+  return (_filter.empty() || group.find(_filter) != std::string::npos);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief start the clock
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::start () {
+  _start = TRI_microtime();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief stop the clock and record the measurement
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmark::stop (std::string const& group,
+                      std::string const& name,
+                      uint64_t operations,
+                      size_t memory) {
+  double const seconds = TRI_microtime() - _start;
+
+  for (auto& it : _results) {
+    if (it.group == group && it.name == name) {
+      // keep the fastest run
+      if (seconds < it.seconds) {
+        it.seconds    = seconds;
+        it.operations = operations;
+        it.memory     = memory;
+      }
+      return;
+    }
+  }
+
+  _results.emplace_back(BenchmarkResult{ group, name, operations, seconds, memory });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return all results as JSON
+////////////////////////////////////////////////////////////////////////////////
+
+Json Benchmark::toJson () const {
+  Json results(Json::Array, _results.size());
+
+  for (auto const& it : _results) {
+    double const opsPerSecond = (it.seconds > 0.0 ? static_cast<double>(it.operations) / it.seconds : 0.0);
+
+    results.add(Json(Json::Object)
+                ("group", Json(it.group))
+                ("name", Json(it.name))
+                ("operations", Json(static_cast<double>(it.operations)))
+                ("seconds", Json(it.seconds))
+                ("opsPerSecond", Json(opsPerSecond))
+                ("memory", Json(static_cast<double>(it.memory))));
+  }
+
+  Json json(Json::Object);
+  json("version", Json(TRI_VERSION))
+      ("size", Json(static_cast<double>(_size)))
+      ("runs", Json(static_cast<double>(_runs)))
+      ("results", results);
+
+  return json;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmark harness
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARANGODB_UNIT_TESTS_BENCHMARKS_BENCHMARK_H
+#define ARANGODB_UNIT_TESTS_BENCHMARKS_BENCHMARK_H 1
+
+#include "Basics/Common.h"
+#include "Basics/JsonHelper.h"
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                              struct BenchmarkResult
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief result of a single measurement
+////////////////////////////////////////////////////////////////////////////////
+
+struct BenchmarkResult {
+  std::string group;
+  std::string name;
+  uint64_t operations;
+  double seconds;
+  size_t memory;
+};
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  class Benchmark
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief collects the measurements of all benchmarks
+///
+/// every benchmark is executed the configured number of times, and only the
+/// fastest run of each measurement is kept. the results are emitted as a
+/// single JSON document, so they can be compared between builds
+////////////////////////////////////////////////////////////////////////////////
+
+class Benchmark {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+  public:
+
+    Benchmark (Benchmark const&) = delete;
+    Benchmark& operator= (Benchmark const&) = delete;
+
+    Benchmark (size_t,
+               size_t,
+               std::string const&);
+
+    ~Benchmark ();
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+  public:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of elements each benchmark should work on
+////////////////////////////////////////////////////////////////////////////////
+
+    size_t size () const {
+      return _size;
+    }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of runs for each benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+    size_t runs () const {
+      return _runs;
+    }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the benchmarks of a group should be executed
+////////////////////////////////////////////////////////////////////////////////
+
+    bool enabled (std::string const&) const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief start the clock
+////////////////////////////////////////////////////////////////////////////////
+
+    void start ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief stop the clock and record the measurement
+////////////////////////////////////////////////////////////////////////////////
+
+    void stop (std::string const&,
+               std::string const&,
+               uint64_t,
+               size_t = 0);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return all results as JSON
+////////////////////////////////////////////////////////////////////////////////
+
+    triagens::basics::Json toJson () const;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+  private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of elements
+////////////////////////////////////////////////////////////////////////////////
+
+    size_t const _size;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of runs
+////////////////////////////////////////////////////////////////////////////////
+
+    size_t const _runs;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief only execute the groups containing this string, if not empty
+////////////////////////////////////////////////////////////////////////////////
+
+    std::string const _filter;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief start time of the current measurement
+////////////////////////////////////////////////////////////////////////////////
+
+    double _start;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief results, in the order in which they were first recorded
+////////////////////////////////////////////////////////////////////////////////
+
+    std::vector<BenchmarkResult> _results;
+};
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                        benchmarks
+// -----------------------------------------------------------------------------
+
+void RunAssocMultiBenchmarks (Benchmark&);
+
+void RunSkiplistBenchmarks (Benchmark&);
+
+void RunGeoIndexBenchmarks (Benchmark&);
+
+void RunFulltextIndexBenchmarks (Benchmark&);
+
+void RunHashArrayBenchmarks (Benchmark&);
+
+void RunAqlItemBlockBenchmarks (Benchmark&);
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmarks for index structures
+///
+/// @file
+///
+/// runs all benchmarks and prints the results as JSON. the following options
+/// are supported:
+///
+/// - `--size <n>`: number of elements per benchmark (default: 1000000)
+/// - `--runs <n>`: number of runs per benchmark, the fastest is reported
+///   (default: 3)
+/// - `--filter <group>`: only run the benchmark groups containing this string
+/// - `--output <file>`: write the results into a file instead of stdout
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include "Basics/FileUtils.h"
+#include "Basics/conversions.h"
+
+#include <iostream>
+
+using namespace triagens::basics;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief print usage information
+////////////////////////////////////////////////////////////////////////////////
+
+static void Usage (char const* name) {
+  std::cerr << "usage: " << name
+            << " [--size <n>] [--runs <n>] [--filter <group>] [--output <file>]"
+            << std::endl;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief main
+////////////////////////////////////////////////////////////////////////////////
+
+int main (int argc, char* argv[]) {
+  size_t size = 1000000;
+  size_t runs = 3;
+  std::string filter;
+  std::string output;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const option(argv[i]);
+
+    if (i + 1 >= argc) {
+      Usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    std::string const value(argv[++i]);
+
+    if (option == "--size") {
+      size = static_cast<size_t>(TRI_UInt64String(value.c_str()));
+    }
+    else if (option == "--runs") {
+      runs = static_cast<size_t>(TRI_UInt64String(value.c_str()));
+    }
+    else if (option == "--filter") {
+      filter = value;
+    }
+    else if (option == "--output") {
+      output = value;
+    }
+    else {
+      Usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (size == 0 || runs == 0) {
+    Usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Benchmark benchmark(size, runs, filter);
+
+  RunAssocMultiBenchmarks(benchmark);
+  RunSkiplistBenchmarks(benchmark);
+  RunGeoIndexBenchmarks(benchmark);
+  RunFulltextIndexBenchmarks(benchmark);
+  RunHashArrayBenchmarks(benchmark);
+  RunAqlItemBlockBenchmarks(benchmark);
+
+  std::string const result = benchmark.toJson().toString();
+
+  if (output.empty()) {
+    std::cout << result << std::endl;
+  }
+  else {
+    FileUtils::spit(output, result);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
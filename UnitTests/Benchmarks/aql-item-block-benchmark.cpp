@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmarks for AqlItemBlock
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "Benchmark.h"
+
+#include "Aql/AqlItemBlock.h"
+#include "Aql/ExecutionBlock.h"
+#include "Basics/JsonHelper.h"
+
+using namespace triagens::aql;
+using Json = triagens::basics::Json;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of registers per row
+///
+/// register 0 holds a value calculated for the row, register 1 the same value
+/// inherited from an outer block, register 2 is empty
+////////////////////////////////////////////////////////////////////////////////
+
+static RegisterId const NumberOfRegisters = 3;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private helpers
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief creates a block with a fresh value per row
+////////////////////////////////////////////////////////////////////////////////
+
+static AqlItemBlock* FillBlock (size_t rows,
+                                bool columnar) {
+  std::unique_ptr<AqlItemBlock> block(new AqlItemBlock(rows, NumberOfRegisters, columnar));
+
+  for (size_t row = 0; row < rows; ++row) {
+    AqlValue a(new Json(static_cast<double>(row)));
+
+    try {
+      block->setValue(row, 0, a);
+    }
+    catch (...) {
+      a.destroy();
+      throw;
+    }
+
+    block->setValue(row, 1, a);
+  }
+
+  return block.release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief rows per second of the item block operations that the execution
+/// blocks perform for each batch
+////////////////////////////////////////////////////////////////////////////////
+
+static void RunBenchmarks (Benchmark& benchmark,
+                           std::string const& group,
+                           bool columnar) {
+  size_t const batchSize = ExecutionBlock::DefaultBatchSize;
+  size_t const numBlocks = (std::max)(benchmark.size() / batchSize, static_cast<size_t>(1));
+  size_t const n = numBlocks * batchSize;
+
+  // every second row passes the filter
+  std::vector<size_t> chosen;
+
+  for (size_t row = 0; row < batchSize; row += 2) {
+    chosen.emplace_back(row);
+  }
+
+  for (size_t run = 0; run < benchmark.runs(); ++run) {
+    std::vector<AqlItemBlock*> blocks;
+    blocks.reserve(numBlocks);
+
+    // CalculationBlock and the blocks that produce new rows
+    benchmark.start();
+    for (size_t i = 0; i < numBlocks; ++i) {
+      blocks.emplace_back(FillBlock(batchSize, columnar));
+    }
+    benchmark.stop(group, "fill", n, numBlocks * blocks[0]->memoryUsage());
+
+    // copies of parts of a block, as returned by getSome() if fewer rows than
+    // a whole block are requested
+    benchmark.start();
+    for (auto& it : blocks) {
+      delete it->slice(0, batchSize);
+    }
+    benchmark.stop(group, "slice", n);
+
+    // FilterBlock
+    benchmark.start();
+    for (auto& it : blocks) {
+      AqlItemBlock* filtered = it->steal(chosen, 0, chosen.size());
+      delete it;
+      it = filtered;
+    }
+    benchmark.stop(group, "filter", n);
+
+    // SortBlock, and getSome() if more rows than one block are requested
+    benchmark.start();
+    AqlItemBlock* all = AqlItemBlock::concatenate(blocks);
+    for (auto& it : blocks) {
+      delete it;
+    }
+    benchmark.stop(group, "concatenate", all->size());
+
+    delete all;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief rows per second of AqlItemBlock, in both layouts
+///
+/// this measures the item block operations of the execution blocks in
+/// isolation. whole execution plans need a database, and are measured with
+/// AQL queries instead
+////////////////////////////////////////////////////////////////////////////////
+
+void RunAqlItemBlockBenchmarks (Benchmark& benchmark) {
+  std::string const group("AqlItemBlock");
+
+  if (benchmark.enabled(group)) {
+    RunBenchmarks(benchmark, group, false);
+  }
+
+  std::string const columnarGroup("AqlItemBlockColumnar");
+
+  if (benchmark.enabled(columnarGroup)) {
+    RunBenchmarks(benchmark, columnarGroup, true);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmarks for AssocMulti
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include "Basics/AssocMulti.h"
+#include "Basics/fasthash.h"
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of elements with the same key, similar to the edges of a
+/// vertex in the edge index
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const ElementsPerKey = 4;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private helpers
+// -----------------------------------------------------------------------------
+
+struct element_t {
+  uint64_t key;
+  uint64_t value;
+};
+
+typedef triagens::basics::AssocMulti<void, void, uint64_t> assoc_multi_t;
+
+static uint64_t HashKey (void const* k) {
+  return fasthash64(k, sizeof(uint64_t), 0x12345678);
+}
+
+static uint64_t HashElement (void const* e, bool byKey) {
+  element_t const* element = static_cast<element_t const*>(e);
+
+  if (byKey) {
+    return fasthash64(&element->key, sizeof(uint64_t), 0x12345678);
+  }
+  return fasthash64(&element->value, sizeof(uint64_t), 0x12345678);
+}
+
+static bool IsEqualKeyElement (void const* k, void const* e) {
+  return *static_cast<uint64_t const*>(k) == static_cast<element_t const*>(e)->key;
+}
+
+static bool IsEqualElementElement (void const* l, void const* r) {
+  return static_cast<element_t const*>(l)->value == static_cast<element_t const*>(r)->value;
+}
+
+static bool IsEqualElementElementByKey (void const* l, void const* r) {
+  return static_cast<element_t const*>(l)->key == static_cast<element_t const*>(r)->key;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief insert, lookup and remove throughput of AssocMulti
+////////////////////////////////////////////////////////////////////////////////
+
+void RunAssocMultiBenchmarks (Benchmark& benchmark) {
+  std::string const group("AssocMulti");
+
+  if (! benchmark.enabled(group)) {
+    return;
+  }
+
+  size_t const n = benchmark.size();
+  size_t const numKeys = (n + ElementsPerKey - 1) / ElementsPerKey;
+
+  std::vector<element_t> elements;
+  elements.reserve(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    elements.emplace_back(element_t{ static_cast<uint64_t>(i / ElementsPerKey), static_cast<uint64_t>(i) });
+  }
+
+  for (size_t run = 0; run < benchmark.runs(); ++run) {
+    assoc_multi_t a(HashKey, HashElement, IsEqualKeyElement, IsEqualElementElement, IsEqualElementElementByKey);
+
+    benchmark.start();
+    for (auto& it : elements) {
+      a.insert(&it, false, false);
+    }
+    benchmark.stop(group, "insert", n, a.memoryUsage());
+
+    benchmark.start();
+    for (uint64_t key = 0; key < numKeys; ++key) {
+      std::unique_ptr<std::vector<void*>> result(a.lookupByKey(&key));
+      TRI_ASSERT(! result->empty());
+    }
+    benchmark.stop(group, "lookupByKey", numKeys);
+
+    benchmark.start();
+    for (auto& it : elements) {
+      a.lookup(&it);
+    }
+    benchmark.stop(group, "lookup", n);
+
+    benchmark.start();
+    for (auto& it : elements) {
+      a.remove(&it);
+    }
+    benchmark.stop(group, "remove", n);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmarks for the fulltext index
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include "Basics/tri-strings.h"
+#include "FulltextIndex/fulltext-index.h"
+#include "FulltextIndex/fulltext-query.h"
+#include "FulltextIndex/fulltext-result.h"
+#include "FulltextIndex/fulltext-wordlist.h"
+
+#include <iostream>
+#include <random>
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of words indexed per document
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const WordsPerDocument = 5;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private helpers
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief build a lower-case word from a number
+////////////////////////////////////////////////////////////////////////////////
+
+static std::string MakeWord (uint64_t value) {
+  std::string word("w");
+
+  do {
+    word.push_back(static_cast<char>('a' + (value % 26)));
+    value /= 26;
+  }
+  while (value > 0);
+
+  return word;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief build a word list that can be handed to the index
+////////////////////////////////////////////////////////////////////////////////
+
+static TRI_fulltext_wordlist_t* MakeWordlist (std::vector<std::string> const& words) {
+  char** buffer = static_cast<char**>(TRI_Allocate(TRI_UNKNOWN_MEM_ZONE, words.size() * sizeof(char*), false));
+
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+
+  for (size_t i = 0; i < words.size(); ++i) {
+    buffer[i] = TRI_DuplicateString2Z(TRI_UNKNOWN_MEM_ZONE, words[i].c_str(), words[i].size());
+  }
+
+  return TRI_CreateWordlistFulltextIndex(buffer, words.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute a single word query
+////////////////////////////////////////////////////////////////////////////////
+
+static void Query (TRI_fts_index_t* idx,
+                   std::string const& word,
+                   TRI_fulltext_query_match_e match) {
+  TRI_fulltext_query_t* query = TRI_CreateQueryFulltextIndex(1, 0);
+
+  if (query == nullptr) {
+    return;
+  }
+
+  if (! TRI_SetQueryFulltextIndex(query, 0, word.c_str(), word.size(), match, TRI_FULLTEXT_AND)) {
+    TRI_FreeQueryFulltextIndex(query);
+    return;
+  }
+
+  // this will free the query
+  TRI_fulltext_result_t* result = TRI_QueryFulltextIndex(idx, query);
+
+  if (result != nullptr) {
+    TRI_FreeResultFulltextIndex(result);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief insert, query and remove throughput of the fulltext index
+////////////////////////////////////////////////////////////////////////////////
+
+void RunFulltextIndexBenchmarks (Benchmark& benchmark) {
+  std::string const group("FulltextIndex");
+
+  if (! benchmark.enabled(group)) {
+    return;
+  }
+
+  size_t const n = benchmark.size();
+  size_t const numWords = (std::max)(n / 10, static_cast<size_t>(1000));
+  size_t const numQueries = (std::max)(n / 100, static_cast<size_t>(1));
+
+  // random, but repeatable words
+  std::mt19937_64 generator(0x12345678);
+  std::uniform_int_distribution<uint64_t> wordNumber(0, numWords - 1);
+
+  std::vector<std::vector<std::string>> documents;
+  documents.reserve(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<std::string> words;
+    words.reserve(WordsPerDocument);
+
+    for (size_t j = 0; j < WordsPerDocument; ++j) {
+      words.emplace_back(MakeWord(wordNumber(generator)));
+    }
+    documents.emplace_back(std::move(words));
+  }
+
+  std::vector<std::string> queries;
+  queries.reserve(numQueries);
+
+  for (size_t i = 0; i < numQueries; ++i) {
+    queries.emplace_back(MakeWord(wordNumber(generator)));
+  }
+
+  for (size_t run = 0; run < benchmark.runs(); ++run) {
+    TRI_fts_index_t* idx = TRI_CreateFtsIndex(2048, 1, 1);
+
+    if (idx == nullptr) {
+      std::cerr << "cannot create fulltext index" << std::endl;
+      return;
+    }
+
+    std::vector<TRI_fulltext_wordlist_t*> wordlists;
+    wordlists.reserve(n);
+
+    for (auto const& it : documents) {
+      wordlists.emplace_back(MakeWordlist(it));
+    }
+
+    benchmark.start();
+    for (size_t i = 0; i < n; ++i) {
+      if (wordlists[i] != nullptr) {
+        TRI_InsertWordsFulltextIndex(idx, static_cast<TRI_fulltext_doc_t>(i + 1), wordlists[i]);
+      }
+    }
+    benchmark.stop(group, "insert", n, TRI_MemoryFulltextIndex(idx));
+
+    for (auto it : wordlists) {
+      if (it != nullptr) {
+        TRI_FreeWordlistFulltextIndex(it);
+      }
+    }
+
+    benchmark.start();
+    for (auto const& it : queries) {
+      Query(idx, it, TRI_FULLTEXT_COMPLETE);
+    }
+    benchmark.stop(group, "query", numQueries);
+
+    benchmark.start();
+    for (auto const& it : queries) {
+      // a short prefix is shared by many words
+      Query(idx, it.substr(0, 3), TRI_FULLTEXT_PREFIX);
+    }
+    benchmark.stop(group, "prefixQuery", numQueries);
+
+    benchmark.start();
+    for (size_t i = 0; i < n; ++i) {
+      TRI_DeleteDocumentFulltextIndex(idx, static_cast<TRI_fulltext_doc_t>(i + 1));
+    }
+    benchmark.stop(group, "remove", n);
+
+    TRI_FreeFtsIndex(idx);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmarks for the geo index
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include "GeoIndex/GeoIndex.h"
+
+#include <iostream>
+#include <random>
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of points returned by each nearest query
+////////////////////////////////////////////////////////////////////////////////
+
+static int const NearestCount = 10;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief radius of each within query, in meters
+////////////////////////////////////////////////////////////////////////////////
+
+static double const WithinRadius = 10000.0;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief insert, query and remove throughput of the geo index
+////////////////////////////////////////////////////////////////////////////////
+
+void RunGeoIndexBenchmarks (Benchmark& benchmark) {
+  std::string const group("GeoIndex");
+
+  if (! benchmark.enabled(group)) {
+    return;
+  }
+
+  size_t const n = benchmark.size();
+
+  // random, but repeatable coordinates
+  std::mt19937_64 generator(0x12345678);
+  std::uniform_real_distribution<double> latitude(-90.0, 90.0);
+  std::uniform_real_distribution<double> longitude(-180.0, 180.0);
+
+  std::vector<GeoCoordinate> coordinates;
+  coordinates.reserve(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    GeoCoordinate c;
+    c.latitude  = latitude(generator);
+    c.longitude = longitude(generator);
+    c.data      = reinterpret_cast<void*>(static_cast<uintptr_t>(i + 1));
+    coordinates.emplace_back(c);
+  }
+
+  size_t const numQueries = (std::max)(n / 100, static_cast<size_t>(1));
+
+  for (size_t run = 0; run < benchmark.runs(); ++run) {
+    GeoIndex* gi = GeoIndex_new();
+
+    if (gi == nullptr) {
+      std::cerr << "cannot create geo index" << std::endl;
+      return;
+    }
+
+    benchmark.start();
+    for (auto& it : coordinates) {
+      GeoIndex_insert(gi, &it);
+    }
+    benchmark.stop(group, "insert", n, GeoIndex_MemoryUsage(gi));
+
+    benchmark.start();
+    for (size_t i = 0; i < numQueries; ++i) {
+      GeoCoordinates* result = GeoIndex_NearestCountPoints(gi, &coordinates[i], NearestCount);
+
+      if (result != nullptr) {
+        GeoIndex_CoordinatesFree(result);
+      }
+    }
+    benchmark.stop(group, "near", numQueries);
+
+    benchmark.start();
+    for (size_t i = 0; i < numQueries; ++i) {
+      GeoCoordinates* result = GeoIndex_PointsWithinRadius(gi, &coordinates[i], WithinRadius);
+
+      if (result != nullptr) {
+        GeoIndex_CoordinatesFree(result);
+      }
+    }
+    benchmark.stop(group, "within", numQueries);
+
+    benchmark.start();
+    for (auto& it : coordinates) {
+      GeoIndex_remove(gi, &it);
+    }
+    benchmark.stop(group, "remove", n);
+
+    GeoIndex_free(gi);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,176 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmarks for TRI_hash_array_t
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "Benchmark.h"
+
+#include "HashIndex/hash-array.h"
+#include "HashIndex/hash-index-common.h"
+#include "Indexes/Index.h"
+#include "ShapedJson/json-shaper.h"
+#include "VocBase/document-collection.h"
+
+#include <random>
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of keys looked up by one batched lookup, the same as the
+/// number of rows of an AQL item block
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const BatchSize = 1000;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private helpers
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief creates the element for a document with a numeric attribute value
+///
+/// numbers are stored in the sub-object itself, so the element does not
+/// refer to the document's data, and the documents need no markers
+////////////////////////////////////////////////////////////////////////////////
+
+static TRI_hash_index_element_t CreateElement (TRI_doc_mptr_t* document,
+                                               double const* value) {
+  TRI_hash_index_element_t element;
+  element._document = document;
+  element._subObjects = static_cast<TRI_shaped_sub_t*>(TRI_Allocate(TRI_UNKNOWN_MEM_ZONE, sizeof(TRI_shaped_sub_t), false));
+
+  element._subObjects->_sid = BasicShapes::TRI_SHAPE_SID_NUMBER;
+  memcpy(element._subObjects->_value._data, value, sizeof(double));
+
+  return element;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief insert, lookup, batched lookup and remove throughput of
+/// TRI_hash_array_t, the table of the unique hash index
+///
+/// the hash index itself is not needed, as it is only used for log messages
+/// when a table is rehashed at once
+////////////////////////////////////////////////////////////////////////////////
+
+void RunHashArrayBenchmarks (Benchmark& benchmark) {
+  std::string const group("HashArray");
+
+  if (! benchmark.enabled(group)) {
+    return;
+  }
+
+  size_t const n = benchmark.size();
+
+  // look up the values in random, but repeatable order
+  std::vector<double> values;
+  values.reserve(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    values.emplace_back(static_cast<double>(i));
+  }
+
+  std::mt19937_64 generator(0x12345678);
+  std::shuffle(values.begin(), values.end(), generator);
+
+  std::vector<TRI_shaped_json_t> shaped(n);
+  std::vector<TRI_index_search_value_t> keys(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    shaped[i]._sid = BasicShapes::TRI_SHAPE_SID_NUMBER;
+    shaped[i]._data.data = reinterpret_cast<char*>(&values[i]);
+    shaped[i]._data.length = sizeof(double);
+
+    keys[i]._length = 1;
+    keys[i]._values = &shaped[i];
+  }
+
+  std::vector<std::vector<TRI_index_search_value_t*>> batches;
+
+  for (size_t i = 0; i < n; ++i) {
+    if (i % BatchSize == 0) {
+      batches.emplace_back();
+      batches.back().reserve(BatchSize);
+    }
+    batches.back().emplace_back(&keys[i]);
+  }
+
+  std::vector<TRI_doc_mptr_t> documents(n);
+  std::vector<TRI_hash_index_element_t*> result;
+
+  for (size_t run = 0; run < benchmark.runs(); ++run) {
+    TRI_hash_array_t array;
+    TRI_InitHashArray(&array, 1);
+
+    std::vector<TRI_hash_index_element_t> elements;
+    elements.reserve(n);
+
+    for (size_t i = 0; i < n; ++i) {
+      elements.emplace_back(CreateElement(&documents[i], &values[i]));
+    }
+
+    benchmark.start();
+    for (size_t i = 0; i < n; ++i) {
+      TRI_InsertKeyHashArray(nullptr, &array, &keys[i], &elements[i], false);
+    }
+    benchmark.stop(group, "insert", n, TRI_MemoryUsageHashArray(&array));
+
+    benchmark.start();
+    for (auto& it : keys) {
+      TRI_FindByKeyHashArray(&array, &it);
+    }
+    benchmark.stop(group, "lookup", n);
+
+    benchmark.start();
+    for (auto const& it : batches) {
+      TRI_FindByKeysHashArray(&array, it, result);
+    }
+    benchmark.stop(group, "batchedLookup", n);
+
+    benchmark.start();
+    for (auto& it : elements) {
+      TRI_RemoveElementHashArray(nullptr, &array, &it);
+    }
+    benchmark.stop(group, "remove", n);
+
+    TRI_DestroyHashArray(&array);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
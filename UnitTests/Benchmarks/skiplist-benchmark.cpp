@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief micro benchmarks for SkipList
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include "Basics/skip-list.h"
+
+#include <random>
+
+using namespace triagens::basics;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of nodes visited by each range scan
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const RangeLength = 100;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private helpers
+// -----------------------------------------------------------------------------
+
+static int CmpElmElm (void*,
+                      void* left,
+                      void* right,
+                      SkipListCmpType) {
+  auto l = *(static_cast<uint64_t*>(left));
+  auto r = *(static_cast<uint64_t*>(right));
+
+  if (l != r) {
+    return l < r ? -1 : 1;
+  }
+  return 0;
+}
+
+static int CmpKeyElm (void*,
+                      void* left,
+                      void* right) {
+  auto l = *(static_cast<uint64_t*>(left));
+  auto r = *(static_cast<uint64_t*>(right));
+
+  if (l != r) {
+    return l < r ? -1 : 1;
+  }
+  return 0;
+}
+
+static void FreeElm (void*) {
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief insert, lookup, range scan and remove throughput of SkipList
+////////////////////////////////////////////////////////////////////////////////
+
+void RunSkiplistBenchmarks (Benchmark& benchmark) {
+  std::string const group("SkipList");
+
+  if (! benchmark.enabled(group)) {
+    return;
+  }
+
+  size_t const n = benchmark.size();
+
+  // insert the values in random, but repeatable order
+  std::vector<uint64_t> values;
+  values.reserve(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    values.emplace_back(static_cast<uint64_t>(i));
+  }
+
+  std::mt19937_64 generator(0x12345678);
+  std::shuffle(values.begin(), values.end(), generator);
+
+  size_t const numScans = (std::max)(n / RangeLength, static_cast<size_t>(1));
+
+  for (size_t run = 0; run < benchmark.runs(); ++run) {
+    SkipList skiplist(CmpElmElm, CmpKeyElm, nullptr, FreeElm, true);
+
+    benchmark.start();
+    for (auto& it : values) {
+      skiplist.insert(&it);
+    }
+    benchmark.stop(group, "insert", n, skiplist.memoryUsage());
+
+    benchmark.start();
+    for (auto& it : values) {
+      skiplist.lookup(&it);
+    }
+    benchmark.stop(group, "lookup", n);
+
+    benchmark.start();
+    for (size_t i = 0; i < numScans; ++i) {
+      SkipListNode* node = skiplist.leftKeyLookup(&values[i]);
+
+      for (size_t j = 0; j < RangeLength && node != nullptr; ++j) {
+        node = node->nextNode();
+      }
+    }
+    benchmark.stop(group, "rangeScan", numScans);
+
+    benchmark.start();
+    for (auto& it : values) {
+      skiplist.remove(&it);
+    }
+    benchmark.stop(group, "remove", n);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,253 @@
+# coding: utf-8
+
+require 'rspec'
+require 'arangodb.rb'
+require 'json'
+
+describe ArangoDB do
+
+  before do
+    @api = "/_api/query/cache"
+    @prefix = "api-query-cache"
+    @cursor = "/_api/cursor"
+    @cn = "UnitTestsQueryCache"
+  end
+
+  def set_properties (properties)
+    ArangoDB.log_put("#{@prefix}-properties", @api, :body => JSON.dump(properties))
+  end
+
+  def run_query (query, options = { })
+    body = { query: query, bindVars: { "@collection" => @cn } }
+    body.merge!(options)
+    doc = ArangoDB.log_post("#{@prefix}-cursor", @cursor, :body => JSON.dump(body))
+    doc.code.should eq(201)
+    doc.parsed_response['error'].should eq(false)
+    doc
+  end
+
+################################################################################
+## properties and figures
+################################################################################
+
+  context "dealing with the query cache properties:" do
+    after do
+      set_properties({ mode: "off" })
+    end
+
+    it "returns the properties and figures" do
+      doc = ArangoDB.log_get("#{@prefix}-get", @api)
+
+      doc.code.should eq(200)
+      doc.headers['content-type'].should eq("application/json; charset=utf-8")
+      doc.parsed_response['error'].should eq(false)
+      doc.parsed_response['code'].should eq(200)
+      doc.parsed_response['mode'].should be_kind_of(String)
+      doc.parsed_response['maxResults'].should be_kind_of(Integer)
+      doc.parsed_response['maxMemory'].should be_kind_of(Integer)
+      doc.parsed_response['entries'].should be_kind_of(Integer)
+      doc.parsed_response['memory'].should be_kind_of(Integer)
+      doc.parsed_response['hits'].should be_kind_of(Integer)
+      doc.parsed_response['misses'].should be_kind_of(Integer)
+
+      plans = doc.parsed_response['plans']
+      plans['maxEntries'].should be_kind_of(Integer)
+      plans['entries'].should be_kind_of(Integer)
+      plans['hits'].should be_kind_of(Integer)
+      plans['misses'].should be_kind_of(Integer)
+    end
+
+    it "changes the properties" do
+      doc = set_properties({ mode: "demand", maxResults: 42 })
+
+      doc.code.should eq(200)
+      doc.parsed_response['error'].should eq(false)
+      doc.parsed_response['mode'].should eq("demand")
+      doc.parsed_response['maxResults'].should eq(42)
+
+      doc = ArangoDB.log_get("#{@prefix}-get", @api)
+      doc.code.should eq(200)
+      doc.parsed_response['mode'].should eq("demand")
+      doc.parsed_response['maxResults'].should eq(42)
+
+      doc = set_properties({ mode: "on" })
+      doc.code.should eq(200)
+      doc.parsed_response['mode'].should eq("on")
+      doc.parsed_response['maxResults'].should eq(42)
+    end
+
+    it "rejects an invalid mode" do
+      doc = set_properties({ mode: "foo" })
+
+      doc.code.should eq(400)
+      doc.parsed_response['error'].should eq(true)
+      doc.parsed_response['code'].should eq(400)
+      doc.parsed_response['errorNum'].should eq(10)
+    end
+  end
+
+################################################################################
+## caching of query results
+################################################################################
+
+  context "caching query results:" do
+    before do
+      ArangoDB.drop_collection(@cn)
+      ArangoDB.create_collection(@cn, false)
+
+      (0...10).each{|i|
+        ArangoDB.post("/_api/document?collection=#{@cn}", :body => JSON.dump({ value: i }))
+      }
+
+      set_properties({ mode: "on", maxResults: 128 })
+      ArangoDB.log_delete("#{@prefix}-delete", @api)
+    end
+
+    after do
+      set_properties({ mode: "off" })
+      ArangoDB.drop_collection(@cn)
+    end
+
+    it "serves repeated queries from the cache" do
+      query = "FOR doc IN @@collection SORT doc.value RETURN doc.value"
+
+      doc = ArangoDB.log_get("#{@prefix}-get", @api)
+      hits = doc.parsed_response['hits']
+      misses = doc.parsed_response['misses']
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+      doc.parsed_response['result'].should eq((0...10).to_a)
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(true)
+      doc.parsed_response['result'].should eq((0...10).to_a)
+
+      doc = ArangoDB.log_get("#{@prefix}-get", @api)
+      doc.parsed_response['entries'].should eq(1)
+      doc.parsed_response['hits'].should eq(hits + 1)
+      doc.parsed_response['misses'].should eq(misses + 1)
+    end
+
+    it "distinguishes queries by their bind parameters" do
+      query = "FOR doc IN @@collection FILTER doc.value < @value SORT doc.value RETURN doc.value"
+
+      doc = run_query(query, { bindVars: { "@collection" => @cn, "value" => 3 } })
+      doc.parsed_response['cached'].should eq(false)
+      doc.parsed_response['result'].should eq([ 0, 1, 2 ])
+
+      doc = run_query(query, { bindVars: { "@collection" => @cn, "value" => 5 } })
+      doc.parsed_response['cached'].should eq(false)
+      doc.parsed_response['result'].should eq([ 0, 1, 2, 3, 4 ])
+
+      doc = run_query(query, { bindVars: { "@collection" => @cn, "value" => 3 } })
+      doc.parsed_response['cached'].should eq(true)
+      doc.parsed_response['result'].should eq([ 0, 1, 2 ])
+    end
+
+    it "invalidates results on writes" do
+      query = "FOR doc IN @@collection SORT doc.value RETURN doc.value"
+
+      run_query(query)
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(true)
+
+      doc = ArangoDB.post("/_api/document?collection=#{@cn}", :body => JSON.dump({ value: 10 }))
+      doc.code.should eq(202)
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+      doc.parsed_response['result'].should eq((0..10).to_a)
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(true)
+      doc.parsed_response['result'].should eq((0..10).to_a)
+
+      doc = ArangoDB.put("/_api/simple/remove-by-example", :body => JSON.dump({ collection: @cn, example: { value: 10 } }))
+      doc.code.should eq(200)
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+      doc.parsed_response['result'].should eq((0...10).to_a)
+    end
+
+    it "invalidates results on writes by AQL queries" do
+      query = "FOR doc IN @@collection SORT doc.value RETURN doc.value"
+
+      run_query(query)
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(true)
+
+      run_query("FOR doc IN @@collection FILTER doc.value >= 5 REMOVE doc IN @@collection")
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+      doc.parsed_response['result'].should eq((0...5).to_a)
+    end
+
+    it "does not cache non-deterministic queries" do
+      query = "FOR doc IN @@collection SORT doc.value RETURN [ doc.value, RAND() ]"
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+    end
+
+    it "bypasses the cache if requested" do
+      query = "FOR doc IN @@collection SORT doc.value RETURN doc.value"
+
+      run_query(query)
+      doc = run_query(query, { cache: false })
+      doc.parsed_response['cached'].should eq(false)
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(true)
+    end
+
+    it "uses the cache on demand only" do
+      set_properties({ mode: "demand" })
+      query = "FOR doc IN @@collection SORT doc.value RETURN doc.value"
+
+      run_query(query)
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+
+      run_query(query, { cache: true })
+      doc = run_query(query, { cache: true })
+      doc.parsed_response['cached'].should eq(true)
+    end
+
+    it "clears the cache" do
+      query = "FOR doc IN @@collection SORT doc.value RETURN doc.value"
+
+      run_query(query)
+      doc = ArangoDB.log_get("#{@prefix}-get", @api)
+      doc.parsed_response['entries'].should eq(1)
+
+      doc = ArangoDB.log_delete("#{@prefix}-delete", @api)
+      doc.code.should eq(200)
+      doc.parsed_response['error'].should eq(false)
+
+      doc = ArangoDB.log_get("#{@prefix}-get", @api)
+      doc.parsed_response['entries'].should eq(0)
+
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+    end
+
+    it "does not use the cache when turned off" do
+      query = "FOR doc IN @@collection SORT doc.value RETURN doc.value"
+
+      run_query(query)
+      doc = set_properties({ mode: "off" })
+      doc.parsed_response['entries'].should eq(0)
+
+      run_query(query)
+      doc = run_query(query)
+      doc.parsed_response['cached'].should eq(false)
+    end
+  end
+
+end
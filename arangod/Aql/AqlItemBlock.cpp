@@ -46,9 +46,12 @@ using JsonHelper = triagens::basics::JsonHelper;
 ////////////////////////////////////////////////////////////////////////////////
 
 AqlItemBlock::AqlItemBlock (size_t nrItems, 
-                            RegisterId nrRegs)
+                            RegisterId nrRegs,
+                            bool columnar)
   : _nrItems(nrItems),  
-    _nrRegs(nrRegs) {
+    _nrRegs(nrRegs),
+    _nrItemsAllocated(nrItems),
+    _columnar(columnar) {
 
   TRI_ASSERT(nrItems > 0);  // no, empty AqlItemBlocks are not allowed!
 
@@ -70,7 +73,12 @@ AqlItemBlock::AqlItemBlock (size_t nrItems,
 /// @brief create the block from Json, note that this can throw
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlItemBlock::AqlItemBlock (Json const& json) {
+AqlItemBlock::AqlItemBlock (Json const& json)
+  : _nrItems(0),
+    _nrRegs(0),
+    _nrItemsAllocated(0),
+    _columnar(false) {
+
   bool exhausted = JsonHelper::getBooleanValue(json.json(), "exhausted", false);
   if (exhausted) {
     THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "exhausted must be false");
@@ -82,6 +90,7 @@ AqlItemBlock::AqlItemBlock (Json const& json) {
   }
 
   _nrRegs = JsonHelper::getNumericValue<RegisterId>(json.json(), "nrRegs", 0);
+  _nrItemsAllocated = _nrItems;
 
   // Initialize the data vector:
   if (_nrRegs > 0) {
@@ -233,7 +242,7 @@ void AqlItemBlock::shrink (size_t nrItems) {
   // erase all stored values in the region that we freed
   for (size_t i = nrItems; i < _nrItems; ++i) {
     for (RegisterId j = 0; j < _nrRegs; ++j) {
-      AqlValue& a(_data[_nrRegs * i + j]);
+      AqlValue& a(_data[position(i, j)]);
 
       if (a.requiresDestruction()) {
         auto it = _valueCount.find(a);
@@ -259,6 +268,51 @@ void AqlItemBlock::shrink (size_t nrItems) {
   _nrItems = nrItems;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief reduce the block in place to the rows of a selection vector
+////////////////////////////////////////////////////////////////////////////////
+
+void AqlItemBlock::select (std::vector<size_t> const& chosen,
+                           size_t from,
+                           size_t to) {
+  TRI_ASSERT(from < to && to <= chosen.size());
+
+  // first get rid of all rows that are not selected. values shared with a
+  // selected row survive this because of the reference counting
+  size_t next = from;
+  for (size_t row = 0; row < _nrItems; ++row) {
+    if (next < to && chosen[next] == row) {
+      ++next;
+      continue;
+    }
+
+    for (RegisterId col = 0; col < _nrRegs; ++col) {
+      destroyValue(row, col);
+    }
+  }
+  TRI_ASSERT(next == to);
+
+  // now move the selected rows to the front. as the selection vector is
+  // sorted, the target row is always empty or identical to the source row
+  size_t const n = to - from;
+  for (size_t row = 0; row < n; ++row) {
+    size_t const source = chosen[from + row];
+    TRI_ASSERT(source >= row);
+
+    if (source == row) {
+      continue;
+    }
+
+    for (RegisterId col = 0; col < _nrRegs; ++col) {
+      AqlValue& a(_data[position(source, col)]);
+      _data[position(row, col)] = a;
+      a.erase();
+    }
+  }
+
+  _nrItems = n;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief clears out some columns (registers), this deletes the values if
 /// necessary, using the reference count.
@@ -267,7 +321,7 @@ void AqlItemBlock::shrink (size_t nrItems) {
 void AqlItemBlock::clearRegisters (std::unordered_set<RegisterId> const& toClear) {
   for (auto reg : toClear) {
     for (size_t i = 0; i < _nrItems; i++) {
-      AqlValue& a(_data[_nrRegs * i + reg]);
+      AqlValue& a(_data[position(i, reg)]);
 
       if (a.requiresDestruction()) {
         auto it = _valueCount.find(a);
@@ -302,7 +356,7 @@ AqlItemBlock* AqlItemBlock::slice (size_t from,
   std::unordered_map<AqlValue, AqlValue> cache;
   cache.reserve((to - from) * _nrRegs / 4 + 1);
 
-  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(to - from, _nrRegs));
+  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(to - from, _nrRegs, _columnar));
 
   for (RegisterId col = 0; col < _nrRegs; col++) {
     res->_docColls[col] = _docColls[col];
@@ -310,7 +364,7 @@ AqlItemBlock* AqlItemBlock::slice (size_t from,
 
   for (size_t row = from; row < to; row++) {
     for (RegisterId col = 0; col < _nrRegs; col++) {
-      AqlValue const& a(_data[row * _nrRegs + col]);
+      AqlValue const& a(_data[position(row, col)]);
 
       if (! a.isEmpty()) {
         auto it = cache.find(a);
@@ -344,7 +398,7 @@ AqlItemBlock* AqlItemBlock::slice (size_t row,
                                    std::unordered_set<RegisterId> const& registers) const {
   std::unordered_map<AqlValue, AqlValue> cache;
 
-  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(1, _nrRegs));
+  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(1, _nrRegs, _columnar));
 
   for (RegisterId col = 0; col < _nrRegs; col++) {
     if (registers.find(col) == registers.end()) {
@@ -353,7 +407,7 @@ AqlItemBlock* AqlItemBlock::slice (size_t row,
 
     res->_docColls[col] = _docColls[col];
 
-    AqlValue const& a(_data[row * _nrRegs + col]);
+    AqlValue const& a(_data[position(row, col)]);
 
     if (! a.isEmpty()) {
       auto it = cache.find(a);
@@ -391,7 +445,7 @@ AqlItemBlock* AqlItemBlock::slice (std::vector<size_t>& chosen,
   std::unordered_map<AqlValue, AqlValue> cache;
   cache.reserve((to - from) * _nrRegs / 4 + 1);
 
-  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(to - from, _nrRegs));
+  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(to - from, _nrRegs, _columnar));
 
   for (RegisterId col = 0; col < _nrRegs; col++) {
     res->_docColls[col] = _docColls[col];
@@ -399,7 +453,7 @@ AqlItemBlock* AqlItemBlock::slice (std::vector<size_t>& chosen,
 
   for (size_t row = from; row < to; row++) {
     for (RegisterId col = 0; col < _nrRegs; col++) {
-      AqlValue const& a(_data[chosen[row] * _nrRegs + col]);
+      AqlValue const& a(_data[position(chosen[row], col)]);
 
       if (! a.isEmpty()) {
         auto it = cache.find(a);
@@ -439,7 +493,7 @@ AqlItemBlock* AqlItemBlock::steal (std::vector<size_t>& chosen,
                                    size_t to) {
   TRI_ASSERT(from < to && to <= chosen.size());
 
-  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(to - from, _nrRegs));
+  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(to - from, _nrRegs, _columnar));
 
   for (RegisterId col = 0; col < _nrRegs; col++) {
     res->_docColls[col] = _docColls[col];
@@ -447,7 +501,7 @@ AqlItemBlock* AqlItemBlock::steal (std::vector<size_t>& chosen,
 
   for (size_t row = from; row < to; row++) {
     for (RegisterId col = 0; col < _nrRegs; col++) {
-      AqlValue& a(_data[chosen[row] * _nrRegs + col]);
+      AqlValue& a(_data[position(chosen[row], col)]);
 
       if (! a.isEmpty()) {
         steal(a);
@@ -490,7 +544,7 @@ AqlItemBlock* AqlItemBlock::concatenate (std::vector<AqlItemBlock*> const& block
   TRI_ASSERT(totalSize > 0);
   TRI_ASSERT(nrRegs > 0);
 
-  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(totalSize, nrRegs));
+  std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(totalSize, nrRegs, blocks[0]->isColumnar()));
 
   size_t pos = 0;
   for (it = blocks.begin(); it != blocks.end(); ++it) {
@@ -525,6 +579,22 @@ AqlItemBlock* AqlItemBlock::concatenate (std::vector<AqlItemBlock*> const& block
   return res.release();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief estimate the memory used by the block and its values
+////////////////////////////////////////////////////////////////////////////////
+
+size_t AqlItemBlock::memoryUsage () const {
+  size_t size = sizeof(AqlItemBlock) + 
+                _data.size() * sizeof(AqlValue) + 
+                _docColls.size() * sizeof(TRI_document_collection_t const*);
+
+  for (auto const& it : _valueCount) {
+    size += sizeof(it) + it.first.memoryUsage();
+  }
+
+  return size;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief toJson, transfer a whole AqlItemBlock to Json, the result can
 /// be used to recreate the AqlItemBlock via the Json constructor
@@ -582,7 +652,7 @@ Json AqlItemBlock::toJson (triagens::arango::AqlTransaction* trx) const {
   size_t pos = 2;   // write position in raw
   for (RegisterId column = 0; column < _nrRegs; column++) {
     for (size_t i = 0; i < _nrItems; i++) {
-      AqlValue const& a(_data[i * _nrRegs + column]);
+      AqlValue const& a(_data[position(i, column)]);
       if (a.isEmpty()) {
         emptyCount++;
       }
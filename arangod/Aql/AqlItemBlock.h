@@ -52,6 +52,12 @@ namespace triagens {
 // <getDocumentCollections>. There is no access to an entire item, only
 // access to particular registers of an item (via getValue).
 //
+// The values can be stored in one of two layouts: row-major (all registers of
+// an item are adjacent, the default) or column-major (all values of a register
+// are adjacent). The column-major layout is meant for blocks that are mainly
+// processed register by register, e.g. by vectorized calculations and filters.
+// The layout is transparent for all users of the public accessors.
+//
 // An AqlItemBlock is responsible to explicitly destroy all the
 // <AqlValue>s it contains at destruction time. It is however allowed
 // that multiple of the <AqlValue>s in it are pointing to identical
@@ -75,7 +81,8 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         AqlItemBlock (size_t nrItems, 
-                      RegisterId nrRegs);
+                      RegisterId nrRegs,
+                      bool columnar = false);
 
         AqlItemBlock (triagens::basics::Json const& json);
 
@@ -102,8 +109,8 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         AqlValue getValue (size_t index, RegisterId varNr) const {
-          TRI_ASSERT_EXPENSIVE(_data.capacity() > index * _nrRegs + varNr);
-          return _data[index * _nrRegs + varNr];
+          TRI_ASSERT_EXPENSIVE(_data.capacity() > position(index, varNr));
+          return _data[position(index, varNr)];
         }
  
 ////////////////////////////////////////////////////////////////////////////////
@@ -111,8 +118,8 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         AqlValue const& getValueReference (size_t index, RegisterId varNr) const {
-          TRI_ASSERT_EXPENSIVE(_data.capacity() > index * _nrRegs + varNr);
-          return _data[index * _nrRegs + varNr];
+          TRI_ASSERT_EXPENSIVE(_data.capacity() > position(index, varNr));
+          return _data[position(index, varNr)];
         }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -120,8 +127,9 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
       void setValue (size_t index, RegisterId varNr, AqlValue const& value) {
-        TRI_ASSERT_EXPENSIVE(_data.capacity() > index * _nrRegs + varNr);
-        TRI_ASSERT_EXPENSIVE(_data[index * _nrRegs + varNr].isEmpty());
+        size_t const pos = position(index, varNr);
+        TRI_ASSERT_EXPENSIVE(_data.capacity() > pos);
+        TRI_ASSERT_EXPENSIVE(_data[pos].isEmpty());
 
         // First update the reference count, if this fails, the value is empty
         if (value.requiresDestruction()) {
@@ -139,7 +147,7 @@ namespace triagens {
           }
         }
 
-        _data[index * _nrRegs + varNr] = value;
+        _data[pos] = value;
       }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -148,10 +156,11 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         void setShaped (size_t index, RegisterId varNr, TRI_df_marker_t const* marker) {
-          TRI_ASSERT_EXPENSIVE(_data.capacity() > index * _nrRegs + varNr);
-          TRI_ASSERT_EXPENSIVE(! _data[index * _nrRegs + varNr].requiresDestruction());
+          size_t const pos = position(index, varNr);
+          TRI_ASSERT_EXPENSIVE(_data.capacity() > pos);
+          TRI_ASSERT_EXPENSIVE(! _data[pos].requiresDestruction());
 
-          auto& v = _data[index * _nrRegs + varNr];
+          auto& v = _data[pos];
           v._marker = marker;
           v._type = AqlValue::SHAPED;
         }
@@ -164,7 +173,7 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         void destroyValue (size_t index, RegisterId varNr) {
-          size_t const pos = index * _nrRegs + varNr;
+          size_t const pos = position(index, varNr);
           auto& element = _data[pos];
 
           if (element.requiresDestruction()) {
@@ -192,7 +201,7 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         void eraseValue (size_t index, RegisterId varNr) {
-          size_t const pos = index * _nrRegs + varNr;
+          size_t const pos = position(index, varNr);
           auto& element = _data[pos];
 
           if (element.requiresDestruction()) {
@@ -290,6 +299,14 @@ namespace triagens {
           return _nrItems;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the block uses the column-major layout
+////////////////////////////////////////////////////////////////////////////////
+
+        inline bool isColumnar () const {
+          return _columnar;
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief getter for _docColls
 ////////////////////////////////////////////////////////////////////////////////
@@ -304,6 +321,19 @@ namespace triagens {
 
         void shrink (size_t nrItems);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief reduce the block in place to the rows contained in the selection
+/// vector <chosen> between positions <from> (inclusive) and <to> (exclusive).
+/// the selected rows are moved to the front of the block in their original
+/// order, all other rows are destroyed. in contrast to steal(), this neither
+/// allocates a new block nor touches the reference counts of the values that
+/// are kept. the selection vector must be sorted in ascending order
+////////////////////////////////////////////////////////////////////////////////
+
+        void select (std::vector<size_t> const& chosen,
+                     size_t from,
+                     size_t to);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief clears out some columns (registers), this deletes the values if
 /// necessary, using the reference count.
@@ -360,6 +390,30 @@ namespace triagens {
 
         triagens::basics::Json toJson (triagens::arango::AqlTransaction* trx) const;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief estimate the memory used by the block and its values. values that
+/// are used in multiple rows are only counted once
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t memoryUsage () const;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief position of a register value of an item inside _data
+////////////////////////////////////////////////////////////////////////////////
+
+        inline size_t position (size_t index, RegisterId varNr) const {
+          if (_columnar) {
+            return varNr * _nrItemsAllocated + index;
+          }
+          return index * _nrRegs + varNr;
+        }
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
 // -----------------------------------------------------------------------------
@@ -368,7 +422,8 @@ namespace triagens {
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief _data, the actual data as a single vector of dimensions _nrItems
-/// times _nrRegs
+/// times _nrRegs. in column-major layout, each column occupies
+/// _nrItemsAllocated consecutive slots
 ////////////////////////////////////////////////////////////////////////////////
 
         std::vector<AqlValue> _data;
@@ -403,6 +458,20 @@ namespace triagens {
 
         RegisterId _nrRegs;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief _nrItemsAllocated, number of rows the block was created with. this
+/// is the column stride in column-major layout and does not change when the
+/// block is shrunk
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t     _nrItemsAllocated;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief _columnar, whether the values are stored column by column
+////////////////////////////////////////////////////////////////////////////////
+
+        bool       _columnar;
+
     };
 
   }  // namespace triagens::aql
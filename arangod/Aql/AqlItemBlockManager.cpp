@@ -41,7 +41,8 @@ using namespace triagens::aql;
 ////////////////////////////////////////////////////////////////////////////////
 
 AqlItemBlockManager::AqlItemBlockManager ()
-  : _last(nullptr) {
+  : _last(nullptr),
+    _columnar(false) {
 
 }
 
@@ -65,13 +66,14 @@ AqlItemBlock* AqlItemBlockManager::requestBlock (size_t nrItems,
                                                  RegisterId nrRegs) {
   if (_last != nullptr &&
       _last->size() == nrItems &&
-      _last->getNrRegs() == nrRegs) {
+      _last->getNrRegs() == nrRegs &&
+      _last->isColumnar() == _columnar) {
     auto block = _last;
     _last = nullptr;
     return block;
   }
 
-  return new AqlItemBlock(nrItems, nrRegs);
+  return new AqlItemBlock(nrItems, nrRegs, _columnar);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
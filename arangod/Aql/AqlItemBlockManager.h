@@ -81,6 +81,22 @@ namespace triagens {
 
         void returnBlock (AqlItemBlock*&);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not new blocks are created in column-major layout
+////////////////////////////////////////////////////////////////////////////////
+
+        inline bool columnar () const {
+          return _columnar;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the layout for blocks created from now on
+////////////////////////////////////////////////////////////////////////////////
+
+        inline void columnar (bool value) {
+          _columnar = value;
+        }
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
 // -----------------------------------------------------------------------------
@@ -94,6 +110,12 @@ namespace triagens {
 
         AqlItemBlock* _last;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether new blocks are created in column-major layout
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _columnar;
+
     };
 
   }
@@ -129,6 +129,39 @@ std::string AqlValue::getTypeString () const {
   THROW_ARANGO_EXCEPTION(TRI_ERROR_INTERNAL);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief estimate the memory used by the value, not including the AqlValue
+/// itself
+////////////////////////////////////////////////////////////////////////////////
+
+size_t AqlValue::memoryUsage () const {
+  switch (_type) {
+    case JSON: {
+      return sizeof(Json) + TRI_MemoryUsageJson(_json->json());
+    }
+
+    case DOCVEC: {
+      size_t size = sizeof(std::vector<AqlItemBlock*>);
+      for (auto it = _vector->begin(); it != _vector->end(); ++it) {
+        size += (*it)->memoryUsage();
+      }
+      return size;
+    }
+
+    case RANGE: {
+      return sizeof(Range);
+    }
+
+    case SHAPED: 
+    case EMPTY: {
+      // the document data is not owned by the value
+      return 0;
+    }
+  }
+
+  return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief clone for recursive copying
 ////////////////////////////////////////////////////////////////////////////////
@@ -201,6 +201,13 @@ namespace triagens {
 
       AqlValue clone () const;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief estimate the memory used by the value, not including the AqlValue
+/// itself
+////////////////////////////////////////////////////////////////////////////////
+
+      size_t memoryUsage () const;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief whether or not the AqlValue contains a string value
 ////////////////////////////////////////////////////////////////////////////////
@@ -1019,9 +1019,49 @@ AstNode* Ast::createNodeNop () {
 /// @brief injects bind parameters into the AST
 ////////////////////////////////////////////////////////////////////////////////
 
-void Ast::injectBindParameters (BindParameters& parameters) {
+void Ast::injectBindParameters (BindParameters& parameters,
+                                std::unordered_set<std::string>* constantParameters) {
   auto p = parameters();
 
+  if (constantParameters != nullptr) {
+    // determine the bind parameters whose values must be known to the optimizer
+    auto collect = [&](AstNode const* node) -> void {
+      traverseReadOnly(node, [&](AstNode const* sub, void*) -> void {
+        if (sub->type == NODE_TYPE_PARAMETER) {
+          constantParameters->emplace(sub->getStringValue());
+        }
+      }, nullptr);
+    };
+
+    traverseReadOnly(_root, [&](AstNode const* node, void*) -> void {
+      switch (node->type) {
+        case NODE_TYPE_LIMIT:
+          collect(node);
+          break;
+        case NODE_TYPE_SORT_ELEMENT:
+        case NODE_TYPE_BOUND_ATTRIBUTE_ACCESS:
+        case NODE_TYPE_INDEXED_ACCESS:
+          // sort direction, attribute name
+          collect(node->getMember(1));
+          break;
+        case NODE_TYPE_EXAMPLE:
+        case NODE_TYPE_REMOVE:
+        case NODE_TYPE_INSERT:
+        case NODE_TYPE_UPDATE:
+        case NODE_TYPE_REPLACE:
+        case NODE_TYPE_UPSERT:
+        case NODE_TYPE_COLLECT:
+        case NODE_TYPE_COLLECT_COUNT:
+        case NODE_TYPE_COLLECT_EXPRESSION:
+          // example, OPTIONS
+          collect(node->getMember(0));
+          break;
+        default: {
+        }
+      }
+    }, nullptr);
+  }
+
   auto func = [&](AstNode* node, void*) -> AstNode* {
     if (node->type == NODE_TYPE_PARAMETER) {
       // found a bind parameter in the query string
@@ -1042,6 +1082,15 @@ void Ast::injectBindParameters (BindParameters& parameters) {
       // mark the bind parameter as being used
       (*it).second.second = true;
 
+      if (constantParameters != nullptr) {
+        if (*param != '@' &&
+            constantParameters->find(std::string(param)) == constantParameters->end()) {
+          // the value will be inserted when the plan is instanciated
+          return node;
+        }
+        constantParameters->emplace(std::string(param));
+      }
+
       auto value = (*it).second.first;
 
       if (*param == '@') {
@@ -537,9 +537,23 @@ namespace triagens {
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief injects bind parameters into the AST
+/// if constantParameters is given, value bind parameters are only injected
+/// where the optimizer needs to know their values, e.g. in LIMIT, SORT
+/// directions, OPTIONS or attribute names. all other value bind parameters
+/// remain parameter nodes, so the optimized plan does not depend on their
+/// values. the names of all injected bind parameters, including collection
+/// bind parameters, are added to constantParameters
 ////////////////////////////////////////////////////////////////////////////////
 
-        void injectBindParameters (BindParameters&);
+        void injectBindParameters (BindParameters&,
+                                   std::unordered_set<std::string>* = nullptr);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create an AST node from JSON
+////////////////////////////////////////////////////////////////////////////////
+
+        AstNode* nodeFromJson (TRI_json_t const*,
+                               bool);
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief replace variables
@@ -691,13 +705,6 @@ namespace triagens {
 
         AstNode* optimizeFor (AstNode*);
 
-////////////////////////////////////////////////////////////////////////////////
-/// @brief create an AST node from JSON
-////////////////////////////////////////////////////////////////////////////////
-
-        AstNode* nodeFromJson (TRI_json_t const*,
-                               bool);
-
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief traverse the AST, using pre- and post-order visitors
 ////////////////////////////////////////////////////////////////////////////////
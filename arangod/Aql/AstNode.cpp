@@ -1218,7 +1218,9 @@ bool AstNode::isSimple () const {
 
   if (type == NODE_TYPE_OBJECT_ELEMENT || 
       type == NODE_TYPE_ATTRIBUTE_ACCESS ||
-      type == NODE_TYPE_OPERATOR_UNARY_NOT) {
+      type == NODE_TYPE_OPERATOR_UNARY_NOT ||
+      type == NODE_TYPE_OPERATOR_UNARY_PLUS ||
+      type == NODE_TYPE_OPERATOR_UNARY_MINUS) {
     TRI_ASSERT(numMembers() == 1);
 
     if (! getMember(0)->isSimple()) {
@@ -1265,10 +1267,16 @@ bool AstNode::isSimple () const {
       type == NODE_TYPE_OPERATOR_BINARY_GE ||
       type == NODE_TYPE_OPERATOR_BINARY_IN ||
       type == NODE_TYPE_OPERATOR_BINARY_NIN ||
+      type == NODE_TYPE_OPERATOR_BINARY_PLUS ||
+      type == NODE_TYPE_OPERATOR_BINARY_MINUS ||
+      type == NODE_TYPE_OPERATOR_BINARY_TIMES ||
+      type == NODE_TYPE_OPERATOR_BINARY_DIV ||
+      type == NODE_TYPE_OPERATOR_BINARY_MOD ||
       type == NODE_TYPE_RANGE ||
       type == NODE_TYPE_INDEXED_ACCESS) {
     // a logical operator is simple if its operands are simple
     // a comparison operator is simple if both bounds are simple
+    // an arithmetic operator is simple if both operands are simple
     // a range is simple if both bounds are simple
     if (! getMember(0)->isSimple() || ! getMember(1)->isSimple()) {
       setFlag(DETERMINED_SIMPLE);
@@ -81,6 +81,14 @@ namespace triagens {
           return _parameters;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the original parameter json
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_json_t const* json () const {
+          return _json;
+        }
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                   private methods
 // -----------------------------------------------------------------------------
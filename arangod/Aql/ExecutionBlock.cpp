@@ -28,9 +28,11 @@
 #include "Aql/ExecutionBlock.h"
 #include "Aql/CollectionScanner.h"
 #include "Aql/ExecutionEngine.h"
+#include "Aql/Query.h"
 #include "Basics/ScopeGuard.h"
 #include "Basics/StringUtils.h"
 #include "Basics/StringBuffer.h"
+#include "Basics/ThreadPool.h"
 #include "Basics/json-utilities.h"
 #include "Basics/Exceptions.h"
 #include "Dispatcher/DispatcherThread.h"
@@ -823,7 +825,11 @@ EnumerateCollectionBlock::EnumerateCollectionBlock (ExecutionEngine* engine,
     _scanner(nullptr),
     _posInDocuments(0),
     _random(ep->_random),
-    _mustStoreResult(true) {
+    _mustStoreResult(true),
+    _filterExpressions(),
+    _filterInVars(),
+    _filterInRegs(),
+    _filterRegister(0) {
 
   auto trxCollection = _trx->trxCollection(_collection->cid());
   if (trxCollection != nullptr) {
@@ -842,6 +848,195 @@ EnumerateCollectionBlock::EnumerateCollectionBlock (ExecutionEngine* engine,
 
 EnumerateCollectionBlock::~EnumerateCollectionBlock () {
   delete _scanner;
+
+  for (auto& expressions : _filterExpressions) {
+    for (auto& e : expressions) {
+      delete e;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up the per-thread copies of the filter calculations
+////////////////////////////////////////////////////////////////////////////////
+
+void EnumerateCollectionBlock::initializeFilter () {
+  auto ep = static_cast<EnumerateCollectionNode const*>(_exeNode);
+  auto const& calculations = ep->filterCalculations();
+
+  // the filter blocks contain the document in register 0, followed by
+  // the results of the calculations
+  std::unordered_map<VariableId, RegisterId> registers;
+  registers.emplace(ep->_outVariable->id, 0);
+
+  for (size_t i = 0; i < calculations.size(); ++i) {
+    auto expression = calculations[i].second;
+    // the flags of the AST nodes must be determined before the
+    // expression is used by multiple threads
+    expression->prepareConcurrentExecution();
+
+    std::vector<Variable*> inVars;
+    std::vector<RegisterId> inRegs;
+
+    for (auto const& v : expression->variables()) {
+      auto it = registers.find(v->id);
+      TRI_ASSERT(it != registers.end());
+
+      inVars.emplace_back(v);
+      inRegs.emplace_back((*it).second);
+    }
+
+    _filterInVars.emplace_back(inVars);
+    _filterInRegs.emplace_back(inRegs);
+    registers.emplace(calculations[i].first->id, static_cast<RegisterId>(i + 1));
+  }
+
+  auto it = registers.find(ep->filterVariable()->id);
+  TRI_ASSERT(it != registers.end());
+  _filterRegister = (*it).second;
+
+  size_t const parallelism = (std::max)(ep->parallelism(), static_cast<size_t>(1));
+  _filterExpressions.reserve(parallelism);
+
+  for (size_t i = 0; i < parallelism; ++i) {
+    _filterExpressions.emplace_back(std::vector<Expression*>());
+    auto& expressions = _filterExpressions.back();
+    expressions.reserve(calculations.size());
+
+    for (auto const& calculation : calculations) {
+      auto expression = calculation.second->clone();
+      expressions.emplace_back(expression);
+
+      // analyze the copy here, before it is used by a filter thread
+      expression->canExecuteVectorized();
+      TRI_ASSERT(! expression->isV8());
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove all documents that do not match the filter
+////////////////////////////////////////////////////////////////////////////////
+
+void EnumerateCollectionBlock::filterDocuments (std::vector<TRI_doc_mptr_copy_t>& docs) {
+  size_t const n = docs.size();
+
+  // do not split the batch into tiny ranges
+  size_t numRanges = (std::min)(_filterExpressions.size(), (n + MinDocumentsPerRange - 1) / MinDocumentsPerRange);
+  if (numRanges == 0) {
+    numRanges = 1;
+  }
+
+  size_t const perRange = (n + numRanges - 1) / numRanges;
+  auto document = _trx->documentCollection(_collection->cid());
+
+  std::vector<char> matches(n, 0);
+  std::vector<std::exception_ptr> errors(numRanges);
+
+  auto work = [&] (size_t range) -> void {
+    size_t const from = range * perRange;
+    size_t const to = (std::min)(from + perRange, n);
+
+    try {
+      if (from < to) {
+        filterRange(range, docs, from, to, document, matches);
+      }
+    }
+    catch (...) {
+      errors[range] = std::current_exception();
+    }
+  };
+
+  auto pool = Query::ScanPool();
+
+  if (pool == nullptr) {
+    for (size_t i = 0; i < numRanges; ++i) {
+      work(i);
+    }
+  }
+  else {
+    // the ranges are handed out to the shared scan threads, and this thread
+    // takes part in the work. it never waits for ranges that no other
+    // thread has claimed yet, so a busy pool cannot block the query
+    pool->parallelFor(numRanges, work);
+  }
+
+  for (auto const& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // gather the matching documents, keeping them in scan order
+  size_t out = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    if (matches[i] != 0) {
+      if (out != i) {
+        docs[out] = docs[i];
+      }
+      ++out;
+    }
+  }
+
+  docs.resize(out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief evaluate the filter for a range of documents
+////////////////////////////////////////////////////////////////////////////////
+
+void EnumerateCollectionBlock::filterRange (size_t range,
+                                            std::vector<TRI_doc_mptr_copy_t> const& docs,
+                                            size_t from,
+                                            size_t to,
+                                            TRI_document_collection_t const* document,
+                                            std::vector<char>& matches) {
+  TRI_ASSERT(range < _filterExpressions.size());
+  auto const& expressions = _filterExpressions[range];
+  size_t const n = to - from;
+
+  std::unique_ptr<AqlItemBlock> block(new AqlItemBlock(n, static_cast<RegisterId>(expressions.size() + 1), _engine->getQuery()->columnarBlocks()));
+  block->setDocumentCollection(0, document);
+
+  for (size_t i = 0; i < n; ++i) {
+    block->setShaped(i, 0, reinterpret_cast<TRI_df_marker_t const*>(docs[from + i].getDataPtr()));
+  }
+
+  for (size_t j = 0; j < expressions.size(); ++j) {
+    auto expression = expressions[j];
+    RegisterId const outReg = static_cast<RegisterId>(j + 1);
+    block->setDocumentCollection(outReg, nullptr);
+
+    if (block->isColumnar() && expression->canExecuteVectorized()) {
+      expression->executeVectorized(_trx, block.get(), _filterInVars[j], _filterInRegs[j], outReg);
+      continue;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      TRI_document_collection_t const* myCollection = nullptr;
+      AqlValue a = expression->execute(_trx, block.get(), i, _filterInVars[j], _filterInRegs[j], &myCollection);
+
+      try {
+        block->setValue(i, outReg, a);
+      }
+      catch (...) {
+        a.destroy();
+        throw;
+      }
+
+      if (myCollection != nullptr) {
+        // a reference to the document
+        block->setDocumentCollection(outReg, myCollection);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    if (block->getValueReference(i, _filterRegister).isTrue()) {
+      matches[from + i] = 1;
+    }
+  }
 }
 
 bool EnumerateCollectionBlock::moreDocuments (size_t hint) {
@@ -849,26 +1044,46 @@ bool EnumerateCollectionBlock::moreDocuments (size_t hint) {
     hint = DefaultBatchSize;
   }
 
-  throwIfKilled(); // check if we were aborted
-
-  TRI_IF_FAILURE("EnumerateCollectionBlock::moreDocuments") {
-    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+  if (! _filterExpressions.empty()) {
+    // fetch enough documents to keep all filter threads busy
+    hint = (std::max)(hint, DefaultBatchSize * _filterExpressions.size());
   }
 
   std::vector<TRI_doc_mptr_copy_t> newDocs;
   newDocs.reserve(hint);
 
-  int res = _scanner->scan(newDocs, hint);
+  while (true) {
+    throwIfKilled(); // check if we were aborted
 
-  if (res != TRI_ERROR_NO_ERROR) {
-    THROW_ARANGO_EXCEPTION(res);
-  }
+    TRI_IF_FAILURE("EnumerateCollectionBlock::moreDocuments") {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+    }
+
+    int res = _scanner->scan(newDocs, hint);
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      THROW_ARANGO_EXCEPTION(res);
+    }
   
-  if (newDocs.empty()) {
-    return false;
-  }
+    if (newDocs.empty()) {
+      return false;
+    }
+
+    size_t const scanned = newDocs.size();
+    _engine->_stats.scannedFull += static_cast<int64_t>(scanned);
 
-  _engine->_stats.scannedFull += static_cast<int64_t>(newDocs.size());
+    if (_filterExpressions.empty()) {
+      break;
+    }
+
+    filterDocuments(newDocs);
+    _engine->_stats.filtered += static_cast<int64_t>(scanned - newDocs.size());
+
+    if (! newDocs.empty()) {
+      break;
+    }
+    // no document of this batch matched. continue scanning
+  }
 
   _documents.swap(newDocs);
   _posInDocuments = 0;
@@ -879,6 +1094,10 @@ bool EnumerateCollectionBlock::moreDocuments (size_t hint) {
 int EnumerateCollectionBlock::initialize () {
   auto ep = static_cast<EnumerateCollectionNode const*>(_exeNode);
   _mustStoreResult = ep->isVarUsedLater(ep->_outVariable);
+
+  if (ep->hasParallelFilter() && _filterExpressions.empty()) {
+    initializeFilter();
+  }
   
   return ExecutionBlock::initialize();
 }
@@ -1059,6 +1278,8 @@ IndexRangeBlock::IndexRangeBlock (ExecutionEngine* engine,
     _edgeIndexIterator(nullptr),
     _hashIndexSearchValue({ 0, nullptr }),
     _hashNextElement(nullptr),
+    _hashBatchRow(false),
+    _hashBatchDocument(nullptr),
     _condition(new IndexOrCondition()),
     _posInRanges(0),
     _sortCoords(),
@@ -1439,6 +1660,26 @@ int IndexRangeBlock::initialize () {
 bool IndexRangeBlock::initRanges () {
   ENTER_BLOCK
   _flag = true; 
+  _hashBatchRow = false;
+  
+  auto en = static_cast<IndexRangeNode const*>(getPlanNode());
+  TRI_ASSERT(en->_index != nullptr);
+
+  if (_anyBoundVariable &&
+      en->_index->type == triagens::arango::Index::TRI_IDX_TYPE_HASH_INDEX) {
+    if (_pos == 0) {
+      // first row of a new input block: look up all of its rows at once
+      batchHashIndexLookups();
+    }
+
+    if (_pos < _hashBatched.size() && _hashBatched[_pos]) {
+      destroyHashIndexSearchValues();
+      _hashBatchRow = true;
+      _hashBatchDocument = _hashBatchDocuments[_pos];
+      _hashNextElement = _hashBatchNext[_pos];
+      return true;
+    }
+  }
 
   // Find out about the actual values for the bounds in the variable bound case:
 
@@ -1477,9 +1718,6 @@ bool IndexRangeBlock::initRanges () {
       buildExpressions();
     }
   }
-  
-  auto en = static_cast<IndexRangeNode const*>(getPlanNode());
-  TRI_ASSERT(en->_index != nullptr);
    
   if (en->_index->type == triagens::arango::Index::TRI_IDX_TYPE_PRIMARY_INDEX) {
     return true; //no initialization here!
@@ -1810,6 +2048,8 @@ int IndexRangeBlock::initializeCursor (AqlItemBlock* items, size_t pos) {
   }
   _pos = 0;
   _posInDocs = 0;
+  _hashBatchRow = false;
+  _hashBatched.clear();
   
   return TRI_ERROR_NO_ERROR; 
   LEAVE_BLOCK;
@@ -2177,15 +2417,23 @@ void IndexRangeBlock::readEdgeIndex (size_t atMost) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void IndexRangeBlock::destroyHashIndexSearchValues () {
-  if (_hashIndexSearchValue._values != nullptr) {
+  destroyHashIndexSearchValue(_hashIndexSearchValue);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy a hash index search value
+////////////////////////////////////////////////////////////////////////////////
+
+void IndexRangeBlock::destroyHashIndexSearchValue (TRI_index_search_value_t& searchValue) {
+  if (searchValue._values != nullptr) {
     TRI_shaper_t* shaper = _collection->documentCollection()->getShaper(); 
 
-    for (size_t i = 0; i < _hashIndexSearchValue._length; ++i) {
-      TRI_DestroyShapedJson(shaper->_memoryZone, &_hashIndexSearchValue._values[i]);
+    for (size_t i = 0; i < searchValue._length; ++i) {
+      TRI_DestroyShapedJson(shaper->_memoryZone, &searchValue._values[i]);
     }
 
-    TRI_Free(TRI_UNKNOWN_MEM_ZONE, _hashIndexSearchValue._values);
-    _hashIndexSearchValue._values = nullptr;
+    TRI_Free(TRI_UNKNOWN_MEM_ZONE, searchValue._values);
+    searchValue._values = nullptr;
   }
 }
 
@@ -2268,19 +2516,145 @@ void IndexRangeBlock::getHashIndexIterator (IndexAndCondition const& ranges) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief actually read from the hash index
+/// @brief look up the hash index for all rows of the current input block
+///
+/// the bounds of all rows are evaluated first, so the index can compute and
+/// prefetch all bucket positions before probing any of them. this hides most
+/// of the cache misses of the individual lookups when the index is larger
+/// than the CPU caches. the first document of each row and the state for
+/// reading the remaining ones are kept until the row is processed
 ////////////////////////////////////////////////////////////////////////////////
- 
-void IndexRangeBlock::readHashIndex (size_t atMost) {
+
+void IndexRangeBlock::batchHashIndexLookups () {
   ENTER_BLOCK;
+  _hashBatched.clear();
+  _hashBatchDocuments.clear();
+  _hashBatchNext.clear();
 
-  if (_hashIndexSearchValue._values == nullptr) {
+  if (_hasV8Expression) {
+    // evaluating the bounds requires entering a V8 context for each row
+    return;
+  }
+
+  AqlItemBlock* cur = _buffer.front();
+  size_t const n = cur->size();
+
+  if (n < 2) {
+    // nothing to gain
+    return;
+  }
+
+  std::vector<TRI_index_search_value_t> searchValues;
+  searchValues.reserve(n);
+  std::vector<size_t> rows;
+  rows.reserve(n);
+
+  size_t const oldPos = _pos;
+
+  triagens::basics::ScopeGuard guard{
+    []() -> void { },
+    [&]() -> void {
+      _pos = oldPos;
+
+      for (auto& it : searchValues) {
+        destroyHashIndexSearchValue(it);
+      }
+    }
+  };
+
+  for (_pos = 0; _pos < n; ++_pos) {
+    buildExpressions();
+
+    if (_condition == nullptr || _condition->size() != 1) {
+      // empty or OR conditions are handled row by row
+      continue;
+    }
+
+    getHashIndexIterator(_condition->at(0));
+
+    if (_hashIndexSearchValue._values == nullptr) {
+      continue;
+    }
+
+    // take over the search value
+    searchValues.emplace_back(_hashIndexSearchValue);
+    _hashIndexSearchValue._values = nullptr;
+    _hashIndexSearchValue._length = 0;
+    rows.emplace_back(_pos);
+  }
+
+  if (rows.empty()) {
     return;
   }
 
+  std::vector<TRI_index_search_value_t*> keys;
+  keys.reserve(searchValues.size());
+
+  for (auto& it : searchValues) {
+    keys.emplace_back(&it);
+  }
+
+  auto en = static_cast<IndexRangeNode const*>(getPlanNode());
+  auto idx = en->_index->getInternals();
+  TRI_ASSERT(idx != nullptr);
+
+  std::vector<TRI_doc_mptr_t*> documents;
+  std::vector<struct TRI_hash_index_element_multi_s*> next;
+
+  TRI_IF_FAILURE("IndexRangeBlock::batchHashIndexLookups") {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+  }
+
+  static_cast<triagens::arango::HashIndex*>(idx)->lookup(keys, documents, next);
+  TRI_ASSERT(documents.size() == rows.size());
+  TRI_ASSERT(next.size() == rows.size());
+
+  _hashBatched.resize(n, false);
+  _hashBatchDocuments.resize(n, nullptr);
+  _hashBatchNext.resize(n, nullptr);
+
+  for (size_t i = 0; i < rows.size(); ++i) {
+    size_t const row = rows[i];
+    _hashBatched[row] = true;
+    _hashBatchDocuments[row] = documents[i];
+    _hashBatchNext[row] = next[i];
+  }
+  LEAVE_BLOCK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief actually read from the hash index
+////////////////////////////////////////////////////////////////////////////////
+ 
+void IndexRangeBlock::readHashIndex (size_t atMost) {
+  ENTER_BLOCK;
+
   auto en = static_cast<IndexRangeNode const*>(getPlanNode());
   auto idx = en->_index->getInternals();
   TRI_ASSERT(idx != nullptr);
+
+  if (_hashBatchRow) {
+    // the row was already looked up by batchHashIndexLookups
+    size_t const n = _documents.size();
+
+    if (_hashBatchDocument != nullptr) {
+      _documents.emplace_back(*_hashBatchDocument);
+      _hashBatchDocument = nullptr;
+    }
+
+    if (_hashNextElement != nullptr) {
+      // continue with the remaining documents. the search value is not needed
+      // for this, as the lookup only follows the iterator state
+      static_cast<triagens::arango::HashIndex*>(idx)->lookup(&_hashIndexSearchValue, _documents, _hashNextElement, atMost);
+    }
+
+    _engine->_stats.scannedIndex += static_cast<int64_t>(_documents.size() - n);
+    return;
+  }
+
+  if (_hashIndexSearchValue._values == nullptr) {
+    return;
+  }
   
   size_t nrSent = 0;
   while (nrSent < atMost) { 
@@ -2781,64 +3155,575 @@ void EnumerateListBlock::throwArrayExpectedException () {
 }
 
 // -----------------------------------------------------------------------------
-// --SECTION--                                            class CalculationBlock
+// --SECTION--                                               class HashJoinBlock
 // -----------------------------------------------------------------------------
-        
-CalculationBlock::CalculationBlock (ExecutionEngine* engine,
-                                    CalculationNode const* en)
+
+HashJoinBlock::HashJoinBlock (ExecutionEngine* engine,
+                              HashJoinNode const* en)
   : ExecutionBlock(engine, en),
-    _expression(en->expression()),
-    _inVars(),
-    _inRegs(),
-    _outReg(ExecutionNode::MaxRegisterId) {
+    _collection(en->_collection),
+    _scanner(nullptr),
+    _documents(),
+    _posInDocuments(0),
+    _hashCollection(en->_hashCollection),
+    _built(false),
+    _probing(false),
+    _mustStoreResult(true),
+    _outReg(ExecutionNode::MaxRegisterId),
+    _collectionExpression(en->_collectionExpression),
+    _collectionInVars(),
+    _collectionInRegs(),
+    _documentBlock(nullptr),
+    _inputExpression(en->_inputExpression),
+    _inputInVars(),
+    _inputInRegs(),
+    _collectionTable(1024, KeyHash(_trx), KeyEqual(_trx)),
+    _inputTable(1024, KeyHash(_trx), KeyEqual(_trx)),
+    _inputBlocks(),
+    _documentMatches(nullptr),
+    _rowMatches(nullptr),
+    _matchCount(0),
+    _posInMatches(0) {
 
-  std::unordered_set<Variable*> const& inVars = _expression->variables();
-  _inVars.reserve(inVars.size());
-  _inRegs.reserve(inVars.size());
+  auto trxCollection = _trx->trxCollection(_collection->cid());
+  if (trxCollection != nullptr) {
+    _trx->orderDitch(trxCollection);
+  }
 
-  for (auto it = inVars.begin(); it != inVars.end(); ++it) {
-    _inVars.emplace_back(*it);
-    auto it2 = en->getRegisterPlan()->varInfo.find((*it)->id);
+  _scanner = new LinearCollectionScanner(_trx, trxCollection);
 
-    TRI_ASSERT(it2 != en->getRegisterPlan()->varInfo.end());
-    TRI_ASSERT(it2->second.registerId < ExecutionNode::MaxRegisterId);
-    _inRegs.emplace_back(it2->second.registerId);
+  // the key expression for the documents only refers to the document itself,
+  // which is put into register 0 of _documentBlock
+  for (auto v : _collectionExpression->variables()) {
+    TRI_ASSERT(v->id == en->_outVariable->id);
+    _collectionInVars.emplace_back(v);
+    _collectionInRegs.emplace_back(0);
   }
 
-  // check if the expression is "only" a reference to another variable
-  // this allows further optimizations inside doEvaluation
-  _isReference = (_expression->node()->type == NODE_TYPE_REFERENCE);
+  for (auto v : _inputExpression->variables()) {
+    auto it = en->getRegisterPlan()->varInfo.find(v->id);
 
-  if (_isReference) {
-    TRI_ASSERT(_inRegs.size() == 1);
+    TRI_ASSERT(it != en->getRegisterPlan()->varInfo.end());
+    TRI_ASSERT(it->second.registerId < ExecutionNode::MaxRegisterId);
+    _inputInVars.emplace_back(v);
+    _inputInRegs.emplace_back(it->second.registerId);
   }
 
-  auto it3 = en->getRegisterPlan()->varInfo.find(en->_outVariable->id);
-  TRI_ASSERT(it3 != en->getRegisterPlan()->varInfo.end());
-  _outReg = it3->second.registerId;
+  auto it = en->getRegisterPlan()->varInfo.find(en->_outVariable->id);
+  TRI_ASSERT(it != en->getRegisterPlan()->varInfo.end());
+  _outReg = it->second.registerId;
   TRI_ASSERT(_outReg < ExecutionNode::MaxRegisterId);
-  
-  if (en->_conditionVariable != nullptr) {
-    auto it = en->getRegisterPlan()->varInfo.find(en->_conditionVariable->id);
-    TRI_ASSERT(it != en->getRegisterPlan()->varInfo.end());
-    _conditionReg = it->second.registerId;
-    TRI_ASSERT(_conditionReg < ExecutionNode::MaxRegisterId);
-  }
+
+  _documentBlock = new AqlItemBlock(1, 1);
+  _documentBlock->setDocumentCollection(0, _trx->documentCollection(_collection->cid()));
 }
 
-CalculationBlock::~CalculationBlock () {
+HashJoinBlock::~HashJoinBlock () {
+  freeCollectionTable();
+  freeInputTable();
+
+  delete _documentBlock;
+  delete _scanner;
 }
 
-int CalculationBlock::initialize () {
+int HashJoinBlock::initialize () {
+  auto en = static_cast<HashJoinNode const*>(_exeNode);
+  _mustStoreResult = en->isVarUsedLater(en->_outVariable);
+
   return ExecutionBlock::initialize();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief fill the target register in the item block with a reference to 
-/// another variable
+/// @brief initializeCursor
 ////////////////////////////////////////////////////////////////////////////////
 
-void CalculationBlock::fillBlockWithReference (AqlItemBlock* result) {
+int HashJoinBlock::initializeCursor (AqlItemBlock* items, 
+                                     size_t pos) {
+  int res = ExecutionBlock::initializeCursor(items, pos);
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    return res;
+  }
+
+  if (! _hashCollection) {
+    // the input rows are different for each cursor
+    freeInputTable();
+    _built = false;
+  }
+
+  _scanner->reset();
+  _documents.clear();
+  _posInDocuments = 0;
+  _probing = false;
+  _documentMatches = nullptr;
+  _rowMatches = nullptr;
+  _matchCount = 0;
+  _posInMatches = 0;
+
+  return TRI_ERROR_NO_ERROR;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief shutdown
+////////////////////////////////////////////////////////////////////////////////
+
+int HashJoinBlock::shutdown (int errorCode) {
+  freeCollectionTable();
+  freeInputTable();
+  _built = false;
+
+  return ExecutionBlock::shutdown(errorCode);
+}
+
+bool HashJoinBlock::hasMore () {
+  if (_done) {
+    return false;
+  }
+
+  if (nextMatch()) {
+    return true;
+  }
+
+  _done = true;
+  return false;
+}
+
+int HashJoinBlock::getOrSkipSome (size_t atLeast,
+                                  size_t atMost,
+                                  bool skipping,
+                                  AqlItemBlock*& result,
+                                  size_t& skipped) {
+  TRI_ASSERT(result == nullptr && skipped == 0);
+
+  if (_done) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  std::unique_ptr<AqlItemBlock> res;
+
+  while (skipped < atMost) {
+    if (! nextMatch()) {
+      _done = true;
+      break;
+    }
+
+    if (! skipping) {
+      if (res == nullptr) {
+        RegisterId nrRegs = getPlanNode()->getRegisterPlan()->nrRegs[getPlanNode()->getDepth()];
+        res.reset(requestBlock(atMost, nrRegs));
+        res->setDocumentCollection(_outReg, _trx->documentCollection(_collection->cid()));
+      }
+
+      TRI_df_marker_t const* marker;
+
+      if (_hashCollection) {
+        AqlItemBlock const* cur = _buffer.front();
+        marker = (*_documentMatches)[_posInMatches];
+
+        if (skipped > 0 && _posInMatches > 0) {
+          // the previous output row was produced from the same input row.
+          // re-use its already copied values
+          RegisterId const curRegs = cur->getNrRegs();
+          for (RegisterId i = 0; i < curRegs; i++) {
+            res->setValue(skipped, i, res->getValueReference(skipped - 1, i));
+          }
+        }
+        else {
+          inheritRegisters(cur, res.get(), _pos, skipped);
+        }
+      }
+      else {
+        auto const& match = (*_rowMatches)[_posInMatches];
+        marker = static_cast<TRI_df_marker_t const*>(_documents[_posInDocuments].getDataPtr());
+
+        inheritRegisters(_inputBlocks[match.first], res.get(), match.second, skipped);
+      }
+
+      if (_mustStoreResult) {
+        res->setShaped(skipped, _outReg, marker);
+      }
+    }
+
+    ++_posInMatches;
+    ++skipped;
+  }
+
+  if (res != nullptr) {
+    if (skipped < atMost) {
+      res->shrink(skipped);
+    }
+    result = res.release();
+  }
+
+  return TRI_ERROR_NO_ERROR;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief build the hash table
+////////////////////////////////////////////////////////////////////////////////
+
+void HashJoinBlock::buildHashTable () {
+  if (_hashCollection) {
+    freeCollectionTable();
+    _scanner->reset();
+
+    while (moreDocuments()) {
+      for (auto const& doc : _documents) {
+        auto marker = static_cast<TRI_df_marker_t const*>(doc.getDataPtr());
+        AqlValue key = documentKey(marker);
+
+        auto it = _collectionTable.find(key);
+
+        if (it != _collectionTable.end()) {
+          key.destroy();
+          (*it).second.emplace_back(marker);
+        }
+        else {
+          try {
+            _collectionTable.emplace(key, std::vector<TRI_df_marker_t const*>{ marker });
+          }
+          catch (...) {
+            key.destroy();
+            throw;
+          }
+        }
+      }
+    }
+
+    _documents.clear();
+    _posInDocuments = 0;
+  }
+  else {
+    freeInputTable();
+
+    // buffer all input rows and hash them by their keys
+    while (! _buffer.empty() || getBlock(DefaultBatchSize, DefaultBatchSize)) {
+      throwIfKilled(); // check if we were aborted
+
+      AqlItemBlock* cur = _buffer.front();
+      _buffer.pop_front();
+
+      try {
+        _inputBlocks.emplace_back(cur);
+      }
+      catch (...) {
+        delete cur;
+        throw;
+      }
+
+      size_t const index = _inputBlocks.size() - 1;
+      size_t const n = cur->size();
+
+      for (size_t i = 0; i < n; ++i) {
+        AqlValue key = inputKey(cur, i);
+
+        auto it = _inputTable.find(key);
+
+        if (it != _inputTable.end()) {
+          key.destroy();
+          (*it).second.emplace_back(std::make_pair(index, i));
+        }
+        else {
+          try {
+            _inputTable.emplace(key, std::vector<std::pair<size_t, size_t>>{ std::make_pair(index, i) });
+          }
+          catch (...) {
+            key.destroy();
+            throw;
+          }
+        }
+      }
+    }
+
+    _pos = 0;
+    _scanner->reset();
+    _documents.clear();
+    _posInDocuments = 0;
+  }
+
+  _built = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief make sure there is an unreturned match
+////////////////////////////////////////////////////////////////////////////////
+
+bool HashJoinBlock::nextMatch () {
+  if (! _built) {
+    buildHashTable();
+  }
+
+  while (_posInMatches >= _matchCount) {
+    if (! nextProbe()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief advance the probe side and look up the partners
+////////////////////////////////////////////////////////////////////////////////
+
+bool HashJoinBlock::nextProbe () {
+  _matchCount = 0;
+  _posInMatches = 0;
+
+  if (_hashCollection) {
+    if (_collectionTable.empty()) {
+      // no input row can find a partner
+      return false;
+    }
+
+    if (_probing) {
+      // all partners of the current input row have been returned
+      _probing = false;
+
+      if (++_pos >= _buffer.front()->size()) {
+        AqlItemBlock* cur = _buffer.front();
+        _buffer.pop_front();
+        returnBlock(cur);
+        _pos = 0;
+      }
+    }
+
+    if (_buffer.empty()) {
+      if (! getBlock(DefaultBatchSize, DefaultBatchSize)) {
+        return false;
+      }
+      _pos = 0;
+    }
+
+    _probing = true;
+
+    AqlValue key = inputKey(_buffer.front(), _pos);
+    
+    try {
+      auto it = _collectionTable.find(key);
+
+      if (it != _collectionTable.end()) {
+        _documentMatches = &((*it).second);
+        _matchCount = _documentMatches->size();
+      }
+    }
+    catch (...) {
+      key.destroy();
+      throw;
+    }
+
+    key.destroy();
+    return true;
+  }
+
+  // the input rows are hashed. probe with the documents of the collection
+  if (_inputTable.empty()) {
+    // no document can find a partner
+    return false;
+  }
+
+  if (_probing) {
+    _probing = false;
+    ++_posInDocuments;
+  }
+
+  if (_posInDocuments >= _documents.size()) {
+    if (! moreDocuments()) {
+      return false;
+    }
+  }
+
+  _probing = true;
+
+  AqlValue key = documentKey(static_cast<TRI_df_marker_t const*>(_documents[_posInDocuments].getDataPtr()));
+
+  try {
+    auto it = _inputTable.find(key);
+
+    if (it != _inputTable.end()) {
+      _rowMatches = &((*it).second);
+      _matchCount = _rowMatches->size();
+    }
+  }
+  catch (...) {
+    key.destroy();
+    throw;
+  }
+
+  key.destroy();
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fetch the next batch of documents from the collection
+////////////////////////////////////////////////////////////////////////////////
+
+bool HashJoinBlock::moreDocuments () {
+  throwIfKilled(); // check if we were aborted
+
+  _documents.clear();
+  _posInDocuments = 0;
+
+  int res = _scanner->scan(_documents, DefaultBatchSize);
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    THROW_ARANGO_EXCEPTION(res);
+  }
+
+  _engine->_stats.scannedFull += static_cast<int64_t>(_documents.size());
+
+  return ! _documents.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compute the join key for a document
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue HashJoinBlock::documentKey (TRI_df_marker_t const* marker) {
+  _documentBlock->setShaped(0, 0, marker);
+
+  TRI_document_collection_t const* myCollection = nullptr;
+  AqlValue a = _collectionExpression->execute(_trx, _documentBlock, 0, _collectionInVars, _collectionInRegs, &myCollection);
+
+  return normalizeKey(a, myCollection);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compute the join key for an input row
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue HashJoinBlock::inputKey (AqlItemBlock const* block,
+                                  size_t row) {
+  TRI_document_collection_t const* myCollection = nullptr;
+  AqlValue a = _inputExpression->execute(_trx, block, row, _inputInVars, _inputInRegs, &myCollection);
+
+  return normalizeKey(a, myCollection);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief turn the result of a key expression into a JSON value
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue HashJoinBlock::normalizeKey (AqlValue value,
+                                      TRI_document_collection_t const* document) {
+  if (value.isJson()) {
+    return value;
+  }
+
+  TRI_json_t* json = nullptr;
+
+  try {
+    if (value.isEmpty()) {
+      json = TRI_CreateNullJson(TRI_UNKNOWN_MEM_ZONE);
+    }
+    else {
+      json = value.toJson(_trx, document).steal();
+    }
+  }
+  catch (...) {
+    value.destroy();
+    throw;
+  }
+
+  value.destroy();
+
+  if (json == nullptr) {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, json));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief free the hash table for the collection
+////////////////////////////////////////////////////////////////////////////////
+
+void HashJoinBlock::freeCollectionTable () {
+  for (auto& it : _collectionTable) {
+    AqlValue key = it.first;
+    key.destroy();
+  }
+  _collectionTable.clear();
+  _documentMatches = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief free the hash table for the input rows and the buffered rows
+////////////////////////////////////////////////////////////////////////////////
+
+void HashJoinBlock::freeInputTable () {
+  for (auto& it : _inputTable) {
+    AqlValue key = it.first;
+    key.destroy();
+  }
+  _inputTable.clear();
+  _rowMatches = nullptr;
+
+  for (auto& it : _inputBlocks) {
+    delete it;
+  }
+  _inputBlocks.clear();
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                            class CalculationBlock
+// -----------------------------------------------------------------------------
+        
+CalculationBlock::CalculationBlock (ExecutionEngine* engine,
+                                    CalculationNode const* en)
+  : ExecutionBlock(engine, en),
+    _expression(en->expression()),
+    _inVars(),
+    _inRegs(),
+    _outReg(ExecutionNode::MaxRegisterId) {
+
+  std::unordered_set<Variable*> const& inVars = _expression->variables();
+  _inVars.reserve(inVars.size());
+  _inRegs.reserve(inVars.size());
+
+  for (auto it = inVars.begin(); it != inVars.end(); ++it) {
+    _inVars.emplace_back(*it);
+    auto it2 = en->getRegisterPlan()->varInfo.find((*it)->id);
+
+    TRI_ASSERT(it2 != en->getRegisterPlan()->varInfo.end());
+    TRI_ASSERT(it2->second.registerId < ExecutionNode::MaxRegisterId);
+    _inRegs.emplace_back(it2->second.registerId);
+  }
+
+  // check if the expression is "only" a reference to another variable
+  // this allows further optimizations inside doEvaluation
+  _isReference = (_expression->node()->type == NODE_TYPE_REFERENCE);
+
+  if (_isReference) {
+    TRI_ASSERT(_inRegs.size() == 1);
+  }
+
+  auto it3 = en->getRegisterPlan()->varInfo.find(en->_outVariable->id);
+  TRI_ASSERT(it3 != en->getRegisterPlan()->varInfo.end());
+  _outReg = it3->second.registerId;
+  TRI_ASSERT(_outReg < ExecutionNode::MaxRegisterId);
+  
+  if (en->_conditionVariable != nullptr) {
+    auto it = en->getRegisterPlan()->varInfo.find(en->_conditionVariable->id);
+    TRI_ASSERT(it != en->getRegisterPlan()->varInfo.end());
+    _conditionReg = it->second.registerId;
+    TRI_ASSERT(_conditionReg < ExecutionNode::MaxRegisterId);
+  }
+}
+
+CalculationBlock::~CalculationBlock () {
+}
+
+int CalculationBlock::initialize () {
+  return ExecutionBlock::initialize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fill the target register in the item block with a reference to 
+/// another variable
+////////////////////////////////////////////////////////////////////////////////
+
+void CalculationBlock::fillBlockWithReference (AqlItemBlock* result) {
   result->setDocumentCollection(_outReg, result->getDocumentCollection(_inRegs[0]));
 
   size_t const n = result->size();
@@ -2869,6 +3754,16 @@ void CalculationBlock::executeExpression (AqlItemBlock* result) {
 
   bool const hasCondition = (static_cast<CalculationNode const*>(_exeNode)->_conditionVariable != nullptr);
 
+  if (! hasCondition && 
+      result->isColumnar() && 
+      _expression->canExecuteVectorized()) {
+    // execute the expression for all items of the block at once. this is
+    // only done for column-major blocks (columnarBlocks query option)
+    _expression->executeVectorized(_trx, result, _inVars, _inRegs, _outReg);
+    throwIfKilled(); // check if we were aborted
+    return;
+  }
+
   size_t const n = result->size();
 
   for (size_t i = 0; i < n; i++) {
@@ -3232,20 +4127,24 @@ int FilterBlock::getOrSkipSome (size_t atLeast,
       }
       else if (_pos > 0 || _chosen.size() < cur->size()) {
         // The current block fits into our result, but it is already
-        // half-eaten or needs to be copied anyway:
+        // half-eaten or contains rows that were filtered out. we reduce
+        // it to the chosen rows in place instead of copying them:
         if (! skipping) {
-          std::unique_ptr<AqlItemBlock> more(cur->steal(_chosen, _pos, _chosen.size()));
-          
           TRI_IF_FAILURE("FilterBlock::getOrSkipSome2") {
             THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
           }
 
-          collector.emplace_back(more.get());
-          more.release();
+          // if this throws, then cur is not lost, as it is still contained
+          // in _buffer
+          collector.emplace_back(cur);
+          _buffer.pop_front();
+          cur->select(_chosen, _pos, _chosen.size());
+        }
+        else {
+          delete cur;
+          _buffer.pop_front();
         }
         skipped += _chosen.size() - _pos;
-        delete cur;
-        _buffer.pop_front();
         _chosen.clear();
         _pos = 0;
       }
@@ -3933,11 +4832,23 @@ bool HashedAggregateBlock::GroupKeyEqual::operator() (std::vector<AqlValue> cons
 // --SECTION--                                                   class SortBlock
 // -----------------------------------------------------------------------------
         
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum number of runs that are merged at once
+////////////////////////////////////////////////////////////////////////////////
+
+size_t const SortBlock::MaxMergeRuns = 64;
+
 SortBlock::SortBlock (ExecutionEngine* engine,
                       SortNode const* en)
   : ExecutionBlock(engine, en),
     _sortRegisters(),
-    _stable(en->_stable) {
+    _stable(en->_stable),
+    _runs(),
+    _mergeHeap(),
+    _nrRegs(0),
+    _collections(),
+    _sortCollections(),
+    _limit(en->_limit) {
   
   for (auto const& p : en->_elements) {
     auto it = en->getRegisterPlan()->varInfo.find(p.first->id);
@@ -3948,6 +4859,7 @@ SortBlock::SortBlock (ExecutionEngine* engine,
 }
 
 SortBlock::~SortBlock () {
+  clearRuns();
 }
 
 int SortBlock::initialize () {
@@ -3959,8 +4871,48 @@ int SortBlock::initializeCursor (AqlItemBlock* items, size_t pos) {
   if (res != TRI_ERROR_NO_ERROR) {
     return res;
   }
-  // suck all blocks into _buffer
+
+  clearRuns();
+
+  if (_limit > 0) {
+    // only the first rows are needed, which fit into memory
+    doHeapSorting();
+
+    _done = _buffer.empty();
+    _pos = 0;
+
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  size_t const memoryLimit = _engine->getQuery()->memoryLimit();
+  size_t memoryUsage = 0;
+
+  // suck all blocks into _buffer. if the buffered rows use more memory than
+  // the query allows, sort them and move them into a sorted run on disk
   while (getBlock(DefaultBatchSize, DefaultBatchSize)) {
+    if (memoryLimit > 0) {
+      memoryUsage += _buffer.back()->memoryUsage();
+
+      if (memoryUsage > memoryLimit) {
+        spillBuffer();
+        memoryUsage = 0;
+      }
+    }
+  }
+
+  if (! _runs.empty()) {
+    // external sort: spill the remainder, too, and merge all runs
+    if (! _buffer.empty()) {
+      spillBuffer();
+    }
+
+    reduceRuns();
+    startMerge(_runs, _mergeHeap);
+
+    _done = _mergeHeap.empty();
+    _pos = 0;
+
+    return TRI_ERROR_NO_ERROR;
   }
 
   if (_buffer.empty()) {
@@ -3976,10 +4928,82 @@ int SortBlock::initializeCursor (AqlItemBlock* items, size_t pos) {
   return TRI_ERROR_NO_ERROR;
 }
 
-void SortBlock::doSorting () {
-  // coords[i][j] is the <j>th row of the <i>th block
-  std::vector<std::pair<size_t, size_t>> coords;
+int SortBlock::shutdown (int errorCode) {
+  clearRuns();
+
+  return ExecutionBlock::shutdown(errorCode);
+}
+
+int SortBlock::getOrSkipSome (size_t atLeast,
+                              size_t atMost,
+                              bool skipping,
+                              AqlItemBlock*& result,
+                              size_t& skipped) {
+  if (_runs.empty()) {
+    return ExecutionBlock::getOrSkipSome(atLeast, atMost, skipping, result, skipped);
+  }
+
+  TRI_ASSERT(result == nullptr && skipped == 0);
+
+  if (_done) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  throwIfKilled(); // check if we were aborted
+
+  if (skipping) {
+    while (skipped < atMost && ! _mergeHeap.empty()) {
+      popMerge(_runs, _mergeHeap);
+      advanceMerge(_runs, _mergeHeap);
+      ++skipped;
+    }
+  }
+  else {
+    size_t const toReturn = (std::min)(atMost, mergeRemaining());
+
+    if (toReturn > 0) {
+      std::unique_ptr<AqlItemBlock> res(new AqlItemBlock(toReturn, _nrRegs));
+
+      for (RegisterId i = 0; i < _nrRegs; ++i) {
+        res->setDocumentCollection(i, _collections[i]);
+      }
+
+      while (skipped < toReturn) {
+        size_t const run = popMerge(_runs, _mergeHeap);
+        _runs[run]->moveHead(res.get(), skipped);
+        advanceMerge(_runs, _mergeHeap);
+        ++skipped;
+      }
+
+      result = res.release();
+    }
+  }
+
+  if (_mergeHeap.empty()) {
+    _done = true;
+  }
+
+  return TRI_ERROR_NO_ERROR;
+}
+
+bool SortBlock::hasMore () {
+  if (_runs.empty()) {
+    return ExecutionBlock::hasMore();
+  }
+
+  return (! _done && ! _mergeHeap.empty());
+}
+
+int64_t SortBlock::remaining () {
+  if (_runs.empty()) {
+    return ExecutionBlock::remaining();
+  }
+
+  return static_cast<int64_t>(mergeRemaining());
+}
 
+void SortBlock::sortCoordinates (std::vector<std::pair<size_t, size_t>>& coords) {
+  // coords[i][j] is the <j>th row of the <i>th block
   size_t sum = 0;
   for (auto const& block : _buffer) {
     sum += block->size();
@@ -4015,6 +5039,95 @@ void SortBlock::doSorting () {
   else {
     std::sort(coords.begin(), coords.end(), ourLessThan);
   }
+}
+
+void SortBlock::doSorting () {
+  std::vector<std::pair<size_t, size_t>> coords;
+  sortCoordinates(coords);
+  rearrangeRows(coords);
+}
+
+void SortBlock::doHeapSorting () {
+  TRI_ASSERT(_limit > 0);
+
+  std::vector<std::pair<size_t, size_t>> heap;
+  std::vector<TRI_document_collection_t const*> colls;
+  OurLessThan ourLessThan(_trx, _buffer, _sortRegisters, colls);
+
+  // equal rows are ordered by their position in _buffer, so the heap keeps
+  // the rows that were read first, as a stable sort would
+  auto heapLessThan = [&ourLessThan] (std::pair<size_t, size_t> const& a,
+                                      std::pair<size_t, size_t> const& b) -> bool {
+    int cmp = ourLessThan.compare(a, b);
+    return (cmp < 0 || (cmp == 0 && a < b));
+  };
+
+  // rows that were pushed out of the heap are still referenced by their
+  // blocks. the blocks are compacted once they hold too many of these rows
+  size_t const maxBufferedRows = (std::max)(2 * _limit, DefaultBatchSize);
+  size_t bufferedRows = 0;
+
+  heap.reserve((std::min)(_limit, maxBufferedRows));
+
+  while (getBlock(DefaultBatchSize, DefaultBatchSize)) {
+    if (colls.empty()) {
+      for (auto const& reg : _sortRegisters) {
+        colls.emplace_back(_buffer.front()->getDocumentCollection(reg.first));
+      }
+    }
+
+    size_t const blockIndex = _buffer.size() - 1;
+    size_t const n = _buffer.back()->size();
+
+    for (size_t i = 0; i < n; ++i) {
+      auto const coord = std::make_pair(blockIndex, i);
+
+      if (heap.size() < _limit) {
+        heap.emplace_back(coord);
+        std::push_heap(heap.begin(), heap.end(), heapLessThan);
+      }
+      else if (heapLessThan(coord, heap.front())) {
+        // the new row replaces the last row in the heap
+        std::pop_heap(heap.begin(), heap.end(), heapLessThan);
+        heap.back() = coord;
+        std::push_heap(heap.begin(), heap.end(), heapLessThan);
+      }
+    }
+
+    bufferedRows += n;
+
+    if (bufferedRows > maxBufferedRows) {
+      // free all rows that are no longer in the heap
+      std::sort_heap(heap.begin(), heap.end(), heapLessThan);
+      rearrangeRows(heap);
+
+      heap.clear();
+      for (size_t j = 0; j < _buffer.size(); ++j) {
+        for (size_t i = 0; i < _buffer[j]->size(); ++i) {
+          heap.emplace_back(std::make_pair(j, i));
+        }
+      }
+      std::make_heap(heap.begin(), heap.end(), heapLessThan);
+
+      bufferedRows = heap.size();
+    }
+  }
+
+  if (_buffer.empty()) {
+    return;
+  }
+
+  std::sort_heap(heap.begin(), heap.end(), heapLessThan);
+  rearrangeRows(heap);
+}
+
+void SortBlock::rearrangeRows (std::vector<std::pair<size_t, size_t>> const& coords) {
+  if (_buffer.empty()) {
+    return;
+  }
+
+  size_t const sum = coords.size();
+  size_t count = 0;
 
   // here we collect the new blocks (later swapped into _buffer):
   std::deque<AqlItemBlock*> newbuffer;
@@ -4022,7 +5135,6 @@ void SortBlock::doSorting () {
   try {  // If we throw from here, the catch will delete the new
     // blocks in newbuffer
 
-    count = 0;
     RegisterId const nrregs = _buffer.front()->getNrRegs();
 
     // install the rearranged values from _buffer into newbuffer
@@ -4144,12 +5256,135 @@ void SortBlock::doSorting () {
   }
 }
 
+void SortBlock::spillBuffer () {
+  TRI_ASSERT(! _buffer.empty());
+
+  if (_collections.empty()) {
+    // all blocks have the same registers, so the first spilled block
+    // determines the layout of all runs
+    AqlItemBlock const* first = _buffer.front();
+    _nrRegs = first->getNrRegs();
+
+    for (RegisterId i = 0; i < _nrRegs; ++i) {
+      _collections.emplace_back(first->getDocumentCollection(i));
+    }
+    for (auto const& reg : _sortRegisters) {
+      _sortCollections.emplace_back(first->getDocumentCollection(reg.first));
+    }
+  }
+
+  std::vector<std::pair<size_t, size_t>> coords;
+  sortCoordinates(coords);
+
+  std::unique_ptr<SortedRun> run(new SortedRun(_trx, _nrRegs, _collections));
+
+  for (auto const& c : coords) {
+    run->add(_buffer[c.first], c.second);
+  }
+  run->finish();
+
+  _runs.emplace_back(run.get());
+  run.release();
+
+  for (auto& x : _buffer) {
+    delete x;
+  }
+  _buffer.clear();
+}
+
+void SortBlock::reduceRuns () {
+  while (_runs.size() > MaxMergeRuns) {
+    // merge the oldest runs into one, so the result keeps the input order
+    std::vector<SortedRun*> group(_runs.begin(), _runs.begin() + MaxMergeRuns);
+    std::unique_ptr<SortedRun> merged(new SortedRun(_trx, _nrRegs, _collections));
+    std::vector<size_t> heap;
+
+    startMerge(group, heap);
+
+    while (! heap.empty()) {
+      throwIfKilled(); // check if we were aborted
+
+      size_t const run = popMerge(group, heap);
+      merged->add(group[run]->head(), 0);
+      advanceMerge(group, heap);
+    }
+    merged->finish();
+
+    for (auto& x : group) {
+      delete x;
+    }
+    _runs.erase(_runs.begin(), _runs.begin() + MaxMergeRuns);
+    _runs.insert(_runs.begin(), merged.get());
+    merged.release();
+  }
+}
+
+void SortBlock::startMerge (std::vector<SortedRun*>& runs,
+                            std::vector<size_t>& heap) {
+  heap.clear();
+  heap.reserve(runs.size());
+
+  for (size_t i = 0; i < runs.size(); ++i) {
+    if (runs[i]->next()) {
+      heap.emplace_back(i);
+    }
+  }
+
+  OurRunGreaterThan ourRunGreaterThan(_trx, runs, _sortRegisters, _sortCollections);
+  std::make_heap(heap.begin(), heap.end(), ourRunGreaterThan);
+}
+
+size_t SortBlock::popMerge (std::vector<SortedRun*>& runs,
+                            std::vector<size_t>& heap) {
+  TRI_ASSERT(! heap.empty());
+
+  OurRunGreaterThan ourRunGreaterThan(_trx, runs, _sortRegisters, _sortCollections);
+  std::pop_heap(heap.begin(), heap.end(), ourRunGreaterThan);
+
+  return heap.back();
+}
+
+void SortBlock::advanceMerge (std::vector<SortedRun*>& runs,
+                              std::vector<size_t>& heap) {
+  TRI_ASSERT(! heap.empty());
+
+  if (runs[heap.back()]->next()) {
+    OurRunGreaterThan ourRunGreaterThan(_trx, runs, _sortRegisters, _sortCollections);
+    std::push_heap(heap.begin(), heap.end(), ourRunGreaterThan);
+  }
+  else {
+    heap.pop_back();
+  }
+}
+
+size_t SortBlock::mergeRemaining () const {
+  // each run in the heap has read its current row already
+  size_t sum = _mergeHeap.size();
+
+  for (auto const& run : _runs) {
+    sum += run->remaining();
+  }
+
+  return sum;
+}
+
+void SortBlock::clearRuns () {
+  for (auto& x : _runs) {
+    delete x;
+  }
+  _runs.clear();
+  _mergeHeap.clear();
+  _collections.clear();
+  _sortCollections.clear();
+  _nrRegs = 0;
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                      class SortBlock::OurLessThan
 // -----------------------------------------------------------------------------
 
-bool SortBlock::OurLessThan::operator() (std::pair<size_t, size_t> const& a,
-                                         std::pair<size_t, size_t> const& b) {
+int SortBlock::OurLessThan::compare (std::pair<size_t, size_t> const& a,
+                                     std::pair<size_t, size_t> const& b) {
 
   size_t i = 0;
   for (auto const& reg : _sortRegisters) {
@@ -4163,16 +5398,48 @@ bool SortBlock::OurLessThan::operator() (std::pair<size_t, size_t> const& a,
       true
     );
     
+    if (cmp != 0) {
+      return (reg.second ? cmp : -cmp);
+    }
+    i++;
+  }
+
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                class SortBlock::OurRunGreaterThan
+// -----------------------------------------------------------------------------
+
+bool SortBlock::OurRunGreaterThan::operator() (size_t a,
+                                               size_t b) {
+
+  AqlItemBlock const* left = _runs[a]->head();
+  AqlItemBlock const* right = _runs[b]->head();
+
+  size_t i = 0;
+  for (auto const& reg : _sortRegisters) {
+
+    int cmp = AqlValue::Compare(
+      _trx,
+      left->getValueReference(0, reg.first),
+      _colls[i],
+      right->getValueReference(0, reg.first),
+      _colls[i],
+      true
+    );
+    
     if (cmp < 0) {
-      return reg.second;
+      return ! reg.second;
     } 
     else if (cmp > 0) {
-      return ! reg.second;
+      return reg.second;
     }
     i++;
   }
 
-  return false;
+  // equal rows: the run that was written later goes last
+  return a > b;
 }
 
 // -----------------------------------------------------------------------------
@@ -34,6 +34,7 @@
 #include "Aql/CollectionScanner.h"
 #include "Aql/ExecutionNode.h"
 #include "Aql/Range.h"
+#include "Aql/SortedRun.h"
 #include "Aql/WalkerWorker.h"
 #include "Aql/ExecutionStats.h"
 #include "Basics/StringBuffer.h"
@@ -528,12 +529,50 @@ namespace triagens {
 
         size_t skipSome (size_t atLeast, size_t atMost) override final;
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up the per-thread copies of the filter calculations
+////////////////////////////////////////////////////////////////////////////////
+
+        void initializeFilter ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove all documents that do not match the filter. the documents
+/// are split into ranges which are filtered by the threads of the shared scan
+/// pool and the calling thread, and the matching documents of all ranges are gathered in their original order
+////////////////////////////////////////////////////////////////////////////////
+
+        void filterDocuments (std::vector<TRI_doc_mptr_copy_t>&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief evaluate the filter for a range of documents, using the
+/// calculations of the specified range
+////////////////////////////////////////////////////////////////////////////////
+
+        void filterRange (size_t,
+                          std::vector<TRI_doc_mptr_copy_t> const&,
+                          size_t,
+                          size_t,
+                          TRI_document_collection_t const*,
+                          std::vector<char>&);
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
 // -----------------------------------------------------------------------------
 
       private:
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief minimum number of documents in a filter range
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t const MinDocumentsPerRange = 256;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief collection
 ////////////////////////////////////////////////////////////////////////////////
@@ -569,6 +608,30 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         bool _mustStoreResult;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief filter calculations, one copy per thread
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<std::vector<Expression*>> _filterExpressions;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief input variables of each filter calculation
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<std::vector<Variable*>> _filterInVars;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief input registers of each filter calculation
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<std::vector<RegisterId>> _filterInRegs;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief register of the filter variable in the filter blocks
+////////////////////////////////////////////////////////////////////////////////
+
+        RegisterId _filterRegister;
     };
 
 // -----------------------------------------------------------------------------
@@ -663,6 +726,20 @@ namespace triagens {
 
         void destroyHashIndexSearchValues ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy a hash index search value
+////////////////////////////////////////////////////////////////////////////////
+
+        void destroyHashIndexSearchValue (TRI_index_search_value_t&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief look up the hash index for all rows of the current input block
+/// at once. rows with more than one OR condition are left for the regular
+/// per-row lookup
+////////////////////////////////////////////////////////////////////////////////
+
+        void batchHashIndexLookups ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief set up a hash index search value
 ////////////////////////////////////////////////////////////////////////////////
@@ -833,6 +910,37 @@ namespace triagens {
 
         struct TRI_hash_index_element_multi_s* _hashNextElement;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief rows of the current input block whose hash index lookup was done
+/// by batchHashIndexLookups
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<bool> _hashBatched;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief first matching document for each batched row, or nullptr
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<TRI_doc_mptr_t*> _hashBatchDocuments;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief iterator state for the remaining documents of each batched row
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<struct TRI_hash_index_element_multi_s*> _hashBatchNext;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the current row is read from the batched lookup results
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _hashBatchRow;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief first document of the current batched row, if not yet returned
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_doc_mptr_t* _hashBatchDocument;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief reentrant edge index iterator state
 ////////////////////////////////////////////////////////////////////////////////
@@ -967,6 +1075,257 @@ namespace triagens {
 
     };
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                     HashJoinBlock
+// -----------------------------------------------------------------------------
+
+    class HashJoinBlock : public ExecutionBlock {
+
+      public:
+
+        HashJoinBlock (ExecutionEngine*,
+                       HashJoinNode const*);
+
+        ~HashJoinBlock ();
+
+        int initialize () override;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief initializeCursor, this drops the hash table if it was built for the
+/// input rows. a hash table for the collection is kept
+////////////////////////////////////////////////////////////////////////////////
+
+        int initializeCursor (AqlItemBlock* items, size_t pos) override;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief shutdown, free the hash tables
+////////////////////////////////////////////////////////////////////////////////
+
+        int shutdown (int) override;
+
+        bool hasMore () override final;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+      private:
+
+        int getOrSkipSome (size_t atLeast,
+                           size_t atMost,
+                           bool skipping,
+                           AqlItemBlock*& result,
+                           size_t& skipped) override;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief build the hash table for the side chosen by the optimizer
+////////////////////////////////////////////////////////////////////////////////
+
+        void buildHashTable ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief make sure there is an unreturned match. returns false if there are
+/// no more matches
+////////////////////////////////////////////////////////////////////////////////
+
+        bool nextMatch ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief advance to the next input row (when hashing the collection) or to
+/// the next document (when hashing the input) and look up its partners.
+/// returns false if the probe side is exhausted
+////////////////////////////////////////////////////////////////////////////////
+
+        bool nextProbe ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fetch the next batch of documents from the collection. returns
+/// false if the collection is exhausted
+////////////////////////////////////////////////////////////////////////////////
+
+        bool moreDocuments ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compute the join key for a document
+////////////////////////////////////////////////////////////////////////////////
+
+        AqlValue documentKey (TRI_df_marker_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compute the join key for an input row
+////////////////////////////////////////////////////////////////////////////////
+
+        AqlValue inputKey (AqlItemBlock const*,
+                           size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief turn the result of a key expression into a JSON value, so keys from
+/// both sides can be hashed and compared without their collections
+////////////////////////////////////////////////////////////////////////////////
+
+        AqlValue normalizeKey (AqlValue,
+                               TRI_document_collection_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief free the hash tables and the buffered input rows
+////////////////////////////////////////////////////////////////////////////////
+
+        void freeCollectionTable ();
+
+        void freeInputTable ();
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hasher for join keys
+////////////////////////////////////////////////////////////////////////////////
+
+        struct KeyHash {
+          explicit KeyHash (triagens::arango::AqlTransaction* trx)
+            : _trx(trx) {
+          }
+
+          size_t operator() (AqlValue const& value) const {
+            return static_cast<size_t>(value.hash(_trx, nullptr));
+          }
+
+          triagens::arango::AqlTransaction* _trx;
+        };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief comparator for join keys, using the semantics of the == operator
+////////////////////////////////////////////////////////////////////////////////
+
+        struct KeyEqual {
+          explicit KeyEqual (triagens::arango::AqlTransaction* trx)
+            : _trx(trx) {
+          }
+
+          bool operator() (AqlValue const& lhs,
+                           AqlValue const& rhs) const {
+            return AqlValue::Compare(_trx, lhs, nullptr, rhs, nullptr, false) == 0;
+          }
+
+          triagens::arango::AqlTransaction* _trx;
+        };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief collection
+////////////////////////////////////////////////////////////////////////////////
+
+        Collection* _collection;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief collection scanner
+////////////////////////////////////////////////////////////////////////////////
+
+        CollectionScanner* _scanner;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the documents of the current scan batch
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<TRI_doc_mptr_copy_t> _documents;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief current position in _documents
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _posInDocuments;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the hash table is built for the collection
+////////////////////////////////////////////////////////////////////////////////
+
+        bool const _hashCollection;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the hash table for the current cursor has been built
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _built;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the probe side is positioned on a row or document
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _probing;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the joined documents need to be stored
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _mustStoreResult;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the output register
+////////////////////////////////////////////////////////////////////////////////
+
+        RegisterId _outReg;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief key expression for documents, its variable and register. documents
+/// are put into register 0 of _documentBlock for evaluating it
+////////////////////////////////////////////////////////////////////////////////
+
+        Expression* _collectionExpression;
+
+        std::vector<Variable*> _collectionInVars;
+
+        std::vector<RegisterId> _collectionInRegs;
+
+        AqlItemBlock* _documentBlock;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief key expression for input rows, its variables and registers
+////////////////////////////////////////////////////////////////////////////////
+
+        Expression* _inputExpression;
+
+        std::vector<Variable*> _inputInVars;
+
+        std::vector<RegisterId> _inputInRegs;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hash table for the documents of the collection
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<AqlValue, std::vector<TRI_df_marker_t const*>, KeyHash, KeyEqual> _collectionTable;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hash table for the input rows, pointing into _inputBlocks
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<AqlValue, std::vector<std::pair<size_t, size_t>>, KeyHash, KeyEqual> _inputTable;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the buffered input rows, when hashing the input
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<AqlItemBlock*> _inputBlocks;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief partners of the current probe row or document
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<TRI_df_marker_t const*> const* _documentMatches;
+
+        std::vector<std::pair<size_t, size_t>> const* _rowMatches;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of partners of the current probe row or document, and the
+/// position of the next one to return
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _matchCount;
+
+        size_t _posInMatches;
+    };
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                  CalculationBlock
 // -----------------------------------------------------------------------------
@@ -1351,6 +1710,31 @@ namespace triagens {
 
         virtual int initializeCursor (AqlItemBlock* items, size_t pos);
 
+        int shutdown (int) override;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief getOrSkipSome, merges the sorted runs if the input was spilled to
+/// disk and uses the default implementation otherwise
+////////////////////////////////////////////////////////////////////////////////
+
+        int getOrSkipSome (size_t atLeast,
+                           size_t atMost,
+                           bool skipping,
+                           AqlItemBlock*& result,
+                           size_t& skipped) override;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hasMore
+////////////////////////////////////////////////////////////////////////////////
+
+        bool hasMore () override;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remaining
+////////////////////////////////////////////////////////////////////////////////
+
+        int64_t remaining () override;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief dosorting
 ////////////////////////////////////////////////////////////////////////////////
@@ -1359,6 +1743,74 @@ namespace triagens {
 
         void doSorting ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read all input and keep only the first _limit rows in sort order,
+/// using a bounded heap. _buffer contains these rows in order afterwards
+////////////////////////////////////////////////////////////////////////////////
+
+        void doHeapSorting ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sort the coordinates of all rows in _buffer
+////////////////////////////////////////////////////////////////////////////////
+
+        void sortCoordinates (std::vector<std::pair<size_t, size_t>>&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief replace the blocks in _buffer with new blocks that contain only
+/// the given rows, in the given order
+////////////////////////////////////////////////////////////////////////////////
+
+        void rearrangeRows (std::vector<std::pair<size_t, size_t>> const&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sort the rows in _buffer and write them to a new sorted run on
+/// disk. _buffer is empty afterwards
+////////////////////////////////////////////////////////////////////////////////
+
+        void spillBuffer ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief merge groups of sorted runs until at most MaxMergeRuns are left
+////////////////////////////////////////////////////////////////////////////////
+
+        void reduceRuns ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read the first row of each run and set up the merge heap
+////////////////////////////////////////////////////////////////////////////////
+
+        void startMerge (std::vector<SortedRun*>&,
+                         std::vector<size_t>&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief move the run with the smallest current row to the back of the
+/// merge heap and return its index
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t popMerge (std::vector<SortedRun*>&,
+                         std::vector<size_t>&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief advance the run at the back of the merge heap, and put it back
+/// into the heap unless it is exhausted
+////////////////////////////////////////////////////////////////////////////////
+
+        void advanceMerge (std::vector<SortedRun*>&,
+                           std::vector<size_t>&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of rows that are left in the merge
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t mergeRemaining () const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief delete all sorted runs
+////////////////////////////////////////////////////////////////////////////////
+
+        void clearRuns ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief OurLessThan
 ////////////////////////////////////////////////////////////////////////////////
@@ -1377,7 +1829,18 @@ namespace triagens {
             }
 
             bool operator() (std::pair<size_t, size_t> const& a,
-                             std::pair<size_t, size_t> const& b);
+                             std::pair<size_t, size_t> const& b) {
+              return compare(a, b) < 0;
+            }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compare two rows, taking the sort directions into account.
+/// returns a negative value if a sorts before b, a positive value if a sorts
+/// after b, and 0 if they are equal
+////////////////////////////////////////////////////////////////////////////////
+
+            int compare (std::pair<size_t, size_t> const& a,
+                         std::pair<size_t, size_t> const& b);
 
           private:
             triagens::arango::AqlTransaction* _trx;
@@ -1386,6 +1849,35 @@ namespace triagens {
             std::vector<TRI_document_collection_t const*>& _colls;
         };
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief OurRunGreaterThan, heap order for merging sorted runs. a run is
+/// greater than another if its current row sorts after the other's. ties
+/// are broken by the run index, so the merge preserves the input order
+////////////////////////////////////////////////////////////////////////////////
+
+        class OurRunGreaterThan {
+
+          public:
+            OurRunGreaterThan (triagens::arango::AqlTransaction* trx,
+                               std::vector<SortedRun*>& runs,
+                               std::vector<std::pair<RegisterId, bool>>& sortRegisters,
+                               std::vector<TRI_document_collection_t const*>& colls)
+              : _trx(trx),
+                _runs(runs),
+                _sortRegisters(sortRegisters),
+                _colls(colls) {
+            }
+
+            bool operator() (size_t a,
+                             size_t b);
+
+          private:
+            triagens::arango::AqlTransaction* _trx;
+            std::vector<SortedRun*>& _runs;
+            std::vector<std::pair<RegisterId, bool>>& _sortRegisters;
+            std::vector<TRI_document_collection_t const*>& _colls;
+        };
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief pairs, consisting of variable and sort direction
 /// (true = ascending | false = descending)
@@ -1399,6 +1891,49 @@ namespace triagens {
 
         bool _stable;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sorted runs that were spilled to disk, in input order
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<SortedRun*> _runs;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief heap of the indexes of all runs that still have rows
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<size_t> _mergeHeap;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of registers of the spilled rows
+////////////////////////////////////////////////////////////////////////////////
+
+        RegisterId _nrRegs;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief document collections of all registers of the spilled rows
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<TRI_document_collection_t const*> _collections;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief document collections of the sort registers of the spilled rows
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<TRI_document_collection_t const*> _sortCollections;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum number of rows to produce, 0 means all rows. if set, the
+/// sort keeps only the first rows in a bounded heap
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _limit;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum number of runs that are merged at once
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t const MaxMergeRuns;
+
     };
 
 // -----------------------------------------------------------------------------
@@ -64,6 +64,10 @@ static ExecutionBlock* CreateBlock (ExecutionEngine* engine,
       return new EnumerateListBlock(engine,
                                     static_cast<EnumerateListNode const*>(en));
     }
+    case ExecutionNode::HASH_JOIN: {
+      return new HashJoinBlock(engine,
+                               static_cast<HashJoinNode const*>(en));
+    }
     case ExecutionNode::CALCULATION: {
       return new CalculationBlock(engine,
                                   static_cast<CalculationNode const*>(en));
@@ -184,6 +188,10 @@ ExecutionEngine::ExecutionEngine (Query* query)
     _lockedShards(nullptr) {
 
   _blocks.reserve(8);
+
+  if (_query != nullptr) {
+    _itemBlockManager.columnar(_query->columnarBlocks());
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -75,7 +75,8 @@ std::unordered_map<int, std::string const> const ExecutionNode::TypeNames{
   { static_cast<int>(DISTRIBUTE),                   "DistributeNode" },
   { static_cast<int>(GATHER),                       "GatherNode" },
   { static_cast<int>(NORESULTS),                    "NoResultsNode" },
-  { static_cast<int>(UPSERT),                       "UpsertNode" }
+  { static_cast<int>(UPSERT),                       "UpsertNode" },
+  { static_cast<int>(HASH_JOIN),                    "HashJoinNode" }
 };
           
 // -----------------------------------------------------------------------------
@@ -221,6 +222,8 @@ ExecutionNode* ExecutionNode::fromJsonFactory (ExecutionPlan* plan,
       return new ScatterNode(plan, oneNode);
     case DISTRIBUTE: 
       return new DistributeNode(plan, oneNode);
+    case HASH_JOIN:
+      return new HashJoinNode(plan, oneNode);
     case ILLEGAL: {
       THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid node type");
     }
@@ -910,6 +913,22 @@ void ExecutionNode::RegisterPlan::after (ExecutionNode *en) {
       break;
     }
 
+    case ExecutionNode::HASH_JOIN: {
+      depth++;
+      nrRegsHere.emplace_back(1);
+      // create a copy of the last value here
+      // this is requried because back returns a reference and emplace/push_back may invalidate all references
+      RegisterId registerId = 1 + nrRegs.back();
+      nrRegs.emplace_back(registerId);
+
+      auto ep = static_cast<HashJoinNode const*>(en);
+      TRI_ASSERT(ep != nullptr);
+      varInfo.emplace(make_pair(ep->_outVariable->id,
+                               VarInfo(depth, totalNrRegs)));
+      totalNrRegs++;
+      break;
+    }
+
     case ExecutionNode::CALCULATION: {
       nrRegsHere[depth]++;
       nrRegs[depth]++;
@@ -1170,7 +1189,24 @@ EnumerateCollectionNode::EnumerateCollectionNode (ExecutionPlan* plan,
     _vocbase(plan->getAst()->query()->vocbase()),
     _collection(plan->getAst()->query()->collections()->get(JsonHelper::checkAndGetStringValue(base.json(), "collection"))),
     _outVariable(varFromJson(plan->getAst(), base, "outVariable")),
-    _random(JsonHelper::checkAndGetBooleanValue(base.json(), "random")) {
+    _random(JsonHelper::checkAndGetBooleanValue(base.json(), "random")),
+    _filterCalculations(),
+    _filterVariable(varFromJson(plan->getAst(), base, "filterVariable", true)),
+    _parallelism(JsonHelper::getNumericValue<size_t>(base.json(), "parallelism", 1)) {
+
+  triagens::basics::Json calculations = base.get("filterCalculations");
+
+  if (calculations.isArray()) {
+    size_t const n = calculations.size();
+    _filterCalculations.reserve(n);
+
+    for (size_t i = 0; i < n; ++i) {
+      triagens::basics::Json calculation = calculations.at(i);
+
+      _filterCalculations.emplace_back(std::make_pair(varFromJson(plan->getAst(), calculation, "outVariable"), 
+                                                      new Expression(plan->getAst(), calculation)));
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1192,6 +1228,20 @@ void EnumerateCollectionNode::toJsonHelper (triagens::basics::Json& nodes,
       ("outVariable", _outVariable->toJson())
       ("random", triagens::basics::Json(_random));
 
+  if (_filterVariable != nullptr) {
+    triagens::basics::Json calculations(triagens::basics::Json::Array, _filterCalculations.size());
+
+    for (auto const& it : _filterCalculations) {
+      calculations(triagens::basics::Json(triagens::basics::Json::Object)
+                   ("expression", it.second->toJson(TRI_UNKNOWN_MEM_ZONE, verbose))
+                   ("outVariable", it.first->toJson()));
+    }
+
+    json("filterCalculations", calculations)
+        ("filterVariable", _filterVariable->toJson())
+        ("parallelism", triagens::basics::Json(static_cast<double>(_parallelism)));
+  }
+
   // And add it:
   nodes(json);
 }
@@ -1211,6 +1261,26 @@ ExecutionNode* EnumerateCollectionNode::clone (ExecutionPlan* plan,
     
   auto c = new EnumerateCollectionNode(plan, _id, _vocbase, _collection, outVariable, _random);
 
+  if (_filterVariable != nullptr) {
+    std::vector<std::pair<Variable const*, Expression*>> calculations;
+    calculations.reserve(_filterCalculations.size());
+
+    try {
+      for (auto const& it : _filterCalculations) {
+        calculations.emplace_back(std::make_pair(it.first, it.second->clone()));
+      }
+    }
+    catch (...) {
+      for (auto& it : calculations) {
+        delete it.second;
+      }
+      delete c;
+      throw;
+    }
+
+    c->setParallelFilter(calculations, _filterVariable, _parallelism);
+  }
+
   CloneHelper(c, plan, withDependencies, withProperties);
 
   return static_cast<ExecutionNode*>(c);
@@ -1347,7 +1417,120 @@ double EnumerateCollectionNode::estimateCost (size_t& nrItems) const {
   nrItems = incoming * count;
   // We do a full collection scan for each incoming item.
   // random iteration is slightly more expensive than linear iteration
-  return depCost + nrItems * (_random ? 1.005 : 1.0);
+  double cost = depCost + nrItems * (_random ? 1.005 : 1.0);
+
+  if (_filterVariable != nullptr) {
+    // the calculations and the filter are spread over multiple threads
+    cost += static_cast<double>(nrItems) * (_filterCalculations.size() + 1) / _parallelism;
+  }
+
+  return cost;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                           methods of HashJoinNode
+// -----------------------------------------------------------------------------
+
+HashJoinNode::HashJoinNode (ExecutionPlan* plan,
+                            triagens::basics::Json const& base)
+  : ExecutionNode(plan, base),
+    _vocbase(plan->getAst()->query()->vocbase()),
+    _collection(plan->getAst()->query()->collections()->get(JsonHelper::checkAndGetStringValue(base.json(), "collection"))),
+    _outVariable(varFromJson(plan->getAst(), base, "outVariable")),
+    _collectionExpression(nullptr),
+    _inputExpression(nullptr),
+    _hashCollection(JsonHelper::checkAndGetBooleanValue(base.json(), "hashCollection")) {
+
+  _collectionExpression = new Expression(plan->getAst(), new AstNode(plan->getAst(), base.get("collectionExpression")));
+
+  try {
+    _inputExpression = new Expression(plan->getAst(), new AstNode(plan->getAst(), base.get("inputExpression")));
+  }
+  catch (...) {
+    delete _collectionExpression;
+    throw;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief toJson, for HashJoinNode
+////////////////////////////////////////////////////////////////////////////////
+
+void HashJoinNode::toJsonHelper (triagens::basics::Json& nodes,
+                                 TRI_memory_zone_t* zone,
+                                 bool verbose) const {
+  triagens::basics::Json json(ExecutionNode::toJsonHelperGeneric(nodes, zone, verbose));  // call base class method
+
+  if (json.isEmpty()) {
+    return;
+  }
+
+  json("database", triagens::basics::Json(_vocbase->_name))
+      ("collection", triagens::basics::Json(_collection->getName()))
+      ("outVariable", _outVariable->toJson())
+      ("collectionExpression", _collectionExpression->toJson(TRI_UNKNOWN_MEM_ZONE, verbose))
+      ("inputExpression", _inputExpression->toJson(TRI_UNKNOWN_MEM_ZONE, verbose))
+      ("hashCollection", triagens::basics::Json(_hashCollection));
+
+  // And add it:
+  nodes(json);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief clone ExecutionNode recursively
+////////////////////////////////////////////////////////////////////////////////
+
+ExecutionNode* HashJoinNode::clone (ExecutionPlan* plan,
+                                    bool withDependencies,
+                                    bool withProperties) const {
+  auto outVariable = _outVariable;
+  if (withProperties) {
+    outVariable = plan->getAst()->variables()->createVariable(outVariable);
+    TRI_ASSERT(outVariable != nullptr);
+  }
+
+  std::unique_ptr<Expression> collectionExpression(_collectionExpression->clone());
+  std::unique_ptr<Expression> inputExpression(_inputExpression->clone());
+
+  auto c = new HashJoinNode(plan, _id, _vocbase, _collection, outVariable, 
+                            collectionExpression.get(), inputExpression.get(), _hashCollection);
+  collectionExpression.release();
+  inputExpression.release();
+
+  CloneHelper(c, plan, withDependencies, withProperties);
+
+  return static_cast<ExecutionNode*>(c);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the cost of a hash join node is the cost of building the hash table
+/// for one side plus the cost of probing it with the other side
+////////////////////////////////////////////////////////////////////////////////
+
+double HashJoinNode::estimateCost (size_t& nrItems) const {
+  size_t incoming;
+  double depCost = _dependencies.at(0)->getCost(incoming);
+  size_t count = _collection->count();
+
+  // the result size cannot be known in advance. assume that each row of
+  // the larger side finds a single partner
+  nrItems = (std::max)(incoming, count);
+
+  // inserting into the hash table is more expensive than probing it.
+  // the collection is scanned once in any case
+  double build;
+  double probe;
+
+  if (_hashCollection) {
+    build = static_cast<double>(count) * 1.5;
+    probe = static_cast<double>(incoming);
+  }
+  else {
+    build = static_cast<double>(incoming) * 1.5;
+    probe = static_cast<double>(count);
+  }
+
+  return depCost + build + probe + static_cast<double>(nrItems);
 }
 
 // -----------------------------------------------------------------------------
@@ -2135,7 +2318,8 @@ SortNode::SortNode (ExecutionPlan* plan,
                     bool stable)
   : ExecutionNode(plan, base),
     _elements(elements),
-    _stable(stable) {
+    _stable(stable),
+    _limit(JsonHelper::getNumericValue<size_t>(base.json(), "limit", 0)) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -2160,6 +2344,10 @@ void SortNode::toJsonHelper (triagens::basics::Json& nodes,
   json("elements", values);
   json("stable", triagens::basics::Json(_stable));
 
+  if (_limit > 0) {
+    json("limit", triagens::basics::Json(static_cast<double>(_limit)));
+  }
+
   // And add it:
   nodes(json);
 }
@@ -2296,6 +2484,10 @@ double SortNode::estimateCost (size_t& nrItems) const {
   if (nrItems <= 3.0) {
     return depCost + nrItems;
   }
+  if (_limit > 0 && _limit < nrItems) {
+    // bounded heap with _limit entries
+    return depCost + nrItems * (std::max)(log(static_cast<double>(_limit)), 1.0);
+  }
   return depCost + nrItems * log(nrItems);
 }
 
@@ -2441,6 +2633,7 @@ struct UserVarFinder : public WalkerWorker<ExecutionNode> {
     else if (en->getType() == ExecutionNode::ENUMERATE_COLLECTION ||
              en->getType() == ExecutionNode::INDEX_RANGE ||
              en->getType() == ExecutionNode::ENUMERATE_LIST ||
+             en->getType() == ExecutionNode::HASH_JOIN ||
              en->getType() == ExecutionNode::AGGREGATE) {
       depth += 1;
     }
@@ -101,7 +101,8 @@ namespace triagens {
           RETURN                  = 18,
           NORESULTS               = 19,
           DISTRIBUTE              = 20,
-          UPSERT                  = 21
+          UPSERT                  = 21,
+          HASH_JOIN               = 22
         };
 
 // -----------------------------------------------------------------------------
@@ -856,7 +857,10 @@ namespace triagens {
             _vocbase(vocbase), 
             _collection(collection),
             _outVariable(outVariable),  
-            _random(random) {
+            _random(random),
+            _filterCalculations(),
+            _filterVariable(nullptr),
+            _parallelism(1) {
           TRI_ASSERT(_vocbase != nullptr);
           TRI_ASSERT(_collection != nullptr);
           TRI_ASSERT(_outVariable != nullptr);
@@ -865,6 +869,16 @@ namespace triagens {
         EnumerateCollectionNode (ExecutionPlan* plan,
                                  triagens::basics::Json const& base);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destructor
+////////////////////////////////////////////////////////////////////////////////
+
+        ~EnumerateCollectionNode () {
+          for (auto& it : _filterCalculations) {
+            delete it.second;
+          }
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return the type of the node
 ////////////////////////////////////////////////////////////////////////////////
@@ -936,6 +950,14 @@ namespace triagens {
           _random = true;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the documents are iterated in random order
+////////////////////////////////////////////////////////////////////////////////
+
+        bool isRandom () const {
+          return _random;
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return the database
 ////////////////////////////////////////////////////////////////////////////////
@@ -960,6 +982,56 @@ namespace triagens {
           return _outVariable;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief let the node filter the documents of the collection itself, using
+/// multiple threads. the calculations are executed in order for each document,
+/// and only documents for which the filter variable is true are produced. the
+/// node takes over ownership of the expressions
+////////////////////////////////////////////////////////////////////////////////
+
+        void setParallelFilter (std::vector<std::pair<Variable const*, Expression*>> const& calculations,
+                                Variable const* filterVariable,
+                                size_t parallelism) {
+          TRI_ASSERT(_filterCalculations.empty());
+          TRI_ASSERT(filterVariable != nullptr);
+
+          _filterCalculations = calculations;
+          _filterVariable = filterVariable;
+          _parallelism = parallelism;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the node filters the documents itself
+////////////////////////////////////////////////////////////////////////////////
+
+        bool hasParallelFilter () const {
+          return (_filterVariable != nullptr);
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the calculations of the filter
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<std::pair<Variable const*, Expression*>> const& filterCalculations () const {
+          return _filterCalculations;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the filter variable
+////////////////////////////////////////////////////////////////////////////////
+
+        Variable const* filterVariable () const {
+          return _filterVariable;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the number of threads used for filtering
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t parallelism () const {
+          return _parallelism;
+        }
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
 // -----------------------------------------------------------------------------
@@ -989,6 +1061,25 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         bool _random;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculations executed for each document before filtering, with
+/// their output variables
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<std::pair<Variable const*, Expression*>> _filterCalculations;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the variable that decides whether a document is produced
+////////////////////////////////////////////////////////////////////////////////
+
+        Variable const* _filterVariable;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of threads used for filtering
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _parallelism;
     };
 
 // -----------------------------------------------------------------------------
@@ -1291,6 +1382,221 @@ namespace triagens {
         bool _reverse;
     };
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                class HashJoinNode
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief class HashJoinNode
+///
+/// joins the rows of its dependency with the documents of a collection for
+/// which the key expressions of both sides compare equal. one side is put
+/// into an in-memory hash table, and the other side is probed against it
+////////////////////////////////////////////////////////////////////////////////
+
+    class HashJoinNode : public ExecutionNode {
+      friend class ExecutionNode;
+      friend class ExecutionBlock;
+      friend class HashJoinBlock;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief constructor. the node takes over ownership of the expressions
+////////////////////////////////////////////////////////////////////////////////
+
+      public:
+
+        HashJoinNode (ExecutionPlan* plan,
+                      size_t id,
+                      TRI_vocbase_t* vocbase,
+                      Collection* collection,
+                      Variable const* outVariable,
+                      Expression* collectionExpression,
+                      Expression* inputExpression,
+                      bool hashCollection)
+          : ExecutionNode(plan, id),
+            _vocbase(vocbase),
+            _collection(collection),
+            _outVariable(outVariable),
+            _collectionExpression(collectionExpression),
+            _inputExpression(inputExpression),
+            _hashCollection(hashCollection) {
+          TRI_ASSERT(_vocbase != nullptr);
+          TRI_ASSERT(_collection != nullptr);
+          TRI_ASSERT(_outVariable != nullptr);
+          TRI_ASSERT(_collectionExpression != nullptr);
+          TRI_ASSERT(_inputExpression != nullptr);
+        }
+
+        HashJoinNode (ExecutionPlan* plan,
+                      triagens::basics::Json const& base);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destructor
+////////////////////////////////////////////////////////////////////////////////
+
+        ~HashJoinNode () {
+          delete _collectionExpression;
+          delete _inputExpression;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the type of the node
+////////////////////////////////////////////////////////////////////////////////
+
+        NodeType getType () const override final {
+          return HASH_JOIN;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief export to JSON
+////////////////////////////////////////////////////////////////////////////////
+
+        void toJsonHelper (triagens::basics::Json&,
+                           TRI_memory_zone_t*,
+                           bool) const override final;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief clone ExecutionNode recursively
+////////////////////////////////////////////////////////////////////////////////
+
+        ExecutionNode* clone (ExecutionPlan* plan,
+                              bool withDependencies,
+                              bool withProperties) const override final;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the cost of a hash join node is the cost of building the hash table
+/// for one side plus the cost of probing it with the other side
+////////////////////////////////////////////////////////////////////////////////
+
+        double estimateCost (size_t&) const override final;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief getVariablesUsedHere
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<Variable const*> getVariablesUsedHere () const override final {
+          std::unordered_set<Variable*> vars = _inputExpression->variables();
+          std::vector<Variable const*> v;
+          v.reserve(vars.size());
+
+          for (auto vv : vars) {
+            v.emplace_back(vv);
+          }
+
+          return v;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief getVariablesSetHere
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<Variable const*> getVariablesSetHere () const override final {
+          return std::vector<Variable const*>{ _outVariable };
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the database
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_vocbase_t* vocbase () const {
+          return _vocbase;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the collection
+////////////////////////////////////////////////////////////////////////////////
+
+        Collection const* collection () const {
+          return _collection;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the out variable
+////////////////////////////////////////////////////////////////////////////////
+
+        Variable const* outVariable () const {
+          return _outVariable;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the key expression for the documents of the collection
+////////////////////////////////////////////////////////////////////////////////
+
+        Expression* collectionExpression () const {
+          return _collectionExpression;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the key expression for the input rows
+////////////////////////////////////////////////////////////////////////////////
+
+        Expression* inputExpression () const {
+          return _inputExpression;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the hash table is built for the documents of the collection
+/// (true) or for the input rows (false)
+////////////////////////////////////////////////////////////////////////////////
+
+        bool hashCollection () const {
+          return _hashCollection;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set whether the hash table is built for the documents of the
+/// collection
+////////////////////////////////////////////////////////////////////////////////
+
+        void setHashCollection (bool value) {
+          _hashCollection = value;
+          _estimatedCostSet = false;
+        }
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the database
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_vocbase_t* _vocbase;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief collection
+////////////////////////////////////////////////////////////////////////////////
+
+        Collection* _collection;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief output variable
+////////////////////////////////////////////////////////////////////////////////
+
+        Variable const* _outVariable;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief key expression, evaluated for each document of the collection. the
+/// only variable it refers to is the output variable
+////////////////////////////////////////////////////////////////////////////////
+
+        Expression* _collectionExpression;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief key expression, evaluated for each input row
+////////////////////////////////////////////////////////////////////////////////
+
+        Expression* _inputExpression;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the hash table is built for the documents of the collection
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _hashCollection;
+    };
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                   class LimitNode
 // -----------------------------------------------------------------------------
@@ -1373,6 +1679,30 @@ namespace triagens {
         
         double estimateCost (size_t&) const override final;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the offset
+////////////////////////////////////////////////////////////////////////////////
+
+        inline size_t offset () const {
+          return _offset;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the limit
+////////////////////////////////////////////////////////////////////////////////
+
+        inline size_t limit () const {
+          return _limit;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the node fully counts what it limits
+////////////////////////////////////////////////////////////////////////////////
+
+        inline bool fullCount () const {
+          return _fullCount;
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief tell the node to fully count what it will limit
 ////////////////////////////////////////////////////////////////////////////////
@@ -1491,6 +1821,14 @@ namespace triagens {
           return _outVariable;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the condition variable
+////////////////////////////////////////////////////////////////////////////////
+
+        Variable const* conditionVariable () const {
+          return _conditionVariable;
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return the expression
 ////////////////////////////////////////////////////////////////////////////////
@@ -1872,7 +2210,8 @@ namespace triagens {
                   bool stable) 
           : ExecutionNode(plan, id),
             _elements(elements),
-            _stable(stable) {
+            _stable(stable),
+            _limit(0) {
         }
         
         SortNode (ExecutionPlan* plan,
@@ -1896,6 +2235,24 @@ namespace triagens {
           return _stable;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the maximum number of rows the sort needs to produce.
+/// 0 means all rows are needed
+////////////////////////////////////////////////////////////////////////////////
+
+        inline size_t limit () const {
+          return _limit;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief restrict the sort to produce only the first rows. the sort will
+/// then keep only these rows in a bounded heap
+////////////////////////////////////////////////////////////////////////////////
+
+        void setLimit (size_t limit) {
+          _limit = limit;
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief export to JSON
 ////////////////////////////////////////////////////////////////////////////////
@@ -1912,6 +2269,7 @@ namespace triagens {
                               bool withDependencies,
                               bool withProperties) const override final {
           auto c = new SortNode(plan, _id, _elements, _stable);
+          c->setLimit(_limit);
 
           CloneHelper(c, plan, withDependencies, withProperties);
 
@@ -1980,6 +2338,12 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         bool _stable;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum number of rows the sort needs to produce (0 = all)
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _limit;
     };
 
 
@@ -71,6 +71,300 @@ TRI_json_t const Expression::TrueJson  = { TRI_JSON_BOOLEAN, { true } };
 
 TRI_json_t const Expression::FalseJson = { TRI_JSON_BOOLEAN, { false } };
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  VectorizedColumn
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief intermediate result of a vectorized expression execution. a column
+/// holds the result of an expression node for all items of an AqlItemBlock
+////////////////////////////////////////////////////////////////////////////////
+
+namespace triagens {
+  namespace aql {
+
+    struct VectorizedColumn {
+
+      enum ColumnType {
+        CONSTANT,    // a single constant value, valid for all items
+        REGISTER,    // the values of a register of the input block (not owned)
+        VALUES,      // one value per item, owned by the column
+        NUMBERS,     // one number per item, NaN is used for null
+        BOOLEANS     // one boolean per item
+      };
+
+      VectorizedColumn () 
+        : type(CONSTANT),
+          constant(nullptr),
+          reg(0),
+          collection(nullptr) {
+      }
+
+      ~VectorizedColumn () {
+        for (auto& it : values) {
+          it.destroy();
+        }
+      }
+
+      ColumnType                       type;
+      TRI_json_t const*                constant;
+      RegisterId                       reg;
+      TRI_document_collection_t const* collection;
+      std::vector<AqlValue>            values;
+      std::vector<double>              numbers;
+      std::vector<char>                booleans;
+    };
+
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  helper functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the node produces a boolean value
+////////////////////////////////////////////////////////////////////////////////
+
+static inline bool IsBooleanNode (AstNode const* node) {
+  switch (node->type) {
+    case NODE_TYPE_OPERATOR_BINARY_EQ:
+    case NODE_TYPE_OPERATOR_BINARY_NE:
+    case NODE_TYPE_OPERATOR_BINARY_LT:
+    case NODE_TYPE_OPERATOR_BINARY_LE:
+    case NODE_TYPE_OPERATOR_BINARY_GT:
+    case NODE_TYPE_OPERATOR_BINARY_GE:
+    case NODE_TYPE_OPERATOR_UNARY_NOT:
+      return true;
+    case NODE_TYPE_OPERATOR_BINARY_AND:
+    case NODE_TYPE_OPERATOR_BINARY_OR:
+      return IsBooleanNode(node->getMember(0)) && IsBooleanNode(node->getMember(1));
+    default: 
+      return false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert an AqlValue into a number, using the conversion rules of
+/// the AQL arithmetic operators. returns NaN if the value is converted to null
+////////////////////////////////////////////////////////////////////////////////
+
+static double ToNumber (triagens::arango::AqlTransaction* trx,
+                        AqlValue const& value,
+                        TRI_document_collection_t const* collection) {
+  bool failed;
+  double result;
+
+  if (value.isJson()) {
+    result = TRI_ToDoubleJson(value._json->json(), failed);
+  }
+  else if (value.isShaped() || value.isEmpty()) {
+    // a document cannot be converted into a number
+    return NAN;
+  }
+  else {
+    Json json = value.toJson(trx, collection);
+    result = TRI_ToDoubleJson(json.json(), failed);
+  }
+
+  if (failed) {
+    return NAN;
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute an arithmetic operator on two numbers. NaN is used as the 
+/// representation of null for both the operands and the result
+////////////////////////////////////////////////////////////////////////////////
+
+static double Arithmetic (AstNodeType type,
+                          double lhs,
+                          double rhs,
+                          Query* query) {
+  if (std::isnan(lhs)) {
+    return NAN;
+  }
+
+  double result;
+
+  switch (type) {
+    case NODE_TYPE_OPERATOR_BINARY_PLUS:
+      result = lhs + rhs;
+      break;
+    case NODE_TYPE_OPERATOR_BINARY_MINUS:
+      result = lhs - rhs;
+      break;
+    case NODE_TYPE_OPERATOR_BINARY_TIMES:
+      result = lhs * rhs;
+      break;
+    case NODE_TYPE_OPERATOR_BINARY_DIV:
+    case NODE_TYPE_OPERATOR_BINARY_MOD:
+      if (std::isnan(rhs) || rhs == 0.0) {
+        query->registerWarning(TRI_ERROR_QUERY_DIVISION_BY_ZERO);
+        return NAN;
+      }
+      if (type == NODE_TYPE_OPERATOR_BINARY_DIV) {
+        result = lhs / rhs;
+      }
+      else {
+        result = fmod(lhs, rhs);
+      }
+      break;
+    default:
+      THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid arithmetic operator");
+  }
+
+  if (std::isnan(result) || result == HUGE_VAL || result == -HUGE_VAL) {
+    return NAN;
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create an AqlValue from a number. NaN will produce a null value
+////////////////////////////////////////////////////////////////////////////////
+
+static inline AqlValue NumberValue (double value) {
+  if (std::isnan(value)) {
+    return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, &Expression::NullJson, Json::NOFREE));
+  }
+  return AqlValue(new Json(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create an AqlValue from a boolean
+////////////////////////////////////////////////////////////////////////////////
+
+static inline AqlValue BooleanValue (bool value) {
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, value ? &Expression::TrueJson : &Expression::FalseJson, Json::NOFREE));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert the result of a comparison into a boolean
+////////////////////////////////////////////////////////////////////////////////
+
+static inline bool ComparisonResult (AstNodeType type,
+                                     int compareResult) {
+  switch (type) {
+    case NODE_TYPE_OPERATOR_BINARY_EQ:
+      return (compareResult == 0);
+    case NODE_TYPE_OPERATOR_BINARY_NE:
+      return (compareResult != 0);
+    case NODE_TYPE_OPERATOR_BINARY_LT:
+      return (compareResult < 0);
+    case NODE_TYPE_OPERATOR_BINARY_LE:
+      return (compareResult <= 0);
+    case NODE_TYPE_OPERATOR_BINARY_GT:
+      return (compareResult > 0);
+    case NODE_TYPE_OPERATOR_BINARY_GE:
+      return (compareResult >= 0);
+    default:
+      THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid comparison operator");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fill the numbers of a column from a column of arbitrary type
+////////////////////////////////////////////////////////////////////////////////
+
+static void ColumnToNumbers (VectorizedColumn const& column,
+                             std::vector<double>& numbers,
+                             triagens::arango::AqlTransaction* trx,
+                             AqlItemBlock const* block) {
+  size_t const n = block->size();
+
+  switch (column.type) {
+    case VectorizedColumn::NUMBERS: {
+      numbers = column.numbers;
+      break;
+    }
+    case VectorizedColumn::BOOLEANS: {
+      numbers.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        numbers[i] = column.booleans[i] ? 1.0 : 0.0;
+      }
+      break;
+    }
+    case VectorizedColumn::CONSTANT: {
+      bool failed;
+      double value = TRI_ToDoubleJson(column.constant, failed);
+      numbers.assign(n, failed ? NAN : value);
+      break;
+    }
+    case VectorizedColumn::VALUES: {
+      numbers.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        numbers[i] = ToNumber(trx, column.values[i], nullptr);
+      }
+      break;
+    }
+    case VectorizedColumn::REGISTER: {
+      numbers.resize(n);
+      for (size_t i = 0; i < n; ++i) {
+        numbers[i] = ToNumber(trx, block->getValueReference(i, column.reg), column.collection);
+      }
+      break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compare the values of two columns for a single item
+////////////////////////////////////////////////////////////////////////////////
+
+static int CompareColumns (VectorizedColumn const& lhs,
+                           VectorizedColumn const& rhs,
+                           size_t row,
+                           triagens::arango::AqlTransaction* trx,
+                           AqlItemBlock const* block,
+                           bool compareUtf8) {
+  // storage for values that are not available as an AqlValue already
+  TRI_json_t scratch[2];
+  Json wrapper[2] = { Json(TRI_UNKNOWN_MEM_ZONE, &scratch[0], Json::NOFREE), 
+                      Json(TRI_UNKNOWN_MEM_ZONE, &scratch[1], Json::NOFREE) };
+  AqlValue values[2];
+  TRI_document_collection_t const* collections[2] = { nullptr, nullptr };
+
+  for (size_t i = 0; i < 2; ++i) {
+    VectorizedColumn const& column = (i == 0 ? lhs : rhs);
+
+    switch (column.type) {
+      case VectorizedColumn::CONSTANT: {
+        wrapper[i] = Json(TRI_UNKNOWN_MEM_ZONE, column.constant, Json::NOFREE);
+        values[i] = AqlValue(&wrapper[i]);
+        break;
+      }
+      case VectorizedColumn::REGISTER: {
+        values[i] = block->getValueReference(row, column.reg);
+        collections[i] = column.collection;
+        break;
+      }
+      case VectorizedColumn::VALUES: {
+        values[i] = column.values[row];
+        break;
+      }
+      case VectorizedColumn::NUMBERS: {
+        if (std::isnan(column.numbers[row])) {
+          TRI_InitNullJson(&scratch[i]);
+        }
+        else {
+          TRI_InitNumberJson(&scratch[i], column.numbers[row]);
+        }
+        values[i] = AqlValue(&wrapper[i]);
+        break;
+      }
+      case VectorizedColumn::BOOLEANS: {
+        TRI_InitBooleanJson(&scratch[i], column.booleans[row] != 0);
+        values[i] = AqlValue(&wrapper[i]);
+        break;
+      }
+    }
+  }
+
+  return AqlValue::Compare(trx, values[0], collections[0], values[1], collections[1], compareUtf8);
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                        constructors / destructors
 // -----------------------------------------------------------------------------
@@ -90,8 +384,10 @@ Expression::Expression (Ast* ast,
     _isDeterministic(false),
     _hasDeterminedAttributes(false),
     _built(false),
+    _canExecuteVectorized(false),
     _attributes(),
-    _buffer(TRI_UNKNOWN_MEM_ZONE) {
+    _buffer(TRI_UNKNOWN_MEM_ZONE),
+    _vectorizedAccessors() {
 
   TRI_ASSERT(_ast != nullptr);
   TRI_ASSERT(_executor != nullptr);
@@ -113,6 +409,8 @@ Expression::Expression (Ast* ast,
 ////////////////////////////////////////////////////////////////////////////////
 
 Expression::~Expression () {
+  clearVectorizedAccessors();
+
   if (_built) {
     switch (_type) {
       case JSON:
@@ -152,6 +450,20 @@ std::unordered_set<Variable*> Expression::variables () const {
   return Ast::getReferencedVariables(_node);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief determine all lazily computed properties of the expression's AST
+/// nodes up front, so clones of the expression can be executed by multiple
+/// threads concurrently
+////////////////////////////////////////////////////////////////////////////////
+
+void Expression::prepareConcurrentExecution () {
+  if (_type == UNPROCESSED) {
+    analyzeExpression();
+  }
+
+  prepareNodeForConcurrentExecution(_node);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief execute the expression
 ////////////////////////////////////////////////////////////////////////////////
@@ -225,6 +537,8 @@ void Expression::replaceVariables (std::unordered_map<VariableId, Variable const
 
   _ast->replaceVariables(const_cast<AstNode*>(_node), replacements);
  
+  // the accessors refer to the old nodes and variables
+  clearVectorizedAccessors();
   invalidate(); 
 }
 
@@ -362,6 +676,10 @@ void Expression::analyzeExpression () {
         _built = true;
       }
     }
+
+    if (_type == SIMPLE) {
+      _canExecuteVectorized = isVectorizable(_node);
+    }
   }
   else {
     // expression is a V8 expression
@@ -389,6 +707,36 @@ void Expression::analyzeExpression () {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief determine the flags and the constant value of an AST node and its
+/// members. the results are cached in the nodes
+////////////////////////////////////////////////////////////////////////////////
+
+void Expression::prepareNodeForConcurrentExecution (AstNode const* node) {
+  if (node == nullptr) {
+    return;
+  }
+
+  node->isConstant();
+  node->isSimple();
+  node->canThrow();
+  node->canRunOnDBServer();
+  node->isDeterministic();
+
+  if (node->type == NODE_TYPE_VALUE ||
+      ((node->type == NODE_TYPE_ARRAY || node->type == NODE_TYPE_OBJECT) && node->isConstant())) {
+    if (node->computeJson() == nullptr) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    }
+  }
+
+  size_t const n = node->numMembers();
+
+  for (size_t i = 0; i < n; ++i) {
+    prepareNodeForConcurrentExecution(node->getMemberUnchecked(i));
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief build the expression
 ////////////////////////////////////////////////////////////////////////////////
@@ -762,6 +1110,38 @@ AqlValue Expression::executeSimpleExpression (AstNode const* node,
     // fall-through intentional
   }
   
+  else if (node->type == NODE_TYPE_OPERATOR_UNARY_PLUS ||
+           node->type == NODE_TYPE_OPERATOR_UNARY_MINUS) {
+    TRI_document_collection_t const* myCollection = nullptr;
+    AqlValue operand = executeSimpleExpression(node->getMember(0), &myCollection, trx, argv, startPos, vars, regs);
+
+    double value = ToNumber(trx, operand, myCollection);
+    operand.destroy();
+
+    if (node->type == NODE_TYPE_OPERATOR_UNARY_MINUS) {
+      value = -value;
+    }
+    return NumberValue(value);
+  }
+  
+  else if (node->type == NODE_TYPE_OPERATOR_BINARY_PLUS ||
+           node->type == NODE_TYPE_OPERATOR_BINARY_MINUS ||
+           node->type == NODE_TYPE_OPERATOR_BINARY_TIMES ||
+           node->type == NODE_TYPE_OPERATOR_BINARY_DIV ||
+           node->type == NODE_TYPE_OPERATOR_BINARY_MOD) {
+    TRI_document_collection_t const* leftCollection = nullptr;
+    AqlValue left  = executeSimpleExpression(node->getMember(0), &leftCollection, trx, argv, startPos, vars, regs);
+    double const l = ToNumber(trx, left, leftCollection);
+    left.destroy();
+
+    TRI_document_collection_t const* rightCollection = nullptr;
+    AqlValue right = executeSimpleExpression(node->getMember(1), &rightCollection, trx, argv, startPos, vars, regs);
+    double const r = ToNumber(trx, right, rightCollection);
+    right.destroy();
+
+    return NumberValue(Arithmetic(node->type, l, r, _ast->query()));
+  }
+  
   else if (node->type == NODE_TYPE_OPERATOR_TERNARY) {
     TRI_document_collection_t const* myCollection = nullptr;
     AqlValue condition  = executeSimpleExpression(node->getMember(0), &myCollection, trx, argv, startPos, vars, regs);
@@ -780,6 +1160,411 @@ AqlValue Expression::executeSimpleExpression (AstNode const* node,
   THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "unhandled type in simple expression");
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not a node can be executed for a whole block at once
+////////////////////////////////////////////////////////////////////////////////
+
+bool Expression::isVectorizable (AstNode const* node) {
+  switch (node->type) {
+    case NODE_TYPE_VALUE:
+    case NODE_TYPE_REFERENCE:
+      return true;
+
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT:
+      return node->isConstant();
+
+    case NODE_TYPE_ATTRIBUTE_ACCESS: {
+      auto member = node->getMember(0);
+      while (member->type == NODE_TYPE_ATTRIBUTE_ACCESS) {
+        member = member->getMember(0);
+      }
+      return (member->type == NODE_TYPE_REFERENCE);
+    }
+
+    case NODE_TYPE_OPERATOR_UNARY_NOT:
+    case NODE_TYPE_OPERATOR_UNARY_PLUS:
+    case NODE_TYPE_OPERATOR_UNARY_MINUS:
+      return isVectorizable(node->getMember(0));
+
+    case NODE_TYPE_OPERATOR_BINARY_AND:
+    case NODE_TYPE_OPERATOR_BINARY_OR:
+      // AND and OR return one of their operands, which can only be
+      // represented as a boolean column if both operands are booleans
+      if (! IsBooleanNode(node)) {
+        return false;
+      }
+      // fall-through intentional
+    case NODE_TYPE_OPERATOR_BINARY_EQ:
+    case NODE_TYPE_OPERATOR_BINARY_NE:
+    case NODE_TYPE_OPERATOR_BINARY_LT:
+    case NODE_TYPE_OPERATOR_BINARY_LE:
+    case NODE_TYPE_OPERATOR_BINARY_GT:
+    case NODE_TYPE_OPERATOR_BINARY_GE:
+    case NODE_TYPE_OPERATOR_BINARY_PLUS:
+    case NODE_TYPE_OPERATOR_BINARY_MINUS:
+    case NODE_TYPE_OPERATOR_BINARY_TIMES:
+    case NODE_TYPE_OPERATOR_BINARY_DIV:
+    case NODE_TYPE_OPERATOR_BINARY_MOD:
+      return isVectorizable(node->getMember(0)) && isVectorizable(node->getMember(1));
+
+    default:
+      return false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute an expression of type SIMPLE for all items of a block,
+/// writing the results into the output register
+////////////////////////////////////////////////////////////////////////////////
+
+void Expression::executeVectorized (triagens::arango::AqlTransaction* trx,
+                                    AqlItemBlock* block,
+                                    std::vector<Variable*> const& vars,
+                                    std::vector<RegisterId> const& regs,
+                                    RegisterId outReg) {
+  TRI_ASSERT(_type == SIMPLE);
+  TRI_ASSERT(_canExecuteVectorized);
+
+  VectorizedColumn column;
+  executeVectorizedNode(_node, column, trx, block, vars, regs);
+
+  size_t const n = block->size();
+
+  for (size_t i = 0; i < n; ++i) {
+    AqlValue a;
+
+    switch (column.type) {
+      case VectorizedColumn::CONSTANT: {
+        a = AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, column.constant, Json::NOFREE));
+        break;
+      }
+      case VectorizedColumn::REGISTER: {
+        a = block->getValueReference(i, column.reg).clone();
+        break;
+      }
+      case VectorizedColumn::VALUES: {
+        a = column.values[i];
+        break;
+      }
+      case VectorizedColumn::NUMBERS: {
+        a = NumberValue(column.numbers[i]);
+        break;
+      }
+      case VectorizedColumn::BOOLEANS: {
+        a = BooleanValue(column.booleans[i] != 0);
+        break;
+      }
+    }
+
+    try {
+      block->setValue(i, outReg, a);
+    }
+    catch (...) {
+      if (column.type != VectorizedColumn::VALUES) {
+        a.destroy();
+      }
+      throw;
+    }
+
+    if (column.type == VectorizedColumn::VALUES) {
+      // the block is now responsible for the value
+      column.values[i].erase();
+    }
+  }
+
+  if (column.type == VectorizedColumn::REGISTER) {
+    block->setDocumentCollection(outReg, column.collection);
+  }
+  else {
+    block->setDocumentCollection(outReg, nullptr);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute a node for all items of a block, producing a column
+////////////////////////////////////////////////////////////////////////////////
+
+void Expression::executeVectorizedNode (AstNode const* node,
+                                        VectorizedColumn& column,
+                                        triagens::arango::AqlTransaction* trx,
+                                        AqlItemBlock const* block,
+                                        std::vector<Variable*> const& vars,
+                                        std::vector<RegisterId> const& regs) {
+  size_t const n = block->size();
+
+  switch (node->type) {
+    case NODE_TYPE_VALUE:
+    case NODE_TYPE_ARRAY:
+    case NODE_TYPE_OBJECT: {
+      // we do not own the JSON but the node does!
+      column.type = VectorizedColumn::CONSTANT;
+      column.constant = node->computeJson();
+
+      if (column.constant == nullptr) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+      }
+      return;
+    }
+
+    case NODE_TYPE_REFERENCE: {
+      auto v = static_cast<Variable const*>(node->getData());
+
+      size_t i = 0;
+      for (auto it = vars.begin(); it != vars.end(); ++it, ++i) {
+        if ((*it)->name == v->name) {
+          column.type = VectorizedColumn::REGISTER;
+          column.reg = regs[i];
+          column.collection = block->getDocumentCollection(regs[i]);
+          return;
+        }
+      }
+      break;
+    }
+
+    case NODE_TYPE_ATTRIBUTE_ACCESS: {
+      auto it = _vectorizedAccessors.find(node);
+      AttributeAccessor* accessor = nullptr;
+
+      if (it == _vectorizedAccessors.end()) {
+        std::vector<char const*> parts{ static_cast<char const*>(node->getData()) };
+        auto member = node->getMember(0);
+
+        while (member->type == NODE_TYPE_ATTRIBUTE_ACCESS) {
+          parts.insert(parts.begin(), static_cast<char const*>(member->getData()));
+          member = member->getMember(0);
+        }
+        TRI_ASSERT(member->type == NODE_TYPE_REFERENCE);
+
+        accessor = new AttributeAccessor(parts, static_cast<Variable const*>(member->getData()));
+
+        try {
+          _vectorizedAccessors.emplace(node, accessor);
+        }
+        catch (...) {
+          delete accessor;
+          throw;
+        }
+      }
+      else {
+        accessor = (*it).second;
+      }
+
+      column.type = VectorizedColumn::VALUES;
+      column.values.reserve(n);
+
+      for (size_t i = 0; i < n; ++i) {
+        column.values.emplace_back(accessor->get(trx, block, i, vars, regs));
+      }
+      return;
+    }
+
+    case NODE_TYPE_OPERATOR_UNARY_NOT: {
+      VectorizedColumn operand;
+      executeVectorizedNode(node->getMember(0), operand, trx, block, vars, regs);
+
+      column.type = VectorizedColumn::BOOLEANS;
+      column.booleans.resize(n);
+
+      if (operand.type == VectorizedColumn::BOOLEANS) {
+        for (size_t i = 0; i < n; ++i) {
+          column.booleans[i] = ! operand.booleans[i];
+        }
+      }
+      else if (operand.type == VectorizedColumn::NUMBERS) {
+        for (size_t i = 0; i < n; ++i) {
+          double const value = operand.numbers[i];
+          column.booleans[i] = (std::isnan(value) || value == 0.0);
+        }
+      }
+      else {
+        for (size_t i = 0; i < n; ++i) {
+          bool isTrue;
+          if (operand.type == VectorizedColumn::CONSTANT) {
+            Json wrapper(TRI_UNKNOWN_MEM_ZONE, operand.constant, Json::NOFREE);
+            isTrue = AqlValue(&wrapper).isTrue();
+          }
+          else if (operand.type == VectorizedColumn::REGISTER) {
+            isTrue = block->getValueReference(i, operand.reg).isTrue();
+          }
+          else {
+            isTrue = operand.values[i].isTrue();
+          }
+          column.booleans[i] = ! isTrue;
+        }
+      }
+      return;
+    }
+
+    case NODE_TYPE_OPERATOR_BINARY_AND:
+    case NODE_TYPE_OPERATOR_BINARY_OR: {
+      VectorizedColumn left;
+      executeVectorizedNode(node->getMember(0), left, trx, block, vars, regs);
+      VectorizedColumn right;
+      executeVectorizedNode(node->getMember(1), right, trx, block, vars, regs);
+
+      TRI_ASSERT(left.type == VectorizedColumn::BOOLEANS);
+      TRI_ASSERT(right.type == VectorizedColumn::BOOLEANS);
+
+      column.type = VectorizedColumn::BOOLEANS;
+      column.booleans.resize(n);
+
+      if (node->type == NODE_TYPE_OPERATOR_BINARY_AND) {
+        for (size_t i = 0; i < n; ++i) {
+          column.booleans[i] = (left.booleans[i] && right.booleans[i]);
+        }
+      }
+      else {
+        for (size_t i = 0; i < n; ++i) {
+          column.booleans[i] = (left.booleans[i] || right.booleans[i]);
+        }
+      }
+      return;
+    }
+
+    case NODE_TYPE_OPERATOR_BINARY_EQ:
+    case NODE_TYPE_OPERATOR_BINARY_NE:
+    case NODE_TYPE_OPERATOR_BINARY_LT:
+    case NODE_TYPE_OPERATOR_BINARY_LE:
+    case NODE_TYPE_OPERATOR_BINARY_GT:
+    case NODE_TYPE_OPERATOR_BINARY_GE: {
+      VectorizedColumn left;
+      executeVectorizedNode(node->getMember(0), left, trx, block, vars, regs);
+      VectorizedColumn right;
+      executeVectorizedNode(node->getMember(1), right, trx, block, vars, regs);
+
+      column.type = VectorizedColumn::BOOLEANS;
+      column.booleans.resize(n);
+
+      bool const leftIsNumeric = (left.type == VectorizedColumn::NUMBERS ||
+                                  (left.type == VectorizedColumn::CONSTANT && TRI_IsNumberJson(left.constant)));
+      bool const rightIsNumeric = (right.type == VectorizedColumn::NUMBERS ||
+                                   (right.type == VectorizedColumn::CONSTANT && TRI_IsNumberJson(right.constant)));
+
+      if (leftIsNumeric && rightIsNumeric) {
+        // fast path: compare numbers directly. null (NaN) is less than any number
+        std::vector<double> l;
+        ColumnToNumbers(left, l, trx, block);
+        std::vector<double> r;
+        ColumnToNumbers(right, r, trx, block);
+
+        for (size_t i = 0; i < n; ++i) {
+          int compareResult;
+          bool const lNull = std::isnan(l[i]);
+          bool const rNull = std::isnan(r[i]);
+
+          if (lNull || rNull) {
+            compareResult = (lNull ? 0 : 1) - (rNull ? 0 : 1);
+          }
+          else {
+            compareResult = (l[i] < r[i] ? -1 : (l[i] > r[i] ? 1 : 0));
+          }
+          column.booleans[i] = ComparisonResult(node->type, compareResult);
+        }
+        return;
+      }
+
+      // for equality and non-equality we can use a binary comparison
+      bool compareUtf8 = (node->type != NODE_TYPE_OPERATOR_BINARY_EQ && node->type != NODE_TYPE_OPERATOR_BINARY_NE);
+
+      for (size_t i = 0; i < n; ++i) {
+        int compareResult = CompareColumns(left, right, i, trx, block, compareUtf8);
+        column.booleans[i] = ComparisonResult(node->type, compareResult);
+      }
+      return;
+    }
+
+    case NODE_TYPE_OPERATOR_UNARY_PLUS:
+    case NODE_TYPE_OPERATOR_UNARY_MINUS: {
+      VectorizedColumn operand;
+      executeVectorizedNode(node->getMember(0), operand, trx, block, vars, regs);
+
+      column.type = VectorizedColumn::NUMBERS;
+      ColumnToNumbers(operand, column.numbers, trx, block);
+
+      if (node->type == NODE_TYPE_OPERATOR_UNARY_MINUS) {
+        for (size_t i = 0; i < n; ++i) {
+          column.numbers[i] = - column.numbers[i];
+        }
+      }
+      return;
+    }
+
+    case NODE_TYPE_OPERATOR_BINARY_PLUS:
+    case NODE_TYPE_OPERATOR_BINARY_MINUS:
+    case NODE_TYPE_OPERATOR_BINARY_TIMES:
+    case NODE_TYPE_OPERATOR_BINARY_DIV:
+    case NODE_TYPE_OPERATOR_BINARY_MOD: {
+      std::vector<double> r;
+      {
+        VectorizedColumn left;
+        executeVectorizedNode(node->getMember(0), left, trx, block, vars, regs);
+        ColumnToNumbers(left, column.numbers, trx, block);
+      }
+      {
+        VectorizedColumn right;
+        executeVectorizedNode(node->getMember(1), right, trx, block, vars, regs);
+        ColumnToNumbers(right, r, trx, block);
+      }
+
+      column.type = VectorizedColumn::NUMBERS;
+      double* l = column.numbers.data();
+
+      // NaN operands propagate to the result, so the common operators can
+      // run in tight loops. results that are not finite are turned into null
+      switch (node->type) {
+        case NODE_TYPE_OPERATOR_BINARY_PLUS:
+          for (size_t i = 0; i < n; ++i) {
+            l[i] += r[i];
+          }
+          break;
+        case NODE_TYPE_OPERATOR_BINARY_MINUS:
+          for (size_t i = 0; i < n; ++i) {
+            l[i] -= r[i];
+          }
+          break;
+        case NODE_TYPE_OPERATOR_BINARY_TIMES:
+          for (size_t i = 0; i < n; ++i) {
+            l[i] *= r[i];
+          }
+          break;
+        default: {
+          // division and modulo need to check for division by zero
+          Query* query = _ast->query();
+          for (size_t i = 0; i < n; ++i) {
+            l[i] = Arithmetic(node->type, l[i], r[i], query);
+          }
+          return;
+        }
+      }
+
+      for (size_t i = 0; i < n; ++i) {
+        if (l[i] == HUGE_VAL || l[i] == -HUGE_VAL) {
+          l[i] = NAN;
+        }
+      }
+      return;
+    }
+
+    default: {
+      break;
+    }
+  }
+
+  THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "unhandled type in vectorized expression");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief free the attribute accessors used for vectorized execution
+////////////////////////////////////////////////////////////////////////////////
+
+void Expression::clearVectorizedAccessors () {
+  for (auto& it : _vectorizedAccessors) {
+    delete it.second;
+  }
+  _vectorizedAccessors.clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief check whether this is an attribute access of any degree (e.g. a.b, 
 /// a.b.c, ...)
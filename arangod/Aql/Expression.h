@@ -53,6 +53,7 @@ namespace triagens {
     class AttributeAccessor;
     class Executor;
     struct V8Expression;
+    struct VectorizedColumn;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief AqlExpression, used in execution plans and execution blocks
@@ -153,6 +154,14 @@ namespace triagens {
           return new Expression(_ast, _node);
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief determine all lazily computed properties of the expression's AST
+/// nodes up front, so clones of the expression can be executed by multiple
+/// threads concurrently
+////////////////////////////////////////////////////////////////////////////////
+
+        void prepareConcurrentExecution ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return all variables used in the expression
 ////////////////////////////////////////////////////////////////////////////////
@@ -179,6 +188,29 @@ namespace triagens {
                           std::vector<RegisterId> const&,
                           TRI_document_collection_t const**);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the expression can be executed for all items of a
+/// block at once via executeVectorized()
+////////////////////////////////////////////////////////////////////////////////
+
+        inline bool canExecuteVectorized () {
+          if (_type == UNPROCESSED) {
+            analyzeExpression();
+          }
+          return _canExecuteVectorized;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute the expression for all items of a block at once, and
+/// store the results in the specified output register of the block
+////////////////////////////////////////////////////////////////////////////////
+
+        void executeVectorized (triagens::arango::AqlTransaction*,
+                                AqlItemBlock*,
+                                std::vector<Variable*> const&,
+                                std::vector<RegisterId> const&,
+                                RegisterId);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief check whether this is a JSON expression
 ////////////////////////////////////////////////////////////////////////////////
@@ -312,6 +344,13 @@ namespace triagens {
 
         void buildExpression ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief determine the flags and the constant value of an AST node and its
+/// members
+////////////////////////////////////////////////////////////////////////////////
+
+        static void prepareNodeForConcurrentExecution (AstNode const*);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief execute an expression of type SIMPLE
 ////////////////////////////////////////////////////////////////////////////////
@@ -324,6 +363,29 @@ namespace triagens {
                                           std::vector<Variable*> const&,
                                           std::vector<RegisterId> const&);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not an expression node can be executed vectorized
+////////////////////////////////////////////////////////////////////////////////
+
+        static bool isVectorizable (AstNode const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute an expression node for all items of a block at once
+////////////////////////////////////////////////////////////////////////////////
+
+        void executeVectorizedNode (AstNode const*,
+                                    VectorizedColumn&,
+                                    triagens::arango::AqlTransaction*,
+                                    AqlItemBlock const*,
+                                    std::vector<Variable*> const&,
+                                    std::vector<RegisterId> const&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief free the attribute accessors used for vectorized execution
+////////////////////////////////////////////////////////////////////////////////
+
+        void clearVectorizedAccessors ();
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
 // -----------------------------------------------------------------------------
@@ -398,6 +460,12 @@ namespace triagens {
 
         bool                      _built;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the expression can be executed vectorized
+////////////////////////////////////////////////////////////////////////////////
+
+        bool                      _canExecuteVectorized;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief the top-level attributes used in the expression, group by variable name
 ////////////////////////////////////////////////////////////////////////////////
@@ -410,6 +478,13 @@ namespace triagens {
 
         triagens::basics::StringBuffer _buffer;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief attribute accessors used in vectorized execution, one per attribute
+/// access node
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<AstNode const*, AttributeAccessor*> _vectorizedAccessors;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                             public static members
 // -----------------------------------------------------------------------------
@@ -34,6 +34,7 @@
 #include "Basics/JsonHelper.h"
 #include "Basics/json-utilities.h"
 #include "Basics/StringBuffer.h"
+#include "Basics/system-functions.h"
 #include "Basics/Utf8Helper.h"
 #include "Rest/SslInterface.h"
 
@@ -205,1039 +206,4204 @@ static void AppendAsString (triagens::basics::StringBuffer& buffer,
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function IS_NULL
+/// @brief convert a value into a string, using the AQL TO_STRING() conversion 
+/// rules
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::IsNull (triagens::aql::Query*, 
-                            triagens::arango::AqlTransaction* trx,
-                            TRI_document_collection_t const* collection,
-                            AqlValue const parameters) {
-  Json j(parameters.extractArrayMember(trx, collection, 0, false));
-  return AqlValue(new Json(j.isNull()));
+static std::string ValueToString (TRI_json_t const* json) {
+  if (TRI_IsStringJson(json)) {
+    return std::string(json->_value._string.data, json->_value._string.length - 1);
+  }
+
+  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE, 24);
+  AppendAsString(buffer, json);
+  return std::string(buffer.c_str(), buffer.length());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function IS_BOOL
+/// @brief extract a parameter and convert it into a string, using the AQL
+/// TO_STRING() conversion rules
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::IsBool (triagens::aql::Query*,
-                            triagens::arango::AqlTransaction* trx,
-                            TRI_document_collection_t const* collection,
-                            AqlValue const parameters) {
-  Json j(parameters.extractArrayMember(trx, collection, 0, false));
-  return AqlValue(new Json(j.isBoolean()));
+static std::string ExtractString (triagens::arango::AqlTransaction* trx,
+                                  TRI_document_collection_t const* collection,
+                                  AqlValue const& parameters,
+                                  size_t position) {
+  Json value(parameters.extractArrayMember(trx, collection, position, false));
+  return ValueToString(value.json());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function IS_NUMBER
+/// @brief copy a value
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::IsNumber (triagens::aql::Query*,
-                              triagens::arango::AqlTransaction* trx,
-                              TRI_document_collection_t const* collection,
-                              AqlValue const parameters) {
-  Json j(parameters.extractArrayMember(trx, collection, 0, false));
-  return AqlValue(new Json(j.isNumber()));
-}
+static Json CopyValue (TRI_json_t const* json) {
+  TRI_json_t* copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, json);
 
-////////////////////////////////////////////////////////////////////////////////
-/// @brief function IS_STRING
-////////////////////////////////////////////////////////////////////////////////
+  if (copy == nullptr) {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  }
 
-AqlValue Functions::IsString (triagens::aql::Query*,
-                              triagens::arango::AqlTransaction* trx,
-                              TRI_document_collection_t const* collection,
-                              AqlValue const parameters) {
-  Json j(parameters.extractArrayMember(trx, collection, 0, false));
-  return AqlValue(new Json(j.isString()));
+  return Json(TRI_UNKNOWN_MEM_ZONE, copy);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function IS_ARRAY
+/// @brief whether or not a string is an array index in JavaScript. objects
+/// enumerate such keys first, in ascending order
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::IsArray (triagens::aql::Query*,
-                             triagens::arango::AqlTransaction* trx,
-                             TRI_document_collection_t const* collection,
-                             AqlValue const parameters) {
-  Json j(parameters.extractArrayMember(trx, collection, 0, false));
-  return AqlValue(new Json(j.isArray()));
-}
+static bool IsArrayIndex (char const* value,
+                          size_t length,
+                          uint64_t& index) {
+  if (length == 0 || length > 10 || (length > 1 && value[0] == '0')) {
+    return false;
+  }
 
-////////////////////////////////////////////////////////////////////////////////
-/// @brief function IS_OBJECT
-////////////////////////////////////////////////////////////////////////////////
+  index = 0;
+  for (size_t i = 0; i < length; ++i) {
+    if (value[i] < '0' || value[i] > '9') {
+      return false;
+    }
+    index = index * 10 + static_cast<uint64_t>(value[i] - '0');
+  }
 
-AqlValue Functions::IsObject (triagens::aql::Query*,
-                              triagens::arango::AqlTransaction* trx,
-                              TRI_document_collection_t const* collection,
-                              AqlValue const parameters) {
-  Json j(parameters.extractArrayMember(trx, collection, 0, false));
-  return AqlValue(new Json(j.isObject()));
+  return index < 4294967295ULL;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function LENGTH
+/// @brief return the positions of the keys of an object, in the order in 
+/// which JavaScript's Object.keys() returns them
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Length (triagens::aql::Query*,
-                            triagens::arango::AqlTransaction* trx,
-                            TRI_document_collection_t const* collection,
-                            AqlValue const parameters) {
-  Json j(parameters.extractArrayMember(trx, collection, 0, false));
-
-  TRI_json_t const* json = j.json();
-  size_t length = 0;
+static std::vector<size_t> ObjectKeyPositions (TRI_json_t const* json) {
+  TRI_ASSERT(TRI_IsObjectJson(json));
 
-  if (json != nullptr) {
-    switch (json->_type) {
-      case TRI_JSON_UNUSED:
-      case TRI_JSON_NULL: {
-        length = 0;
-        break;
-      }
+  std::vector<std::pair<uint64_t, size_t>> indexes;
+  std::vector<size_t> positions;
+  size_t const n = TRI_LengthVector(&json->_value._objects);
 
-      case TRI_JSON_BOOLEAN: {
-        length = (json->_value._boolean ? 1 : 0);
-        break;
-      }
+  for (size_t i = 0; i + 1 < n; i += 2) {
+    auto key = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, i));
+    uint64_t index;
 
-      case TRI_JSON_NUMBER: {
-        if (std::isnan(json->_value._number) ||
-            ! std::isfinite(json->_value._number)) {
-          // invalid value
-          length = strlen("null");
-        }
-        else {
-          // convert to a string representation of the number
-          char buffer[24];
-          length = static_cast<size_t>(fpconv_dtoa(json->_value._number, buffer));
-        }
-        break;
-      }
+    if (IsArrayIndex(key->_value._string.data, key->_value._string.length - 1, index)) {
+      indexes.emplace_back(index, i);
+    }
+    else {
+      positions.emplace_back(i);
+    }
+  }
 
-      case TRI_JSON_STRING:
-      case TRI_JSON_STRING_REFERENCE: {
-        // return number of characters (not bytes) in string
-        length = TRI_CharLengthUtf8String(json->_value._string.data);
-        break;
-      }
+  std::sort(indexes.begin(), indexes.end());
 
-      case TRI_JSON_OBJECT: {
-        // return number of attributes
-        length = TRI_LengthVector(&json->_value._objects) / 2;
-        break;
-      }
+  std::vector<size_t> result;
+  result.reserve(indexes.size() + positions.size());
 
-      case TRI_JSON_ARRAY: {
-        // return list length
-        length = TRI_LengthArrayJson(json);
-        break;
-      }
-    }
+  for (auto const& it : indexes) {
+    result.emplace_back(it.second);
   }
+  result.insert(result.end(), positions.begin(), positions.end());
 
-  return AqlValue(new Json(static_cast<double>(length)));
+  return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function CONCAT
+/// @brief remove duplicates from a list of values, in the order the V8 
+/// implementation of UNIQUE() returns them: numbers that are array indexes
+/// come first in ascending order, all other values keep their order
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Concat (triagens::aql::Query*,
-                            triagens::arango::AqlTransaction* trx,
-                            TRI_document_collection_t const* collection,
-                            AqlValue const parameters) {
-  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE, 24);
-
-  size_t const n = parameters.arraySize();
+static void UniqueValues (std::vector<TRI_json_t const*>& values) {
+  std::unordered_set<TRI_json_t const*, triagens::basics::JsonHash, triagens::basics::JsonEqual> seen(
+    values.size(), 
+    triagens::basics::JsonHash(), 
+    triagens::basics::JsonEqual()
+  );
 
-  for (size_t i = 0; i < n; ++i) {
-    Json member = parameters.at(trx, i);
+  std::vector<std::pair<double, TRI_json_t const*>> indexes;
+  std::vector<TRI_json_t const*> others;
 
-    if (member.isEmpty() || member.isNull()) {
+  for (auto const& it : values) {
+    if (! seen.emplace(it).second) {
+      // duplicate
       continue;
     }
-      
-    TRI_json_t const* json = member.json();
-    
-    if (member.isArray()) {
-      // append each member individually
-      size_t const subLength = TRI_LengthArrayJson(json);
-
-      for (size_t j = 0; j < subLength; ++j) {
-        auto sub = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, j));
-
-        if (sub == nullptr || sub->_type == TRI_JSON_NULL) {
-          continue;
-        }
 
-        AppendAsString(buffer, sub);
-      }
+    if (TRI_IsNumberJson(it) &&
+        it->_value._number >= 0.0 && 
+        it->_value._number < 4294967295.0 &&
+        it->_value._number == std::floor(it->_value._number)) {
+      indexes.emplace_back(it->_value._number, it);
     }
     else {
-      // convert member to a string and append
-      AppendAsString(buffer, json);
+      others.emplace_back(it);
     }
   }
-  
-  // steal the StringBuffer's char* pointer so we can avoid copying data around
-  // multiple times
-  size_t length = buffer.length();
-  std::unique_ptr<TRI_json_t> j(TRI_CreateStringJson(TRI_UNKNOWN_MEM_ZONE, buffer.steal(), length));
 
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.get());
-  j.release();
-  return AqlValue(jr);
+  std::sort(indexes.begin(), indexes.end(), [] (std::pair<double, TRI_json_t const*> const& lhs,
+                                                std::pair<double, TRI_json_t const*> const& rhs) -> bool {
+    return lhs.first < rhs.first;
+  });
+
+  values.clear();
+  for (auto const& it : indexes) {
+    values.emplace_back(it.second);
+  }
+  values.insert(values.end(), others.begin(), others.end());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function PASSTHRU
+/// @brief extract a parameter and convert it into a number, using the AQL
+/// TO_NUMBER() conversion rules. failed is set if the result would be null
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Passthru (triagens::aql::Query*,
-                              triagens::arango::AqlTransaction* trx,
-                              TRI_document_collection_t const* collection,
-                              AqlValue const parameters) {
-
-  Json j(parameters.extractArrayMember(trx, collection, 0, true));
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.json());
-  j.steal();
-  return AqlValue(jr);
+static double ExtractNumber (triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const& parameters,
+                             size_t position,
+                             bool& failed) {
+  Json value(parameters.extractArrayMember(trx, collection, position, false));
+  return TRI_ToDoubleJson(value.json(), failed);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function UNSET
+/// @brief convert a number into an integer, like JavaScript's ToInteger does
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Unset (triagens::aql::Query* query,
-                           triagens::arango::AqlTransaction* trx,
-                           TRI_document_collection_t const* collection,
-                           AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+static double ToInteger (double value) {
+  if (std::isnan(value)) {
+    return 0.0;
+  }
+  if (value == HUGE_VAL || value == -HUGE_VAL) {
+    return value;
+  }
+  return (value < 0.0 ? std::ceil(value) : std::floor(value));
+}
 
-  if (! value.isObject()) {
-    RegisterInvalidArgumentWarning(query, "UNSET");
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a number result. invalid numbers are returned as null
+////////////////////////////////////////////////////////////////////////////////
+
+static AqlValue NumberResult (double value) {
+  if (std::isnan(value) || value == HUGE_VAL || value == -HUGE_VAL) {
     return AqlValue(new Json(Json::Null));
   }
- 
-  std::unordered_set<std::string> names;
-  ExtractKeys(names, query, trx, collection, parameters, 1, "UNSET");
+  return AqlValue(new Json(value));
+}
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert a UTF-8 string into UTF-16 code units. character positions
+/// and lengths are measured in UTF-16 code units, like in JavaScript
+////////////////////////////////////////////////////////////////////////////////
 
-  // create result object
-  TRI_json_t const* valueJson = value.json();
-  size_t const n = TRI_LengthVector(&valueJson->_value._objects);
+static void DecodeUtf16 (std::string const& value,
+                         std::vector<uint16_t>& units) {
+  size_t const length = value.size();
 
-  size_t size;
-  if (names.size() >= n / 2) {
-    size = 4; 
-  }
-  else {
-    size = (n / 2) - names.size(); 
-  }
+  units.clear();
+  units.reserve(length);
 
-  std::unique_ptr<TRI_json_t> j(TRI_CreateObjectJson(TRI_UNKNOWN_MEM_ZONE, size));
+  size_t i = 0;
+  while (i < length) {
+    unsigned char c = static_cast<unsigned char>(value[i]);
+    uint32_t cp;
+    size_t n;
 
-  if (j == nullptr) {
-    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    if (c < 0x80) {
+      cp = c;
+      n = 0;
+    }
+    else if ((c & 0xE0) == 0xC0) {
+      cp = c & 0x1F;
+      n = 1;
+    }
+    else if ((c & 0xF0) == 0xE0) {
+      cp = c & 0x0F;
+      n = 2;
+    }
+    else {
+      cp = c & 0x07;
+      n = 3;
+    }
+
+    ++i;
+    while (n-- > 0 && i < length) {
+      cp = (cp << 6) | (static_cast<unsigned char>(value[i]) & 0x3F);
+      ++i;
+    }
+
+    if (cp >= 0x10000) {
+      // surrogate pair
+      cp -= 0x10000;
+      units.emplace_back(static_cast<uint16_t>(0xD800 + (cp >> 10)));
+      units.emplace_back(static_cast<uint16_t>(0xDC00 + (cp & 0x3FF)));
+    }
+    else {
+      units.emplace_back(static_cast<uint16_t>(cp));
+    }
   }
+}
 
-  for (size_t i = 0; i < n; i += 2) {
-    auto key = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
-    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i + 1));
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert a range of UTF-16 code units into a UTF-8 string. surrogates
+/// that are not part of a pair are replaced with U+FFFD
+////////////////////////////////////////////////////////////////////////////////
 
-    if (TRI_IsStringJson(key) && 
-        names.find(key->_value._string.data) == names.end()) {
-      auto copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value);
+static std::string EncodeUtf16 (std::vector<uint16_t> const& units,
+                                size_t from,
+                                size_t to) {
+  std::string result;
+  result.reserve(to - from);
 
-      if (copy == nullptr) {
-        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
-      } 
+  for (size_t i = from; i < to; ++i) {
+    uint32_t cp = units[i];
 
-      TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, j.get(), key->_value._string.data, copy);
+    if (cp >= 0xD800 && cp <= 0xDBFF && 
+        i + 1 < to && 
+        units[i + 1] >= 0xDC00 && units[i + 1] <= 0xDFFF) {
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (units[i + 1] - 0xDC00);
+      ++i;
+    }
+    else if (cp >= 0xD800 && cp <= 0xDFFF) {
+      cp = 0xFFFD;
     }
-  } 
 
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.get());
-  j.release();
-  return AqlValue(jr);
+    if (cp < 0x80) {
+      result.push_back(static_cast<char>(cp));
+    }
+    else if (cp < 0x800) {
+      result.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000) {
+      result.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else {
+      result.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  }
+
+  return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function KEEP
+/// @brief number of UTF-16 code units needed for a UTF-8 string
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Keep (triagens::aql::Query* query,
-                          triagens::arango::AqlTransaction* trx,
-                          TRI_document_collection_t const* collection,
-                          AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+static size_t Utf16Length (char const* value,
+                           size_t length) {
+  size_t result = 0;
 
-  if (! value.isObject()) {
-    RegisterInvalidArgumentWarning(query, "KEEP");
-    return AqlValue(new Json(Json::Null));
+  for (size_t i = 0; i < length; ++i) {
+    unsigned char const c = static_cast<unsigned char>(value[i]);
+
+    if ((c & 0xC0) != 0x80) {
+      // not a continuation byte. 4-byte sequences need a surrogate pair
+      result += (c >= 0xF0 ? 2 : 1);
+    }
   }
- 
-  std::unordered_set<std::string> names;
-  ExtractKeys(names, query, trx, collection, parameters, 1, "KEEP");
 
+  return result;
+}
 
-  // create result object
-  std::unique_ptr<TRI_json_t> j(TRI_CreateObjectJson(TRI_UNKNOWN_MEM_ZONE, names.size()));
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculate the range of a substring, like JavaScript's 
+/// String.prototype.substr() does. hasCount is false if no count was given
+////////////////////////////////////////////////////////////////////////////////
 
-  if (j == nullptr) {
-    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+static void SubstrRange (size_t size,
+                         double start,
+                         double count,
+                         bool hasCount,
+                         size_t& from,
+                         size_t& to) {
+  double const length = static_cast<double>(size);
+
+  start = ToInteger(start);
+  if (start < 0.0) {
+    start = (std::max)(length + start, 0.0);
   }
+  start = (std::min)(start, length);
 
-  TRI_json_t const* valueJson = value.json();
-  size_t const n = TRI_LengthVector(&valueJson->_value._objects);
-
-  for (size_t i = 0; i < n; i += 2) {
-    auto key = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
-    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i + 1));
+  if (hasCount) {
+    count = (std::min)((std::max)(ToInteger(count), 0.0), length - start);
+  }
+  else {
+    count = length - start;
+  }
 
-    if (TRI_IsStringJson(key) && 
-        names.find(key->_value._string.data) != names.end()) {
-      auto copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value);
+  from = static_cast<size_t>(start);
+  to = static_cast<size_t>(start + count);
+}
 
-      if (copy == nullptr) {
-        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
-      } 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief extract a substring of UTF-16 code units, like JavaScript's
+/// String.prototype.substr() does. hasCount is false if no count was given
+////////////////////////////////////////////////////////////////////////////////
 
-      TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, j.get(), key->_value._string.data, copy);
-    }
-  } 
+static std::string Substr (std::vector<uint16_t> const& units,
+                           double start,
+                           double count,
+                           bool hasCount) {
+  size_t from, to;
+  SubstrRange(units.size(), start, count, hasCount, from, to);
 
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.get());
-  j.release();
-  return AqlValue(jr);
+  return EncodeUtf16(units, from, to);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function MERGE
+/// @brief find the first occurrence of search in value, starting at the
+/// specified position, like JavaScript's String.prototype.indexOf() does
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Merge (triagens::aql::Query* query,
-                           triagens::arango::AqlTransaction* trx,
-                           TRI_document_collection_t const* collection,
-                           AqlValue const parameters) {
-  size_t const n = parameters.arraySize();
+static double IndexOf (std::vector<uint16_t> const& value,
+                       std::vector<uint16_t> const& search,
+                       double position) {
+  size_t const length = value.size();
+  size_t const start = static_cast<size_t>((std::min)((std::max)(ToInteger(position), 0.0), static_cast<double>(length)));
 
-  if (n == 0) {
-    // no parameters
-    return AqlValue(new Json(Json::Object));
+  if (search.size() > length) {
+    return -1.0;
   }
 
-  // use the first argument as the preliminary result
-  Json initial(parameters.extractArrayMember(trx, collection, 0, true));
-
-  if (! initial.isObject()) {
-    RegisterInvalidArgumentWarning(query, "MERGE");
-    return AqlValue(new Json(Json::Null));
+  for (size_t i = start; i + search.size() <= length; ++i) {
+    if (std::equal(search.begin(), search.end(), value.begin() + i)) {
+      return static_cast<double>(i);
+    }
   }
 
-  std::unique_ptr<TRI_json_t> result(initial.steal());
+  return -1.0;
+}
 
-  // now merge in all other arguments
-  for (size_t i = 1; i < n; ++i) {
-    Json param(parameters.extractArrayMember(trx, collection, i, false));
+////////////////////////////////////////////////////////////////////////////////
+/// @brief find the last occurrence of search in value, like JavaScript's
+/// String.prototype.lastIndexOf() does
+////////////////////////////////////////////////////////////////////////////////
 
-    if (! param.isObject()) {
-      RegisterInvalidArgumentWarning(query, "MERGE");
-      return AqlValue(new Json(Json::Null));
-    }
- 
-    auto merged = TRI_MergeJson(TRI_UNKNOWN_MEM_ZONE, result.get(), param.json(), false, true);
+static double LastIndexOf (std::vector<uint16_t> const& value,
+                           std::vector<uint16_t> const& search) {
+  if (search.size() > value.size()) {
+    return -1.0;
+  }
 
-    if (merged == nullptr) {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  for (size_t i = value.size() - search.size() + 1; i > 0; --i) {
+    if (std::equal(search.begin(), search.end(), value.begin() + (i - 1))) {
+      return static_cast<double>(i - 1);
     }
+  }
 
-    result.reset(merged);
-  } 
+  return -1.0;
+}
 
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
-  result.release();
-  return AqlValue(jr);
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not a code point is whitespace, as defined for the
+/// \s class in JavaScript regular expressions
+////////////////////////////////////////////////////////////////////////////////
+
+static bool IsWhitespace (uint32_t c) {
+  return ((c >= 0x09 && c <= 0x0D) ||
+          c == 0x20 ||
+          c == 0xA0 ||
+          c == 0x1680 ||
+          c == 0x180E ||
+          (c >= 0x2000 && c <= 0x200A) ||
+          c == 0x2028 ||
+          c == 0x2029 ||
+          c == 0x202F ||
+          c == 0x205F ||
+          c == 0x3000 ||
+          c == 0xFEFF);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function HAS
+/// @brief whether or not a code point is a line terminator. line terminators
+/// are not matched by the wildcards of LIKE()
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Has (triagens::aql::Query* query,
-                         triagens::arango::AqlTransaction* trx,
-                         TRI_document_collection_t const* collection,
-                         AqlValue const parameters) {
-  size_t const n = parameters.arraySize();
+static inline bool IsLineTerminator (uint32_t c) {
+  return (c == '\n' || c == '\r' || c == 0x2028 || c == 0x2029);
+}
 
-  if (n < 2) {
-    // no parameters
-    return AqlValue(new Json(false));
-  }
-    
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove characters from the start and/or end of a string. if no
+/// characters are specified, whitespace is removed
+////////////////////////////////////////////////////////////////////////////////
 
-  if (! value.isObject()) {
-    // not an object
-    return AqlValue(new Json(false));
+static std::string TrimString (std::string const& value,
+                               std::string const* chars,
+                               bool left,
+                               bool right) {
+  std::vector<uint16_t> units;
+  DecodeUtf16(value, units);
+
+  std::vector<uint16_t> remove;
+  if (chars != nullptr) {
+    DecodeUtf16(*chars, remove);
   }
- 
-  // process name parameter 
-  Json name(parameters.extractArrayMember(trx, collection, 1, false));
 
-  char const* p;
+  auto isRemovable = [&] (uint16_t c) -> bool {
+    if (chars == nullptr) {
+      return IsWhitespace(c);
+    }
+    return (std::find(remove.begin(), remove.end(), c) != remove.end());
+  };
 
-  if (! name.isString()) {
-    triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE);
-    AppendAsString(buffer, name.json());
-    p = buffer.c_str();
+  size_t start = 0;
+  size_t end = units.size();
+
+  if (left) {
+    while (start < end && isRemovable(units[start])) {
+      ++start;
+    }
   }
-  else {
-    p = name.json()->_value._string.data;
+  if (right) {
+    while (end > start && isRemovable(units[end - 1])) {
+      --end;
+    }
   }
- 
-  bool const hasAttribute = (TRI_LookupObjectJson(value.json(), p) != nullptr);
-  return AqlValue(new Json(hasAttribute));
+
+  return EncodeUtf16(units, start, end);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function ATTRIBUTES
+/// @brief a token of a LIKE pattern
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Attributes (triagens::aql::Query* query,
-                                triagens::arango::AqlTransaction* trx,
-                                TRI_document_collection_t const* collection,
-                                AqlValue const parameters) {
-  size_t const n = parameters.arraySize();
-
-  if (n < 1) {
-    // no parameters
-    return AqlValue(new Json(Json::Null));
-  }
-    
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
-
-  if (! value.isObject()) {
-    // not an object
-    RegisterWarning(query, "ATTRIBUTES", TRI_ERROR_QUERY_FUNCTION_ARGUMENT_TYPE_MISMATCH);
-    return AqlValue(new Json(Json::Null));
-  }
- 
-  bool const removeInternal = GetBooleanParameter(trx, collection, parameters, 1, false);
-  bool const doSort = GetBooleanParameter(trx, collection, parameters, 2, false);
+struct LikeToken {
+  enum TokenType {
+    LITERAL,
+    ANY_CHARACTER,
+    ANY_SEQUENCE
+  };
 
-  auto const valueJson = value.json();
-  TRI_ASSERT(TRI_IsObjectJson(valueJson));
+  TokenType type;
+  uint32_t  value;
+};
 
-  size_t const numValues = TRI_LengthVectorJson(valueJson);
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not a character has a special meaning in a regex
+////////////////////////////////////////////////////////////////////////////////
 
-  if (numValues == 0) {
-    // empty object
-    return AqlValue(new Json(Json::Object));
-  }
+static bool IsRegexSpecialCharacter (uint16_t c) {
+  return (c != 0 && c < 0x80 && strchr(".*+?^=!:${}()|[]/\\", static_cast<int>(c)) != nullptr);
+}
 
-  std::vector<std::pair<char const*, size_t>> sortPositions;
-  sortPositions.reserve(numValues / 2);
+////////////////////////////////////////////////////////////////////////////////
+/// @brief parse a LIKE pattern. % matches any sequence of characters, _ 
+/// matches any single character. both can be escaped with a backslash
+////////////////////////////////////////////////////////////////////////////////
 
-  // create a vector with positions into the object
-  for (size_t i = 0; i < numValues; i += 2) {
-    auto key = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, i));
+static void ParseLikePattern (std::vector<uint16_t> const& pattern,
+                              std::vector<LikeToken>& tokens) {
+  bool escaped = false;
 
-    if (! TRI_IsStringJson(key)) {
-      // somehow invalid
+  for (auto c : pattern) {
+    if (c == '\\') {
+      if (escaped) {
+        // literal backslash
+        tokens.push_back({ LikeToken::LITERAL, '\\' });
+      }
+      escaped = ! escaped;
       continue;
     }
 
-    if (removeInternal && *key->_value._string.data == '_') {
-      // skip attribute
-      continue;
+    if (c == '%' && ! escaped) {
+      if (tokens.empty() || tokens.back().type != LikeToken::ANY_SEQUENCE) {
+        tokens.push_back({ LikeToken::ANY_SEQUENCE, 0 });
+      }
+    }
+    else if (c == '_' && ! escaped) {
+      tokens.push_back({ LikeToken::ANY_CHARACTER, 0 });
+    }
+    else {
+      if (escaped && c != '%' && c != '_' && ! IsRegexSpecialCharacter(c)) {
+        // a backslash followed by no special character. a backslash 
+        // before a character with a special meaning in a regex is dropped
+        tokens.push_back({ LikeToken::LITERAL, '\\' });
+      }
+      tokens.push_back({ LikeToken::LITERAL, c });
     }
 
-    sortPositions.emplace_back(std::make_pair(key->_value._string.data, i));
+    escaped = false;
   }
+}
 
-  if (doSort) {
-    // sort according to attribute name
-    std::sort(sortPositions.begin(), sortPositions.end(), [] (std::pair<char const*, size_t> const& lhs,
-                                                              std::pair<char const*, size_t> const& rhs) -> bool {
-      return TRI_compare_utf8(lhs.first, rhs.first) < 0;
-    });
+////////////////////////////////////////////////////////////////////////////////
+/// @brief match a string against a parsed LIKE pattern
+////////////////////////////////////////////////////////////////////////////////
+
+static bool MatchLikePattern (std::vector<uint16_t> const& value,
+                              std::vector<LikeToken> const& tokens) {
+  size_t const n = value.size();
+
+  // matches[i] is true if the pattern processed so far matches the first
+  // i characters of the value
+  std::vector<char> matches(n + 1, 0);
+  std::vector<char> next(n + 1, 0);
+  matches[0] = 1;
+
+  for (auto const& token : tokens) {
+    if (token.type == LikeToken::ANY_SEQUENCE) {
+      next[0] = matches[0];
+      for (size_t i = 1; i <= n; ++i) {
+        next[i] = matches[i] || (next[i - 1] && ! IsLineTerminator(value[i - 1]));
+      }
+    }
+    else {
+      next[0] = 0;
+      for (size_t i = 1; i <= n; ++i) {
+        uint16_t const c = value[i - 1];
+        bool const charMatches = (token.type == LikeToken::ANY_CHARACTER) ? ! IsLineTerminator(c) : (c == token.value);
+        next[i] = (matches[i - 1] && charMatches);
+      }
+    }
+    matches.swap(next);
   }
 
-  // create the output
-  Json result(Json::Array, sortPositions.size());
+  return (matches[n] != 0);
+}
 
-  // iterate over either sorted or unsorted object 
-  for (auto const& it : sortPositions) {
-    auto key = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, it.second));
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of milliseconds per day
+////////////////////////////////////////////////////////////////////////////////
 
-    result.add(Json(std::string(key->_value._string.data, key->_value._string.length - 1)));
-  } 
+static double const MillisecondsPerDay = 86400000.0;
 
-  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of days since 1970-01-01 for a date of the proleptic 
+/// gregorian calendar
+////////////////////////////////////////////////////////////////////////////////
+
+static double DaysFromCivil (double year,
+                             double month,
+                             double day) {
+  // month is 1-based here
+  year -= (month <= 2 ? 1 : 0);
+  double const era = std::floor(year / 400.0);
+  double const yoe = year - era * 400.0;
+  double const doy = std::floor((153.0 * (month + (month > 2 ? -3 : 9)) + 2.0) / 5.0) + day - 1.0;
+  double const doe = yoe * 365.0 + std::floor(yoe / 4.0) - std::floor(yoe / 100.0) + doy;
+  return era * 146097.0 + doe - 719468.0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function MIN
+/// @brief calculate year, month (1-based) and day from the number of days 
+/// since 1970-01-01
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Min (triagens::aql::Query* query,
-                         triagens::arango::AqlTransaction* trx,
-                         TRI_document_collection_t const* collection,
-                         AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+static void CivilFromDays (double days,
+                           double& year,
+                           double& month,
+                           double& day) {
+  days += 719468.0;
+  double const era = std::floor(days / 146097.0);
+  double const doe = days - era * 146097.0;
+  double const yoe = std::floor((doe - std::floor(doe / 1460.0) + std::floor(doe / 36524.0) - std::floor(doe / 146096.0)) / 365.0);
+  double const doy = doe - (365.0 * yoe + std::floor(yoe / 4.0) - std::floor(yoe / 100.0));
+  double const mp = std::floor((5.0 * doy + 2.0) / 153.0);
+
+  day = doy - std::floor((153.0 * mp + 2.0) / 5.0) + 1.0;
+  month = mp + (mp < 10 ? 3 : -9);
+  year = yoe + era * 400.0 + (month <= 2 ? 1 : 0);
+}
 
-  if (! value.isArray()) {
-    // not an array
-    RegisterWarning(query, "MIN", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-    return AqlValue(new Json(Json::Null));
+////////////////////////////////////////////////////////////////////////////////
+/// @brief make a timestamp from date components, like JavaScript's MakeDay
+/// and MakeTime do. month is 0-based and may overflow
+////////////////////////////////////////////////////////////////////////////////
+
+static double MakeTimestamp (double year,
+                             double month,
+                             double day,
+                             double hour,
+                             double minute,
+                             double second,
+                             double millisecond) {
+  if (std::isnan(year) || std::isnan(month) || std::isnan(day) ||
+      std::isnan(hour) || std::isnan(minute) || std::isnan(second) || std::isnan(millisecond)) {
+    return NAN;
   }
 
-  TRI_json_t const* valueJson = value.json();
-  size_t const n = TRI_LengthArrayJson(valueJson);
-  TRI_json_t const* minValue = nullptr;;
+  year = ToInteger(year);
+  month = ToInteger(month);
 
-  for (size_t i = 0; i < n; ++i) {
-    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+  double const ym = year + std::floor(month / 12.0);
+  double const mn = month - std::floor(month / 12.0) * 12.0;
 
-    if (TRI_IsNullJson(value)) {
-      continue;
-    }
+  double const days = DaysFromCivil(ym, mn + 1.0, 1.0) + ToInteger(day) - 1.0;
+  double const time = ToInteger(hour) * 3600000.0 + ToInteger(minute) * 60000.0 + ToInteger(second) * 1000.0 + ToInteger(millisecond);
 
-    if (minValue == nullptr ||
-        TRI_CompareValuesJson(value, minValue) < 0) {
-      minValue = value;
-    }
-  } 
+  double const result = days * MillisecondsPerDay + time;
 
-  if (minValue != nullptr) {
-    std::unique_ptr<TRI_json_t> result(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, minValue));
-    
-    if (result != nullptr) {
-      auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
-      result.release();
-      return AqlValue(jr);
-    }
+  // the valid range of JavaScript dates
+  if (std::isnan(result) || std::fabs(result) > 8.64e15) {
+    return NAN;
   }
-
-  return AqlValue(new Json(Json::Null));
+  return ToInteger(result);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function MAX
+/// @brief a token of a date string
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Max (triagens::aql::Query* query,
-                         triagens::arango::AqlTransaction* trx,
-                         TRI_document_collection_t const* collection,
-                         AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+struct DateToken {
+  enum TokenType {
+    END_OF_INPUT,
+    INVALID,
+    NUMBER,
+    SYMBOL,
+    WHITESPACE,
+    KEYWORD,
+    UNKNOWN
+  };
 
-  if (! value.isArray()) {
-    // not an array
-    RegisterWarning(query, "MAX", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-    return AqlValue(new Json(Json::Null));
-  }
+  enum KeywordType {
+    KEYWORD_INVALID,
+    KEYWORD_MONTH_NAME,
+    KEYWORD_TIME_ZONE_NAME,
+    KEYWORD_TIME_SEPARATOR,
+    KEYWORD_AM_PM
+  };
 
-  TRI_json_t const* valueJson = value.json();
-  size_t const n = TRI_LengthArrayJson(valueJson);
-  TRI_json_t const* maxValue = nullptr;;
+  TokenType   type;
+  int         value;     // number value, symbol character or keyword value
+  int         length;    // number of characters
+  KeywordType keyword;
 
-  for (size_t i = 0; i < n; ++i) {
-    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+  bool isNumber () const {
+    return type == NUMBER;
+  }
 
-    if (TRI_IsNullJson(value)) {
-      continue;
-    }
+  bool isFixedLengthNumber (int n) const {
+    return type == NUMBER && length == n;
+  }
 
-    if (maxValue == nullptr ||
-        TRI_CompareValuesJson(value, maxValue) > 0) {
-      maxValue = value;
-    }
-  } 
+  bool isSymbol (char c) const {
+    return type == SYMBOL && value == c;
+  }
 
-  if (maxValue != nullptr) {
-    std::unique_ptr<TRI_json_t> result(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, maxValue));
-    
-    if (result != nullptr) {
-      auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
-      result.release();
-      return AqlValue(jr);
-    }
+  bool isSign () const {
+    return isSymbol('+') || isSymbol('-');
   }
 
-  return AqlValue(new Json(Json::Null));
-}
+  int sign () const {
+    return (value == '-' ? -1 : 1);
+  }
+
+  bool isKeywordType (KeywordType t) const {
+    return type == KEYWORD && keyword == t;
+  }
+
+  bool isKeywordZ () const {
+    return isKeywordType(KEYWORD_TIME_ZONE_NAME) && length == 1 && value == 0;
+  }
+};
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function SUM
+/// @brief splits a date string into tokens, with one token lookahead. this
+/// is modelled after V8's date string tokenizer, so AQL accepts the same
+/// date strings as JavaScript's Date.parse()
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Sum (triagens::aql::Query* query,
-                         triagens::arango::AqlTransaction* trx,
-                         TRI_document_collection_t const* collection,
-                         AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
-
-  if (! value.isArray()) {
-    // not an array
-    RegisterWarning(query, "SUM", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-    return AqlValue(new Json(Json::Null));
-  }
+class DateTokenizer {
 
-  TRI_json_t const* valueJson = value.json();
-  size_t const n = TRI_LengthArrayJson(valueJson);
-  double sum = 0.0;
+  public:
 
-  for (size_t i = 0; i < n; ++i) {
-    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+    DateTokenizer (std::string const& value)
+      : _p(reinterpret_cast<unsigned char const*>(value.c_str())),
+        _e(_p + value.size()) {
+      _next = read();
+    }
 
-    if (TRI_IsNullJson(value)) {
-      continue;
+    DateToken next () {
+      DateToken result = _next;
+      _next = read();
+      return result;
     }
 
-    if (! TRI_IsNumberJson(value)) {
-      RegisterInvalidArgumentWarning(query, "SUM");
-      return AqlValue(new Json(Json::Null));
+    DateToken const& peek () const {
+      return _next;
     }
 
-    // got a numeric value
-    double const number = value->_value._number;
+    bool skipSymbol (char c) {
+      if (_next.isSymbol(c)) {
+        next();
+        return true;
+      }
+      return false;
+    }
 
-    if (! std::isnan(number) && number != HUGE_VAL && number != -HUGE_VAL) {
-      sum += number;
-    } 
-  } 
+  private:
 
-  if (! std::isnan(sum) && sum != HUGE_VAL && sum != -HUGE_VAL) {
-    return AqlValue(new Json(sum));
-  } 
+    static bool IsDigit (unsigned char c) {
+      return c >= '0' && c <= '9';
+    }
 
-  return AqlValue(new Json(Json::Null));
-}
+    static bool IsWhiteSpace (unsigned char c) {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
 
-////////////////////////////////////////////////////////////////////////////////
-/// @brief function AVERAGE
-////////////////////////////////////////////////////////////////////////////////
+    static DateToken Make (DateToken::TokenType type,
+                           int value,
+                           int length) {
+      return DateToken{ type, value, length, DateToken::KEYWORD_INVALID };
+    }
 
-AqlValue Functions::Average (triagens::aql::Query* query,
-                             triagens::arango::AqlTransaction* trx,
-                             TRI_document_collection_t const* collection,
-                             AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+    static DateToken Keyword (char const* prefix, 
+                              int length) {
+      static struct {
+        char                   name[4];
+        DateToken::KeywordType type;
+        int                    value;
+      } const Keywords[] = {
+        { "jan", DateToken::KEYWORD_MONTH_NAME, 1 },
+        { "feb", DateToken::KEYWORD_MONTH_NAME, 2 },
+        { "mar", DateToken::KEYWORD_MONTH_NAME, 3 },
+        { "apr", DateToken::KEYWORD_MONTH_NAME, 4 },
+        { "may", DateToken::KEYWORD_MONTH_NAME, 5 },
+        { "jun", DateToken::KEYWORD_MONTH_NAME, 6 },
+        { "jul", DateToken::KEYWORD_MONTH_NAME, 7 },
+        { "aug", DateToken::KEYWORD_MONTH_NAME, 8 },
+        { "sep", DateToken::KEYWORD_MONTH_NAME, 9 },
+        { "oct", DateToken::KEYWORD_MONTH_NAME, 10 },
+        { "nov", DateToken::KEYWORD_MONTH_NAME, 11 },
+        { "dec", DateToken::KEYWORD_MONTH_NAME, 12 },
+        { "am", DateToken::KEYWORD_AM_PM, 0 },
+        { "pm", DateToken::KEYWORD_AM_PM, 12 },
+        { "ut", DateToken::KEYWORD_TIME_ZONE_NAME, 0 },
+        { "utc", DateToken::KEYWORD_TIME_ZONE_NAME, 0 },
+        { "z", DateToken::KEYWORD_TIME_ZONE_NAME, 0 },
+        { "gmt", DateToken::KEYWORD_TIME_ZONE_NAME, 0 },
+        { "cdt", DateToken::KEYWORD_TIME_ZONE_NAME, -5 },
+        { "cst", DateToken::KEYWORD_TIME_ZONE_NAME, -6 },
+        { "edt", DateToken::KEYWORD_TIME_ZONE_NAME, -4 },
+        { "est", DateToken::KEYWORD_TIME_ZONE_NAME, -5 },
+        { "mdt", DateToken::KEYWORD_TIME_ZONE_NAME, -6 },
+        { "mst", DateToken::KEYWORD_TIME_ZONE_NAME, -7 },
+        { "pdt", DateToken::KEYWORD_TIME_ZONE_NAME, -7 },
+        { "pst", DateToken::KEYWORD_TIME_ZONE_NAME, -8 },
+        { "t", DateToken::KEYWORD_TIME_SEPARATOR, 0 }
+      };
+
+      for (auto const& it : Keywords) {
+        // words longer than the keyword are only allowed for month names
+        if (memcmp(it.name, prefix, 3) == 0 &&
+            (length <= 3 || it.type == DateToken::KEYWORD_MONTH_NAME)) {
+          return DateToken{ DateToken::KEYWORD, it.value, length, it.type };
+        }
+      }
+      return DateToken{ DateToken::KEYWORD, 0, length, DateToken::KEYWORD_INVALID };
+    }
 
-  if (! value.isArray()) {
-    // not an array
-    RegisterWarning(query, "AVERAGE", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-    return AqlValue(new Json(Json::Null));
-  }
+    DateToken read () {
+      if (_p >= _e) {
+        return Make(DateToken::END_OF_INPUT, 0, 0);
+      }
 
-  TRI_json_t const* valueJson = value.json();
-  size_t const n = TRI_LengthArrayJson(valueJson);
-  double sum = 0.0;
-  size_t count = 0;
+      unsigned char const c = *_p;
 
-  for (size_t i = 0; i < n; ++i) {
-    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+      if (IsDigit(c)) {
+        // only the first 9 digits are significant
+        int value = 0;
+        int length = 0;
+        while (_p < _e && IsDigit(*_p)) {
+          if (length < 9) {
+            value = value * 10 + (*_p - '0');
+          }
+          ++length;
+          ++_p;
+        }
+        return Make(DateToken::NUMBER, value, length);
+      }
 
-    if (TRI_IsNullJson(value)) {
-      continue;
-    }
+      if (c == ':' || c == '-' || c == '+' || c == '.' || c == ')') {
+        ++_p;
+        return Make(DateToken::SYMBOL, c, 1);
+      }
 
-    if (! TRI_IsNumberJson(value)) {
-      RegisterInvalidArgumentWarning(query, "AVERAGE");
-      return AqlValue(new Json(Json::Null));
-    }
+      if (c >= 'A') {
+        // a word. only its first three characters are significant
+        char prefix[3] = { 0, 0, 0 };
+        int length = 0;
+        while (_p < _e && *_p >= 'A') {
+          if (length < 3) {
+            prefix[length] = static_cast<char>(tolower(*_p));
+          }
+          ++length;
+          ++_p;
+        }
+        return Keyword(prefix, length);
+      }
 
-    // got a numeric value
-    double const number = value->_value._number;
+      if (IsWhiteSpace(c)) {
+        int length = 0;
+        while (_p < _e && IsWhiteSpace(*_p)) {
+          ++length;
+          ++_p;
+        }
+        return Make(DateToken::WHITESPACE, 0, length);
+      }
 
-    if (! std::isnan(number) && number != HUGE_VAL && number != -HUGE_VAL) {
-      sum += number;
-      ++count;
-    } 
-  } 
+      if (c == '(') {
+        // comments in parentheses are ignored
+        int balance = 0;
+        do {
+          if (*_p == ')') {
+            --balance;
+          }
+          else if (*_p == '(') {
+            ++balance;
+          }
+          ++_p;
+        }
+        while (balance > 0 && _p < _e);
+        return Make(DateToken::UNKNOWN, 0, 0);
+      }
 
-  if (count > 0 && 
-      ! std::isnan(sum) && sum != HUGE_VAL && sum != -HUGE_VAL) {
-    return AqlValue(new Json(sum / static_cast<size_t>(count)));
-  } 
+      ++_p;
+      return Make(DateToken::UNKNOWN, 0, 0);
+    }
 
-  return AqlValue(new Json(Json::Null));
-}
+    unsigned char const* _p;
+    unsigned char const* _e;
+    DateToken _next;
+};
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function MD5
+/// @brief value of a date component that has not been set
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Md5 (triagens::aql::Query* query,
-                         triagens::arango::AqlTransaction* trx,
-                         TRI_document_collection_t const* collection,
-                         AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
-    
-  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE);
-  AppendAsString(buffer, value.json());
-  
-  // create md5
-  char hash[17]; 
-  char* p = &hash[0];
-  size_t length;
+static int const DateNone = INT_MAX;
 
-  triagens::rest::SslInterface::sslMD5(buffer.c_str(), buffer.length(), p, length);
+////////////////////////////////////////////////////////////////////////////////
+/// @brief collects the day components of a date string
+////////////////////////////////////////////////////////////////////////////////
 
-  // as hex
-  char hex[33];
-  p = &hex[0];
+struct DateDayComposer {
+  int  comp[3];
+  int  index      = 0;
+  int  namedMonth = DateNone;
+  bool isIsoDate  = false;
 
-  triagens::rest::SslInterface::sslHEX(hash, 16, p, length);
+  static bool IsMonth (int x) {
+    return x >= 1 && x <= 12;
+  }
 
-  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, hex, 32));
-}
+  static bool IsDay (int x) {
+    return x >= 1 && x <= 31;
+  }
 
-////////////////////////////////////////////////////////////////////////////////
-/// @brief function SHA1
-////////////////////////////////////////////////////////////////////////////////
+  bool add (int n) {
+    if (index == 3) {
+      return false;
+    }
+    comp[index++] = n;
+    return true;
+  }
 
-AqlValue Functions::Sha1 (triagens::aql::Query* query,
-                          triagens::arango::AqlTransaction* trx,
-                          TRI_document_collection_t const* collection,
-                          AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
-    
-  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE);
-  AppendAsString(buffer, value.json());
-  
-  // create sha1
-  char hash[21];
-  char* p = &hash[0];
-  size_t length;
+  bool write (int& year, 
+              int& month, 
+              int& day) {
+    if (index < 1) {
+      return false;
+    }
 
-  triagens::rest::SslInterface::sslSHA1(buffer.c_str(), buffer.length(), p, length);
+    // day and month default to 1
+    while (index < 3) {
+      comp[index++] = 1;
+    }
 
-  // as hex
-  char hex[41];
-  p = &hex[0];
+    // the default year is 0 (2000)
+    year = 0;
 
-  triagens::rest::SslInterface::sslHEX(hash, 20, p, length);
+    if (namedMonth == DateNone) {
+      if (isIsoDate || ! IsDay(comp[0])) {
+        year = comp[0]; 
+        month = comp[1]; 
+        day = comp[2];
+      }
+      else {
+        month = comp[0]; 
+        day = comp[1];
+        year = comp[2];
+      }
+    }
+    else {
+      month = namedMonth;
+      if (! IsDay(comp[0])) {
+        year = comp[0]; 
+        day = comp[1];
+      }
+      else {
+        day = comp[0]; 
+        year = comp[1];
+      }
+    }
 
-  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, hex, 40));
-}
+    if (! isIsoDate) {
+      if (year >= 0 && year <= 49) {
+        year += 2000;
+      }
+      else if (year >= 50 && year <= 99) {
+        year += 1900;
+      }
+    }
+
+    return IsMonth(month) && IsDay(day);
+  }
+};
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function UNIQUE
+/// @brief collects the time components of a date string
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Unique (triagens::aql::Query* query,
-                            triagens::arango::AqlTransaction* trx,
-                            TRI_document_collection_t const* collection,
-                            AqlValue const parameters) {
-  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+struct DateTimeComposer {
+  int comp[4];
+  int index      = 0;
+  int hourOffset = DateNone;
 
-  if (! value.isArray()) {
-    // not an array
-    RegisterWarning(query, "UNIQUE", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-    return AqlValue(new Json(Json::Null));
+  static bool IsHour (int x) {
+    return x >= 0 && x <= 23;
   }
 
-  TRI_json_t const* valueJson = value.json();
-  size_t const n = TRI_LengthArrayJson(valueJson);
+  static bool IsMinute (int x) {
+    return x >= 0 && x <= 59;
+  }
 
-  std::unordered_set<TRI_json_t const*, triagens::basics::JsonHash, triagens::basics::JsonEqual> values(
-    512, 
-    triagens::basics::JsonHash(), 
-    triagens::basics::JsonEqual()
-  );
+  static bool IsMillisecond (int x) {
+    return x >= 0 && x <= 999;
+  }
 
-  for (size_t i = 0; i < n; ++i) {
-    auto value = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, i));
+  bool isEmpty () const {
+    return index == 0;
+  }
 
-    if (value == nullptr) {
-      continue;
+  bool isExpecting (int n) const {
+    return (index == 1 && IsMinute(n)) || 
+           (index == 2 && IsMinute(n)) || 
+           (index == 3 && IsMillisecond(n));
+  }
+
+  bool add (int n) {
+    if (index == 4) {
+      return false;
     }
+    comp[index++] = n;
+    return true;
+  }
 
-    values.emplace(value); 
-  } 
+  bool addFinal (int n) {
+    if (! add(n)) {
+      return false;
+    }
+    while (index < 4) {
+      comp[index++] = 0;
+    }
+    return true;
+  }
 
-  std::unique_ptr<TRI_json_t> result(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, values.size()));
- 
-  for (auto const& it : values) {
-    auto copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, it);
+  bool write (int& hour,
+              int& minute,
+              int& second,
+              int& millisecond) {
+    // all time components default to 0
+    while (index < 4) {
+      comp[index++] = 0;
+    }
 
-    if (copy == nullptr) {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    hour = comp[0];
+    minute = comp[1];
+    second = comp[2];
+    millisecond = comp[3];
+
+    if (hourOffset != DateNone) {
+      if (hour < 0 || hour > 12) {
+        return false;
+      }
+      hour = hour % 12 + hourOffset;
     }
- 
-    TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), copy); 
+
+    if (! IsHour(hour) || ! IsMinute(minute) || ! IsMinute(second) || ! IsMillisecond(millisecond)) {
+      // 24:00:00.000 is allowed
+      return (hour == 24 && minute == 0 && second == 0 && millisecond == 0);
+    }
+    return true;
   }
-      
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
-  result.release();
-  return AqlValue(jr);
-}
+};
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function UNION
+/// @brief collects the timezone components of a date string
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Union (triagens::aql::Query* query,
-                           triagens::arango::AqlTransaction* trx,
-                           TRI_document_collection_t const* collection,
-                           AqlValue const parameters) {
-  std::unique_ptr<TRI_json_t> result(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, 16));
+struct DateTimeZoneComposer {
+  int sign   = DateNone;
+  int hour   = DateNone;
+  int minute = DateNone;
 
-  size_t const n = parameters.arraySize();
+  void set (int offsetInHours) {
+    sign = (offsetInHours < 0 ? -1 : 1);
+    hour = offsetInHours * sign;
+    minute = 0;
+  }
 
-  for (size_t i = 0; i < n; ++i) {
-    Json value(parameters.extractArrayMember(trx, collection, i, false));
+  bool isExpecting (int n) const {
+    return hour != DateNone && minute == DateNone && DateTimeComposer::IsMinute(n);
+  }
 
-    if (! value.isArray()) {
-      // not an array
-      RegisterWarning(query, "UNION", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-      return AqlValue(new Json(Json::Null));
-    }
+  bool isUTC () const {
+    return hour == 0 && minute == 0;
+  }
 
-    TRI_json_t const* valueJson = value.json();
-    size_t const nrValues = TRI_LengthArrayJson(valueJson);
+  bool isEmpty () const {
+    return hour == DateNone;
+  }
 
-    if (TRI_ReserveVector(&(result.get()->_value._objects), nrValues) != TRI_ERROR_NO_ERROR) {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
-    }
+  bool write (bool& hasOffset,
+              double& offset) {
+    hasOffset = (sign != DateNone);
 
-    TRI_IF_FAILURE("AqlFunctions::OutOfMemory1") {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+    if (hasOffset) {
+      offset = sign * ((hour == DateNone ? 0.0 : hour) * 3600000.0 + (minute == DateNone ? 0.0 : minute) * 60000.0);
     }
-    
-    // this passes ownership for the JSON contens into result
-    for (size_t j = 0; j < nrValues; ++j) {
-      TRI_json_t* copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, TRI_LookupArrayJson(valueJson, j));
+    return true;
+  }
+};
 
-      if (copy == nullptr) {
-        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
-      }
-    
-      TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), copy);
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read the milliseconds from the digits of a fraction
+////////////////////////////////////////////////////////////////////////////////
 
-      TRI_IF_FAILURE("AqlFunctions::OutOfMemory2") {
-        THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
-      }
-    } 
-  } 
-      
-  TRI_IF_FAILURE("AqlFunctions::OutOfMemory3") {
-    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+static int ReadMilliseconds (DateToken const& token) {
+  int number = token.value;
+  int length = std::min(token.length, 9);
+
+  if (length == 1) {
+    number *= 100;
+  }
+  else if (length == 2) {
+    number *= 10;
   }
 
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
-  result.release();
-  return AqlValue(jr);
+  while (length > 3) {
+    number /= 10;
+    --length;
+  }
+
+  return number;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function UNION_DISTINCT
+/// @brief parse an ES5 date time string (a subset of ISO 8601). returns the
+/// first token that could not be handled, which is an end-of-input token if
+/// the complete string was parsed
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::UnionDistinct (triagens::aql::Query* query,
-                                   triagens::arango::AqlTransaction* trx,
-                                   TRI_document_collection_t const* collection,
-                                   AqlValue const parameters) {
-  std::unordered_set<TRI_json_t*, triagens::basics::JsonHash, triagens::basics::JsonEqual> values(
-    512, 
-    triagens::basics::JsonHash(), 
-    triagens::basics::JsonEqual()
-  );
-
-  auto freeValues = [&values] () -> void {
-    for (auto& it : values) {
-      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it);
+static DateToken ParseIsoDateString (DateTokenizer& scanner,
+                                     DateDayComposer& day,
+                                     DateTimeComposer& time,
+                                     DateTimeZoneComposer& tz) {
+  DateToken const invalid{ DateToken::INVALID, 0, 0, DateToken::KEYWORD_INVALID };
+
+  // mandatory date: [('-'|'+')yy]yyyy['-'MM['-'DD]]
+  if (scanner.peek().isSign()) {
+    DateToken sign = scanner.next();
+    if (! scanner.peek().isFixedLengthNumber(6)) {
+      return sign;
     }
-  };
-
-  std::unique_ptr<TRI_json_t> result;
-  size_t const n = parameters.arraySize();
+    int const year = scanner.next().value;
+    if (sign.sign() < 0 && year == 0) {
+      return sign;
+    }
+    day.add(sign.sign() * year);
+  }
+  else if (scanner.peek().isFixedLengthNumber(4)) {
+    day.add(scanner.next().value);
+  }
+  else {
+    return scanner.next();
+  }
 
-  try {
-    for (size_t i = 0; i < n; ++i) {
-      Json value(parameters.extractArrayMember(trx, collection, i, false));
+  if (scanner.skipSymbol('-')) {
+    if (! scanner.peek().isFixedLengthNumber(2) || 
+        ! DateDayComposer::IsMonth(scanner.peek().value)) {
+      return scanner.next();
+    }
+    day.add(scanner.next().value);
 
-      if (! value.isArray()) {
-        // not an array
-        freeValues();
-        RegisterWarning(query, "UNION_DISTINCT", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-        return AqlValue(new Json(Json::Null));
+    if (scanner.skipSymbol('-')) {
+      if (! scanner.peek().isFixedLengthNumber(2) || 
+          ! DateDayComposer::IsDay(scanner.peek().value)) {
+        return scanner.next();
       }
+      day.add(scanner.next().value);
+    }
+  }
 
-      TRI_json_t const* valueJson = value.json();
-      size_t const nrValues = TRI_LengthArrayJson(valueJson);
+  // optional time: 'T'HH':'mm[':'ss['.'sss]][tz]
+  if (! scanner.peek().isKeywordType(DateToken::KEYWORD_TIME_SEPARATOR)) {
+    if (scanner.peek().type != DateToken::END_OF_INPUT) {
+      return scanner.next();
+    }
+  }
+  else {
+    scanner.next();
 
-      for (size_t j = 0; j < nrValues; ++j) {
-        auto value = static_cast<TRI_json_t*>(TRI_AddressVector(&valueJson->_value._objects, j));
+    if (! scanner.peek().isFixedLengthNumber(2) ||
+        scanner.peek().value > 24) {
+      return invalid;
+    }
+    // 24:00[:00[.000]] is allowed, but no other time starting with 24
+    bool const hourIs24 = (scanner.peek().value == 24);
+    time.add(scanner.next().value);
 
-        if (values.find(value) == values.end()) { 
-          std::unique_ptr<TRI_json_t> copy(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value));
+    if (! scanner.skipSymbol(':')) {
+      return invalid;
+    }
+    if (! scanner.peek().isFixedLengthNumber(2) ||
+        ! DateTimeComposer::IsMinute(scanner.peek().value) ||
+        (hourIs24 && scanner.peek().value > 0)) {
+      return invalid;
+    }
+    time.add(scanner.next().value);
 
-          if (copy == nullptr) {
-            THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
-          }
-      
-          TRI_IF_FAILURE("AqlFunctions::OutOfMemory1") {
-            THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
-          }
+    if (scanner.skipSymbol(':')) {
+      if (! scanner.peek().isFixedLengthNumber(2) ||
+          ! DateTimeComposer::IsMinute(scanner.peek().value) ||
+          (hourIs24 && scanner.peek().value > 0)) {
+        return invalid;
+      }
+      time.add(scanner.next().value);
 
-          values.emplace(copy.get());
-          copy.release();
+      if (scanner.skipSymbol('.')) {
+        if (! scanner.peek().isNumber() ||
+            (hourIs24 && scanner.peek().value > 0)) {
+          return invalid;
         }
+        // more or less than three digits are allowed
+        time.add(ReadMilliseconds(scanner.next()));
       }
     }
 
-    result.reset(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, values.size()));
-
-    if (result == nullptr) {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    // optional timezone: 'Z' | ('+'|'-')hh':'mm | ('+'|'-')hhmm
+    if (scanner.peek().isKeywordZ()) {
+      scanner.next();
+      tz.set(0);
     }
-          
-    TRI_IF_FAILURE("AqlFunctions::OutOfMemory2") {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
-    }
-   
-    for (auto const& it : values) {
-      TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), it); 
+    else if (scanner.peek().isSign()) {
+      tz.sign = scanner.next().sign();
+
+      if (scanner.peek().isFixedLengthNumber(4)) {
+        int const value = scanner.next().value;
+        if (! DateTimeComposer::IsHour(value / 100) || 
+            ! DateTimeComposer::IsMinute(value % 100)) {
+          return invalid;
+        }
+        tz.hour = value / 100;
+        tz.minute = value % 100;
+      }
+      else {
+        if (! scanner.peek().isFixedLengthNumber(2) ||
+            ! DateTimeComposer::IsHour(scanner.peek().value)) {
+          return invalid;
+        }
+        tz.hour = scanner.next().value;
+        if (! scanner.skipSymbol(':')) {
+          return invalid;
+        }
+        if (! scanner.peek().isFixedLengthNumber(2) ||
+            ! DateTimeComposer::IsMinute(scanner.peek().value)) {
+          return invalid;
+        }
+        tz.minute = scanner.next().value;
+      }
     }
 
+    if (scanner.peek().type != DateToken::END_OF_INPUT) {
+      return invalid;
+    }
   }
-  catch (...) {  
-    freeValues();
-    throw;
-  }
-    
-  TRI_IF_FAILURE("AqlFunctions::OutOfMemory3") {
-    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+
+  // ISO dates without a timezone are interpreted as UTC
+  if (tz.isEmpty()) {
+    tz.set(0);
   }
-      
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
-  result.release();
-  return AqlValue(jr);
+  day.isIsoDate = true;
+
+  return DateToken{ DateToken::END_OF_INPUT, 0, 0, DateToken::KEYWORD_INVALID };
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief function INTERSECTION
+/// @brief the offset of the local timezone from UTC at the given time
 ////////////////////////////////////////////////////////////////////////////////
 
-AqlValue Functions::Intersection (triagens::aql::Query* query,
-                                  triagens::arango::AqlTransaction* trx,
-                                  TRI_document_collection_t const* collection,
-                                  AqlValue const parameters) {
-  std::unordered_map<TRI_json_t*, size_t, triagens::basics::JsonHash, triagens::basics::JsonEqual> values(
-    512, 
-    triagens::basics::JsonHash(), 
-    triagens::basics::JsonEqual()
-  );
+static double LocalTimezoneOffset (double timestamp) {
+  time_t const seconds = static_cast<time_t>(std::floor(timestamp / 1000.0));
 
-  auto freeValues = [&values] () -> void {
-    for (auto& it : values) {
-      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it.first);
-    }
-    values.clear();
-  };
+  struct tm local;
+  TRI_localtime(seconds, &local);
 
-  std::unique_ptr<TRI_json_t> result;
-  size_t const n = parameters.arraySize();
+  double const days = DaysFromCivil(local.tm_year + 1900.0, local.tm_mon + 1.0, local.tm_mday);
+  double const localTime = days * MillisecondsPerDay + (local.tm_hour * 3600.0 + local.tm_min * 60.0 + local.tm_sec) * 1000.0;
 
-  try {
-    for (size_t i = 0; i < n; ++i) {
-      Json value(parameters.extractArrayMember(trx, collection, i, false));
+  return localTime - static_cast<double>(seconds) * 1000.0;
+}
 
-      if (! value.isArray()) {
-        // not an array
-        freeValues();
-        RegisterWarning(query, "INTERSECTION", TRI_ERROR_QUERY_ARRAY_EXPECTED);
-        return AqlValue(new Json(Json::Null));
-      }
+////////////////////////////////////////////////////////////////////////////////
+/// @brief parse a date string into a timestamp, like JavaScript's Date.parse()
+/// does. ISO 8601 dates without a timezone are interpreted as UTC, all other 
+/// dates without a timezone are interpreted as local time. returns NaN for 
+/// invalid dates
+////////////////////////////////////////////////////////////////////////////////
 
-      TRI_json_t const* valueJson = value.json();
-      size_t const nrValues = TRI_LengthArrayJson(valueJson);
+static double ParseDateString (std::string const& value) {
+  DateTokenizer scanner(value);
+  DateDayComposer day;
+  DateTimeComposer time;
+  DateTimeZoneComposer tz;
 
-      for (size_t j = 0; j < nrValues; ++j) {
-        auto value = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, j));
+  DateToken token = ParseIsoDateString(scanner, day, time, tz);
 
-        if (i == 0) {
-          // round one
-          std::unique_ptr<TRI_json_t> copy(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value));
+  if (token.type == DateToken::INVALID) {
+    return NAN;
+  }
 
-          if (copy == nullptr) {
-            THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
-          }
-    
-          TRI_IF_FAILURE("AqlFunctions::OutOfMemory1") {
-            THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
-          }
+  // anything left is handled by the legacy parser
+  bool hasReadNumber = (day.index > 0);
 
-          auto r = values.emplace(copy.get(), 1);
- 
-          if (r.second) {
-            // successfully inserted
-            copy.release();
+  for (; token.type != DateToken::END_OF_INPUT; token = scanner.next()) {
+    if (token.isNumber()) {
+      hasReadNumber = true;
+      int const n = token.value;
+
+      if (scanner.skipSymbol(':')) {
+        if (scanner.skipSymbol(':')) {
+          // n + "::"
+          if (! time.isEmpty()) {
+            return NAN;
           }
+          time.add(n);
+          time.add(0);
         }
         else {
-          // check if we have seen the same element before
-          auto it = values.find(const_cast<TRI_json_t*>(value));
-
-          if (it != values.end()) {
-            // already seen
-            TRI_ASSERT((*it).second > 0);
-            ++((*it).second);
+          // n + ":"
+          if (! time.add(n)) {
+            return NAN;
           }
+          if (scanner.peek().isSymbol('.')) {
+            scanner.next();
+          }
+        }
+      }
+      else if (scanner.skipSymbol('.') && time.isExpecting(n)) {
+        time.add(n);
+        if (! scanner.peek().isNumber()) {
+          return NAN;
+        }
+        time.addFinal(ReadMilliseconds(scanner.next()));
+      }
+      else if (tz.isExpecting(n)) {
+        tz.minute = n;
+      }
+      else if (time.isExpecting(n)) {
+        time.addFinal(n);
+      }
+      else {
+        if (! day.add(n)) {
+          return NAN;
         }
+        scanner.skipSymbol('-');
       }
     }
- 
-    // count how many valid we have 
-    size_t total = 0;
+    else if (token.type == DateToken::KEYWORD) {
+      if (token.keyword == DateToken::KEYWORD_AM_PM && ! time.isEmpty()) {
+        time.hourOffset = token.value;
+      }
+      else if (token.keyword == DateToken::KEYWORD_MONTH_NAME) {
+        day.namedMonth = token.value;
+        scanner.skipSymbol('-');
+      }
+      else if (token.keyword == DateToken::KEYWORD_TIME_ZONE_NAME && hasReadNumber) {
+        tz.set(token.value);
+      }
+      else {
+        // garbage words are illegal after a number, and must be separated 
+        // from the first number
+        if (hasReadNumber || scanner.peek().isNumber()) {
+          return NAN;
+        }
+      }
+    }
+    else if (token.isSign() && (tz.isUTC() || ! time.isEmpty())) {
+      // a UTC offset, only after UTC or a time. the number is optional
+      tz.sign = token.sign();
+      int n = 0;
+      if (scanner.peek().isNumber()) {
+        n = scanner.next().value;
+      }
+      hasReadNumber = true;
 
-    for (auto const& it : values) {
-      if (it.second == n) {
-        ++total;
+      if (scanner.peek().isSymbol(':')) {
+        tz.hour = n;
+        tz.minute = DateNone;
+      }
+      else {
+        tz.hour = n / 100;
+        tz.minute = n % 100;
       }
     }
+    else if ((token.isSign() || token.isSymbol(')')) && hasReadNumber) {
+      // an extra sign or ')' is illegal after a number
+      return NAN;
+    }
+    // all other characters and whitespace are ignored
+  }
 
-    result.reset(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, total));
+  int year, month, dayOfMonth, hour, minute, second, millisecond;
+  bool hasOffset;
+  double offset = 0.0;
 
-    if (result == nullptr) {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  if (! day.write(year, month, dayOfMonth) ||
+      ! time.write(hour, minute, second, millisecond) ||
+      ! tz.write(hasOffset, offset)) {
+    return NAN;
+  }
+
+  double result = MakeTimestamp(year, month - 1.0, dayOfMonth, hour, minute, second, millisecond);
+
+  if (std::isnan(result)) {
+    return NAN;
+  }
+
+  if (hasOffset) {
+    result -= offset;
+  }
+  else {
+    // local time
+    result -= LocalTimezoneOffset(result - LocalTimezoneOffset(result));
+  }
+
+  if (std::fabs(result) > 8.64e15) {
+    return NAN;
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a timestamp from the arguments of a date function. returns
+/// false if the function must return null. the timestamp might be NaN if the
+/// arguments do not represent a valid date
+////////////////////////////////////////////////////////////////////////////////
+
+static bool MakeDate (triagens::aql::Query* query,
+                      triagens::arango::AqlTransaction* trx,
+                      TRI_document_collection_t const* collection,
+                      AqlValue const& parameters,
+                      char const* functionName,
+                      double& timestamp) {
+  size_t const n = parameters.arraySize();
+
+  if (n == 1) {
+    Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+    if (value.isNumber()) {
+      double const number = value.json()->_value._number;
+
+      if (std::isnan(number) || std::fabs(number) > 8.64e15) {
+        timestamp = NAN;
+      }
+      else {
+        timestamp = ToInteger(number);
+      }
+      return true;
     }
-          
-    TRI_IF_FAILURE("AqlFunctions::OutOfMemory2") {
-      THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+
+    if (! value.isString()) {
+      RegisterInvalidArgumentWarning(query, functionName);
+      return false;
     }
-   
-    for (auto& it : values) {
-      if (it.second == n) {
-        TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), it.first); 
+
+    TRI_json_t const* json = value.json();
+    timestamp = ParseDateString(std::string(json->_value._string.data, json->_value._string.length - 1));
+    return true;
+  }
+
+  if (n < 3) {
+    query->registerWarning(TRI_ERROR_QUERY_FUNCTION_ARGUMENT_NUMBER_MISMATCH, 
+                           triagens::basics::Exception::FillExceptionString(TRI_ERROR_QUERY_FUNCTION_ARGUMENT_NUMBER_MISMATCH, functionName, 3, 7).c_str());
+    return false;
+  }
+
+  // year, month, day, hour, minute, second, millisecond
+  double components[7] = { 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0 };
+
+  for (size_t i = 0; i < n; ++i) {
+    Json value(parameters.extractArrayMember(trx, collection, i, false));
+    double number;
+
+    if (value.isNull()) {
+      number = 0.0;
+    }
+    else {
+      if (value.isString()) {
+        // parse the leading integer of the string
+        char const* p = value.json()->_value._string.data;
+        char* end;
+        errno = 0;
+        double const parsed = static_cast<double>(strtoll(p, &end, 10));
+        number = (end == p || errno != 0) ? NAN : parsed;
+      }
+      else if (value.isNumber()) {
+        number = value.json()->_value._number;
       }
       else {
-        TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it.first);
+        RegisterInvalidArgumentWarning(query, functionName);
+        return false;
+      }
+
+      if (number < 0.0) {
+        RegisterWarning(query, functionName, TRI_ERROR_QUERY_INVALID_DATE_VALUE);
+        return false;
+      }
+
+      if (i == 1) {
+        // months are 1-based in AQL
+        number -= 1.0;
       }
     }
-    values.clear();
-   
-  } 
-  catch (...) {
-    freeValues();
-    throw;
+
+    if (i < 7) {
+      components[i] = number;
+    }
   }
-    
-  TRI_IF_FAILURE("AqlFunctions::OutOfMemory3") {
-    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+
+  double year = components[0];
+  if (! std::isnan(year)) {
+    double const y = ToInteger(year);
+    if (y >= 0.0 && y <= 99.0) {
+      // two-digit years are interpreted as 1900 + year
+      year = 1900.0 + y;
+    }
   }
+
+  timestamp = MakeTimestamp(year, components[1], components[2], components[3], components[4], components[5], components[6]);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a date component of the date specified in the first argument
+////////////////////////////////////////////////////////////////////////////////
+
+static AqlValue DateComponent (triagens::aql::Query* query,
+                               triagens::arango::AqlTransaction* trx,
+                               TRI_document_collection_t const* collection,
+                               AqlValue const& parameters,
+                               char const* functionName,
+                               std::function<double(double, double)> const& extract) {
+  double timestamp;
+
+  if (! MakeDate(query, trx, collection, parameters, functionName, timestamp) ||
+      std::isnan(timestamp)) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  double const days = std::floor(timestamp / MillisecondsPerDay);
+  double const time = timestamp - days * MillisecondsPerDay;
+
+  return NumberResult(extract(days, time));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function IS_NULL
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::IsNull (triagens::aql::Query*, 
+                            triagens::arango::AqlTransaction* trx,
+                            TRI_document_collection_t const* collection,
+                            AqlValue const parameters) {
+  Json j(parameters.extractArrayMember(trx, collection, 0, false));
+  return AqlValue(new Json(j.isNull()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function IS_BOOL
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::IsBool (triagens::aql::Query*,
+                            triagens::arango::AqlTransaction* trx,
+                            TRI_document_collection_t const* collection,
+                            AqlValue const parameters) {
+  Json j(parameters.extractArrayMember(trx, collection, 0, false));
+  return AqlValue(new Json(j.isBoolean()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function IS_NUMBER
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::IsNumber (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  Json j(parameters.extractArrayMember(trx, collection, 0, false));
+  return AqlValue(new Json(j.isNumber()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function IS_STRING
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::IsString (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  Json j(parameters.extractArrayMember(trx, collection, 0, false));
+  return AqlValue(new Json(j.isString()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function IS_ARRAY
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::IsArray (triagens::aql::Query*,
+                             triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const parameters) {
+  Json j(parameters.extractArrayMember(trx, collection, 0, false));
+  return AqlValue(new Json(j.isArray()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function IS_OBJECT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::IsObject (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  Json j(parameters.extractArrayMember(trx, collection, 0, false));
+  return AqlValue(new Json(j.isObject()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function LENGTH
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Length (triagens::aql::Query*,
+                            triagens::arango::AqlTransaction* trx,
+                            TRI_document_collection_t const* collection,
+                            AqlValue const parameters) {
+  Json j(parameters.extractArrayMember(trx, collection, 0, false));
+
+  TRI_json_t const* json = j.json();
+  size_t length = 0;
+
+  if (json != nullptr) {
+    switch (json->_type) {
+      case TRI_JSON_UNUSED:
+      case TRI_JSON_NULL: {
+        length = 0;
+        break;
+      }
+
+      case TRI_JSON_BOOLEAN: {
+        length = (json->_value._boolean ? 1 : 0);
+        break;
+      }
+
+      case TRI_JSON_NUMBER: {
+        if (std::isnan(json->_value._number) ||
+            ! std::isfinite(json->_value._number)) {
+          // invalid value
+          length = strlen("null");
+        }
+        else {
+          // convert to a string representation of the number
+          char buffer[24];
+          length = static_cast<size_t>(fpconv_dtoa(json->_value._number, buffer));
+        }
+        break;
+      }
+
+      case TRI_JSON_STRING:
+      case TRI_JSON_STRING_REFERENCE: {
+        // return number of UTF-16 code units (not bytes) in string
+        length = Utf16Length(json->_value._string.data, json->_value._string.length - 1);
+        break;
+      }
+
+      case TRI_JSON_OBJECT: {
+        // return number of attributes
+        length = TRI_LengthVector(&json->_value._objects) / 2;
+        break;
+      }
+
+      case TRI_JSON_ARRAY: {
+        // return list length
+        length = TRI_LengthArrayJson(json);
+        break;
+      }
+    }
+  }
+
+  return AqlValue(new Json(static_cast<double>(length)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function CONCAT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Concat (triagens::aql::Query*,
+                            triagens::arango::AqlTransaction* trx,
+                            TRI_document_collection_t const* collection,
+                            AqlValue const parameters) {
+  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE, 24);
+
+  size_t const n = parameters.arraySize();
+
+  for (size_t i = 0; i < n; ++i) {
+    Json member = parameters.at(trx, i);
+
+    if (member.isEmpty() || member.isNull()) {
+      continue;
+    }
       
-  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
-  result.release();
+    TRI_json_t const* json = member.json();
+    
+    if (member.isArray()) {
+      // append each member individually
+      size_t const subLength = TRI_LengthArrayJson(json);
+
+      for (size_t j = 0; j < subLength; ++j) {
+        auto sub = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, j));
+
+        if (sub == nullptr || sub->_type == TRI_JSON_NULL) {
+          continue;
+        }
+
+        AppendAsString(buffer, sub);
+      }
+    }
+    else {
+      // convert member to a string and append
+      AppendAsString(buffer, json);
+    }
+  }
+  
+  // steal the StringBuffer's char* pointer so we can avoid copying data around
+  // multiple times
+  size_t length = buffer.length();
+  std::unique_ptr<TRI_json_t> j(TRI_CreateStringJson(TRI_UNKNOWN_MEM_ZONE, buffer.steal(), length));
+
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.get());
+  j.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function PASSTHRU
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Passthru (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+
+  Json j(parameters.extractArrayMember(trx, collection, 0, true));
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.json());
+  j.steal();
   return AqlValue(jr);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function UNSET
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Unset (triagens::aql::Query* query,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isObject()) {
+    RegisterInvalidArgumentWarning(query, "UNSET");
+    return AqlValue(new Json(Json::Null));
+  }
+ 
+  std::unordered_set<std::string> names;
+  ExtractKeys(names, query, trx, collection, parameters, 1, "UNSET");
+
+
+  // create result object
+  TRI_json_t const* valueJson = value.json();
+  size_t const n = TRI_LengthVector(&valueJson->_value._objects);
+
+  size_t size;
+  if (names.size() >= n / 2) {
+    size = 4; 
+  }
+  else {
+    size = (n / 2) - names.size(); 
+  }
+
+  std::unique_ptr<TRI_json_t> j(TRI_CreateObjectJson(TRI_UNKNOWN_MEM_ZONE, size));
+
+  if (j == nullptr) {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  }
+
+  for (size_t i = 0; i < n; i += 2) {
+    auto key = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i + 1));
+
+    if (TRI_IsStringJson(key) && 
+        names.find(key->_value._string.data) == names.end()) {
+      auto copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value);
+
+      if (copy == nullptr) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+      } 
+
+      TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, j.get(), key->_value._string.data, copy);
+    }
+  } 
+
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.get());
+  j.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function KEEP
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Keep (triagens::aql::Query* query,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isObject()) {
+    RegisterInvalidArgumentWarning(query, "KEEP");
+    return AqlValue(new Json(Json::Null));
+  }
+ 
+  std::unordered_set<std::string> names;
+  ExtractKeys(names, query, trx, collection, parameters, 1, "KEEP");
+
+
+  // create result object
+  std::unique_ptr<TRI_json_t> j(TRI_CreateObjectJson(TRI_UNKNOWN_MEM_ZONE, names.size()));
+
+  if (j == nullptr) {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  }
+
+  TRI_json_t const* valueJson = value.json();
+  size_t const n = TRI_LengthVector(&valueJson->_value._objects);
+
+  for (size_t i = 0; i < n; i += 2) {
+    auto key = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i + 1));
+
+    if (TRI_IsStringJson(key) && 
+        names.find(key->_value._string.data) != names.end()) {
+      auto copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value);
+
+      if (copy == nullptr) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+      } 
+
+      TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, j.get(), key->_value._string.data, copy);
+    }
+  } 
+
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.get());
+  j.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function MERGE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Merge (triagens::aql::Query* query,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  if (n == 0) {
+    // no parameters
+    return AqlValue(new Json(Json::Object));
+  }
+
+  // use the first argument as the preliminary result
+  Json initial(parameters.extractArrayMember(trx, collection, 0, true));
+
+  if (! initial.isObject()) {
+    RegisterInvalidArgumentWarning(query, "MERGE");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  std::unique_ptr<TRI_json_t> result(initial.steal());
+
+  // now merge in all other arguments
+  for (size_t i = 1; i < n; ++i) {
+    Json param(parameters.extractArrayMember(trx, collection, i, false));
+
+    if (! param.isObject()) {
+      RegisterInvalidArgumentWarning(query, "MERGE");
+      return AqlValue(new Json(Json::Null));
+    }
+ 
+    auto merged = TRI_MergeJson(TRI_UNKNOWN_MEM_ZONE, result.get(), param.json(), false, true);
+
+    if (merged == nullptr) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    }
+
+    result.reset(merged);
+  } 
+
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
+  result.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function HAS
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Has (triagens::aql::Query* query,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  if (n < 2) {
+    // no parameters
+    return AqlValue(new Json(false));
+  }
+    
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isObject()) {
+    // not an object
+    return AqlValue(new Json(false));
+  }
+ 
+  // process name parameter 
+  Json name(parameters.extractArrayMember(trx, collection, 1, false));
+
+  char const* p;
+
+  if (! name.isString()) {
+    triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE);
+    AppendAsString(buffer, name.json());
+    p = buffer.c_str();
+  }
+  else {
+    p = name.json()->_value._string.data;
+  }
+ 
+  bool const hasAttribute = (TRI_LookupObjectJson(value.json(), p) != nullptr);
+  return AqlValue(new Json(hasAttribute));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function ATTRIBUTES
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Attributes (triagens::aql::Query* query,
+                                triagens::arango::AqlTransaction* trx,
+                                TRI_document_collection_t const* collection,
+                                AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  if (n < 1) {
+    // no parameters
+    return AqlValue(new Json(Json::Null));
+  }
+    
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isObject()) {
+    // not an object
+    RegisterWarning(query, "ATTRIBUTES", TRI_ERROR_QUERY_FUNCTION_ARGUMENT_TYPE_MISMATCH);
+    return AqlValue(new Json(Json::Null));
+  }
+ 
+  bool const removeInternal = GetBooleanParameter(trx, collection, parameters, 1, false);
+  bool const doSort = GetBooleanParameter(trx, collection, parameters, 2, false);
+
+  auto const valueJson = value.json();
+  TRI_ASSERT(TRI_IsObjectJson(valueJson));
+
+  size_t const numValues = TRI_LengthVectorJson(valueJson);
+
+  if (numValues == 0) {
+    // empty object
+    return AqlValue(new Json(Json::Object));
+  }
+
+  std::vector<std::pair<char const*, size_t>> sortPositions;
+  sortPositions.reserve(numValues / 2);
+
+  // create a vector with positions into the object
+  for (size_t i = 0; i < numValues; i += 2) {
+    auto key = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, i));
+
+    if (! TRI_IsStringJson(key)) {
+      // somehow invalid
+      continue;
+    }
+
+    if (removeInternal && *key->_value._string.data == '_') {
+      // skip attribute
+      continue;
+    }
+
+    sortPositions.emplace_back(std::make_pair(key->_value._string.data, i));
+  }
+
+  if (doSort) {
+    // sort according to attribute name
+    std::sort(sortPositions.begin(), sortPositions.end(), [] (std::pair<char const*, size_t> const& lhs,
+                                                              std::pair<char const*, size_t> const& rhs) -> bool {
+      return TRI_compare_utf8(lhs.first, rhs.first) < 0;
+    });
+  }
+
+  // create the output
+  Json result(Json::Array, sortPositions.size());
+
+  // iterate over either sorted or unsorted object 
+  for (auto const& it : sortPositions) {
+    auto key = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, it.second));
+
+    result.add(Json(std::string(key->_value._string.data, key->_value._string.length - 1)));
+  } 
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function MIN
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Min (triagens::aql::Query* query,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    // not an array
+    RegisterWarning(query, "MIN", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* valueJson = value.json();
+  size_t const n = TRI_LengthArrayJson(valueJson);
+  TRI_json_t const* minValue = nullptr;;
+
+  for (size_t i = 0; i < n; ++i) {
+    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+
+    if (TRI_IsNullJson(value)) {
+      continue;
+    }
+
+    if (minValue == nullptr ||
+        TRI_CompareValuesJson(value, minValue) < 0) {
+      minValue = value;
+    }
+  } 
+
+  if (minValue != nullptr) {
+    std::unique_ptr<TRI_json_t> result(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, minValue));
+    
+    if (result != nullptr) {
+      auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
+      result.release();
+      return AqlValue(jr);
+    }
+  }
+
+  return AqlValue(new Json(Json::Null));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function MAX
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Max (triagens::aql::Query* query,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    // not an array
+    RegisterWarning(query, "MAX", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* valueJson = value.json();
+  size_t const n = TRI_LengthArrayJson(valueJson);
+  TRI_json_t const* maxValue = nullptr;;
+
+  for (size_t i = 0; i < n; ++i) {
+    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+
+    if (TRI_IsNullJson(value)) {
+      continue;
+    }
+
+    if (maxValue == nullptr ||
+        TRI_CompareValuesJson(value, maxValue) > 0) {
+      maxValue = value;
+    }
+  } 
+
+  if (maxValue != nullptr) {
+    std::unique_ptr<TRI_json_t> result(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, maxValue));
+    
+    if (result != nullptr) {
+      auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
+      result.release();
+      return AqlValue(jr);
+    }
+  }
+
+  return AqlValue(new Json(Json::Null));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SUM
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Sum (triagens::aql::Query* query,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    // not an array
+    RegisterWarning(query, "SUM", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* valueJson = value.json();
+  size_t const n = TRI_LengthArrayJson(valueJson);
+  double sum = 0.0;
+
+  for (size_t i = 0; i < n; ++i) {
+    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+
+    if (TRI_IsNullJson(value)) {
+      continue;
+    }
+
+    if (! TRI_IsNumberJson(value)) {
+      RegisterInvalidArgumentWarning(query, "SUM");
+      return AqlValue(new Json(Json::Null));
+    }
+
+    // got a numeric value
+    double const number = value->_value._number;
+
+    if (! std::isnan(number) && number != HUGE_VAL && number != -HUGE_VAL) {
+      sum += number;
+    } 
+  } 
+
+  if (! std::isnan(sum) && sum != HUGE_VAL && sum != -HUGE_VAL) {
+    return AqlValue(new Json(sum));
+  } 
+
+  return AqlValue(new Json(Json::Null));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function AVERAGE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Average (triagens::aql::Query* query,
+                             triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    // not an array
+    RegisterWarning(query, "AVERAGE", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* valueJson = value.json();
+  size_t const n = TRI_LengthArrayJson(valueJson);
+  double sum = 0.0;
+  size_t count = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&valueJson->_value._objects, i));
+
+    if (TRI_IsNullJson(value)) {
+      continue;
+    }
+
+    if (! TRI_IsNumberJson(value)) {
+      RegisterInvalidArgumentWarning(query, "AVERAGE");
+      return AqlValue(new Json(Json::Null));
+    }
+
+    // got a numeric value
+    double const number = value->_value._number;
+
+    if (! std::isnan(number) && number != HUGE_VAL && number != -HUGE_VAL) {
+      sum += number;
+      ++count;
+    } 
+  } 
+
+  if (count > 0 && 
+      ! std::isnan(sum) && sum != HUGE_VAL && sum != -HUGE_VAL) {
+    return AqlValue(new Json(sum / static_cast<size_t>(count)));
+  } 
+
+  return AqlValue(new Json(Json::Null));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function MD5
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Md5 (triagens::aql::Query* query,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+    
+  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE);
+  AppendAsString(buffer, value.json());
+  
+  // create md5
+  char hash[17]; 
+  char* p = &hash[0];
+  size_t length;
+
+  triagens::rest::SslInterface::sslMD5(buffer.c_str(), buffer.length(), p, length);
+
+  // as hex
+  char hex[33];
+  p = &hex[0];
+
+  triagens::rest::SslInterface::sslHEX(hash, 16, p, length);
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, hex, 32));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SHA1
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Sha1 (triagens::aql::Query* query,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+    
+  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE);
+  AppendAsString(buffer, value.json());
+  
+  // create sha1
+  char hash[21];
+  char* p = &hash[0];
+  size_t length;
+
+  triagens::rest::SslInterface::sslSHA1(buffer.c_str(), buffer.length(), p, length);
+
+  // as hex
+  char hex[41];
+  p = &hex[0];
+
+  triagens::rest::SslInterface::sslHEX(hash, 20, p, length);
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, hex, 40));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function UNIQUE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Unique (triagens::aql::Query* query,
+                            triagens::arango::AqlTransaction* trx,
+                            TRI_document_collection_t const* collection,
+                            AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    // not an array
+    RegisterWarning(query, "UNIQUE", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* valueJson = value.json();
+  size_t const n = TRI_LengthArrayJson(valueJson);
+
+  std::unordered_set<TRI_json_t const*, triagens::basics::JsonHash, triagens::basics::JsonEqual> values(
+    512, 
+    triagens::basics::JsonHash(), 
+    triagens::basics::JsonEqual()
+  );
+
+  for (size_t i = 0; i < n; ++i) {
+    auto value = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, i));
+
+    if (value == nullptr) {
+      continue;
+    }
+
+    values.emplace(value); 
+  } 
+
+  std::unique_ptr<TRI_json_t> result(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, values.size()));
+ 
+  for (auto const& it : values) {
+    auto copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, it);
+
+    if (copy == nullptr) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    }
+ 
+    TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), copy); 
+  }
+      
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
+  result.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function UNION
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Union (triagens::aql::Query* query,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  std::unique_ptr<TRI_json_t> result(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, 16));
+
+  size_t const n = parameters.arraySize();
+
+  for (size_t i = 0; i < n; ++i) {
+    Json value(parameters.extractArrayMember(trx, collection, i, false));
+
+    if (! value.isArray()) {
+      // not an array
+      RegisterWarning(query, "UNION", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+      return AqlValue(new Json(Json::Null));
+    }
+
+    TRI_json_t const* valueJson = value.json();
+    size_t const nrValues = TRI_LengthArrayJson(valueJson);
+
+    if (TRI_ReserveVector(&(result.get()->_value._objects), nrValues) != TRI_ERROR_NO_ERROR) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    }
+
+    TRI_IF_FAILURE("AqlFunctions::OutOfMemory1") {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+    }
+    
+    // this passes ownership for the JSON contens into result
+    for (size_t j = 0; j < nrValues; ++j) {
+      TRI_json_t* copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, TRI_LookupArrayJson(valueJson, j));
+
+      if (copy == nullptr) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+      }
+    
+      TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), copy);
+
+      TRI_IF_FAILURE("AqlFunctions::OutOfMemory2") {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+      }
+    } 
+  } 
+      
+  TRI_IF_FAILURE("AqlFunctions::OutOfMemory3") {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+  }
+
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
+  result.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function UNION_DISTINCT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::UnionDistinct (triagens::aql::Query* query,
+                                   triagens::arango::AqlTransaction* trx,
+                                   TRI_document_collection_t const* collection,
+                                   AqlValue const parameters) {
+  std::unordered_set<TRI_json_t*, triagens::basics::JsonHash, triagens::basics::JsonEqual> values(
+    512, 
+    triagens::basics::JsonHash(), 
+    triagens::basics::JsonEqual()
+  );
+
+  auto freeValues = [&values] () -> void {
+    for (auto& it : values) {
+      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it);
+    }
+  };
+
+  std::unique_ptr<TRI_json_t> result;
+  size_t const n = parameters.arraySize();
+
+  try {
+    for (size_t i = 0; i < n; ++i) {
+      Json value(parameters.extractArrayMember(trx, collection, i, false));
+
+      if (! value.isArray()) {
+        // not an array
+        freeValues();
+        RegisterWarning(query, "UNION_DISTINCT", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+        return AqlValue(new Json(Json::Null));
+      }
+
+      TRI_json_t const* valueJson = value.json();
+      size_t const nrValues = TRI_LengthArrayJson(valueJson);
+
+      for (size_t j = 0; j < nrValues; ++j) {
+        auto value = static_cast<TRI_json_t*>(TRI_AddressVector(&valueJson->_value._objects, j));
+
+        if (values.find(value) == values.end()) { 
+          std::unique_ptr<TRI_json_t> copy(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value));
+
+          if (copy == nullptr) {
+            THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+          }
+      
+          TRI_IF_FAILURE("AqlFunctions::OutOfMemory1") {
+            THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+          }
+
+          values.emplace(copy.get());
+          copy.release();
+        }
+      }
+    }
+
+    result.reset(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, values.size()));
+
+    if (result == nullptr) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    }
+          
+    TRI_IF_FAILURE("AqlFunctions::OutOfMemory2") {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+    }
+   
+    for (auto const& it : values) {
+      TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), it); 
+    }
+
+  }
+  catch (...) {  
+    freeValues();
+    throw;
+  }
+    
+  TRI_IF_FAILURE("AqlFunctions::OutOfMemory3") {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+  }
+      
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
+  result.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function INTERSECTION
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Intersection (triagens::aql::Query* query,
+                                  triagens::arango::AqlTransaction* trx,
+                                  TRI_document_collection_t const* collection,
+                                  AqlValue const parameters) {
+  std::unordered_map<TRI_json_t*, size_t, triagens::basics::JsonHash, triagens::basics::JsonEqual> values(
+    512, 
+    triagens::basics::JsonHash(), 
+    triagens::basics::JsonEqual()
+  );
+
+  auto freeValues = [&values] () -> void {
+    for (auto& it : values) {
+      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it.first);
+    }
+    values.clear();
+  };
+
+  std::unique_ptr<TRI_json_t> result;
+  size_t const n = parameters.arraySize();
+
+  try {
+    for (size_t i = 0; i < n; ++i) {
+      Json value(parameters.extractArrayMember(trx, collection, i, false));
+
+      if (! value.isArray()) {
+        // not an array
+        freeValues();
+        RegisterWarning(query, "INTERSECTION", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+        return AqlValue(new Json(Json::Null));
+      }
+
+      TRI_json_t const* valueJson = value.json();
+      size_t const nrValues = TRI_LengthArrayJson(valueJson);
+
+      for (size_t j = 0; j < nrValues; ++j) {
+        auto value = static_cast<TRI_json_t const*>(TRI_AddressVector(&valueJson->_value._objects, j));
+
+        if (i == 0) {
+          // round one
+          std::unique_ptr<TRI_json_t> copy(TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value));
+
+          if (copy == nullptr) {
+            THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+          }
+    
+          TRI_IF_FAILURE("AqlFunctions::OutOfMemory1") {
+            THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+          }
+
+          auto r = values.emplace(copy.get(), 1);
+ 
+          if (r.second) {
+            // successfully inserted
+            copy.release();
+          }
+        }
+        else {
+          // check if we have seen the same element before
+          auto it = values.find(const_cast<TRI_json_t*>(value));
+
+          if (it != values.end()) {
+            // already seen
+            TRI_ASSERT((*it).second > 0);
+            ++((*it).second);
+          }
+        }
+      }
+    }
+ 
+    // count how many valid we have 
+    size_t total = 0;
+
+    for (auto const& it : values) {
+      if (it.second == n) {
+        ++total;
+      }
+    }
+
+    result.reset(TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, total));
+
+    if (result == nullptr) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+    }
+          
+    TRI_IF_FAILURE("AqlFunctions::OutOfMemory2") {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+    }
+   
+    for (auto& it : values) {
+      if (it.second == n) {
+        TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result.get(), it.first); 
+      }
+      else {
+        TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it.first);
+      }
+    }
+    values.clear();
+   
+  } 
+  catch (...) {
+    freeValues();
+    throw;
+  }
+    
+  TRI_IF_FAILURE("AqlFunctions::OutOfMemory3") {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_DEBUG);
+  }
+      
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, result.get());
+  result.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function FIRST
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::First (triagens::aql::Query* query,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    RegisterWarning(query, "FIRST", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = value.json();
+
+  if (TRI_LengthArrayJson(json) == 0) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  return AqlValue(new Json(CopyValue(TRI_LookupArrayJson(json, 0))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function LAST
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Last (triagens::aql::Query* query,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    RegisterWarning(query, "LAST", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = value.json();
+  size_t const n = TRI_LengthArrayJson(json);
+
+  if (n == 0) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  return AqlValue(new Json(CopyValue(TRI_LookupArrayJson(json, n - 1))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function NTH
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Nth (triagens::aql::Query* query,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    RegisterWarning(query, "NTH", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = value.json();
+
+  bool failed = true;
+  double position = 0.0;
+
+  if (parameters.arraySize() > 1) {
+    position = ExtractNumber(trx, collection, parameters, 1, failed);
+  }
+
+  // only integer positions inside the array denote a member
+  if (failed || 
+      position < 0.0 || 
+      position >= static_cast<double>(TRI_LengthArrayJson(json)) ||
+      position != std::floor(position)) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  return AqlValue(new Json(CopyValue(TRI_LookupArrayJson(json, static_cast<size_t>(position)))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function POSITION
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Position (triagens::aql::Query* query,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    RegisterWarning(query, "POSITION", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  Json search(parameters.extractArrayMember(trx, collection, 1, false));
+  bool const returnIndex = GetBooleanParameter(trx, collection, parameters, 2, false);
+
+  TRI_json_t const* json = value.json();
+  size_t const n = TRI_LengthArrayJson(json);
+
+  for (size_t i = 0; i < n; ++i) {
+    if (TRI_CheckSameValueJson(TRI_LookupArrayJson(json, i), search.json())) {
+      if (returnIndex) {
+        return AqlValue(new Json(static_cast<double>(i)));
+      }
+      return AqlValue(new Json(true));
+    }
+  }
+
+  if (returnIndex) {
+    return AqlValue(new Json(-1.0));
+  }
+  return AqlValue(new Json(false));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SLICE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Slice (triagens::aql::Query* query,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    RegisterInvalidArgumentWarning(query, "SLICE");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = value.json();
+  double const length = static_cast<double>(TRI_LengthArrayJson(json));
+
+  bool failed;
+  double from = ExtractNumber(trx, collection, parameters, 1, failed);
+  double to = length;
+
+  if (parameters.arraySize() > 2) {
+    double const number = ExtractNumber(trx, collection, parameters, 2, failed);
+
+    if (! failed) {
+      // a positive to value is the number of members to return
+      to = ToInteger(number >= 0.0 ? number + from : number);
+    }
+  }
+
+  from = ToInteger(from);
+
+  // negative positions are counted from the end of the array
+  from = (from < 0.0 ? (std::max)(length + from, 0.0) : (std::min)(from, length));
+  to = (to < 0.0 ? (std::max)(length + to, 0.0) : (std::min)(to, length));
+
+  Json result(Json::Array, static_cast<size_t>((std::max)(to - from, 0.0)));
+
+  for (size_t i = static_cast<size_t>(from); i < static_cast<size_t>(to); ++i) {
+    result.add(CopyValue(TRI_LookupArrayJson(json, i)));
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function REVERSE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Reverse (triagens::aql::Query* query,
+                             triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (value.isString()) {
+    // strings are reversed by UTF-16 code units, like in JavaScript
+    std::vector<uint16_t> units;
+    DecodeUtf16(ValueToString(value.json()), units);
+    std::reverse(units.begin(), units.end());
+
+    return AqlValue(new Json(EncodeUtf16(units, 0, units.size())));
+  }
+
+  if (! value.isArray()) {
+    RegisterWarning(query, "REVERSE", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = value.json();
+  size_t const n = TRI_LengthArrayJson(json);
+  Json result(Json::Array, n);
+
+  for (size_t i = n; i > 0; --i) {
+    result.add(CopyValue(TRI_LookupArrayJson(json, i - 1)));
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief flatten an array into the result, up to the specified depth
+////////////////////////////////////////////////////////////////////////////////
+
+static void FlattenArray (Json& result,
+                          TRI_json_t const* json,
+                          double maxDepth,
+                          double depth) {
+  size_t const n = TRI_LengthArrayJson(json);
+
+  for (size_t i = 0; i < n; ++i) {
+    TRI_json_t const* value = TRI_LookupArrayJson(json, i);
+
+    if (depth < maxDepth && TRI_IsArrayJson(value)) {
+      FlattenArray(result, value, maxDepth, depth + 1.0);
+    }
+    else {
+      result.add(CopyValue(value));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function FLATTEN
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Flatten (triagens::aql::Query* query,
+                             triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const parameters) {
+  Json value(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (! value.isArray()) {
+    RegisterWarning(query, "FLATTEN", TRI_ERROR_QUERY_ARRAY_EXPECTED);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  bool failed = true;
+  double maxDepth = 1.0;
+
+  if (parameters.arraySize() > 1) {
+    maxDepth = ExtractNumber(trx, collection, parameters, 1, failed);
+  }
+
+  if (failed || maxDepth < 1.0) {
+    maxDepth = 1.0;
+  }
+
+  Json result(Json::Array);
+  FlattenArray(result, value.json(), maxDepth, 0.0);
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function PUSH
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Push (triagens::aql::Query* query,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+  Json value(parameters.extractArrayMember(trx, collection, 1, false));
+
+  if (list.isNull()) {
+    Json result(Json::Array, 1);
+    result.add(value.copy());
+    return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "PUSH");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  Json result = list.copy();
+
+  if (! GetBooleanParameter(trx, collection, parameters, 2, false) ||
+      ! TRI_CheckInArrayJson(value.json(), list.json())) {
+    result.add(value.copy());
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function APPEND
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Append (triagens::aql::Query* query,
+                            triagens::arango::AqlTransaction* trx,
+                            TRI_document_collection_t const* collection,
+                            AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+  Json values(parameters.extractArrayMember(trx, collection, 1, false));
+
+  if (values.isNull()) {
+    return AqlValue(new Json(list.copy()));
+  }
+
+  if (! values.isArray()) {
+    Json wrapped(Json::Array, 1);
+    wrapped.add(values.copy());
+    values = wrapped;
+  }
+
+  TRI_json_t const* valuesJson = values.json();
+  size_t const n = TRI_LengthArrayJson(valuesJson);
+
+  if (n == 0) {
+    return AqlValue(new Json(list.copy()));
+  }
+
+  bool const unique = GetBooleanParameter(trx, collection, parameters, 2, false);
+
+  // the values to append
+  std::vector<TRI_json_t const*> append;
+  append.reserve(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    append.emplace_back(TRI_LookupArrayJson(valuesJson, i));
+  }
+
+  if (unique && n > 1) {
+    // make the values unique themselves, in the order UNIQUE() returns them
+    UniqueValues(append);
+  }
+
+  if (list.isNull()) {
+    Json result(Json::Array, append.size());
+    for (auto const& it : append) {
+      result.add(CopyValue(it));
+    }
+    return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "APPEND");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  Json result = list.copy();
+
+  for (auto const& it : append) {
+    if (! unique || ! TRI_CheckInArrayJson(it, list.json())) {
+      result.add(CopyValue(it));
+    }
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function POP
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Pop (triagens::aql::Query* query,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (list.isNull()) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "POP");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = list.json();
+  size_t const n = TRI_LengthArrayJson(json);
+  Json result(Json::Array, n);
+
+  for (size_t i = 0; i + 1 < n; ++i) {
+    result.add(CopyValue(TRI_LookupArrayJson(json, i)));
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SHIFT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Shift (triagens::aql::Query* query,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (list.isNull()) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "SHIFT");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = list.json();
+  size_t const n = TRI_LengthArrayJson(json);
+  Json result(Json::Array, n);
+
+  for (size_t i = 1; i < n; ++i) {
+    result.add(CopyValue(TRI_LookupArrayJson(json, i)));
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function UNSHIFT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Unshift (triagens::aql::Query* query,
+                             triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+  Json value(parameters.extractArrayMember(trx, collection, 1, false));
+
+  if (list.isNull()) {
+    Json result(Json::Array, 1);
+    result.add(value.copy());
+    return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "UNSHIFT");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = list.json();
+
+  if (GetBooleanParameter(trx, collection, parameters, 2, false) &&
+      TRI_CheckInArrayJson(value.json(), json)) {
+    return AqlValue(new Json(list.copy()));
+  }
+
+  size_t const n = TRI_LengthArrayJson(json);
+  Json result(Json::Array, n + 1);
+  result.add(value.copy());
+
+  for (size_t i = 0; i < n; ++i) {
+    result.add(CopyValue(TRI_LookupArrayJson(json, i)));
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function REMOVE_VALUE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::RemoveValue (triagens::aql::Query* query,
+                                 triagens::arango::AqlTransaction* trx,
+                                 TRI_document_collection_t const* collection,
+                                 AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (list.isNull()) {
+    return AqlValue(new Json(Json::Array));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "REMOVE_VALUE");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  Json value(parameters.extractArrayMember(trx, collection, 1, false));
+
+  // the maximum number of occurrences to remove. a limit of -1 (or no limit)
+  // removes all occurrences, other limits that are not positive remove none
+  bool removeAll = true;
+  double limit = 0.0;
+
+  if (parameters.arraySize() > 2) {
+    Json limitJson(parameters.extractArrayMember(trx, collection, 2, false));
+
+    if (! limitJson.isNull() && 
+        ! (limitJson.isNumber() && limitJson.json()->_value._number == -1.0)) {
+      bool failed;
+      limit = TRI_ToDoubleJson(limitJson.json(), failed);
+      removeAll = false;
+    }
+  }
+
+  TRI_json_t const* json = list.json();
+  size_t const n = TRI_LengthArrayJson(json);
+  Json result(Json::Array, n);
+
+  for (size_t i = 0; i < n; ++i) {
+    TRI_json_t const* element = TRI_LookupArrayJson(json, i);
+
+    if ((removeAll || limit > 0.0) && 
+        TRI_CheckSameValueJson(element, value.json())) {
+      limit -= 1.0;
+      continue;
+    }
+
+    result.add(CopyValue(element));
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function REMOVE_VALUES
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::RemoveValues (triagens::aql::Query* query,
+                                  triagens::arango::AqlTransaction* trx,
+                                  TRI_document_collection_t const* collection,
+                                  AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+  Json values(parameters.extractArrayMember(trx, collection, 1, false));
+
+  if (values.isNull()) {
+    return AqlValue(new Json(list.copy()));
+  }
+
+  if (! values.isArray()) {
+    RegisterInvalidArgumentWarning(query, "REMOVE_VALUES");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  if (list.isNull()) {
+    return AqlValue(new Json(Json::Array));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "REMOVE_VALUES");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = list.json();
+  size_t const n = TRI_LengthArrayJson(json);
+  Json result(Json::Array, n);
+
+  for (size_t i = 0; i < n; ++i) {
+    TRI_json_t const* element = TRI_LookupArrayJson(json, i);
+
+    if (! TRI_CheckInArrayJson(element, values.json())) {
+      result.add(CopyValue(element));
+    }
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function REMOVE_NTH
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::RemoveNth (triagens::aql::Query* query,
+                               triagens::arango::AqlTransaction* trx,
+                               TRI_document_collection_t const* collection,
+                               AqlValue const parameters) {
+  Json list(parameters.extractArrayMember(trx, collection, 0, false));
+
+  if (list.isNull()) {
+    return AqlValue(new Json(Json::Array));
+  }
+
+  if (! list.isArray()) {
+    RegisterInvalidArgumentWarning(query, "REMOVE_NTH");
+    return AqlValue(new Json(Json::Null));
+  }
+
+  TRI_json_t const* json = list.json();
+  size_t const n = TRI_LengthArrayJson(json);
+  double const length = static_cast<double>(n);
+
+  bool failed = true;
+  double position = 0.0;
+
+  if (parameters.arraySize() > 1) {
+    position = ExtractNumber(trx, collection, parameters, 1, failed);
+  }
+
+  if (position >= length || position < - length) {
+    return AqlValue(new Json(list.copy()));
+  }
+
+  // negative positions are counted from the end of the array
+  size_t const remove = static_cast<size_t>(ToInteger(position < 0.0 ? length + position : position));
+  Json result(Json::Array, n);
+
+  for (size_t i = 0; i < n; ++i) {
+    if (i != remove) {
+      result.add(CopyValue(TRI_LookupArrayJson(json, i)));
+    }
+  }
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the first argument that matches the predicate, or null
+////////////////////////////////////////////////////////////////////////////////
+
+static AqlValue FirstMatchingArgument (triagens::arango::AqlTransaction* trx,
+                                       TRI_document_collection_t const* collection,
+                                       AqlValue const& parameters,
+                                       std::function<bool(Json const&)> const& predicate) {
+  size_t const n = parameters.arraySize();
+
+  for (size_t i = 0; i < n; ++i) {
+    Json value(parameters.extractArrayMember(trx, collection, i, false));
+
+    if (predicate(value)) {
+      return AqlValue(new Json(value.copy()));
+    }
+  }
+
+  return AqlValue(new Json(Json::Null));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function NOT_NULL
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::NotNull (triagens::aql::Query*,
+                             triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const parameters) {
+  return FirstMatchingArgument(trx, collection, parameters, [] (Json const& value) -> bool {
+    return ! value.isNull();
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function FIRST_LIST
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::FirstList (triagens::aql::Query*,
+                               triagens::arango::AqlTransaction* trx,
+                               TRI_document_collection_t const* collection,
+                               AqlValue const parameters) {
+  return FirstMatchingArgument(trx, collection, parameters, [] (Json const& value) -> bool {
+    return value.isArray();
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function FIRST_DOCUMENT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::FirstDocument (triagens::aql::Query*,
+                                   triagens::arango::AqlTransaction* trx,
+                                   TRI_document_collection_t const* collection,
+                                   AqlValue const parameters) {
+  return FirstMatchingArgument(trx, collection, parameters, [] (Json const& value) -> bool {
+    return value.isObject();
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function TO_NUMBER
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::ToNumber (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  bool failed;
+  double const value = ExtractNumber(trx, collection, parameters, 0, failed);
+
+  if (failed) {
+    return AqlValue(new Json(Json::Null));
+  }
+  return NumberResult(value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function TO_STRING
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::ToString (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  return AqlValue(new Json(ExtractString(trx, collection, parameters, 0)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function TO_BOOL
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::ToBool (triagens::aql::Query*,
+                            triagens::arango::AqlTransaction* trx,
+                            TRI_document_collection_t const* collection,
+                            AqlValue const parameters) {
+  return AqlValue(new Json(GetBooleanParameter(trx, collection, parameters, 0, false)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function CONCAT_SEPARATOR
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::ConcatSeparator (triagens::aql::Query*,
+                                     triagens::arango::AqlTransaction* trx,
+                                     TRI_document_collection_t const* collection,
+                                     AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  std::string const separator = ExtractString(trx, collection, parameters, 0);
+
+  triagens::basics::StringBuffer buffer(TRI_UNKNOWN_MEM_ZONE, 24);
+  bool found = false;
+
+  for (size_t i = 1; i < n; ++i) {
+    Json member = parameters.at(trx, i);
+
+    if (member.isEmpty() || member.isNull()) {
+      continue;
+    }
+
+    if (found) {
+      buffer.appendText(separator);
+    }
+
+    TRI_json_t const* json = member.json();
+
+    if (member.isArray()) {
+      // append each member individually
+      size_t const subLength = TRI_LengthArrayJson(json);
+      found = false;
+
+      for (size_t j = 0; j < subLength; ++j) {
+        auto sub = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, j));
+
+        if (sub == nullptr || sub->_type == TRI_JSON_NULL) {
+          continue;
+        }
+
+        if (found) {
+          buffer.appendText(separator);
+        }
+        AppendAsString(buffer, sub);
+        found = true;
+      }
+    }
+    else {
+      AppendAsString(buffer, json);
+      found = true;
+    }
+  }
+
+  size_t length = buffer.length();
+  std::unique_ptr<TRI_json_t> j(TRI_CreateStringJson(TRI_UNKNOWN_MEM_ZONE, buffer.steal(), length));
+
+  auto jr = new Json(TRI_UNKNOWN_MEM_ZONE, j.get());
+  j.release();
+  return AqlValue(jr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function CHAR_LENGTH
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::CharLength (triagens::aql::Query*,
+                                triagens::arango::AqlTransaction* trx,
+                                TRI_document_collection_t const* collection,
+                                AqlValue const parameters) {
+  std::string const value = ExtractString(trx, collection, parameters, 0);
+
+  return AqlValue(new Json(static_cast<double>(Utf16Length(value.c_str(), value.size()))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function LOWER
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Lower (triagens::aql::Query*,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  std::string const value = ExtractString(trx, collection, parameters, 0);
+
+  return AqlValue(new Json(triagens::basics::Utf8Helper::DefaultUtf8Helper.toLowerCase(value)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function UPPER
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Upper (triagens::aql::Query*,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  std::string const value = ExtractString(trx, collection, parameters, 0);
+
+  return AqlValue(new Json(triagens::basics::Utf8Helper::DefaultUtf8Helper.toUpperCase(value)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SUBSTRING
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Substring (triagens::aql::Query*,
+                               triagens::arango::AqlTransaction* trx,
+                               TRI_document_collection_t const* collection,
+                               AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  std::vector<uint16_t> units;
+  DecodeUtf16(ExtractString(trx, collection, parameters, 0), units);
+
+  bool failed;
+  double const start = ExtractNumber(trx, collection, parameters, 1, failed);
+  double count = 0.0;
+
+  if (n > 2) {
+    count = ExtractNumber(trx, collection, parameters, 2, failed);
+  }
+
+  return AqlValue(new Json(Substr(units, start, count, n > 2)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function LEFT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Left (triagens::aql::Query*,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  std::vector<uint16_t> units;
+  DecodeUtf16(ExtractString(trx, collection, parameters, 0), units);
+
+  bool failed;
+  double const count = ExtractNumber(trx, collection, parameters, 1, failed);
+
+  return AqlValue(new Json(Substr(units, 0.0, count, true)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function RIGHT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Right (triagens::aql::Query*,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  std::vector<uint16_t> units;
+  DecodeUtf16(ExtractString(trx, collection, parameters, 0), units);
+
+  bool failed;
+  double const count = ExtractNumber(trx, collection, parameters, 1, failed);
+  double const start = (std::max)(static_cast<double>(units.size()) - count, 0.0);
+
+  return AqlValue(new Json(Substr(units, start, count, true)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function CONTAINS
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Contains (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  std::string const search = ExtractString(trx, collection, parameters, 1);
+  bool const returnIndex = GetBooleanParameter(trx, collection, parameters, 2, false);
+
+  double result = -1.0;
+
+  if (! search.empty()) {
+    std::string const value = ExtractString(trx, collection, parameters, 0);
+    size_t const position = value.find(search);
+
+    if (position != std::string::npos) {
+      // convert the byte position into a character position
+      result = static_cast<double>(Utf16Length(value.c_str(), position));
+    }
+  }
+
+  if (returnIndex) {
+    return AqlValue(new Json(result));
+  }
+  return AqlValue(new Json(result != -1.0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function LIKE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Like (triagens::aql::Query* query,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  bool const caseInsensitive = GetBooleanParameter(trx, collection, parameters, 2, false);
+
+  std::string value = ExtractString(trx, collection, parameters, 0);
+  std::string pattern = ExtractString(trx, collection, parameters, 1);
+
+  try {
+    if (caseInsensitive) {
+      value = triagens::basics::Utf8Helper::DefaultUtf8Helper.toLowerCase(value);
+      pattern = triagens::basics::Utf8Helper::DefaultUtf8Helper.toLowerCase(pattern);
+    }
+
+    std::vector<uint16_t> units;
+    DecodeUtf16(pattern, units);
+
+    std::vector<LikeToken> tokens;
+    ParseLikePattern(units, tokens);
+
+    DecodeUtf16(value, units);
+
+    return AqlValue(new Json(MatchLikePattern(units, tokens)));
+  }
+  catch (...) {
+    // the pattern could not be matched
+    RegisterWarning(query, "LIKE", TRI_ERROR_QUERY_INVALID_REGEX);
+    return AqlValue(new Json(false));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function TRIM
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Trim (triagens::aql::Query*,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  std::string const value = ExtractString(trx, collection, parameters, 0);
+
+  if (parameters.arraySize() > 1) {
+    Json chars(parameters.extractArrayMember(trx, collection, 1, false));
+
+    if (chars.isNumber()) {
+      double const type = chars.json()->_value._number;
+
+      if (type == 1.0) {
+        return AqlValue(new Json(TrimString(value, nullptr, true, false)));
+      }
+      else if (type == 2.0) {
+        return AqlValue(new Json(TrimString(value, nullptr, false, true)));
+      }
+    }
+
+    if (! chars.isNull() && ! (chars.isNumber() && chars.json()->_value._number == 0.0)) {
+      std::string const remove = ExtractString(trx, collection, parameters, 1);
+      return AqlValue(new Json(TrimString(value, &remove, true, true)));
+    }
+  }
+
+  return AqlValue(new Json(TrimString(value, nullptr, true, true)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function LTRIM
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::LTrim (triagens::aql::Query*,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  std::string const value = ExtractString(trx, collection, parameters, 0);
+
+  if (parameters.arraySize() > 1) {
+    Json chars(parameters.extractArrayMember(trx, collection, 1, false));
+
+    if (! chars.isNull()) {
+      std::string const remove = ExtractString(trx, collection, parameters, 1);
+      return AqlValue(new Json(TrimString(value, &remove, true, false)));
+    }
+  }
+
+  return AqlValue(new Json(TrimString(value, nullptr, true, false)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function RTRIM
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::RTrim (triagens::aql::Query*,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  std::string const value = ExtractString(trx, collection, parameters, 0);
+
+  if (parameters.arraySize() > 1) {
+    Json chars(parameters.extractArrayMember(trx, collection, 1, false));
+
+    if (! chars.isNull()) {
+      std::string const remove = ExtractString(trx, collection, parameters, 1);
+      return AqlValue(new Json(TrimString(value, &remove, false, true)));
+    }
+  }
+
+  return AqlValue(new Json(TrimString(value, nullptr, false, true)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SPLIT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Split (triagens::aql::Query* query,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  std::string const value = ExtractString(trx, collection, parameters, 0);
+
+  Json separator(parameters.extractArrayMember(trx, collection, 1, false));
+
+  if (n < 2 || separator.isNull()) {
+    Json result(Json::Array, 1);
+    result.add(Json(value));
+    return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+  }
+
+  // the maximum number of parts to return
+  double limit = -1.0;
+
+  if (n > 2) {
+    Json limitJson(parameters.extractArrayMember(trx, collection, 2, false));
+
+    if (! limitJson.isNull()) {
+      bool failed;
+      limit = TRI_ToDoubleJson(limitJson.json(), failed);
+
+      if (failed) {
+        limit = 0.0;
+      }
+      else if (limit < 0.0) {
+        RegisterInvalidArgumentWarning(query, "SPLIT");
+        return AqlValue(new Json(Json::Null));
+      }
+      limit = ToInteger(limit);
+    }
+  }
+
+  // an array of separators is treated as alternatives, in the order given
+  std::vector<std::vector<uint16_t>> separators;
+
+  if (separator.isArray()) {
+    TRI_json_t const* json = separator.json();
+    size_t const length = TRI_LengthArrayJson(json);
+
+    for (size_t i = 0; i < length; ++i) {
+      separators.emplace_back(std::vector<uint16_t>());
+      DecodeUtf16(ValueToString(static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, i))), separators.back());
+    }
+
+    if (separators.empty()) {
+      // no alternatives at all match the empty string
+      separators.emplace_back(std::vector<uint16_t>());
+    }
+  }
+  else {
+    separators.emplace_back(std::vector<uint16_t>());
+    DecodeUtf16(ExtractString(trx, collection, parameters, 1), separators.back());
+  }
+
+  Json result(Json::Array);
+
+  if (limit == 0.0) {
+    return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+  }
+
+  std::vector<uint16_t> units;
+  DecodeUtf16(value, units);
+  size_t const length = units.size();
+
+  // finds the first separator matching at the specified position and 
+  // returns the position after the match
+  auto matchAt = [&] (size_t position, size_t& end) -> bool {
+    for (auto const& it : separators) {
+      if (position + it.size() <= length &&
+          std::equal(it.begin(), it.end(), units.begin() + position)) {
+        end = position + it.size();
+        return true;
+      }
+    }
+    return false;
+  };
+
+  if (length == 0) {
+    size_t end;
+    if (! matchAt(0, end)) {
+      result.add(Json(value));
+    }
+    return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+  }
+
+  size_t p = 0;
+  size_t q = 0;
+
+  while (q < length) {
+    size_t e;
+
+    if (! matchAt(q, e) || e == p) {
+      ++q;
+      continue;
+    }
+
+    result.add(Json(EncodeUtf16(units, p, q)));
+
+    if (static_cast<double>(result.size()) == limit) {
+      return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+    }
+
+    p = e;
+    q = p;
+  }
+
+  result.add(Json(EncodeUtf16(units, p, length)));
+
+  return AqlValue(new Json(TRI_UNKNOWN_MEM_ZONE, result.steal()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function FIND_FIRST
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::FindFirst (triagens::aql::Query*,
+                               triagens::arango::AqlTransaction* trx,
+                               TRI_document_collection_t const* collection,
+                               AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  std::vector<uint16_t> value;
+  std::vector<uint16_t> search;
+  DecodeUtf16(ExtractString(trx, collection, parameters, 0), value);
+  DecodeUtf16(ExtractString(trx, collection, parameters, 1), search);
+
+  double start = 0.0;
+
+  if (n > 2) {
+    Json startJson(parameters.extractArrayMember(trx, collection, 2, false));
+
+    if (! startJson.isNull()) {
+      bool failed;
+      start = TRI_ToDoubleJson(startJson.json(), failed);
+
+      if (start < 0.0) {
+        return NumberResult(-1.0);
+      }
+    }
+  }
+
+  if (n > 3) {
+    Json endJson(parameters.extractArrayMember(trx, collection, 3, false));
+
+    if (! endJson.isNull()) {
+      bool failed;
+      double const end = TRI_ToDoubleJson(endJson.json(), failed);
+
+      if (end < start || end < 0.0) {
+        return NumberResult(-1.0);
+      }
+
+      // the search ends with the character at position end
+      size_t from, to;
+      SubstrRange(value.size(), 0.0, end + 1.0, true, from, to);
+      value.resize(to);
+    }
+  }
+
+  return NumberResult(IndexOf(value, search, start));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function FIND_LAST
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::FindLast (triagens::aql::Query*,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  std::vector<uint16_t> value;
+  std::vector<uint16_t> search;
+  DecodeUtf16(ExtractString(trx, collection, parameters, 0), value);
+  DecodeUtf16(ExtractString(trx, collection, parameters, 1), search);
+
+  double start = 0.0;
+
+  if (n > 2) {
+    Json startJson(parameters.extractArrayMember(trx, collection, 2, false));
+
+    if (! startJson.isNull()) {
+      bool failed;
+      start = TRI_ToDoubleJson(startJson.json(), failed);
+    }
+  }
+
+  bool hasEnd = false;
+  double end = 0.0;
+
+  if (n > 3) {
+    Json endJson(parameters.extractArrayMember(trx, collection, 3, false));
+
+    if (! endJson.isNull()) {
+      bool failed;
+      end = TRI_ToDoubleJson(endJson.json(), failed);
+      hasEnd = true;
+
+      if (end < start || end < 0.0) {
+        return NumberResult(-1.0);
+      }
+    }
+  }
+
+  if (start <= 0.0 && ! hasEnd) {
+    return NumberResult(LastIndexOf(value, search));
+  }
+
+  size_t from, to;
+  SubstrRange(value.size(), start, end - start + 1.0, hasEnd, from, to);
+
+  double result = LastIndexOf(std::vector<uint16_t>(value.begin() + from, value.begin() + to), search);
+
+  if (result != -1.0) {
+    result += start;
+  }
+
+  return NumberResult(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SUBSTITUTE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Substitute (triagens::aql::Query* query,
+                                triagens::arango::AqlTransaction* trx,
+                                TRI_document_collection_t const* collection,
+                                AqlValue const parameters) {
+  size_t const n = parameters.arraySize();
+
+  std::string const original = ExtractString(trx, collection, parameters, 0);
+
+  Json search(parameters.extractArrayMember(trx, collection, 1, false));
+  Json replace(parameters.extractArrayMember(trx, collection, 2, false));
+
+  // the search strings, in the order in which they are tried. if a search 
+  // string occurs more than once, the replacement given last is used
+  std::vector<std::string> patterns;
+  std::unordered_map<std::string, std::string> replacements;
+  size_t limitPosition = 3;
+
+  if (search.isObject()) {
+    TRI_json_t const* json = search.json();
+
+    for (auto const& it : ObjectKeyPositions(json)) {
+      auto key = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, it));
+      auto value = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, it + 1));
+      std::string const pattern = ValueToString(key);
+
+      patterns.emplace_back(pattern);
+      replacements[pattern] = ValueToString(value);
+    }
+
+    // the replacements are part of the search object
+    limitPosition = 2;
+  }
+  else if (search.isArray()) {
+    TRI_json_t const* json = search.json();
+    size_t const length = TRI_LengthArrayJson(json);
+
+    if (length == 0) {
+      RegisterInvalidArgumentWarning(query, "SUBSTITUTE");
+      return AqlValue(new Json(original));
+    }
+
+    for (size_t i = 0; i < length; ++i) {
+      std::string const pattern = ValueToString(TRI_LookupArrayJson(json, i));
+      patterns.emplace_back(pattern);
+
+      if (replace.isArray()) {
+        // replace each search string with the member at the same position
+        TRI_json_t const* r = replace.json();
+        replacements[pattern] = (i < TRI_LengthArrayJson(r) ? ValueToString(TRI_LookupArrayJson(r, i)) : "");
+      }
+      else {
+        replacements[pattern] = (replace.isNull() ? "" : ValueToString(replace.json()));
+      }
+    }
+  }
+  else if (! search.isNull()) {
+    std::string const pattern = ValueToString(search.json());
+
+    patterns.emplace_back(pattern);
+    replacements[pattern] = (replace.isNull() ? "" : ValueToString(replace.json()));
+  }
+
+  if (patterns.empty()) {
+    // nothing to replace
+    return AqlValue(new Json(original));
+  }
+
+  // the maximum number of replacements
+  double limit = -1.0;
+
+  if (n > limitPosition) {
+    Json limitJson(parameters.extractArrayMember(trx, collection, static_cast<int64_t>(limitPosition), false));
+
+    if (! limitJson.isNull()) {
+      bool failed;
+      limit = TRI_ToDoubleJson(limitJson.json(), failed);
+
+      if (limit < 0.0) {
+        RegisterInvalidArgumentWarning(query, "SUBSTITUTE");
+        return AqlValue(new Json(Json::Null));
+      }
+    }
+  }
+
+  std::vector<uint16_t> value;
+  DecodeUtf16(original, value);
+
+  std::vector<std::vector<uint16_t>> searchUnits;
+  std::vector<std::vector<uint16_t>> replaceUnits;
+  searchUnits.reserve(patterns.size());
+  replaceUnits.reserve(patterns.size());
+
+  for (auto const& it : patterns) {
+    searchUnits.emplace_back(std::vector<uint16_t>());
+    DecodeUtf16(it, searchUnits.back());
+    replaceUnits.emplace_back(std::vector<uint16_t>());
+    DecodeUtf16(replacements[it], replaceUnits.back());
+  }
+
+  // scan the value from left to right. at each position, the first search 
+  // string that matches is replaced. an empty search string matches between 
+  // all characters
+  size_t const length = value.size();
+  std::vector<uint16_t> result;
+  result.reserve(length);
+
+  size_t position = 0;
+
+  while (position <= length) {
+    size_t match = 0;
+    bool found = false;
+
+    for (; match < searchUnits.size(); ++match) {
+      auto const& s = searchUnits[match];
+
+      if (position + s.size() <= length &&
+          std::equal(s.begin(), s.end(), value.begin() + position)) {
+        found = true;
+        break;
+      }
+    }
+
+    if (! found) {
+      if (position < length) {
+        result.emplace_back(value[position]);
+      }
+      ++position;
+      continue;
+    }
+
+    auto const& s = searchUnits[match];
+
+    if (limit < 0.0 || limit > 0.0) {
+      // replace
+      auto const& r = replaceUnits[match];
+      result.insert(result.end(), r.begin(), r.end());
+
+      if (limit > 0.0) {
+        limit -= 1.0;
+      }
+    }
+    else {
+      // limit reached. keep the matched string as it is
+      result.insert(result.end(), s.begin(), s.end());
+    }
+
+    if (s.empty()) {
+      if (position < length) {
+        result.emplace_back(value[position]);
+      }
+      ++position;
+    }
+    else {
+      position += s.size();
+    }
+  }
+
+  return AqlValue(new Json(EncodeUtf16(result, 0, result.size())));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function FLOOR
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Floor (triagens::aql::Query*,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  bool failed;
+  double const value = ExtractNumber(trx, collection, parameters, 0, failed);
+
+  return NumberResult(failed ? 0.0 : std::floor(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function CEIL
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Ceil (triagens::aql::Query*,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  bool failed;
+  double const value = ExtractNumber(trx, collection, parameters, 0, failed);
+
+  return NumberResult(failed ? 0.0 : std::ceil(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function ROUND
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Round (triagens::aql::Query*,
+                           triagens::arango::AqlTransaction* trx,
+                           TRI_document_collection_t const* collection,
+                           AqlValue const parameters) {
+  bool failed;
+  double const value = ExtractNumber(trx, collection, parameters, 0, failed);
+
+  if (failed) {
+    return NumberResult(0.0);
+  }
+
+  // rounds half values up, like JavaScript's Math.round() does. adding 0.5
+  // before flooring is not exact (e.g. for 0.49999999999999994), but the
+  // distance to the floor is
+  double result = std::floor(value);
+
+  if (value - result >= 0.5) {
+    result += 1.0;
+  }
+
+  return NumberResult(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function ABS
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Abs (triagens::aql::Query*,
+                         triagens::arango::AqlTransaction* trx,
+                         TRI_document_collection_t const* collection,
+                         AqlValue const parameters) {
+  bool failed;
+  double const value = ExtractNumber(trx, collection, parameters, 0, failed);
+
+  return NumberResult(failed ? 0.0 : std::fabs(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function SQRT
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::Sqrt (triagens::aql::Query*,
+                          triagens::arango::AqlTransaction* trx,
+                          TRI_document_collection_t const* collection,
+                          AqlValue const parameters) {
+  bool failed;
+  double const value = ExtractNumber(trx, collection, parameters, 0, failed);
+
+  return NumberResult(failed ? 0.0 : std::sqrt(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_TIMESTAMP
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateTimestamp (triagens::aql::Query* query,
+                                   triagens::arango::AqlTransaction* trx,
+                                   TRI_document_collection_t const* collection,
+                                   AqlValue const parameters) {
+  double timestamp;
+
+  if (! MakeDate(query, trx, collection, parameters, "DATE_TIMESTAMP", timestamp)) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  return NumberResult(timestamp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_ISO8601
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateIso8601 (triagens::aql::Query* query,
+                                 triagens::arango::AqlTransaction* trx,
+                                 TRI_document_collection_t const* collection,
+                                 AqlValue const parameters) {
+  double timestamp;
+
+  if (! MakeDate(query, trx, collection, parameters, "DATE_ISO8601", timestamp)) {
+    return AqlValue(new Json(Json::Null));
+  }
+
+  if (std::isnan(timestamp)) {
+    RegisterWarning(query, "DATE_ISO8601", TRI_ERROR_QUERY_INVALID_DATE_VALUE);
+    return AqlValue(new Json(Json::Null));
+  }
+
+  double const days = std::floor(timestamp / MillisecondsPerDay);
+  int64_t const time = static_cast<int64_t>(timestamp - days * MillisecondsPerDay);
+
+  double year, month, day;
+  CivilFromDays(days, year, month, day);
+
+  char buffer[32];
+  int length;
+
+  if (year >= 0.0 && year <= 9999.0) {
+    length = snprintf(buffer, sizeof(buffer), "%04d", static_cast<int>(year));
+  }
+  else {
+    length = snprintf(buffer, sizeof(buffer), "%+07d", static_cast<int>(year));
+  }
+
+  snprintf(buffer + length, sizeof(buffer) - length, "-%02d-%02dT%02d:%02d:%02d.%03dZ",
+           static_cast<int>(month),
+           static_cast<int>(day),
+           static_cast<int>(time / 3600000),
+           static_cast<int>((time / 60000) % 60),
+           static_cast<int>((time / 1000) % 60),
+           static_cast<int>(time % 1000));
+
+  return AqlValue(new Json(std::string(buffer)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_DAYOFWEEK
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateDayOfWeek (triagens::aql::Query* query,
+                                   triagens::arango::AqlTransaction* trx,
+                                   TRI_document_collection_t const* collection,
+                                   AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_DAYOFWEEK", [] (double days, double) -> double {
+    // 1970-01-01 was a thursday
+    double const weekday = std::fmod(days + 4.0, 7.0);
+    return (weekday < 0.0 ? weekday + 7.0 : weekday);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_YEAR
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateYear (triagens::aql::Query* query,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_YEAR", [] (double days, double) -> double {
+    double year, month, day;
+    CivilFromDays(days, year, month, day);
+    return year;
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_MONTH
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateMonth (triagens::aql::Query* query,
+                               triagens::arango::AqlTransaction* trx,
+                               TRI_document_collection_t const* collection,
+                               AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_MONTH", [] (double days, double) -> double {
+    double year, month, day;
+    CivilFromDays(days, year, month, day);
+    return month;
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_DAY
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateDay (triagens::aql::Query* query,
+                             triagens::arango::AqlTransaction* trx,
+                             TRI_document_collection_t const* collection,
+                             AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_DAY", [] (double days, double) -> double {
+    double year, month, day;
+    CivilFromDays(days, year, month, day);
+    return day;
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_HOUR
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateHour (triagens::aql::Query* query,
+                              triagens::arango::AqlTransaction* trx,
+                              TRI_document_collection_t const* collection,
+                              AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_HOUR", [] (double, double time) -> double {
+    return std::floor(time / 3600000.0);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_MINUTE
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateMinute (triagens::aql::Query* query,
+                                triagens::arango::AqlTransaction* trx,
+                                TRI_document_collection_t const* collection,
+                                AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_MINUTE", [] (double, double time) -> double {
+    return std::fmod(std::floor(time / 60000.0), 60.0);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_SECOND
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateSecond (triagens::aql::Query* query,
+                                triagens::arango::AqlTransaction* trx,
+                                TRI_document_collection_t const* collection,
+                                AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_SECOND", [] (double, double time) -> double {
+    return std::fmod(std::floor(time / 1000.0), 60.0);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief function DATE_MILLISECOND
+////////////////////////////////////////////////////////////////////////////////
+
+AqlValue Functions::DateMillisecond (triagens::aql::Query* query,
+                                     triagens::arango::AqlTransaction* trx,
+                                     TRI_document_collection_t const* collection,
+                                     AqlValue const parameters) {
+  return DateComponent(query, trx, collection, parameters, "DATE_MILLISECOND", [] (double, double time) -> double {
+    return std::fmod(time, 1000.0);
+  });
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                       END-OF-FILE
 // -----------------------------------------------------------------------------
@@ -572,6 +572,12 @@ void Optimizer::setupRules () {
                useIndexForSortRule_pass6,
                true);
 
+  // join collections by equality conditions using hash tables
+  registerRule("use-hash-join",
+               useHashJoinRule,
+               useHashJoinRule_pass6,
+               true);
+
 //////////////////////////////////////////////////////////////////////////////
 /// Pass 9: push down calculations beyond FILTERs and LIMITs
 //////////////////////////////////////////////////////////////////////////////
@@ -582,6 +588,19 @@ void Optimizer::setupRules () {
                moveCalculationsDownRule_pass9,
                true);
 
+  // filter full collection scans with multiple threads. this only has an 
+  // effect if the query option "parallelism" is greater than 1
+  registerRule("parallelize-collection-scan",
+               parallelizeCollectionScanRule,
+               parallelizeCollectionScanRule_pass9,
+               true);
+
+  // keep only the rows a following LIMIT will return in a SORT
+  registerRule("sort-limit",
+               sortLimitRule,
+               sortLimitRule_pass9,
+               true);
+
   if (triagens::arango::ServerState::instance()->isCoordinator()) {
     // distribute operations in cluster
     registerRule("scatter-in-cluster",
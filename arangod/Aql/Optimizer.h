@@ -192,12 +192,21 @@ namespace triagens {
         // try to find sort blocks which are superseeded by indexes
         useIndexForSortRule_pass6                     = 850,
 
+        // join collections by equality conditions using hash tables
+        useHashJoinRule_pass6                         = 860,
+
 //////////////////////////////////////////////////////////////////////////////
 /// Pass 9: push down calculations beyond FILTERs and LIMITs
 //////////////////////////////////////////////////////////////////////////////
 
         moveCalculationsDownRule_pass9                = 900,
 
+        // filter the documents of full collection scans with multiple threads
+        parallelizeCollectionScanRule_pass9           = 910,
+
+        // sort only the first rows for a SORT that is followed by a LIMIT
+        sortLimitRule_pass9                           = 920,
+
 //////////////////////////////////////////////////////////////////////////////
 /// "Pass 10": final transformations for the cluster
 //////////////////////////////////////////////////////////////////////////////
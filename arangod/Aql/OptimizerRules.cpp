@@ -32,6 +32,7 @@
 #include "Aql/Function.h"
 #include "Aql/Variable.h"
 #include "Aql/types.h"
+#include "Cluster/ServerState.h"
 
 using namespace triagens::aql;
 using Json = triagens::basics::Json;
@@ -847,9 +848,10 @@ int triagens::aql::removeSortRandRule (Optimizer* opt,
         case EN::FILTER: 
         case EN::SUBQUERY:
         case EN::ENUMERATE_LIST:
-        case EN::INDEX_RANGE: {
+        case EN::INDEX_RANGE:
+        case EN::HASH_JOIN: {
           // if we found another SortNode, an AggregateNode, FilterNode, a SubqueryNode, 
-          // an EnumerateListNode or an IndexRangeNode
+          // an EnumerateListNode, an IndexRangeNode or a HashJoinNode
           // this means we cannot apply our optimization
           collectionNode = nullptr;
           current = nullptr;
@@ -1093,6 +1095,228 @@ int triagens::aql::moveCalculationsDownRule (Optimizer* opt,
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief check whether an expression only accesses attributes of the
+/// scanned document that can be read by multiple threads at the same time.
+/// _id, _from and _to are built using the transaction's collection name
+/// resolver, which is not thread-safe, so neither these attributes nor the
+/// document as a whole may be used
+////////////////////////////////////////////////////////////////////////////////
+
+static bool CanReadDocumentConcurrently (AstNode const* node,
+                                         Variable const* variable) {
+  if (node->type == NODE_TYPE_ATTRIBUTE_ACCESS) {
+    auto member = node->getMember(0);
+
+    if (member->type == NODE_TYPE_REFERENCE &&
+        static_cast<Variable const*>(member->getData()) == variable) {
+      char const* name = node->getStringValue();
+
+      return (strcmp(name, TRI_VOC_ATTRIBUTE_ID) != 0 &&
+              strcmp(name, TRI_VOC_ATTRIBUTE_FROM) != 0 &&
+              strcmp(name, TRI_VOC_ATTRIBUTE_TO) != 0);
+    }
+  }
+  else if (node->type == NODE_TYPE_REFERENCE) {
+    return (static_cast<Variable const*>(node->getData()) != variable);
+  }
+
+  size_t const n = node->numMembers();
+
+  for (size_t i = 0; i < n; ++i) {
+    if (! CanReadDocumentConcurrently(node->getMemberUnchecked(i), variable)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief let EnumerateCollectionNodes filter their documents with multiple
+/// threads
+/// this rule modifies the plan in place
+/// it looks for a FILTER that directly follows a full collection scan and
+/// only depends on the scanned documents, via deterministic calculations that
+/// can be executed without V8 and do not access _id, _from or _to. the 
+/// calculations and the filter are moved into the EnumerateCollectionNode, 
+/// which then evaluates them on the threads of the shared scan pool
+////////////////////////////////////////////////////////////////////////////////
+
+int triagens::aql::parallelizeCollectionScanRule (Optimizer* opt, 
+                                                  ExecutionPlan* plan, 
+                                                  Optimizer::Rule const* rule) {
+  size_t const parallelism = plan->getAst()->query()->parallelism();
+
+  if (parallelism <= 1 ||
+      Query::ScanPool() == nullptr ||
+      triagens::arango::ServerState::instance()->isRunningInCluster()) {
+    // nothing to do
+    opt->addPlan(plan, rule, false);
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  std::vector<ExecutionNode*>&& nodes = plan->findNodesOfType(EN::ENUMERATE_COLLECTION, true);
+  bool modified = false;
+
+  for (auto const& n : nodes) {
+    auto en = static_cast<EnumerateCollectionNode*>(n);
+
+    if (en->hasParallelFilter()) {
+      continue;
+    }
+
+    // collect the calculations between the collection scan and the filter
+    std::unordered_set<Variable const*> available{ en->outVariable() };
+    std::vector<CalculationNode*> calculations;
+    FilterNode* filter = nullptr;
+
+    auto parents = en->getParents();
+
+    while (parents.size() == 1) {
+      auto current = parents[0];
+
+      if (current->getType() == EN::FILTER) {
+        auto&& used = current->getVariablesUsedHere();
+        TRI_ASSERT(used.size() == 1);
+
+        if (available.find(used[0]) != available.end()) {
+          filter = static_cast<FilterNode*>(current);
+        }
+        break;
+      }
+
+      if (current->getType() != EN::CALCULATION) {
+        break;
+      }
+
+      auto cn = static_cast<CalculationNode*>(current);
+      auto expression = cn->expression();
+
+      if (cn->conditionVariable() != nullptr ||
+          expression->isV8() ||
+          ! expression->isDeterministic() ||
+          ! CanReadDocumentConcurrently(expression->node(), en->outVariable())) {
+        // the expression cannot be executed in another thread
+        break;
+      }
+
+      bool usesOtherVariables = false;
+
+      for (auto const& v : expression->variables()) {
+        if (available.find(v) == available.end()) {
+          usesOtherVariables = true;
+          break;
+        }
+      }
+
+      if (usesOtherVariables) {
+        break;
+      }
+
+      calculations.emplace_back(cn);
+      available.emplace(cn->outVariable());
+
+      parents = current->getParents();
+    }
+
+    if (filter == nullptr) {
+      continue;
+    }
+
+    // calculations whose results are still needed after the filter (directly
+    // or by other calculations that are kept) remain in the plan
+    plan->findVarUsage();
+    std::unordered_set<Variable const*> needed = filter->getVarsUsedLater();
+    std::unordered_set<ExecutionNode*> toUnlink{ filter };
+
+    for (auto it = calculations.rbegin(); it != calculations.rend(); ++it) {
+      auto cn = (*it);
+
+      if (needed.find(cn->outVariable()) != needed.end()) {
+        for (auto const& v : cn->expression()->variables()) {
+          needed.emplace(v);
+        }
+      }
+      else {
+        toUnlink.emplace(cn);
+      }
+    }
+
+    std::vector<std::pair<Variable const*, Expression*>> filterCalculations;
+    filterCalculations.reserve(calculations.size());
+
+    try {
+      for (auto const& cn : calculations) {
+        filterCalculations.emplace_back(std::make_pair(cn->outVariable(), cn->expression()->clone()));
+      }
+    }
+    catch (...) {
+      for (auto& it : filterCalculations) {
+        delete it.second;
+      }
+      throw;
+    }
+
+    en->setParallelFilter(filterCalculations, filter->getVariablesUsedHere()[0], parallelism);
+    plan->unlinkNodes(toUnlink);
+    modified = true;
+  }
+
+  if (modified) {
+    plan->findVarUsage();
+  }
+
+  opt->addPlan(plan, rule, modified);
+
+  return TRI_ERROR_NO_ERROR;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief restrict SortNodes that are directly followed by a LimitNode to
+/// the rows the LimitNode will actually return
+/// this rule modifies the plan in place
+////////////////////////////////////////////////////////////////////////////////
+
+int triagens::aql::sortLimitRule (Optimizer* opt, 
+                                  ExecutionPlan* plan, 
+                                  Optimizer::Rule const* rule) {
+  bool modified = false;
+  std::vector<ExecutionNode*>&& nodes = plan->findNodesOfType(EN::SORT, true);
+
+  for (auto const& n : nodes) {
+    auto sortNode = static_cast<SortNode*>(n);
+    auto const& parents = sortNode->getParents();
+
+    if (parents.size() != 1 || parents[0]->getType() != EN::LIMIT) {
+      continue;
+    }
+
+    auto limitNode = static_cast<LimitNode const*>(parents[0]);
+
+    if (limitNode->fullCount()) {
+      // the LimitNode needs to see all rows to count them
+      continue;
+    }
+
+    size_t const limit = limitNode->offset() + limitNode->limit();
+
+    if (limit == 0 || limit < limitNode->offset()) {
+      // nothing to return, or overflow
+      continue;
+    }
+
+    if (sortNode->limit() != limit) {
+      sortNode->setLimit(limit);
+      modified = true;
+    }
+  }
+
+  opt->addPlan(plan, rule, modified);
+
+  return TRI_ERROR_NO_ERROR;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief determine the "right" type of AggregateNode and 
 /// add a sort node for each COLLECT (note: the sort may be removed later) 
@@ -1401,6 +1625,12 @@ class triagens::aql::RedundantCalculationsReplacer : public WalkerWorker<Executi
           break;
         }
 
+        case EN::HASH_JOIN: {
+          auto node = static_cast<HashJoinNode*>(en);
+          node->inputExpression()->replaceVariables(_replacements);
+          break;
+        }
+
         case EN::AGGREGATE: {
           auto node = static_cast<AggregateNode*>(en);
           for (auto variable : node->_aggregateVariables) {
@@ -2040,6 +2270,7 @@ class FilterToEnumCollFinder : public WalkerWorker<ExecutionNode> {
           return true;
         case EN::SORT:
         case EN::INDEX_RANGE:
+        case EN::HASH_JOIN:
           break;
         case EN::ENUMERATE_COLLECTION: {
           auto node = static_cast<EnumerateCollectionNode*>(en);
@@ -2844,6 +3075,7 @@ class SortToIndexNode : public WalkerWorker<ExecutionNode> {
       case EN::REMOTE:
       case EN::ILLEGAL:
       case EN::LIMIT:                      // LIMIT is criterion to stop
+      case EN::HASH_JOIN:                  // does not keep the order of its input
         return true;  // abort.
 
       case EN::SORT:     // pulling two sorts together is done elsewhere.
@@ -3133,6 +3365,209 @@ int triagens::aql::removeFiltersCoveredByIndexRule (Optimizer* opt,
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief equality condition of a join between the documents of an
+/// EnumerateCollectionNode and the rows coming into it
+////////////////////////////////////////////////////////////////////////////////
+
+struct HashJoinCondition {
+  FilterNode*      filter;
+  CalculationNode* calculation;
+  AstNode const*   collectionSide;
+  AstNode const*   inputSide;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief find a FILTER after an EnumerateCollectionNode that compares an
+/// attribute of the documents with a value computed from the variables that
+/// are valid before the node, e.g. FILTER a.x == b.y
+////////////////////////////////////////////////////////////////////////////////
+
+static bool FindHashJoinCondition (EnumerateCollectionNode const* en,
+                                   HashJoinCondition& result) {
+  Variable const* outVariable = en->outVariable();
+  auto const& valid = en->getVarsValid();
+
+  // only simple expressions can be executed by the HashJoinBlock
+  auto isUsable = [] (AstNode const* node) -> bool {
+    return (node->isSimple() && 
+            node->isDeterministic() &&
+            ! node->canThrow());
+  };
+
+  auto isCollectionSide = [&] (AstNode const* node) -> bool {
+    auto&& vars = Ast::getReferencedVariables(node);
+    return (vars.size() == 1 && *(vars.begin()) == outVariable);
+  };
+
+  auto isInputSide = [&] (AstNode const* node) -> bool {
+    auto&& vars = Ast::getReferencedVariables(node);
+
+    if (vars.empty()) {
+      // comparisons with constants are handled by indexes and filters
+      return false;
+    }
+
+    for (auto const& v : vars) {
+      if (v == outVariable || valid.find(v) == valid.end()) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  std::unordered_map<Variable const*, HashJoinCondition> candidates;
+  auto parents = en->getParents();
+
+  while (parents.size() == 1) {
+    auto current = parents[0];
+
+    if (current->getType() == EN::FILTER) {
+      auto&& used = current->getVariablesUsedHere();
+      TRI_ASSERT(used.size() == 1);
+
+      auto it = candidates.find(used[0]);
+
+      if (it != candidates.end()) {
+        result = (*it).second;
+        result.filter = static_cast<FilterNode*>(current);
+        return true;
+      }
+    }
+    else if (current->getType() == EN::CALCULATION) {
+      auto cn = static_cast<CalculationNode*>(current);
+      auto node = cn->expression()->node();
+
+      if (cn->conditionVariable() == nullptr &&
+          node->type == NODE_TYPE_OPERATOR_BINARY_EQ) {
+        auto lhs = node->getMember(0);
+        auto rhs = node->getMember(1);
+
+        if (isUsable(lhs) && isUsable(rhs)) {
+          HashJoinCondition condition{ nullptr, cn, nullptr, nullptr };
+
+          if (isCollectionSide(lhs) && isInputSide(rhs)) {
+            condition.collectionSide = lhs;
+            condition.inputSide = rhs;
+          }
+          else if (isCollectionSide(rhs) && isInputSide(lhs)) {
+            condition.collectionSide = rhs;
+            condition.inputSide = lhs;
+          }
+
+          if (condition.collectionSide != nullptr) {
+            candidates.emplace(cn->outVariable(), condition);
+          }
+        }
+      }
+    }
+    else {
+      break;
+    }
+
+    parents = current->getParents();
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief replace EnumerateCollectionNodes that are joined to the preceding
+/// loops by an equality condition with HashJoinNodes
+////////////////////////////////////////////////////////////////////////////////
+
+int triagens::aql::useHashJoinRule (Optimizer* opt,
+                                    ExecutionPlan* plan,
+                                    Optimizer::Rule const* rule) {
+  // the original plan is kept as an alternative, so the optimizer can pick
+  // the cheaper of the two
+  opt->addPlan(plan, rule, false);
+
+  if (triagens::arango::ServerState::instance()->isRunningInCluster()) {
+    // HashJoinNodes are not distributed
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  plan->findVarUsage();
+
+  std::vector<ExecutionNode*>&& nodes = plan->findNodesOfType(EN::ENUMERATE_COLLECTION, true);
+  std::vector<std::pair<EnumerateCollectionNode*, HashJoinCondition>> joins;
+
+  for (auto const& n : nodes) {
+    auto en = static_cast<EnumerateCollectionNode*>(n);
+
+    if (en->isRandom() || en->hasParallelFilter()) {
+      continue;
+    }
+
+    HashJoinCondition condition;
+
+    if (FindHashJoinCondition(en, condition)) {
+      joins.emplace_back(std::make_pair(en, condition));
+    }
+  }
+
+  if (joins.empty()) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  std::unique_ptr<ExecutionPlan> newPlan(plan->clone());
+  std::unordered_set<ExecutionNode*> toUnlink;
+
+  for (auto const& it : joins) {
+    // the filter is satisfied by all documents produced by the join. the
+    // calculation may still be used further down
+    auto&& usedLater = it.second.filter->getVarsUsedLater();
+    bool const keepCalculation = (usedLater.find(it.second.calculation->outVariable()) != usedLater.end());
+
+    auto en = static_cast<EnumerateCollectionNode*>(newPlan->getNodeById(it.first->id()));
+    TRI_ASSERT(en != nullptr);
+    auto filter = newPlan->getNodeById(it.second.filter->id());
+    TRI_ASSERT(filter != nullptr);
+    auto cn = newPlan->getNodeById(it.second.calculation->id());
+    TRI_ASSERT(cn != nullptr);
+
+    std::unique_ptr<Expression> collectionExpression(new Expression(newPlan->getAst(), it.second.collectionSide));
+    std::unique_ptr<Expression> inputExpression(new Expression(newPlan->getAst(), it.second.inputSide));
+
+    auto hj = new HashJoinNode(newPlan.get(), 
+                               newPlan->nextId(), 
+                               en->vocbase(), 
+                               const_cast<Collection*>(en->collection()), 
+                               en->outVariable(), 
+                               collectionExpression.get(), 
+                               inputExpression.get(), 
+                               true);
+    collectionExpression.release();
+    inputExpression.release();
+
+    newPlan->registerNode(hj);
+    newPlan->replaceNode(en, hj);
+
+    // build the hash table for the side the cost estimate prefers
+    size_t nrItems;
+    double const hashCollectionCost = hj->estimateCost(nrItems);
+    hj->setHashCollection(false);
+
+    if (hj->estimateCost(nrItems) > hashCollectionCost) {
+      hj->setHashCollection(true);
+    }
+
+    toUnlink.emplace(filter);
+
+    if (! keepCalculation) {
+      toUnlink.emplace(cn);
+    }
+  }
+
+  newPlan->unlinkNodes(toUnlink);
+  newPlan->findVarUsage();
+
+  opt->addPlan(newPlan.release(), rule, true);
+
+  return TRI_ERROR_NO_ERROR;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief helper to compute lots of permutation tuples
 /// a permutation tuple is represented as a single vector together with
@@ -3664,6 +4099,7 @@ int triagens::aql::distributeFilternCalcToClusterRule (Optimizer* opt,
         case EN::SORT:
         case EN::INDEX_RANGE:
         case EN::ENUMERATE_COLLECTION:
+        case EN::HASH_JOIN:
           //do break
           stopSearching = true;
           break;
@@ -3757,6 +4193,7 @@ int triagens::aql::distributeSortToClusterRule (Optimizer* opt,
         case EN::LIMIT:
         case EN::INDEX_RANGE:
         case EN::ENUMERATE_COLLECTION:
+        case EN::HASH_JOIN:
           // For all these, we do not want to pull a SortNode further down
           // out to the DBservers, note that potential FilterNodes and
           // CalculationNodes that can be moved to the DBservers have 
@@ -4030,7 +4467,8 @@ class RemoveToEnumCollFinder : public WalkerWorker<ExecutionNode> {
         case EN::ILLEGAL:
         case EN::LIMIT:           
         case EN::SORT:
-        case EN::INDEX_RANGE: {
+        case EN::INDEX_RANGE:
+        case EN::HASH_JOIN: {
           // if we meet any of the above, then we abort . . .
         }
     }
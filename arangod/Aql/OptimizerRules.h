@@ -98,6 +98,22 @@ namespace triagens {
 
     int moveCalculationsDownRule (Optimizer*, ExecutionPlan*, Optimizer::Rule const*);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief let EnumerateCollectionNodes filter their documents with multiple
+/// threads
+/// this rule modifies the plan in place
+////////////////////////////////////////////////////////////////////////////////
+
+    int parallelizeCollectionScanRule (Optimizer*, ExecutionPlan*, Optimizer::Rule const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief let SortNodes that are directly followed by a LimitNode keep only
+/// the first offset + limit rows in a bounded heap
+/// this rule modifies the plan in place
+////////////////////////////////////////////////////////////////////////////////
+
+    int sortLimitRule (Optimizer*, ExecutionPlan*, Optimizer::Rule const*);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief determine the "right" type of AggregateNode and 
 /// add a sort node for each COLLECT (may be removed later) 
@@ -152,6 +168,14 @@ namespace triagens {
 
     int removeFiltersCoveredByIndexRule (Optimizer*, ExecutionPlan*, Optimizer::Rule const*);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief replace EnumerateCollectionNodes that are joined to the preceding
+/// loops by an equality condition with HashJoinNodes
+/// this rule adds a new plan and keeps the original one
+////////////////////////////////////////////////////////////////////////////////
+
+    int useHashJoinRule (Optimizer*, ExecutionPlan*, Optimizer::Rule const*);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief interchange adjacent EnumerateCollectionNodes in all possible ways
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,519 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Aql, execution plan cache
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2012-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Aql/PlanCache.h"
+#include "Basics/hashes.h"
+#include "Basics/json-utilities.h"
+#include "Basics/ReadLocker.h"
+#include "Basics/WriteLocker.h"
+#include "Basics/Exceptions.h"
+#include "VocBase/vocbase.h"
+
+using namespace triagens::aql;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the type of a bind parameter value, as seen by the plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+static int ParameterType (TRI_json_t const* json) {
+  switch (json->_type) {
+    case TRI_JSON_BOOLEAN:
+      return 1;
+    case TRI_JSON_NUMBER:
+      return 2;
+    case TRI_JSON_STRING:
+    case TRI_JSON_STRING_REFERENCE:
+      return 3;
+    case TRI_JSON_ARRAY:
+      return 4;
+    case TRI_JSON_OBJECT:
+      return 5;
+    default:
+      return 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the number of bind parameters
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t NumberOfParameters (TRI_json_t const* bindParameters) {
+  if (! TRI_IsObjectJson(bindParameters)) {
+    return 0;
+  }
+
+  return TRI_LengthVector(&bindParameters->_value._objects) / 2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not a plan created with the bind parameters of the entry
+/// can be used for the given bind parameters
+////////////////////////////////////////////////////////////////////////////////
+
+static bool MatchesParameters (PlanCacheEntry const* entry,
+                               TRI_json_t const* bindParameters) {
+  size_t const n = NumberOfParameters(entry->bindParameters);
+
+  if (n != NumberOfParameters(bindParameters)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    auto key   = static_cast<TRI_json_t const*>(TRI_AddressVector(&entry->bindParameters->_value._objects, i));
+    auto value = static_cast<TRI_json_t const*>(TRI_AddressVector(&entry->bindParameters->_value._objects, i + 1));
+    auto other = TRI_LookupObjectJson(bindParameters, key->_value._string.data);
+
+    if (other == nullptr ||
+        ParameterType(value) != ParameterType(other)) {
+      return false;
+    }
+
+    if (entry->constantParameters.find(std::string(key->_value._string.data)) != entry->constantParameters.end() &&
+        ! TRI_CheckSameValueJson(value, other)) {
+      // the value was injected into the plan
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                              struct PlanCacheEntry
+// -----------------------------------------------------------------------------
+
+PlanCacheEntry::PlanCacheEntry (uint64_t hash,
+                                std::string const& queryString,
+                                TRI_json_t* bindParameters,
+                                std::unordered_set<std::string> const& constantParameters,
+                                TRI_json_t* options,
+                                TRI_json_t* plan,
+                                std::vector<std::string> const& collections)
+  : hash(hash),
+    queryString(queryString),
+    bindParameters(bindParameters),
+    constantParameters(constantParameters),
+    options(options),
+    plan(plan),
+    collections(collections) {
+
+}
+
+PlanCacheEntry::~PlanCacheEntry () {
+  if (bindParameters != nullptr) {
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, bindParameters);
+  }
+  if (options != nullptr) {
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, options);
+  }
+  if (plan != nullptr) {
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, plan);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   class PlanCache
+// -----------------------------------------------------------------------------
+
+size_t PlanCache::DoDefaultMaxEntries = 256;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+PlanCache::PlanCache (TRI_vocbase_t*)
+  : _lock(),
+    _entries(),
+    _collections(),
+    _invalidated(),
+    _order(),
+    _positions(),
+    _hits(0),
+    _misses(0),
+    _maxEntries(PlanCache::DefaultMaxEntries()) {
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy a plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+PlanCache::~PlanCache () {
+  WRITE_LOCKER(_lock);
+
+  clear();
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the max number of plans to keep
+////////////////////////////////////////////////////////////////////////////////
+
+void PlanCache::maxEntries (size_t value) {
+  // sanity checks
+  if (value > 16384) {
+    value = 16384;
+  }
+
+  WRITE_LOCKER(_lock);
+
+  _maxEntries = value;
+  enforceLimits();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the properties and figures of the cache
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_json_t* PlanCache::toJson (TRI_memory_zone_t* zone) {
+  TRI_json_t* json = TRI_CreateObjectJson(zone, 5);
+
+  if (json == nullptr) {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  }
+
+  uint64_t const hits   = _hits.load();
+  uint64_t const misses = _misses.load();
+  double const hitRate  = (hits + misses > 0) ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+
+  READ_LOCKER(_lock);
+
+  TRI_Insert3ObjectJson(zone, json, "maxEntries", TRI_CreateNumberJson(zone, static_cast<double>(_maxEntries)));
+  TRI_Insert3ObjectJson(zone, json, "entries", TRI_CreateNumberJson(zone, static_cast<double>(_entries.size())));
+  TRI_Insert3ObjectJson(zone, json, "hits", TRI_CreateNumberJson(zone, static_cast<double>(hits)));
+  TRI_Insert3ObjectJson(zone, json, "misses", TRI_CreateNumberJson(zone, static_cast<double>(misses)));
+  TRI_Insert3ObjectJson(zone, json, "hitRate", TRI_CreateNumberJson(zone, hitRate));
+
+  return json;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculate the hash value for a query string, the names and types of
+/// its bind parameters and the options that influence the optimizer
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t PlanCache::hashQuery (char const* queryString,
+                               size_t length,
+                               TRI_json_t const* bindParameters,
+                               TRI_json_t const* options) {
+  uint64_t hash = TRI_FnvHashPointer(queryString, length);
+
+  size_t const n = NumberOfParameters(bindParameters);
+
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    auto key   = static_cast<TRI_json_t const*>(TRI_AddressVector(&bindParameters->_value._objects, i));
+    auto value = static_cast<TRI_json_t const*>(TRI_AddressVector(&bindParameters->_value._objects, i + 1));
+
+    uint64_t h = TRI_FnvHashPointer(key->_value._string.data, key->_value._string.length - 1);
+
+    if (*key->_value._string.data == '@') {
+      // collection names are always part of the plan
+      h ^= TRI_FastHashJson(value);
+    }
+    else {
+      int const type = ParameterType(value);
+      h = TRI_FnvHashBlock(h, &type, sizeof(type));
+    }
+
+    // the order of the bind parameters does not matter
+    hash ^= h;
+  }
+  if (options != nullptr) {
+    // rotate so equal bind parameters and options do not cancel out
+    uint64_t const h = TRI_FastHashJson(options);
+    hash ^= (h << 17) | (h >> 47);
+  }
+
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief look up an execution plan in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_json_t* PlanCache::lookup (uint64_t hash,
+                               char const* queryString,
+                               size_t length,
+                               TRI_json_t const* bindParameters,
+                               TRI_json_t const* options) {
+  {
+    READ_LOCKER(_lock);
+
+    auto it = _entries.find(hash);
+
+    if (it != _entries.end()) {
+      auto entry = (*it).second;
+
+      // protect against hash collisions
+      if (entry->queryString.size() == length &&
+          memcmp(entry->queryString.c_str(), queryString, length) == 0 &&
+          MatchesParameters(entry, bindParameters) &&
+          TRI_CheckSameValueJson(entry->options, options)) {
+        TRI_json_t* copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, entry->plan);
+
+        if (copy == nullptr) {
+          THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+        }
+
+        ++_hits;
+        return copy;
+      }
+    }
+  }
+
+  ++_misses;
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief store an execution plan in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+bool PlanCache::store (uint64_t hash,
+                       char const* queryString,
+                       size_t length,
+                       TRI_json_t const* bindParameters,
+                       std::unordered_set<std::string> const& constantParameters,
+                       TRI_json_t const* options,
+                       TRI_json_t* plan,
+                       std::vector<std::string> const& collections,
+                       TRI_voc_tick_t startTick) {
+  TRI_json_t* bindCopy = nullptr;
+  TRI_json_t* optionsCopy = nullptr;
+
+  if (bindParameters != nullptr) {
+    bindCopy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, bindParameters);
+  }
+  if (options != nullptr) {
+    optionsCopy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, options);
+  }
+
+  std::unique_ptr<PlanCacheEntry> entry;
+
+  try {
+    entry.reset(new PlanCacheEntry(hash, std::string(queryString, length), bindCopy, constantParameters, optionsCopy, plan, collections));
+  }
+  catch (...) {
+    if (bindCopy != nullptr) {
+      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, bindCopy);
+    }
+    if (optionsCopy != nullptr) {
+      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, optionsCopy);
+    }
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, plan);
+    return false;
+  }
+
+  if ((bindParameters != nullptr && bindCopy == nullptr) ||
+      (options != nullptr && optionsCopy == nullptr)) {
+    // out of memory
+    return false;
+  }
+
+  WRITE_LOCKER(_lock);
+
+  if (_maxEntries == 0) {
+    return false;
+  }
+
+  for (auto const& it : collections) {
+    auto it2 = _invalidated.find(it);
+
+    if (it2 != _invalidated.end() && (*it2).second >= startTick) {
+      // the indexes of one of the collections were changed while the query
+      // was optimized. the plan may refer to an index that is gone
+      return false;
+    }
+  }
+
+  auto previous = _entries.find(hash);
+
+  if (previous != _entries.end()) {
+    removeEntry(previous);
+  }
+
+  _order.push_back(hash);
+
+  try {
+    for (auto const& it : collections) {
+      _collections[it].emplace(hash);
+    }
+    _positions.emplace(hash, std::prev(_order.end()));
+    _entries.emplace(hash, entry.get());
+  }
+  catch (...) {
+    for (auto const& it : collections) {
+      auto it2 = _collections.find(it);
+
+      if (it2 != _collections.end()) {
+        (*it2).second.erase(hash);
+      }
+    }
+    _positions.erase(hash);
+    _order.pop_back();
+    return false;
+  }
+
+  entry.release();
+
+  enforceLimits();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all plans that use the given collection
+////////////////////////////////////////////////////////////////////////////////
+
+void PlanCache::invalidate (std::string const& collection,
+                            TRI_voc_tick_t tick) {
+  WRITE_LOCKER(_lock);
+
+  try {
+    auto& last = _invalidated[collection];
+
+    if (tick > last) {
+      last = tick;
+    }
+
+    auto it = _collections.find(collection);
+
+    if (it == _collections.end()) {
+      return;
+    }
+
+    // copy the hashes because removeEntry() modifies the set
+    std::vector<uint64_t> hashes((*it).second.begin(), (*it).second.end());
+
+    for (auto const& hash : hashes) {
+      auto it2 = _entries.find(hash);
+
+      if (it2 != _entries.end()) {
+        removeEntry(it2);
+      }
+    }
+  }
+  catch (...) {
+    // out of memory. better throw away everything than keeping stale plans
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all plans in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+void PlanCache::invalidate () {
+  WRITE_LOCKER(_lock);
+
+  clear();
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove an entry from all lookup structures and free it
+////////////////////////////////////////////////////////////////////////////////
+
+void PlanCache::removeEntry (std::unordered_map<uint64_t, PlanCacheEntry*>::iterator it) {
+  auto entry = (*it).second;
+  uint64_t const hash = entry->hash;
+
+  for (auto const& name : entry->collections) {
+    auto it2 = _collections.find(name);
+
+    if (it2 != _collections.end()) {
+      (*it2).second.erase(hash);
+
+      if ((*it2).second.empty()) {
+        _collections.erase(it2);
+      }
+    }
+  }
+
+  auto position = _positions.find(hash);
+
+  if (position != _positions.end()) {
+    _order.erase((*position).second);
+    _positions.erase(position);
+  }
+
+  _entries.erase(it);
+  delete entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove the oldest entries until the limit is honored
+////////////////////////////////////////////////////////////////////////////////
+
+void PlanCache::enforceLimits () {
+  while (! _order.empty() && _entries.size() > _maxEntries) {
+    auto it = _entries.find(_order.front());
+
+    TRI_ASSERT(it != _entries.end());
+    removeEntry(it);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove all entries
+////////////////////////////////////////////////////////////////////////////////
+
+void PlanCache::clear () {
+  for (auto& it : _entries) {
+    delete it.second;
+  }
+
+  _entries.clear();
+  _collections.clear();
+  _order.clear();
+  _positions.clear();
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Aql, execution plan cache
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2012-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARANGODB_AQL_PLAN_CACHE_H
+#define ARANGODB_AQL_PLAN_CACHE_H 1
+
+#include "Basics/Common.h"
+#include "Basics/json.h"
+#include "Basics/ReadWriteLock.h"
+#include "VocBase/voc-types.h"
+
+struct TRI_vocbase_s;
+
+namespace triagens {
+  namespace aql {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                              struct PlanCacheEntry
+// -----------------------------------------------------------------------------
+
+    struct PlanCacheEntry {
+      PlanCacheEntry (PlanCacheEntry const&) = delete;
+      PlanCacheEntry& operator= (PlanCacheEntry const&) = delete;
+
+      PlanCacheEntry (uint64_t,
+                      std::string const&,
+                      TRI_json_t*,
+                      std::unordered_set<std::string> const&,
+                      TRI_json_t*,
+                      TRI_json_t*,
+                      std::vector<std::string> const&);
+
+      ~PlanCacheEntry ();
+
+      uint64_t const                         hash;
+      std::string const                      queryString;
+      TRI_json_t*                            bindParameters;
+      std::unordered_set<std::string> const  constantParameters;
+      TRI_json_t*                            options;
+      TRI_json_t*                            plan;
+      std::vector<std::string> const         collections;
+    };
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   class PlanCache
+// -----------------------------------------------------------------------------
+
+    class PlanCache {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+      public:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+        explicit PlanCache (struct TRI_vocbase_s*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy a plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+        ~PlanCache ();
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+      public:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the max number of plans to keep
+/// we're not using a lock here for performance reasons - thus concurrent
+/// modifications of this variable are possible but are considered unharmful
+////////////////////////////////////////////////////////////////////////////////
+
+        inline size_t maxEntries () const {
+          return _maxEntries;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the max number of plans to keep. a value of 0 turns off the
+/// plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+        void maxEntries (size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the properties and figures of the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_json_t* toJson (TRI_memory_zone_t*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculate the hash value for a query string, the names and types of
+/// its bind parameters and the options that influence the optimizer
+/// the values of collection bind parameters are part of the hash, the values
+/// of all other bind parameters are not
+////////////////////////////////////////////////////////////////////////////////
+
+        static uint64_t hashQuery (char const*,
+                                   size_t,
+                                   TRI_json_t const*,
+                                   TRI_json_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief look up an execution plan in the cache
+/// a plan matches if the bind parameters have the same names and types as
+/// the ones the plan was created with, and the same values for all bind
+/// parameters that were injected into the plan as constants. returns a copy
+/// of the plan or a nullptr if the query is not contained in the cache. the
+/// values of the other bind parameters must be inserted into the plan by the
+/// caller
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_json_t* lookup (uint64_t,
+                            char const*,
+                            size_t,
+                            TRI_json_t const*,
+                            TRI_json_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief store an execution plan in the cache
+/// the plan is only stored if the indexes of none of the collections used by
+/// the query were changed after the given tick. the cache takes over
+/// ownership of the plan. the plan must contain parameter nodes for all bind
+/// parameters that are not listed as constant parameters
+////////////////////////////////////////////////////////////////////////////////
+
+        bool store (uint64_t,
+                    char const*,
+                    size_t,
+                    TRI_json_t const*,
+                    std::unordered_set<std::string> const&,
+                    TRI_json_t const*,
+                    TRI_json_t*,
+                    std::vector<std::string> const&,
+                    TRI_voc_tick_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all plans that use the given collection
+////////////////////////////////////////////////////////////////////////////////
+
+        void invalidate (std::string const&,
+                         TRI_voc_tick_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all plans in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        void invalidate ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the default max number of plans for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t DefaultMaxEntries () {
+          return DoDefaultMaxEntries;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the default max number of plans for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static void DefaultMaxEntries (size_t value) {
+          DoDefaultMaxEntries = value;
+        }
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove an entry from all lookup structures and free it
+/// must be called with the write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void removeEntry (std::unordered_map<uint64_t, PlanCacheEntry*>::iterator);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove the oldest entries until the limit is honored
+/// must be called with the write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void enforceLimits ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove all entries
+/// must be called with the write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void clear ();
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief r/w lock for the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        triagens::basics::ReadWriteLock _lock;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief cached plans, indexed by query hash
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<uint64_t, PlanCacheEntry*> _entries;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hashes of the cached plans, per collection
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<std::string, std::unordered_set<uint64_t>> _collections;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tick of the last index change, per collection
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<std::string, TRI_voc_tick_t> _invalidated;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hashes of the cached plans, oldest first
+////////////////////////////////////////////////////////////////////////////////
+
+        std::list<uint64_t> _order;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief position of each cached plan in the insertion order list
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<uint64_t, std::list<uint64_t>::iterator> _positions;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of cache hits
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> _hits;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of cache misses
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> _misses;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief max number of plans to keep
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _maxEntries;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default max number of plans for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t DoDefaultMaxEntries;
+    };
+
+  }
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
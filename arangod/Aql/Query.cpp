@@ -34,9 +34,12 @@
 #include "Aql/ExecutionPlan.h"
 #include "Aql/Optimizer.h"
 #include "Aql/Parser.h"
+#include "Aql/PlanCache.h"
+#include "Aql/QueryCache.h"
 #include "Aql/QueryList.h"
 #include "Aql/ShortStringStorage.h"
 #include "Basics/JsonHelper.h"
+#include "Basics/MutexLocker.h"
 #include "Basics/json.h"
 #include "Basics/tri-strings.h"
 #include "Basics/Exceptions.h"
@@ -46,6 +49,8 @@
 #include "Utils/StandaloneTransactionContext.h"
 #include "Utils/V8TransactionContext.h"
 #include "V8Server/ApplicationV8.h"
+#include "V8/v8-conv.h"
+#include "VocBase/server.h"
 #include "VocBase/vocbase.h"
 
 using namespace triagens::aql;
@@ -161,6 +166,24 @@ TRI_json_t* Profile::toJson (TRI_memory_zone_t*) {
           
 bool Query::DoDisableQueryTracking = false;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default memory limit for queries
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t Query::DoDefaultMemoryLimit = 256 * 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief thread pool used for filtering collection scans
+////////////////////////////////////////////////////////////////////////////////
+
+triagens::basics::ThreadPool* Query::DoScanPool = nullptr;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum number of threads a query may use for a collection scan
+////////////////////////////////////////////////////////////////////////////////
+
+size_t const Query::MaxParallelism;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                        constructors / destructors
 // -----------------------------------------------------------------------------
@@ -201,7 +224,8 @@ Query::Query (triagens::arango::ApplicationV8* applicationV8,
     _warnings(),
     _part(part),
     _contextOwnedByExterior(contextOwnedByExterior),
-    _killed(false) {
+    _killed(false),
+    _planCached(false) {
 
   // std::cout << TRI_CurrentThreadId() << ", QUERY " << this << " CTOR: " << queryString << "\n";
 
@@ -249,7 +273,8 @@ Query::Query (triagens::arango::ApplicationV8* applicationV8,
     _warnings(),
     _part(part),
     _contextOwnedByExterior(contextOwnedByExterior),
-    _killed(false) {
+    _killed(false),
+    _planCached(false) {
 
   // std::cout << TRI_CurrentThreadId() << ", QUERY " << this << " CTOR (JSON): " << _queryJson.toString() << "\n";
 
@@ -488,6 +513,8 @@ void Query::registerWarning (int code,
 
   TRI_ASSERT(code != TRI_ERROR_NO_ERROR);
 
+  MUTEX_LOCKER(_warningsLock);
+
   if (_warnings.size() > _maxWarningCount) {
     return;
   }
@@ -510,14 +537,42 @@ void Query::registerWarning (int code,
 QueryResult Query::prepare (QueryRegistry* registry) {
   enterState(PARSING);
 
+  bool const usePlanCache = canUsePlanCache();
+  uint64_t planHash = 0;
+  TRI_voc_tick_t startTick = 0;
+
   try {
     std::unique_ptr<Parser> parser(new Parser(this));
     std::unique_ptr<ExecutionPlan> plan;
+    triagens::basics::Json cachedPlan;
+    triagens::basics::Json planOptions;
+    std::unordered_set<std::string> constantParameters;
+
+    if (usePlanCache) {
+      // look for an already optimized plan of the same query
+      auto planCache = static_cast<PlanCache*>(_vocbase->_planCache);
+      planOptions = getPlanOptions();
+      planHash = PlanCache::hashQuery(_queryString, _queryLength, _bindParameters.json(), planOptions.json());
+
+      TRI_json_t* json = planCache->lookup(planHash, _queryString, _queryLength, _bindParameters.json(), planOptions.json());
+
+      if (json != nullptr) {
+        cachedPlan = triagens::basics::Json(TRI_UNKNOWN_MEM_ZONE, json);
+        _planCached = true;
+      }
+      else {
+        // index changes after this tick will prevent the plan from being cached
+        startTick = TRI_NewTickServer();
+      }
+    }
+
+    bool const parseQuery = (_queryString != nullptr && ! _planCached);
 
-    if (_queryString != nullptr) {
+    if (parseQuery) {
       parser->parse(false);
-      // put in bind parameters
-      parser->ast()->injectBindParameters(_bindParameters);
+      // put in bind parameters. for the plan cache, only the values the
+      // optimizer needs to know become part of the plan
+      parser->ast()->injectBindParameters(_bindParameters, usePlanCache ? &constantParameters : nullptr);
     }
 
     // create the transaction object, but do not start it yet
@@ -526,7 +581,7 @@ QueryResult Query::prepare (QueryRegistry* registry) {
 
     bool planRegisters;
 
-    if (_queryString != nullptr) {
+    if (parseQuery) {
       // we have an AST
       int res = _trx->begin();
 
@@ -556,12 +611,44 @@ QueryResult Query::prepare (QueryRegistry* registry) {
       // Now plan and all derived plans belong to the optimizer
       plan.reset(opt.stealBest()); // Now we own the best one again
       planRegisters = true;
+
+      if (usePlanCache) {
+        // the plan still contains parameter nodes for the bind parameters
+        // that were not injected. store it and instanciate it again with the
+        // values of the bind parameters
+        plan->findVarUsage();
+        plan->planRegisters();
+
+        triagens::basics::Json planJson = plan->toJson(parser->ast(), TRI_UNKNOWN_MEM_ZONE, true);
+
+        if (_warnings.empty()) {
+          // queries that produced warnings are not cached as the warnings 
+          // would get lost
+          TRI_json_t* copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, planJson.json());
+
+          if (copy != nullptr) {
+            auto planCache = static_cast<PlanCache*>(_vocbase->_planCache);
+            planCache->store(planHash, _queryString, _queryLength, _bindParameters.json(), constantParameters, planOptions.json(), copy, _collections.collectionNames(), startTick);
+          }
+        }
+
+        injectBindParameters(parser->ast(), planJson.json());
+        plan.reset(ExecutionPlan::instanciateFromJson(parser->ast(), planJson));
+        planRegisters = false;
+      }
     }
-    else {   // no queryString, we are instanciating from _queryJson
+    else {   // no queryString or a cached plan, we are instanciating from JSON
       enterState(PLAN_INSTANCIATION);
-      ExecutionPlan::getCollectionsFromJson(parser->ast(), _queryJson);
 
-      parser->ast()->variables()->fromJson(_queryJson);
+      if (_planCached) {
+        injectBindParameters(parser->ast(), cachedPlan.json());
+      }
+
+      triagens::basics::Json const& planJson = (_planCached ? cachedPlan : _queryJson);
+
+      ExecutionPlan::getCollectionsFromJson(parser->ast(), planJson);
+
+      parser->ast()->variables()->fromJson(planJson);
       // creating the plan may have produced some collections
       // we need to add them to the transaction now (otherwise the query will fail)
 
@@ -576,7 +663,7 @@ QueryResult Query::prepare (QueryRegistry* registry) {
       }
 
       // we have an execution plan in JSON format
-      plan.reset(ExecutionPlan::instanciateFromJson(parser->ast(), _queryJson));
+      plan.reset(ExecutionPlan::instanciateFromJson(parser->ast(), planJson));
       if (plan.get() == nullptr) {
         // oops
         return QueryResult(TRI_ERROR_INTERNAL);
@@ -614,6 +701,7 @@ QueryResult Query::prepare (QueryRegistry* registry) {
     _plan = plan.release();
     _parser = parser.release();
     _engine = engine;
+
     return QueryResult();
   }
   catch (triagens::basics::Exception const& ex) {
@@ -639,14 +727,41 @@ QueryResult Query::prepare (QueryRegistry* registry) {
 ////////////////////////////////////////////////////////////////////////////////
 
 QueryResult Query::execute (QueryRegistry* registry) {
+  bool const useQueryCache = canUseQueryCache();
+  uint64_t queryHash = 0;
+  TRI_voc_tick_t startTick = 0;
+
   // Now start the execution:
   try {
+    if (useQueryCache) {
+      auto queryCache = static_cast<QueryCache*>(_vocbase->_queryCache);
+      queryHash = QueryCache::hashQuery(_queryString, _queryLength, _bindParameters.json());
+
+      TRI_json_t* cached = queryCache->lookup(queryHash, _queryString, _queryLength, _bindParameters.json());
+
+      if (cached != nullptr) {
+        // cache hit. no need to parse, optimize or execute the query
+        QueryResult result(TRI_ERROR_NO_ERROR);
+        result.warnings = warningsToJson(TRI_UNKNOWN_MEM_ZONE);
+        result.json     = cached;
+        result.cached   = true;
+
+        return result;
+      }
+
+      // any collection modification committed after this tick will prevent
+      // the result from being stored in the cache
+      startTick = TRI_NewTickServer();
+    }
+
     QueryResult res = prepare(registry);
 
     if (res.code != TRI_ERROR_NO_ERROR) {
       return res;
     }
 
+    bool const storeInCache = (useQueryCache && isCacheable());
+
     triagens::basics::Json jsonResult(triagens::basics::Json::Array, 16);
     triagens::basics::Json stats;
 
@@ -680,6 +795,7 @@ QueryResult Query::execute (QueryRegistry* registry) {
     }
 
     stats = _engine->_stats.toJson();
+    stats.set("planCached", triagens::basics::Json(_planCached));
 
     _trx->commit();
     
@@ -687,6 +803,10 @@ QueryResult Query::execute (QueryRegistry* registry) {
 
     enterState(FINALIZATION); 
 
+    if (storeInCache && _warnings.empty()) {
+      static_cast<QueryCache*>(_vocbase->_queryCache)->store(queryHash, _queryString, _queryLength, _bindParameters.json(), jsonResult.json(), _collections.collectionNames(), startTick);
+    }
+
     QueryResult result(TRI_ERROR_NO_ERROR);
     result.warnings = warningsToJson(TRI_UNKNOWN_MEM_ZONE);
     result.json     = jsonResult.steal();
@@ -722,18 +842,53 @@ QueryResult Query::execute (QueryRegistry* registry) {
 ////////////////////////////////////////////////////////////////////////////////
 
 QueryResultV8 Query::executeV8 (v8::Isolate* isolate, QueryRegistry* registry) {
+  bool const useQueryCache = canUseQueryCache();
+  uint64_t queryHash = 0;
+  TRI_voc_tick_t startTick = 0;
 
   // Now start the execution:
   try {
+    if (useQueryCache) {
+      auto queryCache = static_cast<QueryCache*>(_vocbase->_queryCache);
+      queryHash = QueryCache::hashQuery(_queryString, _queryLength, _bindParameters.json());
+
+      TRI_json_t* cached = queryCache->lookup(queryHash, _queryString, _queryLength, _bindParameters.json());
+
+      if (cached != nullptr) {
+        // cache hit. no need to parse, optimize or execute the query
+        triagens::basics::Json json(TRI_UNKNOWN_MEM_ZONE, cached, triagens::basics::Json::AUTOFREE);
+
+        QueryResultV8 result(TRI_ERROR_NO_ERROR);
+        result.result   = v8::Handle<v8::Array>::Cast(TRI_ObjectJson(isolate, json.json()));
+        result.warnings = warningsToJson(TRI_UNKNOWN_MEM_ZONE);
+        result.cached   = true;
+
+        return result;
+      }
+
+      // any collection modification committed after this tick will prevent
+      // the result from being stored in the cache
+      startTick = TRI_NewTickServer();
+    }
+
     QueryResultV8 res = prepare(registry);
     if (res.code != TRI_ERROR_NO_ERROR) {
       return res;
     }
 
+    bool const storeInCache = (useQueryCache && isCacheable());
+
     uint32_t j = 0;
     QueryResultV8 result(TRI_ERROR_NO_ERROR);
     result.result = v8::Array::New(isolate);
     triagens::basics::Json stats;
+
+    // the V8 result cannot be stored in the cache, so a JSON copy of
+    // the result is built only if needed
+    std::unique_ptr<triagens::basics::Json> cacheResult;
+    if (storeInCache) {
+      cacheResult.reset(new triagens::basics::Json(triagens::basics::Json::Array, 16));
+    }
     
     // this is the RegisterId our results can be found in
     auto const resultRegister = _engine->resultRegister();
@@ -751,6 +906,10 @@ QueryResultV8 Query::executeV8 (v8::Isolate* isolate, QueryRegistry* registry) {
 
           if (! val.isEmpty()) {
             result.result->Set(j++, val.toV8(isolate, _trx, doc)); 
+
+            if (cacheResult != nullptr) {
+              cacheResult->add(val.toJson(_trx, doc));
+            }
           }
         }
         delete value;
@@ -763,6 +922,7 @@ QueryResultV8 Query::executeV8 (v8::Isolate* isolate, QueryRegistry* registry) {
     }
 
     stats = _engine->_stats.toJson();
+    stats.set("planCached", triagens::basics::Json(_planCached));
 
     _trx->commit();
     
@@ -770,6 +930,10 @@ QueryResultV8 Query::executeV8 (v8::Isolate* isolate, QueryRegistry* registry) {
 
     enterState(FINALIZATION); 
 
+    if (cacheResult != nullptr && _warnings.empty()) {
+      static_cast<QueryCache*>(_vocbase->_queryCache)->store(queryHash, _queryString, _queryLength, _bindParameters.json(), cacheResult->json(), _collections.collectionNames(), startTick);
+    }
+
     result.warnings = warningsToJson(TRI_UNKNOWN_MEM_ZONE);
     result.stats    = stats.steal(); 
 
@@ -1259,6 +1423,205 @@ void Query::setPlan (ExecutionPlan *plan) {
   _plan = plan;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the query may use the plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+bool Query::canUsePlanCache () const {
+  if (_queryString == nullptr || 
+      _part != PART_MAIN ||
+      _vocbase->_planCache == nullptr) {
+    return false;
+  }
+
+  if (triagens::arango::ServerState::instance()->isCoordinator()) {
+    // the coordinator distributes its plan to the DB servers
+    return false;
+  }
+
+  return (static_cast<PlanCache*>(_vocbase->_planCache)->maxEntries() > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief extract the options that influence the optimizer. these are part
+/// of the plan cache key
+////////////////////////////////////////////////////////////////////////////////
+
+triagens::basics::Json Query::getPlanOptions () const {
+  triagens::basics::Json result(triagens::basics::Json::Object);
+
+  if (! TRI_IsObjectJson(_options)) {
+    return result;
+  }
+
+  for (auto name : { "fullCount", "maxNumberOfPlans", "optimizer", "parallelism" }) {
+    TRI_json_t const* value = TRI_LookupObjectJson(_options, name);
+
+    if (value != nullptr) {
+      result.set(name, triagens::basics::Json(TRI_UNKNOWN_MEM_ZONE, TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, value)));
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief replace the bind parameter nodes in a plan with the values of the
+/// query's bind parameters. plans from the plan cache contain parameter nodes
+/// for all bind parameters that the optimizer did not need to know the values
+/// of
+////////////////////////////////////////////////////////////////////////////////
+
+void Query::injectBindParameters (Ast* ast,
+                                  TRI_json_t* plan) {
+  // JSON representation of the AST nodes for the bind parameter values
+  std::unordered_map<std::string, TRI_json_t*> values;
+  std::string const& parameterType = AstNode::TypeNames.at(static_cast<int>(NODE_TYPE_PARAMETER));
+
+  std::function<void(TRI_json_t*)> inject = [&](TRI_json_t* json) -> void {
+    if (TRI_IsArrayJson(json)) {
+      size_t const n = TRI_LengthArrayJson(json);
+
+      for (size_t i = 0; i < n; ++i) {
+        inject(TRI_LookupArrayJson(json, i));
+      }
+      return;
+    }
+
+    if (! TRI_IsObjectJson(json)) {
+      return;
+    }
+
+    TRI_json_t const* type = TRI_LookupObjectJson(json, "type");
+
+    if (TRI_IsStringJson(type) &&
+        parameterType == type->_value._string.data) {
+      TRI_json_t const* nameJson = TRI_LookupObjectJson(json, "name");
+
+      if (! TRI_IsStringJson(nameJson)) {
+        THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid bind parameter node in plan");
+      }
+
+      std::string const name(nameJson->_value._string.data, nameJson->_value._string.length - 1);
+
+      auto it = values.find(name);
+
+      if (it == values.end()) {
+        TRI_json_t const* value = TRI_LookupObjectJson(_bindParameters.json(), name.c_str());
+
+        if (value == nullptr) {
+          THROW_ARANGO_EXCEPTION_PARAMS(TRI_ERROR_QUERY_BIND_PARAMETER_MISSING, name.c_str());
+        }
+
+        TRI_json_t* node = ast->nodeFromJson(value, false)->toJson(TRI_UNKNOWN_MEM_ZONE, true);
+
+        try {
+          it = values.emplace(name, node).first;
+        }
+        catch (...) {
+          TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, node);
+          throw;
+        }
+      }
+
+      TRI_DestroyJson(TRI_UNKNOWN_MEM_ZONE, json);
+
+      if (TRI_CopyToJson(TRI_UNKNOWN_MEM_ZONE, json, (*it).second) != TRI_ERROR_NO_ERROR) {
+        TRI_InitNullJson(json);
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+      }
+      return;
+    }
+
+    size_t const n = TRI_LengthVector(&json->_value._objects);
+
+    for (size_t i = 1; i < n; i += 2) {
+      inject(static_cast<TRI_json_t*>(TRI_AddressVector(&json->_value._objects, i)));
+    }
+  };
+
+  try {
+    inject(plan);
+  }
+  catch (...) {
+    for (auto& it : values) {
+      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it.second);
+    }
+    throw;
+  }
+
+  for (auto& it : values) {
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, it.second);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the query may be looked up in the query cache
+////////////////////////////////////////////////////////////////////////////////
+
+bool Query::canUseQueryCache () const {
+  if (_queryString == nullptr || 
+      _queryLength == 0 ||
+      _part != PART_MAIN ||
+      _vocbase->_queryCache == nullptr) {
+    return false;
+  }
+
+  if (triagens::arango::ServerState::instance()->isCoordinator()) {
+    // results on the coordinator cannot be invalidated by local writes
+    return false;
+  }
+
+  if (_contextOwnedByExterior && 
+      triagens::arango::V8TransactionContext::IsEmbedded()) {
+    // the query may see uncommitted modifications of the surrounding 
+    // transaction
+    return false;
+  }
+
+  auto mode = static_cast<QueryCache*>(_vocbase->_queryCache)->mode();
+
+  if (mode == CACHE_ALWAYS_ON) {
+    return getBooleanOption("cache", true);
+  }
+  if (mode == CACHE_ON_DEMAND) {
+    return getBooleanOption("cache", false);
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the result of the prepared query may be stored in
+/// the query cache
+////////////////////////////////////////////////////////////////////////////////
+
+bool Query::isCacheable () const {
+  TRI_ASSERT(_plan != nullptr);
+
+  std::vector<ExecutionNode::NodeType> const modificationTypes{
+    ExecutionNode::INSERT,
+    ExecutionNode::REMOVE,
+    ExecutionNode::REPLACE,
+    ExecutionNode::UPDATE,
+    ExecutionNode::UPSERT
+  };
+
+  if (! _plan->findNodesOfType(modificationTypes, true).empty()) {
+    // data-modification queries are never cached
+    return false;
+  }
+
+  for (auto const& node : _plan->findNodesOfType(ExecutionNode::CALCULATION, true)) {
+    if (! static_cast<CalculationNode const*>(node)->expression()->isDeterministic()) {
+      // results of RAND(), DATE_NOW(), DOCUMENT() etc. must be recalculated
+      return false;
+    }
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief create a TransactionContext
 ////////////////////////////////////////////////////////////////////////////////
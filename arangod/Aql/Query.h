@@ -32,6 +32,7 @@
 
 #include "Basics/Common.h"
 #include "Basics/JsonHelper.h"
+#include "Basics/Mutex.h"
 #include "Aql/BindParameters.h"
 #include "Aql/Collections.h"
 #include "Aql/QueryResultV8.h"
@@ -50,6 +51,10 @@ namespace triagens {
     class TransactionContext;
   }
 
+  namespace basics {
+    class ThreadPool;
+  }
+
   namespace aql {
 
     struct AstNode;
@@ -269,6 +274,39 @@ namespace triagens {
           return getBooleanOption("verbosePlans", false);
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief should the execution blocks store their values column by column?
+////////////////////////////////////////////////////////////////////////////////
+
+        bool columnarBlocks () const {  
+          return getBooleanOption("columnarBlocks", false);
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of threads that may be used for scanning a collection
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t parallelism () const {
+          double value = getNumericOption("parallelism", 1.0);
+          if (value > 1.0) {
+            return (std::min)(static_cast<size_t>(value), MaxParallelism);
+          }
+          return 1;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum amount of memory (in bytes) a SORT may use for buffering
+/// rows before it spills sorted runs to disk. 0 means unlimited
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t memoryLimit () const {
+          double value = getNumericOption("memoryLimit", static_cast<double>(DoDefaultMemoryLimit));
+          if (value > 0.0) {
+            return static_cast<size_t>(value);
+          }
+          return 0;
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief should we return all plans?
 ////////////////////////////////////////////////////////////////////////////////
@@ -478,6 +516,38 @@ namespace triagens {
           DoDisableQueryTracking = value;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the default memory limit for queries
+////////////////////////////////////////////////////////////////////////////////
+
+        static uint64_t DefaultMemoryLimit () {
+          return DoDefaultMemoryLimit;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the default memory limit for queries
+////////////////////////////////////////////////////////////////////////////////
+
+        static void DefaultMemoryLimit (uint64_t value) {
+          DoDefaultMemoryLimit = value;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the thread pool used for filtering collection scans
+////////////////////////////////////////////////////////////////////////////////
+
+        static triagens::basics::ThreadPool* ScanPool () {
+          return DoScanPool;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the thread pool used for filtering collection scans
+////////////////////////////////////////////////////////////////////////////////
+
+        static void ScanPool (triagens::basics::ThreadPool* pool) {
+          DoScanPool = pool;
+        }
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                   private methods
 // -----------------------------------------------------------------------------
@@ -527,6 +597,39 @@ namespace triagens {
 
         void cleanupPlanAndEngine (int);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the query may use the plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+        bool canUsePlanCache () const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief extract the options that influence the optimizer
+////////////////////////////////////////////////////////////////////////////////
+
+        triagens::basics::Json getPlanOptions () const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief replace the bind parameter nodes in a plan with the values of the
+/// query's bind parameters
+////////////////////////////////////////////////////////////////////////////////
+
+        void injectBindParameters (Ast*,
+                                   TRI_json_t*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the query may be looked up in the query cache
+////////////////////////////////////////////////////////////////////////////////
+
+        bool canUseQueryCache () const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the result of the prepared query may be stored in
+/// the query cache
+////////////////////////////////////////////////////////////////////////////////
+
+        bool isCacheable () const;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief create a TransactionContext
 ////////////////////////////////////////////////////////////////////////////////
@@ -680,6 +783,13 @@ namespace triagens {
 
         std::vector<std::pair<int, std::string>> _warnings;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lock for the warnings, which may be registered by multiple threads
+/// concurrently
+////////////////////////////////////////////////////////////////////////////////
+
+        triagens::basics::Mutex _warningsLock;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief the query part
 ////////////////////////////////////////////////////////////////////////////////
@@ -698,12 +808,36 @@ namespace triagens {
 
         bool                              _killed;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the execution plan was taken from the plan cache
+////////////////////////////////////////////////////////////////////////////////
+
+        bool                              _planCached;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief whether or not query tracking is disabled globally
 ////////////////////////////////////////////////////////////////////////////////
           
         static bool DoDisableQueryTracking;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default memory limit for queries
+////////////////////////////////////////////////////////////////////////////////
+
+        static uint64_t DoDefaultMemoryLimit;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief thread pool used for filtering collection scans
+////////////////////////////////////////////////////////////////////////////////
+
+        static triagens::basics::ThreadPool* DoScanPool;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum number of threads a query may use for a collection scan
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t const MaxParallelism = 64;
+
     };
 
   }
@@ -0,0 +1,568 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Aql, query results cache
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2012-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Aql/QueryCache.h"
+#include "Basics/hashes.h"
+#include "Basics/json-utilities.h"
+#include "Basics/logging.h"
+#include "Basics/ReadLocker.h"
+#include "Basics/WriteLocker.h"
+#include "Basics/Exceptions.h"
+#include "VocBase/vocbase.h"
+
+using namespace triagens::aql;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief strip leading and trailing whitespace from a query string, so
+/// queries that only differ in surrounding whitespace share a cache entry
+////////////////////////////////////////////////////////////////////////////////
+
+static char const* NormalizeQueryString (char const* queryString,
+                                         size_t& length) {
+  while (length > 0 &&
+         (*queryString == ' ' || *queryString == '\t' ||
+          *queryString == '\r' || *queryString == '\n')) {
+    ++queryString;
+    --length;
+  }
+
+  while (length > 0) {
+    char const c = queryString[length - 1];
+
+    if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+      break;
+    }
+    --length;
+  }
+
+  return queryString;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                             struct QueryCacheEntry
+// -----------------------------------------------------------------------------
+
+QueryCacheEntry::QueryCacheEntry (uint64_t hash,
+                                  std::string const& queryString,
+                                  TRI_json_t* bindParameters,
+                                  TRI_json_t* result,
+                                  std::vector<std::string> const& collections)
+  : hash(hash),
+    queryString(queryString),
+    bindParameters(bindParameters),
+    result(result),
+    collections(collections),
+    memoryUsage(sizeof(QueryCacheEntry) + queryString.size()) {
+
+  memoryUsage += TRI_MemoryUsageJson(bindParameters);
+  memoryUsage += TRI_MemoryUsageJson(result);
+
+  for (auto const& it : collections) {
+    memoryUsage += it.size();
+  }
+}
+
+QueryCacheEntry::~QueryCacheEntry () {
+  if (bindParameters != nullptr) {
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, bindParameters);
+  }
+  if (result != nullptr) {
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, result);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  class QueryCache
+// -----------------------------------------------------------------------------
+
+QueryCacheMode QueryCache::DoDefaultMode     = CACHE_ALWAYS_OFF;
+size_t QueryCache::DoDefaultMaxResults       = 128;
+size_t QueryCache::DoDefaultMaxMemory        = 64 * 1024 * 1024;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a query cache
+////////////////////////////////////////////////////////////////////////////////
+
+QueryCache::QueryCache (TRI_vocbase_t*)
+  : _lock(),
+    _entries(),
+    _collections(),
+    _invalidated(),
+    _order(),
+    _positions(),
+    _memoryUsage(0),
+    _hits(0),
+    _misses(0),
+    _mode(QueryCache::DefaultMode()),
+    _maxResults(QueryCache::DefaultMaxResults()),
+    _maxMemory(QueryCache::DefaultMaxMemory()) {
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy a query cache
+////////////////////////////////////////////////////////////////////////////////
+
+QueryCache::~QueryCache () {
+  WRITE_LOCKER(_lock);
+
+  clear();
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the cache mode. turning the cache off will also clear it
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::mode (QueryCacheMode value) {
+  WRITE_LOCKER(_lock);
+
+  _mode = value;
+
+  if (value == CACHE_ALWAYS_OFF) {
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the max number of results to keep
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::maxResults (size_t value) {
+  // sanity checks
+  if (value > 16384) {
+    value = 16384;
+  }
+
+  WRITE_LOCKER(_lock);
+
+  _maxResults = value;
+  enforceLimits();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the max memory (in bytes) to use for results
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::maxMemory (size_t value) {
+  WRITE_LOCKER(_lock);
+
+  _maxMemory = value;
+  enforceLimits();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the properties and figures of the cache
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_json_t* QueryCache::toJson (TRI_memory_zone_t* zone) {
+  TRI_json_t* json = TRI_CreateObjectJson(zone, 7);
+
+  if (json == nullptr) {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  }
+
+  std::string const mode = modeString(_mode);
+
+  READ_LOCKER(_lock);
+
+  TRI_Insert3ObjectJson(zone, json, "mode", TRI_CreateStringCopyJson(zone, mode.c_str(), mode.size()));
+  TRI_Insert3ObjectJson(zone, json, "maxResults", TRI_CreateNumberJson(zone, static_cast<double>(_maxResults)));
+  TRI_Insert3ObjectJson(zone, json, "maxMemory", TRI_CreateNumberJson(zone, static_cast<double>(_maxMemory)));
+  TRI_Insert3ObjectJson(zone, json, "entries", TRI_CreateNumberJson(zone, static_cast<double>(_entries.size())));
+  TRI_Insert3ObjectJson(zone, json, "memory", TRI_CreateNumberJson(zone, static_cast<double>(_memoryUsage)));
+  TRI_Insert3ObjectJson(zone, json, "hits", TRI_CreateNumberJson(zone, static_cast<double>(_hits.load())));
+  TRI_Insert3ObjectJson(zone, json, "misses", TRI_CreateNumberJson(zone, static_cast<double>(_misses.load())));
+
+  return json;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculate the hash value for a query string and bind parameters
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t QueryCache::hashQuery (char const* queryString,
+                                size_t length,
+                                TRI_json_t const* bindParameters) {
+  queryString = NormalizeQueryString(queryString, length);
+
+  uint64_t hash = TRI_FnvHashPointer(queryString, length);
+
+  if (bindParameters != nullptr) {
+    hash ^= TRI_FastHashJson(bindParameters);
+  }
+
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief look up a query result in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_json_t* QueryCache::lookup (uint64_t hash,
+                                char const* queryString,
+                                size_t length,
+                                TRI_json_t const* bindParameters) {
+  queryString = NormalizeQueryString(queryString, length);
+
+  {
+    READ_LOCKER(_lock);
+
+    auto it = _entries.find(hash);
+
+    if (it != _entries.end()) {
+      auto entry = (*it).second;
+
+      // protect against hash collisions
+      if (entry->queryString.size() == length &&
+          memcmp(entry->queryString.c_str(), queryString, length) == 0 &&
+          TRI_CheckSameValueJson(entry->bindParameters, bindParameters)) {
+        TRI_json_t* copy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, entry->result);
+
+        if (copy == nullptr) {
+          THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+        }
+
+        ++_hits;
+        return copy;
+      }
+    }
+  }
+
+  ++_misses;
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief store a query result in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+bool QueryCache::store (uint64_t hash,
+                        char const* queryString,
+                        size_t length,
+                        TRI_json_t const* bindParameters,
+                        TRI_json_t const* result,
+                        std::vector<std::string> const& collections,
+                        TRI_voc_tick_t startTick) {
+  if (_mode == CACHE_ALWAYS_OFF || result == nullptr) {
+    return false;
+  }
+
+  queryString = NormalizeQueryString(queryString, length);
+
+  // copy the values outside of the lock
+  TRI_json_t* resultCopy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, result);
+
+  if (resultCopy == nullptr) {
+    return false;
+  }
+
+  TRI_json_t* bindCopy = nullptr;
+
+  if (bindParameters != nullptr) {
+    bindCopy = TRI_CopyJson(TRI_UNKNOWN_MEM_ZONE, bindParameters);
+
+    if (bindCopy == nullptr) {
+      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, resultCopy);
+      return false;
+    }
+  }
+
+  std::unique_ptr<QueryCacheEntry> entry;
+
+  try {
+    // the entry takes over ownership of the copies
+    entry.reset(new QueryCacheEntry(hash, std::string(queryString, length), bindCopy, resultCopy, collections));
+  }
+  catch (...) {
+    TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, resultCopy);
+    if (bindCopy != nullptr) {
+      TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, bindCopy);
+    }
+    return false;
+  }
+
+  if (entry->memoryUsage > _maxMemory) {
+    // result is too big to be cached at all
+    return false;
+  }
+
+  WRITE_LOCKER(_lock);
+
+  if (_mode == CACHE_ALWAYS_OFF) {
+    return false;
+  }
+
+  for (auto const& it : collections) {
+    auto it2 = _invalidated.find(it);
+
+    if (it2 != _invalidated.end() && (*it2).second >= startTick) {
+      // one of the collections was modified while the query was running.
+      // the result may already be outdated, so we must not cache it
+      return false;
+    }
+  }
+
+  // remove a previous result for the same hash
+  auto previous = _entries.find(hash);
+
+  if (previous != _entries.end()) {
+    removeEntry(previous);
+  }
+
+  _order.push_back(hash);
+
+  try {
+    for (auto const& it : collections) {
+      _collections[it].emplace(hash);
+    }
+    _positions.emplace(hash, std::prev(_order.end()));
+    _entries.emplace(hash, entry.get());
+  }
+  catch (...) {
+    // roll back whatever was registered so far
+    for (auto const& it : collections) {
+      auto it2 = _collections.find(it);
+
+      if (it2 != _collections.end()) {
+        (*it2).second.erase(hash);
+      }
+    }
+    _positions.erase(hash);
+    _order.pop_back();
+    return false;
+  }
+
+  _memoryUsage += entry->memoryUsage;
+  entry.release();
+
+  enforceLimits();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all results for the given collections
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::invalidate (std::vector<std::string> const& collections,
+                             TRI_voc_tick_t tick) {
+  if (collections.empty()) {
+    return;
+  }
+
+  WRITE_LOCKER(_lock);
+
+  try {
+    for (auto const& it : collections) {
+      invalidateCollection(it, tick);
+    }
+  }
+  catch (...) {
+    // out of memory. better throw away everything than keeping stale results
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all results for a single collection
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::invalidate (std::string const& collection,
+                             TRI_voc_tick_t tick) {
+  WRITE_LOCKER(_lock);
+
+  try {
+    invalidateCollection(collection, tick);
+  }
+  catch (...) {
+    // out of memory. better throw away everything than keeping stale results
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all results in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::invalidate () {
+  WRITE_LOCKER(_lock);
+
+  clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert a cache mode into a string
+////////////////////////////////////////////////////////////////////////////////
+
+std::string QueryCache::modeString (QueryCacheMode mode) {
+  switch (mode) {
+    case CACHE_ALWAYS_ON:
+      return "on";
+    case CACHE_ON_DEMAND:
+      return "demand";
+    case CACHE_ALWAYS_OFF:
+      break;
+  }
+
+  return "off";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert a string into a cache mode
+////////////////////////////////////////////////////////////////////////////////
+
+QueryCacheMode QueryCache::modeFromString (std::string const& mode) {
+  if (mode == "on") {
+    return CACHE_ALWAYS_ON;
+  }
+  if (mode == "demand") {
+    return CACHE_ON_DEMAND;
+  }
+
+  return CACHE_ALWAYS_OFF;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove an entry from all lookup structures and free it
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::removeEntry (std::unordered_map<uint64_t, QueryCacheEntry*>::iterator it) {
+  auto entry = (*it).second;
+  uint64_t const hash = entry->hash;
+
+  for (auto const& name : entry->collections) {
+    auto it2 = _collections.find(name);
+
+    if (it2 != _collections.end()) {
+      (*it2).second.erase(hash);
+
+      if ((*it2).second.empty()) {
+        _collections.erase(it2);
+      }
+    }
+  }
+
+  auto position = _positions.find(hash);
+
+  if (position != _positions.end()) {
+    _order.erase((*position).second);
+    _positions.erase(position);
+  }
+
+  TRI_ASSERT(_memoryUsage >= entry->memoryUsage);
+  _memoryUsage -= entry->memoryUsage;
+
+  _entries.erase(it);
+  delete entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate the results of a single collection
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::invalidateCollection (std::string const& collection,
+                                       TRI_voc_tick_t tick) {
+  auto& last = _invalidated[collection];
+
+  if (tick > last) {
+    last = tick;
+  }
+
+  auto it = _collections.find(collection);
+
+  if (it == _collections.end()) {
+    return;
+  }
+
+  // copy the hashes because removeEntry() modifies the set
+  std::vector<uint64_t> hashes((*it).second.begin(), (*it).second.end());
+
+  for (auto const& hash : hashes) {
+    auto it2 = _entries.find(hash);
+
+    if (it2 != _entries.end()) {
+      removeEntry(it2);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove the oldest entries until the limits are honored
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::enforceLimits () {
+  while (! _order.empty() &&
+         (_entries.size() > _maxResults || _memoryUsage > _maxMemory)) {
+    auto it = _entries.find(_order.front());
+
+    TRI_ASSERT(it != _entries.end());
+    removeEntry(it);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove all entries
+////////////////////////////////////////////////////////////////////////////////
+
+void QueryCache::clear () {
+  for (auto& it : _entries) {
+    delete it.second;
+  }
+
+  _entries.clear();
+  _collections.clear();
+  _order.clear();
+  _positions.clear();
+  _memoryUsage = 0;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
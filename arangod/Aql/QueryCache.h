@@ -0,0 +1,420 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Aql, query results cache
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2012-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARANGODB_AQL_QUERY_CACHE_H
+#define ARANGODB_AQL_QUERY_CACHE_H 1
+
+#include "Basics/Common.h"
+#include "Basics/json.h"
+#include "Basics/ReadWriteLock.h"
+#include "VocBase/voc-types.h"
+
+struct TRI_vocbase_s;
+
+namespace triagens {
+  namespace aql {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                      public types
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief cache mode
+////////////////////////////////////////////////////////////////////////////////
+
+    enum QueryCacheMode {
+      CACHE_ALWAYS_OFF,
+      CACHE_ALWAYS_ON,
+      CACHE_ON_DEMAND
+    };
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                             struct QueryCacheEntry
+// -----------------------------------------------------------------------------
+
+    struct QueryCacheEntry {
+      QueryCacheEntry (QueryCacheEntry const&) = delete;
+      QueryCacheEntry& operator= (QueryCacheEntry const&) = delete;
+
+      QueryCacheEntry (uint64_t,
+                       std::string const&,
+                       TRI_json_t*,
+                       TRI_json_t*,
+                       std::vector<std::string> const&);
+
+      ~QueryCacheEntry ();
+
+      uint64_t const                  hash;
+      std::string const               queryString;
+      TRI_json_t*                     bindParameters;
+      TRI_json_t*                     result;
+      std::vector<std::string> const  collections;
+      size_t                          memoryUsage;
+    };
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  class QueryCache
+// -----------------------------------------------------------------------------
+
+    class QueryCache {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+      public:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a query cache
+////////////////////////////////////////////////////////////////////////////////
+
+        explicit QueryCache (struct TRI_vocbase_s*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy a query cache
+////////////////////////////////////////////////////////////////////////////////
+
+        ~QueryCache ();
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+      public:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the cache mode
+/// we're not using a lock here for performance reasons - thus concurrent
+/// modifications of this variable are possible but are considered unharmful
+////////////////////////////////////////////////////////////////////////////////
+
+        inline QueryCacheMode mode () const {
+          return _mode;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the cache mode. turning the cache off will also clear it
+////////////////////////////////////////////////////////////////////////////////
+
+        void mode (QueryCacheMode);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the max number of results to keep
+////////////////////////////////////////////////////////////////////////////////
+
+        inline size_t maxResults () const {
+          return _maxResults;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the max number of results to keep
+////////////////////////////////////////////////////////////////////////////////
+
+        void maxResults (size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the max memory (in bytes) to use for results
+////////////////////////////////////////////////////////////////////////////////
+
+        inline size_t maxMemory () const {
+          return _maxMemory;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the max memory (in bytes) to use for results
+////////////////////////////////////////////////////////////////////////////////
+
+        void maxMemory (size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the properties and figures of the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_json_t* toJson (TRI_memory_zone_t*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculate the hash value for a query string and bind parameters
+////////////////////////////////////////////////////////////////////////////////
+
+        static uint64_t hashQuery (char const*,
+                                   size_t,
+                                   TRI_json_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief look up a query result in the cache
+/// returns a copy of the cached result or a nullptr if the query is not
+/// contained in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_json_t* lookup (uint64_t,
+                            char const*,
+                            size_t,
+                            TRI_json_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief store a query result in the cache
+/// the result is only stored if none of the collections used by the query
+/// was modified after the given tick. ownership of the result remains with
+/// the caller
+////////////////////////////////////////////////////////////////////////////////
+
+        bool store (uint64_t,
+                    char const*,
+                    size_t,
+                    TRI_json_t const*,
+                    TRI_json_t const*,
+                    std::vector<std::string> const&,
+                    TRI_voc_tick_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all results for the given collections
+////////////////////////////////////////////////////////////////////////////////
+
+        void invalidate (std::vector<std::string> const&,
+                         TRI_voc_tick_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all results for a single collection
+////////////////////////////////////////////////////////////////////////////////
+
+        void invalidate (std::string const&,
+                         TRI_voc_tick_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate all results in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        void invalidate ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert a cache mode into a string
+////////////////////////////////////////////////////////////////////////////////
+
+        static std::string modeString (QueryCacheMode);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief convert a string into a cache mode. unknown modes will turn off
+/// the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        static QueryCacheMode modeFromString (std::string const&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the default cache mode for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static QueryCacheMode DefaultMode () {
+          return DoDefaultMode;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the default cache mode for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static void DefaultMode (QueryCacheMode value) {
+          DoDefaultMode = value;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the default max number of results for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t DefaultMaxResults () {
+          return DoDefaultMaxResults;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the default max number of results for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static void DefaultMaxResults (size_t value) {
+          DoDefaultMaxResults = value;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the default max memory for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t DefaultMaxMemory () {
+          return DoDefaultMaxMemory;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set the default max memory for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static void DefaultMaxMemory (size_t value) {
+          DoDefaultMaxMemory = value;
+        }
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove an entry from all lookup structures and free it
+/// must be called with the write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void removeEntry (std::unordered_map<uint64_t, QueryCacheEntry*>::iterator);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate the results of a single collection
+/// must be called with the write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void invalidateCollection (std::string const&,
+                                   TRI_voc_tick_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove the oldest entries until the limits are honored
+/// must be called with the write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void enforceLimits ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief remove all entries
+/// must be called with the write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void clear ();
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief r/w lock for the cache
+////////////////////////////////////////////////////////////////////////////////
+
+        triagens::basics::ReadWriteLock _lock;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief cached results, indexed by query hash
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<uint64_t, QueryCacheEntry*> _entries;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hashes of the cached results, per collection
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<std::string, std::unordered_set<uint64_t>> _collections;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tick of the last invalidation, per collection
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<std::string, TRI_voc_tick_t> _invalidated;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief hashes of the cached results, oldest first
+////////////////////////////////////////////////////////////////////////////////
+
+        std::list<uint64_t> _order;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief position of each cached result in the insertion order list
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<uint64_t, std::list<uint64_t>::iterator> _positions;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief memory currently used by the cached results
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _memoryUsage;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of cache hits
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> _hits;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of cache misses
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> _misses;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief cache mode
+////////////////////////////////////////////////////////////////////////////////
+
+        QueryCacheMode _mode;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief max number of results to keep
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _maxResults;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief max memory (in bytes) to use for results
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _maxMemory;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default cache mode for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static QueryCacheMode DoDefaultMode;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default max number of results for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t DoDefaultMaxResults;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default max memory for new databases
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t DoDefaultMaxMemory;
+    };
+
+  }
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
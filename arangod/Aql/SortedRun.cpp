@@ -0,0 +1,610 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Aql, sorted run of rows spilled to a temporary file
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2012-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Aql/SortedRun.h"
+#include "Basics/Exceptions.h"
+#include "Basics/files.h"
+#include "Basics/JsonHelper.h"
+#include "Basics/logging.h"
+#include "Utils/AqlTransaction.h"
+
+using namespace triagens::aql;
+using Json = triagens::basics::Json;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief value type markers used in the serialized rows
+////////////////////////////////////////////////////////////////////////////////
+
+static uint8_t const ValueEmpty  = 0;
+static uint8_t const ValueJson   = 1;
+static uint8_t const ValueShaped = 2;
+static uint8_t const ValueRange  = 3;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief size of the write buffer after which it is flushed to disk
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const WriteBufferSize = 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of bytes read ahead from disk
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const ReadBufferSize = 64 * 1024;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief append a fixed-size value to a buffer
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+static inline void AppendValue (std::string& buffer,
+                                T value) {
+  buffer.append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief append a length-prefixed, NUL-terminated string to a buffer
+////////////////////////////////////////////////////////////////////////////////
+
+static inline void AppendString (std::string& buffer,
+                                 char const* value,
+                                 size_t length) {
+  AppendValue<uint32_t>(buffer, static_cast<uint32_t>(length));
+  buffer.append(value, length);
+  buffer.push_back('\0');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read a fixed-size value from a buffer
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+static inline T ReadValue (char const*& p,
+                           char const* end) {
+  if (p + sizeof(T) > end) {
+    THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid sort run data");
+  }
+
+  T value;
+  memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read a length-prefixed, NUL-terminated string from a buffer
+////////////////////////////////////////////////////////////////////////////////
+
+static inline char const* ReadString (char const*& p,
+                                      char const* end,
+                                      size_t& length) {
+  length = ReadValue<uint32_t>(p, end);
+
+  if (p + length + 1 > end || p[length] != '\0') {
+    THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid sort run data");
+  }
+
+  char const* value = p;
+  p += length + 1;
+
+  return value;
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a run, backed by a new temporary file
+////////////////////////////////////////////////////////////////////////////////
+
+SortedRun::SortedRun (triagens::arango::AqlTransaction* trx,
+                      RegisterId nrRegs,
+                      std::vector<TRI_document_collection_t const*> const& collections)
+  : _trx(trx),
+    _nrRegs(nrRegs),
+    _collections(collections),
+    _filename(),
+    _fd(-1),
+    _buffer(),
+    _readBuffer(),
+    _readPosition(0),
+    _readLength(0),
+    _fileSize(0),
+    _fileRead(0),
+    _count(0),
+    _read(0),
+    _head(nullptr) {
+
+  TRI_ASSERT(_collections.size() == _nrRegs);
+
+  char* filename = nullptr;
+  long systemError;
+  std::string errorMessage;
+
+  int res = TRI_GetTempName("aql-sort", &filename, true, systemError, errorMessage);
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_CANNOT_CREATE_TEMP_FILE, errorMessage);
+  }
+
+  _filename = filename;
+  TRI_Free(TRI_CORE_MEM_ZONE, filename);
+
+  _fd = TRI_OPEN(_filename.c_str(), O_RDWR);
+
+  if (_fd < 0) {
+    TRI_UnlinkFile(_filename.c_str());
+    THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_CANNOT_CREATE_TEMP_FILE,
+                                   std::string("cannot open temporary file '") + _filename + "'");
+  }
+
+  LOG_TRACE("created sort run in temporary file '%s'", _filename.c_str());
+
+  try {
+    _buffer.reserve(WriteBufferSize + 4096);
+    _head = new AqlItemBlock(1, _nrRegs);
+
+    for (RegisterId i = 0; i < _nrRegs; ++i) {
+      _head->setDocumentCollection(i, _collections[i]);
+    }
+  }
+  catch (...) {
+    delete _head;
+    TRI_CLOSE(_fd);
+    TRI_UnlinkFile(_filename.c_str());
+    throw;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy the run and remove its temporary file
+////////////////////////////////////////////////////////////////////////////////
+
+SortedRun::~SortedRun () {
+  delete _head;
+
+  if (_fd >= 0) {
+    TRI_CLOSE(_fd);
+    TRI_UnlinkFile(_filename.c_str());
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief append a row of a block to the run
+////////////////////////////////////////////////////////////////////////////////
+
+void SortedRun::add (AqlItemBlock const* block,
+                     size_t row) {
+  TRI_ASSERT(block->getNrRegs() == _nrRegs);
+
+  size_t const start = _buffer.size();
+  // placeholder for the length of the row
+  AppendValue<uint32_t>(_buffer, 0);
+
+  for (RegisterId i = 0; i < _nrRegs; ++i) {
+    AqlValue const& value = block->getValueReference(row, i);
+
+    switch (value._type) {
+      case AqlValue::JSON: {
+        _buffer.push_back(static_cast<char>(ValueJson));
+        encodeJson(value._json->json());
+        break;
+      }
+
+      case AqlValue::SHAPED: {
+        _buffer.push_back(static_cast<char>(ValueShaped));
+        AppendValue<TRI_df_marker_t const*>(_buffer, value._marker);
+        break;
+      }
+
+      case AqlValue::DOCVEC: {
+        Json json(value.toJson(_trx, block->getDocumentCollection(i)));
+        _buffer.push_back(static_cast<char>(ValueJson));
+        encodeJson(json.json());
+        break;
+      }
+
+      case AqlValue::RANGE: {
+        _buffer.push_back(static_cast<char>(ValueRange));
+        AppendValue<int64_t>(_buffer, value._range->_low);
+        AppendValue<int64_t>(_buffer, value._range->_high);
+        break;
+      }
+
+      case AqlValue::EMPTY: {
+        _buffer.push_back(static_cast<char>(ValueEmpty));
+        break;
+      }
+    }
+  }
+
+  uint32_t const length = static_cast<uint32_t>(_buffer.size() - start - sizeof(uint32_t));
+  memcpy(&_buffer[start], &length, sizeof(uint32_t));
+  ++_count;
+
+  if (_buffer.size() >= WriteBufferSize) {
+    flush();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finish writing and prepare the run for reading
+////////////////////////////////////////////////////////////////////////////////
+
+void SortedRun::finish () {
+  flush();
+
+  if (TRI_LSEEK(_fd, 0, SEEK_SET) != 0) {
+    THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_SYS_ERROR,
+                                   std::string("cannot seek in temporary file '") + _filename + "'");
+  }
+
+  std::string().swap(_buffer);
+  _readBuffer.resize(static_cast<size_t>((std::min)(static_cast<uint64_t>(ReadBufferSize), _fileSize)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read the next row into the head block
+////////////////////////////////////////////////////////////////////////////////
+
+bool SortedRun::next () {
+  // free the values of the previous row, if they were not moved elsewhere
+  for (RegisterId i = 0; i < _nrRegs; ++i) {
+    _head->destroyValue(0, i);
+  }
+
+  if (_read == _count) {
+    return false;
+  }
+
+  uint32_t length;
+  read(reinterpret_cast<char*>(&length), sizeof(uint32_t));
+  _buffer.resize(length);
+  read(&_buffer[0], length);
+
+  char const* p = _buffer.c_str();
+  char const* end = p + length;
+
+  for (RegisterId i = 0; i < _nrRegs; ++i) {
+    uint8_t const type = ReadValue<uint8_t>(p, end);
+
+    switch (type) {
+      case ValueEmpty: {
+        break;
+      }
+
+      case ValueJson: {
+        TRI_json_t* json = decodeJson(p, end);
+        Json* wrapped = nullptr;
+
+        try {
+          wrapped = new Json(TRI_UNKNOWN_MEM_ZONE, json);
+        }
+        catch (...) {
+          TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, json);
+          throw;
+        }
+
+        AqlValue a(wrapped);
+
+        try {
+          _head->setValue(0, i, a);
+        }
+        catch (...) {
+          a.destroy();
+          throw;
+        }
+        break;
+      }
+
+      case ValueShaped: {
+        _head->setShaped(0, i, ReadValue<TRI_df_marker_t const*>(p, end));
+        break;
+      }
+
+      case ValueRange: {
+        int64_t const low = ReadValue<int64_t>(p, end);
+        int64_t const high = ReadValue<int64_t>(p, end);
+        AqlValue a(low, high);
+
+        try {
+          _head->setValue(0, i, a);
+        }
+        catch (...) {
+          a.destroy();
+          throw;
+        }
+        break;
+      }
+
+      default: {
+        THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid sort run data");
+      }
+    }
+  }
+
+  ++_read;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief move the values of the current row into a row of another block
+////////////////////////////////////////////////////////////////////////////////
+
+void SortedRun::moveHead (AqlItemBlock* target,
+                          size_t row) {
+  for (RegisterId i = 0; i < _nrRegs; ++i) {
+    AqlValue a = _head->getValue(0, i);
+
+    if (a.isEmpty()) {
+      continue;
+    }
+
+    // if this throws, the value is still owned by the head block
+    target->setValue(row, i, a);
+    _head->eraseValue(0, i);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief serialize a JSON value into the write buffer
+////////////////////////////////////////////////////////////////////////////////
+
+void SortedRun::encodeJson (TRI_json_t const* json) {
+  if (json == nullptr) {
+    _buffer.push_back(static_cast<char>(TRI_JSON_NULL));
+    return;
+  }
+
+  switch (json->_type) {
+    case TRI_JSON_UNUSED:
+    case TRI_JSON_NULL: {
+      _buffer.push_back(static_cast<char>(TRI_JSON_NULL));
+      break;
+    }
+
+    case TRI_JSON_BOOLEAN: {
+      _buffer.push_back(static_cast<char>(TRI_JSON_BOOLEAN));
+      _buffer.push_back(json->_value._boolean ? 1 : 0);
+      break;
+    }
+
+    case TRI_JSON_NUMBER: {
+      _buffer.push_back(static_cast<char>(TRI_JSON_NUMBER));
+      AppendValue<double>(_buffer, json->_value._number);
+      break;
+    }
+
+    case TRI_JSON_STRING:
+    case TRI_JSON_STRING_REFERENCE: {
+      // string references are turned into regular strings
+      _buffer.push_back(static_cast<char>(TRI_JSON_STRING));
+      AppendString(_buffer, json->_value._string.data, json->_value._string.length - 1);
+      break;
+    }
+
+    case TRI_JSON_ARRAY: {
+      size_t const n = TRI_LengthVector(&json->_value._objects);
+
+      _buffer.push_back(static_cast<char>(TRI_JSON_ARRAY));
+      AppendValue<uint32_t>(_buffer, static_cast<uint32_t>(n));
+
+      for (size_t i = 0; i < n; ++i) {
+        encodeJson(static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, i)));
+      }
+      break;
+    }
+
+    case TRI_JSON_OBJECT: {
+      size_t const n = TRI_LengthVector(&json->_value._objects);
+
+      _buffer.push_back(static_cast<char>(TRI_JSON_OBJECT));
+      AppendValue<uint32_t>(_buffer, static_cast<uint32_t>(n / 2));
+
+      for (size_t i = 0; i < n; i += 2) {
+        auto key = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, i));
+        TRI_ASSERT(TRI_IsStringJson(key));
+        AppendString(_buffer, key->_value._string.data, key->_value._string.length - 1);
+        encodeJson(static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, i + 1)));
+      }
+      break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief deserialize a JSON value from the row buffer
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_json_t* SortedRun::decodeJson (char const*& p,
+                                   char const* end) {
+  uint8_t const type = ReadValue<uint8_t>(p, end);
+  TRI_json_t* result = nullptr;
+
+  switch (type) {
+    case TRI_JSON_NULL: {
+      result = TRI_CreateNullJson(TRI_UNKNOWN_MEM_ZONE);
+      break;
+    }
+
+    case TRI_JSON_BOOLEAN: {
+      result = TRI_CreateBooleanJson(TRI_UNKNOWN_MEM_ZONE, ReadValue<uint8_t>(p, end) != 0);
+      break;
+    }
+
+    case TRI_JSON_NUMBER: {
+      result = TRI_CreateNumberJson(TRI_UNKNOWN_MEM_ZONE, ReadValue<double>(p, end));
+      break;
+    }
+
+    case TRI_JSON_STRING: {
+      size_t length;
+      char const* value = ReadString(p, end, length);
+      result = TRI_CreateStringCopyJson(TRI_UNKNOWN_MEM_ZONE, value, length);
+      break;
+    }
+
+    case TRI_JSON_ARRAY: {
+      uint32_t const n = ReadValue<uint32_t>(p, end);
+      result = TRI_CreateArrayJson(TRI_UNKNOWN_MEM_ZONE, static_cast<size_t>(n));
+
+      if (result == nullptr) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+      }
+
+      try {
+        for (uint32_t i = 0; i < n; ++i) {
+          TRI_json_t* sub = decodeJson(p, end);
+
+          if (TRI_PushBack3ArrayJson(TRI_UNKNOWN_MEM_ZONE, result, sub) != TRI_ERROR_NO_ERROR) {
+            THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+          }
+        }
+      }
+      catch (...) {
+        TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, result);
+        throw;
+      }
+      break;
+    }
+
+    case TRI_JSON_OBJECT: {
+      uint32_t const n = ReadValue<uint32_t>(p, end);
+      result = TRI_CreateObjectJson(TRI_UNKNOWN_MEM_ZONE, static_cast<size_t>(n));
+
+      if (result == nullptr) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+      }
+
+      try {
+        for (uint32_t i = 0; i < n; ++i) {
+          size_t length;
+          char const* name = ReadString(p, end, length);
+          TRI_json_t* sub = decodeJson(p, end);
+
+          TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, result, name, sub);
+        }
+      }
+      catch (...) {
+        TRI_FreeJson(TRI_UNKNOWN_MEM_ZONE, result);
+        throw;
+      }
+      break;
+    }
+
+    default: {
+      THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "invalid sort run data");
+    }
+  }
+
+  if (result == nullptr) {
+    THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief write the contents of the write buffer to the file
+////////////////////////////////////////////////////////////////////////////////
+
+void SortedRun::flush () {
+  if (_buffer.empty()) {
+    return;
+  }
+
+  if (! TRI_WritePointer(_fd, _buffer.c_str(), _buffer.size())) {
+    THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_CANNOT_WRITE_FILE,
+                                   std::string("cannot write to temporary file '") + _filename + "'");
+  }
+
+  _fileSize += _buffer.size();
+  _buffer.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read exactly the specified number of bytes from the file
+////////////////////////////////////////////////////////////////////////////////
+
+void SortedRun::read (char* dst,
+                      size_t length) {
+  while (length > 0) {
+    if (_readPosition == _readLength) {
+      // read ahead, but never beyond the data we have written
+      size_t const toRead = static_cast<size_t>((std::min)(static_cast<uint64_t>(_readBuffer.size()), _fileSize - _fileRead));
+
+      if (toRead == 0) {
+        THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_INTERNAL, "unexpected end of sort run");
+      }
+
+      if (! TRI_ReadPointer(_fd, &_readBuffer[0], toRead)) {
+        THROW_ARANGO_EXCEPTION_MESSAGE(TRI_ERROR_SYS_ERROR,
+                                       std::string("cannot read from temporary file '") + _filename + "'");
+      }
+
+      _fileRead += toRead;
+      _readPosition = 0;
+      _readLength = toRead;
+    }
+
+    size_t const n = (std::min)(length, _readLength - _readPosition);
+    memcpy(dst, &_readBuffer[_readPosition], n);
+    _readPosition += n;
+    dst += n;
+    length -= n;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
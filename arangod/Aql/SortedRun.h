@@ -0,0 +1,283 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief Aql, sorted run of rows spilled to a temporary file
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2012-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARANGODB_AQL_SORTED_RUN_H
+#define ARANGODB_AQL_SORTED_RUN_H 1
+
+#include "Basics/Common.h"
+#include "Basics/json.h"
+#include "Aql/AqlItemBlock.h"
+#include "Aql/types.h"
+
+struct TRI_document_collection_t;
+
+namespace triagens {
+  namespace arango {
+    class AqlTransaction;
+  }
+
+  namespace aql {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   class SortedRun
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief a run of already sorted rows that is kept in a temporary file
+///
+/// rows are appended with add() in sort order. after finish() has been
+/// called, the rows can be read back one at a time with next(). the current
+/// row is made available in a single-row AqlItemBlock, so it can be compared
+/// with the same functions that are used for in-memory sorting.
+///
+/// values are written in a compact binary format. documents (SHAPED values)
+/// are stored as pointers only, as their markers are kept alive by the
+/// transaction's ditches for the lifetime of the query. subquery results
+/// (DOCVEC values) are converted into JSON.
+////////////////////////////////////////////////////////////////////////////////
+
+    class SortedRun {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                        constructors / destructors
+// -----------------------------------------------------------------------------
+
+      public:
+
+        SortedRun (SortedRun const&) = delete;
+        SortedRun& operator= (SortedRun const&) = delete;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief create a run, backed by a new temporary file
+////////////////////////////////////////////////////////////////////////////////
+
+        SortedRun (triagens::arango::AqlTransaction*,
+                   RegisterId,
+                   std::vector<TRI_document_collection_t const*> const&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroy the run and remove its temporary file
+////////////////////////////////////////////////////////////////////////////////
+
+        ~SortedRun ();
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                    public methods
+// -----------------------------------------------------------------------------
+
+      public:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief append a row of a block to the run
+////////////////////////////////////////////////////////////////////////////////
+
+        void add (AqlItemBlock const*,
+                  size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finish writing and prepare the run for reading
+////////////////////////////////////////////////////////////////////////////////
+
+        void finish ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read the next row into the head block. returns false if the run
+/// is exhausted
+////////////////////////////////////////////////////////////////////////////////
+
+        bool next ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the head block, containing the current row at position 0
+////////////////////////////////////////////////////////////////////////////////
+
+        AqlItemBlock const* head () const {
+          return _head;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief move the values of the current row into a row of another block.
+/// the head block does not own the values afterwards
+////////////////////////////////////////////////////////////////////////////////
+
+        void moveHead (AqlItemBlock*,
+                       size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of rows in the run
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t count () const {
+          return _count;
+        }
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of rows that were not yet returned by next()
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t remaining () const {
+          return _count - _read;
+        }
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   private methods
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief serialize a JSON value into the write buffer
+////////////////////////////////////////////////////////////////////////////////
+
+        void encodeJson (TRI_json_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief deserialize a JSON value from the row buffer
+////////////////////////////////////////////////////////////////////////////////
+
+        TRI_json_t* decodeJson (char const*&,
+                                char const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief write the contents of the write buffer to the file
+////////////////////////////////////////////////////////////////////////////////
+
+        void flush ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief read exactly the specified number of bytes from the file
+////////////////////////////////////////////////////////////////////////////////
+
+        void read (char*,
+                   size_t);
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+      private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the transaction, used for converting subquery results
+////////////////////////////////////////////////////////////////////////////////
+
+        triagens::arango::AqlTransaction* _trx;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of registers per row
+////////////////////////////////////////////////////////////////////////////////
+
+        RegisterId const _nrRegs;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief document collections of the registers
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<TRI_document_collection_t const*> const _collections;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief name of the temporary file
+////////////////////////////////////////////////////////////////////////////////
+
+        std::string _filename;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief file descriptor of the temporary file
+////////////////////////////////////////////////////////////////////////////////
+
+        int _fd;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief buffer for writing, and for reading back a single row
+////////////////////////////////////////////////////////////////////////////////
+
+        std::string _buffer;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief buffer for reading ahead from the file
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<char> _readBuffer;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief current read position in the read buffer
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _readPosition;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of valid bytes in the read buffer
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _readLength;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of bytes written to the file
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _fileSize;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of bytes read from the file
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _fileRead;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of rows in the run
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _count;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of rows read back
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t _read;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief single-row block containing the current row
+////////////////////////////////////////////////////////////////////////////////
+
+        AqlItemBlock* _head;
+    };
+
+  }
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
@@ -233,6 +233,14 @@ namespace triagens {
           return triagens::basics::JsonHelper::getNumericValue<uint32_t>(_json, "indexBuckets", 1);
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the compressDatafiles flag
+////////////////////////////////////////////////////////////////////////////////
+
+        bool compressDatafiles () const {
+          return triagens::basics::JsonHelper::getBooleanValue(_json, "compressDatafiles", false);
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief returns the shard keys
 ////////////////////////////////////////////////////////////////////////////////
@@ -432,6 +432,17 @@ int figuresOnCoordinator (string const& dbname,
             result->_journalfileSize      += ExtractFigure<int64_t>(figures, "journals", "fileSize");
             result->_compactorfileSize    += ExtractFigure<int64_t>(figures, "compactors", "fileSize");
             result->_shapefileSize        += ExtractFigure<int64_t>(figures, "shapefiles", "fileSize");
+
+            result->_compactionRuns         += ExtractFigure<int64_t>(figures, "compaction", "count");
+            result->_compactionFiles        += ExtractFigure<int64_t>(figures, "compaction", "files");
+            result->_compactionBytesRead    += ExtractFigure<int64_t>(figures, "compaction", "bytesRead");
+            result->_compactionBytesWritten += ExtractFigure<int64_t>(figures, "compaction", "bytesWritten");
+
+            result->_pageFaultsMinor        += ExtractFigure<int64_t>(figures, "pageFaults", "minor");
+            result->_pageFaultsMajor        += ExtractFigure<int64_t>(figures, "pageFaults", "major");
+
+            result->_numberHeaders          += ExtractFigure<TRI_voc_ssize_t>(figures, "headers", "count");
+            result->_sizeHeaders            += ExtractFigure<int64_t>(figures, "headers", "size");
           }
           nrok++;
         }
@@ -587,6 +587,54 @@ int TRI_LookupByKeyHashArrayMulti (TRI_hash_array_multi_t const* array,
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lookups the table elements for multiple keys at once
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_LookupByKeysHashArrayMulti (TRI_hash_array_multi_t const* array,
+                                     std::vector<TRI_index_search_value_t*> const& keys,
+                                     std::vector<TRI_hash_index_element_multi_t*>& result) {
+  TRI_ASSERT_EXPENSIVE(array->_nrUsed < array->_nrAlloc);
+
+  uint64_t const n = array->_nrAlloc;
+  size_t const numKeys = keys.size();
+
+  std::vector<uint64_t> positions;
+  positions.reserve(numKeys);
+
+  // compute all home slots first and prefetch them
+  for (auto key : keys) {
+    uint64_t const i = HashKey(array, key) % n;
+    PR(&array->_table[i]);
+    positions.emplace_back(i);
+  }
+
+  result.clear();
+  result.reserve(numKeys);
+
+  // now probe, the slots should be in the cache by now
+  for (size_t j = 0; j < numKeys; ++j) {
+    TRI_index_search_value_t const* key = keys[j];
+    uint64_t i, k;
+
+    i = k = positions[j];
+  
+    for (; i < n && array->_table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &array->_table[i]); ++i);
+    if (i == n) {
+      for (i = 0; i < k && array->_table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &array->_table[i]); ++i);
+    }
+
+    TRI_ASSERT_EXPENSIVE(i < n);
+
+    if (array->_table[i]._document != nullptr) {
+      result.emplace_back(&array->_table[i]);
+    }
+    else {
+      result.emplace_back(nullptr);
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief adds an element to the array
 ///
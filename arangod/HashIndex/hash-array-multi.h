@@ -146,6 +146,19 @@ int TRI_LookupByKeyHashArrayMulti (TRI_hash_array_multi_t const*,
                                    struct TRI_hash_index_element_multi_s*&,
                                    size_t);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lookups the table elements for multiple keys at once
+///
+/// the home slots of all keys are computed and prefetched before any of them
+/// is probed. the result contains the table element of each key, or NULL if
+/// the key was not found. the element's overflow chain holds the remaining
+/// documents for the key
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_LookupByKeysHashArrayMulti (TRI_hash_array_multi_t const*,
+                                     std::vector<struct TRI_index_search_value_s*> const&,
+                                     std::vector<struct TRI_hash_index_element_multi_s*>&);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief adds an element to the array
 ////////////////////////////////////////////////////////////////////////////////
@@ -33,6 +33,7 @@
 
 #include "Basics/fasthash.h"
 #include "Basics/logging.h"
+#include "Basics/RunInThreads.h"
 #include "HashIndex/hash-index-common.h"
 #include "Indexes/HashIndex.h"
 #include "Indexes/Index.h"
@@ -93,6 +94,44 @@ static bool IsEqualKeyElement (TRI_hash_array_t const* array,
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief determines if two elements have the same key
+////////////////////////////////////////////////////////////////////////////////
+
+static bool IsEqualElementElement (TRI_hash_array_t const* array,
+                                   TRI_hash_index_element_t const* left,
+                                   TRI_hash_index_element_t const* right) {
+  TRI_ASSERT_EXPENSIVE(left->_document != nullptr);
+  TRI_ASSERT_EXPENSIVE(right->_document != nullptr);
+
+  for (size_t j = 0;  j < array->_numFields;  ++j) {
+    TRI_shaped_sub_t* leftSub = &left->_subObjects[j];
+    TRI_shaped_sub_t* rightSub = &right->_subObjects[j];
+
+    if (leftSub->_sid != rightSub->_sid) {
+      return false;
+    }
+
+    char const* leftData;
+    size_t leftLength;
+    TRI_InspectShapedSub(leftSub, left->_document, leftData, leftLength);
+
+    char const* rightData;
+    size_t rightLength;
+    TRI_InspectShapedSub(rightSub, right->_document, rightData, rightLength);
+
+    if (leftLength != rightLength) {
+      return false;
+    }
+
+    if (leftLength > 0 && memcmp(leftData, rightData, leftLength) != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief given a key generates a hash integer
 ////////////////////////////////////////////////////////////////////////////////
@@ -139,14 +178,33 @@ static uint64_t HashElement (TRI_hash_array_t* array,
 // -----------------------------------------------------------------------------
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief initial preallocation size of the hash table when the table is
+/// @brief initial preallocation size of a partition when the table is
 /// first created
 /// setting this to a high value will waste memory but reduce the number of
 /// reallocations/repositionings necessary when the table grows
 ////////////////////////////////////////////////////////////////////////////////
 
 static inline uint64_t InitialSize () {
-  return 251;
+  return 17;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of slots of the previous table that are moved to the new
+/// table of a growing partition per insert or remove
+///
+/// a partition grows when it is half full and the new table becomes half full
+/// only after at least as many inserts as there are slots in the previous
+/// table, so this is more than enough to finish the move in time
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t MigrationSteps () {
+  TRI_IF_FAILURE("HashArray::MigrationSteps") {
+    // leave the elements in the previous tables, so that tests can work on
+    // partitions in the middle of a move
+    return 0;
+  }
+
+  return 4;
 }
 
 // -----------------------------------------------------------------------------
@@ -162,12 +220,38 @@ static inline size_t TableEntrySize () {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief allocate memory for the hash table
+/// @brief return the number of the partition for a hash value
+////////////////////////////////////////////////////////////////////////////////
+
+static inline size_t BucketIndex (uint64_t hash) {
+  static_assert((TRI_HASH_ARRAY_BUCKETS & (TRI_HASH_ARRAY_BUCKETS - 1)) == 0,
+                "number of hash array buckets must be a power of two");
+
+  // use the topmost bits, the lower bits select the slot inside the partition
+  return static_cast<size_t>((hash >> 32) * TRI_HASH_ARRAY_BUCKETS >> 32);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the partition for a hash value
+////////////////////////////////////////////////////////////////////////////////
+
+static inline TRI_hash_array_bucket_t* BucketForHash (TRI_hash_array_t* array,
+                                                      uint64_t hash) {
+  return &array->_buckets[BucketIndex(hash)];
+}
+
+static inline TRI_hash_array_bucket_t const* BucketForHash (TRI_hash_array_t const* array,
+                                                            uint64_t hash) {
+  return BucketForHash(const_cast<TRI_hash_array_t*>(array), hash);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief allocate memory for a hash table
 ///
 /// the hash table memory will be aligned on a cache line boundary
 ////////////////////////////////////////////////////////////////////////////////
 
-static int AllocateTable (TRI_hash_array_t* array,
+static int AllocateTable (TRI_hash_array_bucket_t* bucket,
                           uint64_t numElements) {
   size_t const size = (size_t) (TableEntrySize() * numElements + 64);
 
@@ -177,92 +261,249 @@ static int AllocateTable (TRI_hash_array_t* array,
     return TRI_ERROR_OUT_OF_MEMORY;
   }
 
-  array->_tablePtr = table;
-  array->_table    = static_cast<TRI_hash_index_element_t*>(TRI_Align64(table));
-  array->_nrAlloc  = numElements;
+  bucket->_tablePtr = table;
+  bucket->_table    = static_cast<TRI_hash_index_element_t*>(TRI_Align64(table));
+  bucket->_nrAlloc  = numElements;
 
   return TRI_ERROR_NO_ERROR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief resizes the array
+/// @brief finds the slot of a key in a table
+///
+/// returns the slot of the element with the key, or the empty slot at which
+/// the probe sequence stopped
 ////////////////////////////////////////////////////////////////////////////////
 
-static int ResizeHashArray (triagens::arango::HashIndex* hashIndex,
-                            TRI_hash_array_t* array,
-                            uint64_t targetSize,
-                            bool allowShrink) {
-  if (array->_nrAlloc >= targetSize && ! allowShrink) {
+static uint64_t FindSlotByKey (TRI_hash_array_t const* array,
+                               TRI_hash_index_element_t const* table,
+                               uint64_t n,
+                               TRI_index_search_value_t const* key,
+                               uint64_t hash) {
+  uint64_t i, k;
+
+  i = k = hash % n;
+
+  for (; i < n && table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &table[i]); ++i);
+  if (i == n) {
+    for (i = 0; i < k && table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &table[i]); ++i);
+  }
+
+  TRI_ASSERT_EXPENSIVE(i < n);
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finds the slot of an element's document in a table
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t FindSlotByDocument (TRI_hash_index_element_t const* table,
+                                    uint64_t n,
+                                    TRI_hash_index_element_t const* element,
+                                    uint64_t hash) {
+  uint64_t i, k;
+
+  i = k = hash % n;
+
+  for (; i < n && table[i]._document != nullptr && element->_document != table[i]._document; ++i);
+  if (i == n) {
+    for (i = 0; i < k && table[i]._document != nullptr && element->_document != table[i]._document; ++i);
+  }
+
+  TRI_ASSERT_EXPENSIVE(i < n);
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finds the first empty slot for a hash value in a table
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t FindEmptySlot (TRI_hash_index_element_t const* table,
+                               uint64_t n,
+                               uint64_t hash) {
+  uint64_t i, k;
+
+  i = k = hash % n;
+
+  for (; i < n && table[i]._document != nullptr; ++i);
+  if (i == n) {
+    for (i = 0; i < k && table[i]._document != nullptr; ++i);
+  }
+
+  TRI_ASSERT_EXPENSIVE(i < n);
+
+  return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief closes the gap left by a removed element in a table
+///
+/// the following places are checked for items to move closer together so
+/// that there are no gaps in the probe sequences
+////////////////////////////////////////////////////////////////////////////////
+
+static void CloseGap (TRI_hash_array_t* array,
+                      TRI_hash_index_element_t* table,
+                      uint64_t n,
+                      uint64_t i) {
+  uint64_t k = TRI_IncModU64(i, n);
+
+  while (table[k]._document != nullptr) {
+    uint64_t j = HashElement(array, &table[k]) % n;
+
+    if ((i < k && ! (i < j && j <= k)) || (k < i && ! (i < j || j <= k))) {
+      table[i] = table[k];
+      table[k]._document   = nullptr;
+      table[k]._subObjects = nullptr;
+      i = k;
+    }
+
+    k = TRI_IncModU64(k, n);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief frees the previous table of a partition
+////////////////////////////////////////////////////////////////////////////////
+
+static void FreeOldTable (TRI_hash_array_bucket_t* bucket) {
+  if (bucket->_tableOldPtr != nullptr) {
+    TRI_Free(TRI_UNKNOWN_MEM_ZONE, bucket->_tableOldPtr);
+  }
+
+  bucket->_tableOld    = nullptr;
+  bucket->_tableOldPtr = nullptr;
+  bucket->_nrAllocOld  = 0;
+  bucket->_nrMigrated  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief moves elements from the previous table of a growing partition to
+/// the current one
+///
+/// all slots of the previous table below _nrMigrated are empty. the element
+/// at _nrMigrated is moved and the gap it leaves is closed, which may pull
+/// another element into the slot, so the slot is only skipped once it stays
+/// empty
+////////////////////////////////////////////////////////////////////////////////
+
+static void MigrateBucket (TRI_hash_array_t* array,
+                           TRI_hash_array_bucket_t* bucket,
+                           uint64_t steps) {
+  if (bucket->_tableOld == nullptr) {
+    return;
+  }
+
+  TRI_hash_index_element_t* oldTable = bucket->_tableOld;
+  uint64_t const oldAlloc = bucket->_nrAllocOld;
+
+  while (steps-- > 0 && bucket->_nrMigrated < oldAlloc) {
+    TRI_hash_index_element_t* element = &oldTable[bucket->_nrMigrated];
+
+    if (element->_document == nullptr) {
+      ++bucket->_nrMigrated;
+      continue;
+    }
+
+    uint64_t const i = FindEmptySlot(bucket->_table, bucket->_nrAlloc, HashElement(array, element));
+
+    // ...........................................................................
+    // memcpy ok here since are simply moving array items internally
+    // ...........................................................................
+
+    memcpy(&bucket->_table[i], element, TableEntrySize());
+    element->_document   = nullptr;
+    element->_subObjects = nullptr;
+
+    CloseGap(array, oldTable, oldAlloc, bucket->_nrMigrated);
+  }
+
+  if (bucket->_nrMigrated == oldAlloc) {
+    FreeOldTable(bucket);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief resizes a partition
+///
+/// if incremental is true, the elements are moved to the new table by the
+/// following inserts and removals in the partition. otherwise, they are
+/// rehashed at once
+////////////////////////////////////////////////////////////////////////////////
+
+static int ResizeBucket (triagens::arango::HashIndex* hashIndex,
+                         TRI_hash_array_t* array,
+                         TRI_hash_array_bucket_t* bucket,
+                         uint64_t targetSize,
+                         bool allowShrink,
+                         bool incremental) {
+  if (bucket->_nrAlloc >= targetSize && ! allowShrink) {
     return TRI_ERROR_NO_ERROR;
   }
-  
+
+  TRI_ASSERT(targetSize > 0);
+
+  // a partition is only resized again after the previous move has finished
+  MigrateBucket(array, bucket, UINT64_MAX);
+  TRI_ASSERT(bucket->_tableOld == nullptr);
+
   // only log performance infos for indexes with more than this number of entries
-  static uint64_t const NotificationSizeThreshold = 131072; 
+  static uint64_t const NotificationSizeThreshold = 131072;
+
+  bool const notify = (! incremental && targetSize > NotificationSizeThreshold);
 
   double start = TRI_microtime();
-  if (targetSize > NotificationSizeThreshold) {
-    LOG_ACTION("index-resize %s, target size: %llu", 
+  if (notify) {
+    LOG_ACTION("index-resize %s, target size: %llu",
                hashIndex->context().c_str(),
                (unsigned long long) targetSize);
   }
 
-  TRI_hash_index_element_t* oldTable    = array->_table;
-  TRI_hash_index_element_t* oldTablePtr = array->_tablePtr;
-  uint64_t oldAlloc = array->_nrAlloc;
+  TRI_hash_index_element_t* oldTable    = bucket->_table;
+  TRI_hash_index_element_t* oldTablePtr = bucket->_tablePtr;
+  uint64_t oldAlloc = bucket->_nrAlloc;
 
-  TRI_ASSERT(targetSize > 0);
-
-  int res = AllocateTable(array, targetSize);
+  int res = AllocateTable(bucket, targetSize);
 
   if (res != TRI_ERROR_NO_ERROR) {
     return res;
   }
 
-  if (array->_nrUsed > 0) {
-    uint64_t const n = array->_nrAlloc;
-
-    for (uint64_t j = 0; j < oldAlloc; j++) {
-      TRI_hash_index_element_t* element = &oldTable[j];
-
-      if (element->_document != nullptr) {
-        uint64_t i, k;
-        i = k = HashElement(array, element) % n;
-
-        for (; i < n && array->_table[i]._document != nullptr; ++i);
-        if (i == n) {
-          for (i = 0; i < k && array->_table[i]._document != nullptr; ++i);
-        }
-
-        TRI_ASSERT_EXPENSIVE(i < n);
+  if (bucket->_nrUsed == 0) {
+    TRI_Free(TRI_UNKNOWN_MEM_ZONE, oldTablePtr);
+    return TRI_ERROR_NO_ERROR;
+  }
 
-        // ...........................................................................
-        // add a new element to the associative array
-        // memcpy ok here since are simply moving array items internally
-        // ...........................................................................
+  bucket->_tableOld    = oldTable;
+  bucket->_tableOldPtr = oldTablePtr;
+  bucket->_nrAllocOld  = oldAlloc;
+  bucket->_nrMigrated  = 0;
 
-        memcpy(&array->_table[i], element, TableEntrySize());
-      }
-    }
+  if (! incremental) {
+    MigrateBucket(array, bucket, UINT64_MAX);
   }
 
-  TRI_Free(TRI_UNKNOWN_MEM_ZONE, oldTablePtr);
-  
-  LOG_TIMER((TRI_microtime() - start),
-            "index-resize %s, target size: %llu", 
-            hashIndex->context().c_str(),
-            (unsigned long long) targetSize);
+  if (notify) {
+    LOG_TIMER((TRI_microtime() - start),
+              "index-resize %s, target size: %llu",
+              hashIndex->context().c_str(),
+              (unsigned long long) targetSize);
+  }
 
   return TRI_ERROR_NO_ERROR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief triggers a resize if necessary
+/// @brief triggers a resize of a partition if necessary
 ////////////////////////////////////////////////////////////////////////////////
 
 static bool CheckResize (triagens::arango::HashIndex* hashIndex,
-                         TRI_hash_array_t* array) {
-  if (array->_nrAlloc < 2 * array->_nrUsed) {
-    int res = ResizeHashArray(hashIndex, array, 2 * array->_nrAlloc + 1, false);
+                         TRI_hash_array_t* array,
+                         TRI_hash_array_bucket_t* bucket) {
+  if (bucket->_nrAlloc < 2 * bucket->_nrUsed) {
+    int res = ResizeBucket(hashIndex, array, bucket, 2 * bucket->_nrAlloc + 1, false, true);
 
     if (res != TRI_ERROR_NO_ERROR) {
       return false;
@@ -272,6 +513,31 @@ static bool CheckResize (triagens::arango::HashIndex* hashIndex,
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief destroys the elements of a table and frees it
+////////////////////////////////////////////////////////////////////////////////
+
+static void DestroyTable (TRI_hash_array_t* array,
+                          TRI_hash_index_element_t* table,
+                          TRI_hash_index_element_t* tablePtr,
+                          uint64_t n) {
+  // the table might be NULL if array initialisation fails
+  if (table == nullptr) {
+    return;
+  }
+
+  TRI_hash_index_element_t* p = table;
+  TRI_hash_index_element_t* e = p + n;
+
+  for (;  p < e;  ++p) {
+    if (p->_document != nullptr) {
+      DestroyElement(array, p);
+    }
+  }
+
+  TRI_Free(TRI_UNKNOWN_MEM_ZONE, tablePtr);
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                      constructors and destructors
 // -----------------------------------------------------------------------------
@@ -286,12 +552,31 @@ int TRI_InitHashArray (TRI_hash_array_t* array,
   TRI_ASSERT(numFields > 0);
 
   array->_numFields = numFields;
-  array->_tablePtr  = nullptr;
-  array->_table     = nullptr;
   array->_nrUsed    = 0;
-  array->_nrAlloc   = 0;
 
-  return AllocateTable(array, InitialSize());
+  for (size_t b = 0; b < TRI_HASH_ARRAY_BUCKETS; ++b) {
+    TRI_hash_array_bucket_t* bucket = &array->_buckets[b];
+
+    bucket->_tablePtr    = nullptr;
+    bucket->_table       = nullptr;
+    bucket->_nrUsed      = 0;
+    bucket->_nrAlloc     = 0;
+    bucket->_tableOldPtr = nullptr;
+    bucket->_tableOld    = nullptr;
+    bucket->_nrAllocOld  = 0;
+    bucket->_nrMigrated  = 0;
+  }
+
+  for (size_t b = 0; b < TRI_HASH_ARRAY_BUCKETS; ++b) {
+    int res = AllocateTable(&array->_buckets[b], InitialSize());
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      TRI_DestroyHashArray(array);
+      return res;
+    }
+  }
+
+  return TRI_ERROR_NO_ERROR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -307,21 +592,16 @@ void TRI_DestroyHashArray (TRI_hash_array_t* array) {
   // Go through each item in the array and remove any internal allocated memory
   // ...........................................................................
 
-  // array->_table might be NULL if array initialisation fails
-  if (array->_table != nullptr) {
-    TRI_hash_index_element_t* p;
-    TRI_hash_index_element_t* e;
-
-    p = array->_table;
-    e = p + array->_nrAlloc;
+  for (size_t b = 0; b < TRI_HASH_ARRAY_BUCKETS; ++b) {
+    TRI_hash_array_bucket_t* bucket = &array->_buckets[b];
 
-    for (;  p < e;  ++p) {
-      if (p->_document != nullptr) {
-        DestroyElement(array, p);
-      }
-    }
+    DestroyTable(array, bucket->_table, bucket->_tablePtr, bucket->_nrAlloc);
+    DestroyTable(array, bucket->_tableOld, bucket->_tableOldPtr, bucket->_nrAllocOld);
 
-    TRI_Free(TRI_UNKNOWN_MEM_ZONE, array->_tablePtr);
+    bucket->_table       = nullptr;
+    bucket->_tablePtr    = nullptr;
+    bucket->_tableOld    = nullptr;
+    bucket->_tableOldPtr = nullptr;
   }
 }
 
@@ -349,7 +629,18 @@ size_t TRI_MemoryUsageHashArray (TRI_hash_array_t const* array) {
     return 0;
   }
 
-  size_t tableSize  = (size_t) (array->_nrAlloc * TableEntrySize() + 64);
+  size_t tableSize = 0;
+
+  for (size_t b = 0; b < TRI_HASH_ARRAY_BUCKETS; ++b) {
+    TRI_hash_array_bucket_t const* bucket = &array->_buckets[b];
+
+    tableSize += (size_t) (bucket->_nrAlloc * TableEntrySize() + 64);
+
+    if (bucket->_tableOld != nullptr) {
+      tableSize += (size_t) (bucket->_nrAllocOld * TableEntrySize() + 64);
+    }
+  }
+
   size_t memberSize = (size_t) (array->_nrUsed * array->_numFields * sizeof(TRI_shaped_sub_t));
 
   return (size_t) (tableSize + memberSize);
@@ -362,32 +653,46 @@ size_t TRI_MemoryUsageHashArray (TRI_hash_array_t const* array) {
 int TRI_ResizeHashArray (triagens::arango::HashIndex* hashIndex,
                          TRI_hash_array_t* array,
                          size_t size) {
-  return ResizeHashArray(hashIndex, array, (uint64_t) (2 * size + 1), false);
+  uint64_t const targetSize = (uint64_t) (2 * (size / TRI_HASH_ARRAY_BUCKETS + 1) + 1);
+
+  for (size_t b = 0; b < TRI_HASH_ARRAY_BUCKETS; ++b) {
+    int res = ResizeBucket(hashIndex, array, &array->_buckets[b], targetSize, false, false);
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      return res;
+    }
+  }
+
+  return TRI_ERROR_NO_ERROR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief lookups an element given a key
+///
+/// if the key is not found, the empty slot of the current table of its
+/// partition is returned
 ////////////////////////////////////////////////////////////////////////////////
 
 TRI_hash_index_element_t* TRI_LookupByKeyHashArray (TRI_hash_array_t const* array,
                                                     TRI_index_search_value_t* key) {
-  uint64_t const n = array->_nrAlloc;
-  uint64_t i, k;
+  uint64_t const hash = HashKey(array, key);
+  TRI_hash_array_bucket_t const* bucket = BucketForHash(array, hash);
 
-  i = k = HashKey(array, key) % n;
+  uint64_t i = FindSlotByKey(array, bucket->_table, bucket->_nrAlloc, key, hash);
 
-  for (; i < n && array->_table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &array->_table[i]); ++i);
-  if (i == n) {
-    for (i = 0; i < k && array->_table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &array->_table[i]); ++i);
-  }
+  if (bucket->_table[i]._document == nullptr && bucket->_tableOld != nullptr) {
+    uint64_t j = FindSlotByKey(array, bucket->_tableOld, bucket->_nrAllocOld, key, hash);
 
-  TRI_ASSERT_EXPENSIVE(i < n);
+    if (bucket->_tableOld[j]._document != nullptr) {
+      return &bucket->_tableOld[j];
+    }
+  }
 
   // ...........................................................................
   // return whatever we found
   // ...........................................................................
 
-  return &array->_table[i];
+  return &bucket->_table[i];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -405,6 +710,62 @@ TRI_hash_index_element_t* TRI_FindByKeyHashArray (TRI_hash_array_t const* array,
   return nullptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finds the elements for multiple keys at once
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_FindByKeysHashArray (TRI_hash_array_t const* array,
+                              std::vector<TRI_index_search_value_t*> const& keys,
+                              std::vector<TRI_hash_index_element_t*>& result) {
+  size_t const numKeys = keys.size();
+
+  std::vector<uint64_t> hashes;
+  hashes.reserve(numKeys);
+
+  // ...........................................................................
+  // compute all home slots first and prefetch them
+  // ...........................................................................
+
+  for (auto key : keys) {
+    uint64_t const hash = HashKey(array, key);
+    TRI_hash_array_bucket_t const* bucket = BucketForHash(array, hash);
+
+    PR(&bucket->_table[hash % bucket->_nrAlloc]);
+    hashes.emplace_back(hash);
+  }
+
+  result.clear();
+  result.reserve(numKeys);
+
+  // ...........................................................................
+  // now probe, the slots should be in the cache by now
+  // ...........................................................................
+
+  for (size_t j = 0; j < numKeys; ++j) {
+    TRI_index_search_value_t* key = keys[j];
+    uint64_t const hash = hashes[j];
+    TRI_hash_array_bucket_t const* bucket = BucketForHash(array, hash);
+
+    uint64_t i = FindSlotByKey(array, bucket->_table, bucket->_nrAlloc, key, hash);
+
+    if (bucket->_table[i]._document != nullptr) {
+      result.emplace_back(&bucket->_table[i]);
+      continue;
+    }
+
+    if (bucket->_tableOld != nullptr) {
+      i = FindSlotByKey(array, bucket->_tableOld, bucket->_nrAllocOld, key, hash);
+
+      if (bucket->_tableOld[i]._document != nullptr) {
+        result.emplace_back(&bucket->_tableOld[i]);
+        continue;
+      }
+    }
+
+    result.emplace_back(nullptr);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief adds an key/element to the array
 ///
@@ -417,32 +778,38 @@ int TRI_InsertKeyHashArray (triagens::arango::HashIndex* hashIndex,
                             TRI_index_search_value_t const* key,
                             TRI_hash_index_element_t const* element,
                             bool isRollback) {
+  uint64_t const hash = HashKey(array, key);
+  TRI_hash_array_bucket_t* bucket = BucketForHash(array, hash);
+
+  // ...........................................................................
+  // continue moving the elements of a growing partition
+  // ...........................................................................
+
+  MigrateBucket(array, bucket, MigrationSteps());
 
   // ...........................................................................
-  // we are adding and the table is more than half full, extend it
+  // we are adding and the partition is more than half full, extend it
   // ...........................................................................
 
-  if (! CheckResize(hashIndex, array)) {
+  if (! CheckResize(hashIndex, array, bucket)) {
     return TRI_ERROR_OUT_OF_MEMORY;
   }
 
-  const uint64_t n = array->_nrAlloc;
-  uint64_t i, k;
+  // ...........................................................................
+  // if we found an element, return
+  // ...........................................................................
 
-  i = k = HashKey(array, key) % n;
+  if (bucket->_tableOld != nullptr) {
+    uint64_t j = FindSlotByKey(array, bucket->_tableOld, bucket->_nrAllocOld, key, hash);
 
-  for (; i < n && array->_table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &array->_table[i]); ++i);
-  if (i == n) {
-    for (i = 0; i < k && array->_table[i]._document != nullptr && ! IsEqualKeyElement(array, key, &array->_table[i]); ++i);
+    if (bucket->_tableOld[j]._document != nullptr) {
+      return TRI_ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED;
+    }
   }
 
-  TRI_ASSERT_EXPENSIVE(i < n);
+  uint64_t i = FindSlotByKey(array, bucket->_table, bucket->_nrAlloc, key, hash);
 
-  TRI_hash_index_element_t* arrayElement = &array->_table[i];
-
-  // ...........................................................................
-  // if we found an element, return
-  // ...........................................................................
+  TRI_hash_index_element_t* arrayElement = &bucket->_table[i];
 
   bool found = (arrayElement->_document != nullptr);
 
@@ -451,11 +818,169 @@ int TRI_InsertKeyHashArray (triagens::arango::HashIndex* hashIndex,
   }
 
   *arrayElement = *element;
+  bucket->_nrUsed++;
   array->_nrUsed++;
 
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief adds many elements to an empty array at once
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_BulkInsertHashArray (triagens::arango::HashIndex* hashIndex,
+                             TRI_hash_array_t* array,
+                             std::vector<TRI_hash_index_element_t> const& elements,
+                             triagens::basics::ThreadPool* pool) {
+  TRI_ASSERT(array->_nrUsed == 0);
+
+  size_t const n = elements.size();
+  size_t const numThreads = (pool == nullptr ? 1 : pool->numThreads() + 1);
+
+  size_t const perThread = (n + numThreads - 1) / numThreads;
+
+  // ...........................................................................
+  // hash all elements and count them per thread and partition
+  // ...........................................................................
+
+  std::vector<uint64_t> hashes(n);
+  std::vector<size_t> counts(numThreads * TRI_HASH_ARRAY_BUCKETS, 0);
+
+  triagens::basics::RunInThreads(pool, numThreads, [&] (size_t thread) -> void {
+    size_t const from = thread * perThread;
+    size_t const to = (std::min)(from + perThread, n);
+    size_t* threadCounts = &counts[thread * TRI_HASH_ARRAY_BUCKETS];
+
+    for (size_t i = from; i < to; ++i) {
+      uint64_t const hash = HashElement(array, const_cast<TRI_hash_index_element_t*>(&elements[i]));
+      hashes[i] = hash;
+      ++threadCounts[BucketIndex(hash)];
+    }
+  });
+
+  // ...........................................................................
+  // scatter the elements into their partitions, every thread writes to its
+  // own range in each partition
+  // ...........................................................................
+
+  std::vector<size_t> bucketStart(TRI_HASH_ARRAY_BUCKETS + 1);
+  std::vector<size_t> offsets(numThreads * TRI_HASH_ARRAY_BUCKETS);
+  size_t total = 0;
+
+  for (size_t b = 0; b < TRI_HASH_ARRAY_BUCKETS; ++b) {
+    bucketStart[b] = total;
+
+    for (size_t t = 0; t < numThreads; ++t) {
+      offsets[t * TRI_HASH_ARRAY_BUCKETS + b] = total;
+      total += counts[t * TRI_HASH_ARRAY_BUCKETS + b];
+    }
+  }
+
+  bucketStart[TRI_HASH_ARRAY_BUCKETS] = total;
+  TRI_ASSERT(total == n);
+
+  // pairs of hash value and position in elements
+  std::vector<std::pair<uint64_t, size_t>> scattered(n);
+
+  triagens::basics::RunInThreads(pool, numThreads, [&] (size_t thread) -> void {
+    size_t const from = thread * perThread;
+    size_t const to = (std::min)(from + perThread, n);
+    size_t* threadOffsets = &offsets[thread * TRI_HASH_ARRAY_BUCKETS];
+
+    for (size_t i = from; i < to; ++i) {
+      scattered[threadOffsets[BucketIndex(hashes[i])]++] = std::make_pair(hashes[i], i);
+    }
+  });
+
+  // ...........................................................................
+  // size each partition for its elements, so that no resize happens below
+  // ...........................................................................
+
+  for (size_t b = 0; b < TRI_HASH_ARRAY_BUCKETS; ++b) {
+    uint64_t const count = static_cast<uint64_t>(bucketStart[b + 1] - bucketStart[b]);
+
+    int res = ResizeBucket(hashIndex, array, &array->_buckets[b], 2 * count + 1, false, false);
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      return res;
+    }
+  }
+
+  // ...........................................................................
+  // sort each partition by home slot and hash value. elements with the same
+  // key have the same hash value and are now next to each other, so the
+  // uniqueness can be checked with a single pass
+  // ...........................................................................
+
+  std::atomic<int> result(TRI_ERROR_NO_ERROR);
+  size_t const bucketThreads = (std::min)(numThreads, static_cast<size_t>(TRI_HASH_ARRAY_BUCKETS));
+
+  triagens::basics::RunInThreads(pool, bucketThreads, [&] (size_t thread) -> void {
+    for (size_t b = thread; b < TRI_HASH_ARRAY_BUCKETS; b += bucketThreads) {
+      uint64_t const nrAlloc = array->_buckets[b]._nrAlloc;
+      auto begin = scattered.begin() + bucketStart[b];
+      auto end = scattered.begin() + bucketStart[b + 1];
+
+      std::sort(begin, end, [nrAlloc] (std::pair<uint64_t, size_t> const& left,
+                                       std::pair<uint64_t, size_t> const& right) -> bool {
+        uint64_t const leftSlot = left.first % nrAlloc;
+        uint64_t const rightSlot = right.first % nrAlloc;
+
+        if (leftSlot != rightSlot) {
+          return leftSlot < rightSlot;
+        }
+        return left.first < right.first;
+      });
+
+      for (auto it = begin; it != end; ) {
+        // compare all elements with the same hash value
+        auto runEnd = it + 1;
+        while (runEnd != end && runEnd->first == it->first) {
+          ++runEnd;
+        }
+
+        for (auto x = it; x != runEnd; ++x) {
+          for (auto y = x + 1; y != runEnd; ++y) {
+            if (IsEqualElementElement(array, &elements[x->second], &elements[y->second])) {
+              result = TRI_ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED;
+              return;
+            }
+          }
+        }
+
+        it = runEnd;
+      }
+    }
+  });
+
+  if (result.load() != TRI_ERROR_NO_ERROR) {
+    return result.load();
+  }
+
+  // ...........................................................................
+  // now fill the partitions. the elements arrive in the order of their home
+  // slots, so the tables are written almost sequentially
+  // ...........................................................................
+
+  triagens::basics::RunInThreads(pool, bucketThreads, [&] (size_t thread) -> void {
+    for (size_t b = thread; b < TRI_HASH_ARRAY_BUCKETS; b += bucketThreads) {
+      TRI_hash_array_bucket_t* bucket = &array->_buckets[b];
+
+      for (size_t j = bucketStart[b]; j < bucketStart[b + 1]; ++j) {
+        uint64_t const i = FindEmptySlot(bucket->_table, bucket->_nrAlloc, scattered[j].first);
+
+        bucket->_table[i] = elements[scattered[j].second];
+      }
+
+      bucket->_nrUsed = static_cast<uint64_t>(bucketStart[b + 1] - bucketStart[b]);
+    }
+  });
+
+  array->_nrUsed = static_cast<uint64_t>(n);
+
+  return TRI_ERROR_NO_ERROR;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief removes an element from the array
 ////////////////////////////////////////////////////////////////////////////////
@@ -463,19 +988,22 @@ int TRI_InsertKeyHashArray (triagens::arango::HashIndex* hashIndex,
 int TRI_RemoveElementHashArray (triagens::arango::HashIndex* hashIndex,
                                 TRI_hash_array_t* array,
                                 TRI_hash_index_element_t* element) {
-  uint64_t const n = array->_nrAlloc;
-  uint64_t i, k;
+  uint64_t const hash = HashElement(array, element);
+  TRI_hash_array_bucket_t* bucket = BucketForHash(array, hash);
 
-  i = k = HashElement(array, element) % n;
+  MigrateBucket(array, bucket, MigrationSteps());
 
-  for (; i < n && array->_table[i]._document != nullptr && element->_document != array->_table[i]._document; ++i);
-  if (i == n) {
-    for (i = 0; i < k && array->_table[i]._document != nullptr && element->_document != array->_table[i]._document; ++i);
-  }
+  TRI_hash_index_element_t* table = bucket->_table;
+  uint64_t n = bucket->_nrAlloc;
+  uint64_t i = FindSlotByDocument(table, n, element, hash);
 
-  TRI_ASSERT_EXPENSIVE(i < n);
+  if (table[i]._document == nullptr && bucket->_tableOld != nullptr) {
+    table = bucket->_tableOld;
+    n = bucket->_nrAllocOld;
+    i = FindSlotByDocument(table, n, element, hash);
+  }
 
-  TRI_hash_index_element_t* arrayElement = static_cast<TRI_hash_index_element_t*>(&array->_table[i]);
+  TRI_hash_index_element_t* arrayElement = &table[i];
 
   // ...........................................................................
   // if we did not find such an item return false
@@ -492,6 +1020,7 @@ int TRI_RemoveElementHashArray (triagens::arango::HashIndex* hashIndex,
   // ...........................................................................
 
   DestroyElement(array, arrayElement);
+  bucket->_nrUsed--;
   array->_nrUsed--;
 
   // ...........................................................................
@@ -499,23 +1028,10 @@ int TRI_RemoveElementHashArray (triagens::arango::HashIndex* hashIndex,
   // so that there are no gaps in the array
   // ...........................................................................
 
-  k = TRI_IncModU64(i, n);
-
-  while (array->_table[k]._document != nullptr) {
-    uint64_t j = HashElement(array, &array->_table[k]) % n;
-
-    if ((i < k && ! (i < j && j <= k)) || (k < i && ! (i < j || j <= k))) {
-      array->_table[i] = array->_table[k];
-      array->_table[k]._document   = nullptr;
-      array->_table[k]._subObjects = nullptr;
-      i = k;
-    }
-
-    k = TRI_IncModU64(k, n);
-  }
+  CloseGap(array, table, n, i);
 
-  if (array->_nrUsed == 0) {
-    ResizeHashArray(hashIndex, array, InitialSize(), true);
+  if (bucket->_nrUsed == 0) {
+    ResizeBucket(hashIndex, array, bucket, InitialSize(), true, false);
   }
 
   return TRI_ERROR_NO_ERROR;
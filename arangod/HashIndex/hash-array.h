@@ -44,6 +44,10 @@ namespace triagens {
   namespace arango {
     class HashIndex;
   }
+
+  namespace basics {
+    class ThreadPool;
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -51,17 +55,50 @@ namespace triagens {
 // -----------------------------------------------------------------------------
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief associative array
+/// @brief number of partitions of an associative array
+///
+/// the partition of an element is selected by the topmost bits of its hash
+/// value, so this must be a power of two
 ////////////////////////////////////////////////////////////////////////////////
 
-typedef struct TRI_hash_array_s {
-  size_t _numFields; // the number of fields indexes
+#define TRI_HASH_ARRAY_BUCKETS 16
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief partition of an associative array
+///
+/// each partition is an open addressing hash table of its own and is resized
+/// independently of the others. when a partition grows, its elements are not
+/// rehashed at once. instead, the previous table is kept and its elements are
+/// moved to the new table a few at a time by the following inserts and
+/// removals in the partition. until the previous table is empty, lookups
+/// consult both tables
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct TRI_hash_array_bucket_s {
   uint64_t _nrAlloc; // the size of the table
-  uint64_t _nrUsed;  // the number of used entries
+  uint64_t _nrUsed;  // the number of used entries, in both tables
 
   struct TRI_hash_index_element_s* _table; // the table itself, aligned to a cache line boundary
   struct TRI_hash_index_element_s* _tablePtr; // the table itself
+
+  uint64_t _nrAllocOld;  // the size of the previous table
+  uint64_t _nrMigrated;  // the number of slots of the previous table already moved
+
+  struct TRI_hash_index_element_s* _tableOld; // the previous table, NULL if not growing
+  struct TRI_hash_index_element_s* _tableOldPtr; // the previous table
+}
+TRI_hash_array_bucket_t;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief associative array
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct TRI_hash_array_s {
+  size_t _numFields; // the number of fields indexes
+
+  uint64_t _nrUsed;  // the number of used entries in all partitions
+
+  TRI_hash_array_bucket_t _buckets[TRI_HASH_ARRAY_BUCKETS]; // the partitions
 }
 TRI_hash_array_t;
 
@@ -104,6 +141,9 @@ size_t TRI_MemoryUsageHashArray (TRI_hash_array_t const*);
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief resizes the hash table
+///
+/// the size is spread evenly over the partitions. unlike the incremental
+/// growth on insert, this rehashes all elements at once
 ////////////////////////////////////////////////////////////////////////////////
 
 int TRI_ResizeHashArray (triagens::arango::HashIndex*,
@@ -124,6 +164,18 @@ struct TRI_hash_index_element_s* TRI_LookupByKeyHashArray (TRI_hash_array_t cons
 struct TRI_hash_index_element_s* TRI_FindByKeyHashArray (TRI_hash_array_t const*,
                                                          struct TRI_index_search_value_s* key);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finds the elements for multiple keys at once
+///
+/// the home slots of all keys are computed and prefetched before any of them
+/// is probed, so the cache misses of the lookups overlap. the result
+/// contains one element per key, or NULL if the key was not found
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_FindByKeysHashArray (TRI_hash_array_t const*,
+                              std::vector<struct TRI_index_search_value_s*> const& keys,
+                              std::vector<struct TRI_hash_index_element_s*>& result);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief adds an key/element to the array
 ////////////////////////////////////////////////////////////////////////////////
@@ -134,6 +186,24 @@ int TRI_InsertKeyHashArray (triagens::arango::HashIndex*,
                             struct TRI_hash_index_element_s const* element,
                             bool isRollback);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief adds many elements to an empty array at once
+///
+/// the elements are hashed using the threads of pool, which may be a nullptr,
+/// and scattered into their partitions. each partition is sized for its
+/// elements, sorted, and filled without any uniqueness checks or resizes.
+/// duplicate keys are found by a pass over the sorted partitions instead.
+///
+/// returns TRI_ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED if two elements have
+/// the same key. in this case, and on any other error, no element is added
+/// and the caller keeps the ownership of the elements' sub-objects
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_BulkInsertHashArray (triagens::arango::HashIndex*,
+                             TRI_hash_array_t*,
+                             std::vector<struct TRI_hash_index_element_s> const& elements,
+                             triagens::basics::ThreadPool* pool);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief removes an element from the array
 ////////////////////////////////////////////////////////////////////////////////
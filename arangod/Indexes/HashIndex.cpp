@@ -28,6 +28,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "HashIndex.h"
+#include "Basics/RunInThreads.h"
 #include "HashIndex/hash-index-common.h"
 #include "VocBase/document-collection.h"
 #include "VocBase/transaction.h"
@@ -262,9 +263,6 @@ HashIndex::HashIndex (TRI_idx_iid_t iid,
   TRI_ASSERT(iid != 0);
 
   if (unique) {
-    _hashArray._table = nullptr;
-    _hashArray._tablePtr = nullptr;
-
     if (TRI_InitHashArray(&_hashArray, paths.size()) != TRI_ERROR_NO_ERROR) {
       THROW_ARANGO_EXCEPTION(TRI_ERROR_OUT_OF_MEMORY);
     }
@@ -349,6 +347,92 @@ int HashIndex::remove (TRI_doc_mptr_t const* doc,
   return removeMulti(doc);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief inserts many documents into the hash index
+///
+/// an empty unique index is built in bulk: the index elements are created
+/// using the threads of the pool and then handed to the hash array as a whole, which sizes
+/// its partitions once and checks the uniqueness on the sorted elements.
+/// other hash indexes insert the documents one by one
+////////////////////////////////////////////////////////////////////////////////
+
+int HashIndex::batchInsert (std::vector<TRI_doc_mptr_t const*> const* documents,
+                            triagens::basics::ThreadPool* pool) {
+  if (! _unique || _hashArray._nrUsed != 0) {
+    return Index::batchInsert(documents, pool);
+  }
+
+  // do not use helper threads for small collections
+  static size_t const MinDocumentsPerThread = 65536;
+
+  size_t const n = documents->size();
+
+  if (n < 2 * MinDocumentsPerThread) {
+    pool = nullptr;
+  }
+
+  size_t numRanges = (pool == nullptr ? 1 : pool->numThreads() + 1);
+  numRanges = (std::max)((std::min)(numRanges, n / MinDocumentsPerThread), static_cast<size_t>(1));
+
+  size_t const perThread = (n + numRanges - 1) / numRanges;
+
+  std::vector<TRI_hash_index_element_t> elements(n);
+  std::atomic<int> result(TRI_ERROR_NO_ERROR);
+
+  triagens::basics::RunInThreads(pool, numRanges, [&] (size_t thread) -> void {
+    size_t const from = thread * perThread;
+    size_t const to = (std::min)(from + perThread, n);
+
+    for (size_t i = from; i < to; ++i) {
+      TRI_hash_index_element_t* element = &elements[i];
+      element->_document = nullptr;
+      element->_subObjects = nullptr;
+
+      if (result.load(std::memory_order_relaxed) != TRI_ERROR_NO_ERROR) {
+        // another thread has failed
+        continue;
+      }
+
+      int res = HashIndexHelperAllocate<TRI_hash_index_element_t>(this, element, (*documents)[i]);
+
+      if (res == TRI_ERROR_ARANGO_INDEX_DOCUMENT_ATTRIBUTE_MISSING) {
+        // the document is not indexed
+        FreeSubObjectsHashIndexElement<TRI_hash_index_element_t>(element);
+        element->_document = nullptr;
+        continue;
+      }
+
+      if (res != TRI_ERROR_NO_ERROR) {
+        FreeSubObjectsHashIndexElement<TRI_hash_index_element_t>(element);
+        element->_document = nullptr;
+
+        int expected = TRI_ERROR_NO_ERROR;
+        result.compare_exchange_strong(expected, res, std::memory_order_acquire);
+      }
+    }
+  });
+
+  // remove the documents not indexed by a sparse index
+  elements.erase(std::remove_if(elements.begin(), elements.end(), [] (TRI_hash_index_element_t const& element) -> bool {
+    return element._document == nullptr;
+  }), elements.end());
+
+  int res = result.load();
+
+  if (res == TRI_ERROR_NO_ERROR) {
+    res = TRI_BulkInsertHashArray(this, &_hashArray, elements, pool);
+  }
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    // the elements have not been handed over to the hash array
+    for (auto& element : elements) {
+      FreeSubObjectsHashIndexElement<TRI_hash_index_element_t>(&element);
+    }
+  }
+
+  return res;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief provides a size hint for the hash index
 ////////////////////////////////////////////////////////////////////////////////
@@ -414,6 +498,49 @@ int HashIndex::lookup (TRI_index_search_value_t* searchValue,
   return TRI_LookupByKeyHashArrayMulti(&_hashArrayMulti, searchValue, documents, next, batchSize);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief locates the entries for multiple search values at once
+////////////////////////////////////////////////////////////////////////////////
+
+int HashIndex::lookup (std::vector<TRI_index_search_value_t*> const& searchValues,
+                       std::vector<TRI_doc_mptr_t*>& documents,
+                       std::vector<struct TRI_hash_index_element_multi_s*>& next) const {
+  size_t const n = searchValues.size();
+
+  documents.clear();
+  documents.reserve(n);
+  next.clear();
+  next.reserve(n);
+
+  if (_unique) {
+    std::vector<TRI_hash_index_element_t*> found;
+    TRI_FindByKeysHashArray(&_hashArray, searchValues, found);
+
+    for (auto element : found) {
+      documents.emplace_back(element == nullptr ? nullptr : element->_document);
+      // unique hash index: maximum number is 1
+      next.emplace_back(nullptr);
+    }
+  }
+  else {
+    std::vector<TRI_hash_index_element_multi_t*> found;
+    TRI_LookupByKeysHashArrayMulti(&_hashArrayMulti, searchValues, found);
+
+    for (auto element : found) {
+      if (element == nullptr) {
+        documents.emplace_back(nullptr);
+        next.emplace_back(nullptr);
+      }
+      else {
+        documents.emplace_back(element->_document);
+        next.emplace_back(element->_next);
+      }
+    }
+  }
+
+  return TRI_ERROR_NO_ERROR;
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                   private methods
 // -----------------------------------------------------------------------------
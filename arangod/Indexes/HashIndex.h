@@ -92,6 +92,8 @@ namespace triagens {
          
         int remove (struct TRI_doc_mptr_t const*, bool) override final;
         
+        int batchInsert (std::vector<struct TRI_doc_mptr_t const*> const*, triagens::basics::ThreadPool*) override final;
+
         int sizeHint (size_t) override final;
         
         std::vector<TRI_shape_pid_t> const& paths () const {
@@ -136,6 +138,19 @@ namespace triagens {
                     struct TRI_hash_index_element_multi_s*&,
                     size_t batchSize) const;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief locates the entries for multiple search values at once
+///
+/// for each search value, the first matching document (or NULL) is returned
+/// in documents, and the state for fetching the remaining documents in next.
+/// the remaining documents can be read by calling the lookup variant above
+/// with this state
+////////////////////////////////////////////////////////////////////////////////
+
+        int lookup (std::vector<TRI_index_search_value_t*> const&,
+                    std::vector<TRI_doc_mptr_t*>&,
+                    std::vector<struct TRI_hash_index_element_multi_s*>&) const;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                   private methods
 // -----------------------------------------------------------------------------
@@ -30,6 +30,7 @@
 #include "Index.h"
 #include "Basics/Exceptions.h"
 #include "Basics/json-utilities.h"
+#include "Basics/logging.h"
 #include "VocBase/document-collection.h"
 #include "VocBase/server.h"
 
@@ -371,6 +372,40 @@ int Index::postInsert (struct TRI_transaction_collection_s*,
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default implementation for batchInsert
+////////////////////////////////////////////////////////////////////////////////
+
+int Index::batchInsert (std::vector<TRI_doc_mptr_t const*> const* documents,
+                        triagens::basics::ThreadPool*) {
+#ifdef TRI_ENABLE_MAINTAINER_MODE
+  static const int LoopSize = 10000;
+  int counter = 0;
+  int loops = 0;
+#endif
+
+  for (auto const& document : *documents) {
+    int res = insert(document, false);
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      return res;
+    }
+
+#ifdef TRI_ENABLE_MAINTAINER_MODE
+    if (++counter == LoopSize) {
+      counter = 0;
+      ++loops;
+
+      LOG_TRACE("indexed %llu documents of collection %llu",
+                (unsigned long long) (LoopSize * loops),
+                (unsigned long long) _collection->_info._cid);
+    }
+#endif
+  }
+
+  return TRI_ERROR_NO_ERROR;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief default implementation for cleanup
 ////////////////////////////////////////////////////////////////////////////////
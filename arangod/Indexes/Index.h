@@ -44,6 +44,12 @@ struct TRI_document_collection_t;
 struct TRI_shaped_json_s;
 struct TRI_transaction_collection_s;
 
+namespace triagens {
+  namespace basics {
+    class ThreadPool;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief index query parameter
 ////////////////////////////////////////////////////////////////////////////////
@@ -183,6 +189,10 @@ namespace triagens {
   
         virtual int insert (struct TRI_doc_mptr_t const*, bool) = 0;
         virtual int remove (struct TRI_doc_mptr_t const*, bool) = 0;
+
+        // insert many documents at once when the index is filled, using the
+        // threads of the given pool (may be a nullptr) as helpers
+        virtual int batchInsert (std::vector<struct TRI_doc_mptr_t const*> const*, triagens::basics::ThreadPool*);
         virtual int postInsert (struct TRI_transaction_collection_s*, struct TRI_doc_mptr_t const*);
 
         // a garbage collection function for the index
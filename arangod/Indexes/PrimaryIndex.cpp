@@ -62,6 +62,32 @@ static inline bool IsDifferentHashElement (char const* key, uint64_t hash, void
   return (hash != e->_hash || strcmp(key, TRI_EXTRACT_MARKER_KEY(e)) != 0);  // ONLY IN INDEX, PROTECTED by RUNTIME
 }
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                             class IndexWriteGuard
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief excludes concurrent readers from the index while in scope
+////////////////////////////////////////////////////////////////////////////////
+
+class IndexWriteGuard {
+  public:
+    IndexWriteGuard (IndexWriteGuard const&) = delete;
+    IndexWriteGuard& operator= (IndexWriteGuard const&) = delete;
+
+    explicit IndexWriteGuard (PrimaryIndex const* index)
+      : _index(index) {
+      _index->beginWrite();
+    }
+
+    ~IndexWriteGuard () {
+      _index->endWrite();
+    }
+
+  private:
+    PrimaryIndex const* _index;
+};
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                class PrimaryIndex
 // -----------------------------------------------------------------------------
@@ -73,7 +99,19 @@ uint64_t const PrimaryIndex::InitialSize = 251;
 // -----------------------------------------------------------------------------
 
 PrimaryIndex::PrimaryIndex (TRI_document_collection_t* collection) 
-  : Index(0, collection, std::vector<std::string>( { TRI_VOC_ATTRIBUTE_KEY } )) {
+  : Index(0, collection, std::vector<std::string>( { TRI_VOC_ATTRIBUTE_KEY } )),
+    _writerActive(false) {
+
+  for (size_t i = 0;  i < NumReaderStripes;  ++i) {
+    _readerStripes[i]._readers = 0;
+  }
+
+  for (size_t i = 0;  i < NumKeyStripes;  ++i) {
+    _keyVersions[i] = 0;
+  }
+
+  // a stripe is marked at most once, so marking never allocates
+  _markedStripes.reserve(NumKeyStripes);
 
   _primaryIndex._nrAlloc = 0;
   _primaryIndex._nrUsed  = 0;
@@ -126,6 +164,7 @@ int PrimaryIndex::remove (TRI_doc_mptr_t const*,
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief looks up an element given a key
+/// the caller must hold the collection lock
 ////////////////////////////////////////////////////////////////////////////////
 
 void* PrimaryIndex::lookupKey (char const* key) const {
@@ -133,25 +172,63 @@ void* PrimaryIndex::lookupKey (char const* key) const {
     return nullptr;
   }
 
-  // compute the hash
+  return lookupKeyInternal(key, calculateHash(key));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief looks up an element given a key and copies it into result
+///
+/// this does not require the collection lock. it is only excluded by
+/// modifications of the index itself, which are short, and not by writers
+/// holding the collection lock. the lookup is not done if a writer has
+/// changed a key with the same stripe that is not committed yet, or does so
+/// during the lookup. returns whether the lookup was done, in which case
+/// found contains whether the key was found
+////////////////////////////////////////////////////////////////////////////////
+
+bool PrimaryIndex::lookupKeyConcurrent (char const* key,
+                                        TRI_doc_mptr_copy_t* result,
+                                        bool& found) const {
   uint64_t const hash = calculateHash(key);
-  uint64_t const n = _primaryIndex._nrAlloc;
-  uint64_t i, k;
+  auto const& version = _keyVersions[hash % NumKeyStripes];
 
-  i = k = hash % n;
+  uint64_t const before = version.load(std::memory_order_seq_cst);
 
-  TRI_ASSERT_EXPENSIVE(n > 0);
+  if (before % 2 != 0) {
+    // a key of the stripe has unpublished changes
+    return false;
+  }
 
-  // search the table
-  for (; i < n && _primaryIndex._table[i] != nullptr && IsDifferentHashElement(key, hash, _primaryIndex._table[i]); ++i);
-  if (i == n) {
-    for (i = 0; i < k && _primaryIndex._table[i] != nullptr && IsDifferentHashElement(key, hash, _primaryIndex._table[i]); ++i);
+  size_t const stripe = beginRead();
+
+  TRI_doc_mptr_t const* element = nullptr;
+  TRI_doc_mptr_copy_t copy;
+
+  if (_primaryIndex._nrUsed > 0) {
+    element = static_cast<TRI_doc_mptr_t const*>(lookupKeyInternal(key, hash));
+
+    if (element != nullptr) {
+      copy = *element;  // ONLY IN INDEX, PROTECTED by RUNTIME
+    }
   }
 
-  TRI_ASSERT_EXPENSIVE(i < n);
+  endRead(stripe);
 
-  // return whatever we found
-  return _primaryIndex._table[i];
+  // the copy must be complete before the version is checked again
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  if (version.load(std::memory_order_relaxed) != before) {
+    // a writer has changed a key of the stripe in between
+    return false;
+  }
+
+  found = (element != nullptr);
+
+  if (found) {
+    *result = copy;
+  }
+
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -163,6 +240,8 @@ int PrimaryIndex::insertKey (TRI_doc_mptr_t const* header,
                              void const** found) {
   *found = nullptr;
 
+  IndexWriteGuard guard(this);
+
   if (shouldResize()) {
     // check for out-of-memory
     if (! resize(static_cast<uint64_t>(2 * _primaryIndex._nrAlloc + 1), false)) {
@@ -207,6 +286,8 @@ int PrimaryIndex::insertKey (TRI_doc_mptr_t const* header,
 ////////////////////////////////////////////////////////////////////////////////
 
 void PrimaryIndex::insertKey (TRI_doc_mptr_t const* header) {
+  IndexWriteGuard guard(this);
+
   uint64_t const n = _primaryIndex._nrAlloc;
   uint64_t i, k;
 
@@ -231,6 +312,9 @@ void PrimaryIndex::insertKey (TRI_doc_mptr_t const* header) {
 
 void* PrimaryIndex::removeKey (char const* key) {
   uint64_t const hash = calculateHash(key);
+
+  IndexWriteGuard guard(this);
+
   uint64_t const n = _primaryIndex._nrAlloc;
   uint64_t i, k;
 
@@ -282,6 +366,8 @@ void* PrimaryIndex::removeKey (char const* key) {
 ////////////////////////////////////////////////////////////////////////////////
 
 int PrimaryIndex::resize (size_t targetSize) {
+  IndexWriteGuard guard(this);
+
   if (! resize(static_cast<uint64_t>(2 * targetSize + 1), false)) {
     return TRI_ERROR_OUT_OF_MEMORY;
   }
@@ -293,6 +379,8 @@ int PrimaryIndex::resize (size_t targetSize) {
 ////////////////////////////////////////////////////////////////////////////////
 
 int PrimaryIndex::resize () {
+  IndexWriteGuard guard(this);
+
   if (shouldResize() &&
       ! resize(static_cast<uint64_t>(2 * _primaryIndex._nrAlloc + 1), false)) {
     return TRI_ERROR_OUT_OF_MEMORY;
@@ -309,10 +397,127 @@ uint64_t PrimaryIndex::calculateHash (char const* key,
   return TRI_FnvHashPointer(static_cast<void const*>(key), length);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief excludes concurrent readers from the index
+////////////////////////////////////////////////////////////////////////////////
+
+void PrimaryIndex::beginWrite () const {
+  bool expected = false;
+
+  while (! _writerActive.compare_exchange_weak(expected, true, std::memory_order_seq_cst)) {
+    expected = false;
+    std::this_thread::yield();
+  }
+
+  // new readers will now back off. wait for the active ones to finish
+  for (size_t i = 0;  i < NumReaderStripes;  ++i) {
+    while (_readerStripes[i]._readers.load(std::memory_order_seq_cst) != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief admits concurrent readers again
+////////////////////////////////////////////////////////////////////////////////
+
+void PrimaryIndex::endWrite () const {
+  _writerActive.store(false, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief marks a key as changed by the current writer
+////////////////////////////////////////////////////////////////////////////////
+
+void PrimaryIndex::markKey (uint64_t hash) {
+  size_t const stripe = hash % NumKeyStripes;
+
+  if (_keyVersions[stripe].load(std::memory_order_relaxed) % 2 != 0) {
+    // already marked by the current writer
+    return;
+  }
+
+  _markedStripes.emplace_back(stripe);
+  _keyVersions[stripe].fetch_add(1, std::memory_order_seq_cst);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief makes the keys changed by the current writer visible again
+////////////////////////////////////////////////////////////////////////////////
+
+void PrimaryIndex::publishKeys () {
+  for (auto const& stripe : _markedStripes) {
+    TRI_ASSERT(_keyVersions[stripe].load() % 2 != 0);
+    _keyVersions[stripe].fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  _markedStripes.clear();
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                   private methods
 // -----------------------------------------------------------------------------
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief registers a concurrent reader
+/// readers are counted in one of several stripes, chosen by thread, so that
+/// readers on different threads do not contend for the same cache line.
+/// returns the stripe, which must be passed to endRead()
+////////////////////////////////////////////////////////////////////////////////
+
+size_t PrimaryIndex::beginRead () const {
+  size_t const stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % NumReaderStripes;
+  auto& readers = _readerStripes[stripe]._readers;
+
+  while (true) {
+    readers.fetch_add(1, std::memory_order_seq_cst);
+
+    if (! _writerActive.load(std::memory_order_seq_cst)) {
+      return stripe;
+    }
+
+    // a writer is active. back off until it is done
+    readers.fetch_sub(1, std::memory_order_release);
+
+    while (_writerActive.load(std::memory_order_relaxed)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief unregisters a concurrent reader
+////////////////////////////////////////////////////////////////////////////////
+
+void PrimaryIndex::endRead (size_t stripe) const {
+  _readerStripes[stripe]._readers.fetch_sub(1, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief looks up an element given a key and its hash
+////////////////////////////////////////////////////////////////////////////////
+
+void* PrimaryIndex::lookupKeyInternal (char const* key,
+                                       uint64_t hash) const {
+  uint64_t const n = _primaryIndex._nrAlloc;
+  uint64_t i, k;
+
+  i = k = hash % n;
+
+  TRI_ASSERT_EXPENSIVE(n > 0);
+
+  // search the table
+  for (; i < n && _primaryIndex._table[i] != nullptr && IsDifferentHashElement(key, hash, _primaryIndex._table[i]); ++i);
+  if (i == n) {
+    for (i = 0; i < k && _primaryIndex._table[i] != nullptr && IsDifferentHashElement(key, hash, _primaryIndex._table[i]); ++i);
+  }
+
+  TRI_ASSERT_EXPENSIVE(i < n);
+
+  // return whatever we found
+  return _primaryIndex._table[i];
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief whether or not the index must be resized
 ////////////////////////////////////////////////////////////////////////////////
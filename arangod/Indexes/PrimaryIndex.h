@@ -35,6 +35,12 @@
 #include "VocBase/vocbase.h"
 #include "VocBase/voc-types.h"
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                              forward declarations
+// -----------------------------------------------------------------------------
+
+struct TRI_doc_mptr_copy_t;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                class PrimaryIndex
 // -----------------------------------------------------------------------------
@@ -99,6 +105,7 @@ namespace triagens {
         int remove (struct TRI_doc_mptr_t const*, bool) override final;
 
         void* lookupKey (char const*) const;
+        bool lookupKeyConcurrent (char const*, TRI_doc_mptr_copy_t*, bool&) const;
         int insertKey (struct TRI_doc_mptr_t const*, void const**);
         void insertKey (struct TRI_doc_mptr_t const*);
         void* removeKey (char const*);
@@ -114,12 +121,53 @@ namespace triagens {
           return &_primaryIndex;
         } 
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief excludes concurrent readers from the index
+///
+/// readers using lookupKeyConcurrent() do not hold the collection lock. the
+/// exclusion must be held while a master pointer contained in the index is
+/// modified. insertKey(), removeKey() and resize() acquire it themselves
+////////////////////////////////////////////////////////////////////////////////
+
+        void beginWrite () const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief admits concurrent readers again
+////////////////////////////////////////////////////////////////////////////////
+
+        void endWrite () const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief marks a key as changed by the current writer
+///
+/// must be called with the collection's write lock held, before the key's
+/// entry in the index or its master pointer is changed. lookupKeyConcurrent()
+/// does not return keys of the same stripe until publishKeys() is called
+////////////////////////////////////////////////////////////////////////////////
+
+        void markKey (uint64_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief makes the keys changed by the current writer visible again
+///
+/// must be called with the collection's write lock held, after the changes
+/// were committed or rolled back
+////////////////////////////////////////////////////////////////////////////////
+
+        void publishKeys ();
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                   private methods
 // -----------------------------------------------------------------------------
 
       private:
 
+        size_t beginRead () const;
+
+        void endRead (size_t) const;
+
+        void* lookupKeyInternal (char const*, uint64_t) const;
+
         bool shouldResize () const;
 
         bool resize (uint64_t, bool);
@@ -136,6 +184,57 @@ namespace triagens {
 
         PrimaryIndexType _primaryIndex;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of stripes for concurrent readers
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t const NumReaderStripes = 16;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief reader counter, padded to a cache line of its own
+////////////////////////////////////////////////////////////////////////////////
+
+        struct ReaderStripe {
+          std::atomic<uint64_t> _readers;
+          char                  _padding[64 - sizeof(std::atomic<uint64_t>)];
+        };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief active concurrent readers, striped by thread
+////////////////////////////////////////////////////////////////////////////////
+
+        mutable ReaderStripe _readerStripes[NumReaderStripes];
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether a writer excludes concurrent readers
+////////////////////////////////////////////////////////////////////////////////
+
+        mutable std::atomic<bool> _writerActive;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of key stripes
+////////////////////////////////////////////////////////////////////////////////
+
+        static size_t const NumKeyStripes = 256;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief version of each key stripe, chosen by key hash
+///
+/// a version is odd while the current writer has changed a key of the stripe
+/// that is not committed or rolled back yet, and is incremented again when the
+/// change is published
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> _keyVersions[NumKeyStripes];
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief stripes marked by the current writer
+///
+/// only used with the collection's write lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<size_t> _markedStripes;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief associative array of pointers
 ////////////////////////////////////////////////////////////////////////////////
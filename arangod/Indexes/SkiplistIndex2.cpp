@@ -29,6 +29,7 @@
 
 #include "SkiplistIndex2.h"
 #include "Basics/logging.h"
+#include "Basics/RunInThreads.h"
 #include "VocBase/document-collection.h"
 #include "VocBase/transaction.h"
 #include "VocBase/voc-shaper.h"
@@ -177,40 +178,10 @@ triagens::basics::Json SkiplistIndex2::toJson (TRI_memory_zone_t* zone) const {
   
 int SkiplistIndex2::insert (TRI_doc_mptr_t const* doc, 
                             bool) {
-  auto skiplistElement = static_cast<TRI_skiplist_index_element_t*>(TRI_Allocate(TRI_UNKNOWN_MEM_ZONE, SkiplistIndex_ElementSize(_skiplistIndex), false));
-
-  if (skiplistElement == nullptr) {
-    return TRI_ERROR_OUT_OF_MEMORY;
-  }
-
-  int res = fillElement(skiplistElement, doc);
-  // ...........................................................................
-  // most likely the cause of this error is that the index is sparse
-  // and not all attributes the index needs are set -- so the document
-  // is ignored. So not really an error at all. Note that this does
-  // not happen in a non-sparse skiplist index, in which empty
-  // attributes are always treated as if they were bound to null, so
-  // TRI_ERROR_ARANGO_INDEX_DOCUMENT_ATTRIBUTE_MISSING cannot happen at
-  // all.
-  // ...........................................................................
-
-  // .........................................................................
-  // It may happen that the document does not have the necessary
-  // attributes to be included within the hash index, in this case do
-  // not report back an error.
-  // .........................................................................
-
-  if (res == TRI_ERROR_ARANGO_INDEX_DOCUMENT_ATTRIBUTE_MISSING) {
-    if (_sparse) {
-      TRI_Free(TRI_UNKNOWN_MEM_ZONE, skiplistElement);
-      return TRI_ERROR_NO_ERROR;
-    }
-
-    res = TRI_ERROR_NO_ERROR;
-  }
+  TRI_skiplist_index_element_t* skiplistElement;
+  int res = createElement(doc, skiplistElement);
 
-  if (res != TRI_ERROR_NO_ERROR) {
-    TRI_Free(TRI_UNKNOWN_MEM_ZONE, skiplistElement);
+  if (res != TRI_ERROR_NO_ERROR || skiplistElement == nullptr) {
     return res;
   }
 
@@ -219,6 +190,22 @@ int SkiplistIndex2::insert (TRI_doc_mptr_t const* doc,
   return SkiplistIndex_insert(_skiplistIndex, skiplistElement);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief inserts many documents into a skiplist index
+///
+/// an empty skiplist is bulk loaded from the sorted elements. otherwise, the
+/// documents are inserted one by one
+////////////////////////////////////////////////////////////////////////////////
+
+int SkiplistIndex2::batchInsert (std::vector<TRI_doc_mptr_t const*> const* documents,
+                                 triagens::basics::ThreadPool* pool) {
+  if (SkiplistIndex_getNrUsed(_skiplistIndex) == 0) {
+    return bulkLoad(documents, pool);
+  }
+
+  return Index::batchInsert(documents, pool);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief removes a document from a skiplist index
 ////////////////////////////////////////////////////////////////////////////////
@@ -377,6 +364,134 @@ int SkiplistIndex2::fillElement(TRI_skiplist_index_element_t* skiplistElement,
   return res;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief creates the index element for a document
+///
+/// element is set to nullptr if the document is not indexed
+////////////////////////////////////////////////////////////////////////////////
+
+int SkiplistIndex2::createElement (TRI_doc_mptr_t const* doc,
+                                   TRI_skiplist_index_element_t*& element) {
+  element = nullptr;
+
+  auto skiplistElement = static_cast<TRI_skiplist_index_element_t*>(TRI_Allocate(TRI_UNKNOWN_MEM_ZONE, SkiplistIndex_ElementSize(_skiplistIndex), false));
+
+  if (skiplistElement == nullptr) {
+    return TRI_ERROR_OUT_OF_MEMORY;
+  }
+
+  int res = fillElement(skiplistElement, doc);
+  // ...........................................................................
+  // most likely the cause of this error is that the index is sparse
+  // and not all attributes the index needs are set -- so the document
+  // is ignored. So not really an error at all. Note that this does
+  // not happen in a non-sparse skiplist index, in which empty
+  // attributes are always treated as if they were bound to null, so
+  // TRI_ERROR_ARANGO_INDEX_DOCUMENT_ATTRIBUTE_MISSING cannot happen at
+  // all.
+  // ...........................................................................
+
+  // .........................................................................
+  // It may happen that the document does not have the necessary
+  // attributes to be included within the hash index, in this case do
+  // not report back an error.
+  // .........................................................................
+
+  if (res == TRI_ERROR_ARANGO_INDEX_DOCUMENT_ATTRIBUTE_MISSING) {
+    if (_sparse) {
+      TRI_Free(TRI_UNKNOWN_MEM_ZONE, skiplistElement);
+      return TRI_ERROR_NO_ERROR;
+    }
+
+    res = TRI_ERROR_NO_ERROR;
+  }
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    TRI_Free(TRI_UNKNOWN_MEM_ZONE, skiplistElement);
+    return res;
+  }
+
+  element = skiplistElement;
+
+  return TRI_ERROR_NO_ERROR;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fills the empty index from the elements of many documents
+///
+/// the elements are created using the threads of the pool, then sorted and
+/// linked into the skiplist at once, which is much cheaper than searching the
+/// insert position for each of them
+////////////////////////////////////////////////////////////////////////////////
+
+int SkiplistIndex2::bulkLoad (std::vector<TRI_doc_mptr_t const*> const* documents,
+                              triagens::basics::ThreadPool* pool) {
+  // do not use helper threads for small collections
+  static size_t const MinDocumentsPerThread = 65536;
+
+  size_t const n = documents->size();
+
+  if (n < 2 * MinDocumentsPerThread) {
+    pool = nullptr;
+  }
+
+  size_t numRanges = (pool == nullptr ? 1 : pool->numThreads() + 1);
+  numRanges = (std::max)((std::min)(numRanges, n / MinDocumentsPerThread), static_cast<size_t>(1));
+
+  size_t const perThread = (n + numRanges - 1) / numRanges;
+
+  std::vector<void*> elements(n, nullptr);
+  std::atomic<int> result(TRI_ERROR_NO_ERROR);
+
+  triagens::basics::RunInThreads(pool, numRanges, [&] (size_t thread) -> void {
+    size_t const from = thread * perThread;
+    size_t const to = (std::min)(from + perThread, n);
+
+    for (size_t i = from; i < to; ++i) {
+      if (result.load(std::memory_order_relaxed) != TRI_ERROR_NO_ERROR) {
+        // another thread has failed
+        return;
+      }
+
+      TRI_skiplist_index_element_t* element = nullptr;
+      int res;
+
+      try {
+        res = createElement((*documents)[i], element);
+      }
+      catch (...) {
+        res = TRI_ERROR_INTERNAL;
+      }
+
+      if (res != TRI_ERROR_NO_ERROR) {
+        int expected = TRI_ERROR_NO_ERROR;
+        result.compare_exchange_strong(expected, res, std::memory_order_acquire);
+        return;
+      }
+
+      elements[i] = element;
+    }
+  });
+
+  // remove the documents not indexed by a sparse index
+  elements.erase(std::remove(elements.begin(), elements.end(), nullptr), elements.end());
+
+  int res = result.load();
+
+  if (res == TRI_ERROR_NO_ERROR) {
+    res = SkiplistIndex_bulkLoad(_skiplistIndex, elements, pool);
+  }
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    // the elements have not been handed over to the index
+    for (auto element : elements) {
+      TRI_Free(TRI_UNKNOWN_MEM_ZONE, element);
+    }
+  }
+
+  return res;
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                       END-OF-FILE
 // -----------------------------------------------------------------------------
@@ -87,6 +87,8 @@ namespace triagens {
         triagens::basics::Json toJson (TRI_memory_zone_t*) const override final;
   
         int insert (struct TRI_doc_mptr_t const*, bool) override final;
+
+        int batchInsert (std::vector<struct TRI_doc_mptr_t const*> const*, triagens::basics::ThreadPool*) override final;
          
         int remove (struct TRI_doc_mptr_t const*, bool) override final;
 
@@ -117,6 +119,12 @@ namespace triagens {
 
         int fillElement(TRI_skiplist_index_element_t*,
                         struct TRI_doc_mptr_t const*);
+
+        int createElement (struct TRI_doc_mptr_t const*,
+                           TRI_skiplist_index_element_t*&);
+
+        int bulkLoad (std::vector<struct TRI_doc_mptr_t const*> const*,
+                      triagens::basics::ThreadPool*);
         
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
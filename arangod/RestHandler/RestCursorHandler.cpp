@@ -298,6 +298,23 @@ triagens::basics::Json RestCursorHandler::buildExtra (triagens::aql::QueryResult
 ///   specific rules. To disable a rule, prefix its name with a `-`, to enable a rule, prefix it
 ///   with a `+`. There is also a pseudo-rule `all`, which will match all optimizer rules.
 ///
+/// - *parallelism*: the number of threads that may be used to filter the
+///   documents of a full collection scan. If set to a value greater than *1*, 
+///   a *FILTER* that directly follows a full collection scan and that only
+///   depends on the scanned documents is evaluated by multiple threads. The
+///   default value is *1*.
+///
+/// - *memoryLimit*: the maximum amount of memory (in bytes) that a *SORT*
+///   operation in the query may use for buffering its input. If a sort needs
+///   more memory, it writes sorted runs to temporary files and merges them.
+///   A value of *0* turns off spilling. The default value can be set with the
+///   server option *--database.query-memory-limit*.
+///
+/// - *cache*: whether or not the query result may be looked up in and stored in
+///   the query result cache. If the cache mode is *on*, setting this option to
+///   *false* will bypass the cache for the query. If the cache mode is *demand*,
+///   only queries with this option set to *true* will use the cache.
+///
 /// If the result set can be created by the server, the server will respond with
 /// *HTTP 201*. The body of the response will contain a JSON object with the
 /// result set.
@@ -324,6 +341,9 @@ triagens::basics::Json RestCursorHandler::buildExtra (triagens::aql::QueryResult
 ///   of modified documents and the number of documents that could not be modified
 ///   due to an error (if *ignoreErrors* query option is specified)
 ///
+/// - *cached*: a boolean flag indicating whether the query result was served
+///   from the query result cache
+///
 /// If the JSON representation is malformed or the query specification is
 /// missing from the request, the server will respond with *HTTP 400*.
 ///
@@ -669,6 +689,7 @@ void RestCursorHandler::createCursor () {
         }
       
         result.set("extra", extra);
+        result.set("cached", triagens::basics::Json(queryResult.cached));
         result.set("error", triagens::basics::Json(false));
         result.set("code", triagens::basics::Json(static_cast<double>(_response->responseCode())));
 
@@ -691,6 +712,7 @@ void RestCursorHandler::createCursor () {
       try {
         _response->body().appendChar('{');
         cursor->dump(_response->body());
+        _response->body().appendText(queryResult.cached ? ",\"cached\":true" : ",\"cached\":false");
         _response->body().appendText(",\"error\":false,\"code\":");
         _response->body().appendInteger(static_cast<uint32_t>(_response->responseCode()));
         _response->body().appendChar('}');
@@ -30,6 +30,8 @@
 #include "RestQueryHandler.h"
 
 #include "Aql/Query.h"
+#include "Aql/PlanCache.h"
+#include "Aql/QueryCache.h"
 #include "Aql/QueryList.h"
 #include "Basics/StringUtils.h"
 #include "Basics/conversions.h"
@@ -182,6 +184,81 @@ bool RestQueryHandler::readQueryProperties () {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @startDocuBlock GetApiQueryCache
+/// @brief returns the configuration and figures of the AQL query result cache
+///
+/// @RESTHEADER{GET /_api/query/cache, Returns the properties of the AQL query result cache}
+///
+/// Returns the current configuration of the AQL query result cache in the
+/// selected database, together with some figures. The result is a JSON object
+/// with the following properties:
+/// 
+/// - *mode*: the mode the query cache operates in. Possible values are *off*,
+///   *on* and *demand*. 
+///
+/// - *maxResults*: the maximum number of query results that will be stored.
+///
+/// - *maxMemory*: the maximum amount of memory (in bytes) that the stored 
+///   query results may use.
+///
+/// - *entries*: the number of query results currently stored.
+///
+/// - *memory*: the approximate amount of memory (in bytes) currently used by
+///   the stored query results.
+///
+/// - *hits*: the number of queries that were answered from the cache.
+///
+/// - *misses*: the number of cache lookups that did not find a result.
+///
+/// - *plans*: the configuration and figures of the execution plan cache of
+///   the database. This is an object with the attributes *maxEntries*, 
+///   *entries*, *hits*, *misses* and *hitRate*.
+///
+/// @RESTRETURNCODES
+///
+/// @RESTRETURNCODE{200}
+/// Is returned when the properties can be retrieved successfully.
+///
+/// @RESTRETURNCODE{400}
+/// The server will respond with *HTTP 400* in case of a malformed request,
+///
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+bool RestQueryHandler::readQueryCache () {
+  try {
+    auto queryCache = static_cast<QueryCache*>(_vocbase->_queryCache);
+
+    Json result(TRI_UNKNOWN_MEM_ZONE, queryCache->toJson(TRI_UNKNOWN_MEM_ZONE));
+
+    auto planCache = static_cast<PlanCache*>(_vocbase->_planCache);
+
+    if (planCache != nullptr) {
+      result.set("plans", Json(TRI_UNKNOWN_MEM_ZONE, planCache->toJson(TRI_UNKNOWN_MEM_ZONE)));
+    }
+
+    result
+    .set("error", Json(false))
+    .set("code", Json(HttpResponse::OK));
+
+    generateResult(HttpResponse::OK, result.json());
+  }
+  catch (Exception const& err) {
+    handleError(err);
+  }
+  catch (std::exception const& ex) {
+    triagens::basics::Exception err(TRI_ERROR_INTERNAL, ex.what(), __FILE__, __LINE__);
+    handleError(err);
+  }
+  catch (...) {
+    triagens::basics::Exception err(TRI_ERROR_INTERNAL, __FILE__, __LINE__);
+    handleError(err);
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @startDocuBlock GetApiQueryCurrent
 /// @brief returns a list of currently running AQL queries
@@ -309,10 +386,13 @@ bool RestQueryHandler::readQuery () {
   else if (name == "properties") {
     return readQueryProperties();
   }
+  else if (name == "cache") {
+    return readQueryCache();
+  }
 
   generateError(HttpResponse::NOT_FOUND,
                 TRI_ERROR_HTTP_NOT_FOUND,
-                "unknown type '" + name + "', expecting 'slow', 'current', or 'properties'");
+                "unknown type '" + name + "', expecting 'slow', 'current', 'properties' or 'cache'");
   return true;
 }
 
@@ -349,6 +429,40 @@ bool RestQueryHandler::deleteQuerySlow () {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @startDocuBlock DeleteApiQueryCache
+/// @brief clears the AQL query result cache
+///
+/// @RESTHEADER{DELETE /_api/query/cache, Clears the AQL query result cache}
+///
+/// Removes all results from the AQL query result cache of the selected 
+/// database. The cache properties and figures are not reset.
+///
+/// @RESTRETURNCODES
+///
+/// @RESTRETURNCODE{200}
+/// The server will respond with *HTTP 200* when the cache was cleared
+/// successfully.
+///
+/// @RESTRETURNCODE{400}
+/// The server will respond with *HTTP 400* in case of a malformed request.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+bool RestQueryHandler::deleteQueryCache () {
+  auto queryCache = static_cast<triagens::aql::QueryCache*>(_vocbase->_queryCache);
+  queryCache->invalidate();
+
+  Json result(Json::Object);
+
+  result
+  .set("error", Json(false))
+  .set("code", Json(HttpResponse::OK));
+
+  generateResult(HttpResponse::OK, result.json());
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @startDocuBlock DeleteApiQueryKill
 /// @brief kills an AQL query
@@ -411,7 +525,7 @@ bool RestQueryHandler::deleteQuery () {
   if (suffix.size() != 1) {
     generateError(HttpResponse::BAD,
                   TRI_ERROR_HTTP_BAD_PARAMETER,
-                  "expecting DELETE /_api/query/<id> or /_api/query/slow");
+                  "expecting DELETE /_api/query/<id>, /_api/query/slow or /_api/query/cache");
     return true;
   }
 
@@ -420,6 +534,9 @@ bool RestQueryHandler::deleteQuery () {
   if (name == "slow") {
     return deleteQuerySlow();
   }
+  else if (name == "cache") {
+    return deleteQueryCache();
+  }
   else {
     return deleteQuery(name);
   }
@@ -477,10 +594,14 @@ bool RestQueryHandler::deleteQuery () {
 bool RestQueryHandler::replaceProperties () {
   const auto& suffix = _request->suffix();
 
+  if (suffix.size() == 1 && suffix[0] == "cache") {
+    return replaceCacheProperties();
+  }
+
   if (suffix.size() != 1 || suffix[0] != "properties") {
     generateError(HttpResponse::BAD,
                   TRI_ERROR_HTTP_BAD_PARAMETER,
-                  "expecting PUT /_api/query/properties");
+                  "expecting PUT /_api/query/properties or /_api/query/cache");
     return true;
   }
 
@@ -545,6 +666,107 @@ bool RestQueryHandler::replaceProperties () {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @startDocuBlock PutApiQueryCache
+/// @brief changes the configuration of the AQL query result cache
+///
+/// @RESTHEADER{PUT /_api/query/cache, Changes the properties of the AQL query result cache}
+///
+/// @RESTBODYPARAM{properties,json,required}
+/// The properties for the query result cache in the current database. 
+///
+/// The properties need to be passed in the body of the HTTP request as a JSON
+/// object with the following optional attributes:
+/// 
+/// - *mode*: the mode the query cache should operate in. Possible values are
+///   *off*, *on* and *demand*. In mode *on*, all cacheable queries will be 
+///   looked up in and stored in the cache unless their *cache* option is set
+///   to *false*. In mode *demand*, only queries with the *cache* option set to
+///   *true* will use the cache. Setting the mode to *off* will also clear the
+///   cache.
+///
+/// - *maxResults*: the maximum number of query results to store. If more 
+///   results are stored, the oldest ones will be removed.
+///
+/// - *maxMemory*: the maximum amount of memory (in bytes) the stored query
+///   results may use. If more memory is used, the oldest results will be
+///   removed.
+///
+/// Only read-only queries with deterministic results are stored. A stored
+/// result is removed as soon as one of the collections used by its query is 
+/// modified.
+///
+/// After the properties have been changed, the current set of properties will
+/// be returned in the HTTP response.
+///
+/// @RESTRETURNCODES
+///
+/// @RESTRETURNCODE{200}
+/// Is returned if the properties were changed successfully.
+///
+/// @RESTRETURNCODE{400}
+/// The server will respond with *HTTP 400* in case of a malformed request,
+///
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+bool RestQueryHandler::replaceCacheProperties () {
+  unique_ptr<TRI_json_t> body(parseJsonBody());
+
+  if (body == nullptr) {
+    // error message generated in parseJsonBody
+    return true;
+  }
+
+  auto queryCache = static_cast<triagens::aql::QueryCache*>(_vocbase->_queryCache);
+
+  try {
+    QueryCacheMode mode = queryCache->mode();
+    size_t maxResults = queryCache->maxResults();
+    size_t maxMemory = queryCache->maxMemory();
+
+    if (JsonHelper::getObjectElement(body.get(), "mode") != nullptr) {
+      std::string const value = JsonHelper::checkAndGetStringValue(body.get(), "mode");
+
+      if (value != "off" && value != "on" && value != "demand") {
+        generateError(HttpResponse::BAD,
+                      TRI_ERROR_BAD_PARAMETER,
+                      "invalid value for 'mode', expecting 'off', 'on' or 'demand'");
+        return true;
+      }
+
+      mode = QueryCache::modeFromString(value);
+    }
+
+    if (JsonHelper::getObjectElement(body.get(), "maxResults") != nullptr) {
+      maxResults = JsonHelper::checkAndGetNumericValue<size_t>(body.get(), "maxResults");
+    }
+
+    if (JsonHelper::getObjectElement(body.get(), "maxMemory") != nullptr) {
+      maxMemory = JsonHelper::checkAndGetNumericValue<size_t>(body.get(), "maxMemory");
+    }
+
+    queryCache->maxResults(maxResults);
+    queryCache->maxMemory(maxMemory);
+    queryCache->mode(mode);
+
+    return readQueryCache();
+  }
+  catch (Exception const& err) {
+    handleError(err);
+  }
+  catch (std::exception const& ex) {
+    triagens::basics::Exception err(TRI_ERROR_INTERNAL, ex.what(), __FILE__, __LINE__);
+    handleError(err);
+  }
+  catch (...) {
+    triagens::basics::Exception err(TRI_ERROR_INTERNAL, __FILE__, __LINE__);
+    handleError(err);
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief parse an AQL query and return information about it
 ////////////////////////////////////////////////////////////////////////////////
@@ -94,6 +94,12 @@ namespace triagens {
 
         bool readQueryProperties ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the properties and figures of the query cache
+////////////////////////////////////////////////////////////////////////////////
+
+        bool readQueryCache ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief returns the list of slow queries
 ////////////////////////////////////////////////////////////////////////////////
@@ -112,6 +118,12 @@ namespace triagens {
 
         bool deleteQuerySlow ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief clears the query cache
+////////////////////////////////////////////////////////////////////////////////
+
+        bool deleteQueryCache ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief interrupts a named query
 ////////////////////////////////////////////////////////////////////////////////
@@ -130,6 +142,12 @@ namespace triagens {
 
         bool replaceProperties ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief changes the query cache settings
+////////////////////////////////////////////////////////////////////////////////
+
+        bool replaceCacheProperties ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief parses a query
 ////////////////////////////////////////////////////////////////////////////////
@@ -1472,6 +1472,7 @@ int RestReplicationHandler::createCollection (TRI_json_t const* json,
   }
 
   params._doCompact   = JsonHelper::getBooleanValue(json, "doCompact", true);
+  params._compressDatafiles = JsonHelper::getBooleanValue(json, "compressDatafiles", false);
   params._waitForSync = JsonHelper::getBooleanValue(json, "waitForSync", _vocbase->_settings.defaultWaitForSync);
   params._isVolatile  = JsonHelper::getBooleanValue(json, "isVolatile", false);
   params._isSystem    = (name[0] == '_');
@@ -37,6 +37,8 @@
 #include "Admin/RestHandlerCreator.h"
 #include "Admin/RestShutdownHandler.h"
 #include "Aql/Query.h"
+#include "Aql/PlanCache.h"
+#include "Aql/QueryCache.h"
 #include "Aql/RestAqlHandler.h"
 #include "Basics/FileUtils.h"
 #include "Basics/Nonce.h"
@@ -81,6 +83,8 @@
 #include "V8/v8-utils.h"
 #include "V8Server/ApplicationV8.h"
 #include "VocBase/auth.h"
+#include "VocBase/compactor.h"
+#include "VocBase/compressed-datafile.h"
 #include "VocBase/server.h"
 #include "Wal/LogfileManager.h"
 
@@ -335,15 +339,32 @@ ArangoServer::ArangoServer (int argc, char** argv)
     _defaultMaximalSize(TRI_JOURNAL_DEFAULT_MAXIMAL_SIZE),
     _defaultWaitForSync(false),
     _forceSyncProperties(true),
+    _indexSnapshots(false),
+    _prefaultDatafiles(false),
+    _compressedCacheSize(128 * 1024 * 1024),
     _ignoreDatafileErrors(false),
     _disableReplicationApplier(false),
     _disableQueryTracking(false),
+    _queryCacheMode("off"),
+    _queryCacheMaxResults(128),
+    _queryCacheMaxMemory(64 * 1024 * 1024),
+    _queryPlanCacheSize(256),
+    _queryMemoryLimit(256 * 1024 * 1024),
+    _queryThreads(4),
+    _compactionInterval(1.0),
+    _compactionDeadSizeThreshold(128 * 1024),
+    _compactionDeadShareThreshold(0.1),
+    _compactionSmallDatafileSize(128 * 1024),
+    _compactionMaxFiles(4),
+    _compactionMaxResultFilesize(128 * 1024 * 1024),
+    _compactionMaxWriteRate(0),
     _foxxQueuesSystemOnly(true),
     _foxxQueuesPollInterval(1.0),
     _server(nullptr),
     _queryRegistry(nullptr),
     _pairForAql(nullptr),
     _indexPool(nullptr),
+    _queryPool(nullptr),
     _threadAffinity(0) {
 
   TRI_SetApplicationName("arangod");
@@ -378,6 +399,9 @@ ArangoServer::ArangoServer (int argc, char** argv)
 ArangoServer::~ArangoServer () {
   delete _indexPool;
 
+  triagens::aql::Query::ScanPool(nullptr);
+  delete _queryPool;
+
   delete _jobManager;
 
   if (_server != nullptr) {
@@ -582,9 +606,25 @@ void ArangoServer::buildApplicationServer () {
     ("database.maximal-journal-size", &_defaultMaximalSize, "default maximal journal size, can be overwritten when creating a collection")
     ("database.wait-for-sync", &_defaultWaitForSync, "default wait-for-sync behavior, can be overwritten when creating a collection")
     ("database.force-sync-properties", &_forceSyncProperties, "force syncing of collection properties to disk, will use waitForSync value of collection when turned off")
+    ("database.index-snapshots", &_indexSnapshots, "persist primary index snapshots when unloading collections")
+    ("database.prefault-datafiles", &_prefaultDatafiles, "load all datafile pages into memory when loading collections")
+    ("database.compressed-cache-size", &_compressedCacheSize, "maximum memory (in bytes) for decompressed blocks of compressed datafiles")
     ("database.ignore-datafile-errors", &_ignoreDatafileErrors, "load collections even if datafiles may contain errors")
     ("database.disable-query-tracking", &_disableQueryTracking, "turn off AQL query tracking by default")
+    ("database.query-cache-mode", &_queryCacheMode, "default mode for the AQL query result cache (on, off, demand)")
+    ("database.query-cache-max-results", &_queryCacheMaxResults, "default maximum number of results in the AQL query result cache per database")
+    ("database.query-cache-max-memory", &_queryCacheMaxMemory, "default maximum memory (in bytes) used by the AQL query result cache per database")
+    ("database.query-plan-cache-size", &_queryPlanCacheSize, "default maximum number of execution plans in the AQL plan cache per database")
+    ("database.query-memory-limit", &_queryMemoryLimit, "default maximum memory (in bytes) an AQL SORT may use before spilling to disk (0 = unlimited)")
     ("database.index-threads", &_indexThreads, "threads to start for parallel background index creation")
+    ("database.query-threads", &_queryThreads, "threads to start for filtering AQL collection scans in parallel")
+    ("compaction.interval", &_compactionInterval, "sleep time (in seconds) between compaction runs")
+    ("compaction.dead-size-threshold", &_compactionDeadSizeThreshold, "minimum size (in bytes) of dead documents that makes a datafile eligible for compaction")
+    ("compaction.dead-share-threshold", &_compactionDeadShareThreshold, "minimum share of dead documents that makes a datafile eligible for compaction")
+    ("compaction.small-datafile-size", &_compactionSmallDatafileSize, "adjacent datafiles smaller than this size (in bytes) are merged")
+    ("compaction.max-files", &_compactionMaxFiles, "maximum number of datafiles merged in one compaction run")
+    ("compaction.max-result-filesize", &_compactionMaxResultFilesize, "maximum size (in bytes) of a compacted datafile")
+    ("compaction.max-write-rate", &_compactionMaxWriteRate, "maximum write rate (in bytes per second) of the compaction (0 = unlimited)")
   ;
 
   // .............................................................................
@@ -739,6 +779,36 @@ void ArangoServer::buildApplicationServer () {
   // set global query tracking flag
   triagens::aql::Query::DisableQueryTracking(_disableQueryTracking);
 
+  // set global query cache defaults
+  if (_queryCacheMode != "off" && 
+      _queryCacheMode != "on" &&
+      _queryCacheMode != "demand") {
+    LOG_FATAL_AND_EXIT("invalid value '%s' for --database.query-cache-mode", _queryCacheMode.c_str());
+  }
+
+  triagens::aql::QueryCache::DefaultMode(triagens::aql::QueryCache::modeFromString(_queryCacheMode));
+  triagens::aql::QueryCache::DefaultMaxResults(static_cast<size_t>(_queryCacheMaxResults));
+  triagens::aql::QueryCache::DefaultMaxMemory(static_cast<size_t>(_queryCacheMaxMemory));
+  triagens::aql::PlanCache::DefaultMaxEntries(static_cast<size_t>(_queryPlanCacheSize));
+
+  // set global query memory limit
+  triagens::aql::Query::DefaultMemoryLimit(_queryMemoryLimit);
+
+  // set compactor settings
+  TRI_compactor_settings_t compactorSettings;
+  compactorSettings._interval           = _compactionInterval;
+  compactorSettings._deadSizeThreshold  = _compactionDeadSizeThreshold;
+  compactorSettings._deadShareThreshold = _compactionDeadShareThreshold;
+  compactorSettings._smallDatafileSize  = _compactionSmallDatafileSize;
+  compactorSettings._maxFiles           = _compactionMaxFiles;
+  compactorSettings._maxResultFilesize  = _compactionMaxResultFilesize;
+  compactorSettings._maxWriteRate       = _compactionMaxWriteRate;
+
+  TRI_SetSettingsCompactor(&compactorSettings);
+
+  // set the size of the cache for blocks of compressed datafiles
+  TRI_SetCacheSizeCompressedDatafiles(_compressedCacheSize);
+
 
   // .............................................................................
   // now run arangod
@@ -796,6 +866,11 @@ void ArangoServer::buildApplicationServer () {
       _indexThreads = 128;
     }
   }
+
+  if (_queryThreads > 128) {
+    // some arbitrary limit
+    _queryThreads = 128;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1393,6 +1468,8 @@ void ArangoServer::openDatabases (bool checkVersion,
   defaults.requireAuthenticationUnixSockets = ! _disableAuthenticationUnixSockets;
   defaults.authenticateSystemOnly           = _authenticateSystemOnly;
   defaults.forceSyncProperties              = _forceSyncProperties;
+  defaults.indexSnapshots                   = _indexSnapshots;
+  defaults.prefaultDatafiles                = _prefaultDatafiles;
 
   TRI_ASSERT(_server != nullptr);
 
@@ -1401,6 +1478,11 @@ void ArangoServer::openDatabases (bool checkVersion,
     _indexPool = new triagens::basics::ThreadPool(_indexThreads, "IndexBuilder");
   }
 
+  if (_queryThreads > 0) {
+    _queryPool = new triagens::basics::ThreadPool(_queryThreads, "QueryScanner");
+    triagens::aql::Query::ScanPool(_queryPool);
+  }
+
   int res = TRI_InitServer(_server,
                            _applicationEndpointServer,
                            _indexPool,
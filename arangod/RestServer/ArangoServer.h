@@ -449,6 +449,64 @@ namespace triagens {
 
         bool _forceSyncProperties;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief persist primary index snapshots when unloading collections
+/// @startDocuBlock databaseIndexSnapshots
+/// `--database.index-snapshots boolean`
+///
+/// Write a snapshot of a collection's primary index and shape dictionary to
+/// the collection directory when the collection is unloaded or the server is
+/// shut down cleanly.
+///
+/// When the collection is loaded again, the snapshot is used instead of
+/// scanning all datafiles. Only datafiles that were appended to or created
+/// after the snapshot was written are scanned. A snapshot that does not match
+/// the datafiles on disk is ignored and the collection is loaded in full.
+///
+/// The default is *false*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _indexSnapshots;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief load all datafile pages into memory when loading collections
+/// @startDocuBlock databasePrefaultDatafiles
+/// `--database.prefault-datafiles boolean`
+///
+/// Load all pages of a collection's datafiles and journals into memory when
+/// the collection is loaded. Documents of such collections can then be read
+/// without page faults, at the cost of a slower load and of memory for
+/// documents that may never be read.
+///
+/// Independent of this option, datafiles are read with sequential readahead
+/// while a collection is loaded or compacted, and with readahead turned off
+/// afterwards, as documents are then looked up randomly.
+///
+/// The default is *false*. The option can be overridden per database with the
+/// option *prefaultDatafiles* of *db._createDatabase()*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _prefaultDatafiles;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximal memory for decompressed blocks of compressed datafiles
+/// @startDocuBlock databaseCompressedCacheSize
+/// `--database.compressed-cache-size size`
+///
+/// Maximal memory (in bytes) used for the decompressed blocks of compressed
+/// datafiles, shared by all collections. Blocks of compressed datafiles are
+/// decompressed when they are first read. If the limit is reached, the block
+/// that was decompressed first is dropped and decompressed again when it is
+/// read the next time. The limit is never lower than 4 MB.
+///
+/// The default is *134217728* (128 MB).
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _compressedCacheSize;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief ignore datafile errors when loading collections
 /// @startDocuBlock databaseIgnoreDatafileErrors
@@ -519,6 +577,211 @@ namespace triagens {
 
         bool _disableQueryTracking;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default mode of the AQL query result cache
+/// @startDocuBlock databaseQueryCacheMode
+/// `--database.query-cache-mode`
+///
+/// Sets the default mode of the AQL query result cache for all databases.
+/// Possible values are *off*, *on* and *demand*. In mode *on*, the results of
+/// all cacheable queries will be cached unless a query's *cache* option is set
+/// to *false*. In mode *demand*, only results of queries with the *cache*
+/// option set to *true* will be cached.
+///
+/// The default is *off*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        std::string _queryCacheMode;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default maximum number of results in the AQL query result cache
+/// @startDocuBlock databaseQueryCacheMaxResults
+/// `--database.query-cache-max-results`
+///
+/// Sets the default maximum number of query results that are kept in the AQL
+/// query result cache of each database. 
+///
+/// The default is *128*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _queryCacheMaxResults;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default maximum memory used by the AQL query result cache
+/// @startDocuBlock databaseQueryCacheMaxMemory
+/// `--database.query-cache-max-memory`
+///
+/// Sets the default maximum amount of memory (in bytes) that the query results
+/// in the AQL query result cache of each database may use.
+///
+/// The default is *67108864* (64 MB).
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _queryCacheMaxMemory;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default number of execution plans kept in the AQL plan cache
+/// @startDocuBlock databaseQueryPlanCacheSize
+/// `--database.query-plan-cache-size`
+///
+/// Sets the default maximum number of optimized execution plans that are
+/// kept in the AQL plan cache of each database. Repeated queries with the
+/// same query string, bind parameters and optimizer options will reuse a
+/// cached plan instead of being parsed and optimized again. Setting this
+/// value to *0* turns off the plan cache.
+///
+/// The default is *256*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _queryPlanCacheSize;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief default memory limit for AQL queries
+/// @startDocuBlock databaseQueryMemoryLimit
+/// `--database.query-memory-limit`
+///
+/// Sets the default maximum amount of memory (in bytes) that a *SORT*
+/// operation in an AQL query may use for buffering its input. If a sort
+/// needs more memory, it writes sorted runs of its input to temporary files
+/// and merges them afterwards. The limit can be overridden per query with
+/// the *memoryLimit* option. Setting this value to *0* turns off spilling.
+///
+/// The default is *268435456* (256 MB).
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _queryMemoryLimit;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of threads for filtering AQL collection scans
+/// @startDocuBlock queryThreads
+/// `--database.query-threads`
+///
+/// Specifies the *number* of threads that help filtering the documents of
+/// AQL collection scans for queries with the *parallelism* option. The 
+/// threads are shared among all queries and databases, and the thread running
+/// a query always takes part in filtering its documents. Specifying a value
+/// of *0* turns off parallel collection scans.
+///
+/// The default is *4*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        int _queryThreads;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sleep time between compaction runs
+/// @startDocuBlock compactionInterval
+/// `--compaction.interval`
+///
+/// Sets the time (in seconds) the compactor thread of a database sleeps
+/// after a run in which no collection was compacted.
+///
+/// The default is *1*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        double _compactionInterval;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief minimum size of dead data that makes a datafile eligible for
+/// compaction
+/// @startDocuBlock compactionDeadSizeThreshold
+/// `--compaction.dead-size-threshold`
+///
+/// A datafile is compacted if it contains at least this many bytes of
+/// dead documents, i.e. documents that were removed or replaced by newer
+/// revisions.
+///
+/// The default is *131072* (128 KB).
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _compactionDeadSizeThreshold;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief minimum share of dead data that makes a datafile eligible for
+/// compaction
+/// @startDocuBlock compactionDeadShareThreshold
+/// `--compaction.dead-share-threshold`
+///
+/// A datafile is compacted if the share of dead documents in it is at least
+/// this value. For example, a datafile with 800 bytes of alive and 400 bytes
+/// of dead documents has a share of 400 / (400 + 800) = 0.33.
+///
+/// If several datafiles are eligible, the one with the highest share of
+/// dead documents is compacted first.
+///
+/// The default is *0.1*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        double _compactionDeadShareThreshold;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief smaller datafiles are merged with others
+/// @startDocuBlock compactionSmallDatafileSize
+/// `--compaction.small-datafile-size`
+///
+/// Adjacent datafiles with a size (in bytes) below this value are merged
+/// into a single datafile by the compaction, even if they do not contain any
+/// dead documents.
+///
+/// The default is *131072* (128 KB).
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _compactionSmallDatafileSize;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum number of datafiles merged in one compaction run
+/// @startDocuBlock compactionMaxFiles
+/// `--compaction.max-files`
+///
+/// Sets the maximum number of adjacent datafiles that are merged into a
+/// single compacted datafile in one compaction run.
+///
+/// The default is *4*.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t _compactionMaxFiles;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum size of a compacted datafile
+/// @startDocuBlock compactionMaxResultFilesize
+/// `--compaction.max-result-filesize`
+///
+/// Sets the maximum size (in bytes) of a datafile created by the compaction.
+/// The actual limit is three times the journal size of the collection, but
+/// at least 8 MB and at most this value.
+///
+/// The default is *134217728* (128 MB).
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _compactionMaxResultFilesize;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum write rate of the compaction
+/// @startDocuBlock compactionMaxWriteRate
+/// `--compaction.max-write-rate`
+///
+/// Limits the rate (in bytes per second) at which the compaction writes
+/// compacted datafiles. The compaction processes datafiles in chunks of 1 MB
+/// and pauses between chunks if it is faster than this rate. Writers are not
+/// blocked while the compaction pauses.
+///
+/// The default is *0*, which means the write rate is not limited.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _compactionMaxWriteRate;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief restrict the Foxx queues to run in the _system database only
 /// @startDocuBlock foxxQueuesSystemOnly
@@ -634,6 +897,12 @@ namespace triagens {
 
         triagens::basics::ThreadPool* _indexPool;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief thread pool for filtering AQL collection scans
+////////////////////////////////////////////////////////////////////////////////
+
+        triagens::basics::ThreadPool* _queryPool;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief use thread affinity
 ////////////////////////////////////////////////////////////////////////////////
@@ -992,6 +992,17 @@ int SkiplistIndex_insert (SkiplistIndex* skiplistIndex,
   return res;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fills an empty skip list with many data elements at once
+/// ownership for the elements is only transferred to the index on success
+////////////////////////////////////////////////////////////////////////////////
+
+int SkiplistIndex_bulkLoad (SkiplistIndex* skiplistIndex,
+                            std::vector<void*>& elements,
+                            triagens::basics::ThreadPool* pool) {
+  return skiplistIndex->skiplist->bulkLoad(elements, pool);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief removes an entry from the skip list
 /// ownership for the element is transferred to the index
@@ -278,6 +278,40 @@ namespace triagens {
             return res;
           }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief commit / finish the transaction without waiting for the sync of
+/// its commit marker. the callback receives the result of the sync, see
+/// TRI_CommitTransaction
+////////////////////////////////////////////////////////////////////////////////
+
+          int commit (TRI_transaction_sync_cb_t const& callback) {
+            if (_trx == nullptr || getStatus() != TRI_TRANSACTION_RUNNING) {
+              // transaction not created or not running
+              return TRI_ERROR_TRANSACTION_INTERNAL;
+            }
+
+            if (! _isReal) {
+              int res = commit();
+
+              if (res == TRI_ERROR_NO_ERROR) {
+                // the outermost transaction syncs the commit
+                callback(TRI_ERROR_NO_ERROR);
+              }
+
+              return res;
+            }
+
+            int res = TRI_CommitTransaction(_trx, _nestingLevel, callback);
+
+#ifdef TRI_ENABLE_MAINTAINER_MODE
+            TRI_ASSERT(_numberTrxActive == _numberTrxInScope);
+            TRI_ASSERT(_numberTrxActive > 0);
+            _numberTrxActive--;  // Every transaction gets here at most once
+#endif
+
+            return res;
+          }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief abort the transaction
 ////////////////////////////////////////////////////////////////////////////////
@@ -948,14 +982,14 @@ namespace triagens {
             int64_t i = 0;
 
             while (doc != nullptr && i < offset) {
-              doc = doc->_next;
+              doc = document->_headersPtr->next(doc);
               ++i;
             }
 
             i = 0;
             while (doc != nullptr && i < count) {
               documents.emplace_back(*doc);
-              doc = doc->_next;
+              doc = document->_headersPtr->next(doc);
               ++i;
             }
           }
@@ -965,14 +999,14 @@ namespace triagens {
             int64_t i = -1;
 
             while (doc != nullptr && i > offset) {
-              doc = doc->_prev;
+              doc = document->_headersPtr->prev(doc);
               --i;
             }
 
             i = 0;
             while (doc != nullptr && i < count) {
               documents.emplace_back(*doc);
-              doc = doc->_prev;
+              doc = document->_headersPtr->prev(doc);
               ++i;
             }
           }
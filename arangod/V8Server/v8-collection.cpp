@@ -1723,6 +1723,25 @@ static TRI_doc_collection_info_t* GetFigures (TRI_vocbase_col_t* collection) {
 /// * *compactors.count*: The number of compactor files.
 /// * *compactors.fileSize*: The total filesize of the compactor files
 ///   (in bytes).
+/// * *compaction.count*: The number of compaction runs since the collection
+///   was loaded.
+/// * *compaction.files*: The number of datafiles compacted since the
+///   collection was loaded.
+/// * *compaction.bytesRead*: The total size of the datafile data that was
+///   compacted (in bytes).
+/// * *compaction.bytesWritten*: The total size of the data that compaction
+///   rewrote into new datafiles (in bytes).
+/// * *compaction.bytesReclaimed*: The difference between *bytesRead* and
+///   *bytesWritten*. The ratio of *bytesWritten* to *bytesReclaimed* is the
+///   write amplification of the compaction.
+/// * *pageFaults.minor*: The number of minor page faults that occurred while
+///   the collection was loaded or compacted, since it was loaded.
+/// * *pageFaults.major*: The number of major page faults, which required
+///   reading from disk, that occurred while the collection was loaded or
+///   compacted, since it was loaded.
+/// * *headers.count*: The number of document headers (master pointers) in use.
+/// * *headers.size*: The total memory allocated for document headers (in bytes).
+///   This includes headers that are currently unused.
 /// * *shapefiles.count*: The number of shape files. This value is
 ///   deprecated and kept for compatibility reasons only. The value will always
 ///   be 0 since ArangoDB 2.0 and higher.
@@ -1841,6 +1860,30 @@ static void JS_FiguresVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>& arg
   cs->Set(TRI_V8_ASCII_STRING("count"),          v8::Number::New(isolate, (double) info->_numberCompactorfiles));
   cs->Set(TRI_V8_ASCII_STRING("fileSize"),       v8::Number::New(isolate, (double) info->_compactorfileSize));
 
+  // compaction statistics
+  v8::Handle<v8::Object> compaction = v8::Object::New(isolate);
+
+  result->Set(TRI_V8_ASCII_STRING("compaction"), compaction);
+  compaction->Set(TRI_V8_ASCII_STRING("count"),          v8::Number::New(isolate, (double) info->_compactionRuns));
+  compaction->Set(TRI_V8_ASCII_STRING("files"),          v8::Number::New(isolate, (double) info->_compactionFiles));
+  compaction->Set(TRI_V8_ASCII_STRING("bytesRead"),      v8::Number::New(isolate, (double) info->_compactionBytesRead));
+  compaction->Set(TRI_V8_ASCII_STRING("bytesWritten"),   v8::Number::New(isolate, (double) info->_compactionBytesWritten));
+  compaction->Set(TRI_V8_ASCII_STRING("bytesReclaimed"), v8::Number::New(isolate, (double) (info->_compactionBytesRead - info->_compactionBytesWritten)));
+
+  // page faults
+  v8::Handle<v8::Object> pageFaults = v8::Object::New(isolate);
+
+  result->Set(TRI_V8_ASCII_STRING("pageFaults"), pageFaults);
+  pageFaults->Set(TRI_V8_ASCII_STRING("minor"),          v8::Number::New(isolate, (double) info->_pageFaultsMinor));
+  pageFaults->Set(TRI_V8_ASCII_STRING("major"),          v8::Number::New(isolate, (double) info->_pageFaultsMajor));
+
+  // document headers
+  v8::Handle<v8::Object> headers = v8::Object::New(isolate);
+
+  result->Set(TRI_V8_ASCII_STRING("headers"), headers);
+  headers->Set(TRI_V8_ASCII_STRING("count"),             v8::Number::New(isolate, (double) info->_numberHeaders));
+  headers->Set(TRI_V8_ASCII_STRING("size"),              v8::Number::New(isolate, (double) info->_sizeHeaders));
+
   // shapefiles info
   v8::Handle<v8::Object> sf = v8::Object::New(isolate);
 
@@ -2025,6 +2068,11 @@ static void JS_PlanIdVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>& args
 ///   value. Changes (see below) are applied when the collection is
 ///   loaded the next time.
 ///
+/// * *compressDatafiles*: if *true*, the compactor writes the datafiles of
+///   the collection in compressed form. Compressed datafiles use less disk
+///   space. Their blocks are decompressed when they are read, and are kept in
+///   a cache of limited size. Journals are never compressed.
+///
 /// In a cluster setup, the result will also contain the following attributes:
 ///
 /// * *numberOfShards*: the number of shards of the collection.
@@ -2045,6 +2093,9 @@ static void JS_PlanIdVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>& args
 /// * *indexBuckets* : See above, changes are only applied when the
 ///   collection is loaded the next time.
 ///
+/// * *compressDatafiles* : See above, changes apply to datafiles that are
+///   compacted afterwards.
+///
 /// *Note*: it is not possible to change the journal size after the journal or
 /// datafile has been created. Changing this parameter will only effect newly
 /// created journals. Also note that you cannot lower the journal size to less
@@ -2149,6 +2200,10 @@ static void JS_PropertiesVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>&
           }
           info._indexBuckets = tmp;
         }
+
+        if (po->Has(TRI_V8_ASCII_STRING("compressDatafiles"))) {
+          info._compressDatafiles = TRI_ObjectToBoolean(po->Get(TRI_V8_ASCII_STRING("compressDatafiles")));
+        }
       }
 
       int res = ClusterInfo::instance()->setCollectionPropertiesCoordinator(databaseName, StringUtils::itoa(collection->_cid), &info);
@@ -2177,6 +2232,8 @@ static void JS_PropertiesVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>&
     result->Set(WaitForSyncKey, v8::Boolean::New(isolate, info._waitForSync));
     result->Set(TRI_V8_ASCII_STRING("indexBuckets"),
                 v8::Number::New(isolate, info._indexBuckets));
+    result->Set(TRI_V8_ASCII_STRING("compressDatafiles"),
+                v8::Boolean::New(isolate, info._compressDatafiles));
 
     shared_ptr<CollectionInfo> c = ClusterInfo::instance()->getCollection(databaseName, StringUtils::itoa(collection->_cid));
     v8::Handle<v8::Array> shardKeys = v8::Array::New(isolate);
@@ -2219,6 +2276,7 @@ static void JS_PropertiesVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>&
       bool doCompact     = base->_info._doCompact;
       bool waitForSync   = base->_info._waitForSync;
       uint32_t indexBuckets = base->_info._indexBuckets;
+      bool compressDatafiles = base->_info._compressDatafiles;
 
       TRI_UNLOCK_JOURNAL_ENTRIES_DOC_COLLECTION(document);
 
@@ -2268,6 +2326,10 @@ static void JS_PropertiesVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>&
         }
       }
 
+      if (po->Has(TRI_V8_ASCII_STRING("compressDatafiles"))) {
+        compressDatafiles = TRI_ObjectToBoolean(po->Get(TRI_V8_ASCII_STRING("compressDatafiles")));
+      }
+
       // update collection
       TRI_col_info_t newParameters;
 
@@ -2275,6 +2337,7 @@ static void JS_PropertiesVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>&
       newParameters._maximalSize = maximalSize;
       newParameters._waitForSync = waitForSync;
       newParameters._indexBuckets = indexBuckets;
+      newParameters._compressDatafiles = compressDatafiles;
 
       // try to write new parameter to file
       bool doSync = base->_vocbase->_settings.forceSyncProperties;
@@ -2327,6 +2390,8 @@ static void JS_PropertiesVocbaseCol (const v8::FunctionCallbackInfo<v8::Value>&
   result->Set(JournalSizeKey, v8::Number::New( isolate, base->_info._maximalSize));
   result->Set(TRI_V8_ASCII_STRING("indexBuckets"),
               v8::Number::New(isolate, document->_info._indexBuckets));
+  result->Set(TRI_V8_ASCII_STRING("compressDatafiles"),
+              v8::Boolean::New(isolate, document->_info._compressDatafiles));
 
   TRI_json_t* keyOptions = document->_keyGenerator->toJson(TRI_UNKNOWN_MEM_ZONE);
 
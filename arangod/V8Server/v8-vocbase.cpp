@@ -56,6 +56,7 @@
 #include "V8Server/v8-wrapshapedjson.h"
 #include "V8Server/V8Traverser.h"
 #include "VocBase/auth.h"
+#include "VocBase/compactor.h"
 #include "VocBase/key-generator.h"
 #include "Wal/LogfileManager.h"
 
@@ -499,6 +500,95 @@ static void JS_PropertiesWal (const v8::FunctionCallbackInfo<v8::Value>& args) {
   TRI_V8_RETURN(result);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief retrieves or changes the configuration of the compaction
+/// @startDocuBlock compactionProperties
+/// `internal.compaction.properties(properties)`
+///
+/// Retrieves the configuration of the compaction. If *properties* is given,
+/// the configuration is changed first. The following attributes are
+/// returned, and can be changed:
+/// - *interval*: the sleep time between compaction runs (in seconds)
+/// - *deadSizeThreshold*: the minimum size of dead documents (in bytes) that
+///   makes a datafile a candidate for compaction
+/// - *deadShareThreshold*: the minimum share of dead documents that makes a
+///   datafile a candidate for compaction
+/// - *smallDatafileSize*: adjacent datafiles smaller than this size (in bytes)
+///   are merged
+/// - *maxFiles*: the maximum number of datafiles merged in one compaction run
+/// - *maxResultFilesize*: the maximum size of a compacted datafile (in bytes)
+/// - *maxWriteRate*: the maximum write rate of the compaction (in bytes per
+///   second). A value of *0* means that the compaction is not throttled.
+///
+/// Changes are used by the next compaction run. They are not persisted, so
+/// the startup options apply again after a restart.
+///
+/// @EXAMPLES
+///
+/// @EXAMPLE_ARANGOSH_OUTPUT{CompactionProperties}
+///   require("internal").compaction.properties();
+/// @END_EXAMPLE_ARANGOSH_OUTPUT
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+static void JS_PropertiesCompaction (const v8::FunctionCallbackInfo<v8::Value>& args) {
+  v8::Isolate* isolate = args.GetIsolate();
+  v8::HandleScope scope(isolate);
+
+  if (args.Length() > 1 || (args.Length() == 1 && ! args[0]->IsObject())) {
+    TRI_V8_THROW_EXCEPTION_USAGE("properties(<object>)");
+  }
+
+  TRI_compactor_settings_t settings = TRI_GetSettingsCompactor();
+
+  if (args.Length() == 1) {
+    // set the properties
+    v8::Handle<v8::Object> object = v8::Handle<v8::Object>::Cast(args[0]);
+
+    if (object->Has(TRI_V8_ASCII_STRING("interval"))) {
+      settings._interval = TRI_ObjectToDouble(object->Get(TRI_V8_ASCII_STRING("interval")));
+    }
+
+    if (object->Has(TRI_V8_ASCII_STRING("deadSizeThreshold"))) {
+      settings._deadSizeThreshold = TRI_ObjectToUInt64(object->Get(TRI_V8_ASCII_STRING("deadSizeThreshold")), true);
+    }
+
+    if (object->Has(TRI_V8_ASCII_STRING("deadShareThreshold"))) {
+      settings._deadShareThreshold = TRI_ObjectToDouble(object->Get(TRI_V8_ASCII_STRING("deadShareThreshold")));
+    }
+
+    if (object->Has(TRI_V8_ASCII_STRING("smallDatafileSize"))) {
+      settings._smallDatafileSize = TRI_ObjectToUInt64(object->Get(TRI_V8_ASCII_STRING("smallDatafileSize")), true);
+    }
+
+    if (object->Has(TRI_V8_ASCII_STRING("maxFiles"))) {
+      settings._maxFiles = static_cast<uint32_t>(TRI_ObjectToUInt64(object->Get(TRI_V8_ASCII_STRING("maxFiles")), true));
+    }
+
+    if (object->Has(TRI_V8_ASCII_STRING("maxResultFilesize"))) {
+      settings._maxResultFilesize = TRI_ObjectToUInt64(object->Get(TRI_V8_ASCII_STRING("maxResultFilesize")), true);
+    }
+
+    if (object->Has(TRI_V8_ASCII_STRING("maxWriteRate"))) {
+      settings._maxWriteRate = TRI_ObjectToUInt64(object->Get(TRI_V8_ASCII_STRING("maxWriteRate")), true);
+    }
+
+    TRI_SetSettingsCompactor(&settings);
+    settings = TRI_GetSettingsCompactor();
+  }
+
+  v8::Handle<v8::Object> result = v8::Object::New(isolate);
+  result->Set(TRI_V8_ASCII_STRING("interval"),           v8::Number::New(isolate, settings._interval));
+  result->Set(TRI_V8_ASCII_STRING("deadSizeThreshold"),  v8::Number::New(isolate, (double) settings._deadSizeThreshold));
+  result->Set(TRI_V8_ASCII_STRING("deadShareThreshold"), v8::Number::New(isolate, settings._deadShareThreshold));
+  result->Set(TRI_V8_ASCII_STRING("smallDatafileSize"),  v8::Number::New(isolate, (double) settings._smallDatafileSize));
+  result->Set(TRI_V8_ASCII_STRING("maxFiles"),           v8::Number::New(isolate, (double) settings._maxFiles));
+  result->Set(TRI_V8_ASCII_STRING("maxResultFilesize"),  v8::Number::New(isolate, (double) settings._maxResultFilesize));
+  result->Set(TRI_V8_ASCII_STRING("maxWriteRate"),       v8::Number::New(isolate, (double) settings._maxWriteRate));
+
+  TRI_V8_RETURN(result);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief flushes the currently open WAL logfile
 /// @startDocuBlock walFlush
@@ -1187,6 +1277,7 @@ static void JS_ExecuteAqlJson (const v8::FunctionCallbackInfo<v8::Value>& args)
   else {
     result->Set(TRI_V8_ASCII_STRING("warnings"), TRI_ObjectJson(isolate, queryResult.warnings));
   }
+  result->Set(TRI_V8_ASCII_STRING("cached"), v8::Boolean::New(isolate, queryResult.cached));
   
   TRI_V8_RETURN(result);
 }
@@ -1285,6 +1376,7 @@ static void JS_ExecuteAql (const v8::FunctionCallbackInfo<v8::Value>& args) {
   else {
     result->Set(TRI_V8_ASCII_STRING("warnings"), TRI_ObjectJson(isolate, queryResult.warnings));
   }
+  result->Set(TRI_V8_ASCII_STRING("cached"), v8::Boolean::New(isolate, queryResult.cached));
   
   TRI_V8_RETURN(result);
 }
@@ -3113,6 +3205,8 @@ static void JS_CreateDatabase (const v8::FunctionCallbackInfo<v8::Value>& args)
   v8::Local<v8::String> keyRequireAuthenticationUnixSockets = TRI_V8_ASCII_STRING("requireAuthenticationUnixSockets");
   v8::Local<v8::String> keyAuthenticateSystemOnly           = TRI_V8_ASCII_STRING("authenticateSystemOnly");
   v8::Local<v8::String> keyForceSyncProperties              = TRI_V8_ASCII_STRING("forceSyncProperties");
+  v8::Local<v8::String> keyIndexSnapshots                   = TRI_V8_ASCII_STRING("indexSnapshots");
+  v8::Local<v8::String> keyPrefaultDatafiles                = TRI_V8_ASCII_STRING("prefaultDatafiles");
 
   // overwrite database defaults from args[2]
   if (args.Length() > 1 && args[1]->IsObject()) {
@@ -3141,6 +3235,14 @@ static void JS_CreateDatabase (const v8::FunctionCallbackInfo<v8::Value>& args)
     if (options->Has(keyForceSyncProperties)) {
       defaults.forceSyncProperties = options->Get(keyForceSyncProperties)->BooleanValue();
     }
+
+    if (options->Has(keyIndexSnapshots)) {
+      defaults.indexSnapshots = options->Get(keyIndexSnapshots)->BooleanValue();
+    }
+
+    if (options->Has(keyPrefaultDatafiles)) {
+      defaults.prefaultDatafiles = options->Get(keyPrefaultDatafiles)->BooleanValue();
+    }
     
     TRI_GET_GLOBAL_STRING(IdKey);
     if (options->Has(IdKey)) {
@@ -3705,6 +3807,7 @@ void TRI_InitV8VocBridge (v8::Isolate* isolate,
   TRI_AddGlobalFunctionVocbase(isolate, context, TRI_V8_ASCII_STRING("TRANSACTION"), JS_Transaction, true);
   TRI_AddGlobalFunctionVocbase(isolate, context, TRI_V8_ASCII_STRING("WAL_FLUSH"), JS_FlushWal, true);
   TRI_AddGlobalFunctionVocbase(isolate, context, TRI_V8_ASCII_STRING("WAL_PROPERTIES"), JS_PropertiesWal, true);
+  TRI_AddGlobalFunctionVocbase(isolate, context, TRI_V8_ASCII_STRING("COMPACTION_PROPERTIES"), JS_PropertiesCompaction, true);
   
   TRI_AddGlobalFunctionVocbase(isolate, context, TRI_V8_ASCII_STRING("ENABLE_NATIVE_BACKTRACES"), JS_EnableNativeBacktraces, true);
 
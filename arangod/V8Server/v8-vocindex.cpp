@@ -1047,6 +1047,7 @@ static void CreateCollectionCoordinator (const v8::FunctionCallbackInfo<v8::Valu
   TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, json, "waitForSync", TRI_CreateBooleanJson(TRI_UNKNOWN_MEM_ZONE, parameters._waitForSync));
   TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, json, "journalSize", TRI_CreateNumberJson(TRI_UNKNOWN_MEM_ZONE, parameters._maximalSize));
   TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, json, "indexBuckets", TRI_CreateNumberJson(TRI_UNKNOWN_MEM_ZONE, parameters._indexBuckets));
+  TRI_Insert3ObjectJson(TRI_UNKNOWN_MEM_ZONE, json, "compressDatafiles", TRI_CreateBooleanJson(TRI_UNKNOWN_MEM_ZONE, parameters._compressDatafiles));
 
   TRI_json_t* keyOptions = TRI_CreateObjectJson(TRI_UNKNOWN_MEM_ZONE);
   if (keyOptions != nullptr) {
@@ -1660,6 +1661,10 @@ static void CreateVocBase (const v8::FunctionCallbackInfo<v8::Value>& args,
         TRI_V8_THROW_EXCEPTION_PARAMETER("indexBuckets must be a two-power between 1 and 1024");
       }
     }
+
+    if (p->Has(TRI_V8_ASCII_STRING("compressDatafiles"))) {
+      parameters._compressDatafiles = TRI_ObjectToBoolean(p->Get(TRI_V8_ASCII_STRING("compressDatafiles")));
+    }
   }
   else {
     TRI_InitCollectionInfo(vocbase, &parameters, name.c_str(), collectionType, effectiveSize, nullptr);
@@ -1730,6 +1735,12 @@ static void CreateVocBase (const v8::FunctionCallbackInfo<v8::Value>& args,
 ///   enforce any synchronization to disk and does not calculate any CRC
 ///   checksums for datafiles (as there are no datafiles).
 ///
+/// * *compressDatafiles* (optional, default is *false*): If *true*, the
+///   compactor writes the datafiles of the collection compressed to disk.
+///   Journals are never compressed. The blocks of compressed datafiles are
+///   decompressed when they are read, and are kept in a cache whose size is
+///   limited by the option `--database.compressed-cache-size`.
+///
 /// * *keyOptions* (optional): additional options for key generation. If
 ///   specified, then *keyOptions* should be a JSON array containing the
 ///   following attributes (**note**: some of them are optional):
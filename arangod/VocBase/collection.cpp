@@ -36,6 +36,8 @@
 #include "Basics/json.h"
 #include "Basics/JsonHelper.h"
 #include "Basics/logging.h"
+#include "Basics/MutexLocker.h"
+#include "Basics/ThreadPool.h"
 #include "Basics/tri-strings.h"
 #include "VocBase/document-collection.h"
 #include "VocBase/server.h"
@@ -60,6 +62,18 @@ typedef struct {
 }
 shape_iterator_t;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief a datafile found in the collection directory when opening
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  char*           _filename;
+  std::string     _type;
+  TRI_datafile_t* _datafile;
+  int             _error;
+}
+datafile_candidate_t;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private functions
 // -----------------------------------------------------------------------------
@@ -408,6 +422,84 @@ static TRI_col_file_structure_t ScanCollectionDirectory (char const* path) {
   return structure;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief opens and checks the datafiles found for a collection
+///
+/// checking a datafile requires reading all of it, so the datafiles are
+/// opened in parallel using the server's index threads. the result for each
+/// datafile is stored in its candidate entry, and the caller processes the
+/// candidates in their original order afterwards
+////////////////////////////////////////////////////////////////////////////////
+
+static void OpenDatafiles (TRI_collection_t* collection,
+                           std::vector<datafile_candidate_t>& candidates,
+                           bool ignoreErrors) {
+  // minimum number of seconds between two progress messages
+  static double const ReportInterval = 10.0;
+
+  size_t const n = candidates.size();
+
+  uint64_t totalSize = 0;
+  for (auto const& candidate : candidates) {
+    int64_t size = TRI_SizeFile(candidate._filename);
+
+    if (size > 0) {
+      totalSize += static_cast<uint64_t>(size);
+    }
+  }
+
+  triagens::basics::Mutex reportLock;
+  double lastReport = TRI_microtime();
+  size_t numberDone = 0;
+  uint64_t sizeDone = 0;
+
+  auto work = [&] (size_t i) -> void {
+    datafile_candidate_t& candidate = candidates[i];
+
+    TRI_set_errno(TRI_ERROR_NO_ERROR);
+    candidate._datafile = TRI_OpenDatafile(candidate._filename, ignoreErrors);
+
+    if (candidate._datafile == nullptr) {
+      candidate._error = TRI_errno();
+
+      if (candidate._error == TRI_ERROR_NO_ERROR) {
+        candidate._error = TRI_ERROR_ARANGO_CORRUPTED_DATAFILE;
+      }
+      return;
+    }
+
+    MUTEX_LOCKER(reportLock);
+
+    ++numberDone;
+    sizeDone += candidate._datafile->_maximalSize;
+
+    double const now = TRI_microtime();
+
+    if (now - lastReport >= ReportInterval && numberDone < n) {
+      lastReport = now;
+
+      LOG_INFO("opening collection '%s/%s': checked %llu of %llu datafiles (%llu of %llu MB)",
+               collection->_vocbase->_name,
+               collection->_info._name,
+               (unsigned long long) numberDone,
+               (unsigned long long) n,
+               (unsigned long long) (sizeDone / (1024 * 1024)),
+               (unsigned long long) (totalSize / (1024 * 1024)));
+    }
+  };
+
+  auto indexPool = static_cast<triagens::basics::ThreadPool*>(collection->_vocbase->_server->_indexPool);
+
+  if (indexPool != nullptr && n > 1) {
+    indexPool->parallelFor(n, work);
+  }
+  else {
+    for (size_t i = 0; i < n; ++i) {
+      work(i);
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief checks a collection
 ///
@@ -423,6 +515,7 @@ static bool CheckCollection (TRI_collection_t* collection,
   TRI_vector_pointer_t journals;
   TRI_vector_pointer_t sealed;
   TRI_vector_string_t files;
+  std::vector<datafile_candidate_t> candidates;
   bool stop;
   regex_t re;
   size_t i, n;
@@ -489,8 +582,6 @@ static bool CheckCollection (TRI_collection_t* collection,
 
       else if (TRI_EqualString2("db", third, thirdLen)) {
         char* filename;
-        char* ptr;
-        TRI_col_header_marker_t* cm;
 
         if (TRI_EqualString2("compaction", first, firstLen)) {
           // found a compaction file. now rename it back
@@ -535,95 +626,121 @@ static bool CheckCollection (TRI_collection_t* collection,
         }
 
         TRI_ASSERT(filename != nullptr);
-        datafile = TRI_OpenDatafile(filename, ignoreErrors);
 
-        if (datafile == nullptr) {
-          collection->_lastError = TRI_errno();
-          LOG_ERROR("cannot open datafile '%s': %s", filename, TRI_last_error());
+        // the datafile is opened later, together with all others
+        datafile_candidate_t candidate;
+        candidate._filename = filename;
+        candidate._type     = std::string(first, firstLen);
+        candidate._datafile = nullptr;
+        candidate._error    = TRI_ERROR_NO_ERROR;
 
-          TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
-          stop = true;
-          break;
-        }
+        candidates.emplace_back(candidate);
+      }
+      else {
+        LOG_ERROR("unknown datafile '%s'", file);
+      }
+    }
+  }
+
+  TRI_DestroyVectorString(&files);
+
+  regfree(&re);
 
-        TRI_PushBackVectorPointer(&all, datafile);
+  // open and check the datafiles
+  if (! stop) {
+    OpenDatafiles(collection, candidates, ignoreErrors);
+  }
 
-        // check the document header
-        ptr  = datafile->_data;
-        // skip the datafile header
-        ptr += TRI_DF_ALIGN_BLOCK(sizeof(TRI_df_header_marker_t));
-        cm   = (TRI_col_header_marker_t*) ptr;
+  // register all opened datafiles first, so they are closed in case of an error
+  for (auto const& candidate : candidates) {
+    if (candidate._datafile != nullptr) {
+      TRI_PushBackVectorPointer(&all, candidate._datafile);
+    }
+  }
 
-        if (cm->base._type != TRI_COL_MARKER_HEADER) {
-          LOG_ERROR("collection header mismatch in file '%s', expected TRI_COL_MARKER_HEADER, found %lu",
-                    filename,
-                    (unsigned long) cm->base._type);
+  for (auto const& candidate : candidates) {
+    if (stop) {
+      break;
+    }
 
-          TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
-          stop = true;
-          break;
-        }
+    char const* filename = candidate._filename;
+    char const* type = candidate._type.c_str();
+    datafile = candidate._datafile;
 
-        if (cm->_cid != collection->_info._cid) {
-          LOG_ERROR("collection identifier mismatch, expected %llu, found %llu",
-                    (unsigned long long) collection->_info._cid,
-                    (unsigned long long) cm->_cid);
+    if (datafile == nullptr) {
+      collection->_lastError = candidate._error;
+      LOG_ERROR("cannot open datafile '%s': %s", filename, TRI_errno_string(candidate._error));
 
-          TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
-          stop = true;
-          break;
-        }
+      stop = true;
+      break;
+    }
 
-        // file is a journal
-        if (TRI_EqualString2("journal", first, firstLen)) {
-          if (datafile->_isSealed) {
-            if (datafile->_state != TRI_DF_STATE_READ) {
-              LOG_WARNING("strange, journal '%s' is already sealed; must be a left over; will use it as datafile", filename);
-            }
+    // check the document header
+    char* ptr = datafile->_data;
+    // skip the datafile header
+    ptr += TRI_DF_ALIGN_BLOCK(sizeof(TRI_df_header_marker_t));
+    TRI_col_header_marker_t* cm = (TRI_col_header_marker_t*) ptr;
 
-            TRI_PushBackVectorPointer(&sealed, datafile);
-          }
-          else {
-            TRI_PushBackVectorPointer(&journals, datafile);
-          }
-        }
+    if (cm->base._type != TRI_COL_MARKER_HEADER) {
+      LOG_ERROR("collection header mismatch in file '%s', expected TRI_COL_MARKER_HEADER, found %lu",
+                filename,
+                (unsigned long) cm->base._type);
 
-        // file is a compactor
-        else if (TRI_EqualString2("compactor", first, firstLen)) {
-          // ignore
-        }
+      stop = true;
+      break;
+    }
 
-        // file is a datafile (or was a compaction file)
-        else if (TRI_EqualString2("datafile", first, firstLen) ||
-                 TRI_EqualString2("compaction", first, firstLen)) {
-          if (! datafile->_isSealed) {
-            LOG_ERROR("datafile '%s' is not sealed, this should never happen", filename);
+    if (cm->_cid != collection->_info._cid) {
+      LOG_ERROR("collection identifier mismatch, expected %llu, found %llu",
+                (unsigned long long) collection->_info._cid,
+                (unsigned long long) cm->_cid);
 
-            collection->_lastError = TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
-            TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
-            stop = true;
-            break;
-          }
-          else {
-            TRI_PushBackVectorPointer(&datafiles, datafile);
-          }
-        }
+      stop = true;
+      break;
+    }
 
-        else {
-          LOG_ERROR("unknown datafile '%s'", file);
+    // file is a journal
+    if (TRI_EqualString("journal", type)) {
+      if (datafile->_isSealed) {
+        if (datafile->_state != TRI_DF_STATE_READ) {
+          LOG_WARNING("strange, journal '%s' is already sealed; must be a left over; will use it as datafile", filename);
         }
 
-        TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
+        TRI_PushBackVectorPointer(&sealed, datafile);
       }
       else {
-        LOG_ERROR("unknown datafile '%s'", file);
+        TRI_PushBackVectorPointer(&journals, datafile);
       }
     }
-  }
 
-  TRI_DestroyVectorString(&files);
+    // file is a compactor
+    else if (TRI_EqualString("compactor", type)) {
+      // ignore
+    }
 
-  regfree(&re);
+    // file is a datafile (or was a compaction file)
+    else if (TRI_EqualString("datafile", type) ||
+             TRI_EqualString("compaction", type)) {
+      if (! datafile->_isSealed) {
+        LOG_ERROR("datafile '%s' is not sealed, this should never happen", filename);
+
+        collection->_lastError = TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
+        stop = true;
+        break;
+      }
+      else {
+        TRI_PushBackVectorPointer(&datafiles, datafile);
+      }
+    }
+
+    else {
+      LOG_ERROR("unknown datafile '%s'", filename);
+    }
+  }
+
+  for (auto& candidate : candidates) {
+    TRI_FreeString(TRI_CORE_MEM_ZONE, candidate._filename);
+  }
 
   // convert the sealed journals into datafiles
   if (! stop) {
@@ -861,6 +978,9 @@ static void FillParametersFromJson (TRI_col_info_t* parameters,
       else if (TRI_EqualString(key->_value._string.data, "doCompact")) {
         parameters->_doCompact = value->_value._boolean;
       }
+      else if (TRI_EqualString(key->_value._string.data, "compressDatafiles")) {
+        parameters->_compressDatafiles = value->_value._boolean;
+      }
       else if (TRI_EqualString(key->_value._string.data, "isVolatile")) {
         parameters->_isVolatile = value->_value._boolean;
       }
@@ -919,6 +1039,7 @@ void TRI_InitCollectionInfo (TRI_vocbase_t* vocbase,
 
   parameters->_deleted       = false;
   parameters->_doCompact     = true;
+  parameters->_compressDatafiles = false;
   parameters->_isVolatile    = false;
   parameters->_isSystem      = false;
   parameters->_waitForSync   = vocbase->_settings.defaultWaitForSync;
@@ -962,6 +1083,7 @@ void TRI_CopyCollectionInfo (TRI_col_info_t* dst,
 
   dst->_deleted       = src->_deleted;
   dst->_doCompact     = src->_doCompact;
+  dst->_compressDatafiles = src->_compressDatafiles;
   dst->_isSystem      = src->_isSystem;
   dst->_isVolatile    = src->_isVolatile;
   dst->_waitForSync   = src->_waitForSync;
@@ -1340,6 +1462,7 @@ TRI_json_t* TRI_CreateJsonCollectionInfo (TRI_col_info_t const* info) {
 
   TRI_Insert3ObjectJson(TRI_CORE_MEM_ZONE, json, "deleted",      TRI_CreateBooleanJson(TRI_CORE_MEM_ZONE, info->_deleted));
   TRI_Insert3ObjectJson(TRI_CORE_MEM_ZONE, json, "doCompact",    TRI_CreateBooleanJson(TRI_CORE_MEM_ZONE, info->_doCompact));
+  TRI_Insert3ObjectJson(TRI_CORE_MEM_ZONE, json, "compressDatafiles", TRI_CreateBooleanJson(TRI_CORE_MEM_ZONE, info->_compressDatafiles));
   TRI_Insert3ObjectJson(TRI_CORE_MEM_ZONE, json, "maximalSize",  TRI_CreateNumberJson(TRI_CORE_MEM_ZONE, (double) info->_maximalSize));
   TRI_Insert3ObjectJson(TRI_CORE_MEM_ZONE, json, "name",         TRI_CreateStringCopyJson(TRI_CORE_MEM_ZONE, info->_name, strlen(info->_name)));
   TRI_Insert3ObjectJson(TRI_CORE_MEM_ZONE, json, "isVolatile",   TRI_CreateBooleanJson(TRI_CORE_MEM_ZONE, info->_isVolatile));
@@ -1468,6 +1591,7 @@ int TRI_UpdateCollectionInfo (TRI_vocbase_t* vocbase,
 
   if (parameters != nullptr) {
     collection->_info._doCompact   = parameters->_doCompact;
+    collection->_info._compressDatafiles = parameters->_compressDatafiles;
     collection->_info._maximalSize = parameters->_maximalSize;
     collection->_info._waitForSync = parameters->_waitForSync;
     collection->_info._indexBuckets = parameters->_indexBuckets;
@@ -1794,13 +1918,15 @@ int TRI_UpgradeCollection20 (TRI_vocbase_t* vocbase,
 
         tick = TRI_NewTickServer();
 
-        // datafile header
+        // datafile header. the shapes and attributes are copied including
+        // their checksums from the old datafiles, so the new datafile must
+        // use the same checksum algorithm
         TRI_InitMarkerDatafile((char*) &header, TRI_DF_MARKER_HEADER, sizeof(TRI_df_header_marker_t));
-        header._version     = TRI_DF_VERSION;
+        header._version     = TRI_DF_VERSION_CRC32;
         header._maximalSize = 0; // TODO: seems ok to set this to 0, check if this is ok
         header._fid         = tick;
         header.base._tick   = tick;
-        header.base._crc    = TRI_FinalCrc32(TRI_BlockCrc32(TRI_InitialCrc32(), (char const*) &header.base, header.base._size));
+        header.base._crc    = TRI_CalculateCrcMarkerDatafile(TRI_DF_VERSION_CRC32, &header.base);
 
         written += TRI_WRITE(fdout, &header.base, header.base._size);
 
@@ -1809,7 +1935,7 @@ int TRI_UpgradeCollection20 (TRI_vocbase_t* vocbase,
         cm._type      = (TRI_col_type_t) info->_type;
         cm._cid       = info->_cid;
         cm.base._tick = tick;
-        cm.base._crc  = TRI_FinalCrc32(TRI_BlockCrc32(TRI_InitialCrc32(), (char const*) &cm.base, cm.base._size));
+        cm.base._crc  = TRI_CalculateCrcMarkerDatafile(TRI_DF_VERSION_CRC32, &cm.base);
 
         written += TRI_WRITE(fdout, &cm.base, cm.base._size);
       }
@@ -1847,7 +1973,7 @@ int TRI_UpgradeCollection20 (TRI_vocbase_t* vocbase,
       tick = TRI_NewTickServer();
       TRI_InitMarkerDatafile((char*) &footer, TRI_DF_MARKER_FOOTER, sizeof(TRI_df_footer_marker_t));
       footer.base._tick = tick;
-      footer.base._crc  = TRI_FinalCrc32(TRI_BlockCrc32(TRI_InitialCrc32(), (char const*) &footer.base, footer.base._size));
+      footer.base._crc  = TRI_CalculateCrcMarkerDatafile(TRI_DF_VERSION_CRC32, &footer.base);
 
       written += TRI_WRITE(fdout, &footer.base, footer.base._size);
 
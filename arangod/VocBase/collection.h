@@ -183,6 +183,7 @@ typedef struct TRI_col_info_s {
   // flags
   bool               _deleted;         // if true, collection has been deleted
   bool               _doCompact;       // if true, collection will be compacted
+  bool               _compressDatafiles; // if true, the compactor writes compressed datafiles
   bool               _isSystem;        // if true, this is a system collection
   bool               _isVolatile;      // if true, collection is memory-only
   bool               _waitForSync;     // if true, wait for msync
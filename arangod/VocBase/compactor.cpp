@@ -36,6 +36,9 @@
 #include "Basics/conversions.h"
 #include "Basics/files.h"
 #include "Basics/logging.h"
+#include "Basics/memory-map.h"
+#include "Basics/MutexLocker.h"
+#include "Basics/process-utils.h"
 #include "Basics/tri-strings.h"
 #include "Utils/transactions.h"
 #include "VocBase/document-collection.h"
@@ -47,33 +50,6 @@
 // --SECTION--                                                 private constants
 // -----------------------------------------------------------------------------
 
-////////////////////////////////////////////////////////////////////////////////
-/// @brief minimum size of dead data (in bytes) in a datafile that will make
-/// the datafile eligible for compaction at all.
-///
-/// Any datafile with less dead data than the threshold will not become a
-/// candidate for compaction.
-////////////////////////////////////////////////////////////////////////////////
-
-#define COMPACTOR_DEAD_SIZE_THRESHOLD (1024 * 128)
-
-////////////////////////////////////////////////////////////////////////////////
-/// @brief percentage of dead documents in a datafile that will trigger the
-/// compaction
-///
-/// for example, if the collection contains 800 bytes of alive and 400 bytes of
-/// dead documents, the share of the dead documents is 400 / (400 + 800) = 33 %.
-/// if this value if higher than the threshold, the datafile will be compacted
-////////////////////////////////////////////////////////////////////////////////
-
-#define COMPACTOR_DEAD_SIZE_SHARE (0.1)
-
-////////////////////////////////////////////////////////////////////////////////
-/// @brief maximum number of datafiles to join together in one compaction run
-////////////////////////////////////////////////////////////////////////////////
-
-#define COMPACTOR_MAX_FILES 4
-
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief maximum multiple of journal filesize of a compacted file
 /// a value of 3 means that the maximum filesize of the compacted file is
@@ -83,28 +59,57 @@
 #define COMPACTOR_MAX_SIZE_FACTOR (3)
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief maximum filesize of resulting compacted file
+/// @brief re-try compaction of a specific collection in this interval (in s)
 ////////////////////////////////////////////////////////////////////////////////
 
-#define COMPACTOR_MAX_RESULT_FILESIZE (128 * 1024 * 1024)
+#define COMPACTOR_COLLECTION_INTERVAL (10.0)
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief datafiles smaller than the following value will be merged with others
+/// @brief amount of datafile data (in bytes) compacted while holding the
+/// write-lock on the primary index
+///
+/// the lock is released after each chunk, so compaction of a big datafile
+/// does not block writers for the whole duration of the compaction
 ////////////////////////////////////////////////////////////////////////////////
 
-#define COMPACTOR_MIN_SIZE (128 * 1024)
+#define COMPACTOR_CHUNK_SIZE (1024 * 1024)
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief re-try compaction of a specific collection in this interval (in s)
+/// @brief compactor settings
+///
+/// a datafile becomes a candidate for compaction if it contains at least
+/// _deadSizeThreshold bytes of dead data, or if the share of dead data is
+/// at least _deadShareThreshold. for example, if a datafile contains 800 bytes
+/// of alive and 400 bytes of dead documents, the share of the dead documents
+/// is 400 / (400 + 800) = 33 %.
+///
+/// datafiles smaller than _smallDatafileSize bytes are merged with their
+/// neighbors, up to _maxFiles datafiles and _maxResultFilesize bytes of live
+/// data per compacted datafile
+///
+/// the settings can be changed while the server is running. the compactor
+/// works on a copy of them, which is taken once per collection and run
 ////////////////////////////////////////////////////////////////////////////////
 
-#define COMPACTOR_COLLECTION_INTERVAL (10.0)
+static TRI_compactor_settings_t CompactorSettings = {
+  1.0,                  // _interval
+  128 * 1024,           // _deadSizeThreshold
+  0.1,                  // _deadShareThreshold
+  128 * 1024,           // _smallDatafileSize
+  4,                    // _maxFiles
+  128 * 1024 * 1024,    // _maxResultFilesize
+  0                     // _maxWriteRate
+};
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief compactify interval in microseconds
+/// @brief lock for the compactor settings
 ////////////////////////////////////////////////////////////////////////////////
 
-static int const COMPACTOR_INTERVAL = (1 * 1000 * 1000);
+static triagens::basics::Mutex CompactorSettingsLock;
 
 // -----------------------------------------------------------------------------
 // --SECTION--                                                     private types
@@ -141,6 +146,8 @@ typedef struct compaction_context_s {
   TRI_document_collection_t* _document;
   TRI_datafile_t*            _compactor;
   TRI_doc_datafile_info_t    _dfi;
+  double                     _start;
+  uint64_t                   _maxWriteRate;
   bool                       _keepDeletions;
 }
 compaction_context_t;
@@ -155,6 +162,22 @@ typedef struct compaction_info_s {
 }
 compaction_info_t;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief scoring information for a datafile when selecting datafiles for
+/// compaction
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct compaction_candidate_s {
+  TRI_datafile_t* _datafile;
+  int64_t         _numAliveBefore;  // number of alive documents in previous datafiles
+  int64_t         _liveSize;        // estimated size of data to be copied
+  double          _score;           // share of dead data
+  bool            _valid;           // whether or not datafile info is available
+  bool            _eligible;        // whether or not the datafile has enough dead data
+  bool            _small;           // whether or not the datafile should be merged
+}
+compaction_candidate_t;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private functions
 // -----------------------------------------------------------------------------
@@ -167,6 +190,33 @@ static inline int64_t AlignedSize (TRI_df_marker_t const* marker) {
   return static_cast<int64_t>(TRI_DF_ALIGN_BLOCK(marker->_size));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief estimated size of the data that compaction copies from a datafile
+////////////////////////////////////////////////////////////////////////////////
+
+static inline int64_t LiveSizeDatafile (TRI_doc_datafile_info_t const* dfi) {
+  return dfi->_sizeAlive + dfi->_sizeShapes + dfi->_sizeAttributes + dfi->_sizeTransactions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compaction score of a datafile
+///
+/// the score is the share of dead documents in the datafile, between 0 (no
+/// dead documents) and 1 (no alive documents). datafiles that only contain
+/// deletion markers also get a score of 1
+////////////////////////////////////////////////////////////////////////////////
+
+static double ScoreDatafile (TRI_doc_datafile_info_t const* dfi) {
+  double const dead  = static_cast<double>(dfi->_sizeDead);
+  double const total = dead + static_cast<double>(dfi->_sizeAlive);
+
+  if (total <= 0.0) {
+    return (dfi->_numberDeletion > 0 ? 1.0 : 0.0);
+  }
+
+  return dead / total;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief creates a compactor file, based on a datafile
 ////////////////////////////////////////////////////////////////////////////////
@@ -200,10 +250,14 @@ static TRI_datafile_t* CreateCompactor (TRI_document_collection_t* document,
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief write a copy of the marker into the datafile
+///
+/// if the marker comes from a datafile with a different version, its CRC
+/// is recalculated with the checksum algorithm of the compactor
 ////////////////////////////////////////////////////////////////////////////////
 
 static int CopyMarker (TRI_document_collection_t* document,
                        TRI_datafile_t* compactor,
+                       TRI_datafile_t const* datafile,
                        TRI_df_marker_t const* marker,
                        TRI_df_marker_t** result) {
   int res = TRI_ReserveElementDatafile(compactor, marker->_size, result, 0);
@@ -214,7 +268,13 @@ static int CopyMarker (TRI_document_collection_t* document,
     return TRI_ERROR_ARANGO_NO_JOURNAL;
   }
 
-  return TRI_WriteElementDatafile(compactor, *result, marker, false);
+  res = TRI_WriteElementDatafile(compactor, *result, marker, false);
+
+  if (res == TRI_ERROR_NO_ERROR && datafile->_version != compactor->_version) {
+    (*result)->_crc = TRI_CalculateCrcMarkerDatafile(compactor->_version, *result);
+  }
+
+  return res;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -472,7 +532,7 @@ static bool Compactifier (TRI_df_marker_t const* marker,
     context->_keepDeletions = true;
 
     // write to compactor files
-    res = CopyMarker(document, context->_compactor, marker, &result);
+    res = CopyMarker(document, context->_compactor, datafile, marker, &result);
 
     if (res != TRI_ERROR_NO_ERROR) {
       // TODO: dont fail but recover from this state
@@ -505,12 +565,14 @@ static bool Compactifier (TRI_df_marker_t const* marker,
         dfi->_numberDead += 1;
         dfi->_sizeDead += AlignedSize(marker);
       }
-
-      found2->_fid = context->_compactor->_fid;
     }
 
-    // let marker point to the new position
+    // let marker point to the new position. concurrent key lookups must not
+    // see the master pointer while it is changed
+    primaryIndex->beginWrite();
+    found2->_fid = context->_compactor->_fid;
     found2->setDataPtr(result);
+    primaryIndex->endWrite();
 
     // update datafile info
     context->_dfi._numberAlive += 1;
@@ -521,7 +583,7 @@ static bool Compactifier (TRI_df_marker_t const* marker,
   else if (marker->_type == TRI_DOC_MARKER_KEY_DELETION &&
            context->_keepDeletions) {
     // write to compactor files
-    res = CopyMarker(document, context->_compactor, marker, &result);
+    res = CopyMarker(document, context->_compactor, datafile, marker, &result);
 
     if (res != TRI_ERROR_NO_ERROR) {
       // TODO: dont fail but recover from this state
@@ -535,7 +597,7 @@ static bool Compactifier (TRI_df_marker_t const* marker,
   // shapes
   else if (marker->_type == TRI_DF_MARKER_SHAPE) {
     // write to compactor files
-    res = CopyMarker(document, context->_compactor, marker, &result);
+    res = CopyMarker(document, context->_compactor, datafile, marker, &result);
 
     if (res != TRI_ERROR_NO_ERROR) {
       // TODO: dont fail but recover from this state
@@ -555,7 +617,7 @@ static bool Compactifier (TRI_df_marker_t const* marker,
   // attributes
   else if (marker->_type == TRI_DF_MARKER_ATTRIBUTE) {
     // write to compactor files
-    res = CopyMarker(document, context->_compactor, marker, &result);
+    res = CopyMarker(document, context->_compactor, datafile, marker, &result);
 
     if (res != TRI_ERROR_NO_ERROR) {
       // TODO: dont fail but recover from this state
@@ -583,7 +645,7 @@ static bool Compactifier (TRI_df_marker_t const* marker,
 
     if (document->_failedTransactions != nullptr) {
       // write to compactor files
-      res = CopyMarker(document, context->_compactor, marker, &result);
+      res = CopyMarker(document, context->_compactor, datafile, marker, &result);
 
       if (res != TRI_ERROR_NO_ERROR) {
         // TODO: dont fail but recover from this state
@@ -599,6 +661,84 @@ static bool Compactifier (TRI_df_marker_t const* marker,
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief wait until the data written into the compactor file so far does not
+/// exceed the configured write rate
+////////////////////////////////////////////////////////////////////////////////
+
+static void ThrottleCompaction (compaction_context_t const* context) {
+  uint64_t const maxWriteRate = context->_maxWriteRate;
+
+  if (maxWriteRate == 0) {
+    return;
+  }
+
+  double const written  = static_cast<double>(context->_compactor->_currentSize);
+  double const expected = written / static_cast<double>(maxWriteRate);
+  double const elapsed  = TRI_microtime() - context->_start;
+
+  if (expected > elapsed) {
+    usleep((unsigned long) ((expected - elapsed) * 1000.0 * 1000.0));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief copies the "live" data of a datafile into the compactor
+///
+/// the datafile is processed in chunks of COMPACTOR_CHUNK_SIZE bytes. the
+/// write-lock on the primary index is held for one chunk only, and the
+/// compaction is throttled between chunks if a maximum write rate is set
+////////////////////////////////////////////////////////////////////////////////
+
+static bool CompactifyDatafile (TRI_document_collection_t* document,
+                                TRI_datafile_t* datafile,
+                                compaction_context_t* context) {
+  if (datafile->_state != TRI_DF_STATE_READ && datafile->_state != TRI_DF_STATE_WRITE) {
+    TRI_set_errno(TRI_ERROR_ARANGO_ILLEGAL_STATE);
+    return false;
+  }
+
+  char const* ptr = datafile->_data;
+  char const* end = datafile->_data + datafile->_currentSize;
+
+  // the datafile is read in order, so let the kernel read ahead
+  TRI_AdviseDatafile(datafile, TRI_MADVISE_SEQUENTIAL);
+
+  while (ptr < end) {
+    char const* chunkEnd = ptr + COMPACTOR_CHUNK_SIZE;
+
+    TRI_WRITE_LOCK_DOCUMENTS_INDEXES_PRIMARY_COLLECTION(document);
+
+    while (ptr < end && ptr < chunkEnd) {
+      TRI_df_marker_t const* marker = reinterpret_cast<TRI_df_marker_t const*>(ptr);
+
+      if (marker->_size == 0) {
+        end = ptr;
+        break;
+      }
+
+      // update the tick statistics
+      TRI_UpdateTicksDatafile(datafile, marker);
+
+      if (! Compactifier(marker, context, datafile)) {
+        TRI_WRITE_UNLOCK_DOCUMENTS_INDEXES_PRIMARY_COLLECTION(document);
+        TRI_ResetAdviceDatafile(datafile);
+        return false;
+      }
+
+      ptr += TRI_DF_ALIGN_BLOCK(marker->_size);
+    }
+
+    TRI_WRITE_UNLOCK_DOCUMENTS_INDEXES_PRIMARY_COLLECTION(document);
+
+    ThrottleCompaction(context);
+  }
+
+  TRI_ResetAdviceDatafile(datafile);
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief remove an empty compactor file
 ////////////////////////////////////////////////////////////////////////////////
@@ -678,6 +818,10 @@ static int RemoveDatafile (TRI_document_collection_t* document,
 
   TRI_WRITE_UNLOCK_DATAFILES_DOC_COLLECTION(document);
 
+  // the datafile stays mapped until it is dropped, but its pages are not
+  // needed anymore
+  TRI_AdviseDatafile(df, TRI_MADVISE_DONTNEED);
+
   return TRI_ERROR_NO_ERROR;
 }
 
@@ -781,6 +925,43 @@ static compaction_initial_context_t InitCompaction (TRI_document_collection_t* d
   return context;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief writes a sealed compaction file compressed to disk
+///
+/// the compressed copy replaces the compaction file on disk, while the
+/// memory of the compaction file stays valid. failing to compress is not an
+/// error: the file is kept uncompressed then
+////////////////////////////////////////////////////////////////////////////////
+
+static void CompressCompactor (TRI_document_collection_t* document,
+                               TRI_datafile_t* compactor) {
+  if (! document->_info._compressDatafiles ||
+      ! compactor->isPhysical(compactor)) {
+    return;
+  }
+
+  // use a fresh tick for the temporary name, as "temp-<fid>.db" is used by
+  // the rename callback
+  char* number       = TRI_StringUInt64(TRI_NewTickServer());
+  char* jname        = TRI_Concatenate3String("temp-", number, ".db");
+  char* tempFilename = TRI_Concatenate2File(document->_directory, jname);
+
+  TRI_FreeString(TRI_CORE_MEM_ZONE, number);
+  TRI_FreeString(TRI_CORE_MEM_ZONE, jname);
+
+  if (tempFilename == nullptr) {
+    return;
+  }
+
+  int res = TRI_CompressDatafile(compactor, tempFilename);
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    LOG_WARNING("could not compress compaction file '%s': %s", compactor->getName(compactor), TRI_errno_string(res));
+  }
+
+  TRI_FreeString(TRI_CORE_MEM_ZONE, tempFilename);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief compact a list of datafiles
 ////////////////////////////////////////////////////////////////////////////////
@@ -830,6 +1011,13 @@ static void CompactifyDatafiles (TRI_document_collection_t* document,
   context._document  = document;
   context._compactor = compactor;
   context._dfi._fid  = compactor->_fid;
+  context._start     = TRI_microtime();
+  context._maxWriteRate = TRI_GetSettingsCompactor()._maxWriteRate;
+
+  int64_t bytesRead = 0;
+
+  uint64_t minorPageFaults, majorPageFaults;
+  TRI_PageFaultsThread(&minorPageFaults, &majorPageFaults);
 
   // now compact all datafiles
   for (i = 0; i < n; ++i) {
@@ -846,12 +1034,8 @@ static void CompactifyDatafiles (TRI_document_collection_t* document,
     // deletion markers
     context._keepDeletions = compaction->_keepDeletions;
 
-    TRI_WRITE_LOCK_DOCUMENTS_INDEXES_PRIMARY_COLLECTION(document);
-    
     // run the actual compaction of a single datafile
-    bool ok = TRI_IterateDatafile(df, Compactifier, &context);
-    
-    TRI_WRITE_UNLOCK_DOCUMENTS_INDEXES_PRIMARY_COLLECTION(document);
+    bool ok = CompactifyDatafile(document, df, &context);
 
     if (! ok) {
       LOG_WARNING("failed to compact datafile '%s'", df->getName(df));
@@ -859,8 +1043,26 @@ static void CompactifyDatafiles (TRI_document_collection_t* document,
       // TODO: Remove
       return;
     }
+
+    bytesRead += static_cast<int64_t>(df->_currentSize);
   } // next file
 
+  // update the write amplification statistics
+  int64_t const bytesWritten = static_cast<int64_t>(compactor->_currentSize);
+
+  document->_compactionRuns++;
+  document->_compactionFiles += static_cast<int64_t>(n);
+  document->addPageFaultsSince(minorPageFaults, majorPageFaults);
+  document->_compactionBytesRead += bytesRead;
+  document->_compactionBytesWritten += bytesWritten;
+
+  LOG_DEBUG("compacted %d datafile(s) of collection '%s' in %f s. bytes read: %llu, bytes written: %llu",
+            (int) n,
+            document->_info._name,
+            TRI_microtime() - context._start,
+            (unsigned long long) bytesRead,
+            (unsigned long long) bytesWritten);
+
 
   // locate the compactor
   // must acquire a write-lock as we're about to change the datafiles vector
@@ -926,6 +1128,8 @@ static void CompactifyDatafiles (TRI_document_collection_t* document,
     }
   }
   else {
+    CompressCompactor(document, compactor);
+
     if (n > 1) {
       // create .dead files for all collected files but the first
       for (i = 1; i < n; ++i) {
@@ -947,6 +1151,10 @@ static void CompactifyDatafiles (TRI_document_collection_t* document,
       compaction_info_t* compaction = static_cast<compaction_info_t*>(TRI_AtVector(compactions, i));
 
       if (i == 0) {
+        // all live data has been copied into the compactor, so the pages of
+        // the datafile are not needed anymore
+        TRI_AdviseDatafile(compaction->_datafile, TRI_MADVISE_DONTNEED);
+
         // add a rename marker
         void* copy;
 
@@ -1004,87 +1212,77 @@ static bool CompactifyDocumentCollection (TRI_document_collection_t* document) {
     return false;
   }
 
+  TRI_compactor_settings_t const settings = TRI_GetSettingsCompactor();
+
   // get maximum size of result file
   uint64_t maxSize = (uint64_t) COMPACTOR_MAX_SIZE_FACTOR * (uint64_t) document->_info._maximalSize;
   if (maxSize < 8 * 1024 * 1024) {
     maxSize = 8 * 1024 * 1024;
   }
-  if (maxSize >= COMPACTOR_MAX_RESULT_FILESIZE) {
-    maxSize = COMPACTOR_MAX_RESULT_FILESIZE;
+  if (maxSize >= settings._maxResultFilesize) {
+    maxSize = settings._maxResultFilesize;
   }
 
-  // copy datafile information
-  TRI_vector_t vector;
-  TRI_InitVector(&vector, TRI_UNKNOWN_MEM_ZONE, sizeof(compaction_info_t));
+  // score all datafiles
+  std::vector<compaction_candidate_t> candidates;
+  candidates.reserve(n);
   int64_t numAlive = 0;
-  bool compactNext = false;
 
   for (size_t i = 0;  i < n;  ++i) {
-    TRI_doc_datafile_info_t* dfi;
-    compaction_info_t compaction;
-    uint64_t totalSize = 0;
-    bool shouldCompact;
-
     TRI_datafile_t* df = static_cast<TRI_datafile_t*>(document->_datafiles._buffer[i]);
 
     TRI_ASSERT(df != nullptr);
 
-    dfi = TRI_FindDatafileInfoDocumentCollection(document, df->_fid, false);
+    compaction_candidate_t candidate;
+    memset(&candidate, 0, sizeof(compaction_candidate_t));
+    candidate._datafile = df;
+    candidate._numAliveBefore = numAlive;
+
+    TRI_doc_datafile_info_t* dfi = TRI_FindDatafileInfoDocumentCollection(document, df->_fid, false);
 
     if (dfi == nullptr) {
       // datafile info not found. this shouldn't happen
       LOG_WARNING("datafile info not found for datafile %llu", (unsigned long long) df->_fid);
+      candidates.push_back(candidate);
       continue;
     }
 
-    shouldCompact = false;
-  
-    if (! compactNext &&
-        df->_maximalSize < COMPACTOR_MIN_SIZE &&
-        i < n - 1) {
-      // very small datafile. let's compact it so it's merged with others
-      shouldCompact = true;
-      compactNext = true;
-    }
-    else if (numAlive == 0 && dfi->_numberAlive == 0 && dfi->_numberDeletion > 0) {
+    candidate._valid    = true;
+    candidate._liveSize = LiveSizeDatafile(dfi);
+    candidate._score    = ScoreDatafile(dfi);
+    candidate._small    = (df->_maximalSize < settings._smallDatafileSize);
+
+    if (numAlive == 0 && dfi->_numberAlive == 0 && dfi->_numberDeletion > 0) {
       // compact first datafile(s) already if they have some deletions
-      shouldCompact = true;
-      compactNext = true;
+      candidate._eligible = true;
     }
-    else {
-      // in all other cases, only check the number and size of "dead" objects
-      if (dfi->_sizeDead >= (int64_t) COMPACTOR_DEAD_SIZE_THRESHOLD) {
-        shouldCompact = true;
-        compactNext = true;
-      }
-      else if (dfi->_sizeDead > 0) {
-        // the size of dead objects is above some threshold
-        double share = (double) dfi->_sizeDead / ((double) dfi->_sizeDead + (double) dfi->_sizeAlive);
-
-        if (share >= COMPACTOR_DEAD_SIZE_SHARE) {
-          // the size of dead objects is above some share
-          shouldCompact = true;
-          compactNext = true;
-        }
-      }
+    else if (dfi->_sizeDead >= (int64_t) settings._deadSizeThreshold) {
+      // the size of dead objects is above some threshold
+      candidate._eligible = true;
     }
-
-    if (! shouldCompact) {
-      // only use those datafiles that contain dead objects
-
-      if (! compactNext) {
-        numAlive += (int64_t) dfi->_numberAlive;
-        continue;
-      }
+    else if (dfi->_sizeDead > 0 && candidate._score >= settings._deadShareThreshold) {
+      // the share of dead objects is above some threshold
+      candidate._eligible = true;
+    }
+    else if (document->_info._compressDatafiles &&
+             df->isPhysical(df) &&
+             df->_isSealed &&
+             ! df->_isCompressed) {
+      // rewrite datafiles of collections with compression turned on, so
+      // they get compressed on disk
+      candidate._eligible = true;
     }
 
-    LOG_TRACE("found datafile eligible for compaction. fid: %llu, size: %llu "
+    LOG_TRACE("scored datafile for compaction. fid: %llu, size: %llu, score: %f, eligible: %d, small: %d, "
               "numberDead: %llu, numberAlive: %llu, numberDeletion: %llu, "
               "numberShapes: %llu, numberAttributes: %llu, transactions: %llu, "
               "sizeDead: %llu, sizeAlive: %llu, sizeShapes %llu, sizeAttributes: %llu, "
               "sizeTransactions: %llu",
               (unsigned long long) df->_fid,
               (unsigned long long) df->_maximalSize,
+              candidate._score,
+              (int) candidate._eligible,
+              (int) candidate._small,
               (unsigned long long) dfi->_numberDead,
               (unsigned long long) dfi->_numberAlive,
               (unsigned long long) dfi->_numberDeletion,
@@ -1096,27 +1294,71 @@ static bool CompactifyDocumentCollection (TRI_document_collection_t* document) {
               (unsigned long long) dfi->_sizeShapes,
               (unsigned long long) dfi->_sizeAttributes,
               (unsigned long long) dfi->_sizeTransactions);
-    totalSize += (uint64_t) df->_maximalSize;
 
-    compaction._datafile = df;
-    compaction._keepDeletions = (numAlive > 0 && i > 0);
+    candidates.push_back(candidate);
+    numAlive += (int64_t) dfi->_numberAlive;
+  }
 
-    TRI_PushBackVector(&vector, &compaction);
+  // start with the datafile that has the highest share of dead data, as it
+  // reclaims the most space per byte rewritten. if no datafile contains enough
+  // dead data, start with the first of at least two adjacent small datafiles
+  size_t start = n;
 
-    // we stop at the first few datafiles.
-    // this is better than going over all datafiles in a collection in one go
-    // because the compactor is single-threaded, and collecting all datafiles
-    // might take a long time (it might even be that there is a request to
-    // delete the collection in the middle of compaction, but the compactor
-    // will not pick this up as it is read-locking the collection status)
+  for (size_t i = 0;  i < n;  ++i) {
+    if (candidates[i]._eligible &&
+        (start == n || candidates[i]._score > candidates[start]._score)) {
+      start = i;
+    }
+  }
 
-    if (TRI_LengthVector(&vector) >= COMPACTOR_MAX_FILES ||
-        totalSize >= maxSize) {
-      // found enough to compact
-      break;
+  if (start == n) {
+    for (size_t i = 0;  i + 1 < n;  ++i) {
+      if (candidates[i]._valid && candidates[i]._small &&
+          candidates[i + 1]._valid && candidates[i + 1]._small) {
+        start = i;
+        break;
+      }
     }
+  }
 
-    numAlive += (int64_t) dfi->_numberAlive;
+  // copy datafile information
+  TRI_vector_t vector;
+  TRI_InitVector(&vector, TRI_UNKNOWN_MEM_ZONE, sizeof(compaction_info_t));
+
+  if (start < n) {
+    uint64_t totalSize = 0;
+
+    // the datafiles following the first one are merged into the same compactor
+    // file if they contain enough dead data themselves or are small. we stop at
+    // the first other datafile, so only adjacent datafiles are merged
+    for (size_t i = start;  i < n;  ++i) {
+      compaction_candidate_t const& candidate = candidates[i];
+
+      if (i > start) {
+        if (! candidate._valid ||
+            ! (candidate._eligible || candidate._small) ||
+            totalSize + (uint64_t) candidate._liveSize > maxSize) {
+          break;
+        }
+      }
+
+      compaction_info_t compaction;
+      compaction._datafile = candidate._datafile;
+      compaction._keepDeletions = (candidate._numAliveBefore > 0 && i > 0);
+
+      TRI_PushBackVector(&vector, &compaction);
+      totalSize += (uint64_t) candidate._liveSize;
+
+      // we stop after a limited number of datafiles.
+      // this is better than going over all datafiles in a collection in one go
+      // because the compactor is single-threaded, and collecting all datafiles
+      // might take a long time (it might even be that there is a request to
+      // delete the collection in the middle of compaction, but the compactor
+      // will not pick this up as it is read-locking the collection status)
+      if (TRI_LengthVector(&vector) >= settings._maxFiles) {
+        break;
+      }
+    }
   }
 
   // can now continue without the lock
@@ -1203,6 +1445,32 @@ static bool CheckAndLockCompaction (TRI_vocbase_t* vocbase) {
 // --SECTION--                                                  public functions
 // -----------------------------------------------------------------------------
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the compactor settings
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_compactor_settings_t TRI_GetSettingsCompactor () {
+  MUTEX_LOCKER(CompactorSettingsLock);
+  return CompactorSettings;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sets the compactor settings
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_SetSettingsCompactor (TRI_compactor_settings_t const* settings) {
+  MUTEX_LOCKER(CompactorSettingsLock);
+  CompactorSettings = *settings;
+
+  if (CompactorSettings._interval <= 0.0) {
+    CompactorSettings._interval = 1.0;
+  }
+
+  if (CompactorSettings._maxFiles == 0) {
+    CompactorSettings._maxFiles = 1;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief initialise the compaction blockers structure
 ////////////////////////////////////////////////////////////////////////////////
@@ -1477,7 +1745,7 @@ void TRI_CompactorVocBase (void* data) {
     else if (state != 2 && vocbase->_state == 1) {
       // only sleep while server is still running
       TRI_LockCondition(&vocbase->_compactorCondition);
-      TRI_TimedWaitCondition(&vocbase->_compactorCondition, (uint64_t) COMPACTOR_INTERVAL);
+      TRI_TimedWaitCondition(&vocbase->_compactorCondition, (uint64_t) (TRI_GetSettingsCompactor()._interval * 1000.0 * 1000.0));
       TRI_UnlockCondition(&vocbase->_compactorCondition);
     }
 
@@ -36,10 +36,43 @@
 
 struct TRI_vocbase_s;
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                      public types
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compactor settings
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct TRI_compactor_settings_s {
+  double    _interval;              // sleep time between compaction runs (in s)
+  uint64_t  _deadSizeThreshold;     // minimum size of dead data in a datafile
+  double    _deadShareThreshold;    // minimum share of dead data in a datafile
+  uint64_t  _smallDatafileSize;     // smaller datafiles get merged
+  uint32_t  _maxFiles;              // maximum number of datafiles per run
+  uint64_t  _maxResultFilesize;     // maximum size of a compacted datafile
+  uint64_t  _maxWriteRate;          // maximum write rate (in bytes/s), 0 = unlimited
+}
+TRI_compactor_settings_t;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                  public functions
 // -----------------------------------------------------------------------------
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the compactor settings
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_compactor_settings_t TRI_GetSettingsCompactor ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sets the compactor settings
+///
+/// the new settings are used by the next compaction run
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_SetSettingsCompactor (TRI_compactor_settings_t const*);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief initialise the compaction blockers structure
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,670 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief on-demand decompression of compressed datafiles
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Dr. Frank Celler
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2011-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#include "compressed-datafile.h"
+
+#include "Basics/logging.h"
+#include "Basics/Mutex.h"
+#include "Basics/MutexLocker.h"
+
+#include "zlib.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximal number of compressed datafiles with on-demand decompression
+///
+/// further compressed datafiles are decompressed completely when opened
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const MaxRegions = 4096;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief minimal number of blocks in the cache
+///
+/// a single memory access may need two adjacent blocks, and several threads
+/// may access compressed datafiles at the same time
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t const MinCacheBlocks = 64;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief size of the memory zlib may use to decompress a block
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const ArenaSize = 64 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief states of a block
+////////////////////////////////////////////////////////////////////////////////
+
+static uint8_t const BlockAbsent   = 0;
+static uint8_t const BlockLoading  = 1;
+static uint8_t const BlockResident = 2;
+static uint8_t const BlockEvicting = 3;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                     private types
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief address range of a compressed datafile
+////////////////////////////////////////////////////////////////////////////////
+
+struct TRI_df_compressed_region_s {
+  char* _data;                                 // start of the reserved range
+  size_t _reservedSize;                        // size of the reserved range
+  char const* _compressed;                     // mapping of the compressed file
+  size_t _compressedSize;                      // size of the compressed file
+  TRI_df_compressed_block_t const* _blocks;    // block index
+  uint64_t _size;                              // size of the uncompressed data
+  uint32_t _blockSize;
+  uint32_t _numberBlocks;
+  size_t _slot;                                // position in the region table
+  uint16_t _generation;                        // distinguishes users of a slot
+  std::atomic<uint8_t>* _states;               // state of each block
+  std::atomic<uint64_t> _resident;             // number of decompressed blocks
+};
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximal size of the decompressed blocks in memory
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t CacheSize = 128 * 1024 * 1024;
+
+#ifdef __linux__
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief protects the creation and removal of regions
+////////////////////////////////////////////////////////////////////////////////
+
+static triagens::basics::Mutex RegionsLock;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether the fault handler is installed
+////////////////////////////////////////////////////////////////////////////////
+
+static bool HandlerInstalled = false;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the fault handler that was installed before
+////////////////////////////////////////////////////////////////////////////////
+
+static struct sigaction PreviousHandler;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the regions, looked up by the fault handler
+////////////////////////////////////////////////////////////////////////////////
+
+static std::atomic<TRI_df_compressed_region_s*> Regions[MaxRegions];
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of region slots that have been used so far
+////////////////////////////////////////////////////////////////////////////////
+
+static std::atomic<size_t> RegionsUsed(0);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief generation of the last created region
+////////////////////////////////////////////////////////////////////////////////
+
+static uint16_t LastGeneration = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief current epoch of the fault handlers, and the number of running
+/// fault handlers per epoch
+///
+/// a region is only freed after all fault handlers that may have seen it
+/// have finished
+////////////////////////////////////////////////////////////////////////////////
+
+static std::atomic<uint64_t> HandlerEpoch(0);
+static std::atomic<uint64_t> ActiveHandlers[2];
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief decompressed blocks in the order of their decompression
+///
+/// an entry contains the slot and the generation of the region and the block
+/// number, or 0 if it is unused
+////////////////////////////////////////////////////////////////////////////////
+
+static std::atomic<uint64_t>* Cache = nullptr;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of entries in the cache
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t CacheBlocks = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief position of the next cache entry to use
+////////////////////////////////////////////////////////////////////////////////
+
+static std::atomic<uint64_t> CachePosition(0);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief memory zlib uses in the fault handler of the current thread
+////////////////////////////////////////////////////////////////////////////////
+
+static __thread char* ArenaMemory = nullptr;
+static __thread size_t ArenaUsed = 0;
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+#ifdef __linux__
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief terminates the process from the fault handler
+////////////////////////////////////////////////////////////////////////////////
+
+static void FatalFault (char const* message) {
+  // only async-signal-safe functions can be used here
+  ssize_t res = write(STDERR_FILENO, message, strlen(message));
+  (void) res;
+  abort();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief allocates memory for zlib from the arena of the current thread
+////////////////////////////////////////////////////////////////////////////////
+
+static voidpf ArenaAllocate (voidpf, uInt items, uInt size) {
+  size_t const length = ((static_cast<size_t>(items) * size) + 15) & ~static_cast<size_t>(15);
+
+  if (ArenaUsed + length > ArenaSize) {
+    return Z_NULL;
+  }
+
+  voidpf result = ArenaMemory + ArenaUsed;
+  ArenaUsed += length;
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief frees memory of zlib. the arena is reset for each block
+////////////////////////////////////////////////////////////////////////////////
+
+static void ArenaFree (voidpf, voidpf) {
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief decompresses a block into the memory at dest
+///
+/// this is called from the fault handler, so it must not call malloc. zlib
+/// allocates its state from an arena of the thread instead
+////////////////////////////////////////////////////////////////////////////////
+
+static bool DecompressBlock (TRI_df_compressed_region_s const* region,
+                             uint32_t block,
+                             char* dest) {
+  TRI_df_compressed_block_t const& entry = region->_blocks[block];
+
+  uint64_t const start = static_cast<uint64_t>(block) * region->_blockSize;
+  uint64_t const length = (std::min)(static_cast<uint64_t>(region->_blockSize), region->_size - start);
+  char const* src = region->_compressed + entry._offset;
+
+  if (entry._size == length) {
+    // block is stored uncompressed
+    memcpy(dest, src, length);
+    return true;
+  }
+
+  if (ArenaMemory == nullptr) {
+    void* memory = mmap(nullptr, ArenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED) {
+      return false;
+    }
+
+    ArenaMemory = static_cast<char*>(memory);
+  }
+
+  ArenaUsed = 0;
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(z_stream));
+  stream.zalloc    = ArenaAllocate;
+  stream.zfree     = ArenaFree;
+  stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(src));
+  stream.avail_in  = static_cast<uInt>(entry._size);
+  stream.next_out  = reinterpret_cast<Bytef*>(dest);
+  stream.avail_out = static_cast<uInt>(length);
+
+  if (inflateInit(&stream) != Z_OK) {
+    return false;
+  }
+
+  bool const ok = (inflate(&stream, Z_FINISH) == Z_STREAM_END &&
+                   stream.total_out == length);
+
+  inflateEnd(&stream);
+
+  return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief makes a decompressed block inaccessible again, and returns its
+/// memory to the operating system
+////////////////////////////////////////////////////////////////////////////////
+
+static void EvictBlock (uint64_t entry) {
+  size_t const slot         = static_cast<size_t>(entry >> 48);
+  uint16_t const generation = static_cast<uint16_t>(entry >> 32);
+  uint32_t const block      = static_cast<uint32_t>(entry);
+
+  TRI_df_compressed_region_s* region = Regions[slot].load();
+
+  if (region == nullptr ||
+      region->_generation != generation ||
+      block >= region->_numberBlocks) {
+    // the datafile has been closed in between
+    return;
+  }
+
+  uint8_t expected = BlockResident;
+
+  if (! region->_states[block].compare_exchange_strong(expected, BlockEvicting)) {
+    // evicted already, and possibly being decompressed again
+    return;
+  }
+
+  char* target = region->_data + static_cast<size_t>(block) * region->_blockSize;
+
+  // replacing the pages is atomic. a thread reading the block at the same
+  // time faults and waits until the block is absent, then decompresses it
+  // again
+  if (mmap(target, region->_blockSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0) == MAP_FAILED) {
+    region->_states[block].store(BlockResident);
+    return;
+  }
+
+  region->_resident--;
+  region->_states[block].store(BlockAbsent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief decompresses a block and makes it readable
+////////////////////////////////////////////////////////////////////////////////
+
+static void LoadBlock (TRI_df_compressed_region_s* region,
+                       uint32_t block) {
+  std::atomic<uint8_t>& state = region->_states[block];
+
+  while (true) {
+    uint8_t expected = BlockAbsent;
+
+    if (state.compare_exchange_strong(expected, BlockLoading)) {
+      break;
+    }
+
+    if (expected == BlockResident) {
+      // another thread has decompressed the block in between
+      return;
+    }
+
+    // another thread decompresses or evicts the block
+    sched_yield();
+  }
+
+  // the block is decompressed into separate pages first, so no thread can
+  // see it partially decompressed
+  void* scratch = mmap(nullptr, region->_blockSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (scratch == MAP_FAILED) {
+    FatalFault("cannot allocate memory for a block of a compressed datafile\n");
+  }
+
+  if (! DecompressBlock(region, block, static_cast<char*>(scratch))) {
+    FatalFault("cannot decompress a block of a compressed datafile\n");
+  }
+
+  char* target = region->_data + static_cast<size_t>(block) * region->_blockSize;
+
+  if (mprotect(scratch, region->_blockSize, PROT_READ) != 0 ||
+      mremap(scratch, region->_blockSize, region->_blockSize, MREMAP_MAYMOVE | MREMAP_FIXED, target) == MAP_FAILED) {
+    FatalFault("cannot map a block of a compressed datafile\n");
+  }
+
+  region->_resident++;
+  state.store(BlockResident);
+
+  // the oldest decompressed block makes room for the new one
+  uint64_t const entry = (static_cast<uint64_t>(region->_slot) << 48) |
+                         (static_cast<uint64_t>(region->_generation) << 32) |
+                         static_cast<uint64_t>(block);
+
+  uint64_t const position = CachePosition++ % CacheBlocks;
+  uint64_t const previous = Cache[position].exchange(entry);
+
+  if (previous != 0) {
+    EvictBlock(previous);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the region containing an address
+////////////////////////////////////////////////////////////////////////////////
+
+static TRI_df_compressed_region_s* FindRegion (char const* address) {
+  size_t const n = RegionsUsed.load();
+
+  for (size_t i = 0;  i < n;  ++i) {
+    TRI_df_compressed_region_s* region = Regions[i].load();
+
+    if (region != nullptr &&
+        address >= region->_data &&
+        address < region->_data + region->_reservedSize) {
+      return region;
+    }
+  }
+
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether a fault was caused by a write access
+///
+/// decompressed blocks are read-only, so writing to them is a bug that must
+/// not be handled by decompressing the block again
+////////////////////////////////////////////////////////////////////////////////
+
+static bool IsWriteFault (void* context) {
+#if defined(__x86_64__)
+  ucontext_t const* uc = static_cast<ucontext_t const*>(context);
+  return (uc->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+#else
+  return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief passes a fault on to the previously installed handler
+////////////////////////////////////////////////////////////////////////////////
+
+static void ForwardFault (int signum,
+                          siginfo_t* info,
+                          void* context) {
+  if (PreviousHandler.sa_flags & SA_SIGINFO) {
+    PreviousHandler.sa_sigaction(signum, info, context);
+    return;
+  }
+
+  if (PreviousHandler.sa_handler == SIG_DFL || PreviousHandler.sa_handler == SIG_IGN) {
+    // the faulting instruction is executed again and terminates the process
+    signal(signum, SIG_DFL);
+    return;
+  }
+
+  PreviousHandler.sa_handler(signum);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief handles faults in the address ranges of compressed datafiles
+////////////////////////////////////////////////////////////////////////////////
+
+static void HandleFault (int signum,
+                         siginfo_t* info,
+                         void* context) {
+  int const savedErrno = errno;
+
+  uint64_t const epoch = HandlerEpoch.load() & 1;
+  ActiveHandlers[epoch]++;
+
+  char const* address = static_cast<char const*>(info->si_addr);
+  TRI_df_compressed_region_s* region = FindRegion(address);
+  bool const handled = (region != nullptr && ! IsWriteFault(context));
+
+  if (handled) {
+    LoadBlock(region, static_cast<uint32_t>((address - region->_data) / region->_blockSize));
+  }
+
+  ActiveHandlers[epoch]--;
+
+  errno = savedErrno;
+
+  if (! handled) {
+    ForwardFault(signum, info, context);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief waits until all fault handlers that may see a removed region have
+/// finished
+///
+/// must be called with the RegionsLock held
+////////////////////////////////////////////////////////////////////////////////
+
+static void WaitForFaultHandlers () {
+  // handlers that start from now on count in the other epoch
+  uint64_t const epoch = HandlerEpoch++ & 1;
+
+  while (ActiveHandlers[epoch].load() != 0) {
+    sched_yield();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief installs the fault handler and allocates the cache
+///
+/// must be called with the RegionsLock held
+////////////////////////////////////////////////////////////////////////////////
+
+static bool InstallFaultHandler () {
+  if (HandlerInstalled) {
+    return true;
+  }
+
+  CacheBlocks = (std::max)(CacheSize / TRI_DF_COMPRESSED_BLOCK_SIZE, MinCacheBlocks);
+  Cache = new std::atomic<uint64_t>[CacheBlocks];
+
+  for (uint64_t i = 0;  i < CacheBlocks;  ++i) {
+    Cache[i] = 0;
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_sigaction = HandleFault;
+  action.sa_flags = SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+
+  if (sigaction(SIGSEGV, &action, &PreviousHandler) != 0) {
+    LOG_ERROR("cannot install fault handler for compressed datafiles: %s", strerror(errno));
+
+    delete[] Cache;
+    Cache = nullptr;
+
+    return false;
+  }
+
+  HandlerInstalled = true;
+
+  LOG_DEBUG("using a cache of %llu blocks for compressed datafiles", (unsigned long long) CacheBlocks);
+
+  return true;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sets the maximal size of the decompressed blocks in memory
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_SetCacheSizeCompressedDatafiles (uint64_t size) {
+  CacheSize = size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief creates the address range for a compressed datafile
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_df_compressed_region_s* TRI_CreateCompressedRegion (char const* filename,
+                                                        void* compressed,
+                                                        size_t compressedSize,
+                                                        TRI_df_compressed_header_t const* header) {
+#ifdef __linux__
+  if (header->_blockSize != TRI_DF_COMPRESSED_BLOCK_SIZE ||
+      header->_blockSize % static_cast<uint32_t>(getpagesize()) != 0) {
+    return nullptr;
+  }
+
+  size_t const reservedSize = static_cast<size_t>(header->_numberBlocks) * header->_blockSize;
+
+  MUTEX_LOCKER(RegionsLock);
+
+  if (! InstallFaultHandler()) {
+    return nullptr;
+  }
+
+  size_t slot = 0;
+
+  while (slot < MaxRegions && Regions[slot].load() != nullptr) {
+    ++slot;
+  }
+
+  if (slot == MaxRegions) {
+    LOG_DEBUG("too many compressed datafiles, decompressing '%s' completely", filename);
+    return nullptr;
+  }
+
+  // reserve the address range without access rights and without memory
+  void* data = mmap(nullptr, reservedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (data == MAP_FAILED) {
+    LOG_ERROR("cannot reserve memory for compressed datafile '%s': %s", filename, strerror(errno));
+    return nullptr;
+  }
+
+  auto region = new TRI_df_compressed_region_s;
+
+  region->_data           = static_cast<char*>(data);
+  region->_reservedSize   = reservedSize;
+  region->_compressed     = static_cast<char const*>(compressed);
+  region->_compressedSize = compressedSize;
+  region->_blocks         = reinterpret_cast<TRI_df_compressed_block_t const*>(region->_compressed + sizeof(TRI_df_compressed_header_t));
+  region->_size           = header->_size;
+  region->_blockSize      = header->_blockSize;
+  region->_numberBlocks   = header->_numberBlocks;
+  region->_slot           = slot;
+  region->_states         = new std::atomic<uint8_t>[header->_numberBlocks];
+  region->_resident       = 0;
+
+  for (uint32_t i = 0;  i < header->_numberBlocks;  ++i) {
+    region->_states[i] = BlockAbsent;
+  }
+
+  // a cache entry with generation 0 would be indistinguishable from an
+  // unused entry for the first block in slot 0
+  if (++LastGeneration == 0) {
+    ++LastGeneration;
+  }
+
+  region->_generation = LastGeneration;
+
+  Regions[slot].store(region);
+
+  if (RegionsUsed.load() <= slot) {
+    RegionsUsed.store(slot + 1);
+  }
+
+  return region;
+#else
+  return nullptr;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the start of the uncompressed data of a range
+////////////////////////////////////////////////////////////////////////////////
+
+char* TRI_DataCompressedRegion (TRI_df_compressed_region_s const* region) {
+  return region->_data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the size of the blocks of a range that are decompressed
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TRI_ResidentSizeCompressedRegion (TRI_df_compressed_region_s const* region) {
+  return region->_resident.load() * region->_blockSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief releases the address range and the compressed file mapping
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_FreeCompressedRegion (TRI_df_compressed_region_s* region) {
+#ifdef __linux__
+  {
+    MUTEX_LOCKER(RegionsLock);
+
+    Regions[region->_slot].store(nullptr);
+
+    // cache entries of the region are ignored from now on, as its slot is
+    // empty or used by a region of another generation
+    WaitForFaultHandlers();
+  }
+
+  munmap(region->_data, region->_reservedSize);
+  munmap(const_cast<char*>(region->_compressed), region->_compressedSize);
+
+  delete[] region->_states;
+  delete region;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
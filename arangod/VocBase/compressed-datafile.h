@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief on-demand decompression of compressed datafiles
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Dr. Frank Celler
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2011-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARANGODB_VOC_BASE_COMPRESSED__DATAFILE_H
+#define ARANGODB_VOC_BASE_COMPRESSED__DATAFILE_H 1
+
+#include "Basics/Common.h"
+
+#include "VocBase/datafile.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// @page CompressedDatafiles Compressed datafiles
+///
+/// The data of a compressed datafile is not decompressed when the datafile is
+/// opened. Instead, an address range of the size of the uncompressed datafile
+/// is reserved without access rights. The first access to a block of the
+/// range raises a segmentation fault, which is handled by decompressing the
+/// block from the memory-mapped compressed file, using its entry in the block
+/// index, and making it readable. The data of a datafile is thus always at
+/// the same address, and master pointers and other raw pointers into it stay
+/// valid.
+///
+/// Decompressed blocks are kept in a cache shared by all compressed
+/// datafiles, whose size is bounded by --database.compressed-cache-size. If
+/// the cache is full, the block that was decompressed first is made
+/// inaccessible again, and its memory is returned to the operating system. A
+/// later access to it decompresses it again. Blocks can thus be evicted while
+/// they are in use, and readers need not pin them.
+///
+/// The range and the compressed file are released when the datafile is
+/// closed. Datafiles are only closed when no reader can use them anymore,
+/// which the ditches of the collection guarantee.
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                      public types
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief address range of a compressed datafile with on-demand decompression
+////////////////////////////////////////////////////////////////////////////////
+
+struct TRI_df_compressed_region_s;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sets the maximal size of the decompressed blocks in memory
+///
+/// only has an effect before the first compressed datafile is opened
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_SetCacheSizeCompressedDatafiles (uint64_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief creates the address range for a compressed datafile
+///
+/// the compressed file must be memory-mapped, and its header and block index
+/// must have been validated. the range takes over the mapping of the
+/// compressed file. returns nullptr if blocks cannot be decompressed on
+/// demand on this platform or for this file, in which case the caller must
+/// decompress the datafile completely
+////////////////////////////////////////////////////////////////////////////////
+
+struct TRI_df_compressed_region_s* TRI_CreateCompressedRegion (char const*,
+                                                               void*,
+                                                               size_t,
+                                                               TRI_df_compressed_header_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the start of the uncompressed data of a range
+////////////////////////////////////////////////////////////////////////////////
+
+char* TRI_DataCompressedRegion (struct TRI_df_compressed_region_s const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the size of the blocks of a range that are decompressed
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TRI_ResidentSizeCompressedRegion (struct TRI_df_compressed_region_s const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief releases the address range and the compressed file mapping
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_FreeCompressedRegion (struct TRI_df_compressed_region_s*);
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
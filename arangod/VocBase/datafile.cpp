@@ -39,8 +39,11 @@
 #include "Basics/memory-map.h"
 #include "Basics/tri-strings.h"
 #include "Basics/files.h"
+#include "VocBase/compressed-datafile.h"
 #include "VocBase/server.h"
 
+#include "zlib.h"
+
 
 // #define DEBUG_DATAFILE 1
 
@@ -134,11 +137,20 @@ static int TruncateDatafile (TRI_datafile_t* const datafile, const off_t length)
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not a datafile version is known
+////////////////////////////////////////////////////////////////////////////////
+
+static bool IsKnownVersion (TRI_df_version_t version) {
+  return (version == TRI_DF_VERSION_CRC32 || version == TRI_DF_VERSION_CRC32C);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief calculates the actual CRC of a marker, without bounds checks
 ////////////////////////////////////////////////////////////////////////////////
 
-static TRI_voc_crc_t CalculateCrcValue (TRI_df_marker_t const* marker) {
+static TRI_voc_crc_t CalculateCrcValue (TRI_df_version_t version,
+                                        TRI_df_marker_t const* marker) {
   TRI_voc_size_t zero = 0;
   off_t o = offsetof(TRI_df_marker_t, _crc);
   size_t n = sizeof(TRI_voc_crc_t);
@@ -147,9 +159,16 @@ static TRI_voc_crc_t CalculateCrcValue (TRI_df_marker_t const* marker) {
 
   TRI_voc_crc_t crc = TRI_InitialCrc32();
 
-  crc = TRI_BlockCrc32(crc, ptr, o);
-  crc = TRI_BlockCrc32(crc, (char*) &zero, n);
-  crc = TRI_BlockCrc32(crc, ptr + o + n, marker->_size - o - n);
+  if (version == TRI_DF_VERSION_CRC32) {
+    crc = TRI_BlockCrc32(crc, ptr, o);
+    crc = TRI_BlockCrc32(crc, (char*) &zero, n);
+    crc = TRI_BlockCrc32(crc, ptr + o + n, marker->_size - o - n);
+  }
+  else {
+    crc = TRI_BlockCrc32C(crc, ptr, o);
+    crc = TRI_BlockCrc32C(crc, (char*) &zero, n);
+    crc = TRI_BlockCrc32C(crc, ptr + o + n, marker->_size - o - n);
+  }
 
   crc = TRI_FinalCrc32(crc);
 
@@ -160,7 +179,8 @@ static TRI_voc_crc_t CalculateCrcValue (TRI_df_marker_t const* marker) {
 /// @brief diagnoses a marker
 ////////////////////////////////////////////////////////////////////////////////
 
-static std::string DiagnoseMarker (TRI_df_marker_t const* marker,
+static std::string DiagnoseMarker (TRI_df_version_t version,
+                                   TRI_df_marker_t const* marker,
                                    char const* end) {
   std::ostringstream result;
 
@@ -200,7 +220,7 @@ static std::string DiagnoseMarker (TRI_df_marker_t const* marker,
     return result.str();
   }
 
-  TRI_voc_crc_t crc = CalculateCrcValue(marker);
+  TRI_voc_crc_t crc = CalculateCrcValue(version, marker);
     
   if (marker->_crc == crc) {
     result << "crc checksum is correct";
@@ -216,7 +236,8 @@ static std::string DiagnoseMarker (TRI_df_marker_t const* marker,
 /// @brief checks a CRC of a marker, with bounds checks
 ////////////////////////////////////////////////////////////////////////////////
 
-static bool CheckCrcMarker (TRI_df_marker_t const* marker,
+static bool CheckCrcMarker (TRI_df_version_t version,
+                            TRI_df_marker_t const* marker,
                             char const* end) {
   if (marker->_size < sizeof(TRI_df_marker_t)) {
     return false;
@@ -226,7 +247,7 @@ static bool CheckCrcMarker (TRI_df_marker_t const* marker,
     return false;
   }
 
-  auto expected = CalculateCrcValue(marker);
+  auto expected = CalculateCrcValue(version, marker);
   return marker->_crc == expected;
 }
 
@@ -313,6 +334,7 @@ static void InitDatafile (TRI_datafile_t* datafile,
 
   datafile->_state       = TRI_DF_STATE_READ;
   datafile->_fid         = fid;
+  datafile->_version     = TRI_DF_VERSION;
 
   datafile->_filename    = filename;
   datafile->_fd          = fd;
@@ -323,6 +345,8 @@ static void InitDatafile (TRI_datafile_t* datafile,
   datafile->_footerSize  = sizeof(TRI_df_footer_marker_t);
 
   datafile->_isSealed    = false;
+  datafile->_isCompressed = false;
+  datafile->_compressedRegion = nullptr;
   datafile->_lastError   = TRI_ERROR_NO_ERROR;
 
   datafile->_full        = false;
@@ -348,6 +372,21 @@ static void InitDatafile (TRI_datafile_t* datafile,
   datafile->truncate     = &TruncateDatafile;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief unmaps the memory of a datafile
+////////////////////////////////////////////////////////////////////////////////
+
+static int UnmapDatafile (TRI_datafile_t* datafile) {
+  if (datafile->_compressedRegion != nullptr) {
+    TRI_FreeCompressedRegion(datafile->_compressedRegion);
+    datafile->_compressedRegion = nullptr;
+
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  return TRI_UNMMFile(datafile->_data, datafile->_maximalSize, datafile->_fd, &datafile->_mmHandle);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief truncates a datafile
 ///
@@ -572,7 +611,7 @@ static TRI_df_scan_t ScanDatafile (TRI_datafile_t const* datafile) {
     if (marker->_size < sizeof(TRI_df_marker_t)) {
       entry._status = 4;
 
-      auto&& diagnosis = DiagnoseMarker(marker, end);
+      auto&& diagnosis = DiagnoseMarker(datafile->_version, marker, end);
       entry._diagnosis = TRI_DuplicateString2Z(TRI_UNKNOWN_MEM_ZONE, diagnosis.c_str(), diagnosis.size());
 
       scan._endPosition = currentSize;
@@ -585,7 +624,7 @@ static TRI_df_scan_t ScanDatafile (TRI_datafile_t const* datafile) {
     if (! TRI_IsValidMarkerDatafile(marker)) {
       entry._status = 4;
 
-      auto&& diagnosis = DiagnoseMarker(marker, end);
+      auto&& diagnosis = DiagnoseMarker(datafile->_version, marker, end);
       entry._diagnosis = TRI_DuplicateString2Z(TRI_UNKNOWN_MEM_ZONE, diagnosis.c_str(), diagnosis.size());
 
       scan._endPosition = currentSize;
@@ -595,12 +634,12 @@ static TRI_df_scan_t ScanDatafile (TRI_datafile_t const* datafile) {
       return scan;
     }
 
-    ok = CheckCrcMarker(marker, end);
+    ok = CheckCrcMarker(datafile->_version, marker, end);
 
     if (! ok) {
       entry._status = 5;
       
-      auto&& diagnosis = DiagnoseMarker(marker, end);
+      auto&& diagnosis = DiagnoseMarker(datafile->_version, marker, end);
       entry._diagnosis = TRI_DuplicateString2Z(TRI_UNKNOWN_MEM_ZONE, diagnosis.c_str(), diagnosis.size());
       
       scan._status = 4;
@@ -660,7 +699,7 @@ static bool TryRepairDatafile (TRI_datafile_t* datafile) {
     }
 
     if (marker->_type != 0) {
-      if (! CheckCrcMarker(marker, end)) {
+      if (! CheckCrcMarker(datafile->_version, marker, end)) {
         // CRC mismatch!
         auto next = reinterpret_cast<char const*>(marker) + marker->_size;
         auto p = next;
@@ -696,7 +735,7 @@ static bool TryRepairDatafile (TRI_datafile_t* datafile) {
                 nextMarker->_size >= sizeof(TRI_df_marker_t) &&
                 next + nextMarker->_size <= end &&
                 TRI_IsValidMarkerDatafile(nextMarker) &&
-                CheckCrcMarker(nextMarker, end)) {
+                CheckCrcMarker(datafile->_version, nextMarker, end)) {
               // next marker looks good.
 
               // create a temporary buffer
@@ -709,7 +748,7 @@ static bool TryRepairDatafile (TRI_datafile_t* datafile) {
               // create a new marker in the temporary buffer
               auto temp = reinterpret_cast<TRI_df_marker_t*>(buffer);
               TRI_InitMarkerDatafile(static_cast<char*>(buffer), TRI_DF_MARKER_BLANK, static_cast<TRI_voc_size_t>(marker->_size));
-              temp->_crc = CalculateCrcValue(temp);
+              temp->_crc = CalculateCrcValue(datafile->_version, temp);
 
               // all done. now copy back the marker into the file
               memcpy(static_cast<void*>(ptr), buffer, static_cast<size_t>(marker->_size));
@@ -901,7 +940,7 @@ static bool CheckDatafile (TRI_datafile_t* datafile,
     }
 
     if (marker->_type != 0) {
-      bool ok = CheckCrcMarker(marker, end);
+      bool ok = CheckCrcMarker(datafile->_version, marker, end);
 
       if (! ok) {
         // CRC mismatch!
@@ -939,7 +978,7 @@ static bool CheckDatafile (TRI_datafile_t* datafile,
                     nextMarker->_size >= sizeof(TRI_df_marker_t) &&
                     next + nextMarker->_size <= end &&
                     TRI_IsValidMarkerDatafile(nextMarker) &&
-                    CheckCrcMarker(nextMarker, end)) {
+                    CheckCrcMarker(datafile->_version, nextMarker, end)) {
                   // next marker looks good.
                   nextMarkerOk = true;
                 }
@@ -964,7 +1003,7 @@ static bool CheckDatafile (TRI_datafile_t* datafile,
           LOG_WARNING("crc mismatch found in datafile '%s' at position %lu. expected crc: %x, actual crc: %x", 
                       datafile->getName(datafile),
                       (unsigned long) currentSize,
-                      CalculateCrcValue(marker),
+                      CalculateCrcValue(datafile->_version, marker),
                       marker->_crc);
           
           if (nextMarkerOk) {
@@ -1058,6 +1097,281 @@ static int WriteInitialHeaderMarker (TRI_datafile_t* datafile,
   return res;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculates the checksum of a compressed datafile header and its
+/// block entries
+////////////////////////////////////////////////////////////////////////////////
+
+static TRI_voc_crc_t CalculateCrcCompressedHeader (TRI_df_compressed_header_t const* header,
+                                                   TRI_df_compressed_block_t const* blocks) {
+  TRI_df_compressed_header_t copy;
+  memcpy(&copy, header, sizeof(TRI_df_compressed_header_t));
+  copy._crc = 0;
+
+  TRI_voc_crc_t crc = TRI_InitialCrc32();
+  crc = TRI_BlockCrc32C(crc, reinterpret_cast<char const*>(&copy), sizeof(TRI_df_compressed_header_t));
+  crc = TRI_BlockCrc32C(crc, reinterpret_cast<char const*>(blocks), header->_numberBlocks * sizeof(TRI_df_compressed_block_t));
+
+  return TRI_FinalCrc32(crc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the start of a file is a compressed datafile header
+////////////////////////////////////////////////////////////////////////////////
+
+static bool IsCompressedDatafile (void const* data) {
+  return memcmp(data, TRI_DF_COMPRESSED_MAGIC, sizeof(TRI_DF_COMPRESSED_MAGIC)) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief checks the block index and the blocks of a compressed datafile
+////////////////////////////////////////////////////////////////////////////////
+
+static bool CheckCompressedBlocks (char const* filename,
+                                   char const* compressed,
+                                   TRI_voc_size_t size,
+                                   TRI_df_compressed_header_t const* header) {
+  TRI_df_compressed_block_t const* blocks = reinterpret_cast<TRI_df_compressed_block_t const*>(compressed + sizeof(TRI_df_compressed_header_t));
+
+  for (uint32_t i = 0; i < header->_numberBlocks; ++i) {
+    TRI_df_compressed_block_t const* block = &blocks[i];
+
+    uint64_t const start = static_cast<uint64_t>(i) * header->_blockSize;
+    uint64_t const length = (std::min)(static_cast<uint64_t>(header->_blockSize), header->_size - start);
+
+    if (block->_offset + block->_size > size || block->_size > length) {
+      LOG_ERROR("block %u of compressed datafile '%s' is out of bounds", (unsigned int) i, filename);
+      return false;
+    }
+
+    TRI_voc_crc_t const crc = TRI_FinalCrc32(TRI_BlockCrc32C(TRI_InitialCrc32(), compressed + block->_offset, block->_size));
+
+    if (crc != block->_crc) {
+      LOG_ERROR("crc mismatch in block %u of compressed datafile '%s'", (unsigned int) i, filename);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief decompresses the blocks of a compressed datafile into memory
+///
+/// the blocks must have been checked before
+////////////////////////////////////////////////////////////////////////////////
+
+static bool DecompressDatafile (char const* filename,
+                                char const* compressed,
+                                TRI_df_compressed_header_t const* header,
+                                char* data) {
+  TRI_df_compressed_block_t const* blocks = reinterpret_cast<TRI_df_compressed_block_t const*>(compressed + sizeof(TRI_df_compressed_header_t));
+
+  for (uint32_t i = 0; i < header->_numberBlocks; ++i) {
+    TRI_df_compressed_block_t const* block = &blocks[i];
+
+    uint64_t const start = static_cast<uint64_t>(i) * header->_blockSize;
+    uint64_t const length = (std::min)(static_cast<uint64_t>(header->_blockSize), header->_size - start);
+    char const* src = compressed + block->_offset;
+
+    if (block->_size == length) {
+      // block is stored uncompressed
+      memcpy(data + start, src, block->_size);
+      continue;
+    }
+
+    uLongf decompressedLength = static_cast<uLongf>(length);
+
+    if (uncompress(reinterpret_cast<Bytef*>(data + start),
+                   &decompressedLength,
+                   reinterpret_cast<Bytef const*>(src),
+                   static_cast<uLong>(block->_size)) != Z_OK ||
+        decompressedLength != length) {
+      LOG_ERROR("cannot decompress block %u of compressed datafile '%s'", (unsigned int) i, filename);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief opens a compressed datafile
+///
+/// the blocks of the datafile are decompressed on access, see
+/// @ref CompressedDatafiles. the mapping of the compressed file is kept for
+/// as long as the datafile is open. if blocks cannot be decompressed on
+/// access, the datafile is decompressed completely into anonymous memory.
+/// the file descriptor of the compressed file is kept open
+////////////////////////////////////////////////////////////////////////////////
+
+static TRI_datafile_t* OpenCompressedDatafile (char const* filename,
+                                               int fd,
+                                               TRI_voc_size_t size,
+                                               TRI_voc_fid_t fid) {
+#if defined(TRI_HAVE_ANONYMOUS_MMAP) && defined(TRI_MMAP_ANONYMOUS)
+  void* compressed;
+  void* compressedHandle;
+
+  if (size < sizeof(TRI_df_compressed_header_t)) {
+    TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
+    TRI_CLOSE(fd);
+
+    LOG_ERROR("compressed datafile '%s' is corrupt, size is only %u", filename, (unsigned int) size);
+    return nullptr;
+  }
+
+  int res = TRI_MMFile(0, size, PROT_READ, MAP_SHARED, fd, &compressedHandle, 0, &compressed);
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    TRI_set_errno(res);
+    TRI_CLOSE(fd);
+
+    LOG_ERROR("cannot memory map compressed datafile '%s': %s", filename, TRI_errno_string(res));
+    return nullptr;
+  }
+
+  char const* base = static_cast<char const*>(compressed);
+  TRI_df_compressed_header_t header;
+  memcpy(&header, base, sizeof(TRI_df_compressed_header_t));
+
+  bool ok = (header._version == TRI_DF_COMPRESSED_VERSION &&
+             header._blockSize > 0 &&
+             header._size >= sizeof(TRI_df_header_marker_t) + sizeof(TRI_df_footer_marker_t) &&
+             header._size <= static_cast<uint64_t>(UINT32_MAX) &&
+             header._numberBlocks == (header._size + header._blockSize - 1) / header._blockSize &&
+             sizeof(TRI_df_compressed_header_t) + static_cast<uint64_t>(header._numberBlocks) * sizeof(TRI_df_compressed_block_t) <= size);
+
+  if (ok) {
+    auto blocks = reinterpret_cast<TRI_df_compressed_block_t const*>(base + sizeof(TRI_df_compressed_header_t));
+    ok = (CalculateCrcCompressedHeader(&header, blocks) == header._crc);
+  }
+
+  if (! ok) {
+    TRI_UNMMFile(compressed, size, fd, &compressedHandle);
+    TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
+    TRI_CLOSE(fd);
+
+    LOG_ERROR("corrupted header in compressed datafile '%s'", filename);
+    return nullptr;
+  }
+
+  // the blocks are checked once here, so decompressing them on access cannot
+  // fail for a damaged file
+  TRI_MMFileAdvise(compressed, size, TRI_MADVISE_SEQUENTIAL);
+
+  if (! CheckCompressedBlocks(filename, base, size, &header)) {
+    TRI_UNMMFile(compressed, size, fd, &compressedHandle);
+    TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
+    TRI_CLOSE(fd);
+
+    LOG_ERROR("corrupted data in compressed datafile '%s'", filename);
+    return nullptr;
+  }
+
+  TRI_MMFileAdvise(compressed, size, TRI_MADVISE_RANDOM);
+
+  TRI_voc_size_t const dataSize = static_cast<TRI_voc_size_t>(header._size);
+  TRI_df_compressed_region_s* region = TRI_CreateCompressedRegion(filename, compressed, size, &header);
+  void* data;
+  void* mmHandle = nullptr;
+
+  if (region != nullptr) {
+    // the region owns the mapping of the compressed file now
+    data = TRI_DataCompressedRegion(region);
+  }
+  else {
+    res = TRI_MMFile(nullptr, dataSize, PROT_READ | PROT_WRITE, TRI_MMAP_ANONYMOUS | MAP_PRIVATE, -1, &mmHandle, 0, &data);
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      TRI_UNMMFile(compressed, size, fd, &compressedHandle);
+      TRI_set_errno(res);
+      TRI_CLOSE(fd);
+
+      LOG_ERROR("cannot allocate memory for compressed datafile '%s': %s", filename, TRI_errno_string(res));
+      return nullptr;
+    }
+
+    // the decompressed data is not backed by a file, so it can use huge pages
+    TRI_MMFileAdvise(data, dataSize, TRI_MADVISE_HUGEPAGE);
+
+    ok = DecompressDatafile(filename, base, &header, static_cast<char*>(data));
+
+    TRI_UNMMFile(compressed, size, fd, &compressedHandle);
+  }
+
+  // the decompressed data must start with a valid datafile header
+  TRI_df_header_marker_t const* marker = static_cast<TRI_df_header_marker_t const*>(data);
+
+  if (ok) {
+    ok = (marker->base._type == TRI_DF_MARKER_HEADER &&
+          marker->base._size == sizeof(TRI_df_header_marker_t) &&
+          IsKnownVersion(marker->_version) &&
+          CheckCrcMarker(marker->_version, &marker->base, static_cast<char const*>(data) + dataSize));
+  }
+
+  if (! ok) {
+    if (region != nullptr) {
+      TRI_FreeCompressedRegion(region);
+    }
+    else {
+      TRI_UNMMFile(data, dataSize, -1, &mmHandle);
+    }
+    TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
+    TRI_CLOSE(fd);
+
+    LOG_ERROR("corrupted data in compressed datafile '%s'", filename);
+    return nullptr;
+  }
+
+  if (region == nullptr) {
+    // compressed datafiles are always sealed
+    TRI_ProtectMMFile(data, dataSize, PROT_READ, -1, &mmHandle);
+  }
+
+  TRI_datafile_t* datafile = static_cast<TRI_datafile_t*>(TRI_Allocate(TRI_UNKNOWN_MEM_ZONE, sizeof(TRI_datafile_t), false));
+
+  if (datafile == nullptr) {
+    if (region != nullptr) {
+      TRI_FreeCompressedRegion(region);
+    }
+    else {
+      TRI_UNMMFile(data, dataSize, -1, &mmHandle);
+    }
+    TRI_CLOSE(fd);
+
+    return nullptr;
+  }
+
+  InitDatafile(datafile,
+               TRI_DuplicateString(filename),
+               fd,
+               mmHandle,
+               dataSize,
+               dataSize,
+               fid,
+               static_cast<char*>(data));
+
+  datafile->_version = marker->_version;
+  datafile->_isCompressed = true;
+  datafile->_compressedRegion = region;
+
+  LOG_TRACE("opened compressed datafile '%s' with %llu bytes, %llu bytes uncompressed, %s",
+            filename,
+            (unsigned long long) size,
+            (unsigned long long) dataSize,
+            (region != nullptr ? "decompressed on access" : "decompressed completely"));
+
+  return datafile;
+#else
+  TRI_set_errno(TRI_ERROR_NOT_IMPLEMENTED);
+  TRI_CLOSE(fd);
+
+  LOG_ERROR("cannot open compressed datafile '%s': not supported on this platform", filename);
+  return nullptr;
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief opens a datafile
 ////////////////////////////////////////////////////////////////////////////////
@@ -1134,11 +1448,17 @@ static TRI_datafile_t* OpenDatafile (char const* filename,
     TRI_CLOSE(fd);
     return nullptr;
   }
+
+  if (IsCompressedDatafile(ptr)) {
+    return OpenCompressedDatafile(filename, fd, size, fid);
+  }
   
   char const* end = static_cast<char const*>(ptr) + len;
 
-  // check CRC
-  ok = CheckCrcMarker(&header.base, end);
+  // check CRC. the datafile version determines the checksum algorithm, an
+  // unknown version is reported below
+  ok = ! IsKnownVersion(header._version) ||
+       CheckCrcMarker(header._version, &header.base, end);
 
   if (! ok) {
     TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
@@ -1153,7 +1473,7 @@ static TRI_datafile_t* OpenDatafile (char const* filename,
 
   // check the datafile version
   if (ok) {
-    if (header._version != TRI_DF_VERSION) {
+    if (! IsKnownVersion(header._version)) {
       TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
 
       LOG_ERROR("unknown datafile version '%u' in datafile '%s'",
@@ -1205,6 +1525,11 @@ static TRI_datafile_t* OpenDatafile (char const* filename,
                fid,
                static_cast<char*>(data));
 
+  // existing datafiles keep the checksum algorithm they were created with
+  if (IsKnownVersion(header._version)) {
+    datafile->_version = header._version;
+  }
+
   return datafile;
 }
 
@@ -1796,6 +2121,15 @@ void TRI_UpdateTicksDatafile (TRI_datafile_t* datafile,
   */
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculates the CRC value of a marker for a datafile version
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_voc_crc_t TRI_CalculateCrcMarkerDatafile (TRI_df_version_t version,
+                                              TRI_df_marker_t const* marker) {
+  return CalculateCrcValue(version, marker);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief checksums and writes a marker to the datafile
 ////////////////////////////////////////////////////////////////////////////////
@@ -1807,10 +2141,7 @@ int TRI_WriteCrcElementDatafile (TRI_datafile_t* datafile,
   TRI_ASSERT(marker->_tick != 0);
 
   if (datafile->isPhysical(datafile)) {
-    TRI_voc_crc_t crc = TRI_InitialCrc32();
-
-    crc = TRI_BlockCrc32(crc, (char const*) marker, marker->_size);
-    marker->_crc = TRI_FinalCrc32(crc);
+    marker->_crc = CalculateCrcValue(datafile->_version, marker);
   }
 
   return TRI_WriteElementDatafile(datafile, position, marker, forceSync);
@@ -1824,13 +2155,27 @@ int TRI_WriteCrcElementDatafile (TRI_datafile_t* datafile,
 bool TRI_IterateDatafile (TRI_datafile_t* datafile,
                           bool (*iterator)(TRI_df_marker_t const*, void*, TRI_datafile_t*),
                           void* data) {
+  return TRI_IterateDatafileFrom(datafile, 0, iterator, data);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief iterates over a datafile, starting at the given offset
+/// the offset must be the (aligned) start position of a marker
+////////////////////////////////////////////////////////////////////////////////
+
+bool TRI_IterateDatafileFrom (TRI_datafile_t* datafile,
+                              TRI_voc_size_t offset,
+                              bool (*iterator)(TRI_df_marker_t const*, void*, TRI_datafile_t*),
+                              void* data) {
   TRI_ASSERT(iterator != nullptr);
+  TRI_ASSERT(offset == TRI_DF_ALIGN_BLOCK(offset));
 
-  LOG_TRACE("iterating over datafile '%s', fid: %llu",
+  LOG_TRACE("iterating over datafile '%s', fid: %llu, offset: %llu",
             datafile->getName(datafile),
-            (unsigned long long) datafile->_fid);
+            (unsigned long long) datafile->_fid,
+            (unsigned long long) offset);
 
-  char const* ptr = datafile->_data;
+  char const* ptr = datafile->_data + offset;
   char const* end = datafile->_data + datafile->_currentSize;
 
   if (datafile->_state != TRI_DF_STATE_READ && datafile->_state != TRI_DF_STATE_WRITE) {
@@ -1838,25 +2183,96 @@ bool TRI_IterateDatafile (TRI_datafile_t* datafile,
     return false;
   }
 
+  // the markers are read in order, so let the kernel read ahead
+  TRI_AdviseDatafile(datafile, TRI_MADVISE_SEQUENTIAL);
+
+  bool result = true;
+
   while (ptr < end) {
     TRI_df_marker_t const* marker = reinterpret_cast<TRI_df_marker_t const*>(ptr);
 
     if (marker->_size == 0) {
-      return true;
+      break;
     }
 
     // update the tick statistics
     TRI_UpdateTicksDatafile(datafile, marker);
 
     if (! iterator(marker, data, datafile)) {
-      return false;
+      result = false;
+      break;
     }
 
     size_t size = TRI_DF_ALIGN_BLOCK(marker->_size);
     ptr += size;
   }
 
-  return true;
+  TRI_ResetAdviceDatafile(datafile);
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief gives the kernel a hint how the datafile will be accessed
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_AdviseDatafile (TRI_datafile_t* datafile,
+                         int advice) {
+  if (datafile->_data == nullptr || datafile->_maximalSize == 0) {
+    return;
+  }
+
+  if (datafile->_compressedRegion != nullptr) {
+    // blocks of compressed datafiles are decompressed and evicted on demand
+    return;
+  }
+
+  if (advice == TRI_MADVISE_DONTNEED &&
+      (! datafile->isPhysical(datafile) || datafile->_isCompressed)) {
+    // the memory of in-memory and decompressed datafiles is not backed by
+    // the file, so dropping it would lose data
+    return;
+  }
+
+  TRI_MMFileAdvise(datafile->_data, datafile->_maximalSize, advice);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief restores the access pattern hint for the state of a datafile
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_ResetAdviceDatafile (TRI_datafile_t* datafile) {
+  if (datafile->_isSealed) {
+    TRI_AdviseDatafile(datafile, TRI_MADVISE_RANDOM);
+  }
+  else {
+    TRI_AdviseDatafile(datafile, TRI_MADVISE_NORMAL);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief loads all pages of the datafile into memory
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_PrefaultDatafile (TRI_datafile_t* datafile) {
+  if (datafile->_data == nullptr || datafile->_currentSize == 0) {
+    return;
+  }
+
+  if (datafile->_compressedRegion != nullptr) {
+    // the blocks are decompressed on access only, which keeps the
+    // decompressed data within the cache size
+    return;
+  }
+
+  // only the used part of the datafile needs to be loaded
+  size_t const size = ((static_cast<size_t>(datafile->_currentSize) + PageSize - 1) / PageSize) * PageSize;
+  size_t const length = (std::min)(size, static_cast<size_t>(datafile->_maximalSize));
+
+  if (TRI_MMFileAdvise(datafile->_data, length, TRI_MADVISE_POPULATE) != TRI_ERROR_NO_ERROR) {
+    // populating is not supported by the kernel, start readahead instead
+    TRI_MMFileAdvise(datafile->_data, length, TRI_MADVISE_WILLNEED);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1877,10 +2293,17 @@ TRI_datafile_t* TRI_OpenDatafile (char const* filename,
   }
 
   // check the datafile by scanning markers
+  TRI_AdviseDatafile(datafile, TRI_MADVISE_SEQUENTIAL);
   bool ok = CheckDatafile(datafile, ignoreFailures);
 
+  // compressed datafiles are only written for sealed datafiles
+  if (ok && datafile->_isCompressed && ! datafile->_isSealed) {
+    TRI_set_errno(TRI_ERROR_ARANGO_CORRUPTED_DATAFILE);
+    ok = false;
+  }
+
   if (! ok) {
-    TRI_UNMMFile(datafile->_data, datafile->_maximalSize, datafile->_fd, &datafile->_mmHandle);
+    UnmapDatafile(datafile);
     TRI_CLOSE(datafile->_fd);
 
     LOG_ERROR("datafile '%s' is corrupt", datafile->getName(datafile));
@@ -1896,6 +2319,8 @@ TRI_datafile_t* TRI_OpenDatafile (char const* filename,
     TRI_ProtectMMFile(datafile->_data, datafile->_maximalSize, PROT_READ | PROT_WRITE, datafile->_fd, &datafile->_mmHandle);
   }
 
+  TRI_ResetAdviceDatafile(datafile);
+
   return datafile;
 }
 
@@ -1922,7 +2347,7 @@ TRI_datafile_t* TRI_ForcedOpenDatafile (char const* filename) {
 
   // change to read-write if no footer has been found
   else {
-    if (! datafile->_isSealed) {
+    if (! datafile->_isSealed && ! datafile->_isCompressed) {
       datafile->_state = TRI_DF_STATE_WRITE;
       TRI_ProtectMMFile(datafile->_data, datafile->_maximalSize, PROT_READ | PROT_WRITE, datafile->_fd, &datafile->_mmHandle);
     }
@@ -1939,7 +2364,7 @@ bool TRI_CloseDatafile (TRI_datafile_t* datafile) {
   if (datafile->_state == TRI_DF_STATE_READ || datafile->_state == TRI_DF_STATE_WRITE) {
     int res;
 
-    res = TRI_UNMMFile(datafile->_data, datafile->_maximalSize, datafile->_fd, &datafile->_mmHandle);
+    res = UnmapDatafile(datafile);
 
     if (res != TRI_ERROR_NO_ERROR) {
       LOG_ERROR("munmap failed with: %d", res);
@@ -2090,6 +2515,8 @@ int TRI_SealDatafile (TRI_datafile_t* datafile) {
     datafile->_isSealed = true;
     datafile->_state = TRI_DF_STATE_READ;
     datafile->_maximalSize = datafile->_currentSize;
+
+    TRI_ResetAdviceDatafile(datafile);
   }
 
   if (! ok) {
@@ -2099,6 +2526,129 @@ int TRI_SealDatafile (TRI_datafile_t* datafile) {
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief replaces the file of a sealed datafile with a compressed copy
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_CompressDatafile (TRI_datafile_t* datafile,
+                          char const* tempFilename) {
+  TRI_ASSERT(tempFilename != nullptr);
+
+  if (! datafile->isPhysical(datafile)) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  if (datafile->_isCompressed) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  if (! datafile->_isSealed || datafile->_state != TRI_DF_STATE_READ) {
+    return TRI_set_errno(TRI_ERROR_ARANGO_ILLEGAL_STATE);
+  }
+
+  uint64_t const size = datafile->_currentSize;
+  uint32_t const blockSize = TRI_DF_COMPRESSED_BLOCK_SIZE;
+  uint32_t const numberBlocks = static_cast<uint32_t>((size + blockSize - 1) / blockSize);
+
+  TRI_df_compressed_header_t header;
+  memset(&header, 0, sizeof(TRI_df_compressed_header_t));
+  memcpy(header._magic, TRI_DF_COMPRESSED_MAGIC, sizeof(TRI_DF_COMPRESSED_MAGIC));
+  header._version      = TRI_DF_COMPRESSED_VERSION;
+  header._fid          = datafile->_fid;
+  header._size         = size;
+  header._blockSize    = blockSize;
+  header._numberBlocks = numberBlocks;
+
+  std::vector<TRI_df_compressed_block_t> blocks(numberBlocks);
+  std::vector<Bytef> buffer(compressBound(blockSize));
+
+  if (TRI_ExistsFile(tempFilename)) {
+    // remove a leftover from a previous attempt
+    TRI_UnlinkFile(tempFilename);
+  }
+
+  int fd = TRI_CREATE(tempFilename, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+
+  if (fd < 0) {
+    LOG_ERROR("cannot create compressed datafile '%s': %s", tempFilename, TRI_last_error());
+    return TRI_set_errno(TRI_ERROR_SYS_ERROR);
+  }
+
+  // the header and the block entries are written last
+  uint64_t offset = sizeof(TRI_df_compressed_header_t) + numberBlocks * sizeof(TRI_df_compressed_block_t);
+  int res = TRI_ERROR_NO_ERROR;
+
+  if (TRI_LSEEK(fd, (TRI_lseek_t) offset, SEEK_SET) == (TRI_lseek_t) -1) {
+    res = TRI_set_errno(TRI_ERROR_SYS_ERROR);
+  }
+
+  char const* data = datafile->_data;
+
+  for (uint32_t i = 0; i < numberBlocks && res == TRI_ERROR_NO_ERROR; ++i) {
+    uint64_t const start = static_cast<uint64_t>(i) * blockSize;
+    uint32_t const length = static_cast<uint32_t>((std::min)(static_cast<uint64_t>(blockSize), size - start));
+
+    uLongf compressedLength = static_cast<uLongf>(buffer.size());
+    void const* src;
+
+    if (compress2(&buffer[0], &compressedLength, reinterpret_cast<Bytef const*>(data + start), static_cast<uLong>(length), Z_BEST_SPEED) == Z_OK &&
+        compressedLength < length) {
+      src = &buffer[0];
+    }
+    else {
+      // store blocks that do not shrink as they are
+      src = data + start;
+      compressedLength = length;
+    }
+
+    TRI_df_compressed_block_t& block = blocks[i];
+    block._offset = offset;
+    block._size   = static_cast<uint32_t>(compressedLength);
+    block._crc    = TRI_FinalCrc32(TRI_BlockCrc32C(TRI_InitialCrc32(), static_cast<char const*>(src), block._size));
+
+    if (! TRI_WritePointer(fd, src, block._size)) {
+      res = TRI_set_errno(TRI_ERROR_SYS_ERROR);
+    }
+
+    offset += block._size;
+  }
+
+  if (res == TRI_ERROR_NO_ERROR) {
+    header._crc = CalculateCrcCompressedHeader(&header, blocks.data());
+
+    if (TRI_LSEEK(fd, 0, SEEK_SET) == (TRI_lseek_t) -1 ||
+        ! TRI_WritePointer(fd, &header, sizeof(TRI_df_compressed_header_t)) ||
+        ! TRI_WritePointer(fd, blocks.data(), numberBlocks * sizeof(TRI_df_compressed_block_t)) ||
+        ! TRI_fsync(fd)) {
+      res = TRI_set_errno(TRI_ERROR_SYS_ERROR);
+    }
+  }
+
+  TRI_CLOSE(fd);
+
+  if (res == TRI_ERROR_NO_ERROR) {
+    // the datafile keeps its descriptor to the uncompressed file, so its
+    // memory stays valid after the rename
+    res = TRI_RenameFile(tempFilename, datafile->_filename);
+  }
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    LOG_ERROR("cannot compress datafile '%s': %s", datafile->getName(datafile), TRI_errno_string(res));
+    TRI_UnlinkFile(tempFilename);
+
+    return res;
+  }
+
+  datafile->_isCompressed = true;
+
+  LOG_DEBUG("compressed datafile '%s' from %llu to %llu bytes",
+            datafile->getName(datafile),
+            (unsigned long long) size,
+            (unsigned long long) offset);
+
+  return TRI_ERROR_NO_ERROR;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief truncates a datafile and seals it
 /// this is called from the recovery procedure only
@@ -2115,6 +2665,14 @@ int TRI_TruncateDatafile (char const* path,
     return TRI_ERROR_ARANGO_DATAFILE_UNREADABLE;
   }
 
+  if (datafile->_isCompressed) {
+    // compressed datafiles are sealed and cannot be modified in place
+    TRI_CloseDatafile(datafile);
+    TRI_FreeDatafile(datafile);
+
+    return TRI_ERROR_ARANGO_READ_ONLY;
+  }
+
   int res = TruncateAndSealDatafile(datafile, position);
   TRI_CloseDatafile(datafile);
   TRI_FreeDatafile(datafile);
@@ -2135,6 +2693,16 @@ bool TRI_TryRepairDatafile (char const* path) {
   if (datafile == nullptr) {
     return false;
   }
+
+  if (datafile->_isCompressed) {
+    // compressed datafiles cannot be repaired in place
+    LOG_ERROR("cannot repair compressed datafile '%s'", path);
+
+    TRI_CloseDatafile(datafile);
+    TRI_FreeDatafile(datafile);
+
+    return false;
+  }
      
   // set to read/write access 
   TRI_ProtectMMFile(datafile->_data, datafile->_maximalSize, PROT_READ | PROT_WRITE, datafile->_fd, &datafile->_mmHandle);
@@ -96,10 +96,24 @@
 // -----------------------------------------------------------------------------
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief datafile version
+/// @brief datafile version with markers checksummed using CRC32 (IEEE
+/// polynomial). this was used up to ArangoDB 2.5
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRI_DF_VERSION_CRC32    (1)
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief datafile version with markers checksummed using CRC32C (Castagnoli
+/// polynomial), which can be calculated by the CPU
 ////////////////////////////////////////////////////////////////////////////////
 
-#define TRI_DF_VERSION          (1)
+#define TRI_DF_VERSION_CRC32C   (2)
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief datafile version used for new datafiles
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRI_DF_VERSION          TRI_DF_VERSION_CRC32C
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief alignment in datafile blocks
@@ -113,6 +127,24 @@
 
 #define TRI_MARKER_MAXIMAL_SIZE (256 * 1024 * 1024)
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief magic bytes at the start of a compressed datafile
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRI_DF_COMPRESSED_MAGIC "ARANGO-DFZ"
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief version of the compressed datafile format
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRI_DF_COMPRESSED_VERSION (1)
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief uncompressed size of a block in a compressed datafile
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRI_DF_COMPRESSED_BLOCK_SIZE (64 * 1024)
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                      public types
 // -----------------------------------------------------------------------------
@@ -253,8 +285,11 @@ TRI_df_scan_entry_t;
 /// @brief datafile
 ////////////////////////////////////////////////////////////////////////////////
 
+struct TRI_df_compressed_region_s;
+
 typedef struct TRI_datafile_s {
   TRI_voc_fid_t _fid;            // datafile identifier
+  TRI_df_version_t _version;     // datafile version, determines the checksum algorithm
 
   TRI_df_state_e _state;         // state of the datafile (READ or WRITE)
   int _fd;                       // underlying file descriptor
@@ -286,6 +321,9 @@ typedef struct TRI_datafile_s {
   int _lastError;                // last (critical) error
   bool _full;                    // at least one request was rejected because there is not enough room
   bool _isSealed;                // true, if footer has been written
+  bool _isCompressed;            // true, if the file on disk is stored compressed
+
+  struct TRI_df_compressed_region_s* _compressedRegion; // decompresses on access, if opened compressed
 
   // .............................................................................
   // access to the following attributes must be protected by a _lock
@@ -296,6 +334,39 @@ typedef struct TRI_datafile_s {
 }
 TRI_datafile_t;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief header of a compressed datafile
+///
+/// A sealed datafile can be stored compressed. The file then starts with this
+/// header, followed by one @ref TRI_df_compressed_block_t entry per block, and
+/// the compressed blocks. Each block contains TRI_DF_COMPRESSED_BLOCK_SIZE
+/// bytes of the uncompressed datafile, except for the last one. A block is
+/// stored as is if it does not get smaller by compression. The checksum
+/// covers the header (with a checksum of 0) and the block entries.
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct TRI_df_compressed_header_s {
+  char _magic[16];                      // 16 bytes
+  uint32_t _version;                    //  4 bytes
+  TRI_voc_crc_t _crc;                   //  4 bytes
+  TRI_voc_fid_t _fid;                   //  8 bytes
+  uint64_t _size;                       //  8 bytes
+  uint32_t _blockSize;                  //  4 bytes
+  uint32_t _numberBlocks;               //  4 bytes
+}
+TRI_df_compressed_header_t;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief block entry of a compressed datafile
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct TRI_df_compressed_block_s {
+  uint64_t _offset;                     //  8 bytes, position in the file
+  uint32_t _size;                       //  4 bytes, stored size
+  TRI_voc_crc_t _crc;                   //  4 bytes, checksum of stored data
+}
+TRI_df_compressed_block_t;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief datafile marker
 ///
@@ -681,6 +752,15 @@ int TRI_WriteElementDatafile (TRI_datafile_t* datafile,
                               TRI_df_marker_t const* marker,
                               bool sync) TRI_WARN_UNUSED_RESULT;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calculates the CRC value of a marker for a datafile version
+///
+/// the marker's _crc attribute is treated as if it were 0
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_voc_crc_t TRI_CalculateCrcMarkerDatafile (TRI_df_version_t,
+                                              TRI_df_marker_t const*);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief checksums and writes a marker to the datafile
 ////////////////////////////////////////////////////////////////////////////////
@@ -706,6 +786,42 @@ bool TRI_IterateDatafile (TRI_datafile_t*,
                           bool (*iterator)(TRI_df_marker_t const*, void*, TRI_datafile_t*),
                           void* data);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief iterates over a datafile, starting at the given offset
+/// the offset must be the (aligned) start position of a marker
+////////////////////////////////////////////////////////////////////////////////
+
+bool TRI_IterateDatafileFrom (TRI_datafile_t*,
+                              TRI_voc_size_t,
+                              bool (*iterator)(TRI_df_marker_t const*, void*, TRI_datafile_t*),
+                              void* data);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief gives the kernel a hint how the datafile will be accessed
+///
+/// advice is one of the TRI_MADVISE_* values. TRI_MADVISE_DONTNEED is only
+/// applied to file-backed datafiles, as it would discard the contents of
+/// in-memory datafiles
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_AdviseDatafile (TRI_datafile_t*,
+                         int);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief restores the access pattern hint for the state of a datafile
+///
+/// sealed datafiles are read randomly via the primary index, so readahead is
+/// turned off for them. datafiles still written to use the default readahead
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_ResetAdviceDatafile (TRI_datafile_t*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief loads all pages of the datafile into memory
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_PrefaultDatafile (TRI_datafile_t*);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief opens an existing datafile read-only
 ////////////////////////////////////////////////////////////////////////////////
@@ -731,6 +847,18 @@ bool TRI_CloseDatafile (TRI_datafile_t* datafile);
 
 int TRI_SealDatafile (TRI_datafile_t* datafile) TRI_WARN_UNUSED_RESULT;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief replaces the file of a sealed datafile with a compressed copy
+///
+/// The compressed copy is written to the temporary file first, which is then
+/// renamed over the datafile. The datafile's memory is not changed, so markers
+/// stay where they are until the datafile is closed. Opening the file again
+/// decompresses its blocks on demand, see @ref CompressedDatafiles.
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_CompressDatafile (TRI_datafile_t* datafile,
+                          char const* tempFilename);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief renames a datafile
 ////////////////////////////////////////////////////////////////////////////////
@@ -29,11 +29,15 @@
 
 #include "document-collection.h"
 
+#include "Aql/PlanCache.h"
 #include "Basics/Barrier.h"
 #include "Basics/conversions.h"
 #include "Basics/Exceptions.h"
 #include "Basics/files.h"
+#include "Basics/hashes.h"
 #include "Basics/logging.h"
+#include "Basics/memory-map.h"
+#include "Basics/process-utils.h"
 #include "Basics/tri-strings.h"
 #include "Basics/ThreadPool.h"
 #include "FulltextIndex/fulltext-index.h"
@@ -119,6 +123,12 @@ TRI_document_collection_t::TRI_document_collection_t ()
     _headersPtr(nullptr),
     _keyGenerator(nullptr),
     _uncollectedLogfileEntries(0),
+    _compactionRuns(0),
+    _compactionFiles(0),
+    _compactionBytesRead(0),
+    _compactionBytesWritten(0),
+    _pageFaultsMinor(0),
+    _pageFaultsMajor(0),
     _cleanupIndexes(0) {
 
   _tickMax = 0;
@@ -147,6 +157,8 @@ void TRI_document_collection_t::addIndex (triagens::arango::Index* idx) {
   else if (idx->type() == triagens::arango::Index::TRI_IDX_TYPE_FULLTEXT_INDEX) {
     ++_cleanupIndexes;
   }
+
+  invalidatePlans();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -176,6 +188,8 @@ triagens::arango::Index* TRI_document_collection_t::removeIndex (TRI_idx_iid_t i
         --_cleanupIndexes;
       }
 
+      invalidatePlans();
+
       return idx;
     }
   }
@@ -184,6 +198,19 @@ triagens::arango::Index* TRI_document_collection_t::removeIndex (TRI_idx_iid_t i
   return nullptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate the cached execution plans that use the collection.
+/// the plans were optimized for the previous set of indexes
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_document_collection_t::invalidatePlans () {
+  if (_vocbase == nullptr || _vocbase->_planCache == nullptr) {
+    return;
+  }
+
+  static_cast<triagens::aql::PlanCache*>(_vocbase->_planCache)->invalidate(std::string(_info._name), TRI_NewTickServer());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief get all indexes of the collection
 ////////////////////////////////////////////////////////////////////////////////
@@ -202,6 +229,24 @@ triagens::arango::PrimaryIndex* TRI_document_collection_t::primaryIndex () {
   return static_cast<triagens::arango::PrimaryIndex*>(_indexes[0]);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief adds the page faults of the current thread since the given values
+/// to the page fault statistics of the collection
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_document_collection_t::addPageFaultsSince (uint64_t minorPageFaults,
+                                                    uint64_t majorPageFaults) {
+  uint64_t minorNow, majorNow;
+  TRI_PageFaultsThread(&minorNow, &majorNow);
+
+  if (minorNow >= minorPageFaults) {
+    _pageFaultsMinor += static_cast<int64_t>(minorNow - minorPageFaults);
+  }
+  if (majorNow >= majorPageFaults) {
+    _pageFaultsMajor += static_cast<int64_t>(majorNow - majorPageFaults);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return the collection's edge index, if it exists
 ////////////////////////////////////////////////////////////////////////////////
@@ -776,6 +821,35 @@ static int LookupDocument (TRI_document_collection_t* document,
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief looks up a document by key without acquiring the collection lock
+///
+/// all document operations hold the collection's write lock until they are
+/// committed or rolled back, and their changes must not be visible before.
+/// they mark the keys they change in the primary index, and lookups of keys
+/// with a marked stripe are not done until the writer releases the write
+/// lock. the collector and the compactor do not mark keys: they only move
+/// master pointers to other files, which the primary index excludes from
+/// being copied at the same time. returns whether the lookup was done, in
+/// which case res contains its result
+////////////////////////////////////////////////////////////////////////////////
+
+static bool LookupDocumentConcurrent (TRI_document_collection_t* document,
+                                      TRI_voc_key_t key,
+                                      TRI_doc_mptr_copy_t* mptr,
+                                      int& res) {
+  bool found;
+
+  if (! document->primaryIndex()->lookupKeyConcurrent(key, mptr, found)) {
+    // a writer has changed a key of the same stripe
+    return false;
+  }
+
+  res = (found ? TRI_ERROR_NO_ERROR : TRI_ERROR_ARANGO_DOCUMENT_NOT_FOUND);
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief updates an existing document
 ////////////////////////////////////////////////////////////////////////////////
@@ -813,8 +887,12 @@ static int UpdateDocument (TRI_transaction_collection_t* trxCollection,
   TRI_doc_mptr_t* newHeader = oldHeader;
 
   // update the header. this will modify oldHeader, too !!!
+  auto primaryIndex = document->primaryIndex();
+
+  primaryIndex->beginWrite();
   newHeader->_rid = operation.rid;
   newHeader->setDataPtr(operation.marker->mem());  // PROTECTED by trx in trxCollection
+  primaryIndex->endWrite();
 
   // insert new document into secondary indexes
   res = InsertSecondaryIndexes(document, newHeader, false);
@@ -824,7 +902,9 @@ static int UpdateDocument (TRI_transaction_collection_t* trxCollection,
     DeleteSecondaryIndexes(document, newHeader, true);
 
     // copy back old header data
+    primaryIndex->beginWrite();
     oldHeader->copy(oldData);
+    primaryIndex->endWrite();
 
     InsertSecondaryIndexes(document, oldHeader, true);
 
@@ -1048,6 +1128,8 @@ static int EndWrite (TRI_document_collection_t* document) {
   }
   // LOCKING-DEBUG
   // std::cout << "EndWrite: " << document->_info._name << std::endl;
+  // the changes of the writer are committed or rolled back now
+  document->primaryIndex()->publishKeys();
   TRI_WRITE_UNLOCK_DOCUMENTS_INDEXES_PRIMARY_COLLECTION(document);
 
   return TRI_ERROR_NO_ERROR;
@@ -2034,6 +2116,17 @@ static TRI_doc_collection_info_t* Figures (TRI_document_collection_t* document)
   info->_uncollectedLogfileEntries = document->_uncollectedLogfileEntries;
   info->_tickMax = document->_tickMax;
 
+  info->_compactionRuns         = document->_compactionRuns;
+  info->_compactionFiles        = document->_compactionFiles;
+  info->_compactionBytesRead    = document->_compactionBytesRead;
+  info->_compactionBytesWritten = document->_compactionBytesWritten;
+
+  info->_pageFaultsMinor        = document->_pageFaultsMinor;
+  info->_pageFaultsMajor        = document->_pageFaultsMajor;
+
+  info->_numberHeaders          = static_cast<TRI_voc_ssize_t>(document->_headersPtr->count());
+  info->_sizeHeaders            = static_cast<int64_t>(document->_headersPtr->memory());
+
   return info;
 }
 
@@ -2193,11 +2286,48 @@ static bool InitDocumentCollection (TRI_document_collection_t* document,
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief iterate over the datafiles in a vector, starting each datafile at
+/// the offset recorded for it. datafiles without a recorded offset are
+/// iterated from the beginning
+////////////////////////////////////////////////////////////////////////////////
+
+static bool IterateDatafilesFrom (TRI_vector_pointer_t const* files,
+                                  std::unordered_map<TRI_voc_fid_t, TRI_voc_size_t> const& offsets,
+                                  open_iterator_state_t* openState) {
+  size_t const n = files->_length;
+
+  for (size_t i = 0;  i < n;  ++i) {
+    auto datafile = static_cast<TRI_datafile_t*>(TRI_AtVectorPointer(files, i));
+
+    TRI_voc_size_t offset = 0;
+    auto it = offsets.find(datafile->_fid);
+
+    if (it != offsets.end()) {
+      offset = (*it).second;
+    }
+
+    if (offset >= datafile->_currentSize) {
+      continue;
+    }
+
+    if (! TRI_IterateDatafileFrom(datafile, offset, OpenIterator, openState)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief iterate all markers of the collection
+///
+/// if offsets are given, the primary index has already been restored from a
+/// snapshot, and only the markers after the recorded offsets are iterated
 ////////////////////////////////////////////////////////////////////////////////
 
-static int IterateMarkersCollection (TRI_collection_t* collection) {
+static int IterateMarkersCollection (TRI_collection_t* collection,
+                                     std::unordered_map<TRI_voc_fid_t, TRI_voc_size_t> const* offsets) {
   auto document = reinterpret_cast<TRI_document_collection_t*>(collection);
 
   // initialise state for iteration
@@ -2213,7 +2343,7 @@ static int IterateMarkersCollection (TRI_collection_t* collection) {
   openState._dfi            = nullptr;
   openState._initialCount   = -1;
 
-  if (collection->_info._initialCount != -1) {
+  if (offsets == nullptr && collection->_info._initialCount != -1) {
     auto primaryIndex = document->primaryIndex();
 
     int res = primaryIndex->resize(static_cast<size_t>(collection->_info._initialCount * 1.1));
@@ -2231,8 +2361,18 @@ static int IterateMarkersCollection (TRI_collection_t* collection) {
     return res;
   }
 
-  // read all documents and fill primary index
-  TRI_IterateCollection(collection, OpenIterator, &openState);
+  if (offsets == nullptr) {
+    // read all documents and fill primary index
+    TRI_IterateCollection(collection, OpenIterator, &openState);
+  }
+  else {
+    // read only the documents not contained in the snapshot
+    for (auto files : { &collection->_datafiles, &collection->_compactors, &collection->_journals }) {
+      if (! IterateDatafilesFrom(files, *offsets, &openState)) {
+        break;
+      }
+    }
+  }
 
   LOG_TRACE("found %llu document markers, %llu deletion markers for collection '%s'",
             (unsigned long long) openState._documents,
@@ -2247,6 +2387,683 @@ static int IterateMarkersCollection (TRI_collection_t* collection) {
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief loads all pages of the collection's datafiles into memory
+////////////////////////////////////////////////////////////////////////////////
+
+static void PrefaultDatafiles (TRI_collection_t* collection) {
+  for (auto files : { &collection->_datafiles, &collection->_compactors, &collection->_journals }) {
+    for (size_t i = 0;  i < files->_length;  ++i) {
+      auto datafile = static_cast<TRI_datafile_t*>(TRI_AtVectorPointer(files, i));
+
+      TRI_PrefaultDatafile(datafile);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                   INDEX SNAPSHOTS
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief name of the snapshot file in the collection directory
+////////////////////////////////////////////////////////////////////////////////
+
+static char const* SnapshotFilename = "snapshot.db";
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief name of the temporary file used while writing a snapshot
+////////////////////////////////////////////////////////////////////////////////
+
+static char const* SnapshotTempFilename = "snapshot.db.tmp";
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief magic string at the start of a snapshot file
+////////////////////////////////////////////////////////////////////////////////
+
+static char const SnapshotMagic[16] = "ARANGO-SNAPSHOT";
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief current version of the snapshot file format
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t const SnapshotVersion = 1;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief size of the write buffer used when writing a snapshot
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t const SnapshotBufferSize = 256 * 1024;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                     private types
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief snapshot file header
+///
+/// the header is followed by _numberDatafiles datafile records,
+/// _numberMarkers shape/attribute marker records and _numberDocuments
+/// document records. all values are stored in native byte order, so
+/// snapshots cannot be moved between architectures
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct snapshot_header_s {
+  char                    _magic[16];
+  uint32_t                _version;
+  uint32_t                _crc;
+  TRI_voc_cid_t           _cid;
+  TRI_voc_tick_t          _tickMax;
+  TRI_voc_rid_t           _revision;
+  uint64_t                _numberDatafiles;
+  uint64_t                _numberMarkers;
+  uint64_t                _numberDocuments;
+  char                    _trackedKey[TRI_VOC_KEY_MAX_LENGTH + 2];
+}
+snapshot_header_t;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief snapshot record for a datafile
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct snapshot_datafile_s {
+  TRI_voc_fid_t           _fid;
+  uint64_t                _size;
+  TRI_voc_tick_t          _tickMin;
+  TRI_voc_tick_t          _tickMax;
+  TRI_voc_tick_t          _dataMin;
+  TRI_voc_tick_t          _dataMax;
+  TRI_doc_datafile_info_t _dfi;
+}
+snapshot_datafile_t;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief snapshot record for a shape or attribute marker
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct snapshot_marker_s {
+  TRI_voc_fid_t           _fid;
+  uint64_t                _offset;
+}
+snapshot_marker_t;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief snapshot record for a document or edge
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct snapshot_document_s {
+  TRI_voc_fid_t           _fid;
+  uint64_t                _offset;
+  TRI_voc_rid_t           _rid;
+  uint64_t                _hash;
+}
+snapshot_document_t;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief buffered writer for snapshot files
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct snapshot_writer_s {
+  int                     _fd;
+  uint32_t                _crc;
+  bool                    _ok;
+  std::string             _buffer;
+}
+snapshot_writer_t;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief flush the buffered snapshot data to disk
+////////////////////////////////////////////////////////////////////////////////
+
+static void FlushSnapshot (snapshot_writer_t* writer) {
+  if (writer->_buffer.empty()) {
+    return;
+  }
+
+  writer->_crc = TRI_BlockCrc32C(writer->_crc, writer->_buffer.c_str(), writer->_buffer.size());
+
+  if (writer->_ok &&
+      ! TRI_WritePointer(writer->_fd, writer->_buffer.c_str(), writer->_buffer.size())) {
+    writer->_ok = false;
+  }
+
+  writer->_buffer.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief append a record to a snapshot
+////////////////////////////////////////////////////////////////////////////////
+
+static void AppendSnapshot (snapshot_writer_t* writer,
+                            void const* data,
+                            size_t length) {
+  writer->_buffer.append(static_cast<char const*>(data), length);
+
+  if (writer->_buffer.size() >= SnapshotBufferSize) {
+    FlushSnapshot(writer);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief find the datafile that contains the memory region given
+///
+/// returns nullptr if the region is not fully contained in a datafile, e.g.
+/// because it is still located in the write-ahead log
+////////////////////////////////////////////////////////////////////////////////
+
+static TRI_datafile_t* SnapshotDatafile (std::map<char const*, TRI_datafile_t*> const& files,
+                                         void const* ptr,
+                                         size_t length) {
+  char const* p = static_cast<char const*>(ptr);
+  auto it = files.upper_bound(p);
+
+  if (it == files.begin()) {
+    return nullptr;
+  }
+
+  --it;
+  TRI_datafile_t* datafile = (*it).second;
+
+  if (p + length > datafile->_data + datafile->_currentSize) {
+    return nullptr;
+  }
+
+  return datafile;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief write a snapshot of the primary index and the shaper
+///
+/// the snapshot stores the datafile position of each marker, so it can only
+/// be written if all markers of the collection have been transferred from the
+/// write-ahead log into the collection's datafiles
+////////////////////////////////////////////////////////////////////////////////
+
+static int WriteSnapshot (TRI_document_collection_t* document) {
+  TRI_collection_t* collection = document;
+
+  if (collection->_compactors._length > 0 ||
+      ! TRI_IsFullyCollectedDocumentCollection(document)) {
+    return TRI_ERROR_ARANGO_ILLEGAL_STATE;
+  }
+
+  double start = TRI_microtime();
+
+  std::map<char const*, TRI_datafile_t*> files;
+
+  for (auto vector : { &collection->_datafiles, &collection->_journals }) {
+    for (size_t i = 0;  i < vector->_length;  ++i) {
+      auto datafile = static_cast<TRI_datafile_t*>(TRI_AtVectorPointer(vector, i));
+
+      if (datafile->_data == nullptr) {
+        return TRI_ERROR_ARANGO_ILLEGAL_STATE;
+      }
+
+      files.emplace(datafile->_data, datafile);
+    }
+  }
+
+  char* filename = TRI_Concatenate2File(collection->_directory, SnapshotTempFilename);
+
+  if (filename == nullptr) {
+    return TRI_ERROR_OUT_OF_MEMORY;
+  }
+
+  TRI_UnlinkFile(filename);
+
+  int fd = TRI_CREATE(filename, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+
+  if (fd < 0) {
+    TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
+    return TRI_ERROR_CANNOT_WRITE_FILE;
+  }
+
+  snapshot_header_t header;
+  memset(&header, 0, sizeof(header));
+
+  snapshot_writer_t writer;
+  writer._fd  = fd;
+  writer._crc = TRI_InitialCrc32();
+  writer._ok  = true;
+  writer._buffer.reserve(SnapshotBufferSize + sizeof(snapshot_datafile_t));
+
+  int res = TRI_ERROR_NO_ERROR;
+
+  try {
+    // the header is written last, after all counts and the checksum are known
+    if (! TRI_WritePointer(fd, &header, sizeof(header))) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_CANNOT_WRITE_FILE);
+    }
+
+    // datafiles
+    for (auto const& it : files) {
+      TRI_datafile_t const* datafile = it.second;
+      TRI_doc_datafile_info_t const* dfi = TRI_FindDatafileInfoDocumentCollection(document, datafile->_fid, false);
+
+      snapshot_datafile_t record;
+      memset(&record, 0, sizeof(record));
+      record._fid     = datafile->_fid;
+      record._size    = datafile->_currentSize;
+      record._tickMin = datafile->_tickMin;
+      record._tickMax = datafile->_tickMax;
+      record._dataMin = datafile->_dataMin;
+      record._dataMax = datafile->_dataMax;
+
+      if (dfi != nullptr) {
+        record._dfi = *dfi;
+      }
+
+      AppendSnapshot(&writer, &record, sizeof(record));
+      ++header._numberDatafiles;
+    }
+
+    // shapes and attributes
+    bool ok = TRI_IterateMarkersVocShaper(document->getShaper(), [&] (TRI_df_marker_t const* marker) -> bool {
+      if (marker->_type != TRI_DF_MARKER_SHAPE &&
+          marker->_type != TRI_DF_MARKER_ATTRIBUTE) {
+        return false;
+      }
+
+      TRI_datafile_t const* datafile = SnapshotDatafile(files, marker, marker->_size);
+
+      if (datafile == nullptr) {
+        return false;
+      }
+
+      snapshot_marker_t record;
+      record._fid    = datafile->_fid;
+      record._offset = static_cast<uint64_t>(reinterpret_cast<char const*>(marker) - datafile->_data);
+
+      AppendSnapshot(&writer, &record, sizeof(record));
+      ++header._numberMarkers;
+
+      return true;
+    });
+
+    if (! ok) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_ARANGO_ILLEGAL_STATE);
+    }
+
+    // documents, in the order of the headers list
+    for (TRI_doc_mptr_t const* mptr = document->_headersPtr->front();  mptr != nullptr;  mptr = document->_headersPtr->next(mptr)) {
+      auto marker = static_cast<TRI_df_marker_t const*>(mptr->getDataPtr());  // ONLY IN CLOSECOLLECTION, PROTECTED by fake trx in caller
+
+      if (marker == nullptr ||
+          (marker->_type != TRI_DOC_MARKER_KEY_DOCUMENT &&
+           marker->_type != TRI_DOC_MARKER_KEY_EDGE)) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_ARANGO_ILLEGAL_STATE);
+      }
+
+      TRI_datafile_t const* datafile = SnapshotDatafile(files, marker, marker->_size);
+
+      if (datafile == nullptr || datafile->_fid != mptr->_fid) {
+        THROW_ARANGO_EXCEPTION(TRI_ERROR_ARANGO_ILLEGAL_STATE);
+      }
+
+      snapshot_document_t record;
+      record._fid    = mptr->_fid;
+      record._offset = static_cast<uint64_t>(reinterpret_cast<char const*>(marker) - datafile->_data);
+      record._rid    = mptr->_rid;
+      record._hash   = mptr->_hash;
+
+      AppendSnapshot(&writer, &record, sizeof(record));
+      ++header._numberDocuments;
+    }
+
+    FlushSnapshot(&writer);
+
+    if (! writer._ok) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_CANNOT_WRITE_FILE);
+    }
+
+    // now fill in the header
+    memcpy(header._magic, SnapshotMagic, sizeof(header._magic));
+    header._version  = SnapshotVersion;
+    header._cid      = collection->_info._cid;
+    header._tickMax  = collection->_tickMax;
+    header._revision = collection->_info._revision;
+
+    std::string const trackedKey = document->_keyGenerator->trackedKey();
+    TRI_ASSERT(trackedKey.size() < sizeof(header._trackedKey));
+    memcpy(header._trackedKey, trackedKey.c_str(), trackedKey.size());
+
+    header._crc = TRI_FinalCrc32(TRI_BlockCrc32C(writer._crc, reinterpret_cast<char const*>(&header), sizeof(header)));
+
+    if (TRI_LSEEK(fd, 0, SEEK_SET) != 0 ||
+        ! TRI_WritePointer(fd, &header, sizeof(header)) ||
+        ! TRI_fsync(fd)) {
+      THROW_ARANGO_EXCEPTION(TRI_ERROR_CANNOT_WRITE_FILE);
+    }
+  }
+  catch (triagens::basics::Exception const& ex) {
+    res = ex.code();
+  }
+  catch (...) {
+    res = TRI_ERROR_OUT_OF_MEMORY;
+  }
+
+  TRI_CLOSE(fd);
+
+  TRI_IF_FAILURE("WriteSnapshotBeforeRename") {
+    // intentionally kill the server, leaving the temporary file behind
+    TRI_SegfaultDebugging("WriteSnapshotBeforeRename");
+  }
+
+  if (res == TRI_ERROR_NO_ERROR) {
+    char* target = TRI_Concatenate2File(collection->_directory, SnapshotFilename);
+
+    if (target == nullptr) {
+      res = TRI_ERROR_OUT_OF_MEMORY;
+    }
+    else {
+      res = TRI_RenameFile(filename, target);
+      TRI_FreeString(TRI_CORE_MEM_ZONE, target);
+    }
+  }
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    TRI_UnlinkFile(filename);
+  }
+
+  TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
+
+  if (res == TRI_ERROR_NO_ERROR) {
+    LOG_TIMER((TRI_microtime() - start),
+              "write-snapshot { collection: %s/%s, documents: %llu }",
+              document->_vocbase->_name,
+              collection->_info._name,
+              (unsigned long long) header._numberDocuments);
+  }
+
+  return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief restore the primary index and the shaper from a mapped snapshot
+///
+/// all records are validated against the datafiles before anything is
+/// modified. if validation fails, loaded is set to false and the collection
+/// must be loaded by iterating over all of its markers. on success, offsets
+/// contains the positions in each datafile up to which the snapshot is valid
+////////////////////////////////////////////////////////////////////////////////
+
+static int ApplySnapshot (TRI_document_collection_t* document,
+                          char const* data,
+                          size_t size,
+                          std::unordered_map<TRI_voc_fid_t, TRI_voc_size_t>& offsets,
+                          bool& loaded) {
+  TRI_collection_t* collection = document;
+  loaded = false;
+
+  if (size < sizeof(snapshot_header_t)) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  snapshot_header_t header;
+  memcpy(&header, data, sizeof(header));
+
+  if (memcmp(header._magic, SnapshotMagic, sizeof(header._magic)) != 0 ||
+      header._version != SnapshotVersion ||
+      header._cid != collection->_info._cid ||
+      header._trackedKey[sizeof(header._trackedKey) - 1] != '\0') {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  uint64_t const expected = sizeof(snapshot_header_t) +
+                            header._numberDatafiles * sizeof(snapshot_datafile_t) +
+                            header._numberMarkers * sizeof(snapshot_marker_t) +
+                            header._numberDocuments * sizeof(snapshot_document_t);
+
+  if (expected != static_cast<uint64_t>(size)) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  uint32_t const crc = header._crc;
+  header._crc = 0;
+
+  uint32_t actual = TRI_BlockCrc32C(TRI_InitialCrc32(), data + sizeof(header), size - sizeof(header));
+  actual = TRI_FinalCrc32(TRI_BlockCrc32C(actual, reinterpret_cast<char const*>(&header), sizeof(header)));
+
+  if (actual != crc) {
+    LOG_WARNING("ignoring corrupted index snapshot for collection '%s'", collection->_info._name);
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  auto datafiles = reinterpret_cast<snapshot_datafile_t const*>(data + sizeof(header));
+  auto markers   = reinterpret_cast<snapshot_marker_t const*>(datafiles + header._numberDatafiles);
+  auto documents = reinterpret_cast<snapshot_document_t const*>(markers + header._numberMarkers);
+
+  // all datafiles of the snapshot must still exist and must not have shrunk
+  std::unordered_map<TRI_voc_fid_t, TRI_datafile_t*> files;
+
+  for (auto vector : { &collection->_datafiles, &collection->_compactors, &collection->_journals }) {
+    for (size_t i = 0;  i < vector->_length;  ++i) {
+      auto datafile = static_cast<TRI_datafile_t*>(TRI_AtVectorPointer(vector, i));
+      files.emplace(datafile->_fid, datafile);
+    }
+  }
+
+  for (uint64_t i = 0;  i < header._numberDatafiles;  ++i) {
+    auto it = files.find(datafiles[i]._fid);
+
+    if (it == files.end() ||
+        (*it).second->_currentSize < datafiles[i]._size ||
+        datafiles[i]._size != TRI_DF_ALIGN_BLOCK(datafiles[i]._size) ||
+        offsets.find(datafiles[i]._fid) != offsets.end()) {
+      LOG_DEBUG("ignoring outdated index snapshot for collection '%s'", collection->_info._name);
+      return TRI_ERROR_NO_ERROR;
+    }
+
+    offsets.emplace(datafiles[i]._fid, static_cast<TRI_voc_size_t>(datafiles[i]._size));
+  }
+
+  // returns the marker at the recorded position, or nullptr if the position
+  // is not valid for the datafile
+  auto lookup = [&] (TRI_voc_fid_t fid, uint64_t offset) -> TRI_df_marker_t const* {
+    auto it = offsets.find(fid);
+
+    if (it == offsets.end() ||
+        offset != TRI_DF_ALIGN_BLOCK(offset) ||
+        offset + sizeof(TRI_df_marker_t) > (*it).second) {
+      return nullptr;
+    }
+
+    auto marker = reinterpret_cast<TRI_df_marker_t const*>(files[fid]->_data + offset);
+
+    if (marker->_size < sizeof(TRI_df_marker_t) ||
+        offset + marker->_size > (*it).second) {
+      return nullptr;
+    }
+
+    return marker;
+  };
+
+  for (uint64_t i = 0;  i < header._numberMarkers;  ++i) {
+    TRI_df_marker_t const* marker = lookup(markers[i]._fid, markers[i]._offset);
+
+    if (marker == nullptr ||
+        (marker->_type != TRI_DF_MARKER_SHAPE &&
+         marker->_type != TRI_DF_MARKER_ATTRIBUTE)) {
+      offsets.clear();
+      return TRI_ERROR_NO_ERROR;
+    }
+  }
+
+  for (uint64_t i = 0;  i < header._numberDocuments;  ++i) {
+    TRI_df_marker_t const* marker = lookup(documents[i]._fid, documents[i]._offset);
+
+    if (marker == nullptr ||
+        (marker->_type != TRI_DOC_MARKER_KEY_DOCUMENT &&
+         marker->_type != TRI_DOC_MARKER_KEY_EDGE) ||
+        marker->_size < sizeof(TRI_doc_document_key_marker_t) ||
+        reinterpret_cast<TRI_doc_document_key_marker_t const*>(marker)->_rid != documents[i]._rid) {
+      offsets.clear();
+      return TRI_ERROR_NO_ERROR;
+    }
+  }
+
+  // the snapshot is valid. from here on, any error is fatal
+  loaded = true;
+
+  auto primaryIndex = document->primaryIndex();
+
+  int res = primaryIndex->resize(static_cast<size_t>(header._numberDocuments * 1.1));
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    return res;
+  }
+
+  TRI_shaper_t* shaper = document->getShaper();  // ONLY IN OPENCOLLECTION, PROTECTED by fake trx in caller
+
+  for (uint64_t i = 0;  i < header._numberMarkers;  ++i) {
+    TRI_df_marker_t const* marker = lookup(markers[i]._fid, markers[i]._offset);
+
+    if (marker->_type == TRI_DF_MARKER_SHAPE) {
+      res = TRI_InsertShapeVocShaper(shaper, marker, true);
+    }
+    else {
+      res = TRI_InsertAttributeVocShaper(shaper, marker, true);
+    }
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      return res;
+    }
+  }
+
+  for (uint64_t i = 0;  i < header._numberDocuments;  ++i) {
+    snapshot_document_t const& record = documents[i];
+    TRI_df_marker_t const* marker = lookup(record._fid, record._offset);
+
+    TRI_doc_mptr_t* mptr = document->_headersPtr->request(marker->_size);  // ONLY IN OPENITERATOR
+
+    if (mptr == nullptr) {
+      return TRI_ERROR_OUT_OF_MEMORY;
+    }
+
+    mptr->_rid  = record._rid;
+    mptr->_fid  = record._fid;
+    mptr->_hash = record._hash;
+    mptr->setDataPtr(marker);  // ONLY IN OPENITERATOR
+
+    primaryIndex->insertKey(mptr);
+    document->_numberDocuments++;
+  }
+
+  // restore datafile statistics and tick values
+  for (uint64_t i = 0;  i < header._numberDatafiles;  ++i) {
+    snapshot_datafile_t const& record = datafiles[i];
+    TRI_datafile_t* datafile = files[record._fid];
+
+    if (datafile->_tickMin == 0 || (record._tickMin != 0 && record._tickMin < datafile->_tickMin)) {
+      datafile->_tickMin = record._tickMin;
+    }
+    if (record._tickMax > datafile->_tickMax) {
+      datafile->_tickMax = record._tickMax;
+    }
+    datafile->_dataMin = record._dataMin;
+    datafile->_dataMax = record._dataMax;
+
+    TRI_doc_datafile_info_t* dfi = TRI_FindDatafileInfoDocumentCollection(document, record._fid, true);
+
+    if (dfi == nullptr) {
+      return TRI_ERROR_OUT_OF_MEMORY;
+    }
+
+    TRI_doc_datafile_info_t stats = record._dfi;
+    stats._fid = record._fid;
+    *dfi = stats;
+  }
+
+  if (header._tickMax > collection->_tickMax) {
+    collection->_tickMax = header._tickMax;
+  }
+
+  SetRevision(document, header._revision, false);
+
+  if (header._trackedKey[0] != '\0') {
+    document->_keyGenerator->track(header._trackedKey);
+  }
+
+  return TRI_ERROR_NO_ERROR;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief load and remove the snapshot of a collection, if there is one
+///
+/// the snapshot file is always removed, so a snapshot can be used only once,
+/// directly after the collection was unloaded. a temporary file left by a
+/// crash while writing a snapshot is removed, too
+////////////////////////////////////////////////////////////////////////////////
+
+static int LoadSnapshot (TRI_document_collection_t* document,
+                         std::unordered_map<TRI_voc_fid_t, TRI_voc_size_t>& offsets,
+                         bool& loaded) {
+  loaded = false;
+
+  char* filename = TRI_Concatenate2File(document->_directory, SnapshotTempFilename);
+
+  if (filename == nullptr) {
+    return TRI_ERROR_OUT_OF_MEMORY;
+  }
+
+  if (TRI_ExistsFile(filename)) {
+    TRI_UnlinkFile(filename);
+  }
+
+  TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
+
+  filename = TRI_Concatenate2File(document->_directory, SnapshotFilename);
+
+  if (filename == nullptr) {
+    return TRI_ERROR_OUT_OF_MEMORY;
+  }
+
+  if (! TRI_ExistsFile(filename)) {
+    TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  double start = TRI_microtime();
+  int res = TRI_ERROR_NO_ERROR;
+  int64_t size = TRI_SizeFile(filename);
+  int fd = TRI_OPEN(filename, O_RDONLY);
+
+  if (fd >= 0 && size > 0) {
+    void* data = nullptr;
+    void* mmHandle = nullptr;
+
+    if (TRI_MMFile(0, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, &mmHandle, 0, &data) == TRI_ERROR_NO_ERROR) {
+      res = ApplySnapshot(document, static_cast<char const*>(data), static_cast<size_t>(size), offsets, loaded);
+
+      TRI_UNMMFile(data, static_cast<size_t>(size), fd, &mmHandle);
+    }
+  }
+
+  if (fd >= 0) {
+    TRI_CLOSE(fd);
+  }
+
+  TRI_UnlinkFile(filename);
+  TRI_FreeString(TRI_CORE_MEM_ZONE, filename);
+
+  if (loaded && res == TRI_ERROR_NO_ERROR) {
+    LOG_TIMER((TRI_microtime() - start),
+              "load-snapshot { collection: %s/%s }",
+              document->_vocbase->_name,
+              document->_info._name);
+  }
+
+  return res;
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                      constructors and destructors
 // -----------------------------------------------------------------------------
@@ -2757,18 +3574,24 @@ int TRI_RollbackOperationDocumentCollection (TRI_document_collection_t* document
     return TRI_ERROR_NO_ERROR;
   }
   else if (type == TRI_VOC_DOCUMENT_OPERATION_UPDATE) {
+    auto primaryIndex = document->primaryIndex();
+
     // copy the existing header's state
     TRI_doc_mptr_copy_t copy = *header;
     
     // remove the current values from the indexes
     DeleteSecondaryIndexes(document, header, true);
     // revert to the old state
+    primaryIndex->beginWrite();
     header->copy(*oldData);
+    primaryIndex->endWrite();
     // re-insert old state
     int res = InsertSecondaryIndexes(document, header, true);
     // revert again to the new state, because other parts of the new state
     // will be reverted at some other place
+    primaryIndex->beginWrite();
     header->copy(copy);
+    primaryIndex->endWrite();
     
     return res;
   }
@@ -3088,8 +3911,26 @@ TRI_document_collection_t* TRI_OpenDocumentCollection (TRI_vocbase_t* vocbase,
                vocbase->_name,
                document->_info._name);
 
-    // iterate over all markers of the collection
-    int res = IterateMarkersCollection(collection);
+    // restore the primary index from a snapshot if there is one, and iterate
+    // over the markers not contained in the snapshot. if there is no usable
+    // snapshot, iterate over all markers of the collection
+    std::unordered_map<TRI_voc_fid_t, TRI_voc_size_t> offsets;
+    bool loaded = false;
+
+    uint64_t minorPageFaults, majorPageFaults;
+    TRI_PageFaultsThread(&minorPageFaults, &majorPageFaults);
+
+    int res = LoadSnapshot(document, offsets, loaded);
+
+    if (res == TRI_ERROR_NO_ERROR) {
+      res = IterateMarkersCollection(collection, loaded ? &offsets : nullptr);
+    }
+
+    if (res == TRI_ERROR_NO_ERROR && vocbase->_settings.prefaultDatafiles) {
+      PrefaultDatafiles(collection);
+    }
+
+    document->addPageFaultsSince(minorPageFaults, majorPageFaults);
   
     LOG_TIMER((TRI_microtime() - start),
               "iterate-markers { collection: %s/%s }", 
@@ -3143,10 +3984,25 @@ int TRI_CloseDocumentCollection (TRI_document_collection_t* document,
     TRI_SaveCollectionInfo(document->_directory, &document->_info, doSync);
   }
 
+  TransactionBase trx(true);  // just to protect the following calls
+
+  if (document->_vocbase->_settings.indexSnapshots &&
+      ! document->_info._deleted &&
+      ! document->_info._isVolatile &&
+      ! triagens::wal::LogfileManager::instance()->isInRecovery()) {
+    // write a snapshot of the primary index while the datafiles are still mapped
+    int res = WriteSnapshot(document);
+
+    if (res != TRI_ERROR_NO_ERROR) {
+      LOG_DEBUG("cannot write index snapshot for collection '%s': %s",
+                document->_info._name,
+                TRI_errno_string(res));
+    }
+  }
+
   // closes all open compactors, journals, datafiles
   int res = TRI_CloseCollection(document);
 
-  TransactionBase trx(true);  // just to protect the following call
   TRI_FreeVocShaper(document->getShaper());  // ONLY IN CLOSECOLLECTION, PROTECTED by fake trx here
   document->setShaper(nullptr);
 
@@ -3226,37 +4082,27 @@ static int FillIndex (TRI_document_collection_t* document,
     // give the index a size hint
     idx->sizeHint(static_cast<size_t>(primaryIndex->_nrUsed));
 
-#ifdef TRI_ENABLE_MAINTAINER_MODE
-    static const int LoopSize = 10000;
-    int counter = 0;
-    int loops = 0;
-#endif
+    std::vector<TRI_doc_mptr_t const*> documents;
+    documents.reserve(static_cast<size_t>(primaryIndex->_nrUsed));
 
     for (;  ptr < end;  ++ptr) {
       auto mptr = static_cast<TRI_doc_mptr_t const*>(*ptr);
 
       if (mptr != nullptr) {
-        int res = idx->insert(mptr, false);
-
-        if (res != TRI_ERROR_NO_ERROR) {
-          return res;
-        }
-
-#ifdef TRI_ENABLE_MAINTAINER_MODE
-        if (++counter == LoopSize) {
-          counter = 0;
-          ++loops;
-
-          LOG_TRACE("indexed %llu documents of collection %llu",
-                    (unsigned long long) (LoopSize * loops),
-                    (unsigned long long) document->_info._cid);
-        }
-#endif
-
+        documents.emplace_back(mptr);
       }
     }
 
-    return TRI_ERROR_NO_ERROR;
+    // the index decides itself whether it uses the threads of the index pool.
+    // these are shared by all indexes filled at the same time
+    auto indexPool = static_cast<triagens::basics::ThreadPool*>(document->_vocbase->_server->_indexPool);
+    int res = idx->batchInsert(&documents, indexPool);
+
+    LOG_TRACE("indexed %llu documents of collection %llu",
+              (unsigned long long) documents.size(),
+              (unsigned long long) document->_info._cid);
+
+    return res;
   }
   catch (triagens::basics::Exception const& ex) {
     return ex.code();
@@ -4980,6 +5826,15 @@ int TRI_ReadShapedJsonDocumentCollection (TRI_transaction_collection_t* trxColle
 
 
     TRI_document_collection_t* document = trxCollection->_collection->_collection;
+
+    if (lock) {
+      int res;
+
+      if (LookupDocumentConcurrent(document, key, mptr, res)) {
+        return res;
+      }
+    }
+
     triagens::arango::CollectionReadLocker collectionLocker(document, lock);
 
     TRI_doc_mptr_t* header;
@@ -5052,6 +5907,9 @@ int TRI_RemoveShapedJsonDocumentCollection (TRI_transaction_collection_t* trxCol
 
     triagens::arango::CollectionWriteLocker collectionLocker(document, lock);
 
+    // hide the key from concurrent lookups until the write lock is released
+    document->primaryIndex()->markKey(triagens::arango::PrimaryIndex::calculateHash(key));
+
     triagens::wal::DocumentOperation operation(marker, freeMarker, trxCollection, TRI_VOC_DOCUMENT_OPERATION_REMOVE, rid);
 
     res = LookupDocument(document, key, policy, header);
@@ -5193,6 +6051,9 @@ int TRI_InsertShapedJsonDocumentCollection (TRI_transaction_collection_t* trxCol
 
     triagens::arango::CollectionWriteLocker collectionLocker(document, lock);
 
+    // hide the key from concurrent lookups until the write lock is released
+    document->primaryIndex()->markKey(hash);
+
     triagens::wal::DocumentOperation operation(marker, freeMarker, trxCollection, TRI_VOC_DOCUMENT_OPERATION_INSERT, rid);
 
     TRI_IF_FAILURE("InsertDocumentNoHeader") {
@@ -5277,6 +6138,9 @@ int TRI_UpdateShapedJsonDocumentCollection (TRI_transaction_collection_t* trxCol
 
     triagens::arango::CollectionWriteLocker collectionLocker(document, lock);
 
+    // hide the key from concurrent lookups until the write lock is released
+    document->primaryIndex()->markKey(triagens::arango::PrimaryIndex::calculateHash(key));
+
     // get the header pointer of the previous revision
     TRI_doc_mptr_t* oldHeader;
     res = LookupDocument(document, key, policy, oldHeader);
@@ -129,8 +129,8 @@ struct TRI_doc_mptr_t {
     TRI_voc_rid_t          _rid;     // this is the revision identifier
     TRI_voc_fid_t          _fid;     // this is the datafile identifier
     uint64_t               _hash;    // the pre-calculated hash value of the key
-    TRI_doc_mptr_t*        _prev;    // previous master pointer
-    TRI_doc_mptr_t*        _next;    // next master pointer
+    uint32_t               _prev;    // slot of the previous master pointer in the headers, 0 if none
+    uint32_t               _next;    // slot of the next master pointer in the headers, 0 if none
   protected:
     void const*            _dataptr; // this is the pointer to the beginning of the raw marker
 
@@ -138,21 +138,31 @@ struct TRI_doc_mptr_t {
     TRI_doc_mptr_t () : _rid(0), 
                         _fid(0), 
                         _hash(0),
-                        _prev(nullptr),
-                        _next(nullptr),
+                        _prev(0),
+                        _next(0),
                         _dataptr(nullptr) {
     }
 
+// the destructor is only virtual in maintainer mode, where the accessors are
+// virtual, too. in release builds, a master pointer has no vtable, which
+// saves 8 bytes per document header. the layouts differ only by the vtable
+// pointer, see the assertions below the class
+
+#ifndef TRI_ENABLE_MAINTAINER_MODE
+    ~TRI_doc_mptr_t () {
+    }
+#else
     virtual ~TRI_doc_mptr_t () {
     }
+#endif
 
     void clear () {
       _rid = 0;
       _fid = 0;
       setDataPtr(nullptr);
       _hash = 0;
-      _prev = nullptr;
-      _next = nullptr;
+      _prev = 0;
+      _next = 0;
     }
 
     void copy (TRI_doc_mptr_t const& that) {
@@ -222,6 +232,27 @@ struct TRI_doc_mptr_t {
 
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief layout of master pointers
+///
+/// master pointers are never written to disk and never deleted through a
+/// pointer to a base class, and no code depends on their layout. the only
+/// difference between release and maintainer builds is the vtable pointer,
+/// and the members must not need padding in either
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TRI_ENABLE_MAINTAINER_MODE
+static_assert(! std::is_polymorphic<TRI_doc_mptr_t>::value,
+              "master pointers must not have a vtable in release builds");
+static_assert(sizeof(TRI_doc_mptr_t) == 3 * sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(void*),
+              "unexpected size of master pointers");
+#else
+static_assert(std::is_polymorphic<TRI_doc_mptr_t>::value,
+              "master pointers must have a vtable in maintainer builds");
+static_assert(sizeof(TRI_doc_mptr_t) == 3 * sizeof(uint64_t) + 2 * sizeof(uint32_t) + 2 * sizeof(void*),
+              "unexpected size of master pointers");
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief A derived class for copies of master pointers, they
 ////////////////////////////////////////////////////////////////////////////////
@@ -338,6 +369,17 @@ typedef struct TRI_doc_collection_info_s {
 
   TRI_voc_tick_t  _tickMax;
   uint64_t        _uncollectedLogfileEntries;
+
+  int64_t         _compactionRuns;
+  int64_t         _compactionFiles;
+  int64_t         _compactionBytesRead;
+  int64_t         _compactionBytesWritten;
+
+  int64_t         _pageFaultsMinor;
+  int64_t         _pageFaultsMajor;
+
+  TRI_voc_ssize_t _numberHeaders;
+  int64_t         _sizeHeaders;
 }
 TRI_doc_collection_info_t;
 
@@ -387,11 +429,13 @@ public:
 
   void addIndex (triagens::arango::Index*);
   triagens::arango::Index* removeIndex (TRI_idx_iid_t);
+  void invalidatePlans ();
   std::vector<triagens::arango::Index*> allIndexes () const;
   triagens::arango::Index* lookupIndex (TRI_idx_iid_t) const;
   triagens::arango::PrimaryIndex* primaryIndex ();
   triagens::arango::EdgeIndex* edgeIndex ();
   triagens::arango::CapConstraint* capConstraint ();
+  void addPageFaultsSince (uint64_t, uint64_t);
 
   triagens::arango::CapConstraint*       _capConstraint;
 
@@ -414,6 +458,16 @@ public:
   TRI_read_write_lock_t                  _compactionLock;
   double                                 _lastCompaction;
 
+  // compaction statistics since the collection was loaded
+  std::atomic<int64_t>                   _compactionRuns;
+  std::atomic<int64_t>                   _compactionFiles;
+  std::atomic<int64_t>                   _compactionBytesRead;
+  std::atomic<int64_t>                   _compactionBytesWritten;
+
+  // page faults of loading and compacting the collection since it was loaded
+  std::atomic<int64_t>                   _pageFaultsMinor;
+  std::atomic<int64_t>                   _pageFaultsMajor;
+
   // ...........................................................................
   // this condition variable protects the _journalsCondition
   // ...........................................................................
@@ -36,6 +36,40 @@
 // --SECTION--                                                 private functions
 // -----------------------------------------------------------------------------
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief links an unlinked header at its previous position (specified in
+/// "old")
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_headers_t::link (TRI_doc_mptr_t* header,
+                          TRI_doc_mptr_t const* old) {
+  uint32_t headerSlot = slot(header);
+  TRI_doc_mptr_t* oldPrev = at(old->_prev);
+  TRI_doc_mptr_t* oldNext = at(old->_next);
+
+  if (oldPrev != nullptr) {
+    oldPrev->_next = headerSlot;
+  }
+  else {
+    _begin = header;
+  }
+
+  if (oldNext != nullptr) {
+    oldNext->_prev = headerSlot;
+  }
+  else {
+    _end = header;
+  }
+
+  header->_prev = old->_prev;
+  header->_next = old->_next;
+
+  TRI_ASSERT(_begin != nullptr);
+  TRI_ASSERT(_end != nullptr);
+  TRI_ASSERT(header->_prev != headerSlot);
+  TRI_ASSERT(header->_next != headerSlot);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief get the size (number of entries) for a block, based on a function
 ///
@@ -47,19 +81,55 @@
 /// the highest value is BLOCK_SIZE_UNIT << 8.
 ////////////////////////////////////////////////////////////////////////////////
 
-static inline size_t GetBlockSize (size_t blockNumber) {
-  static size_t const BLOCK_SIZE_UNIT = 128;
+static size_t const BLOCK_SIZE_UNIT = 128;
 
+static inline size_t GetBlockSize (size_t blockNumber) {
   if (blockNumber < 8) {
     // use a small block size in the beginning to save memory
     return (size_t) (BLOCK_SIZE_UNIT << blockNumber);
   }
 
   // use a block size of 32768
-  // this will use 32768 * sizeof(TRI_doc_mptr_t) bytes, i.e. 1.5 MB
+  // this will use 32768 * sizeof(TRI_doc_mptr_t) bytes, i.e. 1.25 MB
   return (size_t) (BLOCK_SIZE_UNIT << 8);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief get the index of the first header of a block
+///
+/// the headers of all blocks are numbered consecutively. a header is linked
+/// into the list by the number of its slot, which is its index plus one, so
+/// that slot 0 means no header
+////////////////////////////////////////////////////////////////////////////////
+
+static inline size_t GetBlockStart (size_t blockNumber) {
+  if (blockNumber < 8) {
+    return BLOCK_SIZE_UNIT * (((size_t) 1 << blockNumber) - 1);
+  }
+
+  return BLOCK_SIZE_UNIT * 255 + (blockNumber - 8) * (BLOCK_SIZE_UNIT << 8);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief get the number of the block containing the header with an index
+////////////////////////////////////////////////////////////////////////////////
+
+static inline size_t GetBlockNumber (size_t index) {
+  if (index >= GetBlockStart(8)) {
+    return 8 + (index - GetBlockStart(8)) / GetBlockSize(8);
+  }
+
+  size_t n = index / BLOCK_SIZE_UNIT + 1;
+  size_t blockNumber = 0;
+
+  while (n > 1) {
+    n >>= 1;
+    ++blockNumber;
+  }
+
+  return blockNumber;
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                        constructors & destructors
 // -----------------------------------------------------------------------------
@@ -74,6 +144,7 @@ TRI_headers_t::TRI_headers_t ()
     _end(nullptr),
     _nrAllocated(0),
     _nrLinked(0),
+    _nrReserved(0),
     _totalSize(0) {
 
   TRI_InitVectorPointer2(&_blocks, TRI_UNKNOWN_MEM_ZONE, 16);
@@ -113,8 +184,6 @@ void TRI_headers_t::moveBack (TRI_doc_mptr_t* header,
   // we have at least one element in the list
   TRI_ASSERT(_begin != nullptr);
   TRI_ASSERT(_end != nullptr);
-  TRI_ASSERT(header->_prev != header);
-  TRI_ASSERT(header->_next != header);
 
   TRI_ASSERT(old != nullptr);
   TRI_ASSERT(old->getDataPtr() != nullptr);  // ONLY IN HEADERS, PROTECTED by RUNTIME
@@ -128,34 +197,37 @@ void TRI_headers_t::moveBack (TRI_doc_mptr_t* header,
 
   if (_end == header) {
     // header is already at the end
-    TRI_ASSERT(header->_next == nullptr);
+    TRI_ASSERT(header->_next == 0);
     return;
   }
 
   TRI_ASSERT(_begin != _end);
 
+  uint32_t headerSlot = slot(header);
+  TRI_doc_mptr_t* prevHeader = at(header->_prev);
+  TRI_doc_mptr_t* nextHeader = at(header->_next);
+
   // unlink the element
-  if (header->_prev != nullptr) {
-    header->_prev->_next = header->_next;
+  if (prevHeader != nullptr) {
+    prevHeader->_next = header->_next;
   }
-  if (header->_next != nullptr) {
-    header->_next->_prev = header->_prev;
+  if (nextHeader != nullptr) {
+    nextHeader->_prev = header->_prev;
   }
 
   if (_begin == header) {
-    TRI_ASSERT(header->_next != nullptr);
-    _begin = header->_next;
+    TRI_ASSERT(nextHeader != nullptr);
+    _begin = nextHeader;
   }
 
-  header->_prev   = _end;
-  header->_next   = nullptr;
+  header->_prev   = slot(_end);
+  header->_next   = 0;
+  _end->_next     = headerSlot;
   _end            = header;
-  header->_prev->_next = header;
 
   TRI_ASSERT(_begin != nullptr);
   TRI_ASSERT(_end != nullptr);
-  TRI_ASSERT(header->_prev != header);
-  TRI_ASSERT(header->_next != header);
+  TRI_ASSERT(header->_prev != headerSlot);
 
   TRI_ASSERT(_totalSize > 0);
 }
@@ -169,28 +241,29 @@ void TRI_headers_t::unlink (TRI_doc_mptr_t* header) {
 
   TRI_ASSERT(header != nullptr);
   TRI_ASSERT(header->getDataPtr() != nullptr); // ONLY IN HEADERS, PROTECTED by RUNTIME
-  TRI_ASSERT(header->_prev != header);
-  TRI_ASSERT(header->_next != header);
 
   size = (int64_t) ((TRI_df_marker_t*) header->getDataPtr())->_size; // ONLY IN HEADERS, PROTECTED by RUNTIME
   TRI_ASSERT(size > 0);
 
+  TRI_doc_mptr_t* prevHeader = at(header->_prev);
+  TRI_doc_mptr_t* nextHeader = at(header->_next);
+
   // unlink the header
-  if (header->_prev != nullptr) {
-    header->_prev->_next = header->_next;
+  if (prevHeader != nullptr) {
+    prevHeader->_next = header->_next;
   }
 
-  if (header->_next != nullptr) {
-    header->_next->_prev = header->_prev;
+  if (nextHeader != nullptr) {
+    nextHeader->_prev = header->_prev;
   }
 
   // adjust begin & end pointers
   if (_begin == header) {
-    _begin = header->_next;
+    _begin = nextHeader;
   }
 
   if (_end == header) {
-    _end = header->_prev;
+    _end = prevHeader;
   }
 
   TRI_ASSERT(_begin != header);
@@ -210,9 +283,6 @@ void TRI_headers_t::unlink (TRI_doc_mptr_t* header) {
     TRI_ASSERT(_end != nullptr);
     TRI_ASSERT(_totalSize > 0);
   }
-
-  TRI_ASSERT(header->_prev != header);
-  TRI_ASSERT(header->_next != header);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -227,8 +297,6 @@ void TRI_headers_t::move (TRI_doc_mptr_t* header,
   }
 
   TRI_ASSERT(_nrAllocated > 0);
-  TRI_ASSERT(header->_prev != header);
-  TRI_ASSERT(header->_next != header);
   TRI_ASSERT(header->getDataPtr() != nullptr); // ONLY IN HEADERS, PROTECTED by RUNTIME
   TRI_ASSERT(((TRI_df_marker_t*) header->getDataPtr())->_size > 0); // ONLY IN HEADERS, PROTECTED by RUNTIME
   TRI_ASSERT(old != nullptr);
@@ -244,46 +312,27 @@ void TRI_headers_t::move (TRI_doc_mptr_t* header,
   _totalSize -= (  TRI_DF_ALIGN_BLOCK(newSize)
                  - TRI_DF_ALIGN_BLOCK(oldSize));
 
-  // adjust list start and end pointers
-  if (old->_prev == nullptr) {
-    _begin = header;
-  }
-  else if (_begin == header) {
-    if (old->_prev != nullptr) {
-      _begin = old->_prev;
-    }
-  }
-
-  if (old->_next == nullptr) {
-    _end = header;
-  }
-  else if (_end == header) {
-    if (old->_next != nullptr) {
-      _end = old->_next;
-    }
-  }
+  TRI_doc_mptr_t* prevHeader = at(header->_prev);
+  TRI_doc_mptr_t* nextHeader = at(header->_next);
 
-  if (header->_prev != nullptr) {
-    header->_prev->_next = header->_next;
+  // unlink the header from its current position. the list end must become
+  // the current predecessor of the header, which is not necessarily its old
+  // successor
+  if (prevHeader != nullptr) {
+    prevHeader->_next = header->_next;
   }
-  if (header->_next != nullptr) {
-    header->_next->_prev = header->_prev;
+  else {
+    _begin = nextHeader;
   }
 
-  if (old->_prev != nullptr) {
-    old->_prev->_next = header;
+  if (nextHeader != nullptr) {
+    nextHeader->_prev = header->_prev;
   }
-  if (old->_next != nullptr) {
-    old->_next->_prev = header;
+  else {
+    _end = prevHeader;
   }
 
-  header->_prev = old->_prev;
-  header->_next = old->_next;
-
-  TRI_ASSERT(_begin != nullptr);
-  TRI_ASSERT(_end != nullptr);
-  TRI_ASSERT(header->_prev != header);
-  TRI_ASSERT(header->_next != header);
+  this->link(header, old);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -304,14 +353,19 @@ void TRI_headers_t::relink (TRI_doc_mptr_t* header,
 
   TRI_ASSERT(_begin != header);
   TRI_ASSERT(_end != header);
+  TRI_ASSERT(old != nullptr);
+  TRI_ASSERT(old->getDataPtr() != nullptr); // ONLY IN HEADERS, PROTECTED by RUNTIME
+
+  int64_t newSize = (int64_t) (((TRI_df_marker_t*) header->getDataPtr())->_size); // ONLY IN HEADERS, PROTECTED by RUNTIME
+  int64_t oldSize = (int64_t) (((TRI_df_marker_t*) old->getDataPtr())->_size); // ONLY IN HEADERS, PROTECTED by RUNTIME
 
-  this->move(header, old);
+  _totalSize -= (  TRI_DF_ALIGN_BLOCK(newSize)
+                 - TRI_DF_ALIGN_BLOCK(oldSize));
+
+  this->link(header, old);
   _nrLinked++;
   _totalSize += TRI_DF_ALIGN_BLOCK(size);
   TRI_ASSERT(_totalSize > 0);
-
-  TRI_ASSERT(header->_prev != header);
-  TRI_ASSERT(header->_next != header);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -324,14 +378,23 @@ TRI_doc_mptr_t* TRI_headers_t::request (size_t size) {
   TRI_ASSERT(size > 0);
 
   if (_freelist == nullptr) {
-    size_t blockSize = GetBlockSize(_blocks._length);
+    size_t blockNumber = _blocks._length;
+    size_t blockSize = GetBlockSize(blockNumber);
     TRI_ASSERT(blockSize > 0);
 
-    TRI_doc_mptr_t* begin;
+    // slots are 32 bit numbers, and slot 0 is not used
+    if (GetBlockStart(blockNumber) + blockSize >= (size_t) UINT32_MAX) {
+      TRI_set_errno(TRI_ERROR_OUT_OF_MEMORY);
+      return nullptr;
+    }
+
+    TRI_doc_mptr_t* begin = nullptr;
     try {
       begin = new TRI_doc_mptr_t[blockSize];
+      _blockAddresses.reserve(blockNumber + 1);
     }
     catch (std::exception&) {
+      delete[] begin;
       begin = nullptr;
     }
 
@@ -341,6 +404,9 @@ TRI_doc_mptr_t* TRI_headers_t::request (size_t size) {
       return nullptr;
     }
 
+    auto entry = std::make_pair(static_cast<TRI_doc_mptr_t const*>(begin), blockNumber);
+    _blockAddresses.insert(std::upper_bound(_blockAddresses.begin(), _blockAddresses.end(), entry), entry);
+
     TRI_doc_mptr_t* ptr = begin + (blockSize - 1);
 
     header = nullptr;
@@ -351,6 +417,7 @@ TRI_doc_mptr_t* TRI_headers_t::request (size_t size) {
     }
 
     _freelist = header;
+    _nrReserved += blockSize;
 
     TRI_PushBackVectorPointer(&_blocks, begin);
   }
@@ -372,8 +439,8 @@ TRI_doc_mptr_t* TRI_headers_t::request (size_t size) {
     _begin = result;
     _end   = result;
 
-    result->_prev   = nullptr;
-    result->_next   = nullptr;
+    result->_prev   = 0;
+    result->_next   = 0;
   }
   else {
     // list is not empty
@@ -383,9 +450,9 @@ TRI_doc_mptr_t* TRI_headers_t::request (size_t size) {
     TRI_ASSERT(_begin != nullptr);
     TRI_ASSERT(_end != nullptr);
 
-    _end->_next   = result;
-    result->_prev = _end;
-    result->_next = nullptr;
+    _end->_next   = slot(result);
+    result->_prev = slot(_end);
+    result->_next = 0;
     _end          = result;
   }
 
@@ -431,7 +498,9 @@ void TRI_headers_t::release (TRI_doc_mptr_t* header,
 
     // set length to 0
     _blocks._length = 0;
+    _blockAddresses.clear();
     _freelist = nullptr;
+    _nrReserved = 0;
     _begin = nullptr;
     _end = nullptr;
   }
@@ -451,6 +520,74 @@ void TRI_headers_t::adjustTotalSize (int64_t oldSize,
                  - TRI_DF_ALIGN_BLOCK(newSize));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the memory allocated for headers
+////////////////////////////////////////////////////////////////////////////////
+
+size_t TRI_headers_t::memory () const {
+  return _nrReserved * sizeof(TRI_doc_mptr_t);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the element following a linked header in the list
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_doc_mptr_t* TRI_headers_t::next (TRI_doc_mptr_t const* header) const {
+  return at(header->_next);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the element preceding a linked header in the list
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_doc_mptr_t* TRI_headers_t::prev (TRI_doc_mptr_t const* header) const {
+  return at(header->_prev);
+}
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the header in a slot
+////////////////////////////////////////////////////////////////////////////////
+
+TRI_doc_mptr_t* TRI_headers_t::at (uint32_t number) const {
+  if (number == 0) {
+    return nullptr;
+  }
+
+  size_t index = (size_t) number - 1;
+  size_t blockNumber = GetBlockNumber(index);
+  TRI_ASSERT(blockNumber < _blocks._length);
+
+  return static_cast<TRI_doc_mptr_t*>(_blocks._buffer[blockNumber]) + (index - GetBlockStart(blockNumber));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the slot of a header
+///
+/// the block of the header is looked up by its address, so this is
+/// logarithmic in the number of blocks
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TRI_headers_t::slot (TRI_doc_mptr_t const* header) const {
+  TRI_ASSERT(header != nullptr);
+
+  auto it = std::upper_bound(_blockAddresses.begin(), _blockAddresses.end(), header,
+    [] (TRI_doc_mptr_t const* address, std::pair<TRI_doc_mptr_t const*, size_t> const& block) {
+      return address < block.first;
+    });
+
+  TRI_ASSERT(it != _blockAddresses.begin());
+  --it;
+
+  size_t offset = (size_t) (header - (*it).first);
+  TRI_ASSERT(offset < GetBlockSize((*it).second));
+
+  return (uint32_t) (GetBlockStart((*it).second) + offset + 1);
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                       END-OF-FILE
 // -----------------------------------------------------------------------------
@@ -133,6 +133,22 @@ class TRI_headers_t {
       return _end;
     }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the element following a linked header in the list
+///
+/// note: the element returned might be nullptr
+////////////////////////////////////////////////////////////////////////////////
+
+    struct TRI_doc_mptr_t* next (struct TRI_doc_mptr_t const*) const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the element preceding a linked header in the list
+///
+/// note: the element returned might be nullptr
+////////////////////////////////////////////////////////////////////////////////
+
+    struct TRI_doc_mptr_t* prev (struct TRI_doc_mptr_t const*) const;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return the number of active headers
 ////////////////////////////////////////////////////////////////////////////////
@@ -149,6 +165,36 @@ class TRI_headers_t {
       return _totalSize;
     }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the memory allocated for headers
+////////////////////////////////////////////////////////////////////////////////
+
+    size_t memory () const;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+  private:
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief link an unlinked header at its original position
+////////////////////////////////////////////////////////////////////////////////
+
+    void link (struct TRI_doc_mptr_t*, struct TRI_doc_mptr_t const*);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the header in a slot, nullptr for slot 0
+////////////////////////////////////////////////////////////////////////////////
+
+    struct TRI_doc_mptr_t* at (uint32_t) const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the slot of a header
+////////////////////////////////////////////////////////////////////////////////
+
+    uint32_t slot (struct TRI_doc_mptr_t const*) const;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
 // -----------------------------------------------------------------------------
@@ -161,9 +207,13 @@ class TRI_headers_t {
     TRI_doc_mptr_t*        _end;         // end pointer to list of allocated headers
     size_t                 _nrAllocated; // number of allocated headers
     size_t                 _nrLinked;    // number of linked headers
+    size_t                 _nrReserved;  // number of headers in all blocks
     int64_t                _totalSize;   // total size of markers for linked headers
 
     TRI_vector_pointer_t   _blocks;
+
+    // the blocks, sorted by their start addresses, with their numbers
+    std::vector<std::pair<TRI_doc_mptr_t const*, size_t>> _blockAddresses;
 };
 
 #endif
@@ -294,6 +294,14 @@ int TraditionalKeyGenerator::validate (std::string const& key,
 void TraditionalKeyGenerator::track (TRI_voc_key_t) {
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a key that restores the tracking state
+////////////////////////////////////////////////////////////////////////////////
+
+std::string TraditionalKeyGenerator::trackedKey () const {
+  return "";
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief create a JSON representation of the generator
 ////////////////////////////////////////////////////////////////////////////////
@@ -445,6 +453,18 @@ void AutoIncrementKeyGenerator::track (TRI_voc_key_t key) {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a key that restores the tracking state
+////////////////////////////////////////////////////////////////////////////////
+
+std::string AutoIncrementKeyGenerator::trackedKey () const {
+  if (_lastValue == 0) {
+    return "";
+  }
+
+  return std::to_string(_lastValue);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief create a JSON representation of the generator
 ////////////////////////////////////////////////////////////////////////////////
@@ -140,6 +140,13 @@ class KeyGenerator {
 
     virtual void track (TRI_voc_key_t) = 0;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a key that restores the tracking state when passed to
+/// track(), or an empty string if the generator does not track keys
+////////////////////////////////////////////////////////////////////////////////
+
+    virtual std::string trackedKey () const = 0;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return a JSON representation of the generator
 ////////////////////////////////////////////////////////////////////////////////
@@ -231,6 +238,12 @@ class TraditionalKeyGenerator : public KeyGenerator {
 
     void track (TRI_voc_key_t) override;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a key that restores the tracking state
+////////////////////////////////////////////////////////////////////////////////
+
+    std::string trackedKey () const override;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return the generator name
 ////////////////////////////////////////////////////////////////////////////////
@@ -309,6 +322,12 @@ class AutoIncrementKeyGenerator : public KeyGenerator {
 
     void track (TRI_voc_key_t) override;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a key that restores the tracking state
+////////////////////////////////////////////////////////////////////////////////
+
+    std::string trackedKey () const override;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief return the generator name
 ////////////////////////////////////////////////////////////////////////////////
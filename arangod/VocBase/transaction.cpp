@@ -29,6 +29,9 @@
 
 #include "transaction.h"
 
+#include "Aql/QueryCache.h"
+#include "Basics/ConditionLocker.h"
+#include "Basics/ConditionVariable.h"
 #include "Basics/conversions.h"
 #include "Basics/logging.h"
 #include "Basics/tri-strings.h"
@@ -56,6 +59,27 @@
 // --SECTION--                                                       TRANSACTION
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                     private types
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief state shared between a committing transaction and the sync
+/// callback of its commit marker
+////////////////////////////////////////////////////////////////////////////////
+
+struct CommitSyncState {
+  CommitSyncState ()
+    : condition(),
+      done(false),
+      result(TRI_ERROR_NO_ERROR) {
+  }
+
+  triagens::basics::ConditionVariable condition;
+  bool done;
+  int result;
+};
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private functions
 // -----------------------------------------------------------------------------
@@ -142,6 +166,36 @@ static const char* StatusTransaction (const TRI_transaction_status_e status) {
 }
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invalidate the cached query results for all collections the 
+/// transaction has written to
+////////////////////////////////////////////////////////////////////////////////
+
+static void InvalidateQueryCache (TRI_transaction_t* trx) {
+  auto queryCache = static_cast<triagens::aql::QueryCache*>(trx->_vocbase->_queryCache);
+
+  if (queryCache == nullptr ||
+      queryCache->mode() == triagens::aql::CACHE_ALWAYS_OFF) {
+    return;
+  }
+
+  std::vector<std::string> collections;
+  size_t const n = trx->_collections._length;
+
+  for (size_t i = 0; i < n; ++i) {
+    TRI_transaction_collection_t* trxCollection = static_cast<TRI_transaction_collection_t*>(TRI_AtVectorPointer(&trx->_collections, i));
+
+    if (trxCollection->_accessType == TRI_TRANSACTION_WRITE) {
+      collections.emplace_back(trxCollection->_collection->_name);
+    }
+  }
+
+  // the tick is taken after the transaction has finished, so any query that
+  // was started before will not be able to store its (potentially outdated) 
+  // result in the cache
+  queryCache->invalidate(collections, TRI_NewTickServer());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief free all operations for a transaction
 ////////////////////////////////////////////////////////////////////////////////
@@ -708,11 +762,49 @@ static int WriteAbortMarker (TRI_transaction_t* trx) {
   return res;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief write a commit marker into the WAL. if the transaction requires a
+/// sync, the sync is requested without waiting for it, and syncPending is
+/// set if the callback will receive its result
+////////////////////////////////////////////////////////////////////////////////
+
+static int WriteCommitMarker (TRI_transaction_t* trx,
+                              triagens::wal::Marker const& marker,
+                              TRI_transaction_sync_cb_t const& callback,
+                              bool& syncPending) {
+  if (! trx->_waitForSync) {
+    return GetLogfileManager()->allocateAndWrite(marker, false).errorCode;
+  }
+
+  int res = GetLogfileManager()->allocateAndWrite(marker, callback).errorCode;
+
+  // the callback is only invoked if the marker was written
+  syncPending = (res == TRI_ERROR_NO_ERROR);
+
+  return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief wait until the commit marker of a transaction has been synced
+////////////////////////////////////////////////////////////////////////////////
+
+static int WaitForCommitSync (CommitSyncState* syncState) {
+  CONDITION_LOCKER(guard, syncState->condition);
+
+  while (! syncState->done) {
+    guard.wait();
+  }
+
+  return syncState->result;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief write WAL commit marker
 ////////////////////////////////////////////////////////////////////////////////
 
-static int WriteCommitMarker (TRI_transaction_t* trx) {
+static int WriteCommitMarker (TRI_transaction_t* trx,
+                              TRI_transaction_sync_cb_t const& callback,
+                              bool& syncPending) {
   if (! NeedWriteMarker(trx, false)) {
     return TRI_ERROR_NO_ERROR;
   }
@@ -729,12 +821,12 @@ static int WriteCommitMarker (TRI_transaction_t* trx) {
     if (trx->_externalId > 0) {
       // remotely started trx
       triagens::wal::CommitRemoteTransactionMarker marker(trx->_vocbase->_id, trx->_id, trx->_externalId);
-      res = GetLogfileManager()->allocateAndWrite(marker, false).errorCode;
+      res = WriteCommitMarker(trx, marker, callback, syncPending);
     }
     else {
       // local trx
       triagens::wal::CommitTransactionMarker marker(trx->_vocbase->_id, trx->_id);
-      res = GetLogfileManager()->allocateAndWrite(marker, false).errorCode;
+      res = WriteCommitMarker(trx, marker, callback, syncPending);
     }
   }
   catch (triagens::basics::Exception const& ex) {
@@ -1212,10 +1304,17 @@ int TRI_AddOperationTransaction (triagens::wal::DocumentOperation& operation,
   TRI_ASSERT(fid > 0);
   TRI_ASSERT(position != nullptr);
   
+  // the header is contained in the primary index already. concurrent
+  // lookups must not see it while it is changed
+  auto primaryIndex = document->primaryIndex();
+
   if (operation.type == TRI_VOC_DOCUMENT_OPERATION_INSERT ||
       operation.type == TRI_VOC_DOCUMENT_OPERATION_UPDATE) {
     // adjust the data position in the header
+    primaryIndex->beginWrite();
     operation.header->setDataPtr(position);  // PROTECTED by ongoing trx from operation
+    primaryIndex->endWrite();
+
     if (operation.type == TRI_VOC_DOCUMENT_OPERATION_INSERT && sizeChanged) {
       document->_headersPtr->adjustTotalSize(0, sizeChanged);
     }
@@ -1226,7 +1325,9 @@ int TRI_AddOperationTransaction (triagens::wal::DocumentOperation& operation,
   }
 
   // set header file id
+  primaryIndex->beginWrite();
   operation.header->_fid = fid;
+  primaryIndex->endWrite();
 
   TRI_ASSERT(operation.header->_fid > 0);
 
@@ -1349,14 +1450,55 @@ int TRI_BeginTransaction (TRI_transaction_t* trx,
 
 int TRI_CommitTransaction (TRI_transaction_t* trx,
                            int nestingLevel) {
+  if (nestingLevel > 0 || ! trx->_waitForSync) {
+    // there is no sync to wait for
+    return TRI_CommitTransaction(trx, nestingLevel, [] (int) -> void { });
+  }
+
+  TRI_voc_tid_t const id = trx->_id;
+  auto state = std::make_shared<CommitSyncState>();
+
+  int res = TRI_CommitTransaction(trx, nestingLevel, [state] (int result) -> void {
+    CONDITION_LOCKER(guard, state->condition);
+    state->result = result;
+    state->done = true;
+    guard.broadcast();
+  });
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    return res;
+  }
+
+  // wait for the sync of the commit marker without holding the collection
+  // locks. the transaction is committed already and its changes are visible,
+  // so a failed sync does not make the commit fail
+  res = WaitForCommitSync(state.get());
+
+  if (res != TRI_ERROR_NO_ERROR) {
+    LOG_WARNING("transaction %llu is committed, but its commit marker could not be synced: %s",
+                (unsigned long long) id,
+                TRI_errno_string(res));
+  }
+
+  return TRI_ERROR_NO_ERROR;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief commit a transaction without waiting for the sync of its commit
+/// marker
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_CommitTransaction (TRI_transaction_t* trx,
+                           int nestingLevel,
+                           TRI_transaction_sync_cb_t const& callback) {
   LOG_TRX(trx, nestingLevel, "%s %s transaction", "committing", (trx->_type == TRI_TRANSACTION_READ ? "read" : "write"));
 
   TRI_ASSERT(trx->_status == TRI_TRANSACTION_RUNNING);
 
-  int res = TRI_ERROR_NO_ERROR;
+  bool syncPending = false;
 
   if (nestingLevel == 0) {
-    res = WriteCommitMarker(trx);
+    int res = WriteCommitMarker(trx, callback, syncPending);
 
     if (res != TRI_ERROR_NO_ERROR) {
       TRI_AbortTransaction(trx, nestingLevel);
@@ -1368,11 +1510,19 @@ int TRI_CommitTransaction (TRI_transaction_t* trx,
     UpdateTransactionStatus(trx, TRI_TRANSACTION_COMMITTED);
 
     FreeOperations(trx);
+
+    InvalidateQueryCache(trx);
   }
 
   UnuseCollections(trx, nestingLevel);
 
-  return res;
+  if (! syncPending) {
+    // no sync was requested, or a nested transaction, which is synced with
+    // its outermost transaction
+    callback(TRI_ERROR_NO_ERROR);
+  }
+
+  return TRI_ERROR_NO_ERROR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1393,6 +1543,8 @@ int TRI_AbortTransaction (TRI_transaction_t* trx,
     UpdateTransactionStatus(trx, TRI_TRANSACTION_ABORTED);
 
     FreeOperations(trx);
+
+    InvalidateQueryCache(trx);
   }
 
   UnuseCollections(trx, nestingLevel);
@@ -39,6 +39,8 @@
 #include "VocBase/datafile.h"
 #include "VocBase/voc-types.h"
 
+#include <functional>
+
 namespace triagens {
   namespace arango {
     class DocumentDitch;
@@ -123,6 +125,13 @@ TRI_transaction_status_e;
 
 typedef uint32_t TRI_transaction_hint_t;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief typedef for the callback that receives the result of syncing the
+/// commit marker of a transaction
+////////////////////////////////////////////////////////////////////////////////
+
+typedef std::function<void(int)> TRI_transaction_sync_cb_t;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief hints that can be used for transactions
 ////////////////////////////////////////////////////////////////////////////////
@@ -305,11 +314,33 @@ int TRI_BeginTransaction (TRI_transaction_t*,
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief commit a transaction
+///
+/// if the transaction requires a sync, this waits for the sync of its commit
+/// marker after the collection locks have been released. the transaction is
+/// committed once its commit marker has been written. if the sync fails, the
+/// transaction stays committed and this still returns TRI_ERROR_NO_ERROR. the
+/// failure is logged, and the WAL region is synced again later
 ////////////////////////////////////////////////////////////////////////////////
 
 int TRI_CommitTransaction (TRI_transaction_t*,
                            int);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief commit a transaction without waiting for the sync of its commit
+/// marker
+///
+/// returns the result of the commit. if the transaction was committed, the
+/// callback is invoked exactly once with the result of the sync: right away
+/// with TRI_ERROR_NO_ERROR if the transaction does not require a sync or is
+/// nested, otherwise later by the WAL synchroniser thread, with
+/// TRI_ERROR_ARANGO_MSYNC_FAILED if the sync failed. the callback must not
+/// block, and must not access the transaction, which may be freed already
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_CommitTransaction (TRI_transaction_t*,
+                           int,
+                           TRI_transaction_sync_cb_t const&);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief abort a transaction
 ////////////////////////////////////////////////////////////////////////////////
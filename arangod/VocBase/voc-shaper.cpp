@@ -902,6 +902,47 @@ int TRI_InsertAttributeVocShaper (TRI_shaper_t* s,
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief iterate over the markers of all shapes and attributes
+////////////////////////////////////////////////////////////////////////////////
+
+bool TRI_IterateMarkersVocShaper (TRI_shaper_t* s,
+                                  std::function<bool(TRI_df_marker_t const*)> const& callback) {
+  voc_shaper_t* shaper = (voc_shaper_t*) s;
+
+  {
+    MUTEX_LOCKER(shaper->_shapeLock);
+
+    size_t const n = static_cast<size_t>(shaper->_shapeIds._nrAlloc);
+
+    for (size_t i = 0; i < n; ++i) {
+      char const* shape = static_cast<char const*>(shaper->_shapeIds._table[i]);
+
+      if (shape != nullptr &&
+          ! callback(reinterpret_cast<TRI_df_marker_t const*>(shape - sizeof(TRI_df_shape_marker_t)))) {
+        return false;
+      }
+    }
+  }
+
+  {
+    MUTEX_LOCKER(shaper->_attributeLock);
+
+    size_t const n = static_cast<size_t>(shaper->_attributeIds._nrAlloc);
+
+    for (size_t i = 0; i < n; ++i) {
+      void const* marker = shaper->_attributeIds._table[i];
+
+      if (marker != nullptr &&
+          ! callback(static_cast<TRI_df_marker_t const*>(marker))) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief finds an accessor for a shaper
 ////////////////////////////////////////////////////////////////////////////////
@@ -99,6 +99,18 @@ int TRI_InsertAttributeVocShaper (TRI_shaper_t*,
                                   TRI_df_marker_t const*,
                                   bool);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief iterate over the markers of all shapes and attributes
+///
+/// the callback is called with the marker of each shape and attribute,
+/// assuming the datafile marker layout. the caller must check that the
+/// marker is located in a collection datafile before using it. the iteration
+/// stops if the callback returns false
+////////////////////////////////////////////////////////////////////////////////
+
+bool TRI_IterateMarkersVocShaper (TRI_shaper_t*,
+                                  std::function<bool(TRI_df_marker_t const*)> const&);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief finds an accessor
 ////////////////////////////////////////////////////////////////////////////////
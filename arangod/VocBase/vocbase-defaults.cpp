@@ -47,6 +47,8 @@ void TRI_ApplyVocBaseDefaults (TRI_vocbase_t* vocbase,
   vocbase->_settings.requireAuthenticationUnixSockets = defaults->requireAuthenticationUnixSockets;
   vocbase->_settings.authenticateSystemOnly           = defaults->authenticateSystemOnly;
   vocbase->_settings.forceSyncProperties              = defaults->forceSyncProperties;
+  vocbase->_settings.indexSnapshots                   = defaults->indexSnapshots;
+  vocbase->_settings.prefaultDatafiles                = defaults->prefaultDatafiles;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -66,6 +68,8 @@ TRI_json_t* TRI_JsonVocBaseDefaults (TRI_memory_zone_t* zone,
   TRI_Insert3ObjectJson(zone, json, "requireAuthenticationUnixSockets", TRI_CreateBooleanJson(zone, defaults->requireAuthenticationUnixSockets));
   TRI_Insert3ObjectJson(zone, json, "authenticateSystemOnly", TRI_CreateBooleanJson(zone, defaults->authenticateSystemOnly));
   TRI_Insert3ObjectJson(zone, json, "forceSyncProperties", TRI_CreateBooleanJson(zone, defaults->forceSyncProperties));
+  TRI_Insert3ObjectJson(zone, json, "indexSnapshots", TRI_CreateBooleanJson(zone, defaults->indexSnapshots));
+  TRI_Insert3ObjectJson(zone, json, "prefaultDatafiles", TRI_CreateBooleanJson(zone, defaults->prefaultDatafiles));
   TRI_Insert3ObjectJson(zone, json, "defaultMaximalSize", TRI_CreateNumberJson(zone, (double) defaults->defaultMaximalSize));
 
   return json;
@@ -112,6 +116,18 @@ void TRI_FromJsonVocBaseDefaults (TRI_vocbase_defaults_t* defaults,
     defaults->forceSyncProperties = optionJson->_value._boolean;
   }
 
+  optionJson = TRI_LookupObjectJson(json, "indexSnapshots");
+
+  if (TRI_IsBooleanJson(optionJson)) {
+    defaults->indexSnapshots = optionJson->_value._boolean;
+  }
+
+  optionJson = TRI_LookupObjectJson(json, "prefaultDatafiles");
+
+  if (TRI_IsBooleanJson(optionJson)) {
+    defaults->prefaultDatafiles = optionJson->_value._boolean;
+  }
+
   optionJson = TRI_LookupObjectJson(json, "defaultMaximalSize");
 
   if (TRI_IsNumberJson(optionJson)) {
@@ -51,6 +51,8 @@ typedef struct TRI_vocbase_defaults_s {
   bool              requireAuthenticationUnixSockets;
   bool              authenticateSystemOnly;
   bool              forceSyncProperties;
+  bool              indexSnapshots;
+  bool              prefaultDatafiles;
 }
 TRI_vocbase_defaults_t;
 
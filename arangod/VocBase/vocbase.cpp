@@ -35,6 +35,8 @@
 
 #include <regex.h>
 
+#include "Aql/PlanCache.h"
+#include "Aql/QueryCache.h"
 #include "Aql/QueryList.h"
 #include "Basics/conversions.h"
 #include "Basics/files.h"
@@ -223,6 +225,12 @@ static bool UnregisterCollection (TRI_vocbase_t* vocbase,
 
   TRI_WRITE_UNLOCK_COLLECTIONS_VOCBASE(vocbase);
 
+  // cached query results and plans for the collection must not survive a 
+  // re-creation of a collection with the same name
+  TRI_voc_tick_t const tick = TRI_NewTickServer();
+  static_cast<triagens::aql::QueryCache*>(vocbase->_queryCache)->invalidate(std::string(collection->_name), tick);
+  static_cast<triagens::aql::PlanCache*>(vocbase->_planCache)->invalidate(std::string(collection->_name), tick);
+
   return true;
 }
 
@@ -1376,6 +1384,8 @@ TRI_vocbase_t* TRI_CreateInitialVocBase (TRI_server_t* server,
   vocbase->_userStructures     = nullptr;
   vocbase->_cursorRepository   = nullptr;
   vocbase->_queries            = nullptr;
+  vocbase->_queryCache         = nullptr;
+  vocbase->_planCache          = nullptr;
   vocbase->_oldTransactions    = nullptr;
 
   try {
@@ -1390,10 +1400,39 @@ TRI_vocbase_t* TRI_CreateInitialVocBase (TRI_server_t* server,
     return nullptr;
   }
 
+  try {
+    vocbase->_queryCache       = new triagens::aql::QueryCache(vocbase);
+  }
+  catch (...) {
+    delete static_cast<triagens::aql::QueryList*>(vocbase->_queries);
+    TRI_Free(TRI_CORE_MEM_ZONE, vocbase->_name);
+    TRI_Free(TRI_CORE_MEM_ZONE, vocbase->_path);
+    TRI_Free(TRI_UNKNOWN_MEM_ZONE, vocbase);
+    TRI_set_errno(TRI_ERROR_OUT_OF_MEMORY);
+    
+    return nullptr;
+  }
+
+  try {
+    vocbase->_planCache        = new triagens::aql::PlanCache(vocbase);
+  }
+  catch (...) {
+    delete static_cast<triagens::aql::QueryCache*>(vocbase->_queryCache);
+    delete static_cast<triagens::aql::QueryList*>(vocbase->_queries);
+    TRI_Free(TRI_CORE_MEM_ZONE, vocbase->_name);
+    TRI_Free(TRI_CORE_MEM_ZONE, vocbase->_path);
+    TRI_Free(TRI_UNKNOWN_MEM_ZONE, vocbase);
+    TRI_set_errno(TRI_ERROR_OUT_OF_MEMORY);
+    
+    return nullptr;
+  }
+
   try {
     vocbase->_cursorRepository = new triagens::arango::CursorRepository(vocbase);
   }
   catch (...) {
+    delete static_cast<triagens::aql::PlanCache*>(vocbase->_planCache);
+    delete static_cast<triagens::aql::QueryCache*>(vocbase->_queryCache);
     delete static_cast<triagens::aql::QueryList*>(vocbase->_queries);
     TRI_Free(TRI_CORE_MEM_ZONE, vocbase->_name);
     TRI_Free(TRI_CORE_MEM_ZONE, vocbase->_path);
@@ -1478,6 +1517,8 @@ void TRI_DestroyInitialVocBase (TRI_vocbase_t* vocbase) {
   TRI_DestroySpin(&vocbase->_usage._lock);
   
   delete static_cast<triagens::arango::CursorRepository*>(vocbase->_cursorRepository);
+  delete static_cast<triagens::aql::PlanCache*>(vocbase->_planCache);
+  delete static_cast<triagens::aql::QueryCache*>(vocbase->_queryCache);
   delete static_cast<triagens::aql::QueryList*>(vocbase->_queries);
 
   // free name and path
@@ -2290,6 +2331,17 @@ int TRI_RenameCollectionVocBase (TRI_vocbase_t* vocbase,
 
   TRI_ReadUnlockReadWriteLock(&vocbase->_inventoryLock);
 
+  if (res == TRI_ERROR_NO_ERROR) {
+    // cached query results and plans refer to collections by name
+    TRI_voc_tick_t const tick = TRI_NewTickServer();
+    std::vector<std::string> const names({ std::string(oldName), std::string(newName) });
+    static_cast<triagens::aql::QueryCache*>(vocbase->_queryCache)->invalidate(names, tick);
+
+    auto planCache = static_cast<triagens::aql::PlanCache*>(vocbase->_planCache);
+    planCache->invalidate(names[0], tick);
+    planCache->invalidate(names[1], tick);
+  }
+
   TRI_FreeString(TRI_CORE_MEM_ZONE, oldName);
 
   return res;
@@ -313,6 +313,8 @@ typedef struct TRI_vocbase_s {
   // structures for user-defined volatile data
   void*                      _userStructures;
   void*                      _queries;
+  void*                      _queryCache;
+  void*                      _planCache;
   void*                      _cursorRepository;
 
   TRI_associative_pointer_t  _authInfo;
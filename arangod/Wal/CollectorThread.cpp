@@ -30,6 +30,7 @@
 #include "CollectorThread.h"
 
 #include "Basics/MutexLocker.h"
+#include "Basics/ThreadPool.h"
 #include "Basics/hashes.h"
 #include "Basics/logging.h"
 #include "Basics/ConditionLocker.h"
@@ -282,18 +283,26 @@ uint64_t const CollectorThread::Interval = 1000000;
 ////////////////////////////////////////////////////////////////////////////////
 
 CollectorThread::CollectorThread (LogfileManager* logfileManager,
-                                  TRI_server_t* server)
+                                  TRI_server_t* server,
+                                  uint32_t numThreads)
   : Thread("WalCollector"),
     _logfileManager(logfileManager),
     _server(server),
+    _workers(nullptr),
     _condition(),
     _operationsQueueLock(),
     _operationsQueue(),
     _operationsQueueInUse(false),
+    _collectedCollections(),
     _stop(0),
     _numPendingOperations(0) {
 
   allowAsynchronousCancelation();
+
+  if (numThreads > 1) {
+    // the collector thread itself is the first worker
+    _workers = new triagens::basics::ThreadPool(static_cast<size_t>(numThreads - 1), "WalCollectorWorker");
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -301,6 +310,9 @@ CollectorThread::CollectorThread (LogfileManager* logfileManager,
 ////////////////////////////////////////////////////////////////////////////////
 
 CollectorThread::~CollectorThread () {
+  if (_workers != nullptr) {
+    delete _workers;
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -456,74 +468,21 @@ bool CollectorThread::processQueuedOperations () {
 
   // go on without the mutex!
 
-  // process operations for each collection
-  for (auto it = _operationsQueue.begin(); it != _operationsQueue.end(); ++it) {
-    auto& operations = (*it).second;
-    TRI_ASSERT(! operations.empty());
-
-    for (auto it2 = operations.begin(); it2 != operations.end(); /* no hoisting */ ) {
-      Logfile* logfile = (*it2)->logfile;
-
-      int res = TRI_ERROR_INTERNAL;
-
-      try {
-        res = processCollectionOperations((*it2));
-      }
-      catch (triagens::basics::Exception const& ex) {
-        res = ex.code();
-      }
-
-      if (res == TRI_ERROR_LOCK_TIMEOUT) {
-        // could not acquire write-lock for collection in time
-        // do not delete the operations
-        ++it2;
-        continue;
-      }
-
-      if (res == TRI_ERROR_NO_ERROR) {
-        LOG_TRACE("queued operations applied successfully");
-      }
-      else if (res == TRI_ERROR_ARANGO_DATABASE_NOT_FOUND ||
-               res == TRI_ERROR_ARANGO_COLLECTION_NOT_FOUND) {
-        // these are expected errors
-        LOG_TRACE("removing queued operations for already deleted collection");
-        res = TRI_ERROR_NO_ERROR;
-      }
-      else {
-        LOG_WARNING("got unexpected error code while applying queued operations: %s", TRI_errno_string(res));
-      }
+  // process operations for each collection. the collections are independent
+  // of each other, so they can be handled by different workers. the operations
+  // of a single collection are always processed by one worker, in order
+  std::vector<std::vector<CollectorCache*>*> queues;
+  queues.reserve(_operationsQueue.size());
 
-      if (res == TRI_ERROR_NO_ERROR) {
-        uint64_t numOperations = (*it2)->operations->size();
-        uint64_t maxNumPendingOperations = _logfileManager->throttleWhenPending();
-
-        if (maxNumPendingOperations > 0 && 
-            _numPendingOperations >= maxNumPendingOperations &&
-            (_numPendingOperations - numOperations) < maxNumPendingOperations) {
-          // write-throttling was active, but can be turned off now
-          _logfileManager->deactivateWriteThrottling();
-          LOG_INFO("deactivating write-throttling");
-        }
-
-        _numPendingOperations -= numOperations;
-
-        // delete the object
-        delete (*it2);
-
-        // delete the element from the vector while iterating over the vector
-        it2 = operations.erase(it2);
-
-        _logfileManager->decreaseCollectQueueSize(logfile);
-      }
-      else {
-        // do not delete the object but advance in the operations vector
-        ++it2;
-      }
-    }
-
-    // next collection
+  for (auto it = _operationsQueue.begin(); it != _operationsQueue.end(); ++it) {
+    TRI_ASSERT(! (*it).second.empty());
+    queues.emplace_back(&((*it).second));
   }
 
+  parallelFor(queues.size(), [this, &queues] (size_t i) -> void {
+    processQueuedCollection(*queues[i]);
+  });
+
   // finally remove all entries from the map with empty vectors
   {
     MUTEX_LOCKER(_operationsQueueLock);
@@ -544,6 +503,90 @@ bool CollectorThread::processQueuedOperations () {
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief process the queued operations of a single collection, in order
+////////////////////////////////////////////////////////////////////////////////
+
+void CollectorThread::processQueuedCollection (std::vector<CollectorCache*>& operations) {
+  for (auto it = operations.begin(); it != operations.end(); /* no hoisting */ ) {
+    Logfile* logfile = (*it)->logfile;
+
+    int res = TRI_ERROR_INTERNAL;
+
+    try {
+      res = processCollectionOperations((*it));
+    }
+    catch (triagens::basics::Exception const& ex) {
+      res = ex.code();
+    }
+    catch (...) {
+      res = TRI_ERROR_INTERNAL;
+    }
+
+    if (res == TRI_ERROR_LOCK_TIMEOUT) {
+      // could not acquire write-lock for collection in time
+      // do not delete the operations, and do not process any later
+      // operations of the collection before these
+      break;
+    }
+
+    if (res == TRI_ERROR_NO_ERROR) {
+      LOG_TRACE("queued operations applied successfully");
+    }
+    else if (res == TRI_ERROR_ARANGO_DATABASE_NOT_FOUND ||
+             res == TRI_ERROR_ARANGO_COLLECTION_NOT_FOUND) {
+      // these are expected errors
+      LOG_TRACE("removing queued operations for already deleted collection");
+      res = TRI_ERROR_NO_ERROR;
+    }
+    else {
+      LOG_WARNING("got unexpected error code while applying queued operations: %s", TRI_errno_string(res));
+    }
+
+    if (res == TRI_ERROR_NO_ERROR) {
+      uint64_t numOperations = (*it)->operations->size();
+      uint64_t maxNumPendingOperations = _logfileManager->throttleWhenPending();
+      uint64_t numPendingOperations = _numPendingOperations.fetch_sub(numOperations);
+
+      if (maxNumPendingOperations > 0 && 
+          numPendingOperations >= maxNumPendingOperations &&
+          (numPendingOperations - numOperations) < maxNumPendingOperations) {
+        // write-throttling was active, but can be turned off now
+        _logfileManager->deactivateWriteThrottling();
+        LOG_INFO("deactivating write-throttling");
+      }
+
+      // delete the object
+      delete (*it);
+
+      // delete the element from the vector while iterating over the vector
+      it = operations.erase(it);
+
+      _logfileManager->decreaseCollectQueueSize(logfile);
+    }
+    else {
+      // do not delete the object but advance in the operations vector
+      ++it;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute work items, spread over the collector workers
+////////////////////////////////////////////////////////////////////////////////
+
+void CollectorThread::parallelFor (size_t count,
+                                   std::function<void(size_t)> const& work) {
+  if (_workers == nullptr || count < 2) {
+    for (size_t i = 0; i < count; ++i) {
+      work(i);
+    }
+    return;
+  }
+
+  _workers->parallelFor(count, work);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief check whether there are queued operations left
 ////////////////////////////////////////////////////////////////////////////////
@@ -604,8 +647,6 @@ int CollectorThread::processCollectionOperations (CollectorCache* cache) {
     // now we have the write lock on the collection
     LOG_TRACE("wal collector processing operations for collection '%s'", document->_info._name);
 
-    TRI_ASSERT(! cache->operations->empty());
-
     auto primaryIndex = document->primaryIndex();
 
     for (auto it = cache->operations->begin(); it != cache->operations->end(); ++it) {
@@ -639,8 +680,10 @@ int CollectorThread::processCollectionOperations (CollectorCache* cache) {
                                                   TRI_DF_ALIGN_BLOCK(datafileMarkerSize));
 
           // we can safely update the master pointer's dataptr value
+          primaryIndex->beginWrite();
           found->setDataPtr(static_cast<void*>(const_cast<char*>(operation.datafilePosition)));
           found->_fid = fid;
+          primaryIndex->endWrite();
         }
       }
       else if (walMarker->_type == TRI_WAL_MARKER_EDGE) {
@@ -663,8 +706,10 @@ int CollectorThread::processCollectionOperations (CollectorCache* cache) {
                                                   TRI_DF_ALIGN_BLOCK(datafileMarkerSize));
 
           // we can safely update the master pointer's dataptr value
+          primaryIndex->beginWrite();
           found->setDataPtr(static_cast<void*>(const_cast<char*>(operation.datafilePosition)));
           found->_fid = fid;
+          primaryIndex->endWrite();
         }
       }
       else if (walMarker->_type == TRI_WAL_MARKER_REMOVE) {
@@ -775,60 +820,59 @@ int CollectorThread::collect (Logfile* logfile) {
     }
   }
 
-  // now for each collection, write all surviving markers into collection datafiles
-  for (auto it = collectionIds.begin(); it != collectionIds.end(); ++it) {
-    auto cid = (*it);
-
-    OperationsType sortedOperations;
+  // now for each collection, write all surviving markers into collection datafiles.
+  // the collections are independent of each other, so they can be handled by
+  // different workers. the logfile is only marked as collected when all of
+  // them are done
+  std::vector<TRI_voc_cid_t> cids(collectionIds.begin(), collectionIds.end());
+  std::vector<int> results(cids.size(), TRI_ERROR_NO_ERROR);
 
-    // insert structural operations - those are already sorted by tick
-    if (state.structuralOperations.find(cid) != state.structuralOperations.end()) {
-      OperationsType const& ops = state.structuralOperations[cid];
+  // collections that have been collected completely by an earlier, failed
+  // attempt to collect this logfile must not be handled again
+  auto& collected = _collectedCollections[logfile->id()];
 
-      sortedOperations.insert(sortedOperations.begin(), ops.begin(), ops.end());
-      TRI_ASSERT_EXPENSIVE(sortedOperations.size() == ops.size());
+  parallelFor(cids.size(), [this, logfile, &state, &cids, &results, &collected] (size_t i) -> void {
+    if (collected.find(cids[i]) != collected.end()) {
+      return;
     }
 
-    // insert document operations - those are sorted by key, not by tick
-    if (state.documentOperations.find(cid) != state.documentOperations.end()) {
-      DocumentOperationsType const& ops = state.documentOperations[cid];
+    int res = TRI_ERROR_INTERNAL;
 
+    try {
+      res = collectCollection(logfile, &state, cids[i]);
+    }
+    catch (triagens::basics::Exception const& ex) {
+      res = ex.code();
+    }
+    catch (...) {
+      res = TRI_ERROR_INTERNAL;
+    }
 
-      for (auto it2 = ops.begin(); it2 != ops.end(); ++it2) {
-        sortedOperations.push_back((*it2).second);
-      }
+    results[i] = res;
+  });
 
-      // sort vector by marker tick
-      std::sort(sortedOperations.begin(), sortedOperations.end(), [] (TRI_df_marker_t const* left, TRI_df_marker_t const* right) {
-        return (left->_tick < right->_tick);
-      });
+  for (size_t i = 0; i < cids.size(); ++i) {
+    if (results[i] == TRI_ERROR_NO_ERROR) {
+      collected.insert(cids[i]);
     }
+  }
 
-    if (! sortedOperations.empty()) {
-      int res = TRI_ERROR_INTERNAL;
-
-      try {
-        res = transferMarkers(logfile, cid, state.collections[cid], state.operationsCount[cid], sortedOperations);
-      }
-      catch (triagens::basics::Exception const& ex) {
-        res = ex.code();
-      }
-      catch (...) {
-        res = TRI_ERROR_INTERNAL;
-      }
+  for (auto it = results.begin(); it != results.end(); ++it) {
+    int res = (*it);
 
-      if (res != TRI_ERROR_NO_ERROR &&
-          res != TRI_ERROR_ARANGO_DATABASE_NOT_FOUND &&
-          res != TRI_ERROR_ARANGO_COLLECTION_NOT_FOUND) {
-        LOG_WARNING("got unexpected error in CollectorThread::collect: %s", TRI_errno_string(res));
-        // abort early
-        return res;
-      }
+    if (res != TRI_ERROR_NO_ERROR &&
+        res != TRI_ERROR_ARANGO_DATABASE_NOT_FOUND &&
+        res != TRI_ERROR_ARANGO_COLLECTION_NOT_FOUND) {
+      LOG_WARNING("got unexpected error in CollectorThread::collect: %s", TRI_errno_string(res));
+      // abort early
+      return res;
     }
   }
 
   // TODO: what to do if an error has occurred?
 
+  _collectedCollections.erase(logfile->id());
+
   // remove all handled transactions from failedTransactions list
   if (! state.handledTransactions.empty()) {
     _logfileManager->unregisterFailedTransactions(state.handledTransactions);
@@ -837,6 +881,58 @@ int CollectorThread::collect (Logfile* logfile) {
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief transfer the surviving markers of one collection from a logfile
+////////////////////////////////////////////////////////////////////////////////
+
+int CollectorThread::collectCollection (Logfile* logfile,
+                                        CollectorState const* state,
+                                        TRI_voc_cid_t cid) {
+  OperationsType sortedOperations;
+
+  // insert structural operations - those are already sorted by tick
+  auto it = state->structuralOperations.find(cid);
+
+  if (it != state->structuralOperations.end()) {
+    OperationsType const& ops = (*it).second;
+
+    sortedOperations.insert(sortedOperations.begin(), ops.begin(), ops.end());
+    TRI_ASSERT_EXPENSIVE(sortedOperations.size() == ops.size());
+  }
+
+  // insert document operations - those are sorted by key, not by tick
+  auto it2 = state->documentOperations.find(cid);
+
+  if (it2 != state->documentOperations.end()) {
+    DocumentOperationsType const& ops = (*it2).second;
+
+    for (auto it3 = ops.begin(); it3 != ops.end(); ++it3) {
+      sortedOperations.push_back((*it3).second);
+    }
+
+    // sort vector by marker tick
+    std::sort(sortedOperations.begin(), sortedOperations.end(), [] (TRI_df_marker_t const* left, TRI_df_marker_t const* right) {
+      return (left->_tick < right->_tick);
+    });
+  }
+
+  if (sortedOperations.empty()) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  // the collection is known, otherwise it would have been ignored
+  TRI_voc_tick_t const databaseId = state->collections.find(cid)->second;
+
+  int64_t totalOperationsCount = 0;
+  auto it4 = state->operationsCount.find(cid);
+
+  if (it4 != state->operationsCount.end()) {
+    totalOperationsCount = (*it4).second;
+  }
+
+  return transferMarkers(logfile, cid, databaseId, totalOperationsCount, sortedOperations);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief transfer markers into a collection
 ////////////////////////////////////////////////////////////////////////////////
@@ -875,25 +971,42 @@ int CollectorThread::transferMarkers (Logfile* logfile,
 
   try {
     res = executeTransferMarkers(document, cache, operations);
+  }
+  catch (triagens::basics::Exception const& ex) {
+    res = ex.code();
+  }
+  catch (...) {
+    res = TRI_ERROR_INTERNAL;
+  }
 
-    if (res == TRI_ERROR_NO_ERROR && ! cache->operations->empty()) {
-      // now sync the datafile
-      res = syncDatafileCollection(document);
+  // if the logfile is collected again after an error, all markers that are
+  // already in the datafiles are skipped, so a retry never writes a marker
+  // twice. the operations for these markers must therefore be queued now,
+  // even if the transfer has failed later on, and the datafiles must be
+  // synced even if this run has not written any new markers
+  if (res == TRI_ERROR_NO_ERROR) {
+    res = syncDatafileCollection(document);
+  }
 
-      if (res != TRI_ERROR_NO_ERROR) {
-        THROW_ARANGO_EXCEPTION(res);
-      }
+  if (res != TRI_ERROR_NO_ERROR) {
+    // the collection's uncollected operations are only accounted for by the
+    // run that completes the transfer
+    cache->totalOperationsCount = 0;
+  }
 
+  if (! cache->operations->empty() || cache->totalOperationsCount > 0) {
+    try {
       // note: cache is passed by reference and can be modified by queueOperations
       // (i.e. set to nullptr!)
       queueOperations(logfile, cache);
     }
-  }
-  catch (triagens::basics::Exception const& ex) {
-    res = ex.code();
-  }
-  catch (...) {
-    res = TRI_ERROR_INTERNAL;
+    catch (...) {
+      LOG_ERROR("unable to queue WAL collector operations for '%s'", document->_info._name);
+
+      if (res == TRI_ERROR_NO_ERROR) {
+        res = TRI_ERROR_OUT_OF_MEMORY;
+      }
+    }
   }
 
 
@@ -917,6 +1030,9 @@ int CollectorThread::executeTransferMarkers (TRI_document_collection_t* document
   // used only for crash / recovery tests
   int numMarkers = 0;
 
+  // used only for failure tests
+  int numTransferred = 0;
+
   TRI_voc_tick_t const minTransferTick = document->_tickMax;
   TRI_ASSERT(! operations.empty());
 
@@ -935,6 +1051,13 @@ int CollectorThread::executeTransferMarkers (TRI_document_collection_t* document
       }
     }
 
+    TRI_IF_FAILURE("CollectorThreadTransferError") {
+      if (++numTransferred > 10) {
+        // fail after some markers have been transferred
+        return TRI_ERROR_DEBUG;
+      }
+    }
+
     char const* base = reinterpret_cast<char const*>(source);
 
     switch (source->_type) {
@@ -1120,8 +1243,6 @@ int CollectorThread::queueOperations (triagens::wal::Logfile* logfile,
                                       CollectorCache*& cache) {
   TRI_voc_cid_t cid = cache->collectionId;
   uint64_t maxNumPendingOperations = _logfileManager->throttleWhenPending();
- 
-  TRI_ASSERT(! cache->operations->empty());
 
   while (true) {
     {
@@ -1151,17 +1272,16 @@ int CollectorThread::queueOperations (triagens::wal::Logfile* logfile,
   }
   
   uint64_t numOperations = cache->operations->size();
+  uint64_t numPendingOperations = _numPendingOperations.fetch_add(numOperations);
 
   if (maxNumPendingOperations > 0 && 
-      _numPendingOperations < maxNumPendingOperations &&
-      (_numPendingOperations + numOperations) >= maxNumPendingOperations) {
+      numPendingOperations < maxNumPendingOperations &&
+      (numPendingOperations + numOperations) >= maxNumPendingOperations) {
     // activate write-throttling!
     _logfileManager->activateWriteThrottling();
     LOG_WARNING("queued more than %llu pending WAL collector operations. now activating write-throttling", 
                 (unsigned long long) maxNumPendingOperations);
   }
-  
-  _numPendingOperations += numOperations;
 
   // we have put the object into the queue successfully
   // now set the original pointer to null so it isn't double-freed
@@ -1401,14 +1521,12 @@ void CollectorThread::finishMarker (char const* walPosition,
   // re-use the original WAL marker's tick
   marker->_tick = tick;
 
-  // calculate the CRC
-  TRI_voc_crc_t crc = TRI_InitialCrc32();
-  crc = TRI_BlockCrc32(crc, const_cast<char*>(datafilePosition), marker->_size);
-  marker->_crc = TRI_FinalCrc32(crc);
-
   TRI_datafile_t* datafile = cache->lastDatafile;
   TRI_ASSERT(datafile != nullptr);
 
+  // calculate the CRC, using the algorithm of the target datafile's version
+  marker->_crc = TRI_CalculateCrcMarkerDatafile(datafile->_version, marker);
+
   // update ticks
   TRI_UpdateTicksDatafile(datafile, marker);
 
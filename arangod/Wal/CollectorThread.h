@@ -40,12 +40,17 @@
 #include "VocBase/voc-types.h"
 #include "Wal/Logfile.h"
 
+struct CollectorState;
 struct TRI_datafile_s;
 struct TRI_df_marker_s;
 struct TRI_document_collection_t;
 struct TRI_server_s;
 
 namespace triagens {
+  namespace basics {
+    class ThreadPool;
+  }
+
   namespace wal {
 
     class LogfileManager;
@@ -152,7 +157,7 @@ namespace triagens {
 /// @brief total number of operations in this block
 ////////////////////////////////////////////////////////////////////////////////
 
-      int64_t const totalOperationsCount;
+      int64_t totalOperationsCount;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief all collector operations of a collection
@@ -210,7 +215,8 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         CollectorThread (LogfileManager*,
-                         struct TRI_server_s*);
+                         struct TRI_server_s*,
+                         uint32_t);
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief destroy the collector thread
@@ -296,6 +302,20 @@ namespace triagens {
 
         bool processQueuedOperations ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief process the queued operations of a single collection, in order
+////////////////////////////////////////////////////////////////////////////////
+
+        void processQueuedCollection (std::vector<CollectorCache*>&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute work(0) ... work(count - 1), spread over the collector
+/// workers if there are any
+////////////////////////////////////////////////////////////////////////////////
+
+        void parallelFor (size_t,
+                          std::function<void(size_t)> const&);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief process all operations for a single collection
 ////////////////////////////////////////////////////////////////////////////////
@@ -308,6 +328,14 @@ namespace triagens {
 
         int collect (Logfile*);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief transfer the surviving markers of one collection from a logfile
+////////////////////////////////////////////////////////////////////////////////
+
+        int collectCollection (Logfile*,
+                               struct CollectorState const*,
+                               TRI_voc_cid_t);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief transfer markers into a collection
 ////////////////////////////////////////////////////////////////////////////////
@@ -392,6 +420,13 @@ namespace triagens {
 
         struct TRI_server_s* _server;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief helper threads for collecting independent collections in parallel.
+/// this is a nullptr if the collector works single-threaded
+////////////////////////////////////////////////////////////////////////////////
+
+        triagens::basics::ThreadPool* _workers;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief condition variable for the collector thread
 ////////////////////////////////////////////////////////////////////////////////
@@ -416,6 +451,13 @@ namespace triagens {
 
         bool _operationsQueueInUse;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief collections that have been collected completely by a failed attempt
+/// to collect a logfile, per logfile. only used by the collector thread
+////////////////////////////////////////////////////////////////////////////////
+
+        std::unordered_map<Logfile::IdType, std::unordered_set<TRI_voc_cid_t>> _collectedCollections;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief stop flag
 ////////////////////////////////////////////////////////////////////////////////
@@ -426,7 +468,7 @@ namespace triagens {
 /// @brief number of pending operations in collector queue
 ////////////////////////////////////////////////////////////////////////////////
 
-        uint64_t _numPendingOperations;
+        std::atomic<uint64_t> _numPendingOperations;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief wait interval for the collector thread when idle
@@ -3,6 +3,7 @@
 #define TRIAGENS_VOC_BASE_DOCUMENT_OPERATION_H 1
 
 #include "Basics/Common.h"
+#include "Indexes/PrimaryIndex.h"
 #include "VocBase/voc-types.h"
 #include "VocBase/document-collection.h"
 #include "Wal/Marker.h"
@@ -117,7 +118,12 @@ namespace triagens {
         }
         else if (type == TRI_VOC_DOCUMENT_OPERATION_UPDATE) {
           document->_headersPtr->move(header, &oldHeader);  // PROTECTED by trx in trxCollection
+
+          // the header is still contained in the primary index
+          auto primaryIndex = document->primaryIndex();
+          primaryIndex->beginWrite();
           header->copy(oldHeader);
+          primaryIndex->endWrite();
         }
         else if (type == TRI_VOC_DOCUMENT_OPERATION_REMOVE) {
           if (status != StatusType::CREATED) {
@@ -74,6 +74,22 @@ static inline uint64_t MinSyncInterval () {
   return 5;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum value for --wal.group-commit-delay
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t MaxGroupCommitDelay () {
+  return 1000 * 1000;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum value for --wal.collector-threads
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t MaxCollectorThreads () {
+  return 64;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief minimum value for --wal.logfile-size
 ////////////////////////////////////////////////////////////////////////////////
@@ -137,6 +153,9 @@ LogfileManager::LogfileManager (TRI_server_t* server,
     _maxOpenLogfiles(0),
     _numberOfSlots(1048576),
     _syncInterval(100),
+    _groupCommitDelay(0),
+    _groupCommitSize(32),
+    _collectorThreads(4),
     _maxThrottleWait(15000),
     _throttleWhenPending(0),
     _allowOversizeEntries(true),
@@ -233,6 +252,7 @@ void LogfileManager::initialise (std::string* path,
 void LogfileManager::setupOptions (std::map<std::string, triagens::basics::ProgramOptionsDescription>& options) {
   options["Write-ahead log options:help-wal"]
     ("wal.allow-oversize-entries", &_allowOversizeEntries, "allow entries that are bigger than --wal.logfile-size")
+    ("wal.collector-threads", &_collectorThreads, "number of threads used for transferring logfile data into collections")
     ("wal.directory", &_directory, "logfile directory")
     ("wal.historic-logfiles", &_historicLogfiles, "maximum number of historic logfiles to keep after collection")
     ("wal.ignore-logfile-errors", &_ignoreLogfileErrors, "ignore logfile errors. this will read recoverable data from corrupted logfiles but ignore any unrecoverable data")
@@ -242,6 +262,8 @@ void LogfileManager::setupOptions (std::map<std::string, triagens::basics::Progr
     ("wal.reserve-logfiles", &_reserveLogfiles, "maximum number of reserve logfiles to maintain")
     ("wal.slots", &_numberOfSlots, "number of logfile slots to use")
     ("wal.suppress-shape-information", &_suppressShapeInformation, "do not write shape information for markers (saves a lot of disk space, but effectively disables using the write-ahead log for replication)")
+    ("wal.group-commit-delay", &_groupCommitDelay, "maximum delay for gathering sync requests into a single disk sync (in microseconds)")
+    ("wal.group-commit-size", &_groupCommitSize, "number of gathered sync requests that triggers a disk sync without further delay")
     ("wal.sync-interval", &_syncInterval, "interval for automatic, non-requested disk syncs (in milliseconds)")
     ("wal.throttle-when-pending", &_throttleWhenPending, "throttle writes when at least this many operations are waiting for collection (set to 0 to deactivate write-throttling)")
     ("wal.throttle-wait", &_maxThrottleWait, "maximum wait time per operation when write-throttled (in milliseconds)")
@@ -306,6 +328,18 @@ bool LogfileManager::prepare () {
     LOG_FATAL_AND_EXIT("invalid value for --wal.sync-interval. Please use a value of at least %llu", (unsigned long long) MinSyncInterval());
   }
 
+  if (_groupCommitDelay > MaxGroupCommitDelay()) {
+    LOG_FATAL_AND_EXIT("invalid value for --wal.group-commit-delay. Please use a value of at most %llu", (unsigned long long) MaxGroupCommitDelay());
+  }
+
+  if (_groupCommitSize == 0) {
+    LOG_FATAL_AND_EXIT("invalid value for --wal.group-commit-size. Please use a value of at least 1");
+  }
+
+  if (_collectorThreads == 0 || _collectorThreads > MaxCollectorThreads()) {
+    LOG_FATAL_AND_EXIT("invalid value for --wal.collector-threads. Please use a value between 1 and %lu", (unsigned long) MaxCollectorThreads());
+  }
+
   // sync interval is specified in milliseconds by the user, but internally
   // we use microseconds
   _syncInterval = _syncInterval * 1000;
@@ -727,8 +761,8 @@ bool LogfileManager::hasReserveLogfiles () {
 /// @brief signal that a sync operation is required
 ////////////////////////////////////////////////////////////////////////////////
 
-void LogfileManager::signalSync () {
-  _synchroniserThread->signalSync();
+void LogfileManager::signalSync (bool waitForSync) {
+  _synchroniserThread->signalSync(waitForSync);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -797,6 +831,16 @@ void LogfileManager::finalise (SlotInfo& slotInfo,
   _slots->returnUsed(slotInfo, waitForSync);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finalise a log entry and request its synchronisation without
+/// waiting for it. the callback is invoked once the entry is on disk
+////////////////////////////////////////////////////////////////////////////////
+
+void LogfileManager::finalise (SlotInfo& slotInfo,
+                               SyncCallback const& callback) {
+  _slots->returnUsed(slotInfo, callback);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief write data into the logfile
 /// this is a convenience function that combines allocate, memcpy and finalise
@@ -887,6 +931,40 @@ SlotInfoCopy LogfileManager::allocateAndWrite (Marker const& marker,
   return allocateAndWrite(marker.mem(), marker.size(), waitForSync);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief write data into the logfile and request its synchronisation
+/// without waiting for it. the callback is invoked once the data is on disk.
+/// it is not invoked if writing fails
+////////////////////////////////////////////////////////////////////////////////
+
+SlotInfoCopy LogfileManager::allocateAndWrite (Marker const& marker,
+                                               SyncCallback const& callback) {
+  uint32_t const size = marker.size();
+  SlotInfo slotInfo = allocate(size);
+
+  if (slotInfo.errorCode != TRI_ERROR_NO_ERROR) {
+    return SlotInfoCopy(slotInfo.errorCode);
+  }
+
+  TRI_ASSERT(slotInfo.slot != nullptr);
+
+  try {
+    slotInfo.slot->fill(marker.mem(), size);
+
+    // we must copy the slotinfo because finalise() will set its internal to 0 again
+    SlotInfoCopy copy(slotInfo.slot);
+
+    finalise(slotInfo, callback);
+    return copy;
+  }
+  catch (...) {
+    // if we don't return the slot we'll run into serious problems later
+    finalise(slotInfo, false);
+
+    return SlotInfoCopy(TRI_ERROR_INTERNAL);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief finalise and seal the currently open logfile
 /// this is useful to ensure that any open writes up to this point have made
@@ -1041,7 +1119,7 @@ void LogfileManager::setLogfileSealRequested (Logfile* logfile) {
 
   WRITE_LOCKER(_logfilesLock);
   logfile->setStatus(Logfile::StatusType::SEAL_REQUESTED);
-  signalSync();
+  signalSync(false);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1700,7 +1778,7 @@ int LogfileManager::writeShutdownInfo (bool writeShutdownTime) {
 ////////////////////////////////////////////////////////////////////////////////
 
 int LogfileManager::startSynchroniserThread () {
-  _synchroniserThread = new SynchroniserThread(this, _syncInterval);
+  _synchroniserThread = new SynchroniserThread(this, _syncInterval, _groupCommitDelay, _groupCommitSize);
 
   if (_synchroniserThread == nullptr) {
     return TRI_ERROR_INTERNAL;
@@ -1770,7 +1848,7 @@ void LogfileManager::stopAllocatorThread () {
 ////////////////////////////////////////////////////////////////////////////////
 
 int LogfileManager::startCollectorThread () {
-  _collectorThread = new CollectorThread(this, _server);
+  _collectorThread = new CollectorThread(this, _server, _collectorThreads);
 
   if (_collectorThread == nullptr) {
     return TRI_ERROR_INTERNAL;
@@ -197,6 +197,14 @@ namespace triagens {
           _syncInterval = value * 1000;
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief get the group commit delay (in microseconds)
+////////////////////////////////////////////////////////////////////////////////
+
+        inline uint64_t groupCommitDelay () const {
+          return _groupCommitDelay;
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief get the number of reserve logfiles
 ////////////////////////////////////////////////////////////////////////////////
@@ -416,10 +424,11 @@ namespace triagens {
         bool hasReserveLogfiles ();
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief signal that a sync operation is required
+/// @brief signal that a sync operation is required. the flag indicates
+/// whether the caller waits for the sync
 ////////////////////////////////////////////////////////////////////////////////
 
-        void signalSync ();
+        void signalSync (bool);
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief reserve space in a logfile
@@ -443,6 +452,13 @@ namespace triagens {
 
         void finalise (SlotInfo&, bool);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief finalise a log entry and request its synchronisation without
+/// waiting for it. the callback is invoked once the entry is on disk
+////////////////////////////////////////////////////////////////////////////////
+
+        void finalise (SlotInfo&, SyncCallback const&);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief write data into the logfile
 /// this is a convenience function that combines allocate, memcpy and finalise
@@ -474,6 +490,15 @@ namespace triagens {
         SlotInfoCopy allocateAndWrite (Marker const&,
                                        bool);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief write data into the logfile and request its synchronisation
+/// without waiting for it. the callback is invoked once the data is on disk.
+/// it is not invoked if writing fails
+////////////////////////////////////////////////////////////////////////////////
+
+        SlotInfoCopy allocateAndWrite (Marker const&,
+                                       SyncCallback const&);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief finalise and seal the currently open logfile
 /// this is useful to ensure that any open writes up to this point have made
@@ -912,6 +937,56 @@ namespace triagens {
 
         uint64_t _syncInterval;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum delay for gathering sync requests into a group commit
+/// @startDocuBlock WalLogfileGroupCommitDelay
+/// `--wal.group-commit-delay`
+///
+/// The maximum time (in microseconds) the write-ahead log will delay a disk
+/// synchronization to gather more operations that request a sync. All
+/// operations gathered are then synchronized with a single disk sync, and
+/// all of them are acknowledged at the same time. This reduces the number of
+/// disk syncs when there are many concurrent operations with *waitForSync*,
+/// at the price of a higher latency for a single such operation. A value of
+/// *0* turns off the delay. Operations arriving while a sync is in progress
+/// are always synchronized together.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _groupCommitDelay;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of sync requests after which a group commit is executed
+/// without further delay
+/// @startDocuBlock WalLogfileGroupCommitSize
+/// `--wal.group-commit-size`
+///
+/// The number of operations waiting for a disk synchronization after which
+/// the write-ahead log will synchronize them immediately, even if the
+/// `--wal.group-commit-delay` is not yet over.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t _groupCommitSize;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of threads used by the write-ahead log collector
+/// @startDocuBlock WalLogfileCollectorThreads
+/// `--wal.collector-threads`
+///
+/// The number of threads the write-ahead log collector uses for transferring
+/// operations from the write-ahead logfiles into the collection datafiles.
+/// The data of different collections is transferred in parallel, whereas
+/// all operations of the same collection are always handled by one thread in
+/// order. Higher values help to keep the collector up to date when there are
+/// sustained writes into many collections. Logfiles are still collected one
+/// after the other, and a logfile is only released when the data of all its
+/// collections has been transferred.
+/// @endDocuBlock
+////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t _collectorThreads;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief maximum wait time for write-throttling
 ////////////////////////////////////////////////////////////////////////////////
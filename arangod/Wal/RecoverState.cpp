@@ -32,6 +32,8 @@
 #include "Basics/conversions.h"
 #include "Basics/files.h"
 #include "Basics/Exceptions.h"
+#include "Basics/MutexLocker.h"
+#include "Basics/ThreadPool.h"
 #include "VocBase/collection.h"
 #include "VocBase/replication-applier.h"
 #include "VocBase/voc-shaper.h"
@@ -182,6 +184,11 @@ RecoverState::RecoverState (TRI_server_t* server,
     remoteTransactions(),
     remoteTransactionCollections(),
     remoteTransactionDatabases(),
+    droppedCollections(),
+    droppedDatabases(),
+    droppedIds(),
+    createdIds(),
+    usedCollections(),
     lastTick(0),
     logfilesToProcess(),
     openedCollections(),
@@ -674,6 +681,32 @@ bool RecoverState::InitialScanMarker (TRI_df_marker_t const* marker,
       break;
     }
 
+    case TRI_WAL_MARKER_CREATE_COLLECTION: {
+      collection_create_marker_t const* m = reinterpret_cast<collection_create_marker_t const*>(marker);
+      // note that the collection is (re-)created by the replay and must not be preloaded
+      state->createdIds.insert(m->_collectionId);
+      break;
+    }
+
+    // -----------------------------------------------------------------------------
+    // crud operations
+    // -----------------------------------------------------------------------------
+
+    case TRI_WAL_MARKER_DOCUMENT:
+    case TRI_WAL_MARKER_EDGE: {
+      document_marker_t const* m = reinterpret_cast<document_marker_t const*>(marker);
+      // note the collection so it can be loaded before the replay
+      state->usedCollections.emplace(m->_collectionId, m->_databaseId);
+      break;
+    }
+
+    case TRI_WAL_MARKER_REMOVE: {
+      remove_marker_t const* m = reinterpret_cast<remove_marker_t const*>(marker);
+      // note the collection so it can be loaded before the replay
+      state->usedCollections.emplace(m->_collectionId, m->_databaseId);
+      break;
+    }
+
 /*
     case TRI_WAL_MARKER_DROP_DATABASE: {
       database_drop_marker_t const* m = reinterpret_cast<database_drop_marker_t const*>(marker);
@@ -1151,6 +1184,7 @@ bool RecoverState::ReplayMarker (TRI_df_marker_t const* marker,
       
       TRI_col_info_t parameters;
       parameters._doCompact = true;
+      parameters._compressDatafiles = false;
       parameters._waitForSync = vocbase->_settings.defaultWaitForSync;
       parameters._maximalSize = vocbase->_settings.defaultMaximalSize; 
 
@@ -1159,6 +1193,11 @@ bool RecoverState::ReplayMarker (TRI_df_marker_t const* marker,
         parameters._doCompact = value->_value._boolean;
       }
       
+      value = TRI_LookupObjectJson(json, "compressDatafiles");
+      if (TRI_IsBooleanJson(value)) {
+        parameters._compressDatafiles = value->_value._boolean;
+      }
+      
       value = TRI_LookupObjectJson(json, "waitForSync");
       if (TRI_IsBooleanJson(value)) {
         parameters._waitForSync = value->_value._boolean;
@@ -1574,6 +1613,8 @@ int RecoverState::replayLogfiles () {
   droppedCollections.clear();
   droppedDatabases.clear();
 
+  preloadCollections();
+
   int i = 0;
   for (auto& it : logfilesToProcess) {
     TRI_ASSERT(it != nullptr);
@@ -1587,6 +1628,102 @@ int RecoverState::replayLogfiles () {
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief load all collections used by the logfiles in parallel
+///
+/// loading a collection reads and checks all of its datafiles. the replay
+/// would otherwise load the collections one after the other when it finds
+/// their first marker. collections that are created or dropped by the
+/// logfiles are left to the replay. errors are ignored here, as the replay
+/// will try to load the collection again and report them
+////////////////////////////////////////////////////////////////////////////////
+
+void RecoverState::preloadCollections () {
+  // minimum number of seconds between two progress messages
+  static double const ReportInterval = 10.0;
+
+  auto indexPool = static_cast<triagens::basics::ThreadPool*>(server->_indexPool);
+
+  if (indexPool == nullptr || usedCollections.size() < 2) {
+    // collections will be loaded on first use
+    return;
+  }
+
+  std::vector<std::pair<TRI_vocbase_t*, TRI_voc_cid_t>> candidates;
+  candidates.reserve(usedCollections.size());
+
+  for (auto const& it : usedCollections) {
+    TRI_voc_cid_t collectionId = it.first;
+
+    if (willBeDropped(collectionId) || 
+        createdIds.find(collectionId) != createdIds.end() ||
+        openedCollections.find(collectionId) != openedCollections.end()) {
+      continue;
+    }
+
+    TRI_vocbase_t* vocbase = useDatabase(it.second);
+
+    if (vocbase == nullptr || 
+        TRI_LookupCollectionByIdVocBase(vocbase, collectionId) == nullptr) {
+      continue;
+    }
+
+    candidates.emplace_back(vocbase, collectionId);
+  }
+
+  size_t const n = candidates.size();
+
+  if (n < 2) {
+    return;
+  }
+  
+  double const start = TRI_microtime();
+  LOG_INFO("loading %llu collections used by WAL recovery", (unsigned long long) n);
+
+  std::vector<TRI_vocbase_col_t*> loaded(n, nullptr);
+
+  triagens::basics::Mutex reportLock;
+  double lastReport = start;
+  size_t numberDone = 0;
+
+  indexPool->parallelFor(n, [&] (size_t i) -> void {
+    TRI_vocbase_col_status_e status; // ignored here
+    loaded[i] = TRI_UseCollectionByIdVocBase(candidates[i].first, candidates[i].second, status);
+    
+    MUTEX_LOCKER(reportLock);
+    ++numberDone;
+
+    double const now = TRI_microtime();
+
+    if (now - lastReport >= ReportInterval && numberDone < n) {
+      lastReport = now;
+      LOG_INFO("loaded %llu of %llu collections used by WAL recovery", 
+               (unsigned long long) numberDone,
+               (unsigned long long) n);
+    }
+  });
+
+  for (size_t i = 0; i < n; ++i) {
+    TRI_vocbase_col_t* collection = loaded[i];
+
+    if (collection == nullptr) {
+      continue;
+    }
+
+    TRI_document_collection_t* document = collection->_collection;
+    TRI_ASSERT(document != nullptr);
+
+    // disable secondary indexes for the moment
+    document->useSecondaryIndexes(false);
+
+    openedCollections.emplace(candidates[i].second, collection);
+  }
+
+  LOG_INFO("loaded %llu collections used by WAL recovery in %.2f s", 
+           (unsigned long long) n,
+           TRI_microtime() - start);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief abort open transactions
 ////////////////////////////////////////////////////////////////////////////////
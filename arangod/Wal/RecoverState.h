@@ -280,6 +280,12 @@ namespace triagens {
     
       int replayLogfiles ();
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief load all collections used by the logfiles in parallel
+////////////////////////////////////////////////////////////////////////////////
+
+      void preloadCollections ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief abort open transactions
 ////////////////////////////////////////////////////////////////////////////////
@@ -310,6 +316,8 @@ namespace triagens {
       std::unordered_set<TRI_voc_cid_t>                                           droppedCollections;
       std::unordered_set<TRI_voc_tick_t>                                          droppedDatabases;
       std::unordered_set<TRI_voc_cid_t>                                           droppedIds;
+      std::unordered_set<TRI_voc_cid_t>                                           createdIds;
+      std::unordered_map<TRI_voc_cid_t, TRI_voc_tick_t>                           usedCollections;
 
       TRI_voc_tick_t                                                              lastTick;
       std::vector<Logfile*>                                                       logfilesToProcess;
@@ -36,8 +36,32 @@
 #include "VocBase/server.h"
 #include "Wal/LogfileManager.h"
 
+#include <thread>
+
 using namespace triagens::wal;
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private constants
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief flag in the reservation word for a closed handout region
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t const HandoutClosed = (static_cast<uint64_t>(1) << 63);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief one slot in the reservation word
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t const HandoutSlot = (static_cast<uint64_t>(1) << 32);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief mask for the reserved bytes in the reservation word
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t const HandoutBytes = (HandoutSlot - 1);
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                      constructors and destructors
 // -----------------------------------------------------------------------------
@@ -57,12 +81,22 @@ Slots::Slots (LogfileManager* logfileManager,
     _freeSlots(numberOfSlots),
     _waiting(0),
     _handoutIndex(0),
+    _reservation(HandoutClosed),
+    _reservers(0),
+    _ticksAssigned(0),
+    _handoutEnd(0),
+    _handoutMem(nullptr),
+    _handoutLimit(0),
+    _handoutBase(0),
+    _handoutGeneration(0),
+    _handoutOpen(false),
     _recycleIndex(0),
     _logfile(nullptr),
     _lastAssignedTick(0),
     _lastCommittedTick(0),
     _lastCommittedDataTick(0),
-    _numEvents(0)  {
+    _numEvents(0),
+    _syncCallbacks() {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -103,7 +137,7 @@ int Slots::flush (bool waitForSync) {
   int res = closeLogfile(lastTick, worked);
 
   if (res == TRI_ERROR_NO_ERROR) {
-    _logfileManager->signalSync();
+    _logfileManager->signalSync(waitForSync);
 
     if (waitForSync) {
       // wait until data has been committed to disk
@@ -127,8 +161,7 @@ int Slots::flush (bool waitForSync) {
 ////////////////////////////////////////////////////////////////////////////////
 
 Slot::TickType Slots::lastCommittedTick () {
-  MUTEX_LOCKER(_lock);
-  return _lastCommittedTick;
+  return _lastCommittedTick.load();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -136,110 +169,7 @@ Slot::TickType Slots::lastCommittedTick () {
 ////////////////////////////////////////////////////////////////////////////////
 
 SlotInfo Slots::nextUnused (uint32_t size) {
-  // we need to use the aligned size for writing
-  uint32_t alignedSize = TRI_DF_ALIGN_BLOCK(size);
-  int iterations = 0;
-  bool hasWaited = false;
-
-  TRI_ASSERT(size > 0);
-
-  while (++iterations < 1000) {
-    {
-      MUTEX_LOCKER(_lock);
-
-      Slot* slot = &_slots[_handoutIndex];
-      TRI_ASSERT(slot != nullptr);
-
-      if (slot->isUnused()) {
-        if (hasWaited) {
-          CONDITION_LOCKER(guard, _condition);
-          TRI_ASSERT(_waiting > 0);
-          --_waiting;
-          hasWaited = false;
-        }
-
-        // cycle until we have a valid logfile
-        while (_logfile == nullptr ||
-               _logfile->freeSize() < static_cast<uint64_t>(alignedSize)) {
-
-          if (_logfile != nullptr) {
-            // seal existing logfile by creating a footer marker
-            int res = writeFooter(slot);
-
-            if (res != TRI_ERROR_NO_ERROR) {
-              return SlotInfo(res);
-            }
-
-            // advance to next slot
-            slot = &_slots[_handoutIndex];
-            _logfileManager->setLogfileSealRequested(_logfile);
-
-            _logfile = nullptr;
-          }
-
-          // fetch the next free logfile (this may create a new one)
-          Logfile::StatusType status = newLogfile(alignedSize);
-
-          if (_logfile == nullptr) {
-            usleep(10 * 1000);
-
-            TRI_IF_FAILURE("LogfileManagerGetWriteableLogfile") {
-              return SlotInfo(TRI_ERROR_ARANGO_NO_JOURNAL);
-            }
-
-            // try again in next iteration
-          }
-          else if (status == Logfile::StatusType::EMPTY) {
-            // inititialise the empty logfile by writing a header marker
-            int res = writeHeader(slot);
-
-            if (res != TRI_ERROR_NO_ERROR) {
-              return SlotInfo(res);
-            }
-
-            // advance to next slot
-            slot = &_slots[_handoutIndex];
-            _logfileManager->setLogfileOpen(_logfile);
-          }
-          else {
-            TRI_ASSERT(status == Logfile::StatusType::OPEN);
-          }
-        }
-
-        // if we get here, we got a free slot for the actual data...
-
-        char* mem = _logfile->reserve(alignedSize);
-
-        if (mem == nullptr) {
-          return SlotInfo(TRI_ERROR_INTERNAL);
-        }
-
-        // only in this case we return a valid slot
-        slot->setUsed(static_cast<void*>(mem), size, _logfile->id(), handout());
-
-        return SlotInfo(slot);
-      }
-    }
-
-    // if we get here, all slots are busy
-    CONDITION_LOCKER(guard, _condition);
-    if (! hasWaited) {
-      ++_waiting;
-      hasWaited = true;
-    }
-
-    bool mustWait;
-    {
-      MUTEX_LOCKER(_lock);
-      mustWait = (_freeSlots == 0);
-    }
-
-    if (mustWait) {
-      guard.wait(10 * 1000);
-    }
-  }
-
-  return SlotInfo(TRI_ERROR_ARANGO_NO_JOURNAL);
+  return reserveSlot(size, 0, 0, 0, nullptr);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -255,149 +185,96 @@ SlotInfo Slots::nextUnused (uint32_t size,
                             uint32_t legendOffset,
                             void*& oldLegend) {
                             // legendOffset 0 means no legend included
-  // we need to use the aligned size for writing
-  uint32_t alignedSize = TRI_DF_ALIGN_BLOCK(size);
-  int iterations = 0;
-  bool hasWaited = false;
-
-  TRI_ASSERT(size > 0);
-
-  while (++iterations < 1000) {
-    {
-      MUTEX_LOCKER(_lock);
-
-      Slot* slot = &_slots[_handoutIndex];
-      TRI_ASSERT(slot != nullptr);
-
-      if (slot->isUnused()) {
-        if (hasWaited) {
-          CONDITION_LOCKER(guard, _condition);
-          TRI_ASSERT(_waiting > 0);
-          --_waiting;
-          hasWaited = false;
-        }
-
-        // cycle until we have a valid logfile
-        while (_logfile == nullptr ||
-               _logfile->freeSize() < static_cast<uint64_t>(alignedSize)) {
-
-          if (_logfile != nullptr) {
-            // seal existing logfile by creating a footer marker
-            int res = writeFooter(slot);
-
-            if (res != TRI_ERROR_NO_ERROR) {
-              return SlotInfo(res);
-            }
+  return reserveSlot(size, cid, sid, legendOffset, &oldLegend);
+}
 
-            // advance to next slot
-            slot = &_slots[_handoutIndex];
-            _logfileManager->setLogfileSealRequested(_logfile);
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a used slot, allowing its synchronisation
+////////////////////////////////////////////////////////////////////////////////
 
-            _logfile = nullptr;
-          }
+void Slots::returnUsed (SlotInfo& slotInfo,
+                        bool waitForSync) {
+  TRI_ASSERT(slotInfo.slot != nullptr);
+  Slot::TickType tick = slotInfo.slot->tick();
 
-          // fetch the next free logfile (this may create a new one)
-          Logfile::StatusType status = newLogfile(alignedSize);
+  TRI_ASSERT(tick > 0);
 
-          if (_logfile == nullptr) {
-            usleep(10 * 1000);
+  // returning a slot does not require the slots lock. the slot belongs
+  // to the caller until it is marked as returned, and the synchroniser
+  // thread will only pick it up after that
+  slotInfo.slot->setReturned(waitForSync);
+  ++_numEvents;
 
-            TRI_IF_FAILURE("LogfileManagerGetWriteableLogfile") {
-              return SlotInfo(TRI_ERROR_ARANGO_NO_JOURNAL);
-            }
+  _logfileManager->signalSync(waitForSync);
 
-            // try again in next iteration
-          }
-          else if (status == Logfile::StatusType::EMPTY) {
-            // inititialise the empty logfile by writing a header marker
-            int res = writeHeader(slot);
+  if (waitForSync) {
+    waitForTick(tick);
+  }
+}
 
-            if (res != TRI_ERROR_NO_ERROR) {
-              return SlotInfo(res);
-            }
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a used slot and request its synchronisation, without
+/// waiting for it. the callback is invoked by the synchroniser thread once
+/// the slot has been synced to disk
+////////////////////////////////////////////////////////////////////////////////
 
-            // advance to next slot
-            slot = &_slots[_handoutIndex];
-            _logfileManager->setLogfileOpen(_logfile);
-          }
-          else {
-            TRI_ASSERT(status == Logfile::StatusType::OPEN);
-          }
-        }
+void Slots::returnUsed (SlotInfo& slotInfo,
+                        SyncCallback const& callback) {
+  TRI_ASSERT(slotInfo.slot != nullptr);
+  Slot::TickType tick = slotInfo.slot->tick();
 
-        // if we get here, we got a free slot for the actual data...
-        
-        // Now sort out the legend business:
-        if (legendOffset == 0) {
-          void* legend = _logfile->lookupLegend(cid, sid);
-          if (nullptr == legend) {
-            // Bad, we would need a legend for this marker
-            return SlotInfo(TRI_ERROR_LEGEND_NOT_IN_WAL_FILE);
-          }
-          oldLegend = legend;
-        }
+  TRI_ASSERT(tick > 0);
 
-        char* mem = _logfile->reserve(alignedSize);
+  {
+    // register the callback before the slot can be synced
+    CONDITION_LOCKER(guard, _condition);
+    _syncCallbacks.emplace_back(tick, callback);
+  }
 
-        if (mem == nullptr) {
-          return SlotInfo(TRI_ERROR_INTERNAL);
-        }
+  slotInfo.slot->setReturned(true);
+  ++_numEvents;
 
-        if (legendOffset != 0) {
-          void* legend = static_cast<void*>(mem + legendOffset);
-          _logfile->cacheLegend(cid, sid, legend);
-        }
+  _logfileManager->signalSync(true);
+}
 
-        // only in this case we return a valid slot
-        slot->setUsed(static_cast<void*>(mem), size, _logfile->id(), handout());
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invoke all pending sync callbacks with an error code. this is
+/// called on shutdown for callbacks whose slots could not be synced
+////////////////////////////////////////////////////////////////////////////////
 
-        return SlotInfo(slot);
-      }
-    }
+void Slots::abortSyncCallbacks (int errorCode) {
+  std::vector<std::pair<Slot::TickType, SyncCallback>> callbacks;
 
-    // if we get here, all slots are busy
+  {
     CONDITION_LOCKER(guard, _condition);
-    if (! hasWaited) {
-      ++_waiting;
-      hasWaited = true;
-    }
-
-    bool mustWait;
-    {
-      MUTEX_LOCKER(_lock);
-      mustWait = (_freeSlots == 0);
-    }
-
-    if (mustWait) {
-      guard.wait(10 * 1000);
-    }
+    callbacks.swap(_syncCallbacks);
   }
 
-  return SlotInfo(TRI_ERROR_ARANGO_NO_JOURNAL);
+  for (auto& it : callbacks) {
+    it.second(errorCode);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief return a used slot, allowing its synchronisation
+/// @brief invoke the sync callbacks of a region with an error code. this is
+/// called when syncing the region failed. the region itself is kept and
+/// will be synced again later
 ////////////////////////////////////////////////////////////////////////////////
 
-void Slots::returnUsed (SlotInfo& slotInfo,
-                        bool waitForSync) {
-  TRI_ASSERT(slotInfo.slot != nullptr);
-  Slot::TickType tick = slotInfo.slot->tick();
-
-  TRI_ASSERT(tick > 0);
+void Slots::abortSyncRegion (SyncRegion const& region,
+                             int errorCode) {
+  TRI_ASSERT(region.logfileId != 0);
 
-  {
-    MUTEX_LOCKER(_lock);
-    slotInfo.slot->setReturned(waitForSync);
-    ++_numEvents;
+  if (! region.waitForSync) {
+    // no callbacks can be registered for the region
+    return;
   }
 
-  _logfileManager->signalSync();
+  // the slots of the region are returned but not yet recycled, so they
+  // cannot change while we read the tick
+  Slot::TickType lastTick = _slots[region.lastSlotIndex].tick();
 
-  if (waitForSync) {
-    waitForTick(tick);
-  }
+  notifySyncCallbacks(lastTick, errorCode);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -478,6 +355,7 @@ void Slots::returnSyncRegion (SyncRegion const& region) {
   TRI_ASSERT(region.logfileId != 0);
 
   size_t slotIndex = region.firstSlotIndex;
+  Slot::TickType lastTick = 0;
 
   {
     MUTEX_LOCKER(_lock);
@@ -490,6 +368,7 @@ void Slots::returnSyncRegion (SyncRegion const& region) {
       Slot::TickType tick = slot->tick();
       TRI_ASSERT(tick >= _lastCommittedTick);
       _lastCommittedTick = tick;
+      lastTick = tick;
 
       // update the data tick
       TRI_df_marker_t const* m = static_cast<TRI_df_marker_t const*>(slot->mem());
@@ -520,11 +399,18 @@ void Slots::returnSyncRegion (SyncRegion const& region) {
     }
   }
 
-  // signal that we have done something
-  CONDITION_LOCKER(guard, _condition);
+  {
+    // signal that we have done something. this wakes up all writers
+    // that have been waiting for any of the ticks in the region at once
+    CONDITION_LOCKER(guard, _condition);
+
+    if (_waiting > 0 || region.waitForSync) {
+      _condition.broadcast();
+    }
+  }
 
-  if (_waiting > 0 || region.waitForSync) {
-    _condition.broadcast();
+  if (region.waitForSync) {
+    notifySyncCallbacks(lastTick, TRI_ERROR_NO_ERROR);
   }
 }
 
@@ -542,6 +428,12 @@ void Slots::getActiveLogfileRegion (Logfile* logfile,
 
   begin = datafile->_data;
   end   = begin + datafile->_currentSize;
+
+  if (_handoutOpen && logfile == _logfile) {
+    // add the markers reserved in the handout region so far. the region
+    // is only accounted for in the datafile when it is closed
+    end += _handoutEnd.load(std::memory_order_acquire);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -565,6 +457,282 @@ void Slots::getActiveTickRange (Logfile* logfile,
 // --SECTION--                                                   private methods
 // -----------------------------------------------------------------------------
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the next unused slot. oldLegend is a nullptr for markers
+/// without legends
+///
+/// slots are reserved without the slots lock as long as the current logfile
+/// has enough space left for the marker. only rotating the logfile and
+/// writing its header and footer markers acquires the lock
+////////////////////////////////////////////////////////////////////////////////
+
+SlotInfo Slots::reserveSlot (uint32_t size,
+                             TRI_voc_cid_t cid,
+                             TRI_shape_sid_t sid,
+                             uint32_t legendOffset,
+                             void** oldLegend) {
+  // we need to use the aligned size for writing
+  uint32_t alignedSize = TRI_DF_ALIGN_BLOCK(size);
+  int iterations = 0;
+  bool hasWaited = false;
+
+  TRI_ASSERT(size > 0);
+
+  while (true) {
+    if (claimSlots(1)) {
+      if (hasWaited) {
+        CONDITION_LOCKER(guard, _condition);
+        TRI_ASSERT(_waiting > 0);
+        --_waiting;
+        hasWaited = false;
+      }
+
+      uint64_t generation = 0;
+      SlotInfo slotInfo = reserveFast(size, alignedSize, cid, sid, legendOffset, oldLegend, generation);
+
+      if (slotInfo.slot != nullptr || slotInfo.errorCode != TRI_ERROR_NO_ERROR) {
+        return slotInfo;
+      }
+
+      // the handout region is closed or exhausted. rotating the logfile
+      // needs up to three slots: the footer of the current logfile, the
+      // header of the next one and the marker itself
+      if (claimSlots(3)) {
+        MUTEX_LOCKER(_lock);
+
+        if (_handoutOpen && _handoutGeneration != generation) {
+          // someone else has reopened the handout region in the meantime
+          releaseSlots(3);
+          continue;
+        }
+
+        closeHandout();
+
+        uint64_t const ticksAssigned = _ticksAssigned.load();
+        slotInfo = reserveLocked(size, alignedSize, cid, sid, legendOffset, oldLegend);
+        releaseSlots(3 - static_cast<size_t>(_ticksAssigned.load() - ticksAssigned));
+
+        openHandout();
+
+        return slotInfo;
+      }
+    }
+
+    if (++iterations >= 1000) {
+      break;
+    }
+
+    // if we get here, all slots are busy
+    CONDITION_LOCKER(guard, _condition);
+    if (! hasWaited) {
+      ++_waiting;
+      hasWaited = true;
+    }
+
+    if (_freeSlots.load() < 3) {
+      guard.wait(10 * 1000);
+    }
+  }
+
+  if (hasWaited) {
+    CONDITION_LOCKER(guard, _condition);
+    TRI_ASSERT(_waiting > 0);
+    --_waiting;
+  }
+
+  return SlotInfo(TRI_ERROR_ARANGO_NO_JOURNAL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief try to reserve a slot in the open handout region without
+/// acquiring the slots lock. returns a SlotInfo without slot and error if
+/// the caller must fall back to the slow path
+///
+/// the slot and the marker memory are reserved with a single fetch-add on
+/// the reservation word, so slots and memory are handed out in the same
+/// order. the caller must have claimed one slot, which is given back if no
+/// slot is returned
+////////////////////////////////////////////////////////////////////////////////
+
+SlotInfo Slots::reserveFast (uint32_t size,
+                             uint32_t alignedSize,
+                             TRI_voc_cid_t cid,
+                             TRI_shape_sid_t sid,
+                             uint32_t legendOffset,
+                             void** oldLegend,
+                             uint64_t& generation) {
+  // don't register while the region is closed, so closing it does not need
+  // to wait for threads that will fail anyway
+  if ((_reservation.load() & HandoutClosed) != 0) {
+    releaseSlots(1);
+    return SlotInfo();
+  }
+
+  ++_reservers;
+
+  if ((_reservation.load() & HandoutClosed) != 0) {
+    --_reservers;
+    releaseSlots(1);
+    return SlotInfo();
+  }
+
+  // the region cannot be closed and reopened while we are registered, so
+  // the handout variables are stable from here on
+  generation = _handoutGeneration;
+
+  if (oldLegend != nullptr && legendOffset == 0) {
+    // legends cached for the logfile belong to markers reserved before
+    // this one
+    void* legend = _logfile->lookupLegend(cid, sid);
+
+    if (legend == nullptr) {
+      // Bad, we would need a legend for this marker
+      --_reservers;
+      releaseSlots(1);
+      return SlotInfo(TRI_ERROR_LEGEND_NOT_IN_WAL_FILE);
+    }
+
+    *oldLegend = legend;
+  }
+
+  uint64_t word = _reservation.fetch_add(HandoutSlot + alignedSize);
+  uint64_t offset = word & HandoutBytes;
+
+  if ((word & HandoutClosed) != 0 ||
+      offset + alignedSize > static_cast<uint64_t>(_handoutLimit)) {
+    // the marker does not fit. close the region, so all following
+    // reservations take the slow path, too
+    _reservation.fetch_or(HandoutClosed);
+    --_reservers;
+    releaseSlots(1);
+    return SlotInfo();
+  }
+
+  // as space is reserved in slot order, all reservations before this one
+  // have succeeded, too
+  uint64_t position = (word >> 32);
+  uint64_t ordinal = _handoutBase + position;
+
+  Slot* slot = &_slots[(_handoutIndex + static_cast<size_t>(position)) % _numberOfSlots];
+  TRI_ASSERT(slot->isUnused());
+
+  char* mem = _handoutMem + offset;
+
+  // ticks must increase in slot order. the predecessor is past its
+  // reservation already, so this only waits for it to fetch its tick
+  while (_ticksAssigned.load(std::memory_order_acquire) != ordinal) {
+    std::this_thread::yield();
+  }
+
+  _lastAssignedTick = static_cast<Slot::TickType>(TRI_NewTickServer());
+  slot->setUsed(static_cast<void*>(mem), size, _logfile->id(), _lastAssignedTick);
+
+  _handoutEnd.store(static_cast<uint32_t>(offset + alignedSize), std::memory_order_release);
+  _ticksAssigned.store(ordinal + 1, std::memory_order_release);
+
+  if (oldLegend != nullptr && legendOffset != 0) {
+    void* legend = static_cast<void*>(mem + legendOffset);
+    _logfile->cacheLegend(cid, sid, legend);
+  }
+
+  --_reservers;
+
+  return SlotInfo(slot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief reserve a slot, rotating the logfile if required
+/// this must be called with the slots lock held and the handout closed
+////////////////////////////////////////////////////////////////////////////////
+
+SlotInfo Slots::reserveLocked (uint32_t size,
+                               uint32_t alignedSize,
+                               TRI_voc_cid_t cid,
+                               TRI_shape_sid_t sid,
+                               uint32_t legendOffset,
+                               void** oldLegend) {
+  TRI_ASSERT(! _handoutOpen);
+
+  Slot* slot = &_slots[_handoutIndex];
+  TRI_ASSERT(slot->isUnused());
+
+  // cycle until we have a valid logfile
+  while (_logfile == nullptr ||
+         _logfile->freeSize() < static_cast<uint64_t>(alignedSize)) {
+
+    if (_logfile != nullptr) {
+      // seal existing logfile by creating a footer marker
+      int res = writeFooter(slot);
+
+      if (res != TRI_ERROR_NO_ERROR) {
+        return SlotInfo(res);
+      }
+
+      // advance to next slot
+      slot = &_slots[_handoutIndex];
+      _logfileManager->setLogfileSealRequested(_logfile);
+
+      _logfile = nullptr;
+    }
+
+    // fetch the next free logfile (this may create a new one)
+    Logfile::StatusType status = newLogfile(alignedSize);
+
+    if (_logfile == nullptr) {
+      usleep(10 * 1000);
+
+      TRI_IF_FAILURE("LogfileManagerGetWriteableLogfile") {
+        return SlotInfo(TRI_ERROR_ARANGO_NO_JOURNAL);
+      }
+
+      // try again in next iteration
+    }
+    else if (status == Logfile::StatusType::EMPTY) {
+      // inititialise the empty logfile by writing a header marker
+      int res = writeHeader(slot);
+
+      if (res != TRI_ERROR_NO_ERROR) {
+        return SlotInfo(res);
+      }
+
+      // advance to next slot
+      slot = &_slots[_handoutIndex];
+      _logfileManager->setLogfileOpen(_logfile);
+    }
+    else {
+      TRI_ASSERT(status == Logfile::StatusType::OPEN);
+    }
+  }
+
+  // if we get here, we got a free slot for the actual data...
+
+  // Now sort out the legend business:
+  if (oldLegend != nullptr && legendOffset == 0) {
+    void* legend = _logfile->lookupLegend(cid, sid);
+    if (nullptr == legend) {
+      // Bad, we would need a legend for this marker
+      return SlotInfo(TRI_ERROR_LEGEND_NOT_IN_WAL_FILE);
+    }
+    *oldLegend = legend;
+  }
+
+  char* mem = _logfile->reserve(alignedSize);
+
+  if (mem == nullptr) {
+    return SlotInfo(TRI_ERROR_INTERNAL);
+  }
+
+  if (oldLegend != nullptr && legendOffset != 0) {
+    void* legend = static_cast<void*>(mem + legendOffset);
+    _logfile->cacheLegend(cid, sid, legend);
+  }
+
+  // only in this case we return a valid slot
+  slot->setUsed(static_cast<void*>(mem), size, _logfile->id(), handout());
+
+  return SlotInfo(slot);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief close a logfile
 ////////////////////////////////////////////////////////////////////////////////
@@ -576,81 +744,99 @@ int Slots::closeLogfile (Slot::TickType& lastCommittedTick,
   worked = false;
 
   while (++iterations < 1000) {
-    {
-      MUTEX_LOCKER(_lock);
+    // sealing the logfile and initialising the next one needs up to two
+    // slots
+    if (claimSlots(2)) {
+      if (hasWaited) {
+        CONDITION_LOCKER(guard, _condition);
+        TRI_ASSERT(_waiting > 0);
+        --_waiting;
+        hasWaited = false;
+      }
 
-      lastCommittedTick = _lastCommittedTick;
+      int res = TRI_ERROR_NO_ERROR;
+      bool tryAgain = false;
 
-      Slot* slot = &_slots[_handoutIndex];
-      TRI_ASSERT(slot != nullptr);
+      {
+        MUTEX_LOCKER(_lock);
 
-      if (slot->isUnused()) {
-        if (hasWaited) {
-          CONDITION_LOCKER(guard, _condition);
-          TRI_ASSERT(_waiting > 0);
-          --_waiting;
-          hasWaited = false;
-        }
+        closeHandout();
 
-        if (_logfile != nullptr) {
-          if (_logfile->status() == Logfile::StatusType::EMPTY) {
-            // no need to seal a still-empty logfile
-            return TRI_ERROR_NO_ERROR;
-          }
+        uint64_t const ticksAssigned = _ticksAssigned.load();
+        lastCommittedTick = _lastCommittedTick;
 
-          // seal existing logfile by creating a footer marker
-          int res = writeFooter(slot);
+        Slot* slot = &_slots[_handoutIndex];
+        TRI_ASSERT(slot->isUnused());
 
-          if (res != TRI_ERROR_NO_ERROR) {
-            LOG_ERROR("could not write logfile footer: %s", TRI_errno_string(res));
-            return res;
-          }
+        if (_logfile != nullptr &&
+            _logfile->status() == Logfile::StatusType::EMPTY) {
+          // no need to seal a still-empty logfile
+        }
+        else {
+          if (_logfile != nullptr) {
+            // seal existing logfile by creating a footer marker
+            res = writeFooter(slot);
 
-          _logfileManager->setLogfileSealRequested(_logfile);
+            if (res != TRI_ERROR_NO_ERROR) {
+              LOG_ERROR("could not write logfile footer: %s", TRI_errno_string(res));
+            }
+            else {
+              _logfileManager->setLogfileSealRequested(_logfile);
 
-          // advance to next slot
-          slot = &_slots[_handoutIndex];
+              // advance to next slot
+              slot = &_slots[_handoutIndex];
 
-          // invalidate the logfile so for the next write we'll use a
-          // new one
-          _logfile = nullptr;
+              // invalidate the logfile so for the next write we'll use a
+              // new one
+              _logfile = nullptr;
+            }
+          }
 
-          // fall-through intentional
-        }
+          if (res == TRI_ERROR_NO_ERROR) {
+            TRI_ASSERT(_logfile == nullptr);
+            // fetch the next free logfile (this may create a new one)
+            // note: as we don't have a real marker to write the size does
+            // not matter (we use a size of 1 as  it must be > 0)
+            Logfile::StatusType status = newLogfile(1);
 
-        TRI_ASSERT(_logfile == nullptr);
-        // fetch the next free logfile (this may create a new one)
-        // note: as we don't have a real marker to write the size does
-        // not matter (we use a size of 1 as  it must be > 0)
-        Logfile::StatusType status = newLogfile(1);
+            if (_logfile == nullptr) {
+              tryAgain = true;
 
-        if (_logfile == nullptr) {
-          TRI_IF_FAILURE("LogfileManagerGetWriteableLogfile") {
-            return TRI_ERROR_ARANGO_NO_JOURNAL;
+              TRI_IF_FAILURE("LogfileManagerGetWriteableLogfile") {
+                res = TRI_ERROR_ARANGO_NO_JOURNAL;
+                tryAgain = false;
+              }
+            }
+            else if (status == Logfile::StatusType::EMPTY) {
+              // inititialise the empty logfile by writing a header marker
+              res = writeHeader(slot);
+
+              if (res != TRI_ERROR_NO_ERROR) {
+                LOG_ERROR("could not write logfile header: %s", TRI_errno_string(res));
+              }
+              else {
+                _logfileManager->setLogfileOpen(_logfile);
+                worked = true;
+              }
+            }
+            else {
+              TRI_ASSERT(status == Logfile::StatusType::OPEN);
+              worked = false;
+            }
           }
-
-          usleep(10 * 1000);
-          // try again in next iteration
         }
-        else if (status == Logfile::StatusType::EMPTY) {
-          // inititialise the empty logfile by writing a header marker
-          int res = writeHeader(slot);
 
-          if (res != TRI_ERROR_NO_ERROR) {
-            LOG_ERROR("could not write logfile header: %s", TRI_errno_string(res));
-            return res;
-          }
+        releaseSlots(2 - static_cast<size_t>(_ticksAssigned.load() - ticksAssigned));
+        openHandout();
+      }
 
-          _logfileManager->setLogfileOpen(_logfile);
-          worked = true;
-          return TRI_ERROR_NO_ERROR;
-        }
-        else {
-          TRI_ASSERT(status == Logfile::StatusType::OPEN);
-          worked = false;
-          return TRI_ERROR_NO_ERROR;
-        }
+      if (! tryAgain) {
+        return res;
       }
+
+      usleep(10 * 1000);
+      // try again in next iteration
+      continue;
     }
 
     // if we get here, all slots are busy
@@ -660,17 +846,17 @@ int Slots::closeLogfile (Slot::TickType& lastCommittedTick,
       hasWaited = true;
     }
 
-    bool mustWait;
-    {
-      MUTEX_LOCKER(_lock);
-      mustWait = (_freeSlots == 0);
-    }
-
-    if (mustWait) {
+    if (_freeSlots.load() < 2) {
       guard.wait(10 * 1000);
     }
   }
 
+  if (hasWaited) {
+    CONDITION_LOCKER(guard, _condition);
+    TRI_ASSERT(_waiting > 0);
+    --_waiting;
+  }
+
   return TRI_ERROR_ARANGO_NO_JOURNAL;
 }
 
@@ -713,12 +899,108 @@ int Slots::writeFooter (Slot* slot) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief handout a region and advance the handout index
+/// @brief claim the specified number of free slots
+////////////////////////////////////////////////////////////////////////////////
+
+bool Slots::claimSlots (size_t count) {
+  size_t freeSlots = _freeSlots.load();
+
+  while (freeSlots >= count) {
+    if (_freeSlots.compare_exchange_weak(freeSlots, freeSlots - count)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief give back claimed slots that were not used
+////////////////////////////////////////////////////////////////////////////////
+
+void Slots::releaseSlots (size_t count) {
+  if (count > 0) {
+    _freeSlots += count;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief open the handout region for lock-free reservations at the
+/// current write position of the current logfile
+/// this must be called with the slots lock held
+////////////////////////////////////////////////////////////////////////////////
+
+void Slots::openHandout () {
+  TRI_ASSERT(! _handoutOpen);
+
+  // a thread may have registered after closeHandout() stopped waiting. it
+  // sees the closed region and leaves, but must be gone before the
+  // handout variables change
+  while (_reservers.load() != 0) {
+    std::this_thread::yield();
+  }
+
+  if (_logfile == nullptr ||
+      _logfile->status() != Logfile::StatusType::OPEN) {
+    // the next reservation will fetch a new logfile under the lock
+    return;
+  }
+
+  uint64_t freeSize = _logfile->freeSize();
+
+  if (freeSize > static_cast<uint64_t>(HandoutBytes)) {
+    freeSize = static_cast<uint64_t>(HandoutBytes);
+  }
+
+  _handoutMem        = _logfile->df()->_next;
+  _handoutLimit      = static_cast<uint32_t>(freeSize);
+  _handoutBase       = _ticksAssigned.load();
+  _handoutEnd        = 0;
+  _handoutOpen       = true;
+  ++_handoutGeneration;
+
+  // publish the values above to the threads reserving in the region
+  _reservation.store(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief close the handout region, wait for reservations still in flight
+/// and account for the reserved space in the logfile
+/// this must be called with the slots lock held
+////////////////////////////////////////////////////////////////////////////////
+
+void Slots::closeHandout () {
+  if (! _handoutOpen) {
+    return;
+  }
+
+  _reservation.fetch_or(HandoutClosed);
+
+  // reservations in flight have either failed or will get their ticks
+  // soon. none of them needs the slots lock
+  while (_reservers.load() != 0) {
+    std::this_thread::yield();
+  }
+
+  uint64_t handedOut = _ticksAssigned.load() - _handoutBase;
+
+  if (handedOut > 0) {
+    TRI_ASSERT(_handoutMem == _logfile->df()->_next);
+    _logfile->reserve(_handoutEnd.load());
+    _handoutIndex = (_handoutIndex + static_cast<size_t>(handedOut)) % _numberOfSlots;
+  }
+
+  _handoutEnd  = 0;
+  _handoutOpen = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief handout a region and advance the handout index. the slot must
+/// have been claimed before
 ////////////////////////////////////////////////////////////////////////////////
 
 Slot::TickType Slots::handout () {
-  TRI_ASSERT(_freeSlots > 0);
-  _freeSlots--;
+  TRI_ASSERT(! _handoutOpen);
 
   if (++_handoutIndex ==_numberOfSlots) {
     // wrap around
@@ -726,6 +1008,8 @@ Slot::TickType Slots::handout () {
   }
  
   _lastAssignedTick = static_cast<Slot::TickType>(TRI_NewTickServer());
+  ++_ticksAssigned;
+
   return _lastAssignedTick;
 }
 
@@ -752,6 +1036,39 @@ bool Slots::waitForTick (Slot::TickType tick) {
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invoke all sync callbacks up to the specified tick with the
+/// specified result
+////////////////////////////////////////////////////////////////////////////////
+
+void Slots::notifySyncCallbacks (Slot::TickType tick,
+                                 int result) {
+  std::vector<std::pair<Slot::TickType, SyncCallback>> callbacks;
+
+  {
+    CONDITION_LOCKER(guard, _condition);
+
+    if (_syncCallbacks.empty()) {
+      return;
+    }
+
+    // move all callbacks for synced ticks to the end and take them out
+    auto it = std::partition(_syncCallbacks.begin(), _syncCallbacks.end(), 
+                             [&tick] (std::pair<Slot::TickType, SyncCallback> const& value) {
+                               return value.first > tick;
+                             });
+
+    callbacks.reserve(static_cast<size_t>(_syncCallbacks.end() - it));
+    std::move(it, _syncCallbacks.end(), std::back_inserter(callbacks));
+    _syncCallbacks.erase(it, _syncCallbacks.end());
+  }
+
+  // invoke the callbacks without holding the lock
+  for (auto& it : callbacks) {
+    it.second(result);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief request a new logfile which can satisfy a marker of the
 /// specified size
@@ -42,6 +42,13 @@ namespace triagens {
 
     class LogfileManager;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief callback invoked when a slot has been synced to disk. the argument
+/// is the result of the sync operation
+////////////////////////////////////////////////////////////////////////////////
+
+    typedef std::function<void(int)> SyncCallback;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                               struct SlotInfoCopy
 // -----------------------------------------------------------------------------
@@ -179,6 +186,31 @@ namespace triagens {
         void returnUsed (SlotInfo&,
                          bool);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return a used slot and request its synchronisation, without
+/// waiting for it. the callback is invoked by the synchroniser thread once
+/// the slot has been synced to disk
+////////////////////////////////////////////////////////////////////////////////
+
+        void returnUsed (SlotInfo&,
+                         SyncCallback const&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invoke all pending sync callbacks with an error code. this is
+/// called on shutdown for callbacks whose slots could not be synced
+////////////////////////////////////////////////////////////////////////////////
+
+        void abortSyncCallbacks (int);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invoke the sync callbacks of a region with an error code. this is
+/// called when syncing the region failed. the region itself is kept and
+/// will be synced again later
+////////////////////////////////////////////////////////////////////////////////
+
+        void abortSyncRegion (SyncRegion const&,
+                              int);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief get the next synchronisable region
 ////////////////////////////////////////////////////////////////////////////////
@@ -233,7 +265,73 @@ namespace triagens {
         int writeFooter (Slot*);
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief handout a region and advance the handout index
+/// @brief return the next unused slot. oldLegend is a nullptr for markers
+/// without legends
+////////////////////////////////////////////////////////////////////////////////
+
+        SlotInfo reserveSlot (uint32_t,
+                              TRI_voc_cid_t,
+                              TRI_shape_sid_t,
+                              uint32_t,
+                              void**);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief try to reserve a slot in the open handout region without
+/// acquiring the slots lock. returns a SlotInfo without slot and error if
+/// the caller must fall back to the slow path
+////////////////////////////////////////////////////////////////////////////////
+
+        SlotInfo reserveFast (uint32_t,
+                              uint32_t,
+                              TRI_voc_cid_t,
+                              TRI_shape_sid_t,
+                              uint32_t,
+                              void**,
+                              uint64_t&);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief reserve a slot, rotating the logfile if required
+/// this must be called with the slots lock held and the handout closed
+////////////////////////////////////////////////////////////////////////////////
+
+        SlotInfo reserveLocked (uint32_t,
+                                uint32_t,
+                                TRI_voc_cid_t,
+                                TRI_shape_sid_t,
+                                uint32_t,
+                                void**);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief claim the specified number of free slots
+////////////////////////////////////////////////////////////////////////////////
+
+        bool claimSlots (size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief give back claimed slots that were not used
+////////////////////////////////////////////////////////////////////////////////
+
+        void releaseSlots (size_t);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief open the handout region for lock-free reservations at the
+/// current write position of the current logfile
+/// this must be called with the slots lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void openHandout ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief close the handout region, wait for reservations still in flight
+/// and account for the reserved space in the logfile
+/// this must be called with the slots lock held
+////////////////////////////////////////////////////////////////////////////////
+
+        void closeHandout ();
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief handout a region and advance the handout index. the slot must
+/// have been claimed before
 ////////////////////////////////////////////////////////////////////////////////
 
         Slot::TickType handout ();
@@ -244,6 +342,14 @@ namespace triagens {
 
         bool waitForTick (Slot::TickType);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief invoke all sync callbacks up to the specified tick with the
+/// specified result
+////////////////////////////////////////////////////////////////////////////////
+
+        void notifySyncCallbacks (Slot::TickType,
+                                  int);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief request a new logfile which can satisfy a marker of the
 /// specified size
@@ -288,10 +394,11 @@ namespace triagens {
         size_t const _numberOfSlots;
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief the number of currently free slots
+/// @brief the number of currently free slots. slots are claimed by
+/// decreasing this value before they are handed out
 ////////////////////////////////////////////////////////////////////////////////
 
-        size_t _freeSlots;
+        std::atomic<size_t> _freeSlots;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief whether or not someone is waiting for a slot
@@ -300,11 +407,71 @@ namespace triagens {
         uint32_t _waiting;
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief the index of the slot to hand out next
+/// @brief the index of the slot to hand out next. while the handout region
+/// is open, this is the index of its first slot
 ////////////////////////////////////////////////////////////////////////////////
 
         size_t _handoutIndex;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the reservation word of the handout region. the upper half
+/// counts the slots and the lower half the bytes reserved in the region.
+/// the topmost bit is set when the region is closed
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> _reservation;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of threads currently reserving in the handout region
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint32_t> _reservers;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of slots that have been assigned a tick so far. ticks are
+/// assigned in slot order
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint64_t> _ticksAssigned;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief bytes of the handout region used by slots that have been
+/// assigned a tick
+////////////////////////////////////////////////////////////////////////////////
+
+        std::atomic<uint32_t> _handoutEnd;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief start of the handout region in the current logfile
+////////////////////////////////////////////////////////////////////////////////
+
+        char* _handoutMem;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of bytes available in the handout region
+////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t _handoutLimit;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief value of _ticksAssigned when the handout region was opened
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _handoutBase;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of times the handout region has been opened
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t _handoutGeneration;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the handout region is open and not yet accounted
+/// for in the current logfile
+////////////////////////////////////////////////////////////////////////////////
+
+        bool _handoutOpen;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief the index of the slot to recycle
 ////////////////////////////////////////////////////////////////////////////////
@@ -324,10 +491,11 @@ namespace triagens {
         Slot::TickType _lastAssignedTick;
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief last committed tick value
+/// @brief last committed tick value. this is only modified under the slots
+/// lock, but can be read without it
 ////////////////////////////////////////////////////////////////////////////////
 
-        Slot::TickType _lastCommittedTick;
+        std::atomic<Slot::TickType> _lastCommittedTick;
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief last committed data tick value
@@ -339,7 +507,13 @@ namespace triagens {
 /// @brief number of log events handled
 ////////////////////////////////////////////////////////////////////////////////
 
-        uint64_t _numEvents;
+        std::atomic<uint64_t> _numEvents;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief callbacks waiting for the sync of a tick, protected by _condition
+////////////////////////////////////////////////////////////////////////////////
+
+        std::vector<std::pair<Slot::TickType, SyncCallback>> _syncCallbacks;
 
     };
 
@@ -32,6 +32,7 @@
 #include "Basics/logging.h"
 #include "Basics/ConditionLocker.h"
 #include "Basics/Exceptions.h"
+#include "Basics/system-functions.h"
 #include "VocBase/server.h"
 #include "Wal/LogfileManager.h"
 #include "Wal/Slots.h"
@@ -52,13 +53,18 @@ using namespace triagens::wal;
 ////////////////////////////////////////////////////////////////////////////////
 
 SynchroniserThread::SynchroniserThread (LogfileManager* logfileManager,
-                                        uint64_t syncInterval)
+                                        uint64_t syncInterval,
+                                        uint64_t groupCommitDelay,
+                                        uint32_t groupCommitSize)
   : Thread("WalSynchroniser"),
     _logfileManager(logfileManager),
     _condition(),
     _waiting(0),
+    _waitingForSync(0),
     _stop(0),
     _syncInterval(syncInterval),
+    _groupCommitDelay(groupCommitDelay),
+    _groupCommitSize(groupCommitSize),
     _logfileCache() {
 
   allowAsynchronousCancelation();
@@ -96,9 +102,12 @@ void SynchroniserThread::stop () {
 /// @brief signal that we need a sync
 ////////////////////////////////////////////////////////////////////////////////
 
-void SynchroniserThread::signalSync () {
+void SynchroniserThread::signalSync (bool waitForSync) {
   CONDITION_LOCKER(guard, _condition);
   ++_waiting;
+  if (waitForSync) {
+    ++_waitingForSync;
+  }
   _condition.signal();
 }
 
@@ -116,10 +125,16 @@ void SynchroniserThread::run () {
   while (true) {
     int stop = (int) _stop;
     uint32_t waiting = 0;
+    uint32_t waitingForSync = 0;
+
+    if (stop == 0 && _groupCommitDelay > 0) {
+      waitForGroupCommit();
+    }
 
     {
       CONDITION_LOCKER(guard, _condition);
       waiting = _waiting;
+      waitingForSync = _waitingForSync;
     }
 
     // go on without the lock
@@ -155,6 +170,11 @@ void SynchroniserThread::run () {
       _waiting -= waiting;
     }
 
+    if (waitingForSync > 0) {
+      TRI_ASSERT(_waitingForSync >= waitingForSync);
+      _waitingForSync -= waitingForSync;
+    }
+
     if (_waiting == 0 && stop == 0) {
       // sleep if nothing to do
       guard.wait(_syncInterval);
@@ -168,6 +188,10 @@ void SynchroniserThread::run () {
     // next iteration
   }
 
+  // everything that could be synced has been synced now. notify the callers
+  // that still wait for a sync that this is not going to happen anymore
+  _logfileManager->slots()->abortSyncCallbacks(TRI_ERROR_ARANGO_MSYNC_FAILED);
+
   _stop = 2;
 }
 
@@ -201,6 +225,10 @@ int SynchroniserThread::doSync (bool& checkMore) {
   void** mmHandle = nullptr;
   bool result = TRI_MSync(fd, mmHandle, region.mem, region.mem + region.size);
 
+  TRI_IF_FAILURE("SynchroniserThreadSync") {
+    result = false;
+  }
+
   LOG_TRACE("syncing logfile %llu, region %p - %p, length: %lu, wfs: %s",
             (unsigned long long) id,
             region.mem,
@@ -211,6 +239,10 @@ int SynchroniserThread::doSync (bool& checkMore) {
   if (! result) {
     LOG_ERROR("unable to sync wal logfile region");
 
+    // tell the callers waiting for the region that their data did not make
+    // it to disk. the region will be synced again in the next iteration
+    _logfileManager->slots()->abortSyncRegion(region, TRI_ERROR_ARANGO_MSYNC_FAILED);
+
     return TRI_ERROR_ARANGO_MSYNC_FAILED;
   }
 
@@ -251,6 +283,36 @@ int SynchroniserThread::doSync (bool& checkMore) {
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief wait until enough sync requests have been gathered for a group
+/// commit or the group commit delay is over
+///
+/// only sync requests that arrived since the last sync are delayed. if the
+/// previous sync took long enough, the requests were already gathered while
+/// it ran and the next sync is started immediately
+////////////////////////////////////////////////////////////////////////////////
+
+void SynchroniserThread::waitForGroupCommit () {
+  CONDITION_LOCKER(guard, _condition);
+
+  if (_waiting == 0 || _waitingForSync >= _groupCommitSize) {
+    // nothing to do or batch already full
+    return;
+  }
+
+  double const end = TRI_microtime() + static_cast<double>(_groupCommitDelay) / 1000000.0;
+
+  while (_stop == 0 && _waitingForSync < _groupCommitSize) {
+    double const now = TRI_microtime();
+
+    if (now >= end) {
+      break;
+    }
+
+    guard.wait(static_cast<uint64_t>((end - now) * 1000000.0) + 1);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief get a logfile descriptor (it caches the descriptor for performance)
 ////////////////////////////////////////////////////////////////////////////////
@@ -66,7 +66,9 @@ namespace triagens {
 ////////////////////////////////////////////////////////////////////////////////
 
         SynchroniserThread (LogfileManager*,
-                            uint64_t);
+                            uint64_t,
+                            uint64_t,
+                            uint32_t);
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief destroy the synchroniser thread
@@ -87,10 +89,11 @@ namespace triagens {
         void stop ();
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief signal that a sync is needed
+/// @brief signal that a sync is needed. the flag indicates whether the
+/// caller waits for the sync
 ////////////////////////////////////////////////////////////////////////////////
 
-        void signalSync ();
+        void signalSync (bool);
 
 // -----------------------------------------------------------------------------
 // --SECTION--                                                    Thread methods
@@ -116,6 +119,13 @@ namespace triagens {
 
         int doSync (bool&);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief wait until enough sync requests have been gathered for a group
+/// commit or the group commit delay is over
+////////////////////////////////////////////////////////////////////////////////
+
+        void waitForGroupCommit ();
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief get a logfile descriptor (it caches the descriptor for performance)
 ////////////////////////////////////////////////////////////////////////////////
@@ -146,6 +156,12 @@ namespace triagens {
 
         uint32_t _waiting;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of requests waiting for a sync
+////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t _waitingForSync;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief stop flag
 ////////////////////////////////////////////////////////////////////////////////
@@ -158,6 +174,20 @@ namespace triagens {
 
         uint64_t const _syncInterval;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief maximum time (in microseconds) to delay a sync to gather more
+/// sync requests for a group commit
+////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t const _groupCommitDelay;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief number of waiting sync requests that triggers a group commit
+/// without further delay
+////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t const _groupCommitSize;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief logfile descriptor cache
 ////////////////////////////////////////////////////////////////////////////////
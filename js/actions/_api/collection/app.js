@@ -70,6 +70,7 @@ function collectionRepresentation (collection, showProperties, showCount, showFi
     result.keyOptions    = properties.keyOptions;
     result.waitForSync   = properties.waitForSync;
     result.indexBuckets  = properties.indexBuckets;
+    result.compressDatafiles = properties.compressDatafiles;
 
     if (cluster.isCoordinator()) {
       result.shardKeys = properties.shardKeys;
@@ -141,6 +142,10 @@ function parseBodyForCreateCollection (req, res) {
     r.parameter.indexBuckets = body.indexBuckets;
   }
 
+  if (body.hasOwnProperty("compressDatafiles")) {
+    r.parameter.compressDatafiles = body.compressDatafiles;
+  }
+
   if (body.hasOwnProperty("keyOptions")) {
     r.parameter.keyOptions = body.keyOptions;
   }
@@ -190,6 +195,11 @@ function parseBodyForCreateCollection (req, res) {
 /// - *doCompact* (optional, default is *true*): whether or not the collection
 ///   will be compacted.
 ///
+/// - *compressDatafiles* (optional, default is *false*): whether or not the
+///   compactor will write the datafiles of the collection in compressed form.
+///   Compressed datafiles use less disk space. Their blocks are decompressed
+///   when they are read, and are kept in a cache of limited size.
+///
 /// - *journalSize* (optional, default is a configuration parameter): The 
 ///   maximal size of a journal or datafile in bytes. The value 
 ///   must be at least `1048576` (1 MiB).
@@ -478,6 +488,9 @@ function get_api_collections (req, res) {
 ///
 /// - *doCompact*: Whether or not the collection will be compacted.
 ///
+/// - *compressDatafiles*: Whether or not the compactor will write the
+///   datafiles of the collection in compressed form.
+///
 /// - *journalSize*: The maximal size setting for journals / datafiles
 ///   in bytes.
 ///
@@ -639,6 +652,26 @@ function get_api_collections (req, res) {
 /// - *figures.compactors.count*: The number of compactor files.
 /// - *figures.compactors.fileSize*: The total filesize of all compactor files (in bytes).
 ///
+/// - *figures.compaction.count*: The number of compaction runs since the
+///   collection was loaded.
+/// - *figures.compaction.files*: The number of datafiles compacted since the
+///   collection was loaded.
+/// - *figures.compaction.bytesRead*: The total size of the compacted datafile data
+///   (in bytes).
+/// - *figures.compaction.bytesWritten*: The total size of the data rewritten by
+///   the compaction (in bytes).
+/// - *figures.compaction.bytesReclaimed*: The difference between *bytesRead* and
+///   *bytesWritten* (in bytes).
+///
+/// - *figures.pageFaults.minor*: The number of minor page faults that occurred
+///   while the collection was loaded or compacted.
+/// - *figures.pageFaults.major*: The number of major page faults, which required
+///   reading from disk, that occurred while the collection was loaded or compacted.
+///
+/// - *figures.headers.count*: The number of document headers in use.
+/// - *figures.headers.size*: The total memory allocated for document headers
+///   (in bytes).
+///
 /// * *figures.shapefiles.count*: The number of shape files. This value is
 ///   deprecated and kept for compatibility reasons only. The value will always
 ///   be 0 since ArangoDB 2.0 and higher.
@@ -1227,6 +1260,11 @@ function put_api_collection_truncate (req, res, collection) {
 ///   additional journals or datafiles that are created. Already
 ///   existing journals or datafiles will not be affected.
 ///
+/// - *compressDatafiles*: Whether or not the compactor will write the
+///   datafiles of the collection in compressed form. Changing the value
+///   only affects datafiles that are compacted afterwards. Compressed
+///   datafiles do not use less memory, see above.
+///
 /// On success an object with the following attributes is returned:
 ///
 /// - *id*: The identifier of the collection.
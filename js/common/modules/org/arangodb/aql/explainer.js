@@ -448,7 +448,19 @@ function processQuery (query, explain) {
         return keyword("EMPTY") + "   " + annotation("/* empty result set */");
       case "EnumerateCollectionNode":
         collectionVariables[node.outVariable.id] = node.collection;
+        if (node.filterVariable) {
+          return keyword("FOR") + " " + variableName(node.outVariable) + " " + keyword("IN") + " " + collection(node.collection) + " " + 
+                 node.filterCalculations.map(function(calculation) {
+                   return keyword("LET") + " " + variableName(calculation.outVariable) + " = " + buildExpression(calculation.expression);
+                 }).join(" ") + " " + keyword("FILTER") + " " + variableName(node.filterVariable) + "   " + 
+                 annotation("/* full collection scan" + (node.random ? ", random order" : "") + ", filtered by " + node.parallelism + " threads */");
+        }
         return keyword("FOR") + " " + variableName(node.outVariable) + " " + keyword("IN") + " " + collection(node.collection) + "   " + annotation("/* full collection scan" + (node.random ? ", random order" : "") + " */");
+      case "HashJoinNode":
+        collectionVariables[node.outVariable.id] = node.collection;
+        return keyword("FOR") + " " + variableName(node.outVariable) + " " + keyword("IN") + " " + collection(node.collection) + " " + 
+               keyword("FILTER") + " " + buildExpression(node.collectionExpression) + " == " + buildExpression(node.inputExpression) + "   " + 
+               annotation("/* hash join, hash table for " + (node.hashCollection ? "collection" : "input rows") + " */");
       case "EnumerateListNode":
         return keyword("FOR") + " " + variableName(node.outVariable) + " " + keyword("IN") + " " + variableName(node.inVariable) + "   " + annotation("/* list iteration */");
       case "IndexRangeNode":
@@ -474,7 +486,7 @@ function processQuery (query, explain) {
       case "SortNode":
         return keyword("SORT") + " " + node.elements.map(function(node) {
           return variableName(node.inVariable) + " " + keyword(node.ascending ? "ASC" : "DESC"); 
-        }).join(", ");
+        }).join(", ") + (node.limit > 0 ? "   " + annotation("/* sorting strategy: top " + node.limit + " */") : "");
       case "LimitNode":
         return keyword("LIMIT") + " " + value(JSON.stringify(node.offset)) + ", " + value(JSON.stringify(node.limit)); 
       case "ReturnNode":
@@ -532,6 +544,7 @@ function processQuery (query, explain) {
     if ([ "EnumerateCollectionNode",
           "EnumerateListNode",
           "IndexRangeNode",
+          "HashJoinNode",
           "SubqueryNode" ].indexOf(node.type) !== -1) {
       level++;
     }
@@ -63,6 +63,14 @@ function FiguresSuite () {
       var f = c1.figures();
       assertEqual(0, f.datafiles.count);
       assertEqual(0, f.compactors.count);
+      assertEqual(0, f.compaction.count);
+      assertEqual(0, f.compaction.files);
+      assertEqual(0, f.compaction.bytesRead);
+      assertEqual(0, f.compaction.bytesWritten);
+      assertEqual(0, f.compaction.bytesReclaimed);
+      assertEqual("number", typeof f.pageFaults.minor);
+      assertEqual("number", typeof f.pageFaults.major);
+      assertEqual(0, f.headers.count);
       assertEqual(0, f.shapefiles.count);
       assertEqual(0, f.shapefiles.fileSize);
       assertEqual(0, f.alive.count);
@@ -116,6 +124,8 @@ function FiguresSuite () {
       assertTrue(f.journals.fileSize > 0);
       assertEqual(2, f.alive.count);
       assertNotEqual(0, f.alive.size);
+      assertEqual(2, f.headers.count);
+      assertTrue(f.headers.size > 0);
       assertEqual(0, f.dead.count);
       assertEqual(0, f.dead.size);
       assertEqual(0, f.dead.deletion);
@@ -1,5 +1,5 @@
 /*jshint globalstrict:false, strict:false */
-/*global assertEqual, assertTrue, assertEqual */
+/*global assertEqual, assertTrue, assertEqual, fail */
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief test the hash index, selectivity estimates
@@ -30,6 +30,7 @@
 
 var jsunity = require("jsunity");
 var internal = require("internal");
+var testHelper = require("org/arangodb/test-helper").Helper;
 
 // -----------------------------------------------------------------------------
 // --SECTION--                                                     basic methods
@@ -158,6 +159,220 @@ function HashIndexSuite() {
   };
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite: unique hash index growth and bulk loading
+////////////////////////////////////////////////////////////////////////////////
+
+function UniqueHashIndexSuite() {
+  'use strict';
+  var ERRORS = internal.errors;
+  var cn = "UnitTestsCollectionHash";
+  var n = 20000;
+  var collection = null;
+
+  var lookup = function (c, idx, value) {
+    return c.byExampleHash(idx.id, { value: value }).toArray().map(function(doc) {
+      return doc._key;
+    });
+  };
+
+  var assertUniqueViolation = function (c, doc) {
+    try {
+      c.save(doc);
+      fail();
+    }
+    catch (err) {
+      assertEqual(ERRORS.ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED.code, err.errorNum);
+    }
+  };
+
+  var makeValue = function (i) {
+    switch (i % 6) {
+      case 0:  return i;
+      case 1:  return "test" + i;
+      case 2:  return -1 - i;
+      case 3:  return "" + i;
+      case 4:  return i + 0.5;
+      default: return null;
+    }
+  };
+
+  var makeDocument = function (i) {
+    // every twelfth document does not have the attribute at all
+    if (i % 12 === 11) {
+      return { _key: "test" + i };
+    }
+    return { _key: "test" + i, value: makeValue(i) };
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      internal.db._drop(cn);
+      internal.db._drop(cn + "2");
+      collection = internal.db._create(cn);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      internal.db._drop(cn);
+      internal.db._drop(cn + "2");
+      collection = null;
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lookups, inserts and removals while the partitions grow. the
+/// partitions move their elements to the grown tables a few at a time, so
+/// most of these operations happen while a move is in progress
+////////////////////////////////////////////////////////////////////////////////
+
+    testUniqueOperationsWhileGrowing : function () {
+      var idx = collection.ensureUniqueConstraint("value");
+      var i, j;
+
+      var isRemoved = function (value, current) {
+        return (value % 3 === 0 && value <= current - 7);
+      };
+
+      for (i = 0; i < n; ++i) {
+        collection.save({ _key: "test" + i, value: i });
+
+        // remove some documents a few inserts after they were added
+        if (i >= 7 && (i - 7) % 3 === 0) {
+          collection.remove("test" + (i - 7));
+          assertEqual([ ], lookup(collection, idx, i - 7));
+        }
+
+        assertEqual([ "test" + i ], lookup(collection, idx, i));
+
+        j = Math.floor(i / 2);
+        if (isRemoved(j, i)) {
+          assertEqual([ ], lookup(collection, idx, j));
+        }
+        else {
+          assertEqual([ "test" + j ], lookup(collection, idx, j));
+          assertUniqueViolation(collection, { value: j });
+        }
+
+        assertEqual([ ], lookup(collection, idx, -1 - i));
+      }
+
+      // the values of the removed documents can be used again
+      for (i = 0; i < n; ++i) {
+        if (isRemoved(i, n - 1)) {
+          collection.save({ _key: "again" + i, value: i });
+        }
+      }
+
+      assertEqual(n, collection.count());
+
+      for (i = 0; i < n; ++i) {
+        assertEqual([ (isRemoved(i, n - 1) ? "again" : "test") + i ], lookup(collection, idx, i));
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief an index built from existing documents matches an index that was
+/// filled document by document
+////////////////////////////////////////////////////////////////////////////////
+
+    testUniqueBulkMatchesIncremental : function () {
+      var incremental = collection;
+      var bulk = internal.db._create(cn + "2");
+      var i;
+
+      var idxIncremental = incremental.ensureUniqueConstraint("value", { sparse: true });
+
+      for (i = 0; i < n; ++i) {
+        incremental.save(makeDocument(i));
+        bulk.save(makeDocument(i));
+      }
+
+      var idxBulk = bulk.ensureUniqueConstraint("value", { sparse: true });
+
+      var compare = function () {
+        assertEqual(incremental.count(), bulk.count());
+
+        for (i = 0; i < n; ++i) {
+          var value = makeValue(i);
+
+          if (value === null) {
+            continue;
+          }
+
+          var expected = lookup(incremental, idxIncremental, value);
+          assertEqual(expected, lookup(bulk, idxBulk, value), value);
+          assertEqual(incremental.exists("test" + i) ? [ "test" + i ] : [ ], expected, value);
+        }
+
+        assertEqual(1, incremental.index(idxIncremental.id).selectivityEstimate);
+        assertEqual(1, bulk.index(idxBulk.id).selectivityEstimate);
+      };
+
+      compare();
+
+      // the indexes are built in bulk when the collections are loaded again
+      testHelper.waitUnload(incremental);
+      testHelper.waitUnload(bulk);
+
+      compare();
+
+      // both indexes still detect duplicates and allow removals
+      for (i = 0; i < n; i += 5) {
+        if (makeValue(i) !== null) {
+          assertUniqueViolation(incremental, { value: makeValue(i) });
+          assertUniqueViolation(bulk, { value: makeValue(i) });
+        }
+
+        incremental.remove("test" + i);
+        bulk.remove("test" + i);
+      }
+
+      compare();
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief building an index from existing documents with duplicate values
+////////////////////////////////////////////////////////////////////////////////
+
+    testUniqueBulkDuplicates : function () {
+      var i;
+
+      for (i = 0; i < n; ++i) {
+        collection.save({ value: i });
+      }
+      collection.save({ value: n - 1 });
+
+      try {
+        collection.ensureUniqueConstraint("value");
+        fail();
+      }
+      catch (err) {
+        assertEqual(ERRORS.ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED.code, err.errorNum);
+      }
+
+      assertEqual(1, collection.getIndexes().length);
+
+      // the index can be created after the duplicate is gone
+      collection.removeByExample({ value: n - 1 }, false, 1);
+
+      var idx = collection.ensureUniqueConstraint("value");
+
+      for (i = 0; i < n; i += 97) {
+        assertEqual(1, lookup(collection, idx, i).length);
+      }
+    }
+
+  };
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                              main
 // -----------------------------------------------------------------------------
@@ -167,6 +382,7 @@ function HashIndexSuite() {
 ////////////////////////////////////////////////////////////////////////////////
 
 jsunity.run(HashIndexSuite);
+jsunity.run(UniqueHashIndexSuite);
 
 return jsunity.done();
 
@@ -125,6 +125,16 @@ exports.wal = {
   }
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief compaction object
+////////////////////////////////////////////////////////////////////////////////
+
+exports.compaction = {
+  properties: function () {
+    return global.COMPACTION_PROPERTIES.apply(null, arguments);
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief defines an action
 ////////////////////////////////////////////////////////////////////////////////
@@ -2094,12 +2094,26 @@ function AQL_SUBSTITUTE (value, search, replace, limit) {
   var pattern, patterns, replacements = { }, sWeight = TYPEWEIGHT(search);
   value = AQL_TO_STRING(value);
 
+  if (sWeight === TYPEWEIGHT_NULL) {
+    // nothing to replace
+    return value;
+  }
+
+  if (sWeight === TYPEWEIGHT_BOOL || sWeight === TYPEWEIGHT_NUMBER) {
+    search = AQL_TO_STRING(search);
+    sWeight = TYPEWEIGHT_STRING;
+  }
+
   if (sWeight === TYPEWEIGHT_OBJECT) {
     patterns = [ ];
     KEYS(search, false).forEach(function(k) {
       patterns.push(CREATE_REGEX_PATTERN(k));
       replacements[k] = AQL_TO_STRING(search[k]);
     });
+    if (patterns.length === 0) {
+      // nothing to replace
+      return value;
+    }
     pattern = patterns.join('|');
     limit = replace;
   }
@@ -2256,7 +2270,7 @@ function AQL_FIND_LAST (value, search, start, end) {
     start = AQL_TO_NUMBER(start);
   }
   else {
-    start = undefined;
+    start = 0;
   }
 
   if (end !== undefined && end !== null) {
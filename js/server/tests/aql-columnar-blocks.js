@@ -0,0 +1,215 @@
+/*jshint globalstrict:false, strict:false, maxlen: 500 */
+/*global assertEqual, AQL_EXECUTE */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for column-major item blocks and vectorized calculations
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var db = require("org/arangodb").db;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function ahuacatlColumnarBlocksTestSuite () {
+  var c;
+  var rowMajor = { columnarBlocks: false };
+  var columnar = { columnarBlocks: true };
+
+  var values = [ null, false, true, 0, 1, -1, 2.5, -17.25, 1000000, "", "1", "foo", "-3.5", [ ], [ 1 ], [ 1, 2 ], { }, { a: 1 } ];
+
+  var execute = function (query, options) {
+    return AQL_EXECUTE(query, { }, options).json;
+  };
+
+  var compare = function (query) {
+    var expected = execute(query, rowMajor);
+    var actual = execute(query, columnar);
+    assertEqual(expected, actual, query);
+    return actual;
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      db._drop("UnitTestsColumnar");
+      c = db._create("UnitTestsColumnar");
+
+      for (var i = 0; i < 2000; ++i) {
+        c.save({ _key: "test" + i, value: i, half: i / 2, mixed: values[i % values.length], sub: { value: i % 7 } });
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      db._drop("UnitTestsColumnar");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test numeric calculations
+////////////////////////////////////////////////////////////////////////////////
+
+    testNumericCalculations : function () {
+      var result = compare("FOR doc IN " + c.name() + " SORT doc.value LET x = doc.value * 2 + doc.half - 1 RETURN x");
+
+      assertEqual(2000, result.length);
+      for (var i = 0; i < result.length; ++i) {
+        assertEqual(i * 2 + i / 2 - 1, result[i]);
+      }
+
+      result = compare("FOR i IN 1..1000 LET x = -i RETURN [ x, i / 4, i % 3, i - 0.5, +i ]");
+      assertEqual(1000, result.length);
+      for (i = 0; i < result.length; ++i) {
+        assertEqual([ -(i + 1), (i + 1) / 4, (i + 1) % 3, (i + 1) - 0.5, i + 1 ], result[i]);
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test division and modulus by zero
+////////////////////////////////////////////////////////////////////////////////
+
+    testDivisionByZero : function () {
+      var result = compare("FOR i IN 0..10 LET x = i / (i % 2) LET y = i % (i % 2) RETURN [ x, y ]");
+      assertEqual(11, result.length);
+      for (var i = 0; i < result.length; ++i) {
+        if (i % 2 === 0) {
+          assertEqual([ null, null ], result[i]);
+        }
+        else {
+          assertEqual([ i, 0 ], result[i]);
+        }
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test calculations with values of mixed types
+////////////////////////////////////////////////////////////////////////////////
+
+    testMixedTypes : function () {
+      var expressions = [
+        "doc.mixed + 1",
+        "doc.mixed - doc.value",
+        "doc.mixed * 2",
+        "doc.value / doc.mixed",
+        "doc.value % doc.mixed",
+        "-doc.mixed",
+        "+doc.mixed",
+        "doc.mixed == 1",
+        "doc.mixed != null",
+        "doc.mixed < doc.value",
+        "doc.mixed <= \"foo\"",
+        "doc.mixed > [ 1 ]",
+        "doc.mixed >= { }",
+        "! (doc.mixed == true)",
+        "doc.mixed.a",
+        "doc.sub.value",
+        "doc.sub.value.missing",
+        "[ 1, 2, 3 ]",
+        "{ a: 1 }"
+      ];
+
+      expressions.forEach(function(expression) {
+        compare("FOR doc IN " + c.name() + " SORT doc.value LET x = " + expression + " RETURN x");
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test logical operators
+////////////////////////////////////////////////////////////////////////////////
+
+    testLogicalOperators : function () {
+      var result = compare("FOR doc IN " + c.name() + " SORT doc.value LET x = doc.value > 100 && doc.value < 200 LET y = doc.value < 10 || doc.value >= 1990 RETURN [ x, y ]");
+
+      assertEqual(2000, result.length);
+      for (var i = 0; i < result.length; ++i) {
+        assertEqual([ i > 100 && i < 200, i < 10 || i >= 1990 ], result[i]);
+      }
+
+      // operands are not booleans
+      compare("FOR doc IN " + c.name() + " SORT doc.value LET x = doc.mixed && doc.value LET y = doc.mixed || doc.value RETURN [ x, y ]");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test filters on vectorized conditions
+////////////////////////////////////////////////////////////////////////////////
+
+    testFilters : function () {
+      var result = compare("FOR doc IN " + c.name() + " FILTER doc.value % 3 == 0 && doc.sub.value != 2 SORT doc.value RETURN doc.value");
+
+      var expected = [ ];
+      for (var i = 0; i < 2000; ++i) {
+        if (i % 3 === 0 && i % 7 !== 2) {
+          expected.push(i);
+        }
+      }
+      assertEqual(expected, result);
+
+      result = compare("FOR doc IN " + c.name() + " FILTER doc.value >= 1500 FILTER doc.mixed == 1 SORT doc.value RETURN doc.value");
+      assertEqual(27, result.length);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test calculations in subqueries and with conditions
+////////////////////////////////////////////////////////////////////////////////
+
+    testSubqueries : function () {
+      compare("FOR i IN 1..20 LET sub = (FOR doc IN " + c.name() + " FILTER doc.value < i SORT doc.value RETURN doc.value * i) RETURN sub");
+      compare("FOR doc IN " + c.name() + " SORT doc.value LET x = doc.value > 1000 ? doc.value * 2 : doc.half + 1 RETURN x");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that the option is off by default
+////////////////////////////////////////////////////////////////////////////////
+
+    testDefault : function () {
+      var query = "FOR doc IN " + c.name() + " SORT doc.value LET x = doc.value + doc.mixed RETURN x";
+      assertEqual(execute(query, rowMajor), execute(query, { }));
+      assertEqual(execute(query, columnar), execute(query, { }));
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(ahuacatlColumnarBlocksTestSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
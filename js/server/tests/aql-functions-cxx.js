@@ -0,0 +1,368 @@
+/*jshint globalstrict:false, strict:false, maxlen: 500 */
+/*global assertEqual, AQL_EXECUTE */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for the C++ implementations of AQL functions
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function ahuacatlFunctionsCxxTestSuite () {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief calls the function with the given arguments, once using the C++
+/// implementation and once using the JavaScript implementation (via APPLY),
+/// and checks that both return the same result. the arguments are taken
+/// from a loop variable so the calls are not constant-folded
+////////////////////////////////////////////////////////////////////////////////
+
+  var compare = function (name, cases) {
+    cases.forEach(function (args) {
+      var params = [ ], i;
+      for (i = 0; i < args.length; ++i) {
+        params.push("args[" + i + "]");
+      }
+
+      var query = "FOR args IN [ @args ] RETURN [ " + name + "(" + params.join(", ") + "), APPLY(@name, args) ]";
+      var result = AQL_EXECUTE(query, { args: args, name: name }).json;
+
+      assertEqual(1, result.length);
+      assertEqual(result[0][1], result[0][0], name + "(" + JSON.stringify(args).slice(1, -1) + ")");
+    });
+  };
+
+  var strings = [ "", "a", "foobar", "the quick brown fox", "aaaa", "foo\nbar", "füße", "äöüÄÖÜ", "😀 smile 😀", " x ", "%_\\" ];
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test string positions, which are measured in UTF-16 code units
+////////////////////////////////////////////////////////////////////////////////
+
+    testStringPositions : function () {
+      var cases = [ ];
+      strings.forEach(function (s) {
+        cases.push([ s ]);
+      });
+      compare("CHAR_LENGTH", cases);
+      compare("LENGTH", cases);
+
+      // reversing splits surrogate pairs, so only use characters from the BMP
+      compare("REVERSE", cases.filter(function (args) {
+        return ! /[\ud800-\udfff]/.test(args[0]);
+      }));
+
+      cases = [ ];
+      strings.forEach(function (s) {
+        [ 0, 1, 2, 3, -1, -3, 100, 1.5, null, "2" ].forEach(function (n) {
+          cases.push([ s, n ]);
+          cases.push([ s, n, 2 ]);
+          cases.push([ s, 1, n ]);
+        });
+      });
+      compare("SUBSTRING", cases);
+
+      cases = [ ];
+      strings.forEach(function (s) {
+        [ 0, 1, 2, 3, -1, 100, 1.5, null, "2", "foo" ].forEach(function (n) {
+          cases.push([ s, n ]);
+        });
+      });
+      compare("LEFT", cases);
+      compare("RIGHT", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test searching in strings
+////////////////////////////////////////////////////////////////////////////////
+
+    testStringSearch : function () {
+      var searches = [ "", "o", "oo", "x", "😀", "ß", "a", "aa", 1 ];
+      var cases = [ ];
+
+      strings.forEach(function (s) {
+        searches.forEach(function (search) {
+          cases.push([ s, search ]);
+          cases.push([ s, search, true ]);
+        });
+      });
+      compare("CONTAINS", cases);
+
+      cases = [ ];
+      strings.forEach(function (s) {
+        searches.forEach(function (search) {
+          cases.push([ s, search ]);
+          [ 0, 1, 2, 5, -1, null, 1.5, "3" ].forEach(function (start) {
+            cases.push([ s, search, start ]);
+            [ 0, 1, 3, 6, 100, -1, null ].forEach(function (end) {
+              cases.push([ s, search, start, end ]);
+            });
+          });
+        });
+      });
+      compare("FIND_FIRST", cases);
+      compare("FIND_LAST", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test LIKE
+////////////////////////////////////////////////////////////////////////////////
+
+    testLike : function () {
+      var patterns = [ "", "%", "_", "a%", "%o%", "f_o%", "\\%", "\\_", "\\\\", "\\a", "a.b", "(x)", "[a]", "%😀%", "_ smile%", "foo%bar", "FOO%" ];
+      var cases = [ ];
+
+      strings.concat([ "a.b", "(x)", "[a]", "\\a", "%", "_" ]).forEach(function (s) {
+        patterns.forEach(function (pattern) {
+          cases.push([ s, pattern ]);
+          cases.push([ s, pattern, true ]);
+        });
+      });
+      compare("LIKE", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test trimming and splitting
+////////////////////////////////////////////////////////////////////////////////
+
+    testTrimSplit : function () {
+      var values = [ "", "  foo  ", "\t\r\nfoo bar ", "xxfooxx", " foo ", "😀foo😀" ];
+      var cases = [ ];
+
+      values.forEach(function (s) {
+        cases.push([ s ]);
+        [ "x", "fo", "😀", "", null ].forEach(function (chars) {
+          cases.push([ s, chars ]);
+        });
+      });
+      compare("LTRIM", cases);
+      compare("RTRIM", cases);
+
+      cases = [ ];
+      values.concat(strings).forEach(function (s) {
+        [ "", " ", "o", "oo", [ "o", " " ], [ ], null ].forEach(function (separator) {
+          cases.push([ s, separator ]);
+          [ 0, 1, 2, 100 ].forEach(function (limit) {
+            cases.push([ s, separator, limit ]);
+          });
+        });
+      });
+      compare("SPLIT", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test SUBSTITUTE
+////////////////////////////////////////////////////////////////////////////////
+
+    testSubstitute : function () {
+      var cases = [ ];
+
+      strings.forEach(function (s) {
+        [ "o", "oo", "", "a", "😀", 1, true, null ].forEach(function (search) {
+          cases.push([ s, search ]);
+          cases.push([ s, search, "X" ]);
+          cases.push([ s, search, null ]);
+          [ 0, 1, 2, 1.5, null ].forEach(function (limit) {
+            cases.push([ s, search, "XY", limit ]);
+          });
+        });
+
+        [ [ "o", "a" ], [ "a", "o" ], [ "oo", "o" ], [ "o", "oo" ], [ "o", "o" ], [ "", "a" ], [ "a", "" ], [ 1, null ] ].forEach(function (search) {
+          cases.push([ s, search ]);
+          cases.push([ s, search, "X" ]);
+          cases.push([ s, search, [ "X" ] ]);
+          cases.push([ s, search, [ "X", "Y", "Z" ] ]);
+          cases.push([ s, search, [ "X", "Y" ], 1 ]);
+        });
+
+        [ { o: "0", a: "4" }, { oo: "00", o: "0" }, { 2: "two", o: "0" }, { }, { a: null } ].forEach(function (search) {
+          cases.push([ s, search ]);
+          cases.push([ s, search, 1 ]);
+        });
+      });
+      compare("SUBSTITUTE", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test numeric functions
+////////////////////////////////////////////////////////////////////////////////
+
+    testNumeric : function () {
+      var cases = [ ];
+
+      [ 0, -0, 0.5, -0.5, 1.5, -1.5, 2.5, -2.5, 0.49999999999999994, -0.49999999999999994,
+        4503599627370495.5, -4503599627370495.5, 4503599627370497, 1e300, -1e300, 1.1, -1.1,
+        null, true, "3.5", "foo", [ ], [ 2.5 ] ].forEach(function (n) {
+        cases.push([ n ]);
+      });
+      compare("ROUND", cases);
+      compare("FLOOR", cases);
+      compare("CEIL", cases);
+      compare("ABS", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test list functions
+////////////////////////////////////////////////////////////////////////////////
+
+    testLists : function () {
+      var lists = [ [ ], [ 1 ], [ 1, 2, 3, 4, 5 ], [ null, false, "a", [ 1 ], { a: 1 } ], [ 1, 1, 2, 2, "1" ], [ [ 1, [ 2, [ 3, [ 4 ] ] ] ], [ ] ] ];
+      var other = [ null, 1, "foo", { a: 1 } ];
+      var cases = [ ];
+
+      lists.concat(other).forEach(function (list) {
+        cases.push([ list ]);
+      });
+      compare("FIRST", cases);
+      compare("LAST", cases);
+      compare("REVERSE", cases);
+      compare("FLATTEN", cases);
+      compare("POP", cases);
+      compare("SHIFT", cases);
+
+      cases = [ ];
+      lists.concat(other).forEach(function (list) {
+        [ 0, 1, 2, 4, 5, 100, -1, -2, -5, -6, 1.5, -1.5, null, "2", "foo" ].forEach(function (n) {
+          cases.push([ list, n ]);
+        });
+      });
+      compare("NTH", cases);
+      compare("REMOVE_NTH", cases);
+      compare("FLATTEN", cases);
+
+      cases = [ ];
+      lists.concat(other).forEach(function (list) {
+        [ 0, 1, 2, -1, -2, 1.5, null, "1" ].forEach(function (from) {
+          cases.push([ list, from ]);
+          [ 0, 1, 2, 100, -1, -2, 1.5, null, "foo" ].forEach(function (to) {
+            cases.push([ list, from, to ]);
+          });
+        });
+      });
+      compare("SLICE", cases);
+
+      cases = [ ];
+      lists.concat(other).forEach(function (list) {
+        [ 1, 2, "1", null, [ 1 ], { a: 1 }, 99 ].forEach(function (value) {
+          cases.push([ list, value ]);
+          cases.push([ list, value, true ]);
+          cases.push([ list, value, false ]);
+        });
+      });
+      compare("POSITION", cases);
+      compare("PUSH", cases);
+      compare("UNSHIFT", cases);
+      compare("REMOVE_VALUE", cases);
+
+      cases = [ ];
+      lists.concat(other).forEach(function (list) {
+        [ 1, "1", null, [ 1 ], { a: 1 } ].forEach(function (value) {
+          [ -1, 0, 1, 2, 1.5, null, "1", true ].forEach(function (limit) {
+            cases.push([ list, value, limit ]);
+          });
+        });
+      });
+      compare("REMOVE_VALUE", cases);
+
+      cases = [ ];
+      lists.concat(other).forEach(function (list) {
+        [ [ ], [ 1 ], [ 1, 2 ], [ "a", "b", "a" ], [ 3, 1, "x", 2, 1 ], [ null, [ 1 ] ], null, 1, "foo" ].forEach(function (values) {
+          cases.push([ list, values ]);
+          cases.push([ list, values, true ]);
+        });
+      });
+      compare("APPEND", cases);
+      compare("REMOVE_VALUES", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test NOT_NULL, FIRST_LIST and FIRST_DOCUMENT
+////////////////////////////////////////////////////////////////////////////////
+
+    testAlternatives : function () {
+      var cases = [
+        [ null ],
+        [ null, null ],
+        [ 1 ],
+        [ null, 1 ],
+        [ null, false, [ ] ],
+        [ null, "foo", [ 1 ], { } ],
+        [ null, { a: 1 }, [ 1 ] ],
+        [ false, 0, "", [ ], { } ]
+      ];
+
+      compare("NOT_NULL", cases);
+      compare("FIRST_LIST", cases);
+      compare("FIRST_DOCUMENT", cases);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test parsing date strings
+////////////////////////////////////////////////////////////////////////////////
+
+    testDateStrings : function () {
+      var cases = [ ];
+
+      [ "2014-01-15", "2014-01-15T10:30:00Z", "2014-01-15T10:30:00.123Z", "2014-01-15T10:30:00.1Z",
+        "2014-01-15T10:30:00.123456Z", "2014-01-15T10:30:00+01:00", "2014-01-15T10:30:00-0530",
+        "2014-01-15T24:00:00Z", "2014-01-15T24:01:00Z", "2014-13-01", "2014-02-30", "+002014-01-15",
+        "-000001-01-01T00:00:00Z", "2014", "2014-06", "Jan 15 2014", "January 15, 2014",
+        "15 January 2014", "Wed, 15 Jan 2014 10:30:00 GMT", "Wed Jan 15 2014 10:30:00 GMT+0100 (CET)",
+        "2014/01/15", "01/15/2014", "01/15/2014 10:00 PM", "01/15/2014 12:00 AM", "Jan 15", "15 Jan 99",
+        "2014-01-15 10:30:00", "2014-01-15 10:30:00 UTC", "2014-01-15 10:30:00 +01:00",
+        "2014-01-15 10:30:00 EST", "Dec 25, 1995 13:30:00 +0430", "foo", "foo 2014", "2014 foo", "12:30",
+        "Jan 15 2014 13:00 PM", "Jan 15 2014 10:20:30.5", "Jul 4 1976 (comment (nested)) 12:00 UTC",
+        "Mon, 01 Jan 2024 00:00:00 +0000", "275760-09-13", "Sep 13 275760 00:00:01 UTC", "15-Jan-2014"
+      ].forEach(function (s) {
+        cases.push([ s ]);
+      });
+
+      compare("DATE_TIMESTAMP", cases);
+      compare("DATE_ISO8601", cases);
+      compare("DATE_DAYOFWEEK", cases);
+      compare("DATE_HOUR", cases);
+      compare("DATE_MILLISECOND", cases);
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(ahuacatlFunctionsCxxTestSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
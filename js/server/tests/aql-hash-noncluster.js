@@ -1,5 +1,5 @@
 /*jshint globalstrict:false, strict:false, sub: true, maxlen: 500 */
-/*global assertEqual, AQL_EXPLAIN */
+/*global assertEqual, assertTrue, fail, AQL_EXPLAIN, AQL_EXECUTE */
 
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief tests for Ahuacatl, hash index queries
@@ -337,11 +337,345 @@ function ahuacatlHashTestSuite () {
   };
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite: hash index lookups for all rows of an input block
+////////////////////////////////////////////////////////////////////////////////
+
+function ahuacatlHashBatchTestSuite () {
+  var cn = "UnitTestsAhuacatlHashBatch";
+  var on = "UnitTestsAhuacatlHashBatchOuter";
+  var ERRORS = internal.errors;
+  var n = 5000;
+  var c, docs;
+
+  // value that many documents share, so its lookup returns more documents
+  // than fit into a single output block
+  var big = 1000;
+
+  var value = function (doc, attribute) {
+    return doc[attribute] === undefined ? null : doc[attribute];
+  };
+
+  var sorted = function (result) {
+    return result.map(function (row) {
+      return JSON.stringify(row);
+    }).sort();
+  };
+
+  var lookupValues = function () {
+    var values = [ ];
+    for (var i = 0; i < 3000; ++i) {
+      switch (i % 6) {
+        case 0: values.push(i); break;
+        case 1: values.push(n + i); break;
+        case 2: values.push(big); break;
+        case 3: values.push(String(i)); break;
+        case 4: values.push(i % 7 === 0 ? null : i + 0.5); break;
+        default: values.push(i % 100); break;
+      }
+    }
+    return values;
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the join results computed without the index
+////////////////////////////////////////////////////////////////////////////////
+
+  var expectedJoin = function (values, attribute) {
+    var keys = { };
+    docs.forEach(function (doc) {
+      if (doc !== null) {
+        var v = JSON.stringify(value(doc, attribute));
+        keys[v] = keys[v] || [ ];
+        keys[v].push(doc._key);
+      }
+    });
+
+    var result = [ ];
+    values.forEach(function (v) {
+      (keys[JSON.stringify(v)] || [ ]).forEach(function (key) {
+        result.push([ v, key ]);
+      });
+    });
+    return sorted(result);
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the index used by the inner loop of the query
+////////////////////////////////////////////////////////////////////////////////
+
+  var usedIndex = function (query, bindVars) {
+    var indexes = [ ];
+    AQL_EXPLAIN(query, bindVars).plan.nodes.forEach(function (node) {
+      if (node.type === "IndexRangeNode") {
+        indexes.push(node.index);
+      }
+    });
+    return indexes.length === 1 ? indexes[0] : null;
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief checks that the rows of the query are looked up in batches
+////////////////////////////////////////////////////////////////////////////////
+
+  var assertBatched = function (query, bindVars, batched) {
+    if (! internal.debugCanUseFailAt()) {
+      return;
+    }
+
+    internal.debugSetFailAt("IndexRangeBlock::batchHashIndexLookups");
+
+    try {
+      AQL_EXECUTE(query, bindVars);
+      if (batched) {
+        fail();
+      }
+    }
+    catch (err) {
+      assertTrue(batched, query);
+      assertEqual(ERRORS.ERROR_DEBUG.code, err.errorNum);
+    }
+    finally {
+      internal.debugRemoveFailAt("IndexRangeBlock::batchHashIndexLookups");
+    }
+  };
+
+  var fill = function (collection) {
+    docs = [ ];
+
+    for (var i = 0; i < n; ++i) {
+      var doc = { _key: "test" + i, u: i, m: (i < 1500 ? big : i % 100) };
+      if (i % 3 !== 0) {
+        doc.s = i % 10;
+      }
+      if (i % 250 === 0) {
+        // documents without the attribute are indexed with a value of null
+        delete doc.m;
+      }
+      collection.save(doc);
+      docs.push(doc);
+    }
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      internal.db._drop(cn);
+      internal.db._drop(on);
+
+      c = internal.db._create(cn);
+      c.ensureUniqueConstraint("u");
+      c.ensureHashIndex("m");
+      c.ensureHashIndex("s", { sparse: true });
+
+      fill(c);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      if (internal.debugCanUseFailAt()) {
+        internal.debugClearFailAt();
+      }
+      internal.db._drop(cn);
+      internal.db._drop(on);
+      c = null;
+      docs = null;
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief join on a unique hash index, with hits and misses
+////////////////////////////////////////////////////////////////////////////////
+
+    testBatchUnique : function () {
+      var query = "FOR v IN @values FOR d IN @@cn FILTER d.u == v RETURN [ v, d._key ]";
+      var bindVars = { values: lookupValues(), "@cn": cn };
+
+      var idx = usedIndex(query, bindVars);
+      assertEqual("hash", idx.type);
+      assertTrue(idx.unique);
+
+      var result = AQL_EXECUTE(query, bindVars);
+      assertEqual(expectedJoin(bindVars.values, "u"), sorted(result.json));
+      assertEqual(0, result.stats.scannedFull);
+
+      assertBatched(query, bindVars, true);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief join on a unique hash index with an outer collection
+////////////////////////////////////////////////////////////////////////////////
+
+    testBatchUniqueOuterCollection : function () {
+      var outer = internal.db._create(on);
+      var expected = [ ];
+
+      for (var i = 0; i < 2500; ++i) {
+        var ref = (i % 4 === 0 ? -i : i * 2);
+        outer.save({ _key: "outer" + i, ref: ref });
+        if (ref >= 0 && ref < n) {
+          expected.push([ "outer" + i, "test" + ref ]);
+        }
+      }
+
+      var query = "FOR x IN @@on FOR d IN @@cn FILTER d.u == x.ref RETURN [ x._key, d._key ]";
+      var bindVars = { "@on": on, "@cn": cn };
+
+      assertEqual("hash", usedIndex(query, bindVars).type);
+      assertEqual(sorted(expected), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      assertBatched(query, bindVars, true);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief join on a non-unique hash index, with hits, misses, null and a
+/// value with more documents than fit into one output block
+////////////////////////////////////////////////////////////////////////////////
+
+    testBatchNonUnique : function () {
+      var query = "FOR v IN @values FOR d IN @@cn FILTER d.m == v RETURN [ v, d._key ]";
+      var bindVars = { values: lookupValues(), "@cn": cn };
+
+      var idx = usedIndex(query, bindVars);
+      assertEqual("hash", idx.type);
+      assertTrue(! idx.unique);
+
+      assertEqual(expectedJoin(bindVars.values, "m"), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      // a few rows only, each with many results
+      bindVars.values = [ big, 17, big, -1, big ];
+      assertEqual(expectedJoin(bindVars.values, "m"), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      assertBatched(query, bindVars, true);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief join on an attribute with a sparse hash index. the lookup values
+/// may be null, so the sparse index must not be used
+////////////////////////////////////////////////////////////////////////////////
+
+    testBatchSparse : function () {
+      var query = "FOR v IN @values FOR d IN @@cn FILTER d.s == v RETURN [ v, d._key ]";
+      var bindVars = { values: [ 1, null, 2, 42, "3", 9, null ], "@cn": cn };
+
+      assertEqual(null, usedIndex(query, bindVars));
+      assertEqual(expectedJoin(bindVars.values, "s"), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      // a non-sparse index on the same attribute is used
+      c.ensureHashIndex("s");
+      assertEqual("hash", usedIndex(query, bindVars).type);
+      assertTrue(! usedIndex(query, bindVars).sparse);
+      assertEqual(expectedJoin(bindVars.values, "s"), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      assertBatched(query, bindVars, true);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief rows whose conditions are looked up one by one, mixed with rows
+/// that are looked up in a batch
+////////////////////////////////////////////////////////////////////////////////
+
+    testBatchMixedRows : function () {
+      var values = [ ], expected = [ ];
+      for (var i = 0; i < 2000; ++i) {
+        var list;
+        switch (i % 4) {
+          case 0: list = [ i ]; break;
+          case 1: list = [ ]; break;
+          case 2: list = [ i, n + i, i + 1 ]; break;
+          default: list = [ -i ]; break;
+        }
+        values.push(list);
+
+        /*jshint loopfunc: true */
+        list.forEach(function (v) {
+          if (v >= 0 && v < n && expected.indexOf(JSON.stringify([ i, "test" + v ])) === -1) {
+            expected.push(JSON.stringify([ i, "test" + v ]));
+          }
+        });
+      }
+
+      var query = "FOR i IN 0..LENGTH(@values) - 1 FOR d IN @@cn FILTER d.u IN @values[i] RETURN [ i, d._key ]";
+      var bindVars = { values: values, "@cn": cn };
+
+      assertEqual(expected.sort(), sorted(AQL_EXECUTE(query, bindVars).json));
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief conditions that need V8 to evaluate are looked up row by row
+////////////////////////////////////////////////////////////////////////////////
+
+    testBatchV8Condition : function () {
+      var query = "FOR v IN @values FOR d IN @@cn FILTER d.u == MEDIAN([ v ]) RETURN [ v, d._key ]";
+      var bindVars = { values: [ 1, 2, n + 1, 3, 17, -5, 4999 ], "@cn": cn };
+
+      assertEqual(expectedJoin(bindVars.values, "u"), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      assertBatched(query, bindVars, false);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief join on a unique hash index whose partitions are moving their
+/// elements to the grown tables
+////////////////////////////////////////////////////////////////////////////////
+
+    testBatchUniqueWhileGrowing : function () {
+      if (! internal.debugCanUseFailAt()) {
+        return;
+      }
+
+      internal.db._drop(cn);
+      c = internal.db._create(cn);
+      c.ensureUniqueConstraint("u");
+
+      // the elements stay in the previous tables until the failure point is
+      // removed again
+      internal.debugSetFailAt("HashArray::MigrationSteps");
+      fill(c);
+
+      var query = "FOR v IN @values FOR d IN @@cn FILTER d.u == v RETURN [ v, d._key ]";
+      var bindVars = { values: lookupValues(), "@cn": cn };
+
+      assertEqual("hash", usedIndex(query, bindVars).type);
+      assertEqual(expectedJoin(bindVars.values, "u"), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      // removals and inserts while the previous tables are still in use
+      for (var i = 0; i < n; i += 7) {
+        c.remove("test" + i);
+        docs[i] = null;
+      }
+      for (i = 0; i < n; i += 14) {
+        c.save({ _key: "again" + i, u: i });
+        docs.push({ _key: "again" + i, u: i });
+      }
+
+      assertEqual(expectedJoin(bindVars.values, "u"), sorted(AQL_EXECUTE(query, bindVars).json));
+
+      // finish the moves
+      internal.debugRemoveFailAt("HashArray::MigrationSteps");
+      for (i = 0; i < n; ++i) {
+        c.save({ _key: "more" + i, u: n + 10000 + i });
+        docs.push({ _key: "more" + i, u: n + 10000 + i });
+      }
+
+      assertEqual(expectedJoin(bindVars.values, "u"), sorted(AQL_EXECUTE(query, bindVars).json));
+    }
+
+  };
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief executes the test suite
 ////////////////////////////////////////////////////////////////////////////////
 
 jsunity.run(ahuacatlHashTestSuite);
+jsunity.run(ahuacatlHashBatchTestSuite);
 
 return jsunity.done();
 
@@ -0,0 +1,240 @@
+/*jshint globalstrict:false, strict:false, maxlen: 500 */
+/*global assertEqual, assertTrue, assertNotEqual, AQL_EXPLAIN, AQL_EXECUTE */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for optimizer rules
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var db = require("org/arangodb").db;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function optimizerRuleTestSuite () {
+  var ruleName = "parallelize-collection-scan";
+  // various choices to control the optimizer:
+  var paramNone     = { parallelism: 4, optimizer: { rules: [ "-all" ] } };
+  var paramEnabled  = { parallelism: 4, optimizer: { rules: [ "-all", "+" + ruleName ] } };
+  var paramDisabled = { parallelism: 4, optimizer: { rules: [ "+all", "-" + ruleName ] } };
+  var paramSerial   = { parallelism: 1, optimizer: { rules: [ "-all", "+" + ruleName ] } };
+
+  var c, e;
+
+  var isApplied = function (query, options) {
+    return (AQL_EXPLAIN(query, { }, options).plan.rules.indexOf(ruleName) !== -1);
+  };
+
+  var compare = function (query) {
+    var expected = AQL_EXECUTE(query, { }, paramDisabled).json;
+    var actual = AQL_EXECUTE(query, { }, paramEnabled).json;
+    assertEqual(expected, actual, query);
+    return actual;
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      db._drop("UnitTestsParallelScan");
+      db._drop("UnitTestsParallelScanEdges");
+      c = db._create("UnitTestsParallelScan");
+      e = db._createEdgeCollection("UnitTestsParallelScanEdges");
+
+      for (var i = 0; i < 5000; ++i) {
+        c.save({ _key: "test" + i, value: i, mod: i % 13, sub: { value: i % 7 }, name: "test" + (i % 100) });
+      }
+
+      for (i = 0; i < 1000; ++i) {
+        e.save(c.name() + "/test" + i, c.name() + "/test" + (i + 1), { value: i });
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      db._drop("UnitTestsParallelScan");
+      db._drop("UnitTestsParallelScanEdges");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has no effect when explicitly disabled
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleDisabled : function () {
+      var queries = [
+        "FOR doc IN " + c.name() + " FILTER doc.value > 10 RETURN doc",
+        "FOR doc IN " + c.name() + " FILTER doc.sub.value == 3 RETURN doc.value"
+      ];
+
+      queries.forEach(function(query) {
+        assertEqual([ ], AQL_EXPLAIN(query, { }, paramNone).plan.rules, query);
+        assertTrue(! isApplied(query, paramDisabled), query);
+        assertTrue(! isApplied(query, paramSerial), query);
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has no effect
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleNoEffect : function () {
+      var queries = [
+        "FOR i IN 1..10 FILTER i > 1 RETURN i",
+        "FOR doc IN " + c.name() + " RETURN doc",
+        "FOR doc IN " + c.name() + " SORT doc.value FILTER doc.value > 1 RETURN doc",
+        "FOR doc IN " + c.name() + " FILTER doc.value > RAND() RETURN doc",
+        "FOR i IN 1..2 FOR doc IN " + c.name() + " FILTER doc.value == i RETURN doc",
+        // the collection name resolver is not thread-safe
+        "FOR doc IN " + c.name() + " FILTER doc._id == 'UnitTestsParallelScan/test1' RETURN doc",
+        "FOR doc IN " + c.name() + " FILTER LENGTH(doc) > 5 RETURN doc",
+        "FOR doc IN " + c.name() + " FILTER doc == { } RETURN doc",
+        "FOR doc IN " + c.name() + " FILTER doc[doc.name] == 1 RETURN doc",
+        "FOR doc IN " + c.name() + " LET x = doc FILTER x.value == 1 RETURN doc",
+        "FOR doc IN " + e.name() + " FILTER doc._from == 'UnitTestsParallelScan/test1' RETURN doc",
+        "FOR doc IN " + e.name() + " FILTER doc._to == 'UnitTestsParallelScan/test1' RETURN doc"
+      ];
+
+      queries.forEach(function(query) {
+        assertTrue(! isApplied(query, paramEnabled), query);
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has an effect
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleHasEffect : function () {
+      var queries = [
+        "FOR doc IN " + c.name() + " FILTER doc.value > 10 RETURN doc",
+        "FOR doc IN " + c.name() + " FILTER doc.sub.value == 3 RETURN doc.value",
+        "FOR doc IN " + c.name() + " LET x = doc.value * 2 FILTER x < 100 RETURN x",
+        "FOR doc IN " + c.name() + " FILTER doc._key == 'test1' RETURN doc",
+        "FOR doc IN " + c.name() + " FILTER doc._rev != null RETURN doc._id",
+        "FOR doc IN " + c.name() + " FILTER LIKE(doc.name, 'test1%') RETURN doc",
+        "FOR doc IN " + e.name() + " FILTER doc.value < 10 RETURN doc._from"
+      ];
+
+      queries.forEach(function(query) {
+        assertTrue(isApplied(query, paramEnabled), query);
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test generated plans
+////////////////////////////////////////////////////////////////////////////////
+
+    testPlans : function () {
+      var query = "FOR doc IN " + c.name() + " LET x = doc.value * 2 FILTER x < 100 RETURN doc.value";
+      var nodes = AQL_EXPLAIN(query, { }, paramEnabled).plan.nodes.map(function(node) {
+        return node.type;
+      });
+
+      assertEqual([ "SingletonNode", "EnumerateCollectionNode", "CalculationNode", "ReturnNode" ], nodes);
+
+      var node = AQL_EXPLAIN(query, { }, paramEnabled).plan.nodes[1];
+      assertEqual(4, node.parallelism);
+      assertEqual(2, node.filterCalculations.length);
+
+      // the calculation is still needed after the filter
+      query = "FOR doc IN " + c.name() + " LET x = doc.value * 2 FILTER x < 100 RETURN x";
+      nodes = AQL_EXPLAIN(query, { }, paramEnabled).plan.nodes.map(function(node) {
+        return node.type;
+      });
+
+      assertEqual([ "SingletonNode", "EnumerateCollectionNode", "CalculationNode", "ReturnNode" ], nodes);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test results
+////////////////////////////////////////////////////////////////////////////////
+
+    testResults : function () {
+      var result = compare("FOR doc IN " + c.name() + " FILTER doc.mod == 3 RETURN doc.value");
+      assertEqual(385, result.length);
+      result.forEach(function(value) {
+        assertEqual(3, value % 13);
+      });
+
+      result = compare("FOR doc IN " + c.name() + " FILTER doc.value >= 1000 && doc.sub.value != 2 SORT doc.value RETURN doc.value");
+      var expected = [ ];
+      for (var i = 1000; i < 5000; ++i) {
+        if (i % 7 !== 2) {
+          expected.push(i);
+        }
+      }
+      assertEqual(expected, result);
+
+      compare("FOR doc IN " + c.name() + " LET x = doc.value * 2 FILTER x < 100 SORT x RETURN [ x, doc._id, doc._key ]");
+      compare("FOR doc IN " + c.name() + " FILTER LIKE(doc.name, 'test1%') SORT doc.value RETURN doc");
+      compare("FOR doc IN " + e.name() + " FILTER doc.value % 10 == 0 SORT doc.value RETURN [ doc._from, doc._to ]");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test results with few or no matches
+////////////////////////////////////////////////////////////////////////////////
+
+    testResultsFewMatches : function () {
+      assertEqual([ ], compare("FOR doc IN " + c.name() + " FILTER doc.value < 0 RETURN doc"));
+      assertEqual([ 4999 ], compare("FOR doc IN " + c.name() + " FILTER doc.value == 4999 RETURN doc.value"));
+      assertEqual([ 5000 ], compare("FOR doc IN " + c.name() + " FILTER doc.value > 0 || doc.value == 0 COLLECT WITH COUNT INTO length RETURN length"));
+      assertEqual([ 10 ], compare("FOR doc IN " + c.name() + " FILTER doc.value % 500 == 0 LIMIT 20 COLLECT WITH COUNT INTO length RETURN length"));
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test errors and warnings raised in the filter threads
+////////////////////////////////////////////////////////////////////////////////
+
+    testWarnings : function () {
+      var query = "FOR doc IN " + c.name() + " FILTER doc.value / (doc.value % 2) > 1000 SORT doc.value RETURN doc.value";
+      var expected = AQL_EXECUTE(query, { }, paramDisabled);
+      var actual = AQL_EXECUTE(query, { }, paramEnabled);
+
+      assertEqual(expected.json, actual.json);
+      assertNotEqual(0, actual.warnings.length);
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(optimizerRuleTestSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
@@ -0,0 +1,263 @@
+/*jshint globalstrict:false, strict:false, maxlen: 500 */
+/*global assertEqual, assertTrue, assertFalse, AQL_EXPLAIN, AQL_EXECUTE */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for optimizer rules
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var db = require("org/arangodb").db;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function optimizerRuleTestSuite () {
+  var ruleName = "sort-limit";
+  // various choices to control the optimizer:
+  var paramNone     = { optimizer: { rules: [ "-all" ] } };
+  var paramEnabled  = { optimizer: { rules: [ "-all", "+" + ruleName ] } };
+  var paramDisabled = { optimizer: { rules: [ "+all", "-" + ruleName ] } };
+
+  var c;
+
+  var sortNodes = function (query, options) {
+    return AQL_EXPLAIN(query, { }, options || paramEnabled).plan.nodes.filter(function(node) {
+      return node.type === "SortNode";
+    });
+  };
+
+  var isApplied = function (query, options) {
+    return (AQL_EXPLAIN(query, { }, options || paramEnabled).plan.rules.indexOf(ruleName) !== -1);
+  };
+
+  var compare = function (query) {
+    var expected = AQL_EXECUTE(query, { }, paramDisabled).json;
+    var actual = AQL_EXECUTE(query, { }, paramEnabled).json;
+    assertEqual(expected, actual, query);
+    return actual;
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      db._drop("UnitTestsSortLimit");
+      c = db._create("UnitTestsSortLimit");
+
+      for (var i = 0; i < 1000; ++i) {
+        c.save({ _key: "test" + i, value: i, group: i % 17, name: "test" + (i % 10) });
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      db._drop("UnitTestsSortLimit");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has no effect when explicitly disabled
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleDisabled : function () {
+      var query = "FOR doc IN " + c.name() + " SORT doc.value LIMIT 10 RETURN doc";
+
+      assertEqual([ ], AQL_EXPLAIN(query, { }, paramNone).plan.rules);
+      assertFalse(isApplied(query, paramDisabled));
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has no effect
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleNoEffect : function () {
+      var queries = [
+        "FOR doc IN " + c.name() + " SORT doc.value RETURN doc",
+        "FOR doc IN " + c.name() + " LIMIT 10 RETURN doc",
+        "FOR doc IN " + c.name() + " SORT doc.value FILTER doc.group == 1 LIMIT 10 RETURN doc",
+        "FOR doc IN " + c.name() + " SORT doc.value LET x = doc.value * 2 LIMIT 10 RETURN x",
+        "FOR doc IN " + c.name() + " SORT doc.value LIMIT 0 RETURN doc",
+        "FOR doc IN " + c.name() + " LIMIT 10 SORT doc.value RETURN doc"
+      ];
+
+      queries.forEach(function(query) {
+        assertFalse(isApplied(query), query);
+        sortNodes(query).forEach(function(node) {
+          assertFalse(node.hasOwnProperty("limit"), query);
+        });
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has no effect if the limit needs a full count
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleNoEffectFullCount : function () {
+      var query = "FOR doc IN " + c.name() + " SORT doc.value LIMIT 5, 10 RETURN doc.value";
+      var options = { fullCount: true, optimizer: { rules: [ "-all", "+" + ruleName ] } };
+
+      assertFalse(isApplied(query, options));
+
+      var result = AQL_EXECUTE(query, { }, options);
+      assertEqual([ 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 ], result.json);
+      assertEqual(1000, result.stats.fullCount);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has an effect
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleHasEffect : function () {
+      var queries = [
+        [ "FOR doc IN " + c.name() + " SORT doc.value LIMIT 10 RETURN doc", 10 ],
+        [ "FOR doc IN " + c.name() + " SORT doc.value DESC LIMIT 5, 10 RETURN doc", 15 ],
+        [ "FOR doc IN " + c.name() + " SORT doc.group, doc.value LIMIT 1 RETURN doc", 1 ],
+        [ "FOR doc IN " + c.name() + " SORT doc.value LIMIT 990, 2000 RETURN doc", 2990 ],
+        [ "FOR i IN 1..100 SORT i DESC LIMIT 3 RETURN i", 3 ]
+      ];
+
+      queries.forEach(function(query) {
+        assertTrue(isApplied(query[0]), query[0]);
+
+        var nodes = sortNodes(query[0]);
+        assertEqual(1, nodes.length, query[0]);
+        assertEqual(query[1], nodes[0].limit, query[0]);
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test results
+////////////////////////////////////////////////////////////////////////////////
+
+    testResults : function () {
+      var result = compare("FOR doc IN " + c.name() + " SORT doc.value LIMIT 10 RETURN doc.value");
+      assertEqual([ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 ], result);
+
+      result = compare("FOR doc IN " + c.name() + " SORT doc.value DESC LIMIT 3 RETURN doc.value");
+      assertEqual([ 999, 998, 997 ], result);
+
+      result = compare("FOR doc IN " + c.name() + " SORT doc.value DESC LIMIT 10, 3 RETURN doc.value");
+      assertEqual([ 989, 988, 987 ], result);
+
+      result = compare("FOR doc IN " + c.name() + " SORT doc.group, doc.value DESC LIMIT 4 RETURN [ doc.group, doc.value ]");
+      assertEqual([ [ 0, 986 ], [ 0, 969 ], [ 0, 952 ], [ 0, 935 ] ], result);
+
+      result = compare("FOR i IN 1..100 SORT i % 7, i DESC LIMIT 2, 3 RETURN i");
+      assertEqual([ 84, 77, 70 ], result);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test offsets and limits at and beyond the number of input rows
+////////////////////////////////////////////////////////////////////////////////
+
+    testResultsLargeOffsetsAndLimits : function () {
+      var i, expected;
+
+      // limit larger than the input
+      var result = compare("FOR doc IN " + c.name() + " SORT doc.value LIMIT 2000 RETURN doc.value");
+      assertEqual(1000, result.length);
+      for (i = 0; i < 1000; ++i) {
+        assertEqual(i, result[i]);
+      }
+
+      // limit equal to the input
+      result = compare("FOR doc IN " + c.name() + " SORT doc.value DESC LIMIT 1000 RETURN doc.value");
+      assertEqual(1000, result.length);
+      assertEqual(999, result[0]);
+      assertEqual(0, result[999]);
+
+      // offset plus limit beyond the input
+      result = compare("FOR doc IN " + c.name() + " SORT doc.value LIMIT 990, 2000 RETURN doc.value");
+      expected = [ ];
+      for (i = 990; i < 1000; ++i) {
+        expected.push(i);
+      }
+      assertEqual(expected, result);
+
+      // offset at and beyond the input
+      assertEqual([ ], compare("FOR doc IN " + c.name() + " SORT doc.value LIMIT 1000, 10 RETURN doc.value"));
+      assertEqual([ ], compare("FOR doc IN " + c.name() + " SORT doc.value LIMIT 5000, 5000 RETURN doc.value"));
+
+      // empty input
+      assertEqual([ ], compare("FOR doc IN " + c.name() + " FILTER doc.value < 0 SORT doc.value LIMIT 5 RETURN doc.value"));
+
+      // tiny input
+      assertEqual([ 3, 2 ], compare("FOR i IN [ 2, 3, 1 ] SORT i DESC LIMIT 2 RETURN i"));
+      assertEqual([ 1, 2, 3 ], compare("FOR i IN [ 2, 3, 1 ] SORT i LIMIT 100 RETURN i"));
+      assertEqual([ 3 ], compare("FOR i IN [ 2, 3, 1 ] SORT i LIMIT 2, 100 RETURN i"));
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rows with equal sort values keep their input order
+////////////////////////////////////////////////////////////////////////////////
+
+    testStability : function () {
+      var values = [ ], sorted = [ ], i;
+      for (i = 0; i < 500; ++i) {
+        values.push({ group: i % 5, position: i });
+      }
+
+      // stable sort by group
+      for (var group = 0; group < 5; ++group) {
+        for (i = group; i < 500; i += 5) {
+          sorted.push(values[i]);
+        }
+      }
+
+      var query = "FOR v IN " + JSON.stringify(values) + " SORT v.group LIMIT @offset, @count RETURN v";
+
+      [ [ 0, 1 ], [ 0, 10 ], [ 95, 10 ], [ 100, 1 ], [ 250, 300 ], [ 499, 10 ], [ 500, 10 ] ].forEach(function(limit) {
+        var bindVars = { offset: limit[0], count: limit[1] };
+        var actual = AQL_EXECUTE(query, bindVars, paramEnabled).json;
+        assertEqual(sorted.slice(limit[0], limit[0] + limit[1]), actual, limit);
+      });
+
+      // the in-memory sort is not stable, so only compare the sort values
+      compare("FOR doc IN " + c.name() + " SORT doc.name LIMIT 95, 20 RETURN doc.name");
+      compare("FOR doc IN " + c.name() + " SORT doc.group DESC, doc.name LIMIT 30 RETURN [ doc.group, doc.name ]");
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(optimizerRuleTestSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
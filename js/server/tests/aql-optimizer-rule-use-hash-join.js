@@ -0,0 +1,231 @@
+/*jshint globalstrict:false, strict:false, maxlen: 500 */
+/*global assertEqual, assertTrue, assertFalse, AQL_EXPLAIN, AQL_EXECUTE */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for optimizer rules
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var db = require("org/arangodb").db;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function optimizerRuleTestSuite () {
+  var ruleName = "use-hash-join";
+  // various choices to control the optimizer:
+  var paramNone     = { optimizer: { rules: [ "-all" ] } };
+  var paramEnabled  = { optimizer: { rules: [ "-all", "+" + ruleName ] } };
+  var paramDisabled = { optimizer: { rules: [ "+all", "-" + ruleName ] } };
+
+  var small, big;
+
+  var hashJoinNodes = function (query) {
+    return AQL_EXPLAIN(query, { }, paramEnabled).plan.nodes.filter(function(node) {
+      return node.type === "HashJoinNode";
+    });
+  };
+
+  var isApplied = function (query) {
+    return (AQL_EXPLAIN(query, { }, paramEnabled).plan.rules.indexOf(ruleName) !== -1);
+  };
+
+  var compare = function (query) {
+    var expected = AQL_EXECUTE(query, { }, paramDisabled).json;
+    var actual = AQL_EXECUTE(query, { }, paramEnabled).json;
+    assertEqual(expected, actual, query);
+    return actual;
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      db._drop("UnitTestsHashJoinSmall");
+      db._drop("UnitTestsHashJoinBig");
+      small = db._create("UnitTestsHashJoinSmall");
+      big = db._create("UnitTestsHashJoinBig");
+
+      var i;
+      for (i = 0; i < 10; ++i) {
+        small.save({ _key: "test" + i, value: i, name: "test" + i });
+      }
+
+      var mixed = [ null, 1, "1", true, [ 1 ], { a: 1 } ];
+
+      for (i = 0; i < 1000; ++i) {
+        big.save({ _key: "test" + i, value: i, ref: i % 20, name: "test" + (i % 15), mixed: mixed[i % mixed.length] });
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      db._drop("UnitTestsHashJoinSmall");
+      db._drop("UnitTestsHashJoinBig");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has no effect when explicitly disabled
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleDisabled : function () {
+      var query = "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == b.ref RETURN b";
+
+      assertEqual([ ], AQL_EXPLAIN(query, { }, paramNone).plan.rules);
+      assertTrue(AQL_EXPLAIN(query, { }, paramDisabled).plan.rules.indexOf(ruleName) === -1);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has no effect
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleNoEffect : function () {
+      var queries = [
+        "FOR b IN " + big.name() + " FILTER b.value == 1 RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value < b.ref RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER b.value == b.ref RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == b.ref + RAND() RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == 1 RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " SORT b.value FILTER a.value == b.ref RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == b.ref || a.value == b.value RETURN b"
+      ];
+
+      queries.forEach(function(query) {
+        assertFalse(isApplied(query), query);
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that rule has an effect
+////////////////////////////////////////////////////////////////////////////////
+
+    testRuleHasEffect : function () {
+      var queries = [
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == b.ref RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER b.ref == a.value RETURN b",
+        "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value + 1 == b.ref RETURN b",
+        "FOR b IN " + big.name() + " FOR a IN " + small.name() + " FILTER a.name == b.name RETURN a",
+        "FOR i IN 1..100 FOR b IN " + big.name() + " FILTER b.ref == i RETURN b"
+      ];
+
+      queries.forEach(function(query) {
+        assertTrue(isApplied(query), query);
+        assertEqual(1, hashJoinNodes(query).length, query);
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that the hash table is built for the smaller side
+////////////////////////////////////////////////////////////////////////////////
+
+    testBuildSide : function () {
+      // 10 input rows, 1000 documents in the joined collection
+      var nodes = hashJoinNodes("FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == b.ref RETURN b");
+      assertEqual(1, nodes.length);
+      assertEqual(big.name(), nodes[0].collection);
+      assertFalse(nodes[0].hashCollection);
+
+      // 1000 input rows, 10 documents in the joined collection
+      nodes = hashJoinNodes("FOR b IN " + big.name() + " FOR a IN " + small.name() + " FILTER a.value == b.ref RETURN b");
+      assertEqual(1, nodes.length);
+      assertEqual(small.name(), nodes[0].collection);
+      assertTrue(nodes[0].hashCollection);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test generated plans
+////////////////////////////////////////////////////////////////////////////////
+
+    testPlans : function () {
+      var query = "FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == b.ref RETURN b";
+      var nodes = AQL_EXPLAIN(query, { }, paramEnabled).plan.nodes.map(function(node) {
+        return node.type;
+      });
+
+      assertEqual([ "SingletonNode", "EnumerateCollectionNode", "HashJoinNode", "ReturnNode" ], nodes);
+
+      // the result of the comparison is still needed
+      query = "FOR a IN " + small.name() + " FOR b IN " + big.name() + " LET eq = a.value == b.ref FILTER eq RETURN eq";
+      nodes = AQL_EXPLAIN(query, { }, paramEnabled).plan.nodes.map(function(node) {
+        return node.type;
+      });
+
+      assertEqual([ "SingletonNode", "EnumerateCollectionNode", "HashJoinNode", "CalculationNode", "ReturnNode" ], nodes);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test results
+////////////////////////////////////////////////////////////////////////////////
+
+    testResults : function () {
+      var result = compare("FOR a IN " + small.name() + " FOR b IN " + big.name() + " FILTER a.value == b.ref SORT a.value, b.value RETURN [ a.value, b.value ]");
+      assertEqual(500, result.length);
+      result.forEach(function(pair) {
+        assertEqual(pair[0], pair[1] % 20);
+      });
+
+      result = compare("FOR b IN " + big.name() + " FOR a IN " + small.name() + " FILTER a.name == b.name SORT b.value RETURN [ a.value, b.value ]");
+      assertEqual(670, result.length);
+
+      compare("FOR a IN " + small.name() + " FOR b IN " + big.name() + " LET eq = a.value == b.ref FILTER eq SORT b.value RETURN eq");
+      compare("FOR i IN 1..100 FOR b IN " + big.name() + " FILTER b.ref == i SORT b.value RETURN [ i, b._key ]");
+      assertEqual([ ], compare("FOR i IN 100..200 FOR b IN " + big.name() + " FILTER b.ref == i RETURN b"));
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that join keys compare like the == operator
+////////////////////////////////////////////////////////////////////////////////
+
+    testKeyTypes : function () {
+      var values = "[ null, 1, 1.0, '1', true, [ 1 ], { a: 1 }, { a: 1.0 }, [ ], 0, false, '' ]";
+
+      compare("FOR v IN " + values + " FOR b IN " + big.name() + " FILTER b.mixed == v SORT b.value RETURN [ v, b.value ]");
+      compare("FOR v IN " + values + " FOR b IN " + big.name() + " FILTER b.missing == v SORT b.value RETURN [ v, b.value ]");
+      compare("FOR b IN " + big.name() + " FOR v IN " + values + " FILTER v == b.mixed SORT b.value RETURN [ v, b.value ]");
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(optimizerRuleTestSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
@@ -0,0 +1,285 @@
+/*jshint globalstrict:false, strict:false, maxlen: 500 */
+/*global assertEqual, assertTrue, assertFalse, AQL_EXECUTE */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for the execution plan cache
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var db = require("org/arangodb").db;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function ahuacatlPlanCacheTestSuite () {
+  var c;
+  var prefix;
+
+  var execute = function (query, bindVars) {
+    // make the query string unique per test, so plans from earlier runs
+    // are not reused
+    var result = AQL_EXECUTE(prefix + query, bindVars || { });
+    return { json: result.json, cached: result.stats.planCached };
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      db._drop("UnitTestsPlanCache");
+      c = db._create("UnitTestsPlanCache");
+
+      for (var i = 0; i < 100; ++i) {
+        c.save({ _key: "test" + i, value: i, name: "name" + (i % 10), sub: { value: i % 3 } });
+      }
+
+      prefix = "/* " + Date.now() + "-" + Math.random() + " */ ";
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      db._drop("UnitTestsPlanCache");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that plans are reused for different bind parameter values
+////////////////////////////////////////////////////////////////////////////////
+
+    testDifferentValues : function () {
+      var query = "FOR doc IN @@collection FILTER doc.value < @value SORT doc.value RETURN doc.value";
+
+      var result = execute(query, { "@collection": c.name(), value: 3 });
+      assertFalse(result.cached);
+      assertEqual([ 0, 1, 2 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), value: 5 });
+      assertTrue(result.cached);
+      assertEqual([ 0, 1, 2, 3, 4 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), value: 0 });
+      assertTrue(result.cached);
+      assertEqual([ ], result.json);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that plans are not shared between bind parameter types
+////////////////////////////////////////////////////////////////////////////////
+
+    testDifferentTypes : function () {
+      var query = "FOR doc IN @@collection FILTER doc.value == @value RETURN doc.value";
+
+      var result = execute(query, { "@collection": c.name(), value: 3 });
+      assertFalse(result.cached);
+      assertEqual([ 3 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), value: "3" });
+      assertFalse(result.cached);
+      assertEqual([ ], result.json);
+
+      result = execute(query, { "@collection": c.name(), value: 4 });
+      assertTrue(result.cached);
+      assertEqual([ 4 ], result.json);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that plans are not shared between collections
+////////////////////////////////////////////////////////////////////////////////
+
+    testDifferentCollections : function () {
+      var query = "FOR doc IN @@collection RETURN 1";
+
+      db._drop("UnitTestsPlanCache2");
+      var c2 = db._create("UnitTestsPlanCache2");
+      c2.save({ });
+
+      try {
+        var result = execute(query, { "@collection": c.name() });
+        assertFalse(result.cached);
+        assertEqual(100, result.json.length);
+
+        result = execute(query, { "@collection": c2.name() });
+        assertFalse(result.cached);
+        assertEqual(1, result.json.length);
+
+        result = execute(query, { "@collection": c.name() });
+        assertEqual(100, result.json.length);
+      }
+      finally {
+        db._drop("UnitTestsPlanCache2");
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test bind parameters used with an index
+////////////////////////////////////////////////////////////////////////////////
+
+    testIndex : function () {
+      c.ensureHashIndex("value");
+      var query = "FOR doc IN @@collection FILTER doc.value == @value RETURN doc._key";
+
+      for (var i = 0; i < 10; ++i) {
+        var result = execute(query, { "@collection": c.name(), value: i * 7 });
+        assertEqual(i > 0, result.cached);
+        assertEqual([ "test" + (i * 7) ], result.json);
+      }
+
+      query = "FOR doc IN @@collection FILTER doc.value IN @values SORT doc.value RETURN doc.value";
+      var result2 = execute(query, { "@collection": c.name(), values: [ 1, 2, 3 ] });
+      assertFalse(result2.cached);
+      assertEqual([ 1, 2, 3 ], result2.json);
+
+      result2 = execute(query, { "@collection": c.name(), values: [ 17, 99, 1000 ] });
+      assertTrue(result2.cached);
+      assertEqual([ 17, 99 ], result2.json);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test bind parameters that the optimizer may fold
+////////////////////////////////////////////////////////////////////////////////
+
+    testConstantConditions : function () {
+      var query = "FOR doc IN @@collection FILTER @flag SORT doc.value LIMIT 2 RETURN doc.value";
+
+      var result = execute(query, { "@collection": c.name(), flag: true });
+      assertFalse(result.cached);
+      assertEqual([ 0, 1 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), flag: false });
+      assertTrue(result.cached);
+      assertEqual([ ], result.json);
+
+      query = "LET x = @value + 1 FOR i IN 1..@max FILTER i > x RETURN i";
+      result = execute(query, { value: 1, max: 4 });
+      assertEqual([ 3, 4 ], result.json);
+
+      result = execute(query, { value: 2, max: 5 });
+      assertTrue(result.cached);
+      assertEqual([ 4, 5 ], result.json);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test array and object bind parameters
+////////////////////////////////////////////////////////////////////////////////
+
+    testStructuredValues : function () {
+      var query = "FOR value IN @values RETURN [ value, @object.a, @object[@key] ]";
+
+      var result = execute(query, { values: [ 1, 2 ], object: { a: 1, b: 2 }, key: "b" });
+      assertFalse(result.cached);
+      assertEqual([ [ 1, 1, 2 ], [ 2, 1, 2 ] ], result.json);
+
+      result = execute(query, { values: [ "x" ], object: { a: [ 3 ], b: { c: 4 } }, key: "b" });
+      assertTrue(result.cached);
+      assertEqual([ [ "x", [ 3 ], { c: 4 } ] ], result.json);
+
+      result = execute(query, { values: [ "x" ], object: { a: [ 3 ], b: { c: 4 } }, key: "a" });
+      assertFalse(result.cached);
+      assertEqual([ [ "x", [ 3 ], [ 3 ] ] ], result.json);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test bind parameters whose values the optimizer needs
+////////////////////////////////////////////////////////////////////////////////
+
+    testConstantParameters : function () {
+      var query = "FOR doc IN @@collection SORT doc.value @direction LIMIT @offset, @limit RETURN doc.@attribute";
+
+      var result = execute(query, { "@collection": c.name(), direction: "ASC", offset: 0, limit: 2, attribute: "value" });
+      assertFalse(result.cached);
+      assertEqual([ 0, 1 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), direction: "ASC", offset: 0, limit: 2, attribute: "value" });
+      assertTrue(result.cached);
+      assertEqual([ 0, 1 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), direction: "DESC", offset: 0, limit: 2, attribute: "value" });
+      assertFalse(result.cached);
+      assertEqual([ 99, 98 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), direction: "DESC", offset: 1, limit: 3, attribute: "value" });
+      assertFalse(result.cached);
+      assertEqual([ 98, 97, 96 ], result.json);
+
+      result = execute(query, { "@collection": c.name(), direction: "DESC", offset: 1, limit: 3, attribute: "name" });
+      assertFalse(result.cached);
+      assertEqual([ "name8", "name7", "name6" ], result.json);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test bind parameters in data-modification queries
+////////////////////////////////////////////////////////////////////////////////
+
+    testModification : function () {
+      var query = "FOR doc IN @@collection FILTER doc.value == @value UPDATE doc WITH { updated: @updated } IN @@collection OPTIONS { waitForSync: @sync }";
+
+      execute(query, { "@collection": c.name(), value: 1, updated: "a", sync: false });
+      var result = execute(query, { "@collection": c.name(), value: 2, updated: "b", sync: false });
+      assertTrue(result.cached);
+
+      assertEqual("a", c.document("test1").updated);
+      assertEqual("b", c.document("test2").updated);
+      assertEqual(2, c.toArray().filter(function (doc) { return doc.hasOwnProperty("updated"); }).length);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that plans are invalidated when indexes change
+////////////////////////////////////////////////////////////////////////////////
+
+    testInvalidation : function () {
+      var query = "FOR doc IN @@collection FILTER doc.value == @value RETURN doc.value";
+
+      execute(query, { "@collection": c.name(), value: 1 });
+      assertTrue(execute(query, { "@collection": c.name(), value: 1 }).cached);
+
+      c.ensureSkiplist("value");
+
+      var result = execute(query, { "@collection": c.name(), value: 2 });
+      assertFalse(result.cached);
+      assertEqual([ 2 ], result.json);
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(ahuacatlPlanCacheTestSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
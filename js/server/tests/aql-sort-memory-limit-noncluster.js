@@ -0,0 +1,183 @@
+/*jshint globalstrict:false, strict:false, maxlen: 500 */
+/*global assertEqual, assertTrue, AQL_EXECUTE */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for sorting with a memory limit
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var db = require("org/arangodb").db;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function ahuacatlSortMemoryLimitTestSuite () {
+  // a memory limit of 1 byte makes the sort spill every input block
+  var paramSpill    = { memoryLimit: 1 };
+  var paramInMemory = { memoryLimit: 0 };
+
+  var c;
+
+  var compare = function (query, bindVars) {
+    var expected = AQL_EXECUTE(query, bindVars || { }, paramInMemory).json;
+    var actual = AQL_EXECUTE(query, bindVars || { }, paramSpill).json;
+    assertEqual(expected, actual, query);
+    return actual;
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      db._drop("UnitTestsSortMemoryLimit");
+      c = db._create("UnitTestsSortMemoryLimit");
+
+      var mixed = [ null, false, true, -1, 2.5, "", "foo", [ 1 ], { a: 1 } ];
+
+      for (var i = 0; i < 5000; ++i) {
+        c.save({ _key: "test" + i, value: i, group: i % 13, name: "test" + (i % 100), mixed: mixed[i % mixed.length] });
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      db._drop("UnitTestsSortMemoryLimit");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test sorting documents by unique values
+////////////////////////////////////////////////////////////////////////////////
+
+    testSortDocuments : function () {
+      var result = compare("FOR doc IN " + c.name() + " SORT doc.value RETURN doc");
+      assertEqual(5000, result.length);
+      for (var i = 0; i < 5000; ++i) {
+        assertEqual("test" + i, result[i]._key);
+        assertEqual(i, result[i].value);
+      }
+
+      result = compare("FOR doc IN " + c.name() + " SORT doc._key DESC RETURN doc._key");
+      assertEqual(5000, result.length);
+      for (i = 1; i < result.length; ++i) {
+        assertTrue(result[i - 1] > result[i]);
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test sorting by values with ties. the in-memory sort is not stable,
+/// so only the sort values are compared
+////////////////////////////////////////////////////////////////////////////////
+
+    testSortValues : function () {
+      var result = compare("FOR doc IN " + c.name() + " SORT doc.group RETURN doc.group");
+      assertEqual(5000, result.length);
+      for (var i = 1; i < result.length; ++i) {
+        assertTrue(result[i - 1] <= result[i]);
+      }
+
+      compare("FOR doc IN " + c.name() + " SORT doc.group DESC, doc.name RETURN [ doc.group, doc.name ]");
+      compare("FOR doc IN " + c.name() + " SORT doc.mixed RETURN doc.mixed");
+      compare("FOR doc IN " + c.name() + " SORT doc.name, doc.mixed DESC RETURN [ doc.name, doc.mixed ]");
+      compare("FOR doc IN " + c.name() + " LET x = doc.value % 7 SORT x, doc.value DESC RETURN [ x, doc.value ]");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test sorting inputs that are not documents
+////////////////////////////////////////////////////////////////////////////////
+
+    testSortNonDocuments : function () {
+      var result = compare("FOR i IN 1..100000 SORT (i * 7919) % 100000 RETURN (i * 7919) % 100000");
+      assertEqual(100000, result.length);
+      for (var i = 0; i < result.length; ++i) {
+        assertEqual(i, result[i]);
+      }
+
+      compare("FOR i IN 1..3000 LET x = { a: i % 10, b: [ i % 3, 'x' + i ] } SORT x.a, x.b[0] DESC RETURN [ x.a, x.b[0] ]");
+
+      assertEqual([ ], compare("FOR i IN [ ] SORT i RETURN i"));
+      assertEqual([ 1, 2, 3 ], compare("FOR i IN [ 3, 1, 2 ] SORT i RETURN i"));
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test that the stable sort of COLLECT stays stable when it spills
+////////////////////////////////////////////////////////////////////////////////
+
+    testStability : function () {
+      var values = [ ], i;
+      for (i = 0; i < 5000; ++i) {
+        values.push({ group: (i * 7) % 11, position: i });
+      }
+
+      // stable sort by group
+      var expected = [ ];
+      for (var group = 0; group < 11; ++group) {
+        var positions = [ ];
+        for (i = 0; i < values.length; ++i) {
+          if (values[i].group === group) {
+            positions.push(values[i].position);
+          }
+        }
+        expected.push([ group, positions ]);
+      }
+
+      var query = "FOR v IN @values COLLECT group = v.group INTO items RETURN [ group, items[*].v.position ]";
+      var result = compare(query, { values: values });
+      assertEqual(expected, result);
+
+      // the same for documents
+      query = "FOR doc IN " + c.name() + " SORT doc.value COLLECT group = doc.group INTO items RETURN [ group, items[*].doc.value ]";
+      result = compare(query);
+      assertEqual(13, result.length);
+      result.forEach(function (row) {
+        assertEqual(row[0] < 8 ? 385 : 384, row[1].length);
+        for (i = 0; i < row[1].length; ++i) {
+          assertEqual(row[0] + i * 13, row[1][i]);
+        }
+      });
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(ahuacatlSortMemoryLimitTestSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
@@ -0,0 +1,133 @@
+/*jshint globalstrict:false, strict:false, unused : false */
+/*global assertEqual, assertFalse */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for recovery after a crash while writing an index snapshot
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var db = require("org/arangodb").db;
+var internal = require("internal");
+var fs = require("fs");
+var jsunity = require("jsunity");
+
+var snapshotFile = function (c, suffix) {
+  return fs.join(db._path(), "collection-" + c._id, "snapshot.db" + (suffix || ""));
+};
+
+function runSetup () {
+  'use strict';
+  internal.debugClearFailAt();
+
+  try {
+    db._dropDatabase("UnitTestsRecovery");
+  }
+  catch (err) {
+  }
+
+  db._createDatabase("UnitTestsRecovery", { indexSnapshots: true });
+  db._useDatabase("UnitTestsRecovery");
+
+  var c = db._create("UnitTestsRecovery"), i;
+
+  for (i = 0; i < 1000; ++i) {
+    c.save({ _key: "test" + i, value: i });
+  }
+  for (i = 0; i < 1000; i += 3) {
+    c.remove("test" + i);
+  }
+
+  internal.wal.flush(true, true);
+
+  // the server crashes after the snapshot was written to the temporary file,
+  // but before the file is renamed
+  internal.debugSetFailAt("WriteSnapshotBeforeRename");
+
+  for (i = 0; i < 100; ++i) {
+    c.unload();
+    internal.wait(0.5, false);
+  }
+
+  internal.debugSegfault("crashing server");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function recoverySuite () {
+  'use strict';
+  jsunity.jsUnity.attachAssertions();
+
+  return {
+    setUp: function () {
+      db._useDatabase("UnitTestsRecovery");
+    },
+    tearDown: function () {
+      db._useDatabase("_system");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test whether the collection is loaded from its datafiles
+////////////////////////////////////////////////////////////////////////////////
+
+    testIndexSnapshotCrashBeforeRename : function () {
+      var c = db._collection("UnitTestsRecovery"), i;
+
+      assertEqual(666, c.count());
+
+      for (i = 0; i < 1000; ++i) {
+        if (i % 3 === 0) {
+          assertFalse(c.exists("test" + i));
+        }
+        else {
+          assertEqual(i, c.document("test" + i).value);
+        }
+      }
+
+      // the temporary file is removed when the collection is loaded
+      assertFalse(fs.exists(snapshotFile(c)));
+      assertFalse(fs.exists(snapshotFile(c, ".tmp")));
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function main (argv) {
+  'use strict';
+  if (argv[1] === "setup") {
+    runSetup();
+    return 0;
+  }
+  else {
+    jsunity.run(recoverySuite);
+    return jsunity.done().status ? 0 : 1;
+  }
+}
+
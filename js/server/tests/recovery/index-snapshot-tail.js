@@ -0,0 +1,165 @@
+/*jshint globalstrict:false, strict:false, unused : false */
+/*global assertEqual, assertFalse */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for recovery with an outdated index snapshot
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var db = require("org/arangodb").db;
+var internal = require("internal");
+var fs = require("fs");
+var jsunity = require("jsunity");
+
+var snapshotFile = function (c) {
+  return fs.join(db._path(), "collection-" + c._id, "snapshot.db");
+};
+
+function runSetup () {
+  'use strict';
+  internal.debugClearFailAt();
+
+  try {
+    db._dropDatabase("UnitTestsRecovery");
+  }
+  catch (err) {
+  }
+
+  db._createDatabase("UnitTestsRecovery", { indexSnapshots: true });
+  db._useDatabase("UnitTestsRecovery");
+
+  var c = db._create("UnitTestsRecovery", { journalSize: 1048576, doCompact: false }), i;
+
+  for (i = 0; i < 3000; ++i) {
+    c.save({ _key: "test" + i, value: i });
+  }
+
+  internal.wal.flush(true, true);
+
+  // write the snapshot
+  for (i = 0; i < 100 && ! fs.exists(snapshotFile(c)); ++i) {
+    c.unload();
+    internal.wait(0.5, false);
+  }
+
+  var snapshot = fs.readBuffer(snapshotFile(c));
+
+  // these operations are transferred into the datafiles behind the markers
+  // of the snapshot
+  for (i = 3000; i < 4000; ++i) {
+    c.save({ _key: "test" + i, value: i });
+  }
+  for (i = 0; i < 1000; i += 10) {
+    c.update("test" + i, { value: -i });
+  }
+
+  internal.wal.flush(true, true);
+
+  // these operations stay in the logfiles
+  internal.debugSetFailAt("CollectorThreadProcessQueuedOperations");
+
+  for (i = 4000; i < 5000; ++i) {
+    c.save({ _key: "test" + i, value: i });
+  }
+  for (i = 0; i < 5000; i += 7) {
+    c.remove("test" + i);
+  }
+  for (i = 5; i < 5000; i += 10) {
+    if (i % 7 !== 0) {
+      c.update("test" + i, { value: -i });
+    }
+  }
+
+  // put back the snapshot, as if it could not be removed after it was used
+  fs.write(snapshotFile(c), snapshot);
+
+  c.save({ _key: "foo" }, true);
+
+  internal.debugSegfault("crashing server");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function recoverySuite () {
+  'use strict';
+  jsunity.jsUnity.attachAssertions();
+
+  return {
+    setUp: function () {
+      db._useDatabase("UnitTestsRecovery");
+    },
+    tearDown: function () {
+      db._useDatabase("_system");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test whether the snapshot and the later operations are restored
+////////////////////////////////////////////////////////////////////////////////
+
+    testIndexSnapshotTail : function () {
+      var c = db._collection("UnitTestsRecovery"), i, doc, count = 0;
+
+      for (i = 0; i < 5000; ++i) {
+        if (i % 7 === 0) {
+          assertFalse(c.exists("test" + i));
+          continue;
+        }
+
+        ++count;
+        doc = c.document("test" + i);
+
+        if ((i < 1000 && i % 10 === 0) || i % 10 === 5) {
+          assertEqual(-i, doc.value);
+        }
+        else {
+          assertEqual(i, doc.value);
+        }
+      }
+
+      assertEqual(count + 1, c.count());
+      assertFalse(fs.exists(snapshotFile(c)));
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function main (argv) {
+  'use strict';
+  if (argv[1] === "setup") {
+    runSetup();
+    return 0;
+  }
+  else {
+    jsunity.run(recoverySuite);
+    return jsunity.done().status ? 0 : 1;
+  }
+}
+
@@ -0,0 +1,163 @@
+/*jshint globalstrict:false, strict:false, unused : false */
+/*global assertEqual, assertFalse, assertNull */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tests for recovery of many collections
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var db = require("org/arangodb").db;
+var internal = require("internal");
+var jsunity = require("jsunity");
+
+var numberOfCollections = 25;
+var numberOfDocuments = 2000;
+
+function runSetup () {
+  'use strict';
+  internal.debugClearFailAt();
+
+  var c, i, j, payload = "";
+
+  for (i = 0; i < 500; ++i) {
+    payload += "x";
+  }
+
+  // each collection gets more than one datafile, so that the datafiles of a
+  // collection are opened in parallel, too
+  for (i = 0; i < numberOfCollections; ++i) {
+    db._drop("UnitTestsRecovery" + i);
+    c = db._create("UnitTestsRecovery" + i, { journalSize: 1024 * 1024 });
+
+    for (j = 0; j < numberOfDocuments; ++j) {
+      c.save({ _key: "test" + j, value: j, collection: i, payload: payload });
+    }
+  }
+
+  db._drop("UnitTestsRecoveryDropped");
+  c = db._create("UnitTestsRecoveryDropped");
+  c.save({ _key: "test" });
+
+  // move all documents into the datafiles
+  internal.wal.flush(true, true);
+
+  // the following operations stay in the logfiles, so all collections are
+  // loaded by the recovery before the logfiles are replayed
+  internal.debugSetFailAt("CollectorThreadProcessQueuedOperations");
+
+  for (i = 0; i < numberOfCollections; ++i) {
+    c = db._collection("UnitTestsRecovery" + i);
+
+    for (j = 0; j < numberOfDocuments; j += 10) {
+      c.update("test" + j, { value: -j });
+    }
+    for (j = 5; j < numberOfDocuments; j += 10) {
+      c.remove("test" + j);
+    }
+    c.save({ _key: "new", collection: i });
+  }
+
+  // collections created and dropped in the logfiles are not preloaded
+  db._drop("UnitTestsRecoveryCreated");
+  c = db._create("UnitTestsRecoveryCreated");
+  c.save({ _key: "test", value: 1 });
+
+  c = db._collection("UnitTestsRecoveryDropped");
+  c.save({ _key: "test2" });
+  db._drop("UnitTestsRecoveryDropped");
+
+  c = db._collection("UnitTestsRecovery0");
+  c.save({ _key: "crashme" }, true);
+
+  internal.debugSegfault("crashing server");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function recoverySuite () {
+  'use strict';
+  jsunity.jsUnity.attachAssertions();
+
+  return {
+    setUp: function () {
+    },
+    tearDown: function () {
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test whether all collections are restored
+////////////////////////////////////////////////////////////////////////////////
+
+    testManyCollections : function () {
+      var c, i, j, doc;
+
+      for (i = 0; i < numberOfCollections; ++i) {
+        c = db._collection("UnitTestsRecovery" + i);
+
+        assertEqual(numberOfDocuments - numberOfDocuments / 10 + 1 + (i === 0 ? 1 : 0), c.count());
+
+        for (j = 0; j < numberOfDocuments; ++j) {
+          if (j % 10 === 5) {
+            assertFalse(c.exists("test" + j));
+            continue;
+          }
+
+          doc = c.document("test" + j);
+          assertEqual(j % 10 === 0 ? -j : j, doc.value);
+          assertEqual(i, doc.collection);
+          assertEqual(500, doc.payload.length);
+        }
+
+        assertEqual(i, c.document("new").collection);
+      }
+
+      c = db._collection("UnitTestsRecoveryCreated");
+      assertEqual(1, c.count());
+      assertEqual(1, c.document("test").value);
+
+      assertNull(db._collection("UnitTestsRecoveryDropped"));
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function main (argv) {
+  'use strict';
+  if (argv[1] === "setup") {
+    runSetup();
+    return 0;
+  }
+  else {
+    jsunity.run(recoverySuite);
+    return jsunity.done().status ? 0 : 1;
+  }
+}
+
@@ -851,6 +851,250 @@ function CompactionSuite () {
   };
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite: selection of datafiles and throttling
+////////////////////////////////////////////////////////////////////////////////
+
+function CompactionSelectionSuite () {
+  'use strict';
+  var cn = "UnitTestsCompactionSelection";
+  var c, properties, payload;
+
+  var maxWait = internal.valgrind ? 750 : 90;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief writes n documents into a datafile of their own, and removes the
+/// first n of them, with the deletion markers in a datafile of their own
+////////////////////////////////////////////////////////////////////////////////
+
+  var fillDatafile = function (prefix, n) {
+    for (var i = 0; i < n; ++i) {
+      c.save({ _key: prefix + i, value: i, payload: payload });
+    }
+
+    internal.wal.flush(true, true);
+    c.rotate();
+  };
+
+  var remove = function (prefix, n) {
+    for (var i = 0; i < n; ++i) {
+      c.remove(prefix + i);
+    }
+
+    internal.wal.flush(true, true);
+    c.rotate();
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief turns on the compaction and waits until it has compacted the given
+/// number of datafiles. returns the time waited
+////////////////////////////////////////////////////////////////////////////////
+
+  var compact = function (files) {
+    var start = internal.time();
+    c.properties({ doCompact: true });
+
+    var tries = 0;
+    while (++tries < maxWait * 10) {
+      if (c.figures().compaction.files >= files) {
+        break;
+      }
+
+      internal.wait(0.1, false);
+    }
+
+    var elapsed = internal.time() - start;
+    assertEqual(files, c.figures().compaction.files);
+
+    // give the compactor the chance for more runs, which it must not do
+    internal.wait(2, false);
+    assertEqual(files, c.figures().compaction.files);
+
+    return elapsed;
+  };
+
+  var check = function (prefix, n, removed) {
+    for (var i = 0; i < n; ++i) {
+      assertEqual(i >= removed, c.exists(prefix + i) !== false);
+    }
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      properties = internal.compaction.properties();
+      internal.compaction.properties({ interval: 0.2 });
+
+      internal.db._drop(cn);
+      c = internal.db._create(cn, { journalSize: 1048576, doCompact: false });
+
+      payload = new Array(400).join("x");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      internal.compaction.properties(properties);
+      internal.db._drop(cn);
+      c = null;
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the properties can be read and changed
+////////////////////////////////////////////////////////////////////////////////
+
+    testProperties : function () {
+      var p = internal.compaction.properties({ maxFiles: 7, maxWriteRate: 12345 });
+
+      assertEqual(7, p.maxFiles);
+      assertEqual(12345, p.maxWriteRate);
+      assertEqual(properties.deadSizeThreshold, p.deadSizeThreshold);
+      assertEqual(properties.smallDatafileSize, p.smallDatafileSize);
+
+      p = internal.compaction.properties();
+      assertEqual(7, p.maxFiles);
+      assertEqual(12345, p.maxWriteRate);
+
+      // at least one datafile is compacted per run
+      assertEqual(1, internal.compaction.properties({ maxFiles: 0 }).maxFiles);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the compaction starts with the datafile that has the highest share
+/// of dead documents, and does not merge datafiles without enough dead data
+////////////////////////////////////////////////////////////////////////////////
+
+    testSelectHighestScore : function () {
+      internal.compaction.properties({
+        deadSizeThreshold: 1024 * 1024 * 1024,
+        deadShareThreshold: 0.3,
+        smallDatafileSize: 0,
+        maxFiles: 4
+      });
+
+      fillDatafile("a", 1000);
+      fillDatafile("b", 1000);
+      fillDatafile("c", 1000);
+      fillDatafile("d", 1000);
+      assertEqual(4, c.figures().datafiles.count);
+
+      // a share of 10 % in "a" is below the threshold. the deletion markers go
+      // into a fifth datafile
+      remove("a", 100);
+      remove("b", 500);
+      remove("c", 900);
+      assertEqual(5, c.figures().datafiles.count);
+
+      // "c" is compacted first, on its own, as "d" has no dead documents. "b"
+      // follows in a second run, without the compacted "c". starting with the
+      // first eligible datafile would have merged "b" and "c" in one run
+      compact(2);
+
+      var fig = c.figures();
+      assertEqual(2, fig.compaction.count);
+      assertEqual(5, fig.datafiles.count);
+      assertEqual(4000 - 1500, c.count());
+
+      check("a", 1000, 100);
+      check("b", 1000, 500);
+      check("c", 1000, 900);
+      check("d", 1000, 0);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief adjacent small datafiles are merged, up to maxFiles per run
+////////////////////////////////////////////////////////////////////////////////
+
+    testMergeSmallDatafiles : function () {
+      internal.compaction.properties({
+        deadSizeThreshold: 1024 * 1024 * 1024,
+        deadShareThreshold: 1.0,
+        smallDatafileSize: 16 * 1024 * 1024,
+        maxFiles: 3
+      });
+
+      fillDatafile("a", 500);
+      fillDatafile("b", 500);
+      fillDatafile("c", 500);
+      fillDatafile("d", 500);
+      fillDatafile("e", 500);
+      assertEqual(5, c.figures().datafiles.count);
+
+      // "a" to "c" are merged in the first run, the result and "d" and "e" in
+      // the second. the single datafile left has no small neighbor
+      compact(3 + 3);
+
+      var fig = c.figures();
+      assertEqual(2, fig.compaction.count);
+      assertEqual(1, fig.datafiles.count);
+      assertEqual(2500, c.count());
+
+      check("a", 500, 0);
+      check("e", 500, 0);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief datafiles of the default size are not small, and are not merged
+/// without dead documents
+////////////////////////////////////////////////////////////////////////////////
+
+    testNoMergeWithoutDeadDocuments : function () {
+      internal.compaction.properties({
+        deadSizeThreshold: 1024 * 1024 * 1024,
+        deadShareThreshold: 1.0,
+        smallDatafileSize: 1024
+      });
+
+      fillDatafile("a", 500);
+      fillDatafile("b", 500);
+      fillDatafile("c", 500);
+
+      c.properties({ doCompact: true });
+      internal.wait(3, false);
+
+      var fig = c.figures();
+      assertEqual(0, fig.compaction.count);
+      assertEqual(3, fig.datafiles.count);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the compaction does not write faster than maxWriteRate
+////////////////////////////////////////////////////////////////////////////////
+
+    testMaxWriteRate : function () {
+      var rate = 128 * 1024;
+
+      internal.compaction.properties({
+        deadSizeThreshold: 1024 * 1024 * 1024,
+        deadShareThreshold: 0.3,
+        smallDatafileSize: 0,
+        maxFiles: 4,
+        maxWriteRate: rate
+      });
+
+      fillDatafile("a", 1500);
+      remove("a", 750);
+
+      var elapsed = compact(1);
+      var fig = c.figures();
+
+      // the data written by the compaction takes at least this long
+      assertTrue(fig.compaction.bytesWritten > 256 * 1024);
+      assertTrue(elapsed >= fig.compaction.bytesWritten / rate * 0.95,
+                 elapsed + " " + fig.compaction.bytesWritten);
+
+      check("a", 1500, 750);
+    }
+
+  };
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                              main
 // -----------------------------------------------------------------------------
@@ -860,6 +1104,7 @@ function CompactionSuite () {
 ////////////////////////////////////////////////////////////////////////////////
 
 jsunity.run(CompactionSuite);
+jsunity.run(CompactionSelectionSuite);
 
 return jsunity.done();
 
@@ -0,0 +1,162 @@
+/*jshint globalstrict:false, strict:false */
+/*global assertEqual, assertTrue */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test compressed datafiles
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var internal = require("internal");
+var fs = require("fs");
+var testHelper = require("org/arangodb/test-helper").Helper;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function CompressedDatafilesSuite () {
+  var cn = "UnitTestsCompressedDatafiles";
+  var c, expected, payload;
+
+  var directory = function () {
+    return fs.join(internal.db._path(), "collection-" + c._id);
+  };
+
+  var datafiles = function () {
+    return fs.list(directory()).filter(function (name) {
+      return name.match(/^datafile-\d+\.db$/);
+    });
+  };
+
+  var isCompressed = function (name) {
+    var buffer = fs.readBuffer(fs.join(directory(), name));
+    return buffer.toString("binary", 0, 10) === "ARANGO-DFZ";
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief waits until the compactor has compressed all datafiles
+////////////////////////////////////////////////////////////////////////////////
+
+  var waitCompressed = function () {
+    var tries = 0;
+    while (++tries < 120) {
+      internal.wal.flush(true, true);
+
+      var names = datafiles();
+      if (names.length > 1 && names.every(isCompressed)) {
+        return names;
+      }
+      internal.wait(1, false);
+    }
+
+    assertTrue(false, "datafiles were not compressed");
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief checks the collection against the recorded operations
+////////////////////////////////////////////////////////////////////////////////
+
+  var check = function () {
+    var keys = Object.keys(expected);
+
+    assertEqual(keys.length, c.count());
+    assertEqual(keys.length, c.toArray().length);
+
+    keys.forEach(function (key) {
+      var doc = c.document(key);
+      assertEqual(expected[key], doc.value);
+      assertEqual(payload, doc.payload);
+    });
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      internal.db._drop(cn);
+      c = internal.db._create(cn, { journalSize: 1048576, compressDatafiles: true });
+      expected = { };
+      payload = new Array(500).join("x");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      internal.db._drop(cn);
+      c = null;
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief documents in compressed datafiles are read after a reload
+////////////////////////////////////////////////////////////////////////////////
+
+    testReadAfterReload : function () {
+      var i;
+      for (i = 0; i < 10000; ++i) {
+        c.save({ _key: "test" + i, value: i, payload: payload });
+        expected["test" + i] = i;
+      }
+      for (i = 0; i < 10000; i += 7) {
+        c.remove("test" + i);
+        delete expected["test" + i];
+      }
+      testHelper.rotate(c);
+
+      waitCompressed();
+      check();
+
+      c.properties({ doCompact: false });
+      testHelper.waitUnload(c, true);
+      c.load();
+
+      // all blocks are decompressed on access, in an order different from
+      // the order of the datafiles
+      check();
+      Object.keys(expected).reverse().forEach(function (key) {
+        assertEqual(expected[key], c.document(key).value);
+      });
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(CompressedDatafilesSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
@@ -0,0 +1,340 @@
+/*jshint globalstrict:false, strict:false */
+/*global assertEqual, assertTrue, assertFalse */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test primary index snapshots
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var internal = require("internal");
+var fs = require("fs");
+var testHelper = require("org/arangodb/test-helper").Helper;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function IndexSnapshotSuite () {
+  var dn = "UnitTestsIndexSnapshot";
+  var cn = "UnitTestsIndexSnapshot";
+  var c, expected, payload;
+
+  var directory = function () {
+    return fs.join(internal.db._path(), "collection-" + c._id);
+  };
+
+  var snapshotFile = function () {
+    return fs.join(directory(), "snapshot.db");
+  };
+
+  var snapshotTempFile = function () {
+    return fs.join(directory(), "snapshot.db.tmp");
+  };
+
+  var datafiles = function () {
+    return fs.list(directory()).filter(function (name) {
+      return name.match(/^(datafile|journal)-\d+\.db$/);
+    });
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief write operations, with their results recorded in expected
+////////////////////////////////////////////////////////////////////////////////
+
+  var save = function (key, value) {
+    expected[key] = { value: value, rev: c.save({ _key: key, value: value, payload: payload })._rev };
+  };
+
+  var update = function (key, value) {
+    expected[key] = { value: value, rev: c.update(key, { value: value })._rev };
+  };
+
+  var remove = function (key) {
+    c.remove(key);
+    delete expected[key];
+  };
+
+  var fill = function (n) {
+    var i;
+    for (i = 0; i < n; ++i) {
+      save("test" + i, i);
+    }
+    for (i = 0; i < n; i += 10) {
+      update("test" + i, -i);
+    }
+    for (i = 0; i < n; i += 7) {
+      remove("test" + i);
+    }
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief unloads the collection and waits until it has written a snapshot
+////////////////////////////////////////////////////////////////////////////////
+
+  var unloadWithSnapshot = function () {
+    // a snapshot is not written while the compactor works on the collection
+    for (var tries = 0; tries < 10; ++tries) {
+      internal.wal.flush(true, true);
+      testHelper.waitUnload(c, true);
+
+      if (fs.exists(snapshotFile())) {
+        return;
+      }
+
+      c.load();
+      internal.wait(1, false);
+    }
+
+    assertTrue(fs.exists(snapshotFile()));
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief checks the collection against the recorded operations
+////////////////////////////////////////////////////////////////////////////////
+
+  var check = function () {
+    var keys = Object.keys(expected);
+
+    assertEqual(keys.length, c.count());
+    assertEqual(keys.length, c.figures().alive.count);
+
+    keys.forEach(function (key) {
+      var doc = c.document(key);
+      assertEqual(expected[key].value, doc.value);
+      assertEqual(expected[key].rev, doc._rev);
+      assertEqual(payload, doc.payload);
+    });
+
+    assertEqual(keys.length, c.toArray().length);
+
+    // the key generator continues after the restored keys
+    var doc = c.save({ });
+    assertTrue(c.exists(doc._key));
+    c.remove(doc._key);
+
+    // the snapshot is used only once
+    assertFalse(fs.exists(snapshotFile()));
+    assertFalse(fs.exists(snapshotTempFile()));
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      internal.db._useDatabase("_system");
+      try {
+        internal.db._dropDatabase(dn);
+      }
+      catch (err) {
+      }
+
+      internal.db._createDatabase(dn, { indexSnapshots: true });
+      internal.db._useDatabase(dn);
+
+      c = internal.db._create(cn, { journalSize: 1048576, doCompact: false });
+      expected = { };
+      payload = new Array(500).join("x");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      c = null;
+      internal.db._useDatabase("_system");
+      internal.db._dropDatabase(dn);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief load a collection from its snapshot
+////////////////////////////////////////////////////////////////////////////////
+
+    testRoundTrip : function () {
+      fill(5000);
+      assertTrue(datafiles().length > 1);
+
+      unloadWithSnapshot();
+      assertFalse(fs.exists(snapshotTempFile()));
+
+      c.load();
+      check();
+
+      // and again, with a snapshot written by a collection that was loaded
+      // from a snapshot
+      update("test1", 1000);
+      remove("test2");
+      unloadWithSnapshot();
+      check();
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief load a collection from a snapshot followed by more markers in the
+/// datafiles, as if the snapshot could not be removed after it was used
+////////////////////////////////////////////////////////////////////////////////
+
+    testRoundTripWithTail : function () {
+      fill(5000);
+      unloadWithSnapshot();
+
+      var snapshot = fs.readBuffer(snapshotFile());
+
+      c.load();
+      assertFalse(fs.exists(snapshotFile()));
+
+      // these operations go into the journal of the snapshot and into new
+      // journals
+      var i;
+      for (i = 5000; i < 8000; ++i) {
+        save("test" + i, i);
+      }
+      for (i = 1; i < 8000; i += 13) {
+        if (expected.hasOwnProperty("test" + i)) {
+          update("test" + i, i * 2);
+        }
+      }
+      for (i = 3; i < 8000; i += 11) {
+        if (expected.hasOwnProperty("test" + i)) {
+          remove("test" + i);
+        }
+      }
+
+      testHelper.waitUnload(c, true);
+
+      // put back the outdated snapshot
+      fs.write(snapshotFile(), snapshot);
+
+      c.load();
+      check();
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief a damaged snapshot is ignored, and the collection is loaded from
+/// its datafiles
+////////////////////////////////////////////////////////////////////////////////
+
+    testCorruptSnapshot : function () {
+      fill(5000);
+
+      var corruptions = [
+        // checksum mismatch in the document records
+        function (buffer) {
+          buffer[buffer.length - 3] = buffer[buffer.length - 3] ^ 0x5a;
+          return buffer;
+        },
+        // checksum mismatch in the header
+        function (buffer) {
+          buffer[40] = buffer[40] ^ 0x01;
+          return buffer;
+        },
+        // truncated
+        function (buffer) {
+          return buffer.slice(0, buffer.length - 8);
+        },
+        // wrong magic
+        function (buffer) {
+          buffer[0] = 0;
+          return buffer;
+        }
+      ];
+
+      corruptions.forEach(function (corrupt) {
+        unloadWithSnapshot();
+
+        fs.write(snapshotFile(), corrupt(fs.readBuffer(snapshotFile())));
+
+        c.load();
+        check();
+      });
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief a snapshot that refers to a datafile removed by the compaction is
+/// ignored
+////////////////////////////////////////////////////////////////////////////////
+
+    testSnapshotAfterCompaction : function () {
+      fill(5000);
+      unloadWithSnapshot();
+
+      var snapshot = fs.readBuffer(snapshotFile());
+      var before = datafiles();
+
+      c.load();
+
+      // make most of the datafiles obsolete
+      for (var i = 0; i < 5000; ++i) {
+        if (i % 50 !== 1 && expected.hasOwnProperty("test" + i)) {
+          remove("test" + i);
+        }
+      }
+
+      internal.wal.flush(true, true);
+      c.rotate();
+      c.properties({ doCompact: true });
+
+      var tries = 0;
+      while (++tries < 90) {
+        var after = datafiles();
+
+        if (before.some(function (name) { return after.indexOf(name) === -1; })) {
+          break;
+        }
+
+        internal.wait(1, false);
+      }
+
+      var current = datafiles();
+      assertTrue(before.some(function (name) { return current.indexOf(name) === -1; }));
+
+      c.properties({ doCompact: false });
+      testHelper.waitUnload(c, true);
+
+      // put back the snapshot, which refers to removed datafiles
+      fs.write(snapshotFile(), snapshot);
+
+      c.load();
+      check();
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(IndexSnapshotSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
@@ -0,0 +1,385 @@
+/*jshint globalstrict:false, strict:false */
+/*global assertEqual, assertTrue, fail */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test key lookups concurrent to writes
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var arangodb = require("org/arangodb");
+var internal = require("internal");
+var tasks = require("org/arangodb/tasks");
+var fs = require("fs");
+var db = arangodb.db;
+var ERRORS = arangodb.errors;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function LookupConcurrentSuite () {
+  var cn = "UnitTestsLookupConcurrent";
+  var n = 100;
+  var c;
+
+  var cleanTasks = function () {
+    tasks.get().forEach(function(task) {
+      if (task.id.match(/^UnitTest/) || task.name.match(/^UnitTest/)) {
+        try {
+          tasks.unregister(task);
+        }
+        catch (err) {
+        }
+      }
+    });
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief starts the writer in a task on another thread
+////////////////////////////////////////////////////////////////////////////////
+
+  var startWriter = function (writer, params) {
+    params.cn = cn;
+    params.n = n;
+
+    tasks.register({
+      id: "UnitTestsLookupConcurrentWriter",
+      name: "UnitTestsLookupConcurrentWriter",
+      command: "(" + String(writer) + ")(params);",
+      offset: 0,
+      params: params
+    });
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief asserts that a document does not exist
+////////////////////////////////////////////////////////////////////////////////
+
+  var assertNotFound = function (key) {
+    try {
+      c.document(key);
+      fail();
+    }
+    catch (err) {
+      assertEqual(ERRORS.ERROR_ARANGO_DOCUMENT_NOT_FOUND.code, err.errorNum, key);
+    }
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief reads documents by key until the writer is done
+////////////////////////////////////////////////////////////////////////////////
+
+  var readUntilDone = function (check) {
+    var start = internal.time();
+    var rounds = 0;
+
+    while (true) {
+      try {
+        c.document("done");
+        break;
+      }
+      catch (err) {
+        assertEqual(ERRORS.ERROR_ARANGO_DOCUMENT_NOT_FOUND.code, err.errorNum);
+      }
+
+      for (var i = 0; i < n; ++i) {
+        check(i);
+      }
+
+      ++rounds;
+
+      if (internal.time() - start > 300) {
+        fail("writer did not finish in time");
+      }
+    }
+
+    return rounds;
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      cleanTasks();
+      db._drop(cn);
+      c = db._create(cn);
+
+      for (var i = 0; i < n; ++i) {
+        c.save({ _key: "test" + i, value: 0, check: 0 });
+      }
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      if (internal.debugCanUseFailAt()) {
+        internal.debugClearFailAt();
+      }
+      cleanTasks();
+      db._drop(cn);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lookups concurrent to updates, aborted transactions and collection
+////////////////////////////////////////////////////////////////////////////////
+
+    testLookupConcurrentUpdates : function () {
+      startWriter(function (params) {
+        var db = require("internal").db;
+        var wal = require("internal").wal;
+        var c = db._collection(params.cn);
+
+        for (var i = 1; i <= params.rounds; ++i) {
+          var j;
+
+          for (j = 0; j < params.n; ++j) {
+            c.update("test" + j, { value: i, check: i });
+          }
+
+          // inserts and updates of an aborted transaction must never be seen
+          try {
+            db._executeTransaction({
+              collections: { write: params.cn },
+              action: function (params) {
+                var c = require("internal").db._collection(params.cn);
+
+                for (var k = 0; k < 10; ++k) {
+                  c.save({ _key: "uncommitted" + k });
+                  c.update("test" + k, { value: -1, check: -1 });
+                }
+
+                throw "abort";
+              },
+              params: params
+            });
+          }
+          catch (err) {
+          }
+
+          if (i % 10 === 0) {
+            // let the collector move the master pointers to the datafiles
+            wal.flush(true, false);
+          }
+        }
+
+        c.save({ _key: "done" });
+      }, { rounds: 200 });
+
+      var last = [ ];
+
+      readUntilDone(function (i) {
+        var doc = c.document("test" + i);
+
+        assertEqual(doc.value, doc.check);
+        assertTrue(doc.value >= 0);
+
+        // updates of a single document become visible in order
+        if (last[i] !== undefined) {
+          assertTrue(doc.value >= last[i]);
+        }
+        last[i] = doc.value;
+
+        assertNotFound("uncommitted" + (i % 10));
+      });
+
+      for (var i = 0; i < n; ++i) {
+        var doc = c.document("test" + i);
+        assertEqual(200, doc.value);
+        assertEqual(200, doc.check);
+      }
+      assertNotFound("uncommitted0");
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lookups concurrent to inserts and removals
+////////////////////////////////////////////////////////////////////////////////
+
+    testLookupConcurrentInsertsRemovals : function () {
+      startWriter(function (params) {
+        var c = require("internal").db._collection(params.cn);
+
+        for (var i = 0; i < params.rounds; ++i) {
+          var j;
+
+          // these inserts make the primary index grow
+          for (j = 0; j < params.n; ++j) {
+            c.save({ _key: "new" + i + "-" + j, value: j, check: j });
+          }
+
+          for (j = 0; j < params.n; ++j) {
+            c.remove("new" + i + "-" + j);
+          }
+        }
+
+        c.save({ _key: "done" });
+      }, { rounds: 50 });
+
+      readUntilDone(function (i) {
+        var doc = c.document("test" + i);
+        assertEqual(0, doc.value);
+        assertEqual(0, doc.check);
+
+        // documents that are about to be inserted or removed are either
+        // found completely or not at all
+        for (var round = 0; round < 50; round += 7) {
+          try {
+            doc = c.document("new" + round + "-" + i);
+            assertEqual(i, doc.value);
+            assertEqual(i, doc.check);
+          }
+          catch (err) {
+            assertEqual(ERRORS.ERROR_ARANGO_DOCUMENT_NOT_FOUND.code, err.errorNum);
+          }
+        }
+      });
+
+      assertEqual(n + 1, c.count());
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lookups concurrent to single operations that are rolled back
+////////////////////////////////////////////////////////////////////////////////
+
+    testLookupConcurrentRollbacks : function () {
+      if (! internal.debugCanUseFailAt()) {
+        return;
+      }
+
+      // the operations fail after the master pointer has been adjusted
+      internal.debugSetFailAt("TransactionOperationAfterAdjust");
+
+      startWriter(function (params) {
+        var internal = require("internal");
+        var c = internal.db._collection(params.cn);
+
+        for (var i = 0; i < params.rounds; ++i) {
+          for (var j = 0; j < params.n; ++j) {
+            try {
+              c.save({ _key: "failed" + j });
+            }
+            catch (err) {
+            }
+
+            try {
+              c.update("test" + j, { value: -1, check: -1 });
+            }
+            catch (err) {
+            }
+          }
+        }
+
+        internal.debugClearFailAt();
+        c.save({ _key: "done" });
+      }, { rounds: 100 });
+
+      readUntilDone(function (i) {
+        var doc = c.document("test" + i);
+        assertEqual(0, doc.value);
+        assertEqual(0, doc.check);
+
+        assertNotFound("failed" + i);
+      });
+
+      assertEqual(n + 1, c.count());
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief lookups of other keys while a writer holds the write lock
+////////////////////////////////////////////////////////////////////////////////
+
+    testLookupWhileWriteLocked : function () {
+      // the key is chosen so that none of the other keys shares its key
+      // stripe in the primary index
+      c.save({ _key: "changed", value: 0 });
+
+      var signal = fs.getTempFile();
+
+      startWriter(function (params) {
+        var internal = require("internal");
+
+        internal.db._executeTransaction({
+          collections: { write: params.cn },
+          action: function (params) {
+            var internal = require("internal");
+            var c = internal.db._collection(params.cn);
+
+            c.update("changed", { value: 1 });
+
+            // the write lock is held until the transaction commits
+            require("fs").write(params.signal, "locked");
+            internal.wait(params.duration, false);
+          },
+          params: params
+        });
+      }, { signal: signal, duration: 10 });
+
+      var start = internal.time();
+
+      while (! fs.exists(signal)) {
+        internal.wait(0.1, false);
+
+        if (internal.time() - start > 60) {
+          fail("writer did not start in time");
+        }
+      }
+
+      start = internal.time();
+
+      for (var i = 0; i < n; ++i) {
+        var doc = c.document("test" + i);
+        assertEqual(0, doc.value);
+      }
+
+      // the reads did not wait for the writer to commit
+      assertTrue(internal.time() - start < 5);
+
+      // the lookup of the changed key waits for the writer to commit
+      assertEqual(1, c.document("changed").value);
+      assertTrue(internal.time() - start >= 5);
+
+      fs.remove(signal);
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(LookupConcurrentSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
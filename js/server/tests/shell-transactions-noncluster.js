@@ -939,6 +939,41 @@ function transactionOperationsSuite () {
       internal.wait(0);
     },
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test: trx with waitForSync
+////////////////////////////////////////////////////////////////////////////////
+
+    testWaitForSyncCommit : function () {
+      c1 = db._create(cn1);
+      c2 = db._create(cn2);
+
+      var obj = {
+        collections : {
+          write: [ cn1, cn2 ]
+        },
+        waitForSync: true,
+        action : function () {
+          for (var i = 0; i < 10; ++i) {
+            c1.save({ _key: "test" + i, value: i });
+            c2.save({ _key: "test" + i, value: i });
+          }
+          return true;
+        }
+      };
+
+      // each commit returns once its commit marker has been synced
+      for (var i = 0; i < 5; ++i) {
+        assertTrue(TRANSACTION(obj));
+        c1.truncate();
+        c2.truncate();
+      }
+
+      assertTrue(TRANSACTION(obj));
+      assertEqual(10, c1.count());
+      assertEqual(10, c2.count());
+      assertEqual(9, c2.document("test9").value);
+    },
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief test: trx with create operation
 ////////////////////////////////////////////////////////////////////////////////
@@ -4264,6 +4299,82 @@ function transactionServerFailuresSuite () {
       internal.wait(0);
     },
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test: failed sync of the commit marker
+////////////////////////////////////////////////////////////////////////////////
+
+    testCommitSyncFailure : function () {
+      c = db._create(cn);
+
+      internal.debugSetFailAt("SynchroniserThreadSync");
+
+      // the transaction is committed once its commit marker is written, so
+      // the commit succeeds although the sync fails
+      var result = TRANSACTION({
+        collections: {
+          write: [ cn ]
+        },
+        waitForSync: true,
+        action: function () {
+          c.save({ _key: "test1", value: 1 });
+          c.save({ _key: "test2", value: 2 });
+          return true;
+        }
+      });
+
+      // the changes are visible while syncing still fails
+      assertTrue(result);
+      assertEqual(2, c.count());
+      assertEqual(1, c.document("test1").value);
+
+      internal.debugClearFailAt();
+
+      assertEqual(2, c.count());
+      assertEqual(1, c.document("test1").value);
+      assertEqual(2, c.document("test2").value);
+
+      // the data is synced once syncing works again
+      internal.wal.flush(true, false);
+
+      TRANSACTION({
+        collections: {
+          write: [ cn ]
+        },
+        waitForSync: true,
+        action: function () {
+          c.save({ _key: "test3", value: 3 });
+          c.save({ _key: "test4", value: 4 });
+        }
+      });
+
+      assertEqual(4, c.count());
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test: failed sync of a trx without waitForSync
+////////////////////////////////////////////////////////////////////////////////
+
+    testCommitNoSyncFailure : function () {
+      c = db._create(cn);
+
+      internal.debugSetFailAt("SynchroniserThreadSync");
+
+      // the commit does not wait for the sync, so it is not affected
+      TRANSACTION({
+        collections: {
+          write: [ cn ]
+        },
+        action: function () {
+          c.save({ _key: "test1", value: 1 });
+          c.save({ _key: "test2", value: 2 });
+        }
+      });
+
+      internal.debugClearFailAt();
+
+      assertEqual(2, c.count());
+    },
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief test: rollback in case of a server-side fail
 ////////////////////////////////////////////////////////////////////////////////
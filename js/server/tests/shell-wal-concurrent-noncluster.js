@@ -0,0 +1,265 @@
+/*jshint globalstrict:false, strict:false */
+/*global assertEqual, assertTrue, fail, REPLICATION_LOGGER_LAST */
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test concurrent writes to the write-ahead log
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2010-2012 triagens GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is triAGENS GmbH, Cologne, Germany
+///
+/// @author Jan Steemann
+/// @author Copyright 2012, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+var jsunity = require("jsunity");
+var arangodb = require("org/arangodb");
+var internal = require("internal");
+var replication = require("org/arangodb/replication");
+var tasks = require("org/arangodb/tasks");
+var db = arangodb.db;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test suite
+////////////////////////////////////////////////////////////////////////////////
+
+function WalConcurrentSuite () {
+  var cn = "UnitTestsWalConcurrent";
+  var writers = 4;
+  var n = 3000;
+  var c;
+
+  var cleanTasks = function () {
+    tasks.get().forEach(function(task) {
+      if (task.id.match(/^UnitTest/) || task.name.match(/^UnitTest/)) {
+        try {
+          tasks.unregister(task);
+        }
+        catch (err) {
+        }
+      }
+    });
+  };
+
+  var compareTicks = function (l, r) {
+    if (l.length !== r.length) {
+      return l.length < r.length ? -1 : 1;
+    }
+    if (l !== r) {
+      return l < r ? -1 : 1;
+    }
+    return 0;
+  };
+
+  var payload = function (writer, i) {
+    return new Array(1 + (writer * 37 + i) % 200).join("x") + "-" + writer + "-" + i;
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief starts the writers in tasks on other threads
+////////////////////////////////////////////////////////////////////////////////
+
+  var startWriters = function () {
+    for (var w = 0; w < writers; ++w) {
+      tasks.register({
+        id: "UnitTestsWalConcurrentWriter" + w,
+        name: "UnitTestsWalConcurrentWriter" + w,
+        command: "(" + String(function (params) {
+          var c = require("internal").db._collection(params.cn);
+          var payload = new Function("return " + params.payload)();
+
+          for (var i = 0; i < params.n; ++i) {
+            c.save({ _key: "test-" + params.writer + "-" + i, writer: params.writer, value: i, payload: payload(params.writer, i) });
+          }
+
+          c.save({ _key: "done-" + params.writer });
+        }) + ")(params);",
+        offset: 0,
+        params: { cn: cn, n: n, writer: w, payload: String(payload) }
+      });
+    }
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief seals logfiles until all writers are done
+////////////////////////////////////////////////////////////////////////////////
+
+  var rotateUntilDone = function () {
+    var start = internal.time();
+    var rotations = 0;
+
+    while (true) {
+      var done = 0;
+      for (var w = 0; w < writers; ++w) {
+        if (c.exists("done-" + w)) {
+          ++done;
+        }
+      }
+
+      if (done === writers) {
+        break;
+      }
+
+      internal.wal.flush(false, false);
+      ++rotations;
+      internal.wait(0.05, false);
+
+      if (internal.time() - start > 300) {
+        fail("writers did not finish in time");
+      }
+    }
+
+    return rotations;
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns all document markers of the collection after the tick,
+/// in logfile order
+////////////////////////////////////////////////////////////////////////////////
+
+  var getLogEntries = function (tick) {
+    var result = [ ];
+
+    while (true) {
+      var entries = REPLICATION_LOGGER_LAST(tick, "999999999999999999999");
+
+      if (entries.length === 0) {
+        break;
+      }
+
+      entries.forEach(function (entry) {
+        // the markers of all logfiles are in tick order
+        assertEqual(1, compareTicks(entry.tick, tick), entry.tick);
+        tick = entry.tick;
+
+        if (entry.type === 2300 && entry.cid === c._id) {
+          result.push(entry);
+        }
+      });
+    }
+
+    return result;
+  };
+
+  return {
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief set up
+////////////////////////////////////////////////////////////////////////////////
+
+    setUp : function () {
+      cleanTasks();
+      db._drop(cn);
+      c = db._create(cn);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief tear down
+////////////////////////////////////////////////////////////////////////////////
+
+    tearDown : function () {
+      cleanTasks();
+      db._drop(cn);
+    },
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief concurrent inserts while logfiles are sealed
+////////////////////////////////////////////////////////////////////////////////
+
+    testConcurrentInsertsWithRotation : function () {
+      var tick = replication.logger.state().state.lastLogTick;
+
+      startWriters();
+      assertTrue(rotateUntilDone() > 0);
+
+      internal.wal.flush(true, false);
+
+      var i, w, doc;
+
+      if (typeof REPLICATION_LOGGER_LAST === "function") {
+        var entries = getLogEntries(tick);
+        var next = [ ];
+
+        assertEqual(writers * (n + 1), entries.length);
+
+        entries.forEach(function (entry) {
+          assertEqual(entry.key, entry.data._key);
+
+          if (entry.key.substr(0, 5) === "done-") {
+            w = Number(entry.key.substr(5));
+            assertEqual(n, next[w]);
+            next[w] = -1;
+            return;
+          }
+
+          w = entry.data.writer;
+          next[w] = next[w] || 0;
+
+          // the markers of each writer are in the order they were written,
+          // and they are intact
+          assertEqual("test-" + w + "-" + next[w], entry.key);
+          assertEqual(next[w], entry.data.value);
+          assertEqual(payload(w, next[w]), entry.data.payload);
+          ++next[w];
+        });
+
+        for (w = 0; w < writers; ++w) {
+          assertEqual(-1, next[w]);
+        }
+      }
+
+      // the collector transfers the same documents into the datafiles
+      internal.wal.flush(true, true);
+      c.unload();
+      c = null;
+      internal.wait(1, false);
+      c = db._collection(cn);
+
+      assertEqual(writers * (n + 1), c.count());
+
+      for (w = 0; w < writers; ++w) {
+        var last = "0";
+
+        for (i = 0; i < n; ++i) {
+          doc = c.document("test-" + w + "-" + i);
+          assertEqual(w, doc.writer);
+          assertEqual(i, doc.value);
+          assertEqual(payload(w, i), doc.payload);
+
+          assertEqual(1, compareTicks(doc._rev, last));
+          last = doc._rev;
+        }
+      }
+    }
+
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief executes the test suite
+////////////////////////////////////////////////////////////////////////////////
+
+jsunity.run(WalConcurrentSuite);
+
+return jsunity.done();
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "^\\(/// @brief\\|/// @addtogroup\\|// --SECTION--\\|/// @page\\|/// @}\\)"
+// End:
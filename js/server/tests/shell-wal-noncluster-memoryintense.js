@@ -89,6 +89,66 @@ function walFailureSuite () {
       assertEqual(1000, c.count());
     },
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief test collector errors after some markers have been transferred
+////////////////////////////////////////////////////////////////////////////////
+
+    testCollectorTransferErrors : function () {
+      db._drop(cn + "Small");
+      var small = db._create(cn + "Small");
+
+      try {
+        internal.wal.flush(true, true);
+
+        var i;
+        for (i = 0; i < 100; ++i) {
+          c.save({ _key: "test" + i, value: i });
+        }
+        for (i = 0; i < 50; ++i) {
+          c.update("test" + i, { value: i + 1000 });
+        }
+        for (i = 0; i < 5; ++i) {
+          small.save({ _key: "test" + i, value: i });
+        }
+
+        // every attempt to collect the logfile fails after some markers of
+        // the big collection have been transferred. the small collection is
+        // transferred completely by the first attempt
+        internal.debugSetFailAt("CollectorThreadTransferError");
+        internal.wal.flush(true, false);
+        internal.wait(6);
+        internal.debugClearFailAt();
+
+        internal.wal.flush(true, true);
+
+        var tries = 0;
+        while (c.figures().uncollectedLogfileEntries > 0 ||
+               small.figures().uncollectedLogfileEntries > 0) {
+          assertTrue(++tries < 120);
+          internal.wait(0.5);
+        }
+
+        // no marker has been transferred twice, and none has been lost
+        assertEqual(100, c.figures().alive.count);
+        assertEqual(5, small.figures().alive.count);
+
+        testHelper.waitUnload(c);
+        testHelper.waitUnload(small);
+
+        assertEqual(100, c.count());
+        assertEqual(5, small.count());
+        for (i = 0; i < 100; ++i) {
+          assertEqual(i < 50 ? i + 1000 : i, c.document("test" + i).value);
+        }
+        for (i = 0; i < 5; ++i) {
+          assertEqual(i, small.document("test" + i).value);
+        }
+      }
+      finally {
+        db._drop(cn + "Small");
+      }
+    },
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief test no more available logfiles
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @brief split work over the threads of a pool
+///
+/// @file
+///
+/// DISCLAIMER
+///
+/// Copyright 2014 ArangoDB GmbH, Cologne, Germany
+/// Copyright 2004-2014 triAGENS GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Copyright 2014, ArangoDB GmbH, Cologne, Germany
+/// @author Copyright 2013-2013, triAGENS GmbH, Cologne, Germany
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARANGODB_BASICS_RUN_IN_THREADS_H
+#define ARANGODB_BASICS_RUN_IN_THREADS_H 1
+
+#include "Basics/Common.h"
+#include "Basics/ThreadPool.h"
+
+#include <exception>
+#include <functional>
+
+namespace triagens {
+  namespace basics {
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief runs work(0) ... work(n - 1), using the threads of pool as helpers
+///
+/// the calling thread takes part in the work. if pool is a nullptr, all of
+/// the work is done by the calling thread. the pool bounds the number of
+/// threads, so callers running at the same time do not oversubscribe the
+/// machine. exceptions thrown by the work are rethrown after all items have
+/// been processed
+////////////////////////////////////////////////////////////////////////////////
+
+    inline void RunInThreads (ThreadPool* pool,
+                              size_t n,
+                              std::function<void(size_t)> const& work) {
+      std::vector<std::exception_ptr> errors(n);
+
+      auto guarded = [&] (size_t i) -> void {
+        try {
+          work(i);
+        }
+        catch (...) {
+          errors[i] = std::current_exception();
+        }
+      };
+
+      if (pool == nullptr || n <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+          guarded(i);
+        }
+      }
+      else {
+        pool->parallelFor(n, guarded);
+      }
+
+      for (auto const& error : errors) {
+        if (error) {
+          std::rethrow_exception(error);
+        }
+      }
+    }
+
+  }
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                       END-OF-FILE
+// -----------------------------------------------------------------------------
+
+// Local Variables:
+// mode: outline-minor
+// outline-regexp: "/// @brief\\|/// {@inheritDoc}\\|/// @page\\|// --SECTION--\\|/// @\\}"
+// End:
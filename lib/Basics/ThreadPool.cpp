@@ -30,6 +30,8 @@
 #include "ThreadPool.h"
 #include "Basics/WorkerThread.h"
 
+#include <exception>
+
 using namespace triagens::basics;
 
 // -----------------------------------------------------------------------------
@@ -113,6 +115,101 @@ bool ThreadPool::dequeue (std::function<void()>& result) {
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute work items in parallel, with the calling thread helping
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::parallelFor (size_t count,
+                              std::function<void(size_t)> const& work) {
+  if (count == 0) {
+    return;
+  }
+
+  struct SharedState {
+    SharedState (size_t count,
+                 std::function<void(size_t)> const& work)
+      : condition(),
+        work(work),
+        count(count),
+        next(0),
+        running(0),
+        error() {
+    }
+
+    // claim and execute items until there are none left
+    void process () {
+      try {
+        while (true) {
+          size_t i = next++;
+
+          if (i >= count) {
+            break;
+          }
+
+          work(i);
+        }
+      }
+      catch (...) {
+        CONDITION_LOCKER(guard, condition);
+
+        if (! error) {
+          error = std::current_exception();
+        }
+
+        // do not start any further items
+        next = count;
+      }
+    }
+
+    triagens::basics::ConditionVariable condition;
+    std::function<void(size_t)> const work;
+    size_t const count;
+    std::atomic<size_t> next;
+    size_t running;
+    std::exception_ptr error;
+  };
+
+  // the state is shared with the helper tasks, which may be dequeued
+  // only after this function has returned
+  auto state = std::make_shared<SharedState>(count, work);
+
+  size_t helpers = (std::min)(count - 1, _threads.size());
+
+  for (size_t i = 0; i < helpers; ++i) {
+    enqueue([state] () -> void {
+      {
+        CONDITION_LOCKER(guard, state->condition);
+
+        if (state->next >= state->count) {
+          // nothing left to do
+          return;
+        }
+
+        ++state->running;
+      }
+
+      state->process();
+
+      CONDITION_LOCKER(guard, state->condition);
+      --state->running;
+      guard.signal();
+    });
+  }
+
+  state->process();
+
+  // all items are claimed now. wait for the helpers still working on theirs
+  CONDITION_LOCKER(guard, state->condition);
+
+  while (state->running > 0) {
+    guard.wait();
+  }
+
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                       END-OF-FILE
 // -----------------------------------------------------------------------------
@@ -75,6 +75,14 @@ namespace triagens {
           return _name.c_str();
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief return the number of threads in the pool
+////////////////////////////////////////////////////////////////////////////////
+
+        size_t numThreads () const {
+          return _threads.size();
+        }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief dequeue a task
 ////////////////////////////////////////////////////////////////////////////////
@@ -95,6 +103,19 @@ namespace triagens {
           _condition.signal();
         }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief execute work(0) ... work(count - 1), using the pool's threads as
+/// helpers. the calling thread takes part in the work, and the call returns
+/// once all items have been processed. helpers that have not been started by
+/// then are not waited for, so it is safe to call this from inside a task of
+/// the same pool. if work throws, items that have not been started are
+/// skipped, and the first exception is rethrown once the items being worked
+/// on are done
+////////////////////////////////////////////////////////////////////////////////
+
+        void parallelFor (size_t,
+                          std::function<void(size_t)> const&);
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                 private variables
 // -----------------------------------------------------------------------------
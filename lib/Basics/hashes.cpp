@@ -29,6 +29,11 @@
 
 #include "hashes.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+#define TRI_HAVE_SSE42_CRC32C 1
+#endif
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                               FNV
 // -----------------------------------------------------------------------------
@@ -566,6 +571,193 @@ uint32_t TRI_Crc32HashString (char const* data) {
   return TRI_FinalCrc32(crc);
 }
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                            CRC32C
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private variables
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief precomputed lookup values for crc32c 8 bytes-at-a-time calculation
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t Crc32CLookup[8][256];
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief the crc32c implementation selected at startup
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t (*BlockCrc32CImpl) (uint32_t, char const*, size_t) = nullptr;
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                 private functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief generates the CRC32C lookup tables
+////////////////////////////////////////////////////////////////////////////////
+
+static void GenerateCrc32CLookup () {
+  // reflected Castagnoli polynomial
+  uint32_t const polynomial = 0x82F63B78;
+
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t value = i;
+
+    for (int j = 0; j < 8; ++j) {
+      value = (value >> 1) ^ ((value & 1) ? polynomial : 0);
+    }
+
+    Crc32CLookup[0][i] = value;
+  }
+
+  for (uint32_t i = 0; i < 256; ++i) {
+    for (int j = 1; j < 8; ++j) {
+      uint32_t previous = Crc32CLookup[j - 1][i];
+      Crc32CLookup[j][i] = (previous >> 8) ^ Crc32CLookup[0][previous & 0xFF];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C value of data block, portable version
+///
+/// processes 8 bytes at a time, like TRI_BlockCrc32
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t BlockCrc32CSoftware (uint32_t value, char const* data, size_t length) {
+  uint8_t const* current = reinterpret_cast<uint8_t const*>(data);
+
+  while (length >= 8) {
+    uint32_t one;
+    uint32_t two;
+    memcpy(&one, current, sizeof(uint32_t));
+    memcpy(&two, current + 4, sizeof(uint32_t));
+    one ^= value;
+
+    value = Crc32CLookup[0][(two>>24) & 0xFF] ^
+            Crc32CLookup[1][(two>>16) & 0xFF] ^
+            Crc32CLookup[2][(two>> 8) & 0xFF] ^
+            Crc32CLookup[3][ two      & 0xFF] ^
+            Crc32CLookup[4][(one>>24) & 0xFF] ^
+            Crc32CLookup[5][(one>>16) & 0xFF] ^
+            Crc32CLookup[6][(one>> 8) & 0xFF] ^
+            Crc32CLookup[7][ one      & 0xFF];
+    current += 8;
+    length -= 8;
+  }
+
+  while (length--) {
+    value = (value >> 8) ^ Crc32CLookup[0][(value & 0xFF) ^ *current++];
+  }
+
+  return value;
+}
+
+#ifdef TRI_HAVE_SSE42_CRC32C
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not the CPU supports SSE4.2
+////////////////////////////////////////////////////////////////////////////////
+
+static bool HasSse42 () {
+  unsigned int eax, ebx, ecx, edx;
+
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+    return false;
+  }
+
+  return (ecx & bit_SSE4_2) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C value of data block, using the SSE4.2 crc32 instruction
+///
+/// inline assembly is used so that this compiles without -msse4.2. it must
+/// only be called if HasSse42() returned true
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t BlockCrc32CHardware (uint32_t value, char const* data, size_t length) {
+  uint8_t const* current = reinterpret_cast<uint8_t const*>(data);
+
+  // process single bytes until the data is 8-byte aligned
+  while (length > 0 && (reinterpret_cast<uintptr_t>(current) & 7) != 0) {
+    __asm__ ("crc32b %1, %0" : "+r" (value) : "rm" (*current));
+    ++current;
+    --length;
+  }
+
+  uint64_t value64 = value;
+
+  while (length >= 8) {
+    __asm__ ("crc32q %1, %0" : "+r" (value64) : "rm" (*reinterpret_cast<uint64_t const*>(current)));
+    current += 8;
+    length -= 8;
+  }
+
+  value = static_cast<uint32_t>(value64);
+
+  while (length > 0) {
+    __asm__ ("crc32b %1, %0" : "+r" (value) : "rm" (*current));
+    ++current;
+    --length;
+  }
+
+  return value;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C (Castagnoli polynomial) value of data block
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TRI_BlockCrc32C (uint32_t value, char const* data, size_t length) {
+  TRI_ASSERT(BlockCrc32CImpl != nullptr);
+
+  return BlockCrc32CImpl(value, data, length);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not CRC32C values are calculated by the CPU
+////////////////////////////////////////////////////////////////////////////////
+
+bool TRI_HasHardwareCrc32C () {
+#ifdef TRI_HAVE_SSE42_CRC32C
+  return HasSse42();
+#else
+  return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C value of data block, always using the lookup tables
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TRI_BlockCrc32CSoftware (uint32_t value, char const* data, size_t length) {
+  return BlockCrc32CSoftware(value, data, length);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C value of data block, always using the crc32 instruction
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TRI_BlockCrc32CHardware (uint32_t value, char const* data, size_t length) {
+  TRI_ASSERT(TRI_HasHardwareCrc32C());
+
+#ifdef TRI_HAVE_SSE42_CRC32C
+  return BlockCrc32CHardware(value, data, length);
+#else
+  return BlockCrc32CSoftware(value, data, length);
+#endif
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                            MODULE
 // -----------------------------------------------------------------------------
@@ -594,6 +786,15 @@ void TRI_InitialiseHashes () {
   }
 
   GenerateCrc32Polynomial();
+  GenerateCrc32CLookup();
+
+  BlockCrc32CImpl = BlockCrc32CSoftware;
+
+#ifdef TRI_HAVE_SSE42_CRC32C
+  if (HasSse42()) {
+    BlockCrc32CImpl = BlockCrc32CHardware;
+  }
+#endif
 
   Initialised = true;
 }
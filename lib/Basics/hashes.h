@@ -120,6 +120,47 @@ uint32_t TRI_Crc32HashPointer (void const*, size_t);
 
 uint32_t TRI_Crc32HashString (char const*);
 
+// -----------------------------------------------------------------------------
+// --SECTION--                                                            CRC32C
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// --SECTION--                                                  public functions
+// -----------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C (Castagnoli polynomial) value of data block
+///
+/// use TRI_InitialCrc32 and TRI_FinalCrc32 for the initial and final values.
+/// uses the SSE4.2 crc32 instruction if the CPU supports it
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TRI_BlockCrc32C (uint32_t, char const* data, size_t length);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief whether or not CRC32C values are calculated by the CPU
+////////////////////////////////////////////////////////////////////////////////
+
+bool TRI_HasHardwareCrc32C (void);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C value of data block, always using the lookup tables
+///
+/// TRI_BlockCrc32C should be used instead. this is only exposed so that the
+/// implementation that is not selected at startup can be tested
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TRI_BlockCrc32CSoftware (uint32_t, char const* data, size_t length);
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief CRC32C value of data block, always using the crc32 instruction
+///
+/// must only be called if TRI_HasHardwareCrc32C returns true. like
+/// TRI_BlockCrc32CSoftware, this is only exposed for testing
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TRI_BlockCrc32CHardware (uint32_t, char const* data, size_t length);
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                            MODULE
 // -----------------------------------------------------------------------------
@@ -1148,6 +1148,44 @@ TRI_json_t* TRI_CopyJson (TRI_memory_zone_t* zone,
   return dst;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief estimate the memory used by a json value
+////////////////////////////////////////////////////////////////////////////////
+
+size_t TRI_MemoryUsageJson (TRI_json_t const* json) {
+  if (json == nullptr) {
+    return 0;
+  }
+
+  size_t size = sizeof(TRI_json_t);
+
+  switch (json->_type) {
+    case TRI_JSON_STRING:
+    case TRI_JSON_STRING_REFERENCE: {
+      size += json->_value._string.length;
+      break;
+    }
+
+    case TRI_JSON_ARRAY:
+    case TRI_JSON_OBJECT: {
+      size_t const n = TRI_LengthVector(&json->_value._objects);
+
+      // the sub values are stored inline in the vector
+      for (size_t i = 0; i < n; ++i) {
+        auto sub = static_cast<TRI_json_t const*>(TRI_AtVector(&json->_value._objects, i));
+        size += TRI_MemoryUsageJson(sub);
+      }
+      break;
+    }
+
+    default: {
+      break;
+    }
+  }
+
+  return size;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief converts a json object into a number
 ////////////////////////////////////////////////////////////////////////////////
@@ -1234,6 +1272,158 @@ double TRI_ToDoubleJson (TRI_json_t const* json) {
   return 0.0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief converts a string into a number, using the rules of JavaScript's
+/// Number() function. returns NaN if the string is not a valid number
+////////////////////////////////////////////////////////////////////////////////
+
+static double StringToDouble (char const* p,
+                              size_t length) {
+  char const* e = p + length;
+
+  // skip leading and trailing whitespace
+  while (p < e && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\f' || *p == '\v')) {
+    ++p;
+  }
+  while (e > p && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\n' || e[-1] == '\r' || e[-1] == '\f' || e[-1] == '\v')) {
+    --e;
+  }
+
+  if (p == e) {
+    // empty string
+    return 0.0;
+  }
+
+  if (e - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    // hexadecimal number, only valid without a sign
+    double value = 0.0;
+
+    for (char const* q = p + 2; q < e; ++q) {
+      int digit;
+
+      if (*q >= '0' && *q <= '9') {
+        digit = *q - '0';
+      }
+      else if (*q >= 'a' && *q <= 'f') {
+        digit = *q - 'a' + 10;
+      }
+      else if (*q >= 'A' && *q <= 'F') {
+        digit = *q - 'A' + 10;
+      }
+      else {
+        return NAN;
+      }
+      value = value * 16.0 + digit;
+    }
+
+    return value;
+  }
+
+  char const* q = p;
+
+  if (*q == '+' || *q == '-') {
+    ++q;
+  }
+
+  if (static_cast<size_t>(e - q) == 8 && memcmp(q, "Infinity", 8) == 0) {
+    return (*p == '-') ? -HUGE_VAL : HUGE_VAL;
+  }
+
+  // validate the number format before handing it to strtod, which would
+  // accept more than JavaScript does (e.g. hexadecimal floats, "nan")
+  bool hasDigits = false;
+
+  while (q < e && *q >= '0' && *q <= '9') {
+    hasDigits = true;
+    ++q;
+  }
+
+  if (q < e && *q == '.') {
+    ++q;
+    while (q < e && *q >= '0' && *q <= '9') {
+      hasDigits = true;
+      ++q;
+    }
+  }
+
+  if (! hasDigits) {
+    return NAN;
+  }
+
+  if (q < e && (*q == 'e' || *q == 'E')) {
+    ++q;
+    if (q < e && (*q == '+' || *q == '-')) {
+      ++q;
+    }
+    if (q == e || *q < '0' || *q > '9') {
+      return NAN;
+    }
+    while (q < e && *q >= '0' && *q <= '9') {
+      ++q;
+    }
+  }
+
+  if (q != e) {
+    return NAN;
+  }
+
+  std::string const value(p, e - p);
+  return strtod(value.c_str(), nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief converts a json object into a number, using the AQL conversion rules
+////////////////////////////////////////////////////////////////////////////////
+
+double TRI_ToDoubleJson (TRI_json_t const* json, 
+                         bool& failed) {
+  failed = false;
+
+  if (json == nullptr) {
+    failed = true;
+    return 0.0;
+  }
+
+  double value = 0.0;
+
+  switch (json->_type) {
+    case TRI_JSON_UNUSED:
+    case TRI_JSON_NULL:
+      return 0.0;
+    case TRI_JSON_BOOLEAN:
+      return (json->_value._boolean ? 1.0 : 0.0);
+    case TRI_JSON_NUMBER:
+      value = json->_value._number;
+      break;
+    case TRI_JSON_STRING:
+    case TRI_JSON_STRING_REFERENCE:
+      value = StringToDouble(json->_value._string.data, json->_value._string.length - 1);
+      break;
+    case TRI_JSON_ARRAY: {
+      size_t const n = TRI_LengthArrayJson(json);
+
+      if (n == 0) {
+        return 0.0;
+      }
+      else if (n == 1) {
+        return TRI_ToDoubleJson(TRI_LookupArrayJson(json, 0), failed);
+      }
+      failed = true;
+      return 0.0;
+    }
+    case TRI_JSON_OBJECT:
+      failed = true;
+      return 0.0;
+  }
+
+  if (std::isnan(value) || value == HUGE_VAL || value == -HUGE_VAL) {
+    failed = true;
+    return 0.0;
+  }
+
+  return value;
+}
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                       END-OF-FILE
 // -----------------------------------------------------------------------------
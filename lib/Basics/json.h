@@ -349,6 +349,12 @@ int TRI_CopyToJson (TRI_memory_zone_t*, TRI_json_t* dst, TRI_json_t const* src);
 TRI_json_t* TRI_CopyJson (TRI_memory_zone_t*, 
                           TRI_json_t const*);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief estimate the memory used by a json value
+////////////////////////////////////////////////////////////////////////////////
+
+size_t TRI_MemoryUsageJson (TRI_json_t const*);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief parses a json string
 ////////////////////////////////////////////////////////////////////////////////
@@ -379,6 +385,16 @@ int64_t TRI_ToInt64Json (TRI_json_t const*);
 
 double TRI_ToDoubleJson (TRI_json_t const*);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief converts a json object into a number, using the AQL conversion
+/// rules (the same as AQL's TO_NUMBER function). failed is set to true if the
+/// value has no numeric representation, which is the case for objects,
+/// arrays with more than one member, non-numeric strings and for numbers that
+/// are NaN or infinite
+////////////////////////////////////////////////////////////////////////////////
+
+double TRI_ToDoubleJson (TRI_json_t const*, bool& failed);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief default deleter for TRI_json_t
 /// this can be used to put a TRI_json_t with TRI_UNKNOWN_MEM_ZONE into an
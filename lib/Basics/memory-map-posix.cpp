@@ -162,6 +162,33 @@ int TRI_ProtectMMFile (void* memoryAddress,
   return TRI_ERROR_SYS_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// @brief give the kernel a hint about the access pattern of a region
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_MMFileAdvise (void* memoryAddress,
+                      size_t numOfBytes,
+                      int advice) {
+  if (advice < 0 || memoryAddress == nullptr || numOfBytes == 0) {
+    // hint not supported on this platform
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  int result = madvise(memoryAddress, numOfBytes, advice);
+
+  if (result == 0) {
+    return TRI_ERROR_NO_ERROR;
+  }
+
+  LOG_DEBUG("madvise %d failed for range %p - %p: %s",
+            advice,
+            memoryAddress,
+            (void*) (((char*) memoryAddress) + numOfBytes),
+            strerror(errno));
+
+  return TRI_ERROR_SYS_ERROR;
+}
+
 #endif
 
 // -----------------------------------------------------------------------------
@@ -49,6 +49,31 @@
 #define TRI_MMAP_ANONYMOUS MAP_ANON
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief access pattern hints for memory mapped regions
+///
+/// hints that are not supported on the platform are defined as -1 and are
+/// ignored by TRI_MMFileAdvise
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRI_MADVISE_NORMAL     MADV_NORMAL
+#define TRI_MADVISE_SEQUENTIAL MADV_SEQUENTIAL
+#define TRI_MADVISE_RANDOM     MADV_RANDOM
+#define TRI_MADVISE_WILLNEED   MADV_WILLNEED
+#define TRI_MADVISE_DONTNEED   MADV_DONTNEED
+
+#ifdef MADV_HUGEPAGE
+#define TRI_MADVISE_HUGEPAGE   MADV_HUGEPAGE
+#else
+#define TRI_MADVISE_HUGEPAGE   (-1)
+#endif
+
+#ifdef MADV_POPULATE_READ
+#define TRI_MADVISE_POPULATE   MADV_POPULATE_READ
+#else
+#define TRI_MADVISE_POPULATE   MADV_WILLNEED
+#endif
+
 #endif
 
 #endif
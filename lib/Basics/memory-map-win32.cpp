@@ -328,6 +328,17 @@ int TRI_ProtectMMFile(void* memoryAddress,  size_t numOfBytesToProtect, int flag
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// @brief give the kernel a hint about the access pattern of a region
+// access pattern hints are not supported under windows
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_MMFileAdvise (void* memoryAddress,
+                      size_t numOfBytes,
+                      int advice) {
+  return TRI_ERROR_NO_ERROR;
+}
+
 
 #endif
 
@@ -75,6 +75,18 @@
 #define PROT_GROWSDOWN  0x01000000      /* Extend change to start of growsdown vma (mprotect only).  */
 #define PROT_GROWSUP    0x02000000      /* Extend change to start of growsup vma (mprotect only).  */
 
+////////////////////////////////////////////////////////////////////////////////
+// Access pattern hints -- these are ignored under windows
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRI_MADVISE_NORMAL      0
+#define TRI_MADVISE_SEQUENTIAL  1
+#define TRI_MADVISE_RANDOM      2
+#define TRI_MADVISE_WILLNEED    3
+#define TRI_MADVISE_DONTNEED    4
+#define TRI_MADVISE_HUGEPAGE    (-1)
+#define TRI_MADVISE_POPULATE    (-1)
+
 #endif
 
 #endif
@@ -111,6 +111,18 @@ int TRI_ProtectMMFile (void* memoryAddress,
                        int fileDescriptor,
                        void** mmHandle);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief gives the kernel a hint how a memory mapped region will be accessed
+///
+/// advice is one of the TRI_MADVISE_* values. the hint does not change the
+/// contents of file-backed regions, except for TRI_MADVISE_DONTNEED on
+/// private anonymous regions, which must therefore not be used for them
+////////////////////////////////////////////////////////////////////////////////
+
+int TRI_MMFileAdvise (void* memoryAddress,
+                      size_t numOfBytes,
+                      int advice);
+
 #endif
 
 // -----------------------------------------------------------------------------
@@ -538,6 +538,31 @@ uint64_t TRI_MicrosecondsTv (struct timeval* tv) {
 
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the page faults of the current thread
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_PageFaultsThread (uint64_t* minorPageFaults,
+                           uint64_t* majorPageFaults) {
+  *minorPageFaults = 0;
+  *majorPageFaults = 0;
+
+#ifdef TRI_HAVE_GETRUSAGE
+  struct rusage used;
+
+#ifdef RUSAGE_THREAD
+  int res = getrusage(RUSAGE_THREAD, &used);
+#else
+  int res = getrusage(RUSAGE_SELF, &used);
+#endif
+
+  if (res == 0) {
+    *minorPageFaults = static_cast<uint64_t>(used.ru_minflt);
+    *majorPageFaults = static_cast<uint64_t>(used.ru_majflt);
+  }
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief returns information about the current process
 ////////////////////////////////////////////////////////////////////////////////
@@ -170,6 +170,16 @@ TRI_process_info_t TRI_ProcessInfo (TRI_pid_t pid);
 
 uint64_t TRI_ProcessSizeSelf (void);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief returns the page faults of the current thread
+///
+/// falls back to the page faults of the whole process if the platform does
+/// not count them per thread
+////////////////////////////////////////////////////////////////////////////////
+
+void TRI_PageFaultsThread (uint64_t* minorPageFaults,
+                           uint64_t* majorPageFaults);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief returns the size of the process given its pid
 ////////////////////////////////////////////////////////////////////////////////
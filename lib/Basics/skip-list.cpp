@@ -30,6 +30,10 @@
 #include "skip-list.h"
 #include "Basics/random.h"
 #include "Basics/Exceptions.h"
+#include "Basics/RunInThreads.h"
+#include "Basics/ThreadPool.h"
+
+#include <functional>
 
 using namespace triagens::basics;
 
@@ -60,6 +64,61 @@ static int randomHeight (void) {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief sorts the documents, using the threads of pool as helpers
+///
+/// the documents are split into one run per thread, including the calling
+/// thread. each run is sorted on its own, then neighbouring runs are merged
+/// pairwise until a single run is left
+////////////////////////////////////////////////////////////////////////////////
+
+static void ParallelSort (std::vector<void*>& docs,
+                          ThreadPool* pool,
+                          std::function<bool(void*, void*)> const& less) {
+  size_t const n = docs.size();
+  size_t const numRuns = (pool == nullptr ? 1 : pool->numThreads() + 1);
+
+  if (numRuns <= 1 || n < 2 * numRuns) {
+    std::sort(docs.begin(), docs.end(), less);
+    return;
+  }
+
+  size_t const perThread = (n + numRuns - 1) / numRuns;
+
+  // bounds[i] .. bounds[i + 1] is the i-th run
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i < n; i += perThread) {
+    bounds.emplace_back(i);
+  }
+  bounds.emplace_back(n);
+
+  RunInThreads(pool, bounds.size() - 1, [&] (size_t i) -> void {
+    std::sort(docs.begin() + bounds[i], docs.begin() + bounds[i + 1], less);
+  });
+
+  while (bounds.size() > 2) {
+    size_t const runs = bounds.size() - 1;
+
+    RunInThreads(pool, runs / 2, [&] (size_t i) -> void {
+      std::inplace_merge(docs.begin() + bounds[2 * i],
+                         docs.begin() + bounds[2 * i + 1],
+                         docs.begin() + bounds[2 * i + 2],
+                         less);
+    });
+
+    std::vector<size_t> merged;
+    for (size_t i = 0; i < bounds.size(); i += 2) {
+      merged.emplace_back(bounds[i]);
+    }
+    if (merged.back() != n) {
+      // an odd run was left over
+      merged.emplace_back(n);
+    }
+
+    bounds.swap(merged);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief Allocation function for a node. If height is 0, then a
 /// random height is taken.
@@ -408,6 +467,79 @@ int SkipList::insert (void* doc) {
   return TRI_ERROR_NO_ERROR;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fills an empty skiplist with many documents at once
+////////////////////////////////////////////////////////////////////////////////
+
+int SkipList::bulkLoad (std::vector<void*>& docs,
+                        ThreadPool* pool) {
+  TRI_ASSERT(_nrUsed == 0);
+
+  try {
+    ParallelSort(docs, pool, [this] (void* left, void* right) -> bool {
+      return _cmp_elm_elm(_cmpdata, left, right, SKIPLIST_CMP_TOTORDER) < 0;
+    });
+  }
+  catch (...) {
+    return TRI_ERROR_OUT_OF_MEMORY;
+  }
+
+  // neighbours in the sorted order are the only candidates for duplicates
+  for (size_t i = 1; i < docs.size(); ++i) {
+    if (0 == _cmp_elm_elm(_cmpdata, docs[i - 1], docs[i], SKIPLIST_CMP_TOTORDER) ||
+        (_unique &&
+         0 == _cmp_elm_elm(_cmpdata, docs[i - 1], docs[i], SKIPLIST_CMP_PREORDER))) {
+      return TRI_ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED;
+    }
+  }
+
+  // the last node linked on each level so far
+  SkipListNode* last[TRI_SKIPLIST_MAX_HEIGHT];
+  for (int lev = 0; lev < TRI_SKIPLIST_MAX_HEIGHT; lev++) {
+    last[lev] = _start;
+  }
+
+  int height = _start->_height;
+
+  try {
+    for (auto doc : docs) {
+      SkipListNode* newNode = allocNode(0);
+      newNode->_doc = doc;
+      newNode->_prev = last[0];
+
+      for (int lev = 0; lev < newNode->_height; lev++) {
+        last[lev]->_next[lev] = newNode;
+        last[lev] = newNode;
+      }
+
+      if (newNode->_height > height) {
+        height = newNode->_height;
+      }
+    }
+  }
+  catch (...) {
+    // free the nodes linked so far, the documents stay with the caller
+    SkipListNode* p = _start->_next[0];
+    while (nullptr != p) {
+      SkipListNode* next = p->_next[0];
+      freeNode(p);
+      p = next;
+    }
+
+    for (int lev = 0; lev < TRI_SKIPLIST_MAX_HEIGHT; lev++) {
+      _start->_next[lev] = nullptr;
+    }
+
+    return TRI_ERROR_OUT_OF_MEMORY;
+  }
+
+  _start->_height = height;
+  _end = last[0];
+  _nrUsed += docs.size();
+
+  return TRI_ERROR_NO_ERROR;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief removes a document from a skiplist
 ///
@@ -38,6 +38,8 @@
 namespace triagens {
   namespace basics {
 
+    class ThreadPool;
+
 // -----------------------------------------------------------------------------
 // --SECTION--                                                         SKIP LIST
 // -----------------------------------------------------------------------------
@@ -207,6 +209,22 @@ namespace triagens {
 
         int insert (void* doc);
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief fills an empty skiplist with many documents at once
+///
+/// The documents are sorted in the proper total order, using the threads
+/// of pool as helpers if it is not a nullptr, and the nodes are then linked
+/// on all levels in a single pass, without any searches. Returns TRI_ERROR_NO_ERROR if all is
+/// well, TRI_ERROR_OUT_OF_MEMORY if allocation failed and
+/// TRI_ERROR_ARANGO_UNIQUE_CONSTRAINT_VIOLATED if two documents compare
+/// equal in the proper total order, or in the preorder for a unique
+/// skiplist. In the latter two cases nothing is inserted and the caller
+/// keeps the ownership of the documents. The order of docs is changed.
+////////////////////////////////////////////////////////////////////////////////
+
+        int bulkLoad (std::vector<void*>& docs,
+                      ThreadPool* pool);
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief removes a document from a skiplist
 ///